@@ -6,6 +6,11 @@ set(ADDITIONAL_COMPILER_PARAMETERS "" CACHE STRING "User-specified compiler flag
 option(ENABLE_NEON OFF)
 option(ENABLE_SSE OFF)
 
+option(THREAD_CACHING_GLOBAL_HEAP "Allocate containers through ThreadCachingAllocator instead of the system heap." OFF)
+if(THREAD_CACHING_GLOBAL_HEAP)
+    add_definitions(-D INTRA_THREAD_CACHING_GLOBAL_HEAP)
+endif()
+
 if(CMAKE_CXX_COMPILER_ID MATCHES "Clang" OR CMAKE_CXX_COMPILER_ID MATCHES "GNU" OR CMAKE_COMPILER_IS_GNUCXX)
     set(ALL_WARNINGS "-Wall -Wextra -Woverloaded-virtual -Wctor-dtor-privacy -Wnon-virtual-dtor")
     set(ALL_WARNINGS "${ALL_WARNINGS} -Wold-style-cast -Wconversion -Wsign-conversion -Winit-self -Wunreachable-code -pedantic")
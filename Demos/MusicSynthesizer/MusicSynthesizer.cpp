@@ -23,6 +23,7 @@
 #include "Audio/AudioSource.h"
 
 #include "Audio/Sources/Wave.h"
+#include "Audio/Sinks/WaveSink.h"
 
 
 #include "MusicSynthesizerCommon.h"
@@ -112,8 +113,10 @@ void PrintInfoAndPlayMidiFile(StringView filePath, bool enableStreaming)
 	PrintInfoAndPlayMidiStream(OS.FileOpen(filePath, Error::Skip()), enableStreaming);
 }
 
-void PrintInfoAndConvertMidiStreamToWavStream(ForwardStream midiStream, uint sampleRate, OutputStream wavStream)
+void PrintInfoAndConvertMidiFileToWav(StringView filePath, StringView outputPath)
 {
+	Std.PrintLine("Открытие MIDI файла: ", filePath);
+	ForwardStream midiStream = OS.FileOpen(filePath, Error::Skip());
 	FatalErrorStatus status;
 	auto info = PrintMidiInfo(midiStream, status);
 	if(status.Handle())
@@ -124,20 +127,15 @@ void PrintInfoAndConvertMidiStreamToWavStream(ForwardStream midiStream, uint sam
 	}
 	Std.PrintLine("Синтез...");
 	Stopwatch sw;
+	const uint sampleRate = 48000;
 	auto src = CreateMidiAudioSource(Cpp::Move(midiStream), info.Duration, 0.75f, status, sampleRate);
-	Sources::WriteWave(*src, wavStream);
+	Sinks::WaveFileSink sink(outputPath, sampleRate, ushort(src->ChannelCount()), Data::ValueType::SNorm16, true, status);
+	sink.WriteFrom(*src, ~ulong64(), status);
+	sink.Finish(status);
+	if(status.Handle()) Std.PrintLine(status.GetLog());
 	Std.PrintLine("Время синтеза: ", StringOf(sw.ElapsedSeconds()*1000, 2), " мс.");
 }
 
-void PrintInfoAndConvertMidiFileToWav(StringView filePath, StringView outputPath)
-{
-	Std.PrintLine("Открытие MIDI файла: ", filePath);
-	PrintInfoAndConvertMidiStreamToWavStream(
-		OS.FileOpen(filePath, Error::Skip()),
-		48000,
-		OS.FileOpenOverwrite(outputPath, Error::Skip()));
-}
-
 int INTRA_CRTDECL main()
 {
 	//System::InitSignals();
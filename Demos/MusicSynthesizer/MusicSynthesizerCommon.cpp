@@ -67,11 +67,13 @@ bool PrintMidiFileInfo(StringView filePath)
 }
 
 Unique<IAudioSource> CreateMidiAudioSource(InputStream midiFileStream,
-	double duration, float startingVolume, ErrorStatus& status, uint sampleRate)
+	double duration, float startingVolume, ErrorStatus& status, uint sampleRate, ThreadPool* pool)
 {
-	return new Sources::MidiSynth(
+	auto synth = new Sources::MidiSynth(
 		Midi::MidiFileParser::CreateSingleOrderedMessageStream(Cpp::Move(midiFileStream), status),
 		duration, GetMapping(), startingVolume, null, sampleRate == 0? Sound::DefaultSampleRate(): sampleRate, true);
+	synth->SetThreadPool(pool);
+	return synth;
 }
 
 Sound CreateSoundFromMidi(ForwardStream midiFilestream, double duration, float startingVolume, bool printMessages)
@@ -79,7 +81,7 @@ Sound CreateSoundFromMidi(ForwardStream midiFilestream, double duration, float s
 	if(printMessages) Std.PrintLine("Синтез...");
 	FatalErrorStatus status;
 	Stopwatch sw;
-	Sound sound = Sound(CreateMidiAudioSource(Cpp::Move(midiFilestream), duration, startingVolume, status), status);
+	Sound sound = Sound(CreateMidiAudioSource(Cpp::Move(midiFilestream), duration, startingVolume, status, 0, &ThreadPool::Default()), status);
 	if(printMessages) Std.PrintLine("Время синтеза: ", StringOf(sw.ElapsedSeconds()*1000, 2), " мс.");
 	if(status.Handle())
 	{
@@ -21,13 +21,20 @@ namespace Midi {
 struct MidiFileInfo;
 }
 
-}}
+}
+
+namespace Concurrency {
+class ThreadPool;
+}
+
+}
 
 Intra::String GetMidiPath(Intra::StringView fileName);
 Intra::Audio::Midi::MidiFileInfo PrintMidiInfo(Intra::InputStream midiFileStream, Intra::ErrorStatus& status);
 bool PrintMidiFileInfo(Intra::StringView filePath);
 Intra::Unique<Intra::Audio::IAudioSource> CreateMidiAudioSource(Intra::InputStream stream,
-	double duration, float startingVolume, Intra::ErrorStatus& status, Intra::uint sampleRate = 0);
+	double duration, float startingVolume, Intra::ErrorStatus& status, Intra::uint sampleRate = 0,
+	Intra::Concurrency::ThreadPool* pool = nullptr);
 Intra::Audio::Sound CreateSoundFromMidi(Intra::ForwardStream midiFiletream, double duration, float startingVolume, bool printMessages);
 Intra::Audio::StreamedSound CreateStreamedSoundFromMidi(Intra::ForwardStream midiFiletream, float startingVolume, bool printMessages);
 
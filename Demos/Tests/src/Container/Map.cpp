@@ -29,6 +29,7 @@ INTRA_WARNING_POP
 
 #include "Container/Associative/LinearMap.h"
 #include "Container/Associative/HashMap.h"
+#include "Container/Associative/FlatHashMap.h"
 
 using namespace Intra;
 using namespace IO;
@@ -139,7 +140,7 @@ template<typename MAP> double TestMapUnsuccessfulSearching(uint times, uint size
 
 void RunMapPerfTests(FormattedWriter& output)
 {
-	static const StringView comparedContainers[] = {"std::map", "std::unordered_map", "LinearMap", "HashMap"};
+	static const StringView comparedContainers[] = {"std::map", "std::unordered_map", "LinearMap", "HashMap", "FlatHashMap"};
 
 	if(TestGroup gr{"Заполнение случайными ключами uint и значениями uint"})
 	{
@@ -154,7 +155,8 @@ void RunMapPerfTests(FormattedWriter& output)
 				},
 				{
 					TestMapPopulation<LinearMap<uint, uint>>(times, count),
-					TestMapPopulation<HashMap<uint, uint>>(times, count)
+					TestMapPopulation<HashMap<uint, uint>>(times, count),
+					TestMapPopulation<FlatHashMap<uint, uint>>(times, count)
 				});
 		}
 	}
@@ -172,7 +174,8 @@ void RunMapPerfTests(FormattedWriter& output)
 				},
 				{
 					TestMapPopulation<LinearMap<String, uint>>(times, count),
-					TestMapPopulation<HashMap<String, uint>>(times, count)
+					TestMapPopulation<HashMap<String, uint>>(times, count),
+					TestMapPopulation<FlatHashMap<String, uint>>(times, count)
 				});
 		}
 	}
@@ -190,7 +193,8 @@ void RunMapPerfTests(FormattedWriter& output)
 				},
 				{
 					TestMapPopulation<LinearMap<Big<64>, uint>>(times, count),
-					TestMapPopulation<HashMap<Big<64>, uint>>(times, count)
+					TestMapPopulation<HashMap<Big<64>, uint>>(times, count),
+					TestMapPopulation<FlatHashMap<Big<64>, uint>>(times, count)
 				});
 		}
 	}
@@ -208,7 +212,8 @@ void RunMapPerfTests(FormattedWriter& output)
 				},
 				{
 					TestMapIterationSumValues<LinearMap<uint, uint>>(times, count),
-					TestMapIterationSumValues<HashMap<uint, uint>>(times, count)
+					TestMapIterationSumValues<HashMap<uint, uint>>(times, count),
+					TestMapIterationSumValues<FlatHashMap<uint, uint>>(times, count)
 				});
 		}
 	}
@@ -226,7 +231,8 @@ void RunMapPerfTests(FormattedWriter& output)
 				},
 				{
 					TestMapIterationSumValues<LinearMap<String, uint>>(times, count),
-					TestMapIterationSumValues<HashMap<String, uint>>(times, count)
+					TestMapIterationSumValues<HashMap<String, uint>>(times, count),
+					TestMapIterationSumValues<FlatHashMap<String, uint>>(times, count)
 				});
 		}
 	}
@@ -244,7 +250,8 @@ void RunMapPerfTests(FormattedWriter& output)
 				},
 				{
 					TestMapIterationSumValues<LinearMap<Big<64>, uint>>(times, count),
-					TestMapIterationSumValues<HashMap<Big<64>, uint>>(times, count)
+					TestMapIterationSumValues<HashMap<Big<64>, uint>>(times, count),
+					TestMapIterationSumValues<FlatHashMap<Big<64>, uint>>(times, count)
 				});
 		}
 	}
@@ -314,7 +321,8 @@ void RunMapPerfTests(FormattedWriter& output)
 				},
 				{
 					TestMapSuccessfulSearching<LinearMap<uint, uint>>(times, count),
-					TestMapSuccessfulSearching<HashMap<uint, uint>>(times, count)
+					TestMapSuccessfulSearching<HashMap<uint, uint>>(times, count),
+					TestMapSuccessfulSearching<FlatHashMap<uint, uint>>(times, count)
 				});
 		}
 	}
@@ -332,7 +340,8 @@ void RunMapPerfTests(FormattedWriter& output)
 				},
 				{
 					TestMapSuccessfulSearching<LinearMap<String, uint>>(times, count),
-					TestMapSuccessfulSearching<HashMap<String, uint>>(times, count)
+					TestMapSuccessfulSearching<HashMap<String, uint>>(times, count),
+					TestMapSuccessfulSearching<FlatHashMap<String, uint>>(times, count)
 				});
 		}
 	}
@@ -350,7 +359,8 @@ void RunMapPerfTests(FormattedWriter& output)
 				},
 				{
 					TestMapSuccessfulSearching<LinearMap<Big<64>, uint>>(times, count),
-					TestMapSuccessfulSearching<HashMap<Big<64>, uint>>(times, count)
+					TestMapSuccessfulSearching<HashMap<Big<64>, uint>>(times, count),
+					TestMapSuccessfulSearching<FlatHashMap<Big<64>, uint>>(times, count)
 				});
 		}
 	}
@@ -369,7 +379,8 @@ void RunMapPerfTests(FormattedWriter& output)
 				},
 				{
 					TestMapUnsuccessfulSearching<LinearMap<uint, uint>>(times, count),
-					TestMapUnsuccessfulSearching<HashMap<uint, uint>>(times, count)
+					TestMapUnsuccessfulSearching<HashMap<uint, uint>>(times, count),
+					TestMapUnsuccessfulSearching<FlatHashMap<uint, uint>>(times, count)
 				});
 		}
 	}
@@ -387,7 +398,8 @@ void RunMapPerfTests(FormattedWriter& output)
 				},
 				{
 					TestMapUnsuccessfulSearching<LinearMap<String, uint>>(times, count),
-					TestMapUnsuccessfulSearching<HashMap<String, uint>>(times, count)
+					TestMapUnsuccessfulSearching<HashMap<String, uint>>(times, count),
+					TestMapUnsuccessfulSearching<FlatHashMap<String, uint>>(times, count)
 				});
 		}
 	}
@@ -405,7 +417,8 @@ void RunMapPerfTests(FormattedWriter& output)
 				},
 				{
 					TestMapUnsuccessfulSearching<LinearMap<Big<64>, uint>>(times, count),
-					TestMapUnsuccessfulSearching<HashMap<Big<64>, uint>>(times, count)
+					TestMapUnsuccessfulSearching<HashMap<Big<64>, uint>>(times, count),
+					TestMapUnsuccessfulSearching<FlatHashMap<Big<64>, uint>>(times, count)
 				});
 		}
 	}
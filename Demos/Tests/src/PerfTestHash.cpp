@@ -0,0 +1,60 @@
+﻿#include "Cpp/Warnings.h"
+INTRA_PUSH_DISABLE_REDUNDANT_WARNINGS
+
+#include "PerfTestHash.h"
+
+#include "System/Stopwatch.h"
+#include "Test/PerfSummary.h"
+#include "Hash/Murmur.h"
+#include "Hash/Fast64.h"
+#include "Random/FastUniform.h"
+#include "Container/Sequential/Array.h"
+#include "Container/Sequential/String.h"
+
+using namespace Intra;
+
+ulong64 g_HashSink = 0;
+
+template<typename F> static double measureHash(CSpan<char> data, size_t keyLength, size_t repeats, F hashFunc)
+{
+	Stopwatch tim;
+	for(size_t r = 0; r < repeats; r++)
+		for(size_t offset = 0; offset + keyLength <= data.Length(); offset += keyLength)
+			g_HashSink += hashFunc(StringView(data.Data() + offset, keyLength));
+	return tim.ElapsedSeconds();
+}
+
+static void testHashes(IO::FormattedWriter& logger, CSpan<char> data, size_t keyLength)
+{
+	const size_t bytesPerRepeat = data.Length()/keyLength*keyLength;
+	const size_t repeats = keyLength < 64? 4: 16;
+	const double totalGigabytes = double(bytesPerRepeat)*double(repeats)/1e9;
+
+	const double murmur32Time = measureHash(data, keyLength, repeats,
+		[](StringView key) {return ulong64(Hash::Murmur3_32(key, 0));});
+	const double murmur128Time = measureHash(data, keyLength, repeats,
+		[](StringView key) {return Hash::Murmur3_128_x64(key, 0).h1;});
+	const double fast64Time = measureHash(data, keyLength, repeats,
+		[](StringView key) {return Hash::Fast64(key, 0);});
+
+	PrintPerformanceResults(logger, "hashing " + StringOf(bytesPerRepeat*repeats) + " bytes as keys of " + StringOf(keyLength) + " bytes",
+		{"Murmur3_32", "Murmur3_128_x64", "Fast64"},
+		{murmur32Time, murmur128Time},
+		{fast64Time});
+	logger.PrintLine("Пропускная способность (ГБ/с): Murmur3_32 - ", StringOf(totalGigabytes/murmur32Time, 2),
+		", Murmur3_128_x64 - ", StringOf(totalGigabytes/murmur128Time, 2),
+		", Fast64 - ", StringOf(totalGigabytes/fast64Time, 2));
+}
+
+void RunHashPerfTests(IO::FormattedWriter& logger)
+{
+	Array<char> data;
+	data.SetCountUninitialized(1 << 24);
+	Random::FastUniform<uint> random(89274163u);
+	for(char& c: data) c = char(random());
+
+	static const size_t keyLengths[] = {4, 8, 16, 32, 64, 256, 4096, 1 << 20};
+	for(size_t keyLength: keyLengths) testHashes(logger, data, keyLength);
+}
+
+INTRA_WARNING_POP
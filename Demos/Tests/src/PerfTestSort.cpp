@@ -7,6 +7,8 @@ INTRA_PUSH_DISABLE_REDUNDANT_WARNINGS
 #include "Test/TestData.h"
 #include "Range/Sort.hh"
 #include "System/Stopwatch.h"
+#include "System/ProcessorInfo.h"
+#include "Concurrency/ThreadPool.h"
 #include "IO/FormattedWriter.h"
 
 using namespace Intra;
@@ -63,6 +65,36 @@ template<typename T> double TestRadixSorting(size_t size)
 	return result;
 }
 
+template<typename T> double TestParallelQuickSorting(size_t size, ThreadPool& pool = ThreadPool::Default())
+{
+	Array<T> arr = GetRandomValueArray<T>(size);
+	Stopwatch tim;
+	Range::ParallelQuickSort(pool, arr);
+	double result = tim.ElapsedSeconds();
+	INTRA_DEBUG_ASSERT(Range::IsSorted(arr));
+	return result;
+}
+
+template<typename T> double TestParallelMergeSorting(size_t size, ThreadPool& pool = ThreadPool::Default())
+{
+	Array<T> arr = GetRandomValueArray<T>(size);
+	Stopwatch tim;
+	Range::ParallelMergeSort(pool, arr);
+	double result = tim.ElapsedSeconds();
+	INTRA_DEBUG_ASSERT(Range::IsSorted(arr));
+	return result;
+}
+
+template<typename T> double TestParallelRadixSorting(size_t size, ThreadPool& pool = ThreadPool::Default())
+{
+	Array<T> arr = GetRandomValueArray<T>(size);
+	Stopwatch tim;
+	Range::ParallelRadixSort(pool, arr.AsRange());
+	double result = tim.ElapsedSeconds();
+	INTRA_DEBUG_ASSERT(Range::IsSorted(arr));
+	return result;
+}
+
 template<typename T, typename Comparer = Funal::TLess>
 double TestMergeSorting(size_t size, Comparer comparer = Funal::Less)
 {
@@ -107,16 +139,27 @@ double TestStdSorting(size_t size, Comparer comparer = Funal::Less)
 	return result;
 }
 
+template<typename T, typename Comparer = Funal::TLess>
+double TestStdStableSorting(size_t size, Comparer comparer = Funal::Less)
+{
+	Array<T> arr = GetRandomValueArray<T>(size);
+	Stopwatch tim;
+	std::stable_sort(arr.begin(), arr.end(), comparer);
+	double result = tim.ElapsedSeconds();
+	INTRA_DEBUG_ASSERT(Range::IsSorted(arr));
+	return result;
+}
+
 static const StringView comparedSorts[] = {
 	"std::sort", "InsertionSort", "ShellSort", "QuickSort",
 	"MergeSort", "SelectionSort", "HeapSort", "RadixSort"
 };
 static const StringView comparedSortsWithoutSlow[] = {
 	"std::sort", "ShellSort", "QuickSort",
-	"MergeSort", "HeapSort", "RadixSort"
+	"MergeSort", "HeapSort", "RadixSort", "ParallelRadixSort"
 };
 
-template<typename T> void TestAndPrintIntegralTypeSorts(IO::FormattedWriter& output, StringView typeName)
+template<typename T> void TestAndPrintSorts(IO::FormattedWriter& output, StringView typeName)
 {
 	PrintPerformanceResults(output, typeName + " array size: 100",
 		comparedSorts, {TestStdSorting<T>(100)},
@@ -173,7 +216,8 @@ template<typename T> void TestAndPrintIntegralTypeSorts(IO::FormattedWriter& out
 			TestQuickSorting<T>(1000000),
 			TestMergeSorting<T>(1000000),
 			TestHeapSorting<T>(1000000),
-			TestRadixSorting<T>(1000000)
+			TestRadixSorting<T>(1000000),
+			TestParallelRadixSorting<T>(1000000)
 		});
 
 	PrintPerformanceResults(output, typeName + " array size: 10000000",
@@ -183,23 +227,67 @@ template<typename T> void TestAndPrintIntegralTypeSorts(IO::FormattedWriter& out
 			TestQuickSorting<T>(10000000),
 			TestMergeSorting<T>(10000000),
 			TestHeapSorting<T>(10000000),
-			TestRadixSorting<T>(10000000)
+			TestRadixSorting<T>(10000000),
+			TestParallelRadixSorting<T>(10000000)
 		});
 }
 
+static const StringView comparedParallelSorts[] = {
+	"std::sort", "std::stable_sort",
+	"QuickSort", "ParallelQuickSort", "MergeSort", "ParallelMergeSort", "RadixSort", "ParallelRadixSort"
+};
+
+template<typename T> void TestAndPrintParallelSorts(IO::FormattedWriter& output, StringView typeName, size_t size)
+{
+	// the thread calling Wait takes part in sorting, so a pool with n - 1 workers runs n threads
+	const uint processors = System::ProcessorInfo::Get().LogicalProcessorNumber;
+	uint threads = 2;
+	for(;;)
+	{
+		ThreadPool pool(threads - 1);
+		PrintPerformanceResults(output, typeName + " array size: " + StringOf(size) + ", threads: " + StringOf(threads),
+			comparedParallelSorts, {TestStdSorting<T>(size), TestStdStableSorting<T>(size)},
+			{
+				TestQuickSorting<T>(size),
+				TestParallelQuickSorting<T>(size, pool),
+				TestMergeSorting<T>(size),
+				TestParallelMergeSorting<T>(size, pool),
+				TestRadixSorting<T>(size),
+				TestParallelRadixSorting<T>(size, pool)
+			});
+		if(threads >= processors) break;
+		threads = Funal::Min(threads*2, processors);
+	}
+}
+
 void RunSortPerfTests(FormattedWriter& output)
 {
 	if(TestGroup gr{"Sorting of random generated arrays of short"})
-		TestAndPrintIntegralTypeSorts<short>(output, "short");
+		TestAndPrintSorts<short>(output, "short");
 
 	if(TestGroup gr{"Sorting of random generated arrays of int"})
-		TestAndPrintIntegralTypeSorts<int>(output, "int");
+		TestAndPrintSorts<int>(output, "int");
 
 	if(TestGroup gr{"Sorting of random generated arrays of uint"})
-		TestAndPrintIntegralTypeSorts<uint>(output, "uint");
+		TestAndPrintSorts<uint>(output, "uint");
 
 	if(TestGroup gr{"Sorting of random generated arrays of long64"})
-		TestAndPrintIntegralTypeSorts<long64>(output, "long64");
+		TestAndPrintSorts<long64>(output, "long64");
+
+	if(TestGroup gr{"Sorting of random generated arrays of float"})
+		TestAndPrintSorts<float>(output, "float");
+
+	if(TestGroup gr{"Sorting of random generated arrays of double"})
+		TestAndPrintSorts<double>(output, "double");
+
+	if(TestGroup gr{"Multi-threaded sorting of random generated arrays of int"})
+	{
+		TestAndPrintParallelSorts<int>(output, "int", 1000000);
+		TestAndPrintParallelSorts<int>(output, "int", 10000000);
+	}
+
+	if(TestGroup gr{"Multi-threaded sorting of random generated arrays of double"})
+		TestAndPrintParallelSorts<double>(output, "double", 10000000);
 }
 
 INTRA_WARNING_POP
@@ -29,6 +29,7 @@
 #include "Range/Header.h"
 #include "PerfTestRandom.h"
 #include "PerfTestSort.h"
+#include "PerfTestHash.h"
 
 INTRA_DISABLE_REDUNDANT_WARNINGS
 
@@ -113,6 +114,7 @@ int main()
 	TestGroup(null, output, "Associative containers", RunMapPerfTests);
 	TestGroup(null, output, "Serialization and deserialization", RunSerializationPerfTests);
 	TestGroup(null, output, "Sort algorithms", RunSortPerfTests);
+	TestGroup(null, output, "Hashing", RunHashPerfTests);
 
 	if(System::Environment.CommandLine.Get(1, null) != "-a")
 	{
@@ -0,0 +1,14 @@
+#pragma once
+
+#include "IO/FormattedWriter.h"
+
+void TestFFT(Intra::FormattedWriter& output);
+void TestSampleConversion(Intra::FormattedWriter& output);
+void TestSynthFilters(Intra::FormattedWriter& output);
+void TestConvolutionReverb(Intra::FormattedWriter& output);
+void TestPolyphaseResampler(Intra::FormattedWriter& output);
+void TestWaveTableCache(Intra::FormattedWriter& output);
+void TestMidiSynthVoicePool(Intra::FormattedWriter& output);
+void TestAudioSinks(Intra::FormattedWriter& output);
+void TestAudioSourcesSeeking(Intra::FormattedWriter& output);
+void TestMidiParallelRender(Intra::FormattedWriter& output);
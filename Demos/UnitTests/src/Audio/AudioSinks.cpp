@@ -0,0 +1,381 @@
+﻿#include "Audio.h"
+#include "Audio/Sinks/WaveSink.h"
+#include "Audio/Sinks/FlacSink.h"
+#include "Audio/Sources/Wave.h"
+#include "Container/Sequential/Array.h"
+#include "Container/Sequential/String.h"
+#include "IO/FileSystem.h"
+#include "IO/FileReader.h"
+#include "Math/Math.h"
+#include "Utils/Debug.h"
+
+using namespace Intra;
+using namespace IO;
+using namespace Audio;
+
+static Array<float> TestSinkSignal(size_t frames)
+{
+	Array<float> result;
+	result.SetCount(frames*2);
+	for(size_t i = 0; i < frames; i++)
+	{
+		result[2*i] = 0.7f*float(Math::Sin(0.01*double(i)));
+		result[2*i + 1] = 0.5f*float(Math::Sin(0.023*double(i) + 1)) + 0.2f*float(Math::Sin(0.0031*double(i)));
+	}
+	return result;
+}
+
+//! Пишет сигнал кусками разной длины, чтобы задействовать и буфер, и прямую запись в файл.
+static void WriteInPieces(Sinks::AudioFileSink& sink, CSpan<float> samples)
+{
+	size_t piece = 2;
+	while(!samples.Empty())
+	{
+		const size_t n = Math::Min(piece*sink.ChannelCount(), samples.Length());
+		sink.WriteInterleaved(samples.Take(n));
+		samples.PopFirstExactly(n);
+		piece = piece*5 % 6007 + 1;
+	}
+}
+
+static void TestWaveSinkRoundTrip(FormattedWriter& output, Data::ValueType type, float tolerance)
+{
+	enum: size_t {Frames = 10000};
+	const Array<float> signal = TestSinkSignal(Frames);
+	const StringView fileName = "TestWaveSink.wav";
+	{
+		Sinks::WaveFileSink sink(fileName, 44100, 2, type, false, Error::Skip(), 4096);
+		INTRA_ASSERT(sink.IsOpen());
+		WriteInPieces(sink, signal);
+		INTRA_ASSERT_EQUALS(sink.SampleCount(), ulong64(Frames));
+	}
+	const String fileData = OS.FileOpen(fileName, Error::Skip());
+	Sources::Wave wave(null, fileData.AsRange().Reinterpret<const byte>());
+	INTRA_ASSERT_EQUALS(wave.SampleRate(), 44100u);
+	INTRA_ASSERT_EQUALS(wave.ChannelCount(), 2u);
+	INTRA_ASSERT_EQUALS(wave.SampleCount(), size_t(Frames));
+
+	Array<float> decoded;
+	decoded.SetCount(Frames*2);
+	INTRA_ASSERT_EQUALS(wave.GetInterleavedSamples(decoded), size_t(Frames));
+	float maxError = 0;
+	for(size_t i = 0; i < signal.Length(); i++)
+		maxError = Math::Max(maxError, Math::Abs(decoded[i] - signal[i]));
+	output.PrintLine("Максимальная ошибка: ", maxError);
+	INTRA_ASSERT(maxError <= tolerance);
+	OS.FileDelete(fileName);
+}
+
+static ulong64 ReadTestLE(const byte* p, size_t bytes)
+{
+	ulong64 result = 0;
+	for(size_t i = bytes; i--;) result = result << 8 | p[i];
+	return result;
+}
+
+static void TestWaveHeaders(FormattedWriter& output)
+{
+	output.PrintLine("Заголовок RF64 для данных больше 4 ГБ:");
+	enum: ulong64 {HugeSampleCount = 800000000};
+	byte header[Sinks::WaveFileSink::MaxHeaderSize + 12];
+	const size_t headerSize = Sinks::WaveFileSink::BuildHeader(header, 48000, 2, Data::ValueType::SNorm24, HugeSampleCount);
+	const ulong64 dataSize = HugeSampleCount*2*3;
+	INTRA_ASSERT(C::memcmp(header, "RF64", 4) == 0);
+	INTRA_ASSERT_EQUALS(ReadTestLE(header + 4, 4), 0xFFFFFFFFull);
+	INTRA_ASSERT(C::memcmp(header + 8, "WAVEds64", 8) == 0);
+	INTRA_ASSERT_EQUALS(ReadTestLE(header + 16, 4), 28ull);
+	INTRA_ASSERT_EQUALS(ReadTestLE(header + 20, 8), headerSize - 8 + dataSize);
+	INTRA_ASSERT_EQUALS(ReadTestLE(header + 28, 8), dataSize);
+	INTRA_ASSERT_EQUALS(ReadTestLE(header + 36, 8), ulong64(HugeSampleCount));
+	INTRA_ASSERT(C::memcmp(header + 48, "fmt ", 4) == 0);
+	INTRA_ASSERT(C::memcmp(header + headerSize - 8, "data", 4) == 0);
+	INTRA_ASSERT_EQUALS(ReadTestLE(header + headerSize - 4, 4), 0xFFFFFFFFull);
+
+	// Настоящий размер данных читается из ds64, а не из чанка data. Файл здесь обрезан после двух семплов.
+	const byte samples[12] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12};
+	C::memcpy(header + headerSize, samples, sizeof(samples));
+	Sources::Wave rf64(null, CSpanOf(header).Take(headerSize + sizeof(samples)));
+	INTRA_ASSERT_EQUALS(rf64.SampleRate(), 48000u);
+	INTRA_ASSERT_EQUALS(rf64.ChannelCount(), 2u);
+	INTRA_ASSERT_EQUALS(rf64.SampleCount(), size_t(2));
+
+	// Пока данные меньше 4 ГБ, тот же заголовок остаётся обычным RIFF с чанком JUNK на месте ds64
+	INTRA_ASSERT_EQUALS(Sinks::WaveFileSink::BuildHeader(header, 48000, 2, Data::ValueType::SNorm24, 1000), headerSize);
+	INTRA_ASSERT(C::memcmp(header, "RIFF", 4) == 0);
+	INTRA_ASSERT_EQUALS(ReadTestLE(header + 4, 4), headerSize - 8 + 6000ull);
+	INTRA_ASSERT(C::memcmp(header + 8, "WAVEJUNK", 8) == 0);
+	INTRA_ASSERT_EQUALS(ReadTestLE(header + headerSize - 4, 4), 6000ull);
+}
+
+//! Побитовое чтение от старших битов к младшим, как в формате FLAC.
+struct FlacTestBitReader
+{
+	CSpan<byte> Data;
+	size_t Pos;
+
+	uint Read(uint bits)
+	{
+		INTRA_ASSERT(Pos + bits <= Data.Length()*8);
+		uint result = 0;
+		for(uint i = 0; i < bits; i++, Pos++)
+			result = result << 1 | ((uint(Data[Pos >> 3]) >> (7 - (Pos & 7))) & 1);
+		return result;
+	}
+
+	int ReadSigned(uint bits)
+	{
+		const uint value = Read(bits);
+		return (value & (1u << (bits - 1))) != 0? int(value) - int(1u << (bits - 1)) - int(1u << (bits - 1)): int(value);
+	}
+
+	int ReadRice(uint k)
+	{
+		uint q = 0;
+		while(Read(1) == 0) q++;
+		const uint u = q << k | Read(k);
+		return (u & 1) != 0? -int(u >> 1) - 1: int(u >> 1);
+	}
+};
+
+static uint TestFlacCrc(CSpan<byte> data, uint polynomial, uint bits)
+{
+	const uint top = 1u << (bits - 1), mask = (top << 1) - 1;
+	uint crc = 0;
+	for(byte b: data)
+	{
+		crc ^= uint(b) << (bits - 8);
+		for(int i = 0; i < 8; i++) crc = ((crc & top) != 0? (crc << 1) ^ polynomial: crc << 1) & mask;
+	}
+	return crc;
+}
+
+//! Упрощённый декодер FLAC, понимающий всё, что пишет FlacFileSink: кадры фиксированного размера,
+//! подкадры constant, verbatim и fixed, коды Райса с 4- и 5-битными параметрами и все режимы стерео.
+//! Проверяет CRC заголовков и кадров, номера кадров и считает подкадры каждого типа.
+//! @return Декодированные чередующиеся семплы.
+static Array<int> DecodeTestFlac(CSpan<byte> file, size_t subframeTypeCounts[3])
+{
+	const uint channels = ((uint(file[20]) >> 1) & 7) + 1;
+	const uint bps = ((uint(file[20]) & 1) << 4 | uint(file[21]) >> 4) + 1;
+	const size_t streamBlockSize = size_t(file[8]) << 8 | file[9];
+	Array<int> result;
+	Array<int> block[2];
+	FlacTestBitReader br = {file, 42*8};
+	for(ulong64 frameNumber = 0; br.Pos < file.Length()*8; frameNumber++)
+	{
+		const size_t frameStart = br.Pos/8;
+		INTRA_ASSERT_EQUALS(br.Read(16), 0xFFF8u);
+		const uint blockSizeCode = br.Read(4);
+		INTRA_ASSERT_EQUALS(br.Read(4), 0u);
+		const uint assignment = br.Read(4);
+		INTRA_ASSERT(channels == 2 && assignment >= 8? assignment <= 10: assignment == channels - 1);
+		INTRA_ASSERT_EQUALS(br.Read(3), bps == 16? 4u: 6u);
+		INTRA_ASSERT_EQUALS(br.Read(1), 0u);
+		const uint first = br.Read(8);
+		ulong64 number = first;
+		if(first >= 0x80)
+		{
+			uint extraBytes = 0;
+			while((first & (0x40u >> extraBytes)) != 0) extraBytes++;
+			number = first & (0x3Fu >> extraBytes);
+			while(extraBytes--) number = number << 6 | (br.Read(8) & 0x3F);
+		}
+		INTRA_ASSERT_EQUALS(number, frameNumber);
+		size_t n;
+		if(blockSizeCode == 6) n = br.Read(8) + 1u;
+		else if(blockSizeCode == 7) n = br.Read(16) + 1u;
+		else if(blockSizeCode >= 8) n = size_t(256) << (blockSizeCode - 8);
+		else
+		{
+			INTRA_ASSERT(blockSizeCode >= 1);
+			n = blockSizeCode == 1? 192: size_t(576) << (blockSizeCode - 2);
+		}
+		INTRA_ASSERT(n <= streamBlockSize);
+		INTRA_ASSERT_EQUALS(TestFlacCrc(file.Drop(frameStart).Take(br.Pos/8 - frameStart), 0x07, 8), br.Read(8));
+
+		const size_t firstSample = result.Length();
+		result.SetCount(firstSample + n*channels);
+		for(uint c = 0; c < channels; c++)
+		{
+			const bool side = (assignment == 9 && c == 0) || ((assignment == 8 || assignment == 10) && c == 1);
+			const uint bits = bps + (side? 1: 0);
+			Array<int>& x = block[c < 2? c: 0];
+			x.SetCount(n);
+			INTRA_ASSERT_EQUALS(br.Read(1), 0u);
+			const uint type = br.Read(6);
+			INTRA_ASSERT_EQUALS(br.Read(1), 0u);
+			if(type == 0)
+			{
+				subframeTypeCounts[0]++;
+				const int value = br.ReadSigned(bits);
+				for(size_t i = 0; i < n; i++) x[i] = value;
+			}
+			else if(type == 1)
+			{
+				subframeTypeCounts[1]++;
+				for(size_t i = 0; i < n; i++) x[i] = br.ReadSigned(bits);
+			}
+			else
+			{
+				INTRA_ASSERT(type >= 8 && type <= 12);
+				subframeTypeCounts[2]++;
+				const uint order = type - 8;
+				for(uint i = 0; i < order; i++) x[i] = br.ReadSigned(bits);
+				const uint method = br.Read(2);
+				INTRA_ASSERT(method <= 1);
+				const uint partitionOrder = br.Read(4);
+				size_t i = order;
+				for(size_t p = 0; p < (size_t(1) << partitionOrder); p++)
+				{
+					const uint k = br.Read(method == 1? 5: 4);
+					INTRA_ASSERT(k != (method == 1? 31u: 15u));
+					const size_t end = (p + 1)*(n >> partitionOrder);
+					for(; i < end; i++)
+					{
+						const int r = br.ReadRice(k);
+						switch(order)
+						{
+						case 0: x[i] = r; break;
+						case 1: x[i] = r + x[i-1]; break;
+						case 2: x[i] = r + 2*x[i-1] - x[i-2]; break;
+						case 3: x[i] = r + 3*x[i-1] - 3*x[i-2] + x[i-3]; break;
+						default: x[i] = r + 4*x[i-1] - 6*x[i-2] + 4*x[i-3] - x[i-4];
+						}
+					}
+				}
+				INTRA_ASSERT_EQUALS(i, n);
+			}
+			if(channels > 2)
+				for(size_t i = 0; i < n; i++) result[firstSample + i*channels + c] = x[i];
+		}
+		if(channels <= 2) for(size_t i = 0; i < n; i++)
+		{
+			int left = block[0][i], right = channels == 2? block[1][i]: 0;
+			if(assignment == 8) right = left - right;
+			else if(assignment == 9) left += right;
+			else if(assignment == 10)
+			{
+				const int mid = left*2 | (right & 1);
+				left = (mid + right) >> 1;
+				right = (mid - right) >> 1;
+			}
+			result[firstSample + i*channels] = left;
+			if(channels == 2) result[firstSample + i*2 + 1] = right;
+		}
+
+		br.Pos = (br.Pos + 7) & ~size_t(7);
+		INTRA_ASSERT_EQUALS(TestFlacCrc(file.Drop(frameStart).Take(br.Pos/8 - frameStart), 0x8005, 16), br.Read(16));
+	}
+	return result;
+}
+
+//! Семплы в том виде, в каком их квантует FlacFileSink без дизеринга.
+static Array<int> QuantizeTestSamples(CSpan<float> samples, Data::ValueType type)
+{
+	Array<int> result;
+	result.SetCount(samples.Length());
+	if(type == Data::ValueType::SNorm24)
+	{
+		CastFloatsToInt24(result, samples);
+		return result;
+	}
+	Array<short> shorts;
+	shorts.SetCount(samples.Length());
+	CSpan<float> channels[] = {samples};
+	InterleaveFloatsCastToShorts(shorts, channels);
+	for(size_t i = 0; i < shorts.Length(); i++) result[i] = shorts[i];
+	return result;
+}
+
+//! Синусоиды, затем тишина и белый шум. Каждый участок состоит из целых кадров,
+//! чтобы кодировщику понадобились все виды подкадров.
+static Array<float> FlacTestSignal(size_t blockSize, uint channels)
+{
+	const size_t frames = blockSize*9/2;
+	Array<float> result;
+	result.SetCount(frames*channels);
+	uint seed = 12345;
+	for(size_t i = 0; i < frames; i++)
+		for(uint c = 0; c < channels; c++)
+		{
+			float& sample = result[i*channels + c];
+			if(i < blockSize*2) sample = 0.6f*float(Math::Sin(0.013*double(i)*(c + 1) + c));
+			else if(i < blockSize*3) sample = 0;
+			else
+			{
+				seed = seed*1664525u + 1013904223u;
+				sample = 0.9f*float(int(seed >> 8) - (1 << 23))/float(1 << 23);
+			}
+		}
+	return result;
+}
+
+static void TestFlacSinkRoundTrip(FormattedWriter& output, Data::ValueType type, uint channels, size_t blockSize)
+{
+	const Array<float> signal = FlacTestSignal(blockSize, channels);
+	const StringView fileName = "TestFlacSinkRoundTrip.flac";
+	{
+		Sinks::FlacFileSink sink(fileName, 48000, ushort(channels), type, false, Error::Skip(), blockSize, 4096);
+		INTRA_ASSERT(sink.IsOpen());
+		WriteInPieces(sink, signal);
+	}
+	const String fileData = OS.FileOpen(fileName, Error::Skip());
+	size_t subframeTypeCounts[3] = {0, 0, 0};
+	const Array<int> decoded = DecodeTestFlac(fileData.AsRange().Reinterpret<const byte>(), subframeTypeCounts);
+	output.PrintLine("Подкадров constant: ", subframeTypeCounts[0],
+		", verbatim: ", subframeTypeCounts[1], ", fixed: ", subframeTypeCounts[2]);
+	INTRA_ASSERT(decoded == QuantizeTestSamples(signal, type));
+	for(size_t count: subframeTypeCounts) INTRA_ASSERT(count > 0);
+	OS.FileDelete(fileName);
+}
+
+void TestAudioSinks(FormattedWriter& output)
+{
+	output.PrintLine("WAV PCM16:");
+	TestWaveSinkRoundTrip(output, Data::ValueType::SNorm16, 1.0f/32767);
+	output.PrintLine("WAV PCM24:");
+	TestWaveSinkRoundTrip(output, Data::ValueType::SNorm24, 1.0f/8388607);
+	output.PrintLine("WAV float:");
+	TestWaveSinkRoundTrip(output, Data::ValueType::Float, 0);
+	TestWaveHeaders(output);
+
+	enum: size_t {Frames = 10000};
+	const Array<float> signal = TestSinkSignal(Frames);
+	const StringView fileName = "TestFlacSink.flac";
+	ulong64 flacSize;
+	{
+		Sinks::FlacFileSink sink(fileName, 44100, 2, Data::ValueType::SNorm16, false, Error::Skip(), 1024, 4096);
+		INTRA_ASSERT(sink.IsOpen());
+		WriteInPieces(sink, signal);
+		sink.Finish();
+		flacSize = sink.ByteCount();
+	}
+	const String fileData = OS.FileOpen(fileName, Error::Skip());
+	INTRA_ASSERT_EQUALS(ulong64(fileData.Length()), flacSize);
+	const CSpan<byte> bytes = fileData.AsRange().Reinterpret<const byte>();
+	INTRA_ASSERT(C::memcmp(bytes.Begin, "fLaC", 4) == 0);
+	// STREAMINFO: 20 бит частоты, 3 бита каналов, 5 бит разрядности и 36 бит количества семплов
+	const uint sampleRate = uint(bytes[18]) << 12 | uint(bytes[19]) << 4 | uint(bytes[20]) >> 4;
+	const uint channels = ((uint(bytes[20]) >> 1) & 7) + 1;
+	const uint bitsPerSample = ((uint(bytes[20]) & 1) << 4 | uint(bytes[21]) >> 4) + 1;
+	const ulong64 totalSamples = ulong64(bytes[21] & 15) << 32 |
+		ulong64(bytes[22]) << 24 | uint(bytes[23]) << 16 | uint(bytes[24]) << 8 | bytes[25];
+	INTRA_ASSERT_EQUALS(sampleRate, 44100u);
+	INTRA_ASSERT_EQUALS(channels, 2u);
+	INTRA_ASSERT_EQUALS(bitsPerSample, 16u);
+	INTRA_ASSERT_EQUALS(totalSamples, ulong64(Frames));
+	// первый кадр следует сразу за STREAMINFO
+	INTRA_ASSERT_EQUALS(uint(bytes[42]) << 8 | bytes[43], 0xFFF8u);
+	output.PrintLine("FLAC: ", flacSize, " байт вместо ", Frames*4, " байт PCM.");
+	INTRA_ASSERT(flacSize < Frames*4/2);
+	size_t subframeTypeCounts[3] = {0, 0, 0};
+	INTRA_ASSERT(DecodeTestFlac(bytes, subframeTypeCounts) == QuantizeTestSamples(signal, Data::ValueType::SNorm16));
+	OS.FileDelete(fileName);
+
+	output.PrintLine("Декодирование FLAC: стерео PCM16, кадры по 4096 семплов:");
+	TestFlacSinkRoundTrip(output, Data::ValueType::SNorm16, 2, 4096);
+	output.PrintLine("Декодирование FLAC: моно PCM24, кадры по 200 семплов:");
+	TestFlacSinkRoundTrip(output, Data::ValueType::SNorm24, 1, 200);
+	output.PrintLine("Декодирование FLAC: три канала PCM16, кадры по 1000 семплов:");
+	TestFlacSinkRoundTrip(output, Data::ValueType::SNorm16, 3, 1000);
+}
@@ -0,0 +1,58 @@
+﻿#include "Audio.h"
+#include "Audio/Sinks/WaveSink.h"
+#include "Audio/Sources/Wave.h"
+#include "Container/Sequential/Array.h"
+#include "IO/FileSystem.h"
+#include "Math/Math.h"
+#include "Utils/Debug.h"
+
+using namespace Intra;
+using namespace IO;
+using namespace Audio;
+
+static void TestMappedWave(FormattedWriter& output)
+{
+	enum: size_t {Frames = 20000};
+	const StringView fileName = "TestMappedWave.wav";
+	Array<float> signal;
+	signal.SetCount(Frames*2);
+	for(size_t i = 0; i < signal.Length(); i++) signal[i] = float(Math::Sin(0.001*double(i)));
+	{
+		Sinks::WaveFileSink sink(fileName, 22050, 2, Data::ValueType::SNorm16, false);
+		sink.WriteInterleaved(signal);
+	}
+	{
+		Sources::Wave wave(OS.MapFile(fileName, Error::Skip()));
+		INTRA_ASSERT_EQUALS(wave.SampleCount(), size_t(Frames));
+		INTRA_ASSERT(!wave.SetSamplePosition(Frames + 1));
+
+		output.PrintLine("Переход к произвольной позиции и чтение без копирования.");
+		const size_t position = 12345;
+		INTRA_ASSERT(wave.SetSamplePosition(position));
+		INTRA_ASSERT_EQUALS(wave.SamplePosition(), position);
+		Data::ValueType type;
+		bool interleaved;
+		size_t samplesRead;
+		const FixedArray<const void*> raw = wave.GetRawSamplesData(100, &type, &interleaved, &samplesRead);
+		INTRA_ASSERT(type == Data::ValueType::SNorm16);
+		INTRA_ASSERT(interleaved);
+		INTRA_ASSERT_EQUALS(samplesRead, size_t(100));
+		INTRA_ASSERT_EQUALS(wave.SamplePosition(), position + 100);
+		const short* const rawShorts = static_cast<const short*>(raw[0]);
+
+		INTRA_ASSERT(wave.SetSamplePosition(position));
+		short decoded[200];
+		INTRA_ASSERT_EQUALS(wave.GetInterleavedSamples(decoded), size_t(100));
+		for(size_t i = 0; i < 200; i++)
+		{
+			INTRA_ASSERT_EQUALS(rawShorts[i], decoded[i]);
+			INTRA_ASSERT(Math::Abs(float(decoded[i])/32767 - signal[position*2 + i]) <= 1.0f/32767);
+		}
+	}
+	OS.FileDelete(fileName);
+}
+
+void TestAudioSourcesSeeking(FormattedWriter& output)
+{
+	TestMappedWave(output);
+}
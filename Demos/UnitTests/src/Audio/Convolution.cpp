@@ -0,0 +1,79 @@
+﻿#include "Audio.h"
+#include "Audio/Synth/ConvolutionReverb.h"
+#include "Audio/Synth/PostEffects.hh"
+#include "Container/Sequential/Array.h"
+#include "Math/Math.h"
+#include "Utils/Debug.h"
+
+using namespace Intra;
+using namespace IO;
+using namespace Audio::Synth;
+
+void TestConvolutionReverb(FormattedWriter& output)
+{
+	enum: size_t {ImpulseLength = 1000, SignalLength = 3000, BlockSize = 128};
+	Array<float> impulse, signal;
+	impulse.SetCountUninitialized(ImpulseLength);
+	signal.SetCountUninitialized(SignalLength);
+	for(size_t i = 0; i < ImpulseLength; i++) impulse[i] = Math::Exp(-float(i)/200.0f)*Math::Sin(float(i)*0.7f);
+	for(size_t i = 0; i < SignalLength; i++) signal[i] = Math::Sin(float(i)*0.05f) + float(i*7919 % 13)/13.0f - 0.5f;
+
+	Array<float> expected;
+	expected.SetCountUninitialized(SignalLength);
+	for(size_t i = 0; i < SignalLength; i++)
+	{
+		double sum = 0;
+		for(size_t j = 0; j < ImpulseLength && j <= i; j++) sum += double(impulse[j])*double(signal[i - j]);
+		expected[i] = float(0.5*double(signal[i]) + 0.75*sum);
+	}
+
+	const auto partitioned = Shared<PartitionedImpulseResponse>::New(impulse, BlockSize);
+	INTRA_ASSERT_EQUALS(partitioned->PartitionCount(), (ImpulseLength + BlockSize - 1)/BlockSize);
+
+	output.PrintLine("Потоковая свёртка кусками произвольной длины совпадает с прямой свёрткой с задержкой в один блок.");
+	ConvolutionReverb reverb(partitioned, 0.5f, 0.75f);
+	INTRA_ASSERT_EQUALS(reverb.Latency(), size_t(BlockSize));
+	Array<float> streamed = signal;
+	for(size_t pos = 0, chunk = 1; pos < SignalLength; chunk = chunk*3 % 97 + 1)
+	{
+		const size_t n = Funal::Min(chunk, SignalLength - pos);
+		reverb(streamed.Drop(pos).Take(n));
+		pos += n;
+	}
+	for(size_t i = 0; i < BlockSize; i++) INTRA_ASSERT_EQUALS(streamed[i], 0.0f);
+	for(size_t i = BlockSize; i < SignalLength; i++)
+		INTRA_ASSERT(Math::Abs(streamed[i] - expected[i - BlockSize]) < 1e-4f);
+
+	output.PrintLine("Эффект Reverb компенсирует задержку и не меняет длину звука.");
+	Array<float> whole = signal;
+	PostEffects::Reverb(partitioned, 0.5f, 0.75f)(whole, 44100);
+	for(size_t i = 0; i < SignalLength; i++)
+		INTRA_ASSERT(Math::Abs(whole[i] - expected[i]) < 1e-4f);
+
+	output.PrintLine("Эхо смешивает семпл с семплом, отстоящим на задержку, без копирования звука.");
+	Array<float> echoed = signal;
+	PostEffects::Echo(0.001f, 0.5f, 0.25f)(echoed, 10000);
+	for(size_t i = 0; i < SignalLength; i++)
+	{
+		const float expectedEcho = i + 10 < SignalLength? signal[i]*0.5f + signal[i + 10]*0.25f: signal[i];
+		INTRA_ASSERT(Math::Abs(echoed[i] - expectedEcho) < 1e-6f);
+	}
+
+	output.PrintLine("С отрицательной задержкой эхо смешивает семпл с предыдущим, проходя звук с конца.");
+	echoed = signal;
+	PostEffects::Echo(-0.0007f, 0.75f, -0.5f)(echoed, 10000);
+	for(size_t i = 0; i < SignalLength; i++)
+	{
+		const float expectedEcho = i >= 7? signal[i]*0.75f - signal[i - 7]*0.5f: signal[i];
+		INTRA_ASSERT(Math::Abs(echoed[i] - expectedEcho) < 1e-6f);
+	}
+
+	output.PrintLine("Эхо с нулевой громкостью исходного звука и задержкой длиннее звука.");
+	echoed = signal;
+	PostEffects::Echo(0.0005f, 0, 2)(echoed, 10000);
+	for(size_t i = 0; i < SignalLength; i++)
+		INTRA_ASSERT_EQUALS(echoed[i], i + 5 < SignalLength? signal[i + 5]*2: signal[i]);
+	echoed = signal;
+	PostEffects::Echo(-1, 0, 2)(echoed, 10000);
+	INTRA_ASSERT(echoed == signal);
+}
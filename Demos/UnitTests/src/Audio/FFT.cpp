@@ -0,0 +1,86 @@
+﻿#include "Audio.h"
+#include "Audio/AudioProcessing.h"
+#include "Container/Sequential/Array.h"
+#include "Math/Math.h"
+#include "Utils/Debug.h"
+
+using namespace Intra;
+using namespace IO;
+
+static void checkForwardAgainstDft(size_t size)
+{
+	Array<float> real, imag;
+	real.SetCountUninitialized(size);
+	imag.SetCountUninitialized(size);
+	for(size_t i = 0; i < size; i++)
+	{
+		real[i] = Math::Sin(float(i)*0.37f);
+		imag[i] = Math::Cos(float(i)*1.3f);
+	}
+	const Array<float> srcReal = real, srcImag = imag;
+	const Audio::FFTPlan& plan = Audio::FFTPlan::Get(size);
+	plan.Forward(real, imag);
+
+	for(size_t k = 0; k < size; k++)
+	{
+		double sumReal = 0, sumImag = 0;
+		for(size_t n = 0; n < size; n++)
+		{
+			const double angle = -2*Math::PI*double(n*k % size)/double(size);
+			sumReal += srcReal[n]*Math::Cos(angle) - srcImag[n]*Math::Sin(angle);
+			sumImag += srcReal[n]*Math::Sin(angle) + srcImag[n]*Math::Cos(angle);
+		}
+		INTRA_ASSERT(Math::Abs(sumReal - real[k]) < 1e-5*double(size));
+		INTRA_ASSERT(Math::Abs(sumImag - imag[k]) < 1e-5*double(size));
+	}
+
+	plan.Inverse(real, imag);
+	for(size_t i = 0; i < size; i++)
+	{
+		INTRA_ASSERT(Math::Abs(real[i] - srcReal[i]) < 1e-4f);
+		INTRA_ASSERT(Math::Abs(imag[i] - srcImag[i]) < 1e-4f);
+	}
+}
+
+static void checkRealRoundTrip(size_t size)
+{
+	Array<float> samples, restored, real, imag;
+	samples.SetCountUninitialized(size);
+	restored.SetCountUninitialized(size);
+	real.SetCountUninitialized(size/2 + 1);
+	imag.SetCountUninitialized(size/2 + 1);
+	for(size_t i = 0; i < size; i++) samples[i] = Math::Sin(float(i)*0.21f) + 0.25f;
+
+	const Audio::FFTPlan& plan = Audio::FFTPlan::Get(size);
+	plan.ForwardReal(samples, real, imag);
+
+	Array<float> fullReal = samples, fullImag;
+	fullImag.SetCount(size);
+	plan.Forward(fullReal, fullImag);
+	for(size_t k = 0; k <= size/2; k++)
+	{
+		INTRA_ASSERT(Math::Abs(fullReal[k] - real[k]) < 1e-5f*float(size));
+		INTRA_ASSERT(Math::Abs(fullImag[k] - imag[k]) < 1e-5f*float(size));
+	}
+
+	plan.InverseReal(real, imag, restored);
+	for(size_t i = 0; i < size; i++)
+		INTRA_ASSERT(Math::Abs(restored[i] - samples[i]) < 1e-4f);
+}
+
+void TestFFT(FormattedWriter& output)
+{
+	output.PrintLine("Сравниваем БПФ степеней двойки с дискретным преобразованием Фурье по определению.");
+	const size_t powerOfTwoSizes[] = {1, 2, 4, 8, 32, 128, 512};
+	for(size_t size: powerOfTwoSizes) checkForwardAgainstDft(size);
+
+	output.PrintLine("Размеры, не являющиеся степенями двойки, считаются алгоритмом Блюстейна.");
+	const size_t bluesteinSizes[] = {3, 5, 12, 100, 441};
+	for(size_t size: bluesteinSizes) checkForwardAgainstDft(size);
+
+	output.PrintLine("Преобразования действительных сигналов совпадают с комплексным и обратимы.");
+	const size_t realSizes[] = {2, 16, 1024, 882};
+	for(size_t size: realSizes) checkRealRoundTrip(size);
+
+	INTRA_ASSERT_EQUALS(&Audio::FFTPlan::Get(1024), &Audio::FFTPlan::Get(1024));
+}
@@ -0,0 +1,48 @@
+﻿#include "Audio.h"
+#include "Audio/Synth/Filter.h"
+#include "Container/Sequential/Array.h"
+#include "Random/FastUniform.h"
+#include "Math/Math.h"
+#include "Utils/Debug.h"
+
+using namespace Intra;
+using namespace IO;
+using namespace Audio;
+
+//! Обработать samples фильтром сразу целиком, что включает блочную обработку, и кусками короче
+//! минимальной длины блока, что оставляет только скалярную рекурсию. Результаты должны отличаться не больше чем на 5e-6
+//! относительно максимальной амплитуды. Обработка разбита на два вызова, чтобы проверить и перенос состояния.
+template<typename F> static void CheckBlockMatchesScalar(F filter, CSpan<float> samples)
+{
+	Array<float> block = samples, scalar = samples;
+	F blockFilter = filter;
+	const size_t half = block.Length()/2 + 3;
+	blockFilter(block.AsRange().Take(half));
+	blockFilter(block.AsRange().Drop(half));
+	for(size_t pos = 0; pos < scalar.Length(); pos += 31)
+		filter(scalar.AsRange().Drop(pos).Take(31));
+	float peak = 1, maxError = 0;
+	for(size_t i = 0; i < block.Length(); i++)
+	{
+		peak = Math::Max(peak, Math::Abs(scalar[i]));
+		maxError = Math::Max(maxError, Math::Abs(block[i] - scalar[i]));
+	}
+	INTRA_ASSERT(maxError <= 5e-6f*peak);
+}
+
+void TestSynthFilters(FormattedWriter& output)
+{
+	enum: uint {SampleRate = 48000, Count = 4801};
+	Random::FastUniform<float> rand(2718);
+	Array<float> samples;
+	for(uint i = 0; i < Count; i++)
+		samples.AddLast(0.5f*Math::Sin(float(i)*0.05f) + 0.4f*(rand() - 0.5f));
+
+	output.PrintLine("Блочная обработка биквадратного фильтра совпадает со скалярной.");
+	CheckBlockMatchesScalar(Synth::Filter(0.5f, 0.05f, Synth::FilterType::LowPass), samples);
+	CheckBlockMatchesScalar(Synth::Filter(1.2f, 0.2f, Synth::FilterType::HighPass), samples);
+
+	output.PrintLine("Блочная обработка резонансного фильтра и мягкого фильтра высоких частот совпадает со скалярной.");
+	CheckBlockMatchesScalar(Synth::ResonanceFilterFactory(440, 0.999f)(0, 1, SampleRate), samples);
+	CheckBlockMatchesScalar(Synth::SoftHighPassFilterFactory(200)(0, 1, SampleRate), samples);
+}
@@ -0,0 +1,130 @@
+﻿#include "Audio.h"
+#include "Audio/Sources/MidiRender.h"
+#include "Audio/Synth/MusicalInstrument.h"
+#include "Audio/Midi/MidiFileParser.h"
+#include "Container/Sequential/Array.h"
+#include "Math/Math.h"
+#include "Utils/Debug.h"
+
+using namespace Intra;
+using namespace IO;
+using namespace Audio;
+
+static void AddMidiEvent(Array<byte>& track, uint delay, byte status, byte data0, byte data1)
+{
+	// задержка в формате переменной длины
+	if(delay >= 128) track.AddLast(byte(0x80 | (delay >> 7)));
+	track.AddLast(byte(delay & 127));
+	track.AddLast(status);
+	track.AddLast(data0);
+	track.AddLast(data1);
+}
+
+//! MIDI-файл формата 0 из 96 тиков на четверть при стандартном темпе, то есть 192 тика в секунду.
+//! Аккорды перекрываются, между некоторыми из них есть паузы, высота тона меняется посреди звучащих нот.
+static Array<byte> CreateTestMidiFile()
+{
+	Array<byte> track;
+	for(byte i = 0; i < 12; i++)
+	{
+		const byte note = byte(48 + i*3);
+		AddMidiEvent(track, i % 4 == 0? 96: 0, 0x90, note, 100);
+		AddMidiEvent(track, 48, 0x90, byte(note + 7), 80);
+		if(i % 3 == 1) AddMidiEvent(track, 24, 0xE0, 0, byte(64 + i));
+		AddMidiEvent(track, 72, 0x80, note, 0);
+		AddMidiEvent(track, 0, 0x80, byte(note + 7), 0);
+	}
+	track.AddLast(0);
+	track.AddLast(0xFF);
+	track.AddLast(0x2F);
+	track.AddLast(0);
+
+	const byte header[] = {'M', 'T', 'h', 'd', 0, 0, 0, 6, 0, 0, 0, 1, 0, 96,
+		'M', 'T', 'r', 'k', 0, 0, byte(track.Length() >> 8), byte(track.Length() & 255)};
+	Array<byte> result;
+	result.AddLastRange(CSpanOf(header));
+	result.AddLastRange(track.AsConstRange());
+	return result;
+}
+
+//! Частота дискретизации, при которой все события тестового файла попадают точно на семпл.
+enum: uint {MidiRenderTestSampleRate = 192*50};
+
+static Array<float> RenderTestMidi(CSpan<byte> file, const Synth::MidiInstrumentSet& instruments,
+	double chunkDuration, size_t& chunkCount)
+{
+	ErrorStatus status;
+	Sources::MidiRenderParams params;
+	params.SampleRate = MidiRenderTestSampleRate;
+	params.MaxVolume = 4;
+	params.ChunkDuration = chunkDuration;
+	params.TailDuration = 1;
+	auto result = Sources::RenderMidi(Midi::MidiFileParser::CreateSingleOrderedMessageStream(
+		CSpanOfRaw<char>(file.Data(), file.Length()), status), instruments, params, ThreadPool::Default(), &chunkCount);
+	INTRA_ASSERT(!status.Handle());
+	return result;
+}
+
+//! Синтез того же файла одним MidiSynth в вызывающем потоке.
+static Array<float> RenderTestMidiSequentially(CSpan<byte> file, const Synth::MidiInstrumentSet& instruments, size_t sampleCount)
+{
+	ErrorStatus status;
+	Sources::MidiSynth synth(Midi::MidiFileParser::CreateSingleOrderedMessageStream(
+		CSpanOfRaw<char>(file.Data(), file.Length()), status),
+		double(sampleCount)/MidiRenderTestSampleRate - 2, instruments, 4, null, MidiRenderTestSampleRate, true);
+	INTRA_ASSERT(!status.Handle());
+	Array<float> left, right, result;
+	left.SetCount(sampleCount);
+	right.SetCount(sampleCount);
+	const Span<float> channels[] = {left, right};
+	const size_t samplesRead = synth.GetUninterleavedSamples(channels);
+	result.SetCount(samplesRead*2);
+	for(size_t i = 0; i < samplesRead; i++)
+	{
+		result[2*i] = left[i];
+		result[2*i + 1] = right[i];
+	}
+	return result;
+}
+
+static float MaxDifference(CSpan<float> a, CSpan<float> b)
+{
+	float result = 0;
+	for(size_t i = 0; i < a.Length(); i++) result = Math::Max(result, Math::Abs(a[i] - (i < b.Length()? b[i]: 0)));
+	return result;
+}
+
+void TestMidiParallelRender(FormattedWriter& output)
+{
+	Synth::MusicalInstrument instrument;
+	Synth::WaveInstrument wave;
+	wave.Scale = 0.3f;
+	instrument.Waves.AddLast(wave);
+	// долгое затухание, чтобы отпущенные ноты заходили в следующие части
+	instrument.ADSR = Synth::AdsrAttenuatorFactory(0.001f, 0, 1, 0.4f);
+	Synth::MidiInstrumentSet instruments;
+	instruments.Instruments[0] = &instrument;
+
+	const Array<byte> file = CreateTestMidiFile();
+	output.PrintLine("Синтез одной частью совпадает с последовательным синтезом MidiSynth.");
+	size_t wholeChunkCount, chunkCount;
+	const Array<float> whole = RenderTestMidi(file, instruments, 1000, wholeChunkCount);
+	INTRA_ASSERT_EQUALS(wholeChunkCount, size_t(1));
+	INTRA_ASSERT(whole.Length() > MidiRenderTestSampleRate*2*4);
+	float peak = 0;
+	for(float sample: whole) peak = Math::Max(peak, Math::Abs(sample));
+	INTRA_ASSERT(peak > 0.01f);
+	const Array<float> sequential = RenderTestMidiSequentially(file, instruments, whole.Length()/2);
+	INTRA_ASSERT(sequential.Length() > MidiRenderTestSampleRate*2*4);
+	const float sequentialDiff = MaxDifference(whole, sequential);
+	output.PrintLine("Максимальное отличие от MidiSynth: ", sequentialDiff);
+	INTRA_ASSERT(sequentialDiff < 1e-4f);
+
+	output.PrintLine("Синтез частями по полсекунды в нескольких потоках совпадает с синтезом одной частью.");
+	const Array<float> chunked = RenderTestMidi(file, instruments, 0.5, chunkCount);
+	output.PrintLine("Частей: ", chunkCount);
+	INTRA_ASSERT(chunkCount >= 4);
+	INTRA_ASSERT_EQUALS(whole.Length(), chunked.Length());
+	INTRA_ASSERT(MaxDifference(whole, chunked) < 1e-4f);
+	INTRA_ASSERT(MaxDifference(sequential, chunked) < 1e-4f);
+}
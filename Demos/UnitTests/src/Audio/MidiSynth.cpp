@@ -0,0 +1,187 @@
+﻿#include "Audio.h"
+#include "Audio/Sources/MidiSynth.h"
+#include "Audio/Synth/MusicalInstrument.h"
+#include "Audio/Synth/RecordedSampler.h"
+#include "Container/Sequential/Array.h"
+#include "Concurrency/Atomic.h"
+#include "Concurrency/ThreadPool.h"
+#include "Math/Math.h"
+#include "Utils/Debug.h"
+
+#include <stdlib.h>
+
+using namespace Intra;
+using namespace IO;
+using namespace Audio;
+
+#ifndef INTRA_NO_CRT
+//! Замена глобальных operator new и delete для проверки, что синтез не выделяет память.
+//! Выделения считаются только во время существования ScopedNewCounter, в остальное время вызовы передаются malloc и free.
+static AtomicBool gTestNewCounting{false};
+static AtomicInt gTestNewCount{0};
+
+void* operator new(size_t bytes)
+{
+	if(gTestNewCounting.GetRelaxed()) gTestNewCount.IncrementRelaxed();
+	// malloc(0) может вернуть null, а operator new должен вернуть уникальный указатель
+	return malloc(bytes != 0? bytes: 1);
+}
+
+void operator delete(void* block) noexcept {free(block);}
+void operator delete(void* block, size_t) noexcept {free(block);}
+
+//! Считает выделения памяти через operator new во всех потоках, пока существует.
+struct ScopedNewCounter
+{
+	ScopedNewCounter() {gTestNewCount.Set(0); gTestNewCounting.Set(true);}
+	~ScopedNewCounter() {gTestNewCounting.Set(false);}
+	int Count() const {return gTestNewCount.Get();}
+
+	ScopedNewCounter(const ScopedNewCounter&) = delete;
+	ScopedNewCounter& operator=(const ScopedNewCounter&) = delete;
+};
+#endif
+
+static Midi::NoteOn TestNoteOn(double time, byte note)
+{
+	Midi::NoteOn result{};
+	result.Time = time;
+	result.NoteOctaveOrDrumId = note;
+	result.Velocity = 100;
+	result.Volume = 100;
+	return result;
+}
+
+static Midi::NoteOn TestDrumOn(double time, byte drumId)
+{
+	Midi::NoteOn result = TestNoteOn(time, drumId);
+	result.Channel = 9;
+	return result;
+}
+
+static Midi::NoteOff TestNoteOff(double time, byte note)
+{
+	Midi::NoteOff result{};
+	result.Time = time;
+	result.NoteOctaveOrDrumId = note;
+	return result;
+}
+
+static size_t SynthesizeTestBlock(Sources::MidiSynth& synth, size_t sampleCount)
+{
+	Array<float> left, right;
+	left.SetCount(sampleCount);
+	right.SetCount(sampleCount);
+	const Span<float> channels[] = {left, right};
+	return synth.GetUninterleavedSamples(channels);
+}
+
+//! Синтезировать аккорд из 12 нот в пуле потоков pool. Возвращает каналы, записанные друг за другом.
+static Array<float> RenderTestChord(const Synth::MidiInstrumentSet& instruments, ThreadPool& pool)
+{
+	enum: uint {SampleRate = 8000, SampleCount = 5000};
+	Sources::MidiSynth synth(Midi::TrackCombiner(96), 10, instruments, 1, null, SampleRate, true);
+	synth.SetThreadPool(&pool);
+	for(byte note = 50; note < 62; note++) synth.OnNoteOn(TestNoteOn(0, note));
+	Array<float> result;
+	result.SetCount(2*SampleCount);
+	const Span<float> channels[] = {result.AsRange().Take(SampleCount), result.AsRange().Drop(SampleCount)};
+	INTRA_ASSERT_EQUALS(synth.GetUninterleavedSamples(channels), size_t(SampleCount));
+	return result;
+}
+
+void TestMidiSynthVoicePool(FormattedWriter& output)
+{
+	enum: uint {SampleRate = 8000};
+	Synth::MusicalInstrument instrument;
+	Synth::WaveInstrument wave;
+	wave.Scale = 0.3f;
+	instrument.Waves.AddLast(wave);
+	instrument.ADSR = Synth::AdsrAttenuatorFactory(0.001f, 0, 1, 0.01f);
+	Synth::CachedDrumInstrument cachedDrum(Synth::WhiteNoiseSampler(0.1f, 0.5f), SampleRate/20);
+	cachedDrum.Preload(SampleRate);
+	Synth::GenericDrumInstrument drum = cachedDrum;
+	Synth::MidiInstrumentSet instruments;
+	instruments.Instruments[0] = &instrument;
+	instruments.DrumInstruments[35] = &drum;
+
+	Sources::MidiSynth synth(Midi::TrackCombiner(96), 10, instruments, 1, null, SampleRate, true);
+	synth.SetMaxVoiceCount(4);
+	INTRA_ASSERT_EQUALS(synth.MaxVoiceCount(), size_t(4));
+
+	output.PrintLine("При нехватке голосов новые ноты вытесняют самые старые.");
+	for(byte note = 60; note < 66; note++) synth.OnNoteOn(TestNoteOn(0, note));
+	INTRA_ASSERT_EQUALS(synth.ActiveVoiceCount(), size_t(4));
+	// ноты 60 и 61 вытеснены, их отпускание ничего не меняет
+	synth.OnNoteOff(TestNoteOff(0, 60));
+	synth.OnNoteOff(TestNoteOff(0, 61));
+	INTRA_ASSERT_EQUALS(SynthesizeTestBlock(synth, SampleRate/10), size_t(SampleRate/10));
+	INTRA_ASSERT_EQUALS(synth.ActiveVoiceCount(), size_t(4));
+
+	output.PrintLine("Отпущенные ноты освобождают голоса после затухания.");
+	synth.OnNoteOff(TestNoteOff(0.1, 62));
+	INTRA_ASSERT_EQUALS(synth.ActiveVoiceCount(), size_t(4));
+	SynthesizeTestBlock(synth, SampleRate/10);
+	INTRA_ASSERT_EQUALS(synth.ActiveVoiceCount(), size_t(3));
+
+	output.PrintLine("Отпущенный голос вытесняется раньше нажатых.");
+	synth.OnNoteOn(TestNoteOn(0.2, 70));
+	synth.OnNoteOff(TestNoteOff(0.2, 63));
+	synth.OnNoteOn(TestNoteOn(0.2, 71));
+	INTRA_ASSERT_EQUALS(synth.ActiveVoiceCount(), size_t(4));
+	// нота 64 должна звучать до сих пор, поэтому её отпускание освобождает ещё один голос
+	synth.OnNoteOff(TestNoteOff(0.2, 64));
+	SynthesizeTestBlock(synth, SampleRate/10);
+	INTRA_ASSERT_EQUALS(synth.ActiveVoiceCount(), size_t(3));
+
+	output.PrintLine("Повторное нажатие звучащей ноты отпускает её старый голос.");
+	synth.OnNoteOn(TestNoteOn(0.3, 70));
+	INTRA_ASSERT_EQUALS(synth.ActiveVoiceCount(), size_t(4));
+	SynthesizeTestBlock(synth, SampleRate/10);
+	INTRA_ASSERT_EQUALS(synth.ActiveVoiceCount(), size_t(3));
+
+	synth.OnAllNotesOff(0);
+	SynthesizeTestBlock(synth, SampleRate/10);
+	INTRA_ASSERT_EQUALS(synth.ActiveVoiceCount(), size_t(0));
+
+	output.PrintLine("Параллельный синтез не зависит от числа потоков и совпадает с последовательным с точностью до округления.");
+	ThreadPool noThreads(0), twoThreads(2), fiveThreads(5);
+	const Array<float> sequential = RenderTestChord(instruments, noThreads);
+	const Array<float> parallel = RenderTestChord(instruments, twoThreads);
+	INTRA_ASSERT(parallel == RenderTestChord(instruments, fiveThreads));
+	float maxSample = 0;
+	for(size_t i = 0; i < sequential.Length(); i++)
+	{
+		INTRA_ASSERT(Math::Abs(parallel[i] - sequential[i]) <= 1e-5f);
+		maxSample = Math::Max(maxSample, Math::Abs(sequential[i]));
+	}
+	INTRA_ASSERT(maxSample > 0.1f);
+
+#ifndef INTRA_NO_CRT
+	output.PrintLine("Нажатие нот и параллельный синтез на переиспользуемых голосах не выделяют память.");
+	instrument.ExponentAttenuation = Synth::ExponentAttenuatorFactory(0.9f, 2);
+	instrument.Chorus = Synth::ChorusFactory(0.002f);
+	instrument.WhiteNoise = Synth::WhiteNoiseInstrument(0.1f);
+	synth.SetThreadPool(&twoThreads);
+	Array<float> left, right;
+	left.SetCount(SampleRate/10);
+	right.SetCount(SampleRate/10);
+	const Span<float> channels[] = {left, right};
+	// первые нажатия выделяют память линий задержки хоруса каждого голоса
+	for(byte note = 60; note < 64; note++) synth.OnNoteOn(TestNoteOn(0.5, note));
+	synth.GetUninterleavedSamples(channels);
+	synth.OnAllNotesOff(0);
+	synth.GetUninterleavedSamples(channels);
+	{
+		ScopedNewCounter counter;
+		for(byte note = 60; note < 100; note++) synth.OnNoteOn(TestNoteOn(0.7, note));
+		synth.OnNoteOn(TestDrumOn(0.7, 35));
+		INTRA_ASSERT_EQUALS(synth.ActiveVoiceCount(), size_t(4));
+		INTRA_ASSERT_EQUALS(synth.GetUninterleavedSamples(channels), size_t(SampleRate/10));
+		INTRA_ASSERT_EQUALS(counter.Count(), 0);
+	}
+	float maxRendered = 0;
+	for(float sample: left) maxRendered = Math::Max(maxRendered, Math::Abs(sample));
+	INTRA_ASSERT(maxRendered > 0.1f);
+#endif
+}
@@ -0,0 +1,52 @@
+﻿#include "Audio.h"
+#include "Audio/Resample.h"
+#include "Container/Sequential/Array.h"
+#include "Math/Math.h"
+#include "Utils/Debug.h"
+
+using namespace Intra;
+using namespace IO;
+using namespace Audio;
+
+static Array<float> resampleSine(uint srcRate, uint dstRate, double freq, size_t inputLength, size_t chunkLength)
+{
+	PolyphaseResampler resampler(srcRate, dstRate, ResampleQuality::High);
+	Array<float> input;
+	input.SetCount(inputLength + resampler.InputLatency(), 0);
+	for(size_t i = 0; i < inputLength; i++) input[i] = float(Math::Sin(2*Math::PI*freq*double(i)/double(srcRate)));
+
+	Array<float> output;
+	output.SetCount(resampler.OutputLengthFor(input.Length()), 0);
+	INTRA_ASSERT_EQUALS(output.Length(), size_t(ulong64(inputLength)*dstRate/srcRate) + (ulong64(inputLength)*dstRate % srcRate != 0));
+	Span<float> dst = output;
+	for(size_t pos = 0; pos < input.Length(); pos += chunkLength)
+	{
+		CSpan<float> src = input.AsConstRange().Drop(pos).Take(chunkLength);
+		resampler.Process(src, dst);
+		INTRA_ASSERT(src.Empty());
+	}
+	INTRA_ASSERT(dst.Empty());
+	return output;
+}
+
+void TestPolyphaseResampler(FormattedWriter& output)
+{
+	output.PrintLine("44100 -> 48000: синус после ресемплинга совпадает с синусом, вычисленным на новой частоте.");
+	const Array<float> whole = resampleSine(44100, 48000, 1000, 22050, 22050 + 16);
+	for(size_t i = 480; i + 480 < whole.Length(); i++)
+		INTRA_ASSERT(Math::Abs(whole[i] - float(Math::Sin(2*Math::PI*1000*double(i)/48000))) < 1e-3f);
+
+	output.PrintLine("Результат не зависит от того, какими кусками подаётся вход.");
+	const Array<float> chunked = resampleSine(44100, 48000, 1000, 22050, 37);
+	INTRA_ASSERT_EQUALS(chunked.Length(), whole.Length());
+	for(size_t i = 0; i < whole.Length(); i++) INTRA_ASSERT_EQUALS(chunked[i], whole[i]);
+
+	output.PrintLine("При понижении частоты 48000 -> 8000 тон выше новой частоты Найквиста подавляется.");
+	const Array<float> aliased = resampleSine(48000, 8000, 5200, 24000, 1000);
+	for(size_t i = 100; i + 100 < aliased.Length(); i++) INTRA_ASSERT(Math::Abs(aliased[i]) < 1e-3f);
+
+	output.PrintLine("Отношение 44100 -> 48001 требует больше фаз, чем хранится, и использует интерполяцию между ними.");
+	const Array<float> interpolated = resampleSine(44100, 48001, 1000, 22050, 500);
+	for(size_t i = 480; i + 480 < interpolated.Length(); i++)
+		INTRA_ASSERT(Math::Abs(interpolated[i] - float(Math::Sin(2*Math::PI*1000*double(i)/48001))) < 1e-3f);
+}
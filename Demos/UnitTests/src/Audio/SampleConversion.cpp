@@ -0,0 +1,81 @@
+﻿#include "Audio.h"
+#include "Audio/SampleConversion.h"
+#include "Container/Sequential/Array.h"
+#include "Math/Math.h"
+#include "Utils/Debug.h"
+
+using namespace Intra;
+using namespace IO;
+using namespace Audio;
+
+//! 37 кадров: четыре блока SIMD ядер и хвост, обрабатываемый скалярным кодом.
+enum: uint {ConversionFrames = 37, MaxConversionChannels = 9};
+
+//! Выходит за [-1; 1] в части отсчётов, чтобы проверить насыщение.
+static float ConversionTestSample(uint frame, uint channel)
+{return Math::Sin(float(frame*(channel + 3))*0.37f + float(channel))*(channel % 3 == 0? 1.2f: 0.9f);}
+
+static short ReferenceShort(float x)
+{
+	const float v = x*32767;
+	return short(v >= 32767? 32767: v <= -32768? -32768: v);
+}
+
+void TestSampleConversion(FormattedWriter& output)
+{
+	Array<float> channels[MaxConversionChannels];
+	CSpan<float> src[MaxConversionChannels];
+	for(uint c = 0; c < MaxConversionChannels; c++)
+	{
+		for(uint i = 0; i < ConversionFrames; i++) channels[c].AddLast(ConversionTestSample(i, c));
+		src[c] = channels[c];
+	}
+
+	output.PrintLine("SIMD ядра перемежения и разделения каналов совпадают с поэлементным преобразованием для 1-9 каналов.");
+	Array<float> interleaved, back[MaxConversionChannels];
+	Array<short> shorts;
+	for(uint n = 1; n <= MaxConversionChannels; n++)
+	{
+		const Span<CSpan<float>> srcSpan = SpanOf(src).Take(n);
+		interleaved.SetCount(ConversionFrames*n);
+		shorts.SetCount(ConversionFrames*n);
+		if(n >= 2) InterleaveFloats(interleaved, srcSpan);
+		InterleaveFloatsCastToShorts(shorts, srcSpan);
+		for(uint i = 0; i < ConversionFrames; i++)
+			for(uint c = 0; c < n; c++)
+			{
+				if(n >= 2) INTRA_ASSERT_EQUALS(interleaved[i*n + c], channels[c][i]);
+				INTRA_ASSERT_EQUALS(shorts[i*n + c], ReferenceShort(channels[c][i]));
+			}
+		if(n < 2) continue;
+
+		Span<float> dst[MaxConversionChannels];
+		for(uint c = 0; c < n; c++)
+		{
+			back[c].SetCount(ConversionFrames);
+			dst[c] = back[c];
+		}
+		DeinterleaveFloats(interleaved, SpanOf(dst).Take(n));
+		for(uint c = 0; c < n; c++) INTRA_ASSERT(back[c] == channels[c]);
+	}
+
+	output.PrintLine("Дизеринг отклоняется от точного значения меньше чем на 1.5 единицы и не сдвигает каналы вызывающего кода.");
+	for(uint n = 1; n <= MaxConversionChannels; n++)
+	{
+		const CSpan<float> before[MaxConversionChannels] = {src[0], src[1], src[2], src[3], src[4], src[5], src[6], src[7], src[8]};
+		shorts.SetCount(ConversionFrames*n);
+		TpdfDither dither(n);
+		InterleaveFloatsCastToShorts(shorts, SpanOf(src).Take(n), dither);
+		for(uint c = 0; c < MaxConversionChannels; c++)
+		{
+			INTRA_ASSERT(src[c].Begin == before[c].Begin);
+			INTRA_ASSERT(src[c].End == before[c].End);
+		}
+		for(uint i = 0; i < ConversionFrames; i++)
+			for(uint c = 0; c < n; c++)
+			{
+				const float exact = Math::Clamp(channels[c][i]*32767, -32768.0f, 32767.0f);
+				INTRA_ASSERT(Math::Abs(float(shorts[i*n + c]) - exact) < 1.5f);
+			}
+	}
+}
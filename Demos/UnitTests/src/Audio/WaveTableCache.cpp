@@ -0,0 +1,65 @@
+﻿#include "Audio.h"
+#include "Audio/Synth/WaveTableSampler.h"
+#include "Concurrency/ThreadPool.h"
+#include "Concurrency/ParallelFor.h"
+#include "Container/Sequential/Array.h"
+#include "Math/Math.h"
+#include "Utils/Debug.h"
+
+using namespace Intra;
+using namespace IO;
+using namespace Audio::Synth;
+
+static WaveTableCache CreateTestWaveTableCache(bool allowMipmaps)
+{
+	WaveTableCache result;
+	result.Generator = [](float freq, uint sampleRate)
+	{
+		WaveTable tbl;
+		tbl.BaseLevelLength = 256;
+		tbl.BaseLevelRatio = freq/float(sampleRate);
+		tbl.Data.SetCountUninitialized(tbl.BaseLevelLength);
+		for(size_t i = 0; i < tbl.BaseLevelLength; i++) tbl.Data[i] = Math::Sin(2*float(Math::PI)*float(i)/float(tbl.BaseLevelLength));
+		tbl.GenerateAllNextLevels();
+		return tbl;
+	};
+	result.AllowMipmaps = allowMipmaps;
+	return result;
+}
+
+static float TestNoteFrequency(size_t note) {return 110*Math::Pow(2.0f, float(note)/12);}
+
+void TestWaveTableCache(FormattedWriter& output)
+{
+	enum: size_t {NoteCount = 24, RequestCount = 4000, SampleRate = 48000};
+	ThreadPool pool(4);
+
+	output.PrintLine("Параллельные запросы к кешу генерируют каждую таблицу ровно один раз.");
+	const WaveTableCache cache = CreateTestWaveTableCache(false);
+	Array<const WaveTable*> tables;
+	tables.SetCount(RequestCount);
+	Concurrency::ParallelFor(pool, RequestCount, [&](size_t begin, size_t end) {
+		for(size_t i = begin; i < end; i++) tables[i] = &cache.Get(TestNoteFrequency(i % NoteCount), SampleRate);
+	}, 16);
+	INTRA_ASSERT_EQUALS(cache.Count(), size_t(NoteCount));
+	for(size_t i = 0; i < RequestCount; i++)
+	{
+		INTRA_ASSERT_EQUALS(tables[i], &cache.Get(TestNoteFrequency(i % NoteCount), SampleRate));
+		INTRA_ASSERT(tables[i]->CheckInvariant());
+	}
+
+	output.PrintLine("Другая частота дискретизации требует отдельных таблиц.");
+	cache.Get(TestNoteFrequency(0), SampleRate/2);
+	INTRA_ASSERT_EQUALS(cache.Count(), size_t(NoteCount + 1));
+
+	output.PrintLine("Таблицы с мипмапами, загруженные для нижней октавы, используются для верхних октав.");
+	const WaveTableCache mipmapped = CreateTestWaveTableCache(true);
+	float lowerOctave[12];
+	for(size_t i = 0; i < 12; i++) lowerOctave[i] = TestNoteFrequency(i);
+	mipmapped.Preload(lowerOctave, SampleRate);
+	INTRA_ASSERT_EQUALS(mipmapped.Count(), size_t(12));
+	Concurrency::ParallelFor(pool, RequestCount, [&](size_t begin, size_t end) {
+		for(size_t i = begin; i < end; i++) mipmapped.Get(TestNoteFrequency(i % 48), SampleRate);
+	}, 16);
+	INTRA_ASSERT_EQUALS(mipmapped.Count(), size_t(12));
+}
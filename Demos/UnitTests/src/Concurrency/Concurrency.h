@@ -4,3 +4,4 @@
 
 void TestAtomics(Intra::FormattedWriter& output);
 void TestInterruption(Intra::FormattedWriter& output);
+void TestThreadPool(Intra::FormattedWriter& output);
@@ -0,0 +1,83 @@
+﻿#include "Concurrency.h"
+
+#if !defined(INTRA_NO_CONCURRENCY)
+
+#include "Concurrency/Thread.h"
+
+#if(INTRA_LIBRARY_THREAD != INTRA_LIBRARY_THREAD_None)
+
+#include "Concurrency/ThreadPool.h"
+#include "Concurrency/Job.h"
+#include "Concurrency/Atomic.h"
+#include "Container/Sequential/Array.h"
+
+using namespace Intra;
+
+static void TestParallelSumJob(Job* parent, AtomicLong* sum, uint begin, uint end)
+{
+	if(end - begin <= 100)
+	{
+		long64 partialSum = 0;
+		for(uint i = begin; i < end; i++) partialSum += i;
+		sum->Add(partialSum);
+		return;
+	}
+	const uint middle = (begin + end)/2;
+	Job::CreateAsChild(parent, [=](){TestParallelSumJob(parent, sum, begin, middle);})->Run();
+	Job::CreateAsChild(parent, [=](){TestParallelSumJob(parent, sum, middle, end);})->Run();
+}
+
+static void TestIncrementElements(int* data, uint count)
+{
+	for(uint i = 0; i < count; i++) data[i]++;
+}
+
+static int TestFibonacciJob(ThreadPool& pool, int n)
+{
+	if(n < 10) return n < 2? n: TestFibonacciJob(pool, n-1) + TestFibonacciJob(pool, n-2);
+	int left = 0;
+	Job* const job = Job::Create(pool, [&pool, &left, n]() {left = TestFibonacciJob(pool, n-1);});
+	job->Run();
+	const int right = TestFibonacciJob(pool, n-2);
+	job->Wait();
+	job->Release();
+	return left + right;
+}
+
+void TestThreadPool(FormattedWriter& output)
+{
+	ThreadPool pool(4);
+	output.PrintLine("Worker threads: ", pool.ThreadCount());
+	INTRA_ASSERT_EQUALS(pool.ThreadCount(), 4u);
+	INTRA_ASSERT_EQUALS(pool.CurrentWorkerIndex(), -1);
+
+	AtomicLong sum{0};
+	const uint n = 100000;
+	Job* const root = Job::Create(pool, [](){});
+	for(uint i = 0; i < 10; i++)
+	{
+		const uint begin = n*i/10, end = n*(i + 1)/10;
+		Job::CreateAsChild(root, [root, &sum, begin, end]() {TestParallelSumJob(root, &sum, begin, end);})->Run();
+	}
+	root->RunAndWait();
+	INTRA_ASSERT(root->IsFinished());
+	root->Release();
+	output.PrintLine("Parallel sum: ", sum.Get());
+	INTRA_ASSERT_EQUALS(sum.Get(), long64(n)*(n - 1)/2);
+
+	Array<int> values;
+	values.SetCount(50000, 1);
+	Job* const forJob = Job::parallel_for(pool, values.Data(), uint(values.Count()),
+		&TestIncrementElements, Concurrency::CountSplitter(1000));
+	forJob->RunAndWait();
+	forJob->Release();
+	for(int x: values) INTRA_ASSERT_EQUALS(x, 2);
+
+	int fib = 0;
+	pool.Execute([&]() {fib = TestFibonacciJob(pool, 25);});
+	output.PrintLine("Fibonacci(25) computed with nested waits: ", fib);
+	INTRA_ASSERT_EQUALS(fib, 75025);
+}
+
+#endif
+#endif
@@ -1,5 +1,7 @@
 ﻿#include "HashMap.h"
 #include "Container/Associative/HashMap.h"
+#include "Container/Associative/FlatHashMap.h"
+#include "Utils/Debug.h"
 
 using namespace Intra;
 using namespace IO;
@@ -30,3 +32,42 @@ void TestMaps(FormattedWriter& output)
 	output.PrintLine(map);
 }
 
+
+void TestFlatHashMap(FormattedWriter& output)
+{
+	FlatHashMap<String, int> names;
+	names["Строка"] = 6;
+	names["Тест"] = 4;
+	names["Вывод"] = 5;
+	names["FlatHashMap"] = 11;
+	INTRA_ASSERT_EQUALS(names.Count(), 4u);
+	INTRA_ASSERT_EQUALS(names.Get("Тест", -1), 4);
+	INTRA_ASSERT(names.Remove("Тест"));
+	INTRA_ASSERT(!names.Contains("Тест"));
+	output.PrintLine("Заполнили FlatHashMap и удалили из него ключ \"Тест\":");
+	output.PrintLine(names);
+
+	// удаление сдвигает элементы назад, поэтому после каждого удаления все оставшиеся ключи должны находиться
+	FlatHashMap<uint, uint> map;
+	enum: uint {N = 20000};
+	for(uint i = 0; i < N; i++) map.Insert(i*7919u, i);
+	INTRA_ASSERT_EQUALS(map.Count(), size_t(N));
+	for(uint i = 0; i < N; i += 2) INTRA_ASSERT(map.Remove(i*7919u));
+	INTRA_ASSERT_EQUALS(map.Count(), size_t(N/2));
+	for(uint i = 0; i < N; i++)
+	{
+		auto found = map.Find(i*7919u);
+		if(i % 2 == 0) INTRA_ASSERT(found.Empty());
+		else INTRA_ASSERT(!found.Empty() && found.First().Value == i);
+	}
+
+	FlatHashMap<uint, uint> copy = map;
+	INTRA_ASSERT(copy == map);
+	copy[1] = 1;
+	INTRA_ASSERT(copy != map);
+
+	size_t iterated = 0;
+	for(auto&& element: map) {(void)element; iterated++;}
+	INTRA_ASSERT_EQUALS(iterated, map.Count());
+	output.PrintLine("Вставили ", size_t(N), " элементов, удалили половину, осталось ", map.Count(), ", ячеек в таблице: ", map.Capacity());
+}
@@ -1,6 +1,7 @@
-#pragma once
+﻿#pragma once
 
 #include "IO/FormattedWriter.h"
 
 void TestMaps(Intra::IO::FormattedWriter& output);
+void TestFlatHashMap(Intra::IO::FormattedWriter& output);
 
@@ -0,0 +1,59 @@
+﻿#include "StructureOfArrays.h"
+#include "Container/Sequential/StructureOfArrays.h"
+#include "Container/Sequential/String.h"
+#include "Range/Mutation/Transform.h"
+#include "Range/Reduction.h"
+#include "Meta/GetField.h"
+#include "Utils/Debug.h"
+
+using namespace Intra;
+using namespace IO;
+
+void TestStructureOfArrays(FormattedWriter& output)
+{
+	enum {X, VX, Id, Name};
+	StructureOfArrays<float, float, int, String> particles;
+	INTRA_ASSERT(particles.Empty());
+
+	output.PrintLine("Добавляем 100 частиц по одной, ёмкость растёт геометрически.");
+	for(int i = 0; i < 100; i++)
+		INTRA_ASSERT_EQUALS(particles.AddLast(float(i), 0.5f, i, StringOf(i)), size_t(i));
+	INTRA_ASSERT_EQUALS(particles.Count(), 100u);
+	INTRA_ASSERT(particles.Capacity() >= 100);
+
+	output.PrintLine("Прибавляем столбец скоростей к столбцу координат векторной функцией Add.");
+	Range::Add(particles.Column<X>(), particles.Column<VX>());
+	INTRA_ASSERT_EQUALS(particles.Get<X>(10), 10.5f);
+	INTRA_ASSERT_EQUALS(Range::Maximum(particles.Column<X>().AsConstRange()), 99.5f);
+
+	output.PrintLine("Проходим по двум столбцам из четырёх через Columns.");
+	for(auto p: particles.Columns<VX, Id>())
+		Meta::Get<0>(p) = float(Meta::Get<1>(p));
+	INTRA_ASSERT_EQUALS(particles.Get<VX>(42), 42.0f);
+
+	output.PrintLine("Удаляем частицу 5 со сдвигом и частицу 0 с заменой последней.");
+	particles.Remove(5);
+	INTRA_ASSERT_EQUALS(particles.Get<Id>(5), 6);
+	INTRA_ASSERT_EQUALS(particles.Get<Name>(5), "6");
+	particles.RemoveUnordered(0);
+	INTRA_ASSERT_EQUALS(particles.Count(), 98u);
+	INTRA_ASSERT_EQUALS(particles.Get<Id>(0), 99);
+	INTRA_ASSERT_EQUALS(particles.Get<Name>(0), "99");
+	INTRA_ASSERT_EQUALS(particles.Get<X>(0), 99.5f);
+
+	auto copy = particles;
+	particles.SetCount(10);
+	INTRA_ASSERT_EQUALS(copy.Count(), 98u);
+	INTRA_ASSERT_EQUALS(copy.Get<Id>(97), 98);
+	INTRA_ASSERT_EQUALS(copy.Get<Name>(97), "98");
+
+	particles.SetCount(12);
+	INTRA_ASSERT_EQUALS(particles.Get<Id>(11), 0);
+	INTRA_ASSERT(particles.Get<Name>(11).Empty());
+
+	auto moved = Cpp::Move(copy);
+	INTRA_ASSERT(copy.Empty());
+	INTRA_ASSERT_EQUALS(moved.Count(), 98u);
+	moved = null;
+	INTRA_ASSERT_EQUALS(moved.Capacity(), 0u);
+}
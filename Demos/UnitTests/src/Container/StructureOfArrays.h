@@ -0,0 +1,5 @@
+﻿#pragma once
+
+#include "IO/FormattedWriter.h"
+
+void TestStructureOfArrays(Intra::IO::FormattedWriter& output);
@@ -0,0 +1,41 @@
+﻿#include "Cpp/Warnings.h"
+INTRA_PUSH_DISABLE_REDUNDANT_WARNINGS
+
+#include "Hash.h"
+
+#include "Hash/Fast64.h"
+#include "Hash/MurmurCT.h"
+#include "Container/Sequential/String.h"
+#include "IO/FormattedWriter.h"
+#include "Utils/Debug.h"
+#include "Random/FastUniform.h"
+
+using namespace Intra;
+
+void TestHashFunctions(IO::FormattedWriter& output)
+{
+	output.PrintLine("Fast64 совпадает с compile-time версией HashCT::Fast64 на коротком, среднем и длинном путях.");
+	Random::FastUniform<uint> rand(37);
+	String str;
+	str.SetLengthUninitialized(5000);
+	for(char& c: str) c = char(rand(256));
+	static const ulong64 seeds[] = {0, 1, 0x123456789ABCDEF0ULL};
+	// Аккумуляторы перемешиваются после каждых 16 полос по 64 байта, то есть начиная с 1024 байт.
+	// Длины вокруг 1024 и 1088 и длины, не кратные 64, проверяют перемешивание вместе с последней неполной полосой.
+	static const size_t longLengths[] = {1023, 1024, 1025, 1087, 1088, 1089, 1100, 2048, 2111, 2113, 3000, 4159, 5000};
+	for(ulong64 seed: seeds)
+	{
+		for(size_t len = 0; len <= 300; len++)
+		{
+			const StringView key = str.Take(len);
+			INTRA_ASSERT_EQUALS(Hash::Fast64(key, seed), Range::HashCT::Fast64(key.Data(), len, seed));
+		}
+		for(size_t len: longLengths)
+		{
+			const StringView key = str.Take(len);
+			INTRA_ASSERT_EQUALS(Hash::Fast64(key, seed), Range::HashCT::Fast64(key.Data(), len, seed));
+		}
+	}
+}
+
+INTRA_WARNING_POP
@@ -0,0 +1,5 @@
+#pragma once
+
+#include "IO/FormattedWriter.h"
+
+void TestHashFunctions(Intra::IO::FormattedWriter& output);
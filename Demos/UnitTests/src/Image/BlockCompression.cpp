@@ -0,0 +1,172 @@
+﻿#include "Image.h"
+#include "Image/BlockCompression.h"
+#include "Image/Resample.h"
+#include "Image/AnyImage.h"
+#include "Image/Loaders/LoaderDDS.h"
+#include "Image/Loaders/LoaderKTX.h"
+#include "Container/Sequential/Array.h"
+#include "Container/Sequential/String.h"
+#include "Range/Polymorphic/ForwardRange.h"
+#include "Range/Polymorphic/OutputRange.h"
+#include "Range/Comparison/Equals.h"
+#include "Math/Math.h"
+#include "Utils/Debug.h"
+
+using namespace Intra;
+using namespace IO;
+using namespace Image;
+
+//! Плавный градиент с шумом в младших битах: типичное содержимое текстуры.
+static byte BlockTestSample(uint x, uint y, uint c)
+{return byte(c == 3? 255 - x*4 - y*3: 20 + x*(3 + c) + y*(5 - c) + (x*y*13 + c*7) % 5);}
+
+static Array<byte> BlockTestImage(uint w, uint h)
+{
+	Array<byte> result;
+	result.SetCountUninitialized(w*h*4);
+	for(uint y = 0; y < h; y++)
+		for(uint x = 0; x < w; x++)
+			for(uint c = 0; c < 4; c++) result[(y*w + x)*4 + c] = BlockTestSample(x, y, c);
+	return result;
+}
+
+//! Среднеквадратичная ошибка канала channel после сжатия в format и распаковки.
+//! Для LATC сравнение идёт с яркостью исходных пикселей.
+static double RoundTripError(ImageFormat format, uint quality, uint channel)
+{
+	enum: uint {W = 19, H = 10};
+	const Array<byte> src = BlockTestImage(W, H);
+	Array<byte> blocks, dst;
+	blocks.SetCount(((W + 3)/4)*((H + 3)/4)*16);
+	dst.SetCount(W*H*4);
+	BlockCompressParams params;
+	params.Quality = quality;
+	CompressBlocks(src, W*4, {W, H}, format, blocks, params);
+	DecompressBlocks(CSpanOf(blocks), format, {W, H}, dst, W*4);
+	const bool luminance = format == ImageFormat::LATC_Luminance || format == ImageFormat::LATC_LuminanceAlpha;
+	double sum = 0;
+	for(uint i = 0; i < W*H; i++)
+	{
+		int expected = src[i*4 + channel];
+		if(luminance && channel != 3)
+			expected = int((src[i*4]*77u + src[i*4 + 1]*150u + src[i*4 + 2]*29u + 128) >> 8);
+		const int d = dst[i*4 + channel] - expected;
+		sum += d*d;
+	}
+	return Math::Sqrt(float(sum/(W*H)));
+}
+
+static void CheckFileRoundTrip(const AnyImage& image, bool ktx)
+{
+	String file;
+	OutputStream stream = LastAppender(file);
+	if(ktx) LoaderKTX::Instance.Save(image, *stream.Stream);
+	else LoaderDDS::Instance.Save(image, *stream.Stream);
+	const AnyImage loaded = AnyImage::FromStream(CSpanOfRaw<char>(file.Data(), file.Length()));
+	INTRA_ASSERT(loaded != null);
+	INTRA_ASSERT(loaded.Info.Format == image.Info.Format);
+	INTRA_ASSERT(loaded.Info.Size == image.Info.Size);
+	INTRA_ASSERT_EQUALS(loaded.Info.MipmapCount, image.Info.MipmapCount);
+	INTRA_ASSERT(loaded.Data == image.Data);
+}
+
+void TestBlockCompression(FormattedWriter& output)
+{
+	output.PrintLine("Распаковка BC1 в четырёхцветном и трёхцветном режимах.");
+	//c0 - красный, c1 - синий, в первой строке индексы 0, 1, 2, 3
+	const byte bc1[8] = {0x00, 0xF8, 0x1F, 0x00, 0xE4, 0, 0, 0};
+	const byte bc1Expected[] = {255,0,0,255, 0,0,255,255, 170,0,85,255, 85,0,170,255};
+	byte tile[64];
+	DecompressBlocks(CSpanOf(bc1), ImageFormat::DXT1_RGB, {4, 4}, SpanOf(tile), 16);
+	INTRA_ASSERT(Equals(CSpanOf(tile).Take(16), CSpanOf(bc1Expected)));
+	for(size_t i = 16; i < 64; i++) INTRA_ASSERT_EQUALS(uint(tile[i]), i % 4 == 0 || i % 4 == 3? 255u: 0u);
+
+	const byte bc1ThreeColor[8] = {0x1F, 0x00, 0x00, 0xF8, 0xE4, 0, 0, 0};
+	const byte bc1RGBA[] = {0,0,255,255, 255,0,0,255, 128,0,128,255, 0,0,0,0};
+	DecompressBlocks(CSpanOf(bc1ThreeColor), ImageFormat::DXT1_RGBA, {4, 4}, SpanOf(tile), 16);
+	INTRA_ASSERT(Equals(CSpanOf(tile).Take(16), CSpanOf(bc1RGBA)));
+	DecompressBlocks(CSpanOf(bc1ThreeColor), ImageFormat::DXT1_RGB, {4, 4}, SpanOf(tile), 16);
+	INTRA_ASSERT_EQUALS(uint(tile[15]), 255u);
+
+	output.PrintLine("Распаковка BC4 и BC5 в восьми- и шестизначном режимах, в том числе неполного блока.");
+	//Первый блок: 200 и 100, индексы 0, 1, 2. Второй: 50 и 60, индексы 6 и 7 - явные 0 и 255
+	const byte bc5[16] = {200, 100, 0x88, 0, 0, 0, 0, 0, 50, 60, 0x3E, 0, 0, 0, 0, 0};
+	byte small[3*2*4];
+	DecompressBlocks(CSpanOf(bc5), ImageFormat::RGTC_RG, {3, 2}, SpanOf(small), 12);
+	const byte bc5Expected[] = {200,0,0,255, 100,255,0,255, 186,50,0,255, 200,50,0,255, 200,50,0,255, 200,50,0,255};
+	INTRA_ASSERT(Equals(CSpanOf(small), CSpanOf(bc5Expected)));
+	DecompressBlocks(CSpanOf(bc5), ImageFormat::LATC_LuminanceAlpha, {1, 1}, SpanOf(small), 4);
+	INTRA_ASSERT_EQUALS(uint(small[0]), 200u);
+	INTRA_ASSERT_EQUALS(uint(small[2]), 200u);
+	INTRA_ASSERT_EQUALS(uint(small[3]), 0u);
+
+	output.PrintLine("Сжатие и распаковка градиента во всех форматах с ограниченной ошибкой.");
+	static const struct {ImageFormat::I Format; uint Channels; double MaxError;} formats[] = {
+		{ImageFormat::DXT1_RGB, 3, 4.0},
+		{ImageFormat::DXT3_RGBA, 4, 5.5},
+		{ImageFormat::DXT5_RGBA, 4, 4.0},
+		{ImageFormat::RGTC_Red, 1, 1.5},
+		{ImageFormat::RGTC_RG, 2, 1.5},
+		{ImageFormat::LATC_LuminanceAlpha, 4, 1.5}
+	};
+	for(auto& f: formats)
+		for(uint quality = 0; quality < 4; quality++)
+			for(uint c = 0; c < f.Channels; c++)
+				INTRA_ASSERT(RoundTripError(f.Format, quality, c) <= f.MaxError);
+
+	output.PrintLine("Прозрачные пиксели DXT1_RGBA и одноцветные блоки.");
+	byte rgba[64];
+	for(uint i = 0; i < 16; i++)
+	{
+		rgba[i*4] = 90;
+		rgba[i*4 + 1] = 140;
+		rgba[i*4 + 2] = 33;
+		rgba[i*4 + 3] = byte(i % 3 == 0? 0: 255);
+	}
+	byte block[16];
+	CompressBlocks(CSpanOf(rgba), 16, {4, 4}, ImageFormat::DXT1_RGBA, SpanOf(block));
+	DecompressBlocks(CSpanOf(block), ImageFormat::DXT1_RGBA, {4, 4}, SpanOf(tile), 16);
+	for(uint i = 0; i < 16; i++)
+	{
+		INTRA_ASSERT_EQUALS(uint(tile[i*4 + 3]), i % 3 == 0? 0u: 255u);
+		if(i % 3 == 0) continue;
+		for(uint c = 0; c < 3; c++) INTRA_ASSERT(Math::Abs(tile[i*4 + c] - rgba[i*4 + c]) <= 4);
+	}
+	CompressBlocks(CSpanOf(rgba), 16, {4, 4}, ImageFormat::DXT5_RGBA, SpanOf(block));
+	DecompressBlocks(CSpanOf(block), ImageFormat::DXT5_RGBA, {4, 4}, SpanOf(tile), 16);
+	for(uint i = 0; i < 16; i++) INTRA_ASSERT_EQUALS(uint(tile[i*4 + 3]), uint(rgba[i*4 + 3]));
+
+	output.PrintLine("Преобразование изображения с мип-уровнями в DXT5, обратно и через файлы DDS и KTX.");
+	AnyImage image({21, 12, 1}, ImageFormat::RGBA8);
+	Array<byte> pixels = BlockTestImage(21, 12);
+	image.Data.swap(pixels);
+	INTRA_ASSERT(GenerateMipmaps(image));
+	const AnyImage dxt5 = image.ConvertFormat(ImageFormat::DXT5_RGBA);
+	INTRA_ASSERT(dxt5 != null);
+	INTRA_ASSERT_EQUALS(dxt5.Info.MipmapCount, image.Info.MipmapCount);
+	INTRA_ASSERT_EQUALS(dxt5.Data.Length(), dxt5.Info.CalculateFullDataSize(1));
+	const AnyImage unpacked = dxt5.ConvertFormat(ImageFormat::RGBA8);
+	INTRA_ASSERT(unpacked != null);
+	INTRA_ASSERT_EQUALS(unpacked.Data.Length(), image.Data.Length());
+	for(size_t i = 0; i < image.Data.Length(); i++)
+		INTRA_ASSERT(Math::Abs(unpacked.Data[i] - image.Data[i]) <= 24);
+	CheckFileRoundTrip(dxt5, false);
+	CheckFileRoundTrip(dxt5, true);
+
+	output.PrintLine("sRGB8_A8 сжимается в DXT5_sRGB_A и распаковывается обратно без преобразования гаммы.");
+	AnyImage srgb = image;
+	srgb.Info.Format = ImageFormat::sRGB8_A8;
+	const AnyImage dxt5srgb = srgb.ConvertFormat(ImageFormat::DXT5_sRGB_A);
+	INTRA_ASSERT(dxt5srgb != null);
+	INTRA_ASSERT(dxt5srgb.Data == dxt5.Data);
+	const AnyImage srgbUnpacked = dxt5srgb.ConvertFormat(ImageFormat::sRGB8_A8);
+	INTRA_ASSERT(srgbUnpacked != null);
+	INTRA_ASSERT(srgbUnpacked.Data == unpacked.Data);
+	CheckFileRoundTrip(dxt5srgb, true);
+
+	AnyImage rgb = image.ConvertFormat(ImageFormat::RGB8, 1);
+	INTRA_ASSERT(rgb != null);
+	CheckFileRoundTrip(rgb.ConvertFormat(ImageFormat::DXT1_RGB), false);
+	CheckFileRoundTrip(rgb.ConvertFormat(ImageFormat::RGB8, 4), true);
+	INTRA_ASSERT(image.ConvertFormat(ImageFormat::RGTC_SignedRed) == null);
+}
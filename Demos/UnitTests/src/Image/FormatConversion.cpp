@@ -0,0 +1,112 @@
+﻿#include "Image.h"
+#include "Image/FormatConversion.h"
+#include "Container/Sequential/Array.h"
+#include "Range/Polymorphic/ForwardRange.h"
+#include "Utils/Debug.h"
+
+using namespace Intra;
+using namespace IO;
+using namespace Image;
+
+static byte ConversionTestSample(uint x, uint y, uint c)
+{return byte(x*37 + y*101 + c*59 + x*y*13);}
+
+static void TestPackedRoundTrip(ImageFormat format, uint usedBits)
+{
+	Array<byte> packed, rgba, repacked;
+	packed.SetCountUninitialized(65536*2);
+	for(uint i = 0; i < 65536; i++)
+	{
+		packed[2*i] = byte(i);
+		packed[2*i + 1] = byte(i >> 8);
+	}
+	rgba.SetCountUninitialized(65536*4);
+	repacked.SetCountUninitialized(65536*2);
+	ConvertPixelRow(packed.Data(), format, rgba.Data(), ImageFormat::RGBA8, 65536, false);
+	ConvertPixelRow(rgba.Data(), ImageFormat::RGBA8, repacked.Data(), format, 65536, false);
+	for(uint i = 0; i < 65536; i++)
+		INTRA_ASSERT_EQUALS(uint(repacked[2*i] | (repacked[2*i + 1] << 8)), i & usedBits);
+}
+
+void TestPixelFormatConversion(FormattedWriter& output)
+{
+	enum: uint {W = 37, H = 5};
+
+	output.PrintLine("Упакованные форматы переживают распаковку в RGBA8 и обратную упаковку без потерь.");
+	TestPackedRoundTrip(ImageFormat::RGB565, 0xFFFF);
+	TestPackedRoundTrip(ImageFormat::RGB5, 0x7FFF);
+	TestPackedRoundTrip(ImageFormat::RGB5A1, 0xFFFF);
+	TestPackedRoundTrip(ImageFormat::A1_BGR5, 0xFFFF);
+	TestPackedRoundTrip(ImageFormat::RGBA4, 0xFFFF);
+
+	byte rgba[W*4], rgb[W*3], back[W*4];
+	for(uint x = 0; x < W; x++)
+		for(uint c = 0; c < 4; c++) rgba[x*4 + c] = ConversionTestSample(x, 0, c);
+
+	output.PrintLine("RGBA8 -> RGB8 с перестановкой R и B и обратно.");
+	ConvertPixelRow(rgba, ImageFormat::RGBA8, rgb, ImageFormat::RGB8, W, true);
+	for(uint x = 0; x < W; x++)
+		for(uint c = 0; c < 3; c++)
+			INTRA_ASSERT_EQUALS(uint(rgb[x*3 + c]), uint(rgba[x*4 + 2 - c]));
+	ConvertPixelRow(rgb, ImageFormat::RGB8, back, ImageFormat::RGBA8, W, true);
+	for(uint x = 0; x < W; x++)
+		for(uint c = 0; c < 4; c++)
+			INTRA_ASSERT_EQUALS(uint(back[x*4 + c]), c == 3? 255u: uint(rgba[x*4 + c]));
+
+	output.PrintLine("Яркость сохраняет белый и разворачивается во все цветовые каналы.");
+	byte lum[W];
+	const byte white[] = {255, 255, 255, 255};
+	ConvertPixelRow(white, ImageFormat::RGBA8, lum, ImageFormat::Luminance8, 1, false);
+	INTRA_ASSERT_EQUALS(uint(lum[0]), 255u);
+	ConvertPixelRow(rgba, ImageFormat::RGBA8, lum, ImageFormat::Red8, W, false);
+	ConvertPixelRow(lum, ImageFormat::Luminance8, back, ImageFormat::RGB8, W, false);
+	for(uint x = 0; x < W; x++)
+		for(uint c = 0; c < 3; c++)
+			INTRA_ASSERT_EQUALS(uint(back[x*3 + c]), uint(rgba[x*4]));
+	INTRA_ASSERT(!CanConvertPixelRows(ImageFormat::RGB16, ImageFormat::RGB8));
+
+	output.PrintLine("Перестановка R и B в sRGB8_A8 без изменения формата.");
+	byte srgba[W*4];
+	ConvertPixelRow(rgba, ImageFormat::sRGB8_A8, srgba, ImageFormat::sRGB8_A8, W, true);
+	for(uint x = 0; x < W; x++)
+		for(uint c = 0; c < 4; c++)
+			INTRA_ASSERT_EQUALS(uint(srgba[x*4 + c]), uint(rgba[x*4 + (c == 3? 3: 2 - c)]));
+
+	output.PrintLine("ReadPixelDataBlock: RGB5A1 -> RGB8 с переворотом и выравниванием строк за один проход.");
+	enum: uint {SrcLine = (W*2 + 3) & ~3u, DstLine = (W*3 + 3) & ~3u};
+	byte file[SrcLine*H];
+	for(uint y = 0; y < H; y++)
+		for(uint x = 0; x < SrcLine/2; x++)
+		{
+			const uint color = x < W? uint(ConversionTestSample(x, y, 0) | (ConversionTestSample(x, y, 1) << 8)): 0xAAAAu;
+			file[y*SrcLine + 2*x] = byte(color);
+			file[y*SrcLine + 2*x + 1] = byte(color >> 8);
+		}
+	Array<byte> image;
+	image.SetCount(DstLine*H);
+	for(byte& b: image) b = 0xCD;
+	ForwardStream stream = CSpanOfRaw<char>(file, sizeof(file));
+	ReadPixelDataBlock(stream, {W, H}, ImageFormat::RGB5A1, ImageFormat::RGB8, true, true, 4, 4, image);
+	for(uint y = 0; y < H; y++)
+	{
+		const byte* line = image.Data() + (H - 1 - y)*DstLine;
+		for(uint x = 0; x < W; x++)
+		{
+			const uint color = uint(file[y*SrcLine + 2*x] | (file[y*SrcLine + 2*x + 1] << 8));
+			const uint expected[] = {color & 31, (color >> 5) & 31, (color >> 10) & 31};
+			for(uint c = 0; c < 3; c++)
+				INTRA_ASSERT_EQUALS(uint(line[x*3 + c]), (expected[c] << 3)|(expected[c] >> 2));
+		}
+		for(uint i = W*3; i < DstLine; i++) INTRA_ASSERT_EQUALS(uint(line[i]), 0u);
+	}
+
+	output.PrintLine("SwapRedBlueChannels не трогает выравнивание строк.");
+	Array<byte> swapped = image;
+	SwapRedBlueChannels(ImageFormat::RGB8, 4, {W, H}, swapped);
+	for(uint y = 0; y < H; y++)
+		for(uint x = 0; x < DstLine; x++)
+		{
+			const uint c = x < W*3? x % 3: 1;
+			INTRA_ASSERT_EQUALS(uint(swapped[y*DstLine + x]), uint(image[y*DstLine + x - c + 2 - c]));
+		}
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+#include "IO/FormattedWriter.h"
+
+void TestPngLoader(Intra::FormattedWriter& output);
+void TestJpegLoader(Intra::FormattedWriter& output);
+void TestPixelFormatConversion(Intra::FormattedWriter& output);
+void TestResample(Intra::FormattedWriter& output);
+void TestBlockCompression(Intra::FormattedWriter& output);
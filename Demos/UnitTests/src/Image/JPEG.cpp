@@ -0,0 +1,332 @@
+﻿#include "Image.h"
+#include "Image/Loaders/LoaderJPEG.h"
+#include "Image/AnyImage.h"
+#include "Container/Sequential/Array.h"
+#include "Range/Polymorphic/ForwardRange.h"
+#include "Math/Math.h"
+#include "Utils/Debug.h"
+
+using namespace Intra;
+using namespace IO;
+using namespace Image;
+
+// Файлы созданы libjpeg с качеством 95 из изображения 35x27, компоненты которого заданы JpegTestSample.
+// Baseline 4:2:0 с интервалом перезапуска 3 MCU, progressive 4:2:0, baseline 4:2:2 и progressive в оттенках серого.
+static const byte jpegBaseline420[] = {
+	0xFF, 0xD8, 0xFF, 0xE0, 0x00, 0x10, 0x4A, 0x46, 0x49, 0x46, 0x00, 0x01, 0x01, 0x00, 0x00, 0x01,
+	0x00, 0x01, 0x00, 0x00, 0xFF, 0xDB, 0x00, 0x43, 0x00, 0x02, 0x01, 0x01, 0x01, 0x01, 0x01, 0x02,
+	0x01, 0x01, 0x01, 0x02, 0x02, 0x02, 0x02, 0x02, 0x04, 0x03, 0x02, 0x02, 0x02, 0x02, 0x05, 0x04,
+	0x04, 0x03, 0x04, 0x06, 0x05, 0x06, 0x06, 0x06, 0x05, 0x06, 0x06, 0x06, 0x07, 0x09, 0x08, 0x06,
+	0x07, 0x09, 0x07, 0x06, 0x06, 0x08, 0x0B, 0x08, 0x09, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x06, 0x08,
+	0x0B, 0x0C, 0x0B, 0x0A, 0x0C, 0x09, 0x0A, 0x0A, 0x0A, 0xFF, 0xDB, 0x00, 0x43, 0x01, 0x02, 0x02,
+	0x02, 0x02, 0x02, 0x02, 0x05, 0x03, 0x03, 0x05, 0x0A, 0x07, 0x06, 0x07, 0x0A, 0x0A, 0x0A, 0x0A,
+	0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A,
+	0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A,
+	0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0xFF, 0xC0,
+	0x00, 0x11, 0x08, 0x00, 0x1B, 0x00, 0x23, 0x03, 0x01, 0x22, 0x00, 0x02, 0x11, 0x01, 0x03, 0x11,
+	0x01, 0xFF, 0xC4, 0x00, 0x1F, 0x00, 0x00, 0x01, 0x05, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09,
+	0x0A, 0x0B, 0xFF, 0xC4, 0x00, 0xB5, 0x10, 0x00, 0x02, 0x01, 0x03, 0x03, 0x02, 0x04, 0x03, 0x05,
+	0x05, 0x04, 0x04, 0x00, 0x00, 0x01, 0x7D, 0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21,
+	0x31, 0x41, 0x06, 0x13, 0x51, 0x61, 0x07, 0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xA1, 0x08, 0x23,
+	0x42, 0xB1, 0xC1, 0x15, 0x52, 0xD1, 0xF0, 0x24, 0x33, 0x62, 0x72, 0x82, 0x09, 0x0A, 0x16, 0x17,
+	0x18, 0x19, 0x1A, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2A, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A,
+	0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4A, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5A,
+	0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6A, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7A,
+	0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89, 0x8A, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99,
+	0x9A, 0xA2, 0xA3, 0xA4, 0xA5, 0xA6, 0xA7, 0xA8, 0xA9, 0xAA, 0xB2, 0xB3, 0xB4, 0xB5, 0xB6, 0xB7,
+	0xB8, 0xB9, 0xBA, 0xC2, 0xC3, 0xC4, 0xC5, 0xC6, 0xC7, 0xC8, 0xC9, 0xCA, 0xD2, 0xD3, 0xD4, 0xD5,
+	0xD6, 0xD7, 0xD8, 0xD9, 0xDA, 0xE1, 0xE2, 0xE3, 0xE4, 0xE5, 0xE6, 0xE7, 0xE8, 0xE9, 0xEA, 0xF1,
+	0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7, 0xF8, 0xF9, 0xFA, 0xFF, 0xC4, 0x00, 0x1F, 0x01, 0x00, 0x03,
+	0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01,
+	0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0xFF, 0xC4, 0x00, 0xB5, 0x11, 0x00,
+	0x02, 0x01, 0x02, 0x04, 0x04, 0x03, 0x04, 0x07, 0x05, 0x04, 0x04, 0x00, 0x01, 0x02, 0x77, 0x00,
+	0x01, 0x02, 0x03, 0x11, 0x04, 0x05, 0x21, 0x31, 0x06, 0x12, 0x41, 0x51, 0x07, 0x61, 0x71, 0x13,
+	0x22, 0x32, 0x81, 0x08, 0x14, 0x42, 0x91, 0xA1, 0xB1, 0xC1, 0x09, 0x23, 0x33, 0x52, 0xF0, 0x15,
+	0x62, 0x72, 0xD1, 0x0A, 0x16, 0x24, 0x34, 0xE1, 0x25, 0xF1, 0x17, 0x18, 0x19, 0x1A, 0x26, 0x27,
+	0x28, 0x29, 0x2A, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49,
+	0x4A, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5A, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69,
+	0x6A, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7A, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88,
+	0x89, 0x8A, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9A, 0xA2, 0xA3, 0xA4, 0xA5, 0xA6,
+	0xA7, 0xA8, 0xA9, 0xAA, 0xB2, 0xB3, 0xB4, 0xB5, 0xB6, 0xB7, 0xB8, 0xB9, 0xBA, 0xC2, 0xC3, 0xC4,
+	0xC5, 0xC6, 0xC7, 0xC8, 0xC9, 0xCA, 0xD2, 0xD3, 0xD4, 0xD5, 0xD6, 0xD7, 0xD8, 0xD9, 0xDA, 0xE2,
+	0xE3, 0xE4, 0xE5, 0xE6, 0xE7, 0xE8, 0xE9, 0xEA, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7, 0xF8, 0xF9,
+	0xFA, 0xFF, 0xDD, 0x00, 0x04, 0x00, 0x03, 0xFF, 0xDA, 0x00, 0x0C, 0x03, 0x01, 0x00, 0x02, 0x11,
+	0x03, 0x11, 0x00, 0x3F, 0x00, 0xFC, 0x93, 0xF0, 0x97, 0xC0, 0xFF, 0x00, 0xBB, 0xFE, 0x8B, 0xFF,
+	0x00, 0x8E, 0xD7, 0xA7, 0xF8, 0x4B, 0xE0, 0x87, 0xDD, 0xFF, 0x00, 0x44, 0xFF, 0x00, 0xC7, 0x6B,
+	0xDD, 0x3C, 0x25, 0xF0, 0x3C, 0xFC, 0xBF, 0xE8, 0x5F, 0xF8, 0xED, 0x7A, 0x7F, 0x84, 0xBE, 0x08,
+	0x1F, 0x97, 0xFD, 0x0F, 0xFF, 0x00, 0x1D, 0xAF, 0xD1, 0x2A, 0xF1, 0x07, 0x99, 0xF2, 0x7E, 0x1E,
+	0xF8, 0x9F, 0xF0, 0x7B, 0xFF, 0x00, 0x89, 0xE1, 0x7E, 0x12, 0xF8, 0x23, 0xF7, 0x7F, 0xD1, 0x3F,
+	0x4A, 0xF4, 0xFF, 0x00, 0x09, 0x7C, 0x10, 0xFB, 0xBF, 0xE8, 0x87, 0xF2, 0xAF, 0x74, 0xF0, 0x97,
+	0xC1, 0x0F, 0xBB, 0xFE, 0x87, 0xFF, 0x00, 0x8E, 0xD7, 0xA7, 0xF8, 0x4B, 0xE0, 0x79, 0xF9, 0x7F,
+	0xD0, 0xC7, 0xFD, 0xF3, 0x5E, 0x75, 0x5E, 0x20, 0xF3, 0x3F, 0xB9, 0xBC, 0x3D, 0xF1, 0x3F, 0xE0,
+	0xF7, 0xFF, 0x00, 0x13, 0xE7, 0x9B, 0x5F, 0x81, 0xE3, 0xEC, 0xE9, 0xFE, 0x88, 0x7A, 0x7F, 0x72,
+	0x8A, 0xFB, 0x0E, 0xD7, 0xE0, 0x81, 0xFB, 0x3A, 0x7F, 0xA1, 0x76, 0xFE, 0xED, 0x15, 0xC9, 0xFE,
+	0xB0, 0x79, 0x9F, 0xD2, 0x94, 0xFC, 0x4F, 0xFD, 0xDA, 0xF7, 0xFA, 0x77, 0x3F, 0xFF, 0xD0, 0xDA,
+	0xF0, 0x97, 0xC1, 0x01, 0xF2, 0xFF, 0x00, 0xA1, 0xFF, 0x00, 0xE3, 0xB5, 0xE9, 0xFE, 0x12, 0xF8,
+	0x1E, 0x3E, 0x5F, 0xF4, 0x3F, 0xFC, 0x76, 0xBD, 0x23, 0xC2, 0x5A, 0x36, 0x97, 0xF2, 0xFF, 0x00,
+	0xA1, 0x27, 0xE5, 0x5E, 0x9F, 0xE1, 0x3D, 0x1B, 0x4B, 0xF9, 0x7F, 0xD0, 0x93, 0xB7, 0x6A, 0xF9,
+	0xAA, 0xB9, 0xC5, 0x63, 0xFC, 0xCD, 0xF0, 0xF7, 0x8E, 0xF1, 0xFE, 0xE6, 0xE7, 0x9B, 0xF8, 0x4B,
+	0xE0, 0x78, 0xF9, 0x7F, 0xD0, 0xCF, 0xFD, 0xF3, 0x5E, 0x9F, 0xE1, 0x2F, 0x82, 0x1F, 0x77, 0xFD,
+	0x0F, 0xFF, 0x00, 0x1D, 0xAF, 0x48, 0xF0, 0x8E, 0x8D, 0xA5, 0xFC, 0x9F, 0xE8, 0x49, 0xF9, 0x57,
+	0xA7, 0x78, 0x4B, 0x47, 0xD3, 0x3E, 0x5F, 0xF4, 0x24, 0xFC, 0xAB, 0xCE, 0xAB, 0x9C, 0x56, 0x3F,
+	0xB9, 0xBC, 0x3E, 0xE3, 0xBC, 0x7F, 0xB9, 0xB9, 0xE4, 0xD6, 0xBF, 0x04, 0x07, 0xD9, 0xD3, 0xFD,
+	0x0B, 0xB7, 0xF7, 0x68, 0xAF, 0xA5, 0xED, 0x74, 0x6D, 0x2F, 0xEC, 0xEB, 0xFE, 0x84, 0x9D, 0x3D,
+	0x28, 0xAE, 0x37, 0x9C, 0xD6, 0xB9, 0xFD, 0x2B, 0x4F, 0x8E, 0xF1, 0xFE, 0xCD, 0x6F, 0xB1, 0xFF,
+	0xD9,
+};
+
+static const byte jpegProgressive420[] = {
+	0xFF, 0xD8, 0xFF, 0xE0, 0x00, 0x10, 0x4A, 0x46, 0x49, 0x46, 0x00, 0x01, 0x01, 0x00, 0x00, 0x01,
+	0x00, 0x01, 0x00, 0x00, 0xFF, 0xDB, 0x00, 0x43, 0x00, 0x02, 0x01, 0x01, 0x01, 0x01, 0x01, 0x02,
+	0x01, 0x01, 0x01, 0x02, 0x02, 0x02, 0x02, 0x02, 0x04, 0x03, 0x02, 0x02, 0x02, 0x02, 0x05, 0x04,
+	0x04, 0x03, 0x04, 0x06, 0x05, 0x06, 0x06, 0x06, 0x05, 0x06, 0x06, 0x06, 0x07, 0x09, 0x08, 0x06,
+	0x07, 0x09, 0x07, 0x06, 0x06, 0x08, 0x0B, 0x08, 0x09, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x06, 0x08,
+	0x0B, 0x0C, 0x0B, 0x0A, 0x0C, 0x09, 0x0A, 0x0A, 0x0A, 0xFF, 0xDB, 0x00, 0x43, 0x01, 0x02, 0x02,
+	0x02, 0x02, 0x02, 0x02, 0x05, 0x03, 0x03, 0x05, 0x0A, 0x07, 0x06, 0x07, 0x0A, 0x0A, 0x0A, 0x0A,
+	0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A,
+	0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A,
+	0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0xFF, 0xC2,
+	0x00, 0x11, 0x08, 0x00, 0x1B, 0x00, 0x23, 0x03, 0x01, 0x22, 0x00, 0x02, 0x11, 0x01, 0x03, 0x11,
+	0x01, 0xFF, 0xC4, 0x00, 0x17, 0x00, 0x01, 0x01, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x06, 0x00, 0x07, 0x08, 0xFF, 0xC4, 0x00, 0x19, 0x01, 0x00,
+	0x02, 0x03, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03,
+	0x07, 0x04, 0x05, 0x06, 0x09, 0xFF, 0xDA, 0x00, 0x0C, 0x03, 0x01, 0x00, 0x02, 0x10, 0x03, 0x10,
+	0x00, 0x00, 0x01, 0xE4, 0x94, 0xEE, 0x94, 0x68, 0xAA, 0x42, 0xA7, 0x74, 0xA2, 0x33, 0xCF, 0x3C,
+	0xB6, 0x18, 0x4C, 0xA1, 0x89, 0xD2, 0x28, 0xCC, 0x72, 0xFC, 0xDA, 0x74, 0x89, 0xE3, 0xBC, 0xC9,
+	0xDA, 0x5C, 0x16, 0x57, 0xFF, 0xC4, 0x00, 0x1A, 0x10, 0x00, 0x03, 0x01, 0x01, 0x01, 0x01, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x04, 0x05, 0x03, 0x02, 0x22, 0x12,
+	0xFF, 0xDA, 0x00, 0x08, 0x01, 0x01, 0x00, 0x01, 0x05, 0x02, 0x52, 0x18, 0xA4, 0x41, 0x48, 0x82,
+	0x91, 0x0E, 0x61, 0xF9, 0x52, 0x18, 0xA4, 0x41, 0x48, 0x82, 0x90, 0xCE, 0x62, 0x79, 0x52, 0x20,
+	0xA4, 0x31, 0x48, 0x62, 0x91, 0x0E, 0x62, 0x79, 0x53, 0x1C, 0x85, 0x31, 0xC8, 0x53, 0x1C, 0x85,
+	0x31, 0xCC, 0xE7, 0x1C, 0xBE, 0x7F, 0xFF, 0xC4, 0x00, 0x1C, 0x11, 0x00, 0x02, 0x02, 0x03, 0x01,
+	0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x06, 0x03, 0x21, 0x02,
+	0x05, 0x31, 0x12, 0x22, 0xFF, 0xDA, 0x00, 0x08, 0x01, 0x03, 0x01, 0x01, 0x3F, 0x01, 0x5E, 0x67,
+	0xE5, 0x8B, 0xCC, 0xFC, 0xB3, 0x16, 0x7F, 0x9E, 0x8B, 0xDB, 0xD9, 0xE8, 0x5F, 0xDE, 0xCF, 0x46,
+	0x3B, 0xD9, 0xFC, 0x9F, 0xFF, 0xC4, 0x00, 0x19, 0x11, 0x01, 0x01, 0x00, 0x03, 0x01, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x00, 0x04, 0x05, 0x14, 0x15, 0xFF,
+	0xDA, 0x00, 0x08, 0x01, 0x02, 0x01, 0x01, 0x3F, 0x01, 0x5B, 0x09, 0x6C, 0x2F, 0x42, 0x59, 0x8E,
+	0x59, 0x8E, 0xEC, 0x77, 0xFF, 0xC4, 0x00, 0x15, 0x10, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x32, 0xFF, 0xDA, 0x00, 0x08, 0x01,
+	0x01, 0x00, 0x06, 0x3F, 0x02, 0x94, 0xA5, 0x29, 0x42, 0x10, 0x84, 0x21, 0x08, 0x42, 0x10, 0x84,
+	0x21, 0x0F, 0xFF, 0xC4, 0x00, 0x18, 0x10, 0x00, 0x03, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x21, 0xC1, 0x31, 0x11, 0xFF, 0xDA, 0x00, 0x08,
+	0x01, 0x01, 0x00, 0x01, 0x3F, 0x21, 0xC2, 0x4C, 0x64, 0xC4, 0xE2, 0x54, 0x93, 0x08, 0x31, 0x83,
+	0x18, 0x30, 0x81, 0x68, 0x31, 0x83, 0x08, 0x30, 0x83, 0x18, 0x16, 0x81, 0x04, 0x10, 0x41, 0x44,
+	0x11, 0x43, 0x90, 0x87, 0xFF, 0xDA, 0x00, 0x0C, 0x03, 0x01, 0x00, 0x02, 0x00, 0x03, 0x00, 0x00,
+	0x00, 0x10, 0x61, 0xA3, 0x1A, 0x70, 0xDF, 0xFF, 0xC4, 0x00, 0x1A, 0x11, 0x00, 0x02, 0x02, 0x03,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x51, 0x31, 0xF1,
+	0x11, 0x21, 0x61, 0xFF, 0xDA, 0x00, 0x08, 0x01, 0x03, 0x01, 0x01, 0x3F, 0x10, 0xB7, 0x2D, 0xCD,
+	0x2E, 0x58, 0xDC, 0x7E, 0x61, 0xA6, 0x0F, 0xFF, 0xC4, 0x00, 0x19, 0x11, 0x00, 0x02, 0x03, 0x01,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x61, 0x01, 0x10,
+	0x11, 0x71, 0xFF, 0xDA, 0x00, 0x08, 0x01, 0x02, 0x01, 0x01, 0x3F, 0x10, 0x70, 0xE3, 0xAB, 0x92,
+	0x76, 0x3F, 0xFF, 0xC4, 0x00, 0x1F, 0x10, 0x00, 0x02, 0x00, 0x06, 0x03, 0x01, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x10, 0x31, 0x41, 0x51, 0x71, 0xD1, 0x61,
+	0x81, 0x91, 0xF1, 0xFF, 0xDA, 0x00, 0x08, 0x01, 0x01, 0x00, 0x01, 0x3F, 0x10, 0x84, 0x35, 0xF2,
+	0x4B, 0xEF, 0x82, 0x26, 0xE4, 0x5C, 0x27, 0xC0, 0x61, 0xD4, 0x03, 0x70, 0xC2, 0xC0, 0xA0, 0x2A,
+	0xA4, 0x18, 0x4E, 0x18, 0xD6, 0x67, 0x49, 0xD0, 0xD2, 0xE6, 0xAB, 0x38, 0x47, 0x63, 0xFF, 0xD9,
+};
+
+static const byte jpegBaseline422[] = {
+	0xFF, 0xD8, 0xFF, 0xE0, 0x00, 0x10, 0x4A, 0x46, 0x49, 0x46, 0x00, 0x01, 0x01, 0x00, 0x00, 0x01,
+	0x00, 0x01, 0x00, 0x00, 0xFF, 0xDB, 0x00, 0x43, 0x00, 0x02, 0x01, 0x01, 0x01, 0x01, 0x01, 0x02,
+	0x01, 0x01, 0x01, 0x02, 0x02, 0x02, 0x02, 0x02, 0x04, 0x03, 0x02, 0x02, 0x02, 0x02, 0x05, 0x04,
+	0x04, 0x03, 0x04, 0x06, 0x05, 0x06, 0x06, 0x06, 0x05, 0x06, 0x06, 0x06, 0x07, 0x09, 0x08, 0x06,
+	0x07, 0x09, 0x07, 0x06, 0x06, 0x08, 0x0B, 0x08, 0x09, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x06, 0x08,
+	0x0B, 0x0C, 0x0B, 0x0A, 0x0C, 0x09, 0x0A, 0x0A, 0x0A, 0xFF, 0xDB, 0x00, 0x43, 0x01, 0x02, 0x02,
+	0x02, 0x02, 0x02, 0x02, 0x05, 0x03, 0x03, 0x05, 0x0A, 0x07, 0x06, 0x07, 0x0A, 0x0A, 0x0A, 0x0A,
+	0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A,
+	0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A,
+	0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0xFF, 0xC0,
+	0x00, 0x11, 0x08, 0x00, 0x1B, 0x00, 0x23, 0x03, 0x01, 0x21, 0x00, 0x02, 0x11, 0x01, 0x03, 0x11,
+	0x01, 0xFF, 0xC4, 0x00, 0x1F, 0x00, 0x00, 0x01, 0x05, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09,
+	0x0A, 0x0B, 0xFF, 0xC4, 0x00, 0xB5, 0x10, 0x00, 0x02, 0x01, 0x03, 0x03, 0x02, 0x04, 0x03, 0x05,
+	0x05, 0x04, 0x04, 0x00, 0x00, 0x01, 0x7D, 0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21,
+	0x31, 0x41, 0x06, 0x13, 0x51, 0x61, 0x07, 0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xA1, 0x08, 0x23,
+	0x42, 0xB1, 0xC1, 0x15, 0x52, 0xD1, 0xF0, 0x24, 0x33, 0x62, 0x72, 0x82, 0x09, 0x0A, 0x16, 0x17,
+	0x18, 0x19, 0x1A, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2A, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A,
+	0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4A, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5A,
+	0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6A, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7A,
+	0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89, 0x8A, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99,
+	0x9A, 0xA2, 0xA3, 0xA4, 0xA5, 0xA6, 0xA7, 0xA8, 0xA9, 0xAA, 0xB2, 0xB3, 0xB4, 0xB5, 0xB6, 0xB7,
+	0xB8, 0xB9, 0xBA, 0xC2, 0xC3, 0xC4, 0xC5, 0xC6, 0xC7, 0xC8, 0xC9, 0xCA, 0xD2, 0xD3, 0xD4, 0xD5,
+	0xD6, 0xD7, 0xD8, 0xD9, 0xDA, 0xE1, 0xE2, 0xE3, 0xE4, 0xE5, 0xE6, 0xE7, 0xE8, 0xE9, 0xEA, 0xF1,
+	0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7, 0xF8, 0xF9, 0xFA, 0xFF, 0xC4, 0x00, 0x1F, 0x01, 0x00, 0x03,
+	0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01,
+	0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0xFF, 0xC4, 0x00, 0xB5, 0x11, 0x00,
+	0x02, 0x01, 0x02, 0x04, 0x04, 0x03, 0x04, 0x07, 0x05, 0x04, 0x04, 0x00, 0x01, 0x02, 0x77, 0x00,
+	0x01, 0x02, 0x03, 0x11, 0x04, 0x05, 0x21, 0x31, 0x06, 0x12, 0x41, 0x51, 0x07, 0x61, 0x71, 0x13,
+	0x22, 0x32, 0x81, 0x08, 0x14, 0x42, 0x91, 0xA1, 0xB1, 0xC1, 0x09, 0x23, 0x33, 0x52, 0xF0, 0x15,
+	0x62, 0x72, 0xD1, 0x0A, 0x16, 0x24, 0x34, 0xE1, 0x25, 0xF1, 0x17, 0x18, 0x19, 0x1A, 0x26, 0x27,
+	0x28, 0x29, 0x2A, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49,
+	0x4A, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5A, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69,
+	0x6A, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7A, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88,
+	0x89, 0x8A, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9A, 0xA2, 0xA3, 0xA4, 0xA5, 0xA6,
+	0xA7, 0xA8, 0xA9, 0xAA, 0xB2, 0xB3, 0xB4, 0xB5, 0xB6, 0xB7, 0xB8, 0xB9, 0xBA, 0xC2, 0xC3, 0xC4,
+	0xC5, 0xC6, 0xC7, 0xC8, 0xC9, 0xCA, 0xD2, 0xD3, 0xD4, 0xD5, 0xD6, 0xD7, 0xD8, 0xD9, 0xDA, 0xE2,
+	0xE3, 0xE4, 0xE5, 0xE6, 0xE7, 0xE8, 0xE9, 0xEA, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7, 0xF8, 0xF9,
+	0xFA, 0xFF, 0xDA, 0x00, 0x0C, 0x03, 0x01, 0x00, 0x02, 0x11, 0x03, 0x11, 0x00, 0x3F, 0x00, 0xFC,
+	0x93, 0xF0, 0x97, 0xC0, 0xFF, 0x00, 0xBB, 0xFE, 0x8B, 0xFF, 0x00, 0x8E, 0xD7, 0xA7, 0xF8, 0x4B,
+	0xE0, 0x87, 0xDD, 0xFF, 0x00, 0x44, 0xFF, 0x00, 0xC7, 0x6B, 0xF6, 0x0A, 0xB9, 0x87, 0x99, 0xED,
+	0x78, 0x7B, 0xC5, 0x1F, 0x06, 0xBD, 0x8F, 0x4F, 0xF0, 0x97, 0xC1, 0x1F, 0xBB, 0xFE, 0x89, 0xFA,
+	0x57, 0xA7, 0xF8, 0x4B, 0xE0, 0x87, 0xDD, 0xFF, 0x00, 0x44, 0x3F, 0x95, 0x79, 0xD5, 0x73, 0x0F,
+	0x33, 0xFB, 0x9B, 0xC3, 0xDE, 0x28, 0xF8, 0x3D, 0xE3, 0xBD, 0xB5, 0xF8, 0x1E, 0x3E, 0xCE, 0x9F,
+	0xE8, 0x87, 0xA7, 0xF7, 0x28, 0xAE, 0x4F, 0xED, 0x03, 0xFA, 0x52, 0x9F, 0x14, 0x3F, 0x66, 0xB5,
+	0xE8, 0x78, 0xC7, 0x84, 0xBE, 0x07, 0x9F, 0x97, 0xFD, 0x0B, 0xFF, 0x00, 0x1D, 0xAF, 0x4F, 0xF0,
+	0x97, 0xC1, 0x03, 0xF2, 0xFF, 0x00, 0xA1, 0xFF, 0x00, 0xE3, 0xB5, 0xE1, 0xD5, 0xCC, 0x3C, 0xCF,
+	0xF9, 0xFA, 0xF0, 0xF7, 0x8A, 0x3E, 0x0F, 0x78, 0xF4, 0xFF, 0x00, 0x09, 0x7C, 0x10, 0xFB, 0xBF,
+	0xE8, 0x7F, 0xF8, 0xED, 0x7A, 0x7F, 0x84, 0xBE, 0x07, 0x9F, 0x97, 0xFD, 0x0C, 0x7F, 0xDF, 0x35,
+	0xE7, 0xD5, 0xCC, 0x3C, 0xCF, 0xEE, 0x6F, 0x0F, 0x78, 0xA3, 0xE0, 0xF7, 0x8E, 0xF6, 0xD7, 0xE0,
+	0x81, 0xFB, 0x3A, 0x7F, 0xA1, 0x76, 0xFE, 0xED, 0x15, 0xC7, 0xFD, 0xA0, 0x7F, 0x4A, 0x53, 0xE2,
+	0x7F, 0xDD, 0xAF, 0x7B, 0xA1, 0xE3, 0x1E, 0x12, 0xF8, 0x20, 0x3E, 0x5F, 0xF4, 0x3F, 0xFC, 0x76,
+	0xBD, 0x3F, 0xC2, 0x5F, 0x03, 0xC7, 0xCB, 0xFE, 0x87, 0xFF, 0x00, 0x8E, 0xD7, 0x87, 0x57, 0x30,
+	0xF3, 0x3F, 0xE7, 0xEB, 0xC3, 0xDE, 0x28, 0xF8, 0x3D, 0xE3, 0xD3, 0xFC, 0x25, 0xF0, 0x3C, 0x7C,
+	0xBF, 0xE8, 0x67, 0xFE, 0xF9, 0xAF, 0x4F, 0xF0, 0x97, 0xC1, 0x0F, 0xBB, 0xFE, 0x87, 0xFF, 0x00,
+	0x8E, 0xD7, 0x9F, 0x57, 0x30, 0xF3, 0x3F, 0xB9, 0x7C, 0x3D, 0xE2, 0x8F, 0x83, 0xDE, 0x3B, 0xDB,
+	0x5F, 0x82, 0x03, 0xEC, 0xE9, 0xFE, 0x85, 0xDB, 0xFB, 0xB4, 0x57, 0x27, 0xD7, 0xFC, 0xCF, 0xE9,
+	0x5A, 0x7C, 0x51, 0xFB, 0xB5, 0xEF, 0x74, 0x3E, 0x6C, 0xF0, 0x96, 0x8D, 0xA5, 0xFC, 0xBF, 0xE8,
+	0x49, 0xF9, 0x57, 0xA7, 0xF8, 0x4F, 0x46, 0xD2, 0xFE, 0x5F, 0xF4, 0x24, 0xED, 0xDA, 0xBC, 0xFA,
+	0xB5, 0x27, 0xDC, 0xFF, 0x00, 0x06, 0xBC, 0x3D, 0xC4, 0xD7, 0xF7, 0x3D, 0xEE, 0xC7, 0xA7, 0xF8,
+	0x47, 0x46, 0xD2, 0xFE, 0x4F, 0xF4, 0x24, 0xFC, 0xAB, 0xD3, 0xBC, 0x25, 0xA3, 0xE9, 0x9F, 0x2F,
+	0xFA, 0x12, 0x7E, 0x55, 0xE7, 0xD5, 0x9C, 0xFB, 0x9F, 0xDC, 0xBE, 0x1F, 0x62, 0x6B, 0xDA, 0x1E,
+	0xF7, 0x63, 0xBE, 0xB5, 0xD1, 0xB4, 0xBF, 0xB3, 0xAF, 0xFA, 0x12, 0x74, 0xF4, 0xA2, 0xB8, 0x5D,
+	0x49, 0xDF, 0x73, 0xFA, 0x5A, 0x9E, 0x26, 0xBF, 0xB3, 0x5E, 0xF3, 0xD8, 0xFF, 0xD9,
+};
+
+static const byte jpegProgressiveGray[] = {
+	0xFF, 0xD8, 0xFF, 0xE0, 0x00, 0x10, 0x4A, 0x46, 0x49, 0x46, 0x00, 0x01, 0x01, 0x00, 0x00, 0x01,
+	0x00, 0x01, 0x00, 0x00, 0xFF, 0xDB, 0x00, 0x43, 0x00, 0x02, 0x01, 0x01, 0x01, 0x01, 0x01, 0x02,
+	0x01, 0x01, 0x01, 0x02, 0x02, 0x02, 0x02, 0x02, 0x04, 0x03, 0x02, 0x02, 0x02, 0x02, 0x05, 0x04,
+	0x04, 0x03, 0x04, 0x06, 0x05, 0x06, 0x06, 0x06, 0x05, 0x06, 0x06, 0x06, 0x07, 0x09, 0x08, 0x06,
+	0x07, 0x09, 0x07, 0x06, 0x06, 0x08, 0x0B, 0x08, 0x09, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x06, 0x08,
+	0x0B, 0x0C, 0x0B, 0x0A, 0x0C, 0x09, 0x0A, 0x0A, 0x0A, 0xFF, 0xC2, 0x00, 0x0B, 0x08, 0x00, 0x1B,
+	0x00, 0x23, 0x01, 0x01, 0x11, 0x00, 0xFF, 0xC4, 0x00, 0x15, 0x00, 0x01, 0x01, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x06, 0x08, 0xFF, 0xDA, 0x00,
+	0x08, 0x01, 0x01, 0x00, 0x00, 0x00, 0x01, 0x8E, 0x9E, 0x3C, 0x78, 0xBA, 0x6C, 0x78, 0xF1, 0xE2,
+	0xE9, 0xAD, 0xE3, 0xC7, 0x8B, 0xA5, 0xA7, 0x8F, 0x1E, 0x2E, 0xFF, 0xC4, 0x00, 0x19, 0x10, 0x01,
+	0x01, 0x01, 0x01, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x05,
+	0x00, 0x03, 0x02, 0x22, 0x12, 0xFF, 0xDA, 0x00, 0x08, 0x01, 0x01, 0x00, 0x01, 0x05, 0x02, 0x38,
+	0x98, 0xE2, 0x63, 0x89, 0x8E, 0x26, 0xE0, 0x9F, 0x07, 0x13, 0x1C, 0x4C, 0x71, 0x31, 0xC4, 0xDC,
+	0x13, 0xE0, 0xE2, 0x63, 0x89, 0x8E, 0x26, 0x38, 0x9B, 0x82, 0x7C, 0x1D, 0x96, 0x71, 0xD9, 0x67,
+	0x1D, 0x96, 0x71, 0xD9, 0x67, 0x67, 0x96, 0x7F, 0x1F, 0xFF, 0xC4, 0x00, 0x16, 0x10, 0x00, 0x03,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01,
+	0x22, 0xFF, 0xDA, 0x00, 0x08, 0x01, 0x01, 0x00, 0x06, 0x3F, 0x02, 0x52, 0x29, 0x14, 0x8A, 0x45,
+	0x22, 0x91, 0x48, 0xA4, 0x52, 0x29, 0x14, 0x8A, 0x45, 0x22, 0x91, 0x48, 0xA4, 0x52, 0x29, 0x14,
+	0x8A, 0x4F, 0xFF, 0xC4, 0x00, 0x1C, 0x10, 0x01, 0x00, 0x02, 0x02, 0x03, 0x01, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x41, 0xF1, 0x31, 0x81, 0x01, 0x20, 0x51, 0x71,
+	0xFF, 0xDA, 0x00, 0x08, 0x01, 0x01, 0x00, 0x01, 0x3F, 0x21, 0xE8, 0x00, 0x01, 0xC5, 0xF0, 0x78,
+	0xA1, 0x50, 0xA8, 0x54, 0x2D, 0x65, 0x42, 0xA1, 0x50, 0xA8, 0x5A, 0xCA, 0x02, 0x80, 0xA0, 0x28,
+	0x0B, 0x00, 0xE1, 0xFF, 0xDA, 0x00, 0x08, 0x01, 0x01, 0x00, 0x00, 0x00, 0x10, 0xF8, 0x00, 0x1F,
+	0xFF, 0xC4, 0x00, 0x1B, 0x10, 0x00, 0x03, 0x00, 0x03, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0xA1, 0x11, 0x71, 0xF1, 0x10, 0x21, 0xFF, 0xDA, 0x00,
+	0x08, 0x01, 0x01, 0x00, 0x01, 0x3F, 0x10, 0xE2, 0x9C, 0x53, 0x8A, 0x71, 0x4F, 0xB8, 0x23, 0x68,
+	0x1B, 0x40, 0xDA, 0x06, 0xD0, 0x67, 0x64, 0x04, 0xD0, 0x26, 0x81, 0x34, 0x09, 0xA0, 0xCE, 0xC8,
+	0x1A, 0x04, 0xD0, 0x26, 0x81, 0x34, 0x0F, 0x82, 0x5F, 0xFF, 0xD9,
+};
+
+enum: uint {JpegTestWidth = 35, JpegTestHeight = 27};
+
+static int JpegTestSample(uint x, uint y, uint channel, uint channels)
+{
+	const uint r = x*255/(JpegTestWidth - 1), g = y*255/(JpegTestHeight - 1);
+	if(channels == 1) return int((r + g)/2);
+	const uint values[] = {r, g, 64 + 2*x + 3*y};
+	return int(values[channel]);
+}
+
+static AnyImage LoadTestJpeg(CSpan<byte> file, ImageFormat expectedFormat, uint scale = 1, ushort lineAlignment = 1)
+{
+	AnyImage result = LoaderJPEG::Instance.LoadFromMemory(file, scale, lineAlignment);
+	INTRA_ASSERT(result != null);
+	INTRA_ASSERT(result.Info.Format == expectedFormat);
+	INTRA_ASSERT_EQUALS(result.Info.Size.x, (JpegTestWidth + scale - 1)/scale);
+	INTRA_ASSERT_EQUALS(result.Info.Size.y, (JpegTestHeight + scale - 1)/scale);
+	INTRA_ASSERT_EQUALS(result.Data.Length(), result.Info.CalculateMipmapDataSize(0, lineAlignment));
+	return result;
+}
+
+//! Сжатие с потерями: сравниваем с исходным изображением по средней и максимальной ошибке.
+static void CheckTestJpegPixels(const AnyImage& image, uint channels, ushort lineAlignment = 1)
+{
+	const size_t rowBytes = (JpegTestWidth*channels + lineAlignment - 1u)/lineAlignment*lineAlignment;
+	uint errorSum = 0, maxError = 0;
+	for(uint y = 0; y < JpegTestHeight; y++)
+		for(uint x = 0; x < JpegTestWidth; x++)
+			for(uint c = 0; c < channels; c++)
+			{
+				const int value = image.Data[y*rowBytes + x*channels + c];
+				const uint error = uint(Math::Abs(value - JpegTestSample(x, y, c, channels)));
+				errorSum += error;
+				maxError = Math::Max(maxError, error);
+			}
+	INTRA_ASSERT(errorSum <= JpegTestWidth*JpegTestHeight*channels*3/2);
+	INTRA_ASSERT(maxError <= 12);
+}
+
+//! Уменьшенное декодирование должно давать средние значения квадратов scale x scale полного изображения.
+static void CheckScaledJpeg(const AnyImage& full, const AnyImage& scaled, uint channels, uint scale)
+{
+	const uint width = scaled.Info.Size.x, height = scaled.Info.Size.y;
+	uint errorSum = 0;
+	for(uint y = 0; y < height; y++)
+		for(uint x = 0; x < width; x++)
+			for(uint c = 0; c < channels; c++)
+			{
+				uint sum = 0, count = 0;
+				for(uint sy = y*scale; sy < Math::Min<uint>((y + 1)*scale, JpegTestHeight); sy++)
+					for(uint sx = x*scale; sx < Math::Min<uint>((x + 1)*scale, JpegTestWidth); sx++, count++)
+						sum += full.Data[(sy*JpegTestWidth + sx)*channels + c];
+				const int average = int((sum + count/2)/count);
+				const int value = scaled.Data[(y*width + x)*channels + c];
+				errorSum += uint(Math::Abs(value - average));
+			}
+	INTRA_ASSERT(errorSum <= width*height*channels*2);
+}
+
+void TestJpegLoader(FormattedWriter& output)
+{
+	output.PrintLine("Baseline и progressive JPEG с прореживанием цветности 4:2:0 и 4:2:2, интервалы перезапуска.");
+	const AnyImage baseline420 = LoadTestJpeg(CSpanOf(jpegBaseline420), ImageFormat::RGB8);
+	CheckTestJpegPixels(baseline420, 3);
+	const AnyImage progressive420 = LoadTestJpeg(CSpanOf(jpegProgressive420), ImageFormat::RGB8);
+	// коэффициенты обоих файлов одинаковы, отличается только порядок их передачи
+	INTRA_ASSERT(progressive420.Data == baseline420.Data);
+	CheckTestJpegPixels(LoadTestJpeg(CSpanOf(jpegBaseline422), ImageFormat::RGB8, 1, 4), 3, 4);
+	const AnyImage gray = LoadTestJpeg(CSpanOf(jpegProgressiveGray), ImageFormat::Luminance8);
+	CheckTestJpegPixels(gray, 1);
+
+	output.PrintLine("Декодирование с уменьшением в 2, 4 и 8 раз.");
+	for(uint scale = 2; scale <= 8; scale *= 2)
+	{
+		CheckScaledJpeg(baseline420, LoadTestJpeg(CSpanOf(jpegBaseline420), ImageFormat::RGB8, scale), 3, scale);
+		CheckScaledJpeg(baseline420, LoadTestJpeg(CSpanOf(jpegProgressive420), ImageFormat::RGB8, scale), 3, scale);
+		CheckScaledJpeg(gray, LoadTestJpeg(CSpanOf(jpegProgressiveGray), ImageFormat::Luminance8, scale), 1, scale);
+	}
+	INTRA_ASSERT(LoaderJPEG::Instance.LoadFromMemory(CSpanOf(jpegBaseline420), 3) == null);
+	CheckTestJpegPixels(LoadTestJpeg(CSpanOf(jpegBaseline422), ImageFormat::RGB8, 1, 128), 3, 128);
+	static const ushort badAlignments[] = {0, 3, 6, 256};
+	for(ushort alignment: badAlignments)
+		INTRA_ASSERT(LoaderJPEG::Instance.LoadFromMemory(CSpanOf(jpegBaseline420), 1, alignment) == null);
+
+	output.PrintLine("Загрузка из потока и определение формата по заголовку.");
+	const ForwardStream stream = CSpanOfRaw<char>(jpegBaseline420, sizeof(jpegBaseline420));
+	const ImageInfo info = AnyImage::GetImageInfo(stream);
+	INTRA_ASSERT(info.Format == ImageFormat::RGB8);
+	INTRA_ASSERT_EQUALS(info.Size.x, uint(JpegTestWidth));
+	const AnyImage fromStream = AnyImage::FromStream(stream);
+	INTRA_ASSERT(fromStream.Data == baseline420.Data);
+
+	// файл, обрезанный до начала данных скана, не декодируется
+	INTRA_ASSERT(LoaderJPEG::Instance.LoadFromMemory(CSpanOf(jpegBaseline420).Take(300)) == null);
+
+	output.PrintLine("Таблица Хаффмана, нарушающая неравенство Крафта, отвергается.");
+	// SOI и DHT, объявляющий 200 однобитных кодов
+	Array<byte> malformed;
+	const byte header[] = {0xFF, 0xD8, 0xFF, 0xC4, 0x00, 2 + 17 + 200, 0x00, 200};
+	malformed.AddLastRange(CSpanOf(header));
+	for(uint i = 1; i < 16 + 200; i++) malformed.AddLast(byte(i < 16? 0: i - 16));
+	const byte eoi[] = {0xFF, 0xD9};
+	malformed.AddLastRange(CSpanOf(eoi));
+	INTRA_ASSERT(LoaderJPEG::Instance.LoadFromMemory(malformed.AsConstRange()) == null);
+}
@@ -0,0 +1,390 @@
+﻿#include "Image.h"
+#include "Image/Loaders/LoaderPNG.h"
+#include "Image/AnyImage.h"
+#include "Data/Compression/Inflate.h"
+#include "Container/Sequential/Array.h"
+#include "Range/Polymorphic/ForwardRange.h"
+#include "Utils/Debug.h"
+
+using namespace Intra;
+using namespace IO;
+using namespace Image;
+
+// Файлы созданы скриптом на Python с zlib: строки фильтруются по очереди фильтрами None, Sub, Up, Avg и Paeth,
+// компонента c пикселя (x, y) равна PngTestSample(x, y, c) по модулю 2^глубина.
+static const byte pngRGBA8[] = {
+	0x89, 0x50, 0x4E, 0x47, 0x0D, 0x0A, 0x1A, 0x0A, 0x00, 0x00, 0x00, 0x0D, 0x49, 0x48, 0x44, 0x52,
+	0x00, 0x00, 0x00, 0x0D, 0x00, 0x00, 0x00, 0x09, 0x08, 0x06, 0x00, 0x00, 0x00, 0xE9, 0x7A, 0xA6,
+	0x6A, 0x00, 0x00, 0x00, 0x0C, 0x74, 0x45, 0x58, 0x74, 0x43, 0x6F, 0x6D, 0x6D, 0x65, 0x6E, 0x74,
+	0x00, 0x74, 0x65, 0x73, 0x74, 0x57, 0x61, 0x2B, 0xE9, 0x00, 0x00, 0x00, 0xC6, 0x49, 0x44, 0x41,
+	0x54, 0x78, 0xDA, 0x4D, 0x90, 0x31, 0x48, 0x1B, 0x51, 0x1C, 0x87, 0xDF, 0x99, 0x84, 0xF3, 0xFA,
+	0x48, 0xE2, 0x53, 0x8F, 0xFC, 0xA3, 0x17, 0x93, 0xBC, 0xCB, 0xD9, 0xC7, 0x81, 0x42, 0xB8, 0x1E,
+	0x04, 0x09, 0x46, 0xF0, 0x50, 0x44, 0x82, 0x28, 0x66, 0x71, 0x2B, 0x0D, 0x19, 0x0A, 0xB5, 0x4B,
+	0x21, 0xB8, 0x76, 0x10, 0xB3, 0xD9, 0xCD, 0x14, 0x57, 0x85, 0x36, 0xE0, 0xA4, 0x93, 0x52, 0xE8,
+	0x9E, 0x80, 0xE0, 0xE0, 0xE4, 0xE4, 0xEE, 0x9B, 0x04, 0x71, 0xD1, 0x1F, 0x22, 0xE8, 0xF0, 0xE3,
+	0xE3, 0x9B, 0xFE, 0xEF, 0x7D, 0x2C, 0xC1, 0x98, 0xF2, 0x0D, 0xA1, 0xD6, 0xE2, 0x52, 0xFD, 0xB0,
+	0x02, 0xD5, 0x1D, 0x89, 0xD4, 0xBF, 0x6C, 0x43, 0xDD, 0x96, 0x5A, 0x6A, 0xB8, 0xDC, 0x56, 0x33,
+	0x0B, 0x7B, 0x6A, 0x63, 0xBD, 0xAB, 0xDA, 0xCD, 0xBF, 0xEA, 0x70, 0xE7, 0x5C, 0xFD, 0xDF, 0xEF,
+	0x2B, 0x63, 0x24, 0x14, 0xCA, 0x33, 0xB4, 0xE9, 0xC5, 0x02, 0xD3, 0x4B, 0x80, 0x26, 0x68, 0x81,
+	0x1C, 0x4C, 0x82, 0x69, 0x50, 0x80, 0x63, 0xA0, 0x0D, 0x66, 0x02, 0x73, 0x88, 0x87, 0x82, 0xF1,
+	0x30, 0x30, 0x79, 0x38, 0x48, 0xF1, 0x50, 0xDB, 0x70, 0x07, 0xEE, 0xC2, 0x7D, 0x78, 0x19, 0x5E,
+	0x81, 0xD7, 0xE0, 0x4B, 0xF0, 0x3A, 0x7C, 0x33, 0x96, 0xFD, 0x2A, 0xC7, 0x69, 0x52, 0xA7, 0xC8,
+	0x61, 0xA3, 0x94, 0xD3, 0x36, 0x4D, 0x45, 0xBE, 0x91, 0x82, 0x07, 0x00, 0x00, 0x00, 0xC5, 0x49,
+	0x44, 0x41, 0x54, 0x59, 0xCA, 0x6B, 0x87, 0x0A, 0xAC, 0x40, 0x45, 0xED, 0x92, 0x8C, 0x3E, 0x92,
+	0xAB, 0x7D, 0x2A, 0xB1, 0x59, 0x3A, 0xD2, 0x65, 0x3A, 0x8E, 0xCE, 0xE2, 0x2F, 0x97, 0x0C, 0x69,
+	0xF2, 0x98, 0x48, 0xF1, 0x84, 0xB0, 0xB9, 0xD9, 0x71, 0xB8, 0x85, 0x6B, 0x1C, 0x4B, 0x62, 0x69,
+	0x4C, 0x48, 0xE7, 0xE5, 0x05, 0xB6, 0xA8, 0xF3, 0x4C, 0xC7, 0x61, 0x55, 0xAB, 0xA1, 0x3E, 0x7F,
+	0x88, 0x56, 0x77, 0x93, 0xED, 0xED, 0xDE, 0x68, 0xEB, 0xD7, 0x65, 0x56, 0x9C, 0xDE, 0x4B, 0x76,
+	0x3D, 0x31, 0x13, 0x3C, 0xD6, 0xE6, 0x64, 0xAE, 0xB9, 0x72, 0xB3, 0xD0, 0xD9, 0xEA, 0x7F, 0x39,
+	0xF9, 0xF6, 0xB4, 0x7B, 0xF5, 0xF3, 0xEE, 0xCF, 0x43, 0xB7, 0xDB, 0x37, 0x96, 0xE7, 0x5B, 0x08,
+	0x21, 0x7C, 0x2F, 0x36, 0xF0, 0xBD, 0x04, 0x68, 0x82, 0x16, 0xC8, 0xC1, 0x24, 0x98, 0xBE, 0xF1,
+	0x3D, 0x01, 0x8E, 0xC1, 0x6D, 0x30, 0x33, 0xF0, 0x5F, 0x43, 0x68, 0x84, 0x10, 0xEF, 0x42, 0x68,
+	0x84, 0x10, 0xEF, 0x42, 0x68, 0x84, 0x10, 0x6F, 0x21, 0x3E, 0x7D, 0xAF, 0x23, 0x84, 0x2C, 0x90,
+	0x13, 0xB8, 0x94, 0xC3, 0xA7, 0xA7, 0x1A, 0xFE, 0x41, 0xBE, 0x35, 0x4B, 0x85, 0x76, 0x99, 0x8A,
+	0x7B, 0x21, 0x49, 0xA3, 0x42, 0xEE, 0xEF, 0x2A, 0x95, 0x7A, 0x35, 0x3A, 0xBA, 0x58, 0x3C, 0x98,
+	0x1E, 0x2C, 0x3D, 0x03, 0x49, 0x7C, 0x70, 0x14, 0x36, 0xD1, 0x3B, 0x77, 0x00, 0x00, 0x00, 0x00,
+	0x49, 0x45, 0x4E, 0x44, 0xAE, 0x42, 0x60, 0x82,
+};
+
+static const byte pngRGB8Fixed[] = {
+	0x89, 0x50, 0x4E, 0x47, 0x0D, 0x0A, 0x1A, 0x0A, 0x00, 0x00, 0x00, 0x0D, 0x49, 0x48, 0x44, 0x52,
+	0x00, 0x00, 0x00, 0x0B, 0x00, 0x00, 0x00, 0x07, 0x08, 0x02, 0x00, 0x00, 0x00, 0x51, 0x0C, 0x20,
+	0x0A, 0x00, 0x00, 0x00, 0x0C, 0x74, 0x45, 0x58, 0x74, 0x43, 0x6F, 0x6D, 0x6D, 0x65, 0x6E, 0x74,
+	0x00, 0x74, 0x65, 0x73, 0x74, 0x57, 0x61, 0x2B, 0xE9, 0x00, 0x00, 0x00, 0xE3, 0x49, 0x44, 0x41,
+	0x54, 0x78, 0x01, 0x63, 0x60, 0x65, 0x60, 0xD0, 0x62, 0x14, 0xF4, 0x67, 0x51, 0x2A, 0xE1, 0x34,
+	0x9E, 0x29, 0xE0, 0xB2, 0x4F, 0x32, 0xF4, 0xB1, 0x4A, 0x1A, 0x87, 0x61, 0xB9, 0xAE, 0x43, 0x47,
+	0x50, 0xE0, 0xCC, 0xF2, 0x94, 0x55, 0x8C, 0x02, 0xA6, 0x82, 0xAA, 0x8C, 0xEF, 0x55, 0x99, 0x8D,
+	0x55, 0x59, 0xDF, 0xAB, 0xB2, 0x1B, 0xAB, 0x72, 0xBE, 0x57, 0xE5, 0x36, 0x56, 0xE5, 0x7D, 0xAF,
+	0xCA, 0x6F, 0xAC, 0x2A, 0xF8, 0x5E, 0x55, 0xD8, 0x98, 0x89, 0xDB, 0x54, 0x90, 0xDB, 0xD4, 0x98,
+	0xDB, 0xF4, 0x2C, 0xB7, 0xE9, 0x7B, 0xAC, 0x6C, 0x66, 0xC9, 0x2C, 0x25, 0x09, 0xE9, 0xF7, 0x12,
+	0x32, 0x0C, 0x12, 0xB2, 0xEF, 0x25, 0xE4, 0x5C, 0x24, 0xE4, 0xDF, 0x4B, 0x28, 0x30, 0x48, 0x28,
+	0xBE, 0x97, 0x50, 0x72, 0x91, 0x50, 0x7E, 0x2F, 0xA1, 0xC2, 0xC0, 0x02, 0x52, 0xCB, 0xA8, 0xC4,
+	0xCD, 0x2C, 0xC8, 0xCD, 0x2A, 0xC8, 0xCD, 0xDE, 0xC9, 0xCD, 0x29, 0xC8, 0xCD, 0x2D, 0xC8, 0xCD,
+	0x2B, 0xC8, 0xCD, 0x2F, 0xC8, 0x2D, 0xA8, 0x04, 0x94, 0x65, 0xB0, 0xE1, 0x0C, 0x4D, 0xE4, 0x72,
+	0x69, 0xE3, 0x2D, 0x5F, 0x2D, 0x94, 0x76, 0x41, 0x52, 0xF0, 0xAB, 0x12, 0x83, 0x94, 0xAE, 0xB1,
+	0xBD, 0x95, 0x52, 0x8A, 0xE7, 0xDD, 0xCE, 0xA8, 0x33, 0xEB, 0x72, 0xFF, 0x33, 0xBA, 0xDB, 0xA5,
+	0xA9, 0x32, 0x0A, 0xAA, 0x32, 0x9F, 0x55, 0x65, 0x15, 0x54, 0x65, 0x3F, 0xAB, 0xCA, 0x29, 0xA8,
+	0xCA, 0x7D, 0x56, 0x95, 0x57, 0x50, 0x95, 0xFF, 0xAE, 0xAA, 0xA0, 0xA0, 0xAA, 0xF0, 0x59, 0x00,
+	0x80, 0xBA, 0x36, 0xA7, 0x34, 0x33, 0x0D, 0xBC, 0x00, 0x00, 0x00, 0x00, 0x49, 0x45, 0x4E, 0x44,
+	0xAE, 0x42, 0x60, 0x82,
+};
+
+static const byte pngRGB16Adam7[] = {
+	0x89, 0x50, 0x4E, 0x47, 0x0D, 0x0A, 0x1A, 0x0A, 0x00, 0x00, 0x00, 0x0D, 0x49, 0x48, 0x44, 0x52,
+	0x00, 0x00, 0x00, 0x09, 0x00, 0x00, 0x00, 0x0A, 0x10, 0x02, 0x00, 0x00, 0x01, 0xCE, 0xF0, 0x0F,
+	0x3C, 0x00, 0x00, 0x00, 0x0C, 0x74, 0x45, 0x58, 0x74, 0x43, 0x6F, 0x6D, 0x6D, 0x65, 0x6E, 0x74,
+	0x00, 0x74, 0x65, 0x73, 0x74, 0x57, 0x61, 0x2B, 0xE9, 0x00, 0x00, 0x01, 0x6E, 0x49, 0x44, 0x41,
+	0x54, 0x78, 0xDA, 0x4D, 0x8F, 0x3F, 0x68, 0x53, 0x51, 0x18, 0xC5, 0x7F, 0x5F, 0xFE, 0x90, 0x3C,
+	0x62, 0x68, 0xAC, 0xE1, 0x91, 0x52, 0x09, 0x25, 0x58, 0x11, 0xB1, 0x10, 0x89, 0xD1, 0xA4, 0xB6,
+	0xC1, 0x60, 0x44, 0x78, 0xA0, 0x4E, 0x1D, 0x2A, 0x38, 0xFA, 0x86, 0x0A, 0xBA, 0x28, 0x11, 0x1D,
+	0x5C, 0x9D, 0x04, 0xC1, 0x25, 0x59, 0x5C, 0x1C, 0x24, 0x4B, 0xD7, 0x16, 0xAA, 0x9B, 0x83, 0xE0,
+	0x58, 0xC1, 0xE9, 0x2D, 0x0A, 0x6E, 0x09, 0x8E, 0xDD, 0x3C, 0xEF, 0x1B, 0xF4, 0xBD, 0xE1, 0x77,
+	0xCF, 0x3D, 0xEF, 0xBB, 0xF7, 0x9C, 0x0B, 0x45, 0xF4, 0xD9, 0x06, 0x37, 0x78, 0x6D, 0x3C, 0xB0,
+	0x8F, 0x5A, 0x2E, 0x68, 0xF3, 0x1C, 0x26, 0xD4, 0x18, 0x19, 0x7F, 0xEC, 0x80, 0x6F, 0x70, 0x99,
+	0x63, 0x46, 0x7C, 0xE1, 0x97, 0xA6, 0x77, 0xAD, 0x9E, 0x5A, 0xF7, 0x28, 0xD0, 0xE2, 0x27, 0xE7,
+	0x88, 0x8D, 0x97, 0xFC, 0xD0, 0xF2, 0x8E, 0x35, 0x8E, 0x72, 0x5C, 0xB2, 0x74, 0x38, 0xA5, 0xC6,
+	0x56, 0xD9, 0xD3, 0xD8, 0x43, 0x1E, 0x2B, 0x68, 0x9F, 0x17, 0xC4, 0x9C, 0xF0, 0x46, 0x37, 0xDF,
+	0x64, 0xC6, 0xCC, 0xB8, 0x6D, 0x03, 0x59, 0x91, 0xEE, 0x4A, 0xC4, 0x53, 0x24, 0x16, 0x51, 0x77,
+	0x7D, 0x96, 0x39, 0x5C, 0xC4, 0x38, 0xCD, 0x53, 0x02, 0x3A, 0x7C, 0x66, 0x85, 0x1D, 0x2B, 0xAB,
+	0xCB, 0xD8, 0xD4, 0xF1, 0x91, 0xAC, 0x88, 0xB2, 0xCF, 0xD6, 0x14, 0x1E, 0xD1, 0x20, 0xC9, 0x11,
+	0x7A, 0x5E, 0xCA, 0xD8, 0x39, 0x25, 0xB4, 0x3D, 0x92, 0x3C, 0x43, 0xFB, 0xCE, 0x1D, 0xDA, 0x76,
+	0xA8, 0x8C, 0xB6, 0x7D, 0x52, 0x9D, 0x36, 0x43, 0x92, 0xC2, 0xBF, 0x13, 0x65, 0x95, 0x0E, 0x75,
+	0x55, 0xAA, 0x1B, 0xA2, 0x64, 0x57, 0xE1, 0x5D, 0xAE, 0x6A, 0xF6, 0x3E, 0x7D, 0xE5, 0xBD, 0x62,
+	0xA0, 0x1F, 0x1F, 0xB8, 0xC5, 0x0E, 0x5F, 0xB9, 0xAB, 0x03, 0x73, 0x76, 0x55, 0xE7, 0x8C, 0xC2,
+	0x62, 0xEB, 0xF1, 0x8C, 0x89, 0x71, 0x9E, 0xF7, 0x1A, 0x5D, 0x57, 0xF3, 0x85, 0x98, 0x77, 0x16,
+	0x9D, 0x25, 0xC6, 0x62, 0xC0, 0xC2, 0xD6, 0xA9, 0xB8, 0x53, 0x75, 0x2E, 0x31, 0xCE, 0x79, 0xCD,
+	0x56, 0x86, 0x71, 0x86, 0xD3, 0x0C, 0x93, 0x0C, 0x5B, 0x79, 0xAE, 0xD8, 0x13, 0x3D, 0xAB, 0xA9,
+	0x92, 0x81, 0x78, 0x8D, 0xDF, 0x62, 0xCF, 0xD9, 0x27, 0xB0, 0x26, 0x9B, 0xEE, 0x5F, 0x77, 0x67,
+	0xCB, 0xB9, 0xCD, 0xDB, 0xFF, 0x8F, 0x4E, 0x4B, 0x86, 0x2A, 0xD9, 0x11, 0x8B, 0xAE, 0x4B, 0xAE,
+	0x83, 0x54, 0x5B, 0xC5, 0x75, 0xD5, 0xFD, 0x25, 0x96, 0xFF, 0x02, 0xB5, 0x5F, 0x59, 0xC3, 0xF5,
+	0x85, 0xE8, 0x42, 0x00, 0x00, 0x00, 0x00, 0x49, 0x45, 0x4E, 0x44, 0xAE, 0x42, 0x60, 0x82,
+};
+
+static const byte pngRGBA16Adam7[] = {
+	0x89, 0x50, 0x4E, 0x47, 0x0D, 0x0A, 0x1A, 0x0A, 0x00, 0x00, 0x00, 0x0D, 0x49, 0x48, 0x44, 0x52,
+	0x00, 0x00, 0x00, 0x06, 0x00, 0x00, 0x00, 0x05, 0x10, 0x06, 0x00, 0x00, 0x01, 0x41, 0xCF, 0x71,
+	0x33, 0x00, 0x00, 0x00, 0x0C, 0x74, 0x45, 0x58, 0x74, 0x43, 0x6F, 0x6D, 0x6D, 0x65, 0x6E, 0x74,
+	0x00, 0x74, 0x65, 0x73, 0x74, 0x57, 0x61, 0x2B, 0xE9, 0x00, 0x00, 0x00, 0xB9, 0x49, 0x44, 0x41,
+	0x54, 0x78, 0xDA, 0x2D, 0x8E, 0xB1, 0x0E, 0x01, 0x51, 0x10, 0x45, 0xCF, 0x62, 0xC3, 0x36, 0xB2,
+	0x0A, 0x12, 0xB1, 0x95, 0x84, 0x6C, 0x34, 0x22, 0xB2, 0x12, 0x05, 0x51, 0x2C, 0x05, 0x09, 0x95,
+	0x46, 0xA5, 0xB1, 0x05, 0x89, 0x4A, 0x22, 0xA1, 0xF0, 0x1B, 0x68, 0x34, 0x7A, 0x7F, 0xA0, 0x53,
+	0xE8, 0x15, 0x2A, 0x95, 0xDE, 0x2F, 0x98, 0x37, 0xBC, 0x62, 0xCE, 0xCC, 0xDC, 0x77, 0xEF, 0x7B,
+	0x60, 0x63, 0x8E, 0x0F, 0x07, 0x5C, 0x42, 0xD3, 0xD4, 0x78, 0x68, 0x73, 0xE3, 0x2D, 0xCA, 0x1E,
+	0x46, 0x24, 0x28, 0xE2, 0x5B, 0x6C, 0x79, 0x12, 0x31, 0x85, 0x02, 0x73, 0xB3, 0x61, 0xC6, 0x52,
+	0xAE, 0x84, 0x5C, 0xD8, 0xFC, 0x84, 0x0A, 0x16, 0x19, 0x11, 0x56, 0x38, 0xD4, 0x85, 0x57, 0xF2,
+	0x8C, 0x8D, 0xB5, 0xC3, 0x42, 0x16, 0x0D, 0xFA, 0xA4, 0x78, 0xE1, 0x09, 0x5D, 0x71, 0x78, 0x31,
+	0x72, 0x1A, 0x95, 0x56, 0x46, 0xE2, 0x37, 0x3C, 0xD2, 0x43, 0xF4, 0x40, 0xA3, 0x02, 0x71, 0x41,
+	0x95, 0x09, 0x4D, 0x4D, 0xD8, 0xD1, 0x16, 0x43, 0x8B, 0x33, 0x5D, 0x89, 0x0E, 0xB9, 0x33, 0x94,
+	0x3A, 0xB0, 0x28, 0x73, 0xD2, 0x37, 0x4B, 0xF2, 0x87, 0x0F, 0x59, 0x61, 0xFC, 0x4F, 0xFB, 0xCF,
+	0x24, 0x6B, 0xA5, 0x63, 0xE6, 0x2F, 0x3F, 0xA3, 0x21, 0x57, 0x01, 0x79, 0x93, 0x8C, 0x00, 0x00,
+	0x00, 0x00, 0x49, 0x45, 0x4E, 0x44, 0xAE, 0x42, 0x60, 0x82,
+};
+
+static const byte pngGray2[] = {
+	0x89, 0x50, 0x4E, 0x47, 0x0D, 0x0A, 0x1A, 0x0A, 0x00, 0x00, 0x00, 0x0D, 0x49, 0x48, 0x44, 0x52,
+	0x00, 0x00, 0x00, 0x0A, 0x00, 0x00, 0x00, 0x03, 0x02, 0x00, 0x00, 0x00, 0x00, 0xC5, 0xE6, 0xD9,
+	0x08, 0x00, 0x00, 0x00, 0x0C, 0x74, 0x45, 0x58, 0x74, 0x43, 0x6F, 0x6D, 0x6D, 0x65, 0x6E, 0x74,
+	0x00, 0x74, 0x65, 0x73, 0x74, 0x57, 0x61, 0x2B, 0xE9, 0x00, 0x00, 0x00, 0x14, 0x49, 0x44, 0x41,
+	0x54, 0x78, 0xDA, 0x63, 0xC8, 0xC9, 0x49, 0x60, 0x94, 0x66, 0xF8, 0xCA, 0xB4, 0x7A, 0xF5, 0x06,
+	0x00, 0x15, 0xE5, 0x04, 0x52, 0x75, 0x93, 0xC4, 0xBB, 0x00, 0x00, 0x00, 0x00, 0x49, 0x45, 0x4E,
+	0x44, 0xAE, 0x42, 0x60, 0x82,
+};
+
+static const byte pngPalette4[] = {
+	0x89, 0x50, 0x4E, 0x47, 0x0D, 0x0A, 0x1A, 0x0A, 0x00, 0x00, 0x00, 0x0D, 0x49, 0x48, 0x44, 0x52,
+	0x00, 0x00, 0x00, 0x0B, 0x00, 0x00, 0x00, 0x05, 0x04, 0x03, 0x00, 0x00, 0x00, 0x61, 0x88, 0x0B,
+	0x65, 0x00, 0x00, 0x00, 0x21, 0x50, 0x4C, 0x54, 0x45, 0x00, 0x00, 0xFF, 0x28, 0x5A, 0xEB, 0x50,
+	0xB4, 0xD7, 0x78, 0x0E, 0xC3, 0xA0, 0x68, 0xAF, 0xC8, 0xC2, 0x9B, 0xF0, 0x1C, 0x87, 0x18, 0x76,
+	0x73, 0x40, 0xD0, 0x5F, 0x68, 0x2A, 0x4B, 0x90, 0x84, 0x37, 0xD4, 0x4B, 0x1E, 0x8B, 0x00, 0x00,
+	0x00, 0x06, 0x74, 0x52, 0x4E, 0x53, 0xFF, 0xEB, 0xD7, 0xC3, 0xAF, 0x9B, 0xB3, 0x4E, 0x19, 0x40,
+	0x00, 0x00, 0x00, 0x0C, 0x74, 0x45, 0x58, 0x74, 0x43, 0x6F, 0x6D, 0x6D, 0x65, 0x6E, 0x74, 0x00,
+	0x74, 0x65, 0x73, 0x74, 0x57, 0x61, 0x2B, 0xE9, 0x00, 0x00, 0x00, 0x2A, 0x49, 0x44, 0x41, 0x54,
+	0x78, 0xDA, 0x63, 0x60, 0xCE, 0x14, 0xA9, 0x52, 0x6D, 0x60, 0x14, 0x49, 0x5B, 0x1D, 0xBD, 0x2D,
+	0x8A, 0x49, 0x90, 0x4D, 0x50, 0x50, 0x50, 0x80, 0x59, 0xC5, 0xEC, 0x89, 0xD9, 0x93, 0x16, 0x16,
+	0x20, 0x3B, 0x31, 0x4D, 0x00, 0x00, 0x96, 0x02, 0x08, 0x7A, 0xC3, 0x19, 0xAA, 0x90, 0x00, 0x00,
+	0x00, 0x00, 0x49, 0x45, 0x4E, 0x44, 0xAE, 0x42, 0x60, 0x82,
+};
+
+static const byte pngGray8Stored[] = {
+	0x89, 0x50, 0x4E, 0x47, 0x0D, 0x0A, 0x1A, 0x0A, 0x00, 0x00, 0x00, 0x0D, 0x49, 0x48, 0x44, 0x52,
+	0x00, 0x00, 0x00, 0x07, 0x00, 0x00, 0x00, 0x04, 0x08, 0x00, 0x00, 0x00, 0x00, 0x67, 0xAD, 0x7A,
+	0xA1, 0x00, 0x00, 0x00, 0x0C, 0x74, 0x45, 0x58, 0x74, 0x43, 0x6F, 0x6D, 0x6D, 0x65, 0x6E, 0x74,
+	0x00, 0x74, 0x65, 0x73, 0x74, 0x57, 0x61, 0x2B, 0xE9, 0x00, 0x00, 0x00, 0x2B, 0x49, 0x44, 0x41,
+	0x54, 0x78, 0x01, 0x01, 0x20, 0x00, 0xDF, 0xFF, 0x00, 0x05, 0x2A, 0x4F, 0x74, 0x99, 0xBE, 0xE3,
+	0x01, 0x10, 0x25, 0x25, 0x25, 0x25, 0x25, 0x25, 0x02, 0x0B, 0x0B, 0x0B, 0x0B, 0x0B, 0x0B, 0x0B,
+	0x03, 0x19, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x6D, 0xD0, 0x05, 0x17, 0x2C, 0x19, 0xA2, 0x80,
+	0x00, 0x00, 0x00, 0x00, 0x49, 0x45, 0x4E, 0x44, 0xAE, 0x42, 0x60, 0x82,
+};
+
+static const byte zlibSkewed[] = {
+	0x78, 0xDA, 0x25, 0x96, 0x05, 0x12, 0x65, 0x2D, 0x0E, 0x85, 0xD7, 0x1A, 0x20, 0x09, 0x12, 0x02,
+	0x4B, 0x18, 0x77, 0x77, 0x77, 0x77, 0xD7, 0xCD, 0xCD, 0xC7, 0x3F, 0x5D, 0xD5, 0x5D, 0xF5, 0x5E,
+	0xBF, 0xCB, 0x25, 0x27, 0xC7, 0xFC, 0x94, 0x88, 0xA8, 0xF1, 0x21, 0xF5, 0xBC, 0x7B, 0x97, 0x5E,
+	0x6E, 0x39, 0x5E, 0x6F, 0xEF, 0xDE, 0xE7, 0x1A, 0x7B, 0x2E, 0x6F, 0x51, 0xAD, 0x8C, 0xAD, 0x76,
+	0xFB, 0xB1, 0x58, 0x75, 0x8E, 0xDD, 0x96, 0x9F, 0xFB, 0xE1, 0x39, 0xEF, 0xBD, 0x7E, 0xDA, 0xC8,
+	0x5C, 0xC7, 0x97, 0xFA, 0xD9, 0x33, 0xCF, 0xF5, 0x22, 0x12, 0xB7, 0x0C, 0x13, 0x9B, 0xBB, 0xE5,
+	0x8A, 0x31, 0x6B, 0xAB, 0xE9, 0x77, 0xD9, 0x47, 0xAA, 0x37, 0x3E, 0x95, 0xB3, 0xEB, 0x28, 0xBB,
+	0xBA, 0x15, 0xBF, 0xDD, 0x67, 0xFA, 0x1A, 0x6A, 0x63, 0xF7, 0x5D, 0x22, 0xCB, 0xB9, 0x32, 0x7B,
+	0x89, 0xDB, 0xB2, 0x48, 0xDA, 0x47, 0x33, 0xA3, 0xE5, 0x39, 0xF7, 0xF8, 0x50, 0x5F, 0xA5, 0xB5,
+	0x32, 0xB4, 0xC7, 0x12, 0x29, 0xED, 0x4E, 0xE9, 0xB5, 0x99, 0x94, 0xD2, 0xAD, 0xDA, 0xB8, 0xE7,
+	0xCC, 0xD0, 0x2B, 0x1F, 0xCB, 0x79, 0x56, 0xB8, 0x08, 0x87, 0x6F, 0x37, 0xA6, 0x08, 0x89, 0x3E,
+	0x95, 0x5B, 0x0C, 0x31, 0xEF, 0xD6, 0xFB, 0x16, 0x8D, 0xA6, 0xDC, 0x66, 0x37, 0xE3, 0xC7, 0xEB,
+	0xE3, 0x4D, 0x32, 0x0A, 0xCF, 0xEF, 0x3E, 0x4B, 0x5B, 0xC7, 0x56, 0xDB, 0xA3, 0x78, 0x09, 0xEB,
+	0xBA, 0x18, 0xD3, 0xAB, 0x64, 0xB1, 0xDA, 0x81, 0xE2, 0xDC, 0xF4, 0xB1, 0x25, 0x3F, 0x11, 0x5A,
+	0x76, 0x74, 0xED, 0x2D, 0x6B, 0x53, 0x46, 0x29, 0x65, 0x8C, 0x7E, 0x8B, 0xA6, 0x85, 0xDC, 0x66,
+	0x0A, 0x4E, 0x60, 0xB1, 0x5A, 0xB7, 0xA8, 0xB5, 0xB6, 0x2D, 0xFE, 0xC9, 0xE2, 0x9A, 0x75, 0xED,
+	0xF4, 0x32, 0x5B, 0x2D, 0x37, 0x96, 0x6F, 0x60, 0x18, 0x91, 0x2A, 0xCD, 0x56, 0xF5, 0xE5, 0x23,
+	0x77, 0xB1, 0x63, 0x55, 0xDA, 0xE5, 0x6A, 0x2D, 0x3E, 0xD5, 0xC4, 0xF2, 0xB8, 0x14, 0x97, 0x56,
+	0xEE, 0x1C, 0x67, 0x82, 0xFA, 0x29, 0x65, 0x06, 0xA8, 0xDC, 0x7B, 0xCC, 0x0C, 0xC8, 0xEE, 0x3B,
+	0x46, 0xD7, 0x1D, 0xDE, 0x8B, 0x7F, 0xFA, 0x80, 0x61, 0xBD, 0x4D, 0xFB, 0x06, 0xAE, 0x3D, 0x67,
+	0x1F, 0x2B, 0xC7, 0x5E, 0x52, 0x32, 0xD6, 0xE2, 0x08, 0x57, 0x6E, 0xB8, 0x8F, 0xB5, 0x92, 0x65,
+	0xF7, 0xD1, 0xA4, 0x7F, 0x46, 0x46, 0xCE, 0xD9, 0x4A, 0x5D, 0x3D, 0x53, 0x47, 0x5F, 0xAD, 0xD6,
+	0xE9, 0xFD, 0xEA, 0x59, 0x57, 0x18, 0xA3, 0xAE, 0x59, 0xAB, 0xD4, 0x53, 0x74, 0xF8, 0xBC, 0xB9,
+	0x46, 0x89, 0xCF, 0xF2, 0xC6, 0x52, 0xB3, 0x73, 0xDB, 0x16, 0xBB, 0xB4, 0x5E, 0xB2, 0x1B, 0x17,
+	0xB3, 0xE3, 0xD7, 0xDE, 0x4E, 0x79, 0x76, 0x9B, 0x9E, 0x62, 0x43, 0xE6, 0xDD, 0x30, 0x42, 0x3F,
+	0xC7, 0x2E, 0xF6, 0xD4, 0xDC, 0xC7, 0x9D, 0x87, 0xF9, 0xD5, 0xBD, 0x25, 0xEF, 0xEC, 0x3D, 0x81,
+	0x62, 0xF7, 0x34, 0x86, 0x33, 0x09, 0x26, 0x39, 0x55, 0xE1, 0xD4, 0xAD, 0x9F, 0x5F, 0x11, 0xE6,
+	0x2A, 0xD7, 0x7C, 0x35, 0x7E, 0xBC, 0xF4, 0x6E, 0xBE, 0xEE, 0xB3, 0x4B, 0xDF, 0x91, 0x71, 0x78,
+	0x75, 0x74, 0x6B, 0x63, 0xB0, 0x54, 0x99, 0x76, 0xDB, 0xF8, 0x82, 0x43, 0x37, 0x59, 0x71, 0x54,
+	0x6B, 0x28, 0xBF, 0xB1, 0x51, 0xDB, 0xBC, 0x55, 0xA6, 0xD4, 0x30, 0x8E, 0x08, 0xDF, 0x39, 0x80,
+	0xB3, 0x26, 0xCC, 0x81, 0x23, 0x45, 0xBF, 0x28, 0xDC, 0x77, 0xDE, 0xD1, 0x53, 0xAC, 0x43, 0xBC,
+	0xAB, 0xDD, 0x15, 0xB0, 0x59, 0xC1, 0xB2, 0x5B, 0xF6, 0x98, 0x1E, 0xD3, 0x18, 0x69, 0x48, 0x4E,
+	0xCB, 0xBE, 0x5B, 0x7C, 0xA9, 0xEE, 0xDB, 0x45, 0xCB, 0x01, 0xBE, 0x75, 0x42, 0x77, 0x0F, 0x19,
+	0xE7, 0x04, 0x6C, 0x6C, 0x87, 0x75, 0x72, 0xC4, 0xD2, 0x5A, 0x56, 0x2F, 0xA8, 0xE1, 0xDA, 0x4A,
+	0xDB, 0x5F, 0x96, 0x6A, 0xC9, 0x22, 0x75, 0x8F, 0x7B, 0x8D, 0x2F, 0x6C, 0xA9, 0xC8, 0xB8, 0x7D,
+	0xEE, 0x21, 0x4D, 0x0F, 0x58, 0xCD, 0x95, 0x70, 0x6C, 0xAA, 0xFA, 0x08, 0xEE, 0x7E, 0xBF, 0x22,
+	0x63, 0xF5, 0x79, 0xDE, 0x25, 0x7D, 0xCC, 0x55, 0xA2, 0xED, 0x38, 0x22, 0x95, 0x07, 0xD9, 0x87,
+	0xD7, 0x9D, 0x15, 0xD8, 0xF9, 0xFF, 0x53, 0xF3, 0xC9, 0x76, 0xCD, 0xF8, 0x6A, 0x49, 0x56, 0x5C,
+	0x87, 0x83, 0xDC, 0x6A, 0xAB, 0x79, 0x36, 0x14, 0x65, 0x7B, 0xB1, 0x9E, 0xC2, 0xC9, 0x32, 0x3C,
+	0xD2, 0xD5, 0xEF, 0xDC, 0x36, 0xD1, 0xE4, 0xF2, 0xFB, 0x35, 0x71, 0x9F, 0xA5, 0x96, 0xE2, 0x35,
+	0x6B, 0xB6, 0xD1, 0x76, 0x87, 0xCA, 0xAD, 0x1F, 0x7D, 0xAB, 0x18, 0x6D, 0xC5, 0xDD, 0x0B, 0x4F,
+	0x98, 0xB3, 0x22, 0xA5, 0xC0, 0x12, 0xF2, 0xEB, 0xD3, 0x2D, 0xF6, 0x84, 0x95, 0xA0, 0x93, 0x7B,
+	0xCA, 0xAA, 0xCC, 0x69, 0x7D, 0xDC, 0xE5, 0x8C, 0x29, 0x1D, 0x41, 0x30, 0xA4, 0x19, 0x6C, 0x2B,
+	0x3B, 0xB5, 0x8E, 0xF1, 0x8D, 0xED, 0x81, 0x1E, 0x13, 0xF1, 0xEE, 0x55, 0x4F, 0x80, 0xC4, 0x84,
+	0x6E, 0xA5, 0xD5, 0xDD, 0x4D, 0x37, 0xE3, 0xE3, 0x1E, 0xA5, 0x8F, 0xAA, 0x0D, 0xEE, 0x2E, 0x8B,
+	0x3B, 0xBE, 0x59, 0xE4, 0x4E, 0xE8, 0xC8, 0x63, 0xD7, 0xA1, 0xFB, 0xAC, 0xFC, 0x02, 0x89, 0x4A,
+	0x05, 0x90, 0x28, 0x00, 0x83, 0xFD, 0x4C, 0xE4, 0xA2, 0x13, 0x2B, 0xC8, 0x61, 0x67, 0x7E, 0x4B,
+	0x1F, 0x64, 0x71, 0x98, 0xF7, 0x8D, 0x77, 0x4E, 0xF5, 0x51, 0x53, 0x8D, 0xA1, 0x33, 0x38, 0xCC,
+	0xF7, 0xDD, 0xBA, 0x41, 0x11, 0xCF, 0x59, 0x47, 0x5B, 0xCF, 0xF9, 0xED, 0xC1, 0xA4, 0x0C, 0x39,
+	0xD1, 0x7F, 0xE6, 0xB8, 0xED, 0x94, 0xB3, 0x04, 0x05, 0xE2, 0x5D, 0xEA, 0x7C, 0x59, 0x63, 0xA4,
+	0x73, 0x49, 0xBB, 0x00, 0xC3, 0x64, 0x1E, 0xDF, 0x71, 0x24, 0x1C, 0x39, 0x42, 0xBA, 0xB4, 0xE4,
+	0xA1, 0x36, 0xF1, 0x95, 0x85, 0x7B, 0xB2, 0xBE, 0x26, 0x40, 0x84, 0xBA, 0x3C, 0x0A, 0xE8, 0xCE,
+	0x5E, 0x6F, 0xD5, 0x9E, 0xDF, 0x9D, 0x07, 0xEE, 0x6E, 0xA8, 0xBA, 0x6D, 0x78, 0x55, 0x36, 0xB1,
+	0xCC, 0xDA, 0x05, 0x68, 0xC8, 0x85, 0x51, 0xF2, 0x08, 0x94, 0x2A, 0xBA, 0xAB, 0xF4, 0x2B, 0xBC,
+	0x52, 0xBE, 0x77, 0x34, 0xB1, 0x47, 0x2F, 0x6C, 0x29, 0xA3, 0x22, 0xF2, 0x55, 0x25, 0x72, 0xA1,
+	0xB8, 0xC4, 0x21, 0x6D, 0x2D, 0xB8, 0xCB, 0xB0, 0xBD, 0xB7, 0xBD, 0x02, 0x43, 0x69, 0xE5, 0xFB,
+	0x18, 0x13, 0x86, 0x80, 0x77, 0x7B, 0x19, 0x7D, 0xF8, 0xE5, 0x8A, 0x7A, 0x8E, 0x9D, 0xE1, 0xCA,
+	0x5F, 0x96, 0x9F, 0x47, 0x7B, 0x15, 0xBE, 0xBE, 0x3A, 0x9F, 0xF5, 0xEF, 0x1F, 0x54, 0x9D, 0x08,
+	0xDB, 0x17, 0xE6, 0x87, 0x91, 0x0E, 0x71, 0x2E, 0xA4, 0x4C, 0x87, 0x2B, 0xA1, 0xCB, 0x02, 0xCD,
+	0xCB, 0xD5, 0x4C, 0x50, 0x81, 0x91, 0x7D, 0xC9, 0x99, 0x3F, 0xBC, 0x35, 0xBA, 0xF8, 0xDE, 0x82,
+	0x4B, 0x42, 0xFD, 0x5B, 0x20, 0x24, 0xE6, 0x85, 0xDF, 0x97, 0xDB, 0x58, 0x16, 0x0F, 0x6B, 0x6B,
+	0x98, 0x7A, 0xCE, 0xC5, 0x9F, 0x79, 0xED, 0x47, 0x61, 0xB3, 0xAB, 0xB5, 0x7D, 0xC7, 0xDE, 0x6B,
+	0x17, 0x3F, 0x12, 0x3B, 0x17, 0x98, 0x93, 0x26, 0xA3, 0xA3, 0x2C, 0x63, 0xC4, 0x8E, 0x07, 0xB1,
+	0xDF, 0x3B, 0x17, 0xA1, 0xF3, 0x63, 0x16, 0x3C, 0x31, 0xFD, 0xF5, 0xD6, 0x31, 0x32, 0xD8, 0x6A,
+	0x14, 0x85, 0x6A, 0x79, 0x5F, 0x20, 0x04, 0x64, 0x55, 0x02, 0xA9, 0x20, 0xF7, 0x9E, 0x48, 0xBB,
+	0xC5, 0xFA, 0x09, 0x24, 0x7A, 0xD8, 0x12, 0x21, 0x96, 0x3A, 0xFB, 0x75, 0xD9, 0xC2, 0xD6, 0x26,
+	0x1E, 0x8C, 0x1C, 0x59, 0x9D, 0x8E, 0x82, 0x5B, 0xC6, 0x0C, 0x9F, 0x72, 0x70, 0xB8, 0xFE, 0x53,
+	0x0C, 0x36, 0x3A, 0xF4, 0x5D, 0xB5, 0x6E, 0x59, 0x8B, 0x57, 0x7C, 0x30, 0x3C, 0xE8, 0x12, 0x02,
+	0xAA, 0x5B, 0x5B, 0xDC, 0xD8, 0x82, 0xFC, 0xB8, 0xCB, 0xC1, 0x1E, 0xFC, 0x67, 0x78, 0x75, 0x72,
+	0xE8, 0x48, 0x42, 0xF3, 0x3C, 0x59, 0xC9, 0xCB, 0xB8, 0xB3, 0xC7, 0xC1, 0x26, 0xCE, 0x3C, 0x20,
+	0xA6, 0x3A, 0x56, 0x10, 0x36, 0x70, 0xF0, 0xD6, 0x61, 0x3F, 0x67, 0x8F, 0xA3, 0x1C, 0xE9, 0x61,
+	0x7B, 0x0E, 0xF7, 0x1C, 0x23, 0x0A, 0x30, 0xB3, 0x6D, 0x1C, 0xFA, 0x1C, 0xE2, 0xF4, 0x54, 0x44,
+	0x86, 0x51, 0x63, 0x77, 0x8C, 0xEC, 0xF5, 0x17, 0x0B, 0x2F, 0x6C, 0xDC, 0x12, 0xBF, 0xC1, 0x2C,
+	0xCA, 0x44, 0x72, 0xDE, 0x64, 0x6E, 0xDF, 0x56, 0x5E, 0x2A, 0x63, 0x0C, 0x15, 0x8A, 0x76, 0xF4,
+	0xD0, 0xF5, 0x08, 0x69, 0xF0, 0x4B, 0xC5, 0x1D, 0xFC, 0x25, 0x9D, 0x1F, 0x85, 0x53, 0x63, 0x71,
+	0x97, 0xD2, 0x58, 0x83, 0x36, 0xC3, 0x04, 0x09, 0xC0, 0x0B, 0x6A, 0xBC, 0x61, 0x92, 0xF2, 0x26,
+	0xA7, 0xE4, 0xAF, 0x82, 0xE0, 0x5B, 0x7D, 0xED, 0xC0, 0x83, 0x70, 0x8E, 0xE7, 0x15, 0x5E, 0x71,
+	0xCC, 0x36, 0x00, 0x5C, 0xE3, 0x03, 0x86, 0x4E, 0x48, 0x51, 0xA5, 0x98, 0x51, 0x10, 0xF4, 0xFE,
+	0x9A, 0xCF, 0x6A, 0x5B, 0x5F, 0x47, 0x20, 0xC3, 0x30, 0x53, 0x21, 0xA1, 0xC8, 0x1F, 0x32, 0x9F,
+	0x08, 0xC3, 0xCE, 0x70, 0x27, 0xC6, 0xC4, 0x9B, 0xFB, 0x71, 0x3C, 0xD6, 0xF7, 0x6F, 0x88, 0x01,
+	0x05, 0xDE, 0x7B, 0xF0, 0x56, 0x88, 0x7B, 0x71, 0xBA, 0x60, 0x8F, 0x32, 0x6A, 0xC7, 0x8C, 0xB0,
+	0xA5, 0x65, 0x63, 0x61, 0x65, 0xFF, 0xB7, 0xC3, 0x77, 0xD1, 0xDF, 0xC2, 0x3C, 0x27, 0xE6, 0x2D,
+	0xA6, 0x93, 0xDF, 0x43, 0xCE, 0x69, 0x2B, 0x45, 0xC1, 0xF8, 0x85, 0xFD, 0x69, 0x78, 0x0F, 0x8E,
+	0xD7, 0x65, 0x31, 0x1F, 0xB9, 0x1E, 0xFD, 0xFE, 0x0E, 0x74, 0x40, 0x14, 0x03, 0x43, 0x3C, 0xAB,
+	0x83, 0xC2, 0x9D, 0x9C, 0xC1, 0x9D, 0x2B, 0x86, 0xF7, 0xC1, 0x5B, 0xE6, 0x93, 0x8B, 0xF9, 0x29,
+	0x8B, 0x02, 0x80, 0xED, 0xFE, 0x7E, 0x13, 0xA3, 0x30, 0x90, 0x16, 0x44, 0x54, 0xD2, 0x38, 0x94,
+	0x05, 0x62, 0x48, 0x97, 0x6B, 0x55, 0xDC, 0x83, 0x80, 0x1E, 0xA7, 0x33, 0xF6, 0xEC, 0xEB, 0xF2,
+	0x20, 0xCE, 0xFF, 0x07, 0xAE, 0x43, 0x8A, 0xC3, 0x7F, 0x02, 0x42, 0x4C, 0x36, 0xA6, 0x80, 0xC8,
+	0xFD, 0xC5, 0x41, 0xED, 0xED, 0x78, 0x23, 0x0E, 0xA8, 0x26, 0xAB, 0xD3, 0x79, 0xBC, 0xD7, 0xD2,
+	0xEF, 0x1F, 0x13, 0xAF, 0xAC, 0xAB, 0xDE, 0x51, 0x49, 0x4F, 0x84, 0xF1, 0xEA, 0x93, 0x1A, 0x09,
+	0x88, 0x3E, 0x9A, 0x22, 0x2F, 0xC2, 0xED, 0xE9, 0xF7, 0x64, 0x1D, 0x8F, 0xE6, 0x57, 0xFE, 0x44,
+	0x0F, 0xE9, 0xAF, 0xC7, 0x20, 0xB3, 0x6C, 0x07, 0x09, 0xEF, 0x92, 0xFC, 0x13, 0xF4, 0x30, 0x14,
+	0xC7, 0xF6, 0x9F, 0xDF, 0x80, 0x76, 0xAB, 0xB8, 0x88, 0x62, 0xCE, 0xFD, 0xCF, 0x74, 0x10, 0xAE,
+	0x46, 0x55, 0x7A, 0x13, 0x22, 0x00, 0x51, 0x90, 0xE2, 0x5D, 0x56, 0x03, 0x2E, 0xF5, 0x31, 0xE8,
+	0x4C, 0x95, 0x6E, 0xB6, 0x9F, 0xCE, 0xED, 0x19, 0xD3, 0x5F, 0xB8, 0xC7, 0x86, 0xEB, 0xBC, 0x16,
+	0x17, 0x19, 0xF2, 0x64, 0xE2, 0x41, 0xA5, 0x98, 0x97, 0x57, 0x90, 0x96, 0xDE, 0x87, 0x11, 0x7C,
+	0x47, 0xF4, 0x3E, 0xC6, 0x54, 0xAF, 0x7F, 0x85, 0xD5, 0xAC, 0x92, 0x22, 0x50, 0x1B, 0x65, 0x0C,
+	0x9C, 0x09, 0x53, 0x2A, 0xCA, 0xC4, 0x23, 0xDA, 0xD3, 0x26, 0x29, 0x79, 0x21, 0x14, 0x89, 0x83,
+	0xA2, 0x92, 0x55, 0xEF, 0xBF, 0x49, 0x6A, 0x61, 0xFB, 0x54, 0x82, 0x89, 0x58, 0x08, 0x6E, 0x2A,
+	0x48, 0x3B, 0x42, 0x33, 0x5A, 0x9D, 0xB2, 0xB2, 0xF0, 0x0A, 0x12, 0x0F, 0xBB, 0xE9, 0xE4, 0x0B,
+	0x42, 0xF2, 0xF5, 0xF7, 0x03, 0x8F, 0x02, 0xCE, 0xDA, 0x6C, 0x9B, 0x62, 0xFA, 0x8C, 0x9F, 0xC4,
+	0x85, 0xE8, 0x14, 0x1C, 0x27, 0xD8, 0x27, 0x6D, 0x40, 0x47, 0x6B, 0x33, 0x5E, 0x01, 0x61, 0x2C,
+	0xFD, 0x47, 0x28, 0xD5, 0xCE, 0x3C, 0xC1, 0x54, 0x8D, 0xF5, 0x60, 0x09, 0x5A, 0xA1, 0xB3, 0xD0,
+	0x75, 0xF0, 0x7A, 0x49, 0x6F, 0x66, 0x88, 0x18, 0x4B, 0xEE, 0x73, 0x42, 0xFA, 0xFA, 0x4F, 0xBA,
+	0x64, 0x1C, 0x52, 0xE1, 0x90, 0x98, 0x11, 0x79, 0x17, 0x79, 0x42, 0x51, 0x39, 0x86, 0xD4, 0x10,
+	0x1C, 0xD4, 0xC3, 0x76, 0x85, 0x97, 0x8F, 0x8E, 0xAB, 0xD3, 0x05, 0xCF, 0xBF, 0x6A, 0xA7, 0x13,
+	0xD1, 0x39, 0x68, 0xC4, 0x33, 0x25, 0x51, 0xE6, 0xAA, 0xC6, 0x27, 0x32, 0x86, 0x0A, 0x33, 0x17,
+	0x91, 0x24, 0xA4, 0x61, 0xB3, 0x67, 0xE5, 0x58, 0x44, 0xCA, 0xBF, 0x7D, 0x83, 0x35, 0x12, 0xAF,
+	0xD0, 0x09, 0xA7, 0x38, 0x38, 0x2B, 0xF1, 0x8D, 0xD5, 0xC8, 0x25, 0x6F, 0x5F, 0xEF, 0x79, 0xB1,
+	0x42, 0x2B, 0xA0, 0xD3, 0xD4, 0xD9, 0x40, 0xE0, 0x3F, 0x94, 0xA0, 0x8D, 0x43, 0x39, 0xC9, 0xD9,
+	0x5F, 0xB7, 0x31, 0xB8, 0x6A, 0x41, 0x76, 0xE0, 0xAE, 0xFD, 0xD0, 0x25, 0x39, 0x1B, 0xB9, 0x9E,
+	0x03, 0xBF, 0x62, 0x83, 0x9D, 0xFC, 0xF7, 0x3E, 0x58, 0xEF, 0x85, 0x2F, 0x87, 0xD3, 0x91, 0x08,
+	0x9E, 0x79, 0x58, 0x08, 0x27, 0xD3, 0xDE, 0x10, 0xF5, 0xB1, 0x09, 0x11, 0x72, 0x94, 0xFF, 0x01,
+	0xE7, 0x0D, 0xED, 0xEE,
+};
+
+static uint PngTestSample(uint x, uint y, uint channel, uint maxValue)
+{
+	const uint values[] = {x*37 + y*11 + 5, x*x + y*53, (x ^ y)*17, x*y*7 + 40};
+	return values[channel] % (maxValue + 1);
+}
+
+static AnyImage LoadTestPng(CSpan<byte> file, ImageFormat expectedFormat, uint width, uint height, ushort lineAlignment = 1)
+{
+	AnyImage result = LoaderPNG::Instance.LoadFromMemory(file, lineAlignment);
+	INTRA_ASSERT(result != null);
+	INTRA_ASSERT(result.Info.Format == expectedFormat);
+	INTRA_ASSERT_EQUALS(result.Info.Size.x, width);
+	INTRA_ASSERT_EQUALS(result.Info.Size.y, height);
+	INTRA_ASSERT_EQUALS(result.Data.Length(), result.Info.CalculateMipmapDataSize(0, lineAlignment));
+	return result;
+}
+
+//! Проверяет изображение, компоненты которого записаны прямо по формуле PngTestSample.
+template<typename T> static void CheckTestPngPixels(const AnyImage& image, uint channels, ushort lineAlignment = 1)
+{
+	const uint maxValue = (1u << (8*sizeof(T))) - 1;
+	const size_t rowBytes = (image.Info.Size.x*channels*sizeof(T) + lineAlignment - 1)/lineAlignment*lineAlignment;
+	for(uint y = 0; y < image.Info.Size.y; y++)
+	{
+		const T* row = reinterpret_cast<const T*>(image.Data.Data() + y*rowBytes);
+		for(uint x = 0; x < image.Info.Size.x; x++)
+			for(uint c = 0; c < channels; c++)
+				INTRA_ASSERT_EQUALS(uint(row[x*channels + c]), PngTestSample(x, y, c, maxValue));
+	}
+}
+
+static void TestPngInflate(FormattedWriter& output)
+{
+	output.PrintLine("Распаковка zlib с кодами Хаффмана длиннее 10 бит.");
+	Array<byte> expected;
+	uint x = 1;
+	for(uint i = 0; i < 3000; i++)
+	{
+		x = (x*1103515245u + 12345u) & 0x7FFFFFFF;
+		expected.AddLast(byte(97 + ((x >> 16) & 15)));
+		if(i % 50 == 7) expected.AddLast(byte(128 + i/50));
+	}
+	Array<byte> unpacked;
+	unpacked.SetCount(expected.Length());
+	INTRA_ASSERT_EQUALS(Data::InflateZlib(CSpanOf(zlibSkewed), unpacked), expected.Length());
+	INTRA_ASSERT(unpacked == expected);
+
+	// недостаток места и повреждённая контрольная сумма
+	INTRA_ASSERT_EQUALS(Data::InflateZlib(CSpanOf(zlibSkewed), unpacked.AsRange().DropLast()), size_t(Data::InflateError));
+	byte corrupted[sizeof(zlibSkewed)];
+	C::memcpy(corrupted, zlibSkewed, sizeof(zlibSkewed));
+	corrupted[sizeof(corrupted) - 1] ^= 1;
+	INTRA_ASSERT_EQUALS(Data::InflateZlib(CSpanOf(corrupted), unpacked), size_t(Data::InflateError));
+}
+
+void TestPngLoader(FormattedWriter& output)
+{
+	TestPngInflate(output);
+
+	output.PrintLine("8 и 16 бит на компоненту, все фильтры строк, чересстрочная развёртка Adam7.");
+	CheckTestPngPixels<byte>(LoadTestPng(CSpanOf(pngRGBA8), ImageFormat::RGBA8, 13, 9), 4);
+	CheckTestPngPixels<byte>(LoadTestPng(CSpanOf(pngRGB8Fixed), ImageFormat::RGB8, 11, 7, 4), 3, 4);
+	CheckTestPngPixels<ushort>(LoadTestPng(CSpanOf(pngRGB16Adam7), ImageFormat::RGB16, 9, 10), 3);
+	CheckTestPngPixels<ushort>(LoadTestPng(CSpanOf(pngRGBA16Adam7), ImageFormat::RGBA16, 6, 5), 4);
+	CheckTestPngPixels<byte>(LoadTestPng(CSpanOf(pngGray8Stored), ImageFormat::Luminance8, 7, 4, 8), 1, 8);
+
+	output.PrintLine("Оттенки серого с 2 битами на пиксель растягиваются до 8 бит.");
+	const AnyImage gray2 = LoadTestPng(CSpanOf(pngGray2), ImageFormat::Luminance8, 10, 3);
+	for(uint y = 0; y < 3; y++)
+		for(uint x = 0; x < 10; x++)
+			INTRA_ASSERT_EQUALS(uint(gray2.Data[y*10 + x]), PngTestSample(x, y, 0, 3)*85);
+
+	output.PrintLine("Палитра из 4-битных индексов с прозрачностью из tRNS.");
+	const AnyImage paletted = LoadTestPng(CSpanOf(pngPalette4), ImageFormat::RGBA8, 11, 5);
+	for(uint y = 0; y < 5; y++)
+		for(uint x = 0; x < 11; x++)
+		{
+			const uint index = (x*3 + y) % 11;
+			const byte* pixel = paletted.Data.Data() + (y*11 + x)*4;
+			INTRA_ASSERT_EQUALS(uint(pixel[0]), index*40 % 256);
+			INTRA_ASSERT_EQUALS(uint(pixel[1]), index*90 % 256);
+			INTRA_ASSERT_EQUALS(uint(pixel[2]), (255 - index*20) % 256);
+			INTRA_ASSERT_EQUALS(uint(pixel[3]), index < 6? 255 - index*20: 255);
+		}
+
+	output.PrintLine("Загрузка из потока и определение формата по заголовку.");
+	const ForwardStream stream = CSpanOfRaw<char>(pngPalette4, sizeof(pngPalette4));
+	const ImageInfo info = AnyImage::GetImageInfo(stream);
+	INTRA_ASSERT(info.Format == ImageFormat::RGBA8);
+	const AnyImage fromStream = AnyImage::FromStream(stream);
+	INTRA_ASSERT(fromStream.Data == paletted.Data);
+
+	// обрезанный файл не декодируется
+	INTRA_ASSERT(LoaderPNG::Instance.LoadFromMemory(CSpanOf(pngRGBA8).DropLast(30)) == null);
+
+	// выравнивание строк хранится в байте и должно быть степенью двойки
+	static const ushort badAlignments[] = {0, 3, 6, 256};
+	for(ushort alignment: badAlignments)
+		INTRA_ASSERT(LoaderPNG::Instance.LoadFromMemory(CSpanOf(pngRGBA8), alignment) == null);
+	CheckTestPngPixels<byte>(LoadTestPng(CSpanOf(pngRGBA8), ImageFormat::RGBA8, 13, 9, 128), 4, 128);
+
+	// чанк, объявляющий длину больше содержимого потока, не заставляет выделять память под всю длину
+	static const uint hugeLengths[] = {0x7FFFFFF0, 0xFFFFFFF0};
+	for(uint length: hugeLengths)
+	{
+		byte truncated[8 + 25 + 8 + 16];
+		C::memcpy(truncated, pngRGBA8, 8 + 25);
+		byte* chunk = truncated + 8 + 25;
+		for(int i = 0; i < 4; i++) chunk[i] = byte(length >> (24 - 8*i));
+		C::memcpy(chunk + 4, "tEXt", 4);
+		C::memset(chunk + 8, 'x', 16);
+		ForwardStream truncatedStream = CSpanOfRaw<char>(truncated, sizeof(truncated));
+		INTRA_ASSERT(LoaderPNG::Instance.Load(truncatedStream, 1) == null);
+	}
+}
@@ -0,0 +1,107 @@
+﻿#include "Image.h"
+#include "Image/Resample.h"
+#include "Image/AnyImage.h"
+#include "Container/Sequential/Array.h"
+#include "Math/Math.h"
+#include "Utils/Debug.h"
+
+using namespace Intra;
+using namespace IO;
+using namespace Image;
+
+static byte ResampleTestSample(uint x, uint y, uint c)
+{return byte(x*29 + y*71 + c*83 + x*y*7);}
+
+static void CheckConstantMipmaps(ResampleFilter filter, bool srgb)
+{
+	const byte color[] = {200, 37, 121};
+	AnyImage image({13, 7, 2}, ImageFormat::RGB8, 0, ImageType_2DArray);
+	image.LineAlignment = 4;
+	image.Data.SetCount(image.Info.CalculateMipmapDataSize(0, image.LineAlignment));
+	for(size_t i = 0; i < image.Data.Length(); i++)
+	{
+		const size_t x = i % 40;
+		if(x < 39) image.Data[i] = color[x % 3];
+	}
+	const Array<byte> level0 = image.Data;
+
+	ResampleParams params;
+	params.Filter = filter;
+	params.SRGB = srgb;
+	INTRA_ASSERT(GenerateMipmaps(image, params));
+	INTRA_ASSERT_EQUALS(image.Info.MipmapCount, 4);
+	INTRA_ASSERT_EQUALS(image.Data.Length(), image.Info.CalculateFullDataSize(image.LineAlignment));
+	INTRA_ASSERT(image.Data.Take(level0.Length()) == level0);
+	for(uint mip = 1; mip < 4; mip++)
+	{
+		const auto size = image.Info.CalculateMipmapSize(mip);
+		INTRA_ASSERT_EQUALS(size.z, 2);
+		const size_t lineBytes = (size.x*3u + 3u) & ~3u;
+		const byte* data = static_cast<const byte*>(image.GetMipmapDataPtr(mip));
+		for(uint y = 0; y < size.y*size.z; y++)
+			for(uint x = 0; x < lineBytes; x++)
+				INTRA_ASSERT_EQUALS(uint(data[y*lineBytes + x]), x < size.x*3u? uint(color[x % 3]): 0u);
+	}
+}
+
+void TestResample(FormattedWriter& output)
+{
+	output.PrintLine("Box при уменьшении вдвое усредняет квадраты 2x2.");
+	enum: uint {W = 10, H = 6};
+	byte src[W*H*4], dst[W*H];
+	for(uint y = 0; y < H; y++)
+		for(uint x = 0; x < W; x++)
+			for(uint c = 0; c < 4; c++) src[(y*W + x)*4 + c] = ResampleTestSample(x, y, c);
+	ResampleParams box;
+	box.Filter = ResampleFilter::Box;
+	box.PremultiplyAlpha = false;
+	INTRA_ASSERT(ResampleImage(CSpanOf(src), {W, H}, SpanOf(dst), {W/2, H/2}, ImageFormat::RGBA8, 1, box));
+	for(uint y = 0; y < H/2; y++)
+		for(uint x = 0; x < W/2; x++)
+			for(uint c = 0; c < 4; c++)
+			{
+				const uint sum = uint(ResampleTestSample(2*x, 2*y, c)) + ResampleTestSample(2*x + 1, 2*y, c) +
+					ResampleTestSample(2*x, 2*y + 1, c) + ResampleTestSample(2*x + 1, 2*y + 1, c);
+				INTRA_ASSERT(Math::Abs(int(dst[(y*W/2 + x)*4 + c]) - int(sum + 2)/4) <= 1);
+			}
+
+	output.PrintLine("Усреднение в линейном пространстве для sRGB.");
+	const byte blackWhite[] = {0, 0, 0, 255, 255, 255, 255, 255};
+	byte one[4];
+	INTRA_ASSERT(ResampleImage(CSpanOf(blackWhite), {2, 1}, SpanOf(one), {1, 1}, ImageFormat::RGBA8, 1, box));
+	INTRA_ASSERT_EQUALS(uint(one[0]), 128u);
+	box.SRGB = true;
+	INTRA_ASSERT(ResampleImage(CSpanOf(blackWhite), {2, 1}, SpanOf(one), {1, 1}, ImageFormat::RGBA8, 1, box));
+	INTRA_ASSERT_EQUALS(uint(one[0]), 188u);
+	INTRA_ASSERT_EQUALS(uint(one[3]), 255u);
+
+	// для формата sRGB8_A8 фильтрация в линейном пространстве включается без SRGB в параметрах
+	AnyImage srgbImage({2, 1, 1}, ImageFormat::sRGB8_A8, 0);
+	srgbImage.Data.AddLastRange(CSpanOf(blackWhite));
+	box.SRGB = false;
+	INTRA_ASSERT(CanResample(ImageFormat::sRGB8));
+	INTRA_ASSERT(GenerateMipmaps(srgbImage, box));
+	INTRA_ASSERT_EQUALS(srgbImage.Info.MipmapCount, 2);
+	const byte* srgbMip = static_cast<const byte*>(srgbImage.GetMipmapDataPtr(1));
+	INTRA_ASSERT_EQUALS(uint(srgbMip[0]), 188u);
+	INTRA_ASSERT_EQUALS(uint(srgbMip[3]), 255u);
+
+	output.PrintLine("Цвет прозрачных пикселей не попадает в результат при умножении на альфу.");
+	const byte redAndClear[] = {255, 0, 0, 255, 0, 255, 0, 0};
+	INTRA_ASSERT(ResampleImage(CSpanOf(redAndClear), {2, 1}, SpanOf(one), {1, 1}, ImageFormat::RGBA8, 1, box));
+	INTRA_ASSERT_EQUALS(uint(one[1]), 128u);
+	box.PremultiplyAlpha = true;
+	INTRA_ASSERT(ResampleImage(CSpanOf(redAndClear), {2, 1}, SpanOf(one), {1, 1}, ImageFormat::RGBA8, 1, box));
+	INTRA_ASSERT_EQUALS(uint(one[0]), 255u);
+	INTRA_ASSERT_EQUALS(uint(one[1]), 0u);
+	INTRA_ASSERT_EQUALS(uint(one[3]), 128u);
+
+	output.PrintLine("Полная цепочка мип-уровней однотонного массива текстур сохраняет цвет при любом фильтре.");
+	CheckConstantMipmaps(ResampleFilter::Box, false);
+	CheckConstantMipmaps(ResampleFilter::Lanczos3, true);
+	CheckConstantMipmaps(ResampleFilter::Kaiser, true);
+
+	AnyImage compressed({4, 4, 1}, ImageFormat::DXT1_RGB);
+	compressed.Data.SetCount(8);
+	INTRA_ASSERT(!GenerateMipmaps(compressed));
+}
@@ -0,0 +1,163 @@
+#include "Memory.h"
+
+#include "Memory/Allocator/ThreadCaching.h"
+#include "Memory/Allocator/Basic/Arena.h"
+#include "Container/Sequential/List.h"
+#include "Container/Associative/HashMap.h"
+#include "Concurrency/Thread.h"
+#include "Container/Sequential/Array.h"
+#include "Random/FastUniform.h"
+#include "Utils/Debug.h"
+
+using namespace Intra;
+
+typedef Memory::ThreadCachingAllocator TCA;
+
+static size_t TestSizeOfBlock(uint i)
+{
+	static const size_t sizes[] = {1, 8, 24, 32, 33, 100, 500, 4000, 16384, 16385, 100000};
+	return sizes[i % (sizeof(sizes)/sizeof(sizes[0]))];
+}
+
+static void TestFillBlock(byte* block, size_t size, byte tag)
+{
+	for(size_t i = 0; i < size; i++) block[i] = byte(tag + i);
+}
+
+static bool TestCheckBlock(const byte* block, size_t size, byte tag)
+{
+	for(size_t i = 0; i < size; i++) if(block[i] != byte(tag + i)) return false;
+	return true;
+}
+
+struct TestBlock
+{
+	byte* Data;
+	size_t Size;
+	byte Tag;
+};
+
+static void TestAllocateBlocks(Array<TestBlock>& blocks, uint count, uint seed)
+{
+	Random::FastUniform<uint> random(seed);
+	for(uint i = 0; i < count; i++)
+	{
+		size_t size = TestSizeOfBlock(random());
+		const size_t requested = size;
+		byte* const data = TCA::Allocate(size, INTRA_SOURCE_INFO);
+		INTRA_ASSERT(data != null);
+		INTRA_ASSERT(size >= requested);
+		INTRA_ASSERT_EQUALS(TCA::GetAllocationSize(data), size);
+		INTRA_ASSERT_EQUALS(reinterpret_cast<size_t>(data) % TCA::GetAlignment(), 0u);
+		const byte tag = byte(random());
+		TestFillBlock(data, size, tag);
+		blocks.AddLast({data, size, tag});
+	}
+}
+
+static void TestFreeBlocks(CSpan<TestBlock> blocks)
+{
+	for(const TestBlock& block: blocks)
+	{
+		INTRA_ASSERT(TestCheckBlock(block.Data, block.Size, block.Tag));
+		TCA::Free(block.Data, 0);
+	}
+}
+
+void TestThreadCachingAllocator(FormattedWriter& output)
+{
+	(void)output;
+	Array<TestBlock> blocks;
+	TestAllocateBlocks(blocks, 5000, 1);
+	TestFreeBlocks(blocks);
+	blocks.Clear();
+	TestAllocateBlocks(blocks, 5000, 2);
+	TestFreeBlocks(blocks);
+	TCA::ReleaseThreadCache();
+
+#if(INTRA_LIBRARY_THREAD != INTRA_LIBRARY_THREAD_None)
+	// Every thread allocates its own blocks and frees blocks allocated by its neighbour.
+	enum: uint {ThreadCount = 4, BlocksPerRound = 2000, Rounds = 3};
+	Array<TestBlock> threadBlocks[ThreadCount];
+	for(uint round = 0; round < Rounds; round++)
+	{
+		Array<Thread> threads;
+		for(uint t = 0; t < ThreadCount; t++)
+		{
+			threads.AddLast(Thread("TCA test", [&threadBlocks, t]() {
+				Array<TestBlock>& foreign = threadBlocks[(t + 1) % ThreadCount];
+				TestFreeBlocks(foreign);
+				foreign.Clear();
+			}));
+		}
+		for(Thread& thread: threads) thread.Join();
+		threads.Clear();
+		for(uint t = 0; t < ThreadCount; t++)
+		{
+			threads.AddLast(Thread("TCA test", [&threadBlocks, t, round]() {
+				TestAllocateBlocks(threadBlocks[t], BlocksPerRound, t*100 + round);
+			}));
+		}
+		for(Thread& thread: threads) thread.Join();
+	}
+	for(auto& arr: threadBlocks) TestFreeBlocks(arr);
+#endif
+}
+
+void TestVirtualArena(FormattedWriter& output)
+{
+	Memory::AVirtualArena arena(64 << 20);
+	INTRA_ASSERT_EQUALS(arena.ReservedBytes(), size_t(64 << 20));
+	INTRA_ASSERT_EQUALS(arena.CommittedBytes(), 0u);
+
+	size_t bytes = 100;
+	byte* const first = arena.Allocate(bytes, INTRA_SOURCE_INFO);
+	INTRA_ASSERT(first != null);
+	INTRA_ASSERT_EQUALS(reinterpret_cast<size_t>(first) % arena.GetAlignment(), 0u);
+	TestFillBlock(first, bytes, 7);
+
+	// Mark and rewind reuse the same addresses
+	const auto mark = arena.GetMark();
+	size_t bigBytes = 3 << 20;
+	byte* const big = arena.Allocate(bigBytes, INTRA_SOURCE_INFO);
+	INTRA_ASSERT(big != null);
+	TestFillBlock(big, bigBytes, 3);
+	INTRA_ASSERT(arena.CommittedBytes() >= arena.UsedBytes());
+	arena.Rewind(mark);
+	size_t againBytes = 16;
+	INTRA_ASSERT_EQUALS(static_cast<byte*>(arena.Allocate(againBytes, INTRA_SOURCE_INFO)), big);
+
+	// Free releases only the last block
+	size_t lastBytes = 48;
+	void* const last = arena.Allocate(lastBytes, INTRA_SOURCE_INFO);
+	const size_t usedBeforeFree = arena.UsedBytes();
+	arena.Free(last, lastBytes);
+	INTRA_ASSERT_EQUALS(arena.UsedBytes(), usedBeforeFree - lastBytes);
+
+	{
+		Memory::AVirtualArena::Scope scope(arena);
+		BList<int, Memory::AVirtualArena> list(arena);
+		HashMap<int, int, Memory::AVirtualArena> map(arena);
+		for(int i = 0; i < 1000; i++)
+		{
+			list.AddLast(i);
+			map[i] = i*i;
+		}
+		INTRA_ASSERT_EQUALS(list.Last(), 999);
+		INTRA_ASSERT_EQUALS(map[30], 900);
+		output.PrintLine("Arena bytes used by a list and a map of 1000 elements: ", arena.UsedBytes() - usedBeforeFree);
+	}
+	INTRA_ASSERT(TestCheckBlock(first, 100, 7));
+	INTRA_ASSERT_EQUALS(arena.UsedBytes(), usedBeforeFree - lastBytes);
+
+	// Allocations beyond the reservation fail without touching the arena
+	size_t hugeBytes = 65 << 20;
+	INTRA_ASSERT(arena.Allocate(hugeBytes, INTRA_SOURCE_INFO) == null);
+
+	arena.Reset();
+	INTRA_ASSERT_EQUALS(arena.UsedBytes(), 0u);
+	arena.ReleaseUnusedPages();
+	INTRA_ASSERT_EQUALS(arena.CommittedBytes(), 0u);
+	size_t afterResetBytes = 10;
+	INTRA_ASSERT_EQUALS(static_cast<byte*>(arena.Allocate(afterResetBytes, INTRA_SOURCE_INFO)), first);
+}
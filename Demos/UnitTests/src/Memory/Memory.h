@@ -0,0 +1,6 @@
+#pragma once
+
+#include "IO/FormattedWriter.h"
+
+void TestThreadCachingAllocator(Intra::FormattedWriter& output);
+void TestVirtualArena(Intra::FormattedWriter& output);
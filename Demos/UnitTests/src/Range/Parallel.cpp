@@ -0,0 +1,53 @@
+﻿#include "Range.h"
+
+#include "Cpp/Warnings.h"
+
+INTRA_PUSH_DISABLE_REDUNDANT_WARNINGS
+
+#include "Range/Parallel.h"
+#include "Container/Sequential/Array.h"
+#include "IO/FormattedWriter.h"
+#include "Utils/Debug.h"
+
+using namespace Intra;
+using namespace IO;
+using namespace Range;
+
+
+void TestParallelRange(FormattedWriter& output)
+{
+	ThreadPool pool(3);
+
+	Array<int> arr;
+	arr.SetCount(100000, 0);
+	ParallelForEach(pool, arr, [](int& x) {x++;});
+	for(int x: arr) INTRA_ASSERT_EQUALS(x, 1);
+
+	ParallelTransform(pool, arr, [](int x) {return x*3;});
+	for(int x: arr) INTRA_ASSERT_EQUALS(x, 3);
+
+	Array<long64> squares;
+	squares.SetCount(arr.Count(), 0);
+	for(size_t i = 0; i < arr.Count(); i++) arr[i] = int(i);
+	const size_t written = ParallelTransformTo(pool, arr, squares, [](int x) {return long64(x)*x;});
+	INTRA_ASSERT_EQUALS(written, arr.Count());
+	for(size_t i = 0; i < squares.Count(); i++) INTRA_ASSERT_EQUALS(squares[i], long64(i)*long64(i));
+
+	// the sum doesn't fit into int, so elements are added to long64 and partial sums are combined separately
+	const long64 sum = ParallelReduce(pool, arr, [](long64 a, int x) {return a + x;}, long64(0),
+		[](long64 a, long64 b) {return a + b;});
+	INTRA_ASSERT_EQUALS(sum, long64(arr.Count())*long64(arr.Count() - 1)/2);
+	output.PrintLine("Sum of ", arr.Count(), " first integers computed in parallel: ", sum);
+
+	// counting odd elements: func can't combine partial counts, combine does it
+	const size_t oddCount = ParallelReduce(pool, arr, [](size_t n, int x) {return n + size_t(x & 1);}, size_t(0),
+		[](size_t a, size_t b) {return a + b;});
+	INTRA_ASSERT_EQUALS(oddCount, arr.Count()/2);
+
+	// the range is shorter than the grain, so the calling thread reduces it alone
+	const int smallSum = ParallelReduce(CSpan<int>(arr).Take(10), [](int a, int b) {return a + b;}, 0);
+	INTRA_ASSERT_EQUALS(smallSum, 45);
+}
+
+
+INTRA_WARNING_POP
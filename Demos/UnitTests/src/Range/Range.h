@@ -8,3 +8,4 @@ void TestStreamRange(Intra::IO::FormattedWriter& output);
 void TestRangeStlInterop(Intra::IO::FormattedWriter& output);
 void TestUnicodeConversion(Intra::IO::FormattedWriter& output);
 void TestHeap(Intra::IO::FormattedWriter& output);
+void TestParallelRange(Intra::IO::FormattedWriter& output);
@@ -7,6 +7,8 @@ INTRA_PUSH_DISABLE_REDUNDANT_WARNINGS
 #include "Container/Sequential/Array.h"
 #include "IO/FormattedWriter.h"
 #include "Utils/Debug.h"
+#include "Random/FastUniform.h"
+#include "Concurrency/ThreadPool.h"
 
 
 INTRA_PUSH_DISABLE_ALL_WARNINGS
@@ -15,6 +17,84 @@ INTRA_WARNING_POP
 
 using namespace Intra;
 
+template<typename T> static void testRadixSortOf(IO::FormattedWriter& output, const char* typeName, const Array<T>& arrUnsorted)
+{
+	Array<T> arrStdSort = arrUnsorted;
+	std::sort(arrStdSort.begin(), arrStdSort.end());
+
+	Array<T> arrRadix = arrUnsorted;
+	Range::RadixSort(arrRadix.AsRange());
+	INTRA_ASSERT(arrRadix == arrStdSort);
+
+	ThreadPool pool(3);
+	Array<T> arrParallelRadix = arrUnsorted;
+	Range::ParallelRadixSort(pool, arrParallelRadix.AsRange(), Range::D::TExtractKey(), 1000);
+	INTRA_ASSERT(arrParallelRadix == arrStdSort);
+
+	output.PrintLine("RadixSort and ParallelRadixSort sorted ", arrUnsorted.Count(), " values of type ", typeName);
+}
+
+static void testRadixSort(IO::FormattedWriter& output)
+{
+	enum: size_t {Count = 100000};
+	Random::FastUniform<uint> rand(12345);
+	Random::FastUniform<float> frand(54321);
+
+	// only two lower bytes differ, so the passes over the upper ones are skipped
+	Array<int> ints;
+	for(size_t i = 0; i < Count; i++) ints.AddLast(int(rand(65536)));
+	testRadixSortOf(output, "int", ints);
+
+	// negative values flip the sign bit of the key, so all passes are needed
+	Array<int> signedInts;
+	for(size_t i = 0; i < Count; i++) signedInts.AddLast(int(rand(65536)) - 32768);
+	testRadixSortOf(output, "signed int", signedInts);
+
+	Array<ulong64> longs;
+	for(size_t i = 0; i < Count; i++) longs.AddLast(ulong64(rand()) << 32 | rand());
+	testRadixSortOf(output, "ulong64", longs);
+
+	Array<float> floats;
+	for(size_t i = 0; i < Count; i++) floats.AddLast((frand() - 0.5f)*1000);
+	testRadixSortOf(output, "float", floats);
+
+	Array<double> doubles;
+	for(size_t i = 0; i < Count; i++) doubles.AddLast(double(frand() - 0.5f)*1e10);
+	testRadixSortOf(output, "double", doubles);
+
+	Array<uint> equal;
+	equal.SetCount(Count, 7u);
+	testRadixSortOf(output, "uint", equal);
+}
+
+static void testParallelSorts(IO::FormattedWriter& output)
+{
+	enum: size_t {Count = 200000};
+	ThreadPool pool(3);
+	Random::FastUniform<uint> rand(777);
+
+	Array<int> arrUnsorted;
+	for(size_t i = 0; i < Count; i++) arrUnsorted.AddLast(int(rand()));
+	Array<int> arrStdSort = arrUnsorted;
+	std::sort(arrStdSort.begin(), arrStdSort.end());
+
+	Array<int> arrQuick = arrUnsorted;
+	Range::ParallelQuickSort(pool, arrQuick);
+	INTRA_ASSERT(arrQuick == arrStdSort);
+
+	Array<int> arrMerge = arrUnsorted;
+	Range::ParallelMergeSort(pool, arrMerge);
+	INTRA_ASSERT(arrMerge == arrStdSort);
+
+	// few distinct keys: the original index must stay in ascending order for equal keys
+	Array<ulong64> keyIndexPairs;
+	for(size_t i = 0; i < Count; i++) keyIndexPairs.AddLast(ulong64(rand(16)) << 32 | i);
+	Range::ParallelMergeSort(pool, keyIndexPairs, [](ulong64 a, ulong64 b) {return (a >> 32) < (b >> 32);});
+	INTRA_ASSERT(Range::IsSorted(keyIndexPairs));
+
+	output.PrintLine("ParallelQuickSort and ParallelMergeSort sorted ", size_t(Count), " values");
+}
+
 static const short arrayForSortTesting[] = {
 	2, 4234, -9788, 23, 5, 245, 2, 24, 5, -9890,
 	2, 5, 4552, 54, 3, -932, 123, 342, 24321, -234
@@ -53,12 +133,14 @@ void TestSort(IO::FormattedWriter& output)
 	output.PrintLine("RadixSort'ed array: ", arrRadix);
 	INTRA_ASSERT_EQUALS(arrRadix, arrStdSort);
 	INTRA_ASSERT1(Range::IsSorted(arrRadix), arrRadix);
+	testRadixSort(output);
 	
 	Array<short> arrMerge = arrUnsorted;
 	Range::MergeSort(arrMerge);
 	output.PrintLine("MergeSort'ed array: ", arrMerge);
 	INTRA_ASSERT_EQUALS(arrMerge, arrStdSort);
 	INTRA_ASSERT1(Range::IsSorted(arrMerge), arrMerge);
+	testParallelSorts(output);
 	
 	Array<short> arrHeap = arrUnsorted;
 	Range::HeapSort(arrHeap);
@@ -17,12 +17,17 @@ INTRA_DISABLE_REDUNDANT_WARNINGS
 #include "IO/FormattedLogger.h"
 
 #include "Sort.h"
+#include "Hash.h"
 #include "Range/Range.h"
 #include "IO/IO.h"
 #include "Serialization.h"
 #include "Container/HashMap.h"
+#include "Container/StructureOfArrays.h"
 
 #include "Concurrency/Concurrency.h"
+#include "Memory/Memory.h"
+#include "Audio/Audio.h"
+#include "Image/Image.h"
 
 using namespace Intra;
 using namespace IO;
@@ -85,12 +90,15 @@ int main(int argc, const char* argv[])
 		TestGroup("STL and ranges interoperability", TestRangeStlInterop);
 		TestGroup("Unicode encoding conversions", TestUnicodeConversion);
 		TestGroup("Heap algorithms", TestHeap);
+		TestGroup("Parallel range algorithms", TestParallelRange);
 	}
 	if(TestGroup gr{&logger, output, "Containers"})
 	{
 		TestGroup("Sparse Range", TestSparseRange);
 		TestGroup("Sparse Array", TestSparseArray);
 		TestGroup("Map", TestMaps);
+		TestGroup("Flat hash map", TestFlatHashMap);
+		TestGroup("Structure of arrays", TestStructureOfArrays);
 	}
 	if(TestGroup gr{&logger, output, "IO"})
 	{
@@ -103,6 +111,33 @@ int main(int argc, const char* argv[])
 	TestGroup(&logger, output, "Text serialization", TestTextSerialization);
 	TestGroup(&logger, output, "Binary serialization", TestBinarySerialization);
 	TestGroup(&logger, output, "Sort algorithms", TestSort);
+	TestGroup(&logger, output, "Hash functions", TestHashFunctions);
+	if(TestGroup gr{&logger, output, "Memory"})
+	{
+		TestGroup("Thread-caching allocator", TestThreadCachingAllocator);
+		TestGroup("Virtual memory arena", TestVirtualArena);
+	}
+	if(TestGroup gr{&logger, output, "Audio"})
+	{
+		TestGroup("Fast Fourier transform", TestFFT);
+		TestGroup("Sample format conversion", TestSampleConversion);
+		TestGroup("Synthesizer filters", TestSynthFilters);
+		TestGroup("Convolution reverb", TestConvolutionReverb);
+		TestGroup("Polyphase resampler", TestPolyphaseResampler);
+		TestGroup("Wave table cache", TestWaveTableCache);
+		TestGroup("MIDI synthesizer voice pool", TestMidiSynthVoicePool);
+		TestGroup("Audio file sinks", TestAudioSinks);
+		TestGroup("Memory-mapped audio sources", TestAudioSourcesSeeking);
+		TestGroup("Parallel MIDI rendering", TestMidiParallelRender);
+	}
+	if(TestGroup gr{&logger, output, "Image"})
+	{
+		TestGroup("PNG loader", TestPngLoader);
+		TestGroup("JPEG loader", TestJpegLoader);
+		TestGroup("Pixel format conversion", TestPixelFormatConversion);
+		TestGroup("Resample", TestResample);
+		TestGroup("BlockCompression", TestBlockCompression);
+	}
 #if !defined(INTRA_NO_CONCURRENCY) && INTRA_LIBRARY_THREAD != INTRA_LIBRARY_THREAD_None
 	if(TestGroup gr{&logger, output, "Concurrency"})
 	{
@@ -110,6 +145,7 @@ int main(int argc, const char* argv[])
 		TestGroup("Atomics", TestAtomics);
 #endif
 		TestGroup("Thread interruption", TestInterruption);
+		TestGroup("Thread pool", TestThreadPool);
 	}
 #endif
 
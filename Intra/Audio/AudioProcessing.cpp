@@ -3,6 +3,11 @@
 #include "Math/Math.h"
 
 #include "Range/Mutation/Transform.h"
+#include "Range/Mutation/Fill.h"
+#include "Concurrency/Mutex.h"
+#include "Concurrency/Lock.h"
+#include "Utils/Unique.h"
+#include "Simd/Simd.h"
 
 INTRA_PUSH_DISABLE_REDUNDANT_WARNINGS
 
@@ -29,151 +34,379 @@ void DiscreteFourierTransform(Span<float> outFreqs, CSpan<short> samples)
     }
 }
 
-#if(INTRA_DISABLED)
+namespace {
 
-static void rearrangeData(Span<cfloat> data)
+forceinline void complexMul(float& re, float& im, float wr, float wi)
 {
-    size_t targetIndex = 0;
-	const size_t len = data.Length();
-    for(size_t i = 0; i < len; i++)
-    {
-		if(targetIndex > i) Cpp::Swap(data.Begin[targetIndex], data.Begin[i]);
-
-        size_t bitMask = len;
-        while(targetIndex & (bitMask >>= 1))
-            targetIndex &= ~bitMask;
-
-        targetIndex |= bitMask;
-    }
+	const float r = re*wr - im*wi;
+	im = re*wi + im*wr;
+	re = r;
 }
 
-#endif
+//! Шаг с основанием 2 с единичными множителями: пары соседних элементов.
+static void fftRadix2FirstPass(float* re, float* im, size_t n)
+{
+	for(size_t k = 0; k < n; k += 2)
+	{
+		const float ar = re[k], ai = im[k], br = re[k+1], bi = im[k+1];
+		re[k] = ar + br; im[k] = ai + bi;
+		re[k+1] = ar - br; im[k+1] = ai - bi;
+	}
+}
 
-static void rearrangeData(Span<float> real, Span<float> imag)
+//! Два шага с основанием 2 (половины q и 2q), объединённые в один проход по памяти.
+//! w1 = exp(-πi*j/q), w2 = exp(-πi*j/(2q)), множитель элемента j + q второго шага равен w2*(-i).
+static void fftRadix4PassScalar(float* re, float* im, size_t n, size_t q,
+	const float* w1r, const float* w1i, const float* w2r, const float* w2i)
 {
-	size_t targetIndex = 0;
-	const size_t len = real.Length();
-	for(size_t i = 0; i < len; i++)
+	for(size_t base = 0; base < n; base += 4*q)
 	{
-		if(targetIndex > i)
+		float* const r0 = re + base; float* const i0 = im + base;
+		float* const r1 = r0 + q; float* const i1 = i0 + q;
+		float* const r2 = r1 + q; float* const i2 = i1 + q;
+		float* const r3 = r2 + q; float* const i3 = i2 + q;
+		for(size_t j = 0; j < q; j++)
 		{
-			Cpp::Swap(real.Begin[targetIndex], real.Begin[i]);
-			Cpp::Swap(imag.Begin[targetIndex], imag.Begin[i]);
+			float t1r = r1[j], t1i = i1[j], t3r = r3[j], t3i = i3[j];
+			complexMul(t1r, t1i, w1r[j], w1i[j]);
+			complexMul(t3r, t3i, w1r[j], w1i[j]);
+			const float b0r = r0[j] + t1r, b0i = i0[j] + t1i;
+			const float b1r = r0[j] - t1r, b1i = i0[j] - t1i;
+			float b2r = r2[j] + t3r, b2i = i2[j] + t3i;
+			float b3r = r2[j] - t3r, b3i = i2[j] - t3i;
+			complexMul(b2r, b2i, w2r[j], w2i[j]);
+			complexMul(b3r, b3i, w2r[j], w2i[j]);
+			r0[j] = b0r + b2r; i0[j] = b0i + b2i;
+			r2[j] = b0r - b2r; i2[j] = b0i - b2i;
+			// умножение на -i: (x + iy)*(-i) = y - ix
+			r1[j] = b1r + b3i; i1[j] = b1i - b3r;
+			r3[j] = b1r - b3i; i3[j] = b1i + b3r;
 		}
-
-		size_t bitMask = len;
-		while(targetIndex & (bitMask >>= 1))
-			targetIndex &= ~bitMask;
-
-		targetIndex |= bitMask;
 	}
 }
 
-#if(INTRA_DISABLED)
+#if(INTRA_SIMD_SUPPORT >= INTRA_SIMD_SSE2 && INTRA_SIMD_SUPPORT <= INTRA_SIMD_AVX2)
 
-// Принимает phase = -PI для прямого FFT и +PI для обратного.
-static void makeTransform(Span<cfloat> data, float phase)
+forceinline void complexMul4(__m128& re, __m128& im, __m128 wr, __m128 wi)
 {
-	float nextSine = 0;
-    for(size_t i = 1; i < data.Length(); i <<= 1)
-    {
-        const size_t next = i << 1;
-		const float sine = nextSine;
-		phase *= 0.5f;
-		nextSine = Math::Sin(phase);
-		const cfloat mult = {-2*Math::Sqr(nextSine), sine};
-        cfloat factor = 1;
-        for(size_t j = 0; j < i; j++) // iterations through groups with different transform factors
-        {
-            for(size_t k = j; k < data.Length(); k += next) // iterations through pairs within group
-            {
-                const size_t match = k + i;
-				const cfloat product = data[match] * factor;
-				data[match] = data[k] - product;
-				data[k] += product;
-            }
-            factor = mult*factor + factor;
-        }
-    }
+	const __m128 r = _mm_sub_ps(_mm_mul_ps(re, wr), _mm_mul_ps(im, wi));
+	im = _mm_add_ps(_mm_mul_ps(re, wi), _mm_mul_ps(im, wr));
+	re = r;
+}
+
+//! То же, что fftRadix4PassScalar, для q, кратного 4: 4 соседних j обрабатываются одновременно.
+static void fftRadix4PassSse(float* re, float* im, size_t n, size_t q,
+	const float* w1r, const float* w1i, const float* w2r, const float* w2i)
+{
+	for(size_t base = 0; base < n; base += 4*q)
+	{
+		float* const r0 = re + base; float* const i0 = im + base;
+		float* const r1 = r0 + q; float* const i1 = i0 + q;
+		float* const r2 = r1 + q; float* const i2 = i1 + q;
+		float* const r3 = r2 + q; float* const i3 = i2 + q;
+		for(size_t j = 0; j < q; j += 4)
+		{
+			const __m128 v1r = _mm_loadu_ps(w1r + j), v1i = _mm_loadu_ps(w1i + j);
+			const __m128 v2r = _mm_loadu_ps(w2r + j), v2i = _mm_loadu_ps(w2i + j);
+			__m128 t1r = _mm_loadu_ps(r1 + j), t1i = _mm_loadu_ps(i1 + j);
+			__m128 t3r = _mm_loadu_ps(r3 + j), t3i = _mm_loadu_ps(i3 + j);
+			complexMul4(t1r, t1i, v1r, v1i);
+			complexMul4(t3r, t3i, v1r, v1i);
+			const __m128 a0r = _mm_loadu_ps(r0 + j), a0i = _mm_loadu_ps(i0 + j);
+			const __m128 a2r = _mm_loadu_ps(r2 + j), a2i = _mm_loadu_ps(i2 + j);
+			const __m128 b0r = _mm_add_ps(a0r, t1r), b0i = _mm_add_ps(a0i, t1i);
+			const __m128 b1r = _mm_sub_ps(a0r, t1r), b1i = _mm_sub_ps(a0i, t1i);
+			__m128 b2r = _mm_add_ps(a2r, t3r), b2i = _mm_add_ps(a2i, t3i);
+			__m128 b3r = _mm_sub_ps(a2r, t3r), b3i = _mm_sub_ps(a2i, t3i);
+			complexMul4(b2r, b2i, v2r, v2i);
+			complexMul4(b3r, b3i, v2r, v2i);
+			_mm_storeu_ps(r0 + j, _mm_add_ps(b0r, b2r)); _mm_storeu_ps(i0 + j, _mm_add_ps(b0i, b2i));
+			_mm_storeu_ps(r2 + j, _mm_sub_ps(b0r, b2r)); _mm_storeu_ps(i2 + j, _mm_sub_ps(b0i, b2i));
+			_mm_storeu_ps(r1 + j, _mm_add_ps(b1r, b3i)); _mm_storeu_ps(i1 + j, _mm_sub_ps(b1i, b3r));
+			_mm_storeu_ps(r3 + j, _mm_sub_ps(b1r, b3i)); _mm_storeu_ps(i3 + j, _mm_add_ps(b1i, b3r));
+		}
+	}
 }
 
 #endif
 
-// Принимает phase = -PI для прямого FFT и +PI для обратного.
-static void makeTransform(Span<float> real, Span<float> imag, float phase)
+}
+
+FFTPlan::FFTPlan(size_t size):
+	mSize(size), mTempLength(0), mConvolutionPlan(null), mHalfPlan(null)
 {
-	float nextSine = 0;
-	for(size_t i = 1; i < real.Length(); i <<= 1)
+	if(size <= 1) return;
+	if(Math::IsPow2(size))
 	{
-		const size_t next = i << 1;
-		const float multImag = nextSine;
-		phase *= 0.5f;
-		nextSine = Math::Sin(phase);
-		const float multReal = -2*Math::Sqr(nextSine);
-		float factorReal = 1, factorImag = 0;
-		for(size_t j = 0; j < i; j++) // iterations through groups with different transform factors
+		mTwiddleReal.SetCountUninitialized(size - 1);
+		mTwiddleImag.SetCountUninitialized(size - 1);
+		for(size_t h = 1; h < size; h *= 2)
 		{
-			for(size_t k = j; k < real.Length(); k += next) // iterations through pairs within group
+			for(size_t j = 0; j < h; j++)
 			{
-				const size_t match = k + i;
-				const float productReal = real[match] * factorReal - imag[match] * factorImag;
-				const float productImag = imag[match] * factorReal + real[match] * factorImag;
-				real[match] = real[k] - productReal;
-				imag[match] = imag[k] - productImag;
-				real[k] += productReal;
-				imag[k] += productImag;
+				const double angle = -Math::PI*double(j)/double(h);
+				mTwiddleReal[h - 1 + j] = float(Math::Cos(angle));
+				mTwiddleImag[h - 1 + j] = float(Math::Sin(angle));
 			}
-			const float oldFactorReal = factorReal;
-			factorReal = (multReal + 1)*factorReal - multImag*factorImag;
-			factorImag = (multReal + 1)*factorImag + multImag*oldFactorReal;
 		}
+
+		size_t bits = 0;
+		while((size_t(1) << bits) < size) bits++;
+		Array<uint> reversed;
+		reversed.SetCountUninitialized(size);
+		reversed[0] = 0;
+		for(size_t i = 1; i < size; i++)
+		{
+			reversed[i] = uint((reversed[i >> 1] >> 1) | ((i & 1) << (bits - 1)));
+			if(i < reversed[i])
+			{
+				mSwaps.AddLast(uint(i));
+				mSwaps.AddLast(reversed[i]);
+			}
+		}
+	}
+	else
+	{
+		size_t convSize = 1;
+		while(convSize < 2*size - 1) convSize *= 2;
+		mConvolutionPlan = &Get(convSize);
+		mTempLength = 2*convSize;
+
+		mChirpReal.SetCountUninitialized(size);
+		mChirpImag.SetCountUninitialized(size);
+		mKernelReal.SetCount(convSize);
+		mKernelImag.SetCount(convSize);
+		for(size_t i = 0; i < size; i++)
+		{
+			// n² берётся по модулю 2N, чтобы угол не терял точность при больших n
+			const ulong64 sqr = ulong64(i)*ulong64(i) % ulong64(2*size);
+			const double angle = -Math::PI*double(sqr)/double(size);
+			mChirpReal[i] = float(Math::Cos(angle));
+			mChirpImag[i] = float(Math::Sin(angle));
+			mKernelReal[i] = mChirpReal[i];
+			mKernelImag[i] = -mChirpImag[i];
+			if(i != 0)
+			{
+				mKernelReal[convSize - i] = mKernelReal[i];
+				mKernelImag[convSize - i] = mKernelImag[i];
+			}
+		}
+		mConvolutionPlan->Forward(mKernelReal, mKernelImag);
+		Multiply(mKernelReal.AsRange(), 1.0f/float(convSize));
+		Multiply(mKernelImag.AsRange(), 1.0f/float(convSize));
+	}
+
+	if(size % 2 == 0)
+	{
+		mHalfPlan = &Get(size / 2);
+		const size_t quarter = size / 4;
+		mRealTwiddleReal.SetCountUninitialized(quarter + 1);
+		mRealTwiddleImag.SetCountUninitialized(quarter + 1);
+		for(size_t k = 0; k <= quarter; k++)
+		{
+			const double angle = -2*Math::PI*double(k)/double(size);
+			mRealTwiddleReal[k] = float(Math::Cos(angle));
+			mRealTwiddleImag[k] = float(Math::Sin(angle));
+		}
+		const size_t realTempLength = size + mHalfPlan->TempLength();
+		if(mTempLength < realTempLength) mTempLength = realTempLength;
+	}
+}
+
+const FFTPlan& FFTPlan::Get(size_t size)
+{
+	static Array<Unique<FFTPlan>> plans;
+#if(INTRA_LIBRARY_MUTEX != INTRA_LIBRARY_MUTEX_None)
+	// Рекурсивный, потому что конструктор плана запрашивает из кэша вспомогательные планы
+	static RecursiveMutex mutex;
+	auto locker = Concurrency::MakeLock(mutex);
+#endif
+	for(auto& plan: plans)
+		if(plan->mSize == size) return *plan;
+	FFTPlan* const plan = new FFTPlan(size);
+	plans.AddLast(plan);
+	return *plan;
+}
+
+void FFTPlan::forwardPow2(Span<float> real, Span<float> imag) const
+{
+	float* const re = real.Data();
+	float* const im = imag.Data();
+	const size_t n = mSize;
+
+	for(const uint* swap = mSwaps.Data(), *swapsEnd = swap + mSwaps.Length(); swap != swapsEnd; swap += 2)
+	{
+		Cpp::Swap(re[swap[0]], re[swap[1]]);
+		Cpp::Swap(im[swap[0]], im[swap[1]]);
+	}
+
+	size_t q = 1;
+	if((n & size_t(0xAAAAAAAAAAAAAAAAull)) != 0) // нечётная степень двойки - один шаг с основанием 2 остаётся лишним
+	{
+		fftRadix2FirstPass(re, im, n);
+		q = 2;
+	}
+	for(; 4*q <= n; q *= 4)
+	{
+		const float* const w1r = mTwiddleReal.Data() + (q - 1);
+		const float* const w1i = mTwiddleImag.Data() + (q - 1);
+		const float* const w2r = mTwiddleReal.Data() + (2*q - 1);
+		const float* const w2i = mTwiddleImag.Data() + (2*q - 1);
+#if(INTRA_SIMD_SUPPORT >= INTRA_SIMD_SSE2 && INTRA_SIMD_SUPPORT <= INTRA_SIMD_AVX2)
+		if(q >= 4)
+		{
+			fftRadix4PassSse(re, im, n, q, w1r, w1i, w2r, w2i);
+			continue;
+		}
+#endif
+		fftRadix4PassScalar(re, im, n, q, w1r, w1i, w2r, w2i);
 	}
 }
 
-#if(INTRA_DISABLED)
+void FFTPlan::forwardBluestein(Span<float> real, Span<float> imag, Span<float> temp) const
+{
+	const size_t n = mSize;
+	const size_t convSize = mConvolutionPlan->Size();
+	Span<float> ar = temp.Take(convSize), ai = temp.Drop(convSize).Take(convSize);
+	for(size_t i = 0; i < n; i++)
+	{
+		float r = real[i], im = imag[i];
+		complexMul(r, im, mChirpReal[i], mChirpImag[i]);
+		ar[i] = r;
+		ai[i] = im;
+	}
+	FillZeros(ar.Drop(n));
+	FillZeros(ai.Drop(n));
+
+	mConvolutionPlan->Forward(ar, ai);
+	for(size_t i = 0; i < convSize; i++) complexMul(ar[i], ai[i], mKernelReal[i], mKernelImag[i]);
+	mConvolutionPlan->InverseNonNormalized(ar, ai);
+
+	for(size_t i = 0; i < n; i++)
+	{
+		float r = ar[i], im = ai[i];
+		complexMul(r, im, mChirpReal[i], mChirpImag[i]);
+		real[i] = r;
+		imag[i] = im;
+	}
+}
 
-bool InplaceFFT(Span<cfloat> data)
+void FFTPlan::Forward(Span<float> real, Span<float> imag, Span<float> temp) const
 {
-	INTRA_DEBUG_ASSERT(Math::IsPow2(data.Length()));
-	rearrangeData(data);
-	makeTransform(data, -Math::PI);
+	INTRA_DEBUG_ASSERT(real.Length() == mSize && imag.Length() == mSize);
+	if(mSize <= 1) return;
+	if(mConvolutionPlan == null)
+	{
+		forwardPow2(real, imag);
+		return;
+	}
+	Array<float> tempBuffer;
+	if(temp.Length() < 2*mConvolutionPlan->Size()) tempBuffer.SetCountUninitialized(2*mConvolutionPlan->Size());
+	forwardBluestein(real, imag, tempBuffer.Empty()? temp: tempBuffer.AsRange());
 }
 
-bool InplaceInverseFFT(Span<cfloat> data)
+void FFTPlan::Inverse(Span<float> real, Span<float> imag, Span<float> temp) const
 {
-	INTRA_DEBUG_ASSERT(Math::IsPow2(data.Length()));
-	rearrangeData(data);
-	makeTransform(data, Math::PI);
-	Multiply(data.Reinterpret<float>(), 1.0f/data.Length());
+	InverseNonNormalized(real, imag, temp);
+	Multiply(real, 1.0f/float(mSize));
+	Multiply(imag, 1.0f/float(mSize));
 }
 
-#endif
+void FFTPlan::ForwardReal(CSpan<float> samples, Span<float> outReal, Span<float> outImag, Span<float> temp) const
+{
+	INTRA_DEBUG_ASSERT(mHalfPlan != null);
+	INTRA_DEBUG_ASSERT(samples.Length() == mSize);
+	INTRA_DEBUG_ASSERT(outReal.Length() >= mSize/2 + 1 && outImag.Length() >= mSize/2 + 1);
+	const size_t half = mSize / 2;
+
+	// Чётные семплы становятся действительными частями, нечётные - мнимыми
+	for(size_t i = 0; i < half; i++)
+	{
+		outReal[i] = samples[2*i];
+		outImag[i] = samples[2*i + 1];
+	}
+	mHalfPlan->Forward(outReal.Take(half), outImag.Take(half), temp);
+
+	// Разделяем спектры чётной (E) и нечётной (O) частей: X[k] = E[k] + W^k*O[k], X[N/2 - k] = conj(E[k] - W^k*O[k])
+	const float z0r = outReal[0], z0i = outImag[0];
+	outReal[0] = z0r + z0i;
+	outImag[0] = 0;
+	outReal[half] = z0r - z0i;
+	outImag[half] = 0;
+	for(size_t k = 1; 2*k <= half; k++)
+	{
+		const size_t m = half - k;
+		const float ar = outReal[k], ai = outImag[k], br = outReal[m], bi = outImag[m];
+		const float er = 0.5f*(ar + br), ei = 0.5f*(ai - bi);
+		float or_ = 0.5f*(ai + bi), oi = -0.5f*(ar - br);
+		complexMul(or_, oi, mRealTwiddleReal[k], mRealTwiddleImag[k]);
+		outReal[k] = er + or_;
+		outImag[k] = ei + oi;
+		outReal[m] = er - or_;
+		outImag[m] = oi - ei;
+	}
+}
+
+void FFTPlan::InverseRealNonNormalized(CSpan<float> real, CSpan<float> imag, Span<float> outSamples, Span<float> temp) const
+{
+	INTRA_DEBUG_ASSERT(mHalfPlan != null);
+	INTRA_DEBUG_ASSERT(outSamples.Length() == mSize);
+	INTRA_DEBUG_ASSERT(real.Length() >= mSize/2 + 1 && imag.Length() >= mSize/2 + 1);
+	const size_t half = mSize / 2;
+
+	Array<float> tempBuffer;
+	if(temp.Length() < mTempLength) tempBuffer.SetCountUninitialized(mTempLength);
+	const Span<float> work = tempBuffer.Empty()? temp: tempBuffer.AsRange();
+	const Span<float> zr = work.Take(half), zi = work.Drop(half).Take(half);
+
+	// Собираем спектр Z = 2*(E + i*O) комплексного сигнала z[n] = x[2n] + i*x[2n+1]
+	zr[0] = real[0] + real[half];
+	zi[0] = real[0] - real[half];
+	for(size_t k = 1; 2*k <= half; k++)
+	{
+		const size_t m = half - k;
+		const float ar = real[k], ai = imag[k], br = real[m], bi = imag[m];
+		const float er = ar + br, ei = ai - bi;
+		float or_ = ar - br, oi = ai + bi;
+		complexMul(or_, oi, mRealTwiddleReal[k], -mRealTwiddleImag[k]);
+		zr[k] = er - oi;
+		zi[k] = ei + or_;
+		zr[m] = er + oi;
+		zi[m] = or_ - ei;
+	}
+	mHalfPlan->InverseNonNormalized(zr, zi, work.Drop(mSize));
+
+	for(size_t i = 0; i < half; i++)
+	{
+		outSamples[2*i] = zr[i];
+		outSamples[2*i + 1] = zi[i];
+	}
+}
+
+void FFTPlan::InverseReal(CSpan<float> real, CSpan<float> imag, Span<float> outSamples, Span<float> temp) const
+{
+	InverseRealNonNormalized(real, imag, outSamples, temp);
+	Multiply(outSamples, 1.0f/float(mSize));
+}
 
 void InplaceFFT(Span<float> real, Span<float> imag)
 {
 	INTRA_DEBUG_ASSERT(real.Length() == imag.Length());
-	INTRA_DEBUG_ASSERT(Math::IsPow2(real.Length()));
-	rearrangeData(real, imag);
-	makeTransform(real, imag, float(-Math::PI));
+	FFTPlan::Get(real.Length()).Forward(real, imag);
 }
 
 void InplaceInverseFFTNonNormalized(Span<float> real, Span<float> imag)
 {
 	INTRA_DEBUG_ASSERT(real.Length() == imag.Length());
-	INTRA_DEBUG_ASSERT(Math::IsPow2(real.Length()));
-	rearrangeData(real, imag);
-	makeTransform(real, imag, float(Math::PI));
+	FFTPlan::Get(real.Length()).InverseNonNormalized(real, imag);
 }
 
 void InplaceInverseFFT(Span<float> real, Span<float> imag)
 {
-	InplaceInverseFFTNonNormalized(real, imag);
-	Multiply(imag, 1.0f/float(real.Length()));
-	Multiply(real, 1.0f/float(real.Length()));
+	INTRA_DEBUG_ASSERT(real.Length() == imag.Length());
+	FFTPlan::Get(real.Length()).Inverse(real, imag);
 }
 
-
-
 }}
 
 INTRA_WARNING_POP
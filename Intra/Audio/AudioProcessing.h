@@ -1,11 +1,75 @@
 ﻿#pragma once
 
 #include "Utils/Span.h"
+#include "Container/Sequential/Array.h"
 
 namespace Intra { namespace Audio {
 
 void DiscreteFourierTransform(Span<float> outFreqs, CSpan<short> samples);
 
+//! План быстрого преобразования Фурье фиксированного размера над комплексными числами, разделёнными на действительные и мнимые части.
+//! Таблицы поворачивающих множителей и перестановки вычисляются один раз при создании плана.
+//! Степени двойки обрабатываются итеративным алгоритмом с основанием 4 (при нечётном логарифме размера - с одним шагом с основанием 2),
+//! остальные размеры - алгоритмом Блюстейна через циклическую свёртку размера степени двойки.
+//! Преобразования действительных сигналов чётного размера N выполняются через комплексное преобразование размера N/2.
+//! Все методы константны, поэтому один план можно использовать из нескольких потоков одновременно.
+//! Параметр temp - необязательный временный буфер длиной не менее TempLength(). Если он короче, буфер выделяется на время вызова.
+class FFTPlan
+{
+public:
+	explicit FFTPlan(size_t size);
+
+	//! Общий план размера size из потокобезопасного кэша. Планы из кэша не удаляются до завершения программы.
+	static const FFTPlan& Get(size_t size);
+
+	forceinline size_t Size() const {return mSize;}
+
+	//! Минимальная длина временного буфера, при которой ни один из методов не выделяет память.
+	forceinline size_t TempLength() const {return mTempLength;}
+
+	//! Прямое преобразование: X[k] = Σ x[n]*exp(-2πi*n*k/N).
+	void Forward(Span<float> real, Span<float> imag, Span<float> temp = null) const;
+
+	//! Обратное преобразование без деления на Size().
+	forceinline void InverseNonNormalized(Span<float> real, Span<float> imag, Span<float> temp = null) const {Forward(imag, real, temp);}
+
+	void Inverse(Span<float> real, Span<float> imag, Span<float> temp = null) const;
+
+	//! Прямое преобразование Size() действительных семплов в Size()/2 + 1 комплексных амплитуд. Size() должен быть чётным.
+	void ForwardReal(CSpan<float> samples, Span<float> outReal, Span<float> outImag, Span<float> temp = null) const;
+
+	//! Обратное к ForwardReal преобразование Size()/2 + 1 амплитуд в Size() семплов, умноженных на Size().
+	//! Мнимые части первой и последней амплитуд игнорируются.
+	//! outSamples может перекрываться с real и imag: входные данные полностью считываются до записи результата.
+	void InverseRealNonNormalized(CSpan<float> real, CSpan<float> imag, Span<float> outSamples, Span<float> temp = null) const;
+
+	void InverseReal(CSpan<float> real, CSpan<float> imag, Span<float> outSamples, Span<float> temp = null) const;
+
+private:
+	size_t mSize, mTempLength;
+
+	//! Для степеней двойки: множители exp(-πi*j/h) всех шагов h = 1, 2, 4, ..., N/2 подряд, шаг h начинается с индекса h - 1.
+	Array<float> mTwiddleReal, mTwiddleImag;
+
+	//! Пары индексов, переставляемых при бит-реверсной перестановке.
+	Array<uint> mSwaps;
+
+	//! Для алгоритма Блюстейна: план свёртки, множители exp(-πi*n²/N) и спектр ядра свёртки, делённый на размер свёртки.
+	const FFTPlan* mConvolutionPlan;
+	Array<float> mChirpReal, mChirpImag, mKernelReal, mKernelImag;
+
+	//! Для действительных преобразований: план размера N/2 и множители exp(-2πi*k/N) для k от 0 до N/4.
+	const FFTPlan* mHalfPlan;
+	Array<float> mRealTwiddleReal, mRealTwiddleImag;
+
+	void forwardPow2(Span<float> real, Span<float> imag) const;
+	void forwardBluestein(Span<float> real, Span<float> imag, Span<float> temp) const;
+
+	FFTPlan(const FFTPlan&) = delete;
+	FFTPlan& operator=(const FFTPlan&) = delete;
+};
+
+//! Функции ниже используют планы из кэша FFTPlan::Get.
 //void InplaceFFT(Span<cfloat> data);
 //void InplaceInverseFFT(Span<cfloat> data);
 void InplaceFFT(Span<float> real, Span<float> imag);
@@ -78,6 +78,7 @@ struct MidiFileInfo
 	float MaxVolume;
 	StaticBitset<128> UsedInstrumentsFlags;
 	StaticBitset<128> UsedDrumInstrumentsFlags;
+	StaticBitset<128> UsedNotesFlags;
 };
 
 }}}
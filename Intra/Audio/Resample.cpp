@@ -1,5 +1,9 @@
 #include "Resample.h"
 #include "Math/Math.h"
+#include "Cpp/Intrinsics.h"
+#include "Range/Mutation/Copy.h"
+#include "Range/Mutation/Fill.h"
+#include "Simd/Simd.h"
 
 INTRA_PUSH_DISABLE_REDUNDANT_WARNINGS
 
@@ -16,6 +20,208 @@ void ResampleLinear(CSpan<float> src, Span<float> dst)
 }
 
 
+namespace {
+
+struct ResampleQualityPreset
+{
+	uint TapCount;
+	double KaiserBeta, Cutoff;
+};
+
+static const ResampleQualityPreset ResampleQualityPresets[] = {
+	{8, 5.0, 0.80},
+	{16, 7.0, 0.88},
+	{32, 9.0, 0.93},
+	{64, 10.5, 0.96}
+};
+
+//! Modified Bessel function of the first kind of order 0, needed for the Kaiser window.
+static double besselI0(double x)
+{
+	double sum = 1, term = 1;
+	const double halfX = x/2;
+	for(int k = 1; k < 64 && term > sum*1e-12; k++)
+	{
+		term *= Math::Sqr(halfX/k);
+		sum += term;
+	}
+	return sum;
+}
+
+static double sinc(double x)
+{
+	if(Math::Abs(x) < 1e-9) return 1;
+	return Math::Sin(Math::PI*x)/(Math::PI*x);
+}
+
+//! Dot product of two arrays, count must be a multiple of 4.
+static float resampleDotProduct(const float* a, const float* b, size_t count)
+{
+#if(INTRA_SIMD_SUPPORT >= INTRA_SIMD_SSE2 && INTRA_SIMD_SUPPORT <= INTRA_SIMD_AVX2)
+	__m128 sum0 = _mm_setzero_ps(), sum1 = _mm_setzero_ps();
+	size_t i = 0;
+	for(; i + 8 <= count; i += 8)
+	{
+		sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+		sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+	}
+	if(i < count) sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+	sum0 = _mm_add_ps(sum0, sum1);
+	sum0 = _mm_add_ps(sum0, _mm_movehl_ps(sum0, sum0));
+	sum0 = _mm_add_ss(sum0, _mm_shuffle_ps(sum0, sum0, 1));
+	return _mm_cvtss_f32(sum0);
+#else
+	float sum0 = 0, sum1 = 0, sum2 = 0, sum3 = 0;
+	for(size_t i = 0; i < count; i += 4)
+	{
+		sum0 += a[i]*b[i];
+		sum1 += a[i+1]*b[i+1];
+		sum2 += a[i+2]*b[i+2];
+		sum3 += a[i+3]*b[i+3];
+	}
+	return (sum0 + sum1) + (sum2 + sum3);
+#endif
+}
+
+}
+
+PolyphaseResampler::PolyphaseResampler(uint srcSampleRate, uint dstSampleRate, ResampleQuality quality):
+	mBank(Shared<FilterBank>::New()), mHistoryCount(0), mPosition(0), mPhase(0)
+{
+	INTRA_DEBUG_ASSERT(srcSampleRate != 0 && dstSampleRate != 0);
+	uint a = srcSampleRate, b = dstSampleRate;
+	while(b != 0)
+	{
+		const uint r = a % b;
+		a = b;
+		b = r;
+	}
+	FilterBank& bank = *mBank;
+	bank.Interpolation = dstSampleRate / a;
+	bank.Decimation = srcSampleRate / a;
+
+	// When downsampling, the passband shrinks to the new Nyquist frequency and the filter gets longer in input samples
+	const ResampleQualityPreset& preset = ResampleQualityPresets[byte(quality)];
+	const double bandwidth = bank.Interpolation < bank.Decimation? double(bank.Interpolation)/double(bank.Decimation): 1.0;
+	bank.TapCount = (size_t(Math::Ceil(double(preset.TapCount)/bandwidth)) + 3) & ~size_t(3);
+	bank.RowStride = bank.TapCount;
+	bank.Interpolated = bank.Interpolation > MaxPhaseCount;
+	bank.PhaseCount = bank.Interpolated? size_t(MaxPhaseCount): size_t(bank.Interpolation);
+	bank.PhaseScale = float(double(bank.PhaseCount)/double(bank.Interpolation));
+
+	// Row r is the filter for an output located r/PhaseCount input samples after input sample TapCount/2 - 1 of the window.
+	// The interpolated bank has an extra row for phase 1 so that row + 1 is always valid.
+	const size_t rowCount = bank.PhaseCount + (bank.Interpolated? 1: 0);
+	const double radius = double(bank.TapCount/2);
+	// With equal rates the only phase samples the sinc at integer points and becomes an exact delay
+	const double cutoff = bank.Interpolation == bank.Decimation? 1.0: preset.Cutoff*bandwidth;
+	const double windowNorm = 1/besselI0(preset.KaiserBeta);
+	bank.Rows.SetCountUninitialized(rowCount*bank.RowStride);
+	for(size_t r = 0; r < rowCount; r++)
+	{
+		float* const row = bank.Rows.Data() + r*bank.RowStride;
+		const double phase = double(r)/double(bank.PhaseCount);
+		double sum = 0;
+		for(size_t k = 0; k < bank.TapCount; k++)
+		{
+			const double distance = double(k) - (radius - 1) - phase;
+			const double windowArg = 1 - Math::Sqr(distance/radius);
+			const double window = windowArg > 0? besselI0(preset.KaiserBeta*Math::Sqrt(windowArg))*windowNorm: 0;
+			const double value = cutoff*sinc(cutoff*distance)*window;
+			row[k] = float(value);
+			sum += value;
+		}
+		// Every phase gets exactly unity gain at DC, otherwise the gain ripple between phases is audible as noise
+		for(size_t k = 0; k < bank.TapCount; k++) row[k] = float(double(row[k])/sum);
+	}
+
+	mHistory.SetCount(bank.TapCount + HistoryBlockSize, 0);
+	Reset();
+}
+
+void PolyphaseResampler::Reset()
+{
+	// The window of the first output starts TapCount/2 - 1 samples before the first input sample, so that it is centered on it
+	mHistoryCount = mBank->TapCount/2 - 1;
+	FillZeros(mHistory.Take(mHistoryCount));
+	mPosition = 0;
+	mPhase = 0;
+}
+
+forceinline float PolyphaseResampler::filterAt(const float* x) const
+{
+	const FilterBank& bank = *mBank;
+	const float* const rows = bank.Rows.Data();
+	if(!bank.Interpolated) return resampleDotProduct(rows + mPhase*bank.RowStride, x, bank.TapCount);
+	const float phase = float(mPhase)*bank.PhaseScale;
+	const size_t row = size_t(phase);
+	const float* const row0 = rows + row*bank.RowStride;
+	return Math::LinearMix(
+		resampleDotProduct(row0, x, bank.TapCount),
+		resampleDotProduct(row0 + bank.RowStride, x, bank.TapCount),
+		phase - float(row));
+}
+
+size_t PolyphaseResampler::Process(CSpan<float>& src, Span<float>& dst)
+{
+	const FilterBank& bank = *mBank;
+	const size_t stepInteger = bank.Decimation / bank.Interpolation;
+	const uint stepFraction = bank.Decimation % bank.Interpolation;
+	size_t written = 0;
+	for(;;)
+	{
+		// When downsampling strongly, the window may jump past all buffered samples. Skipped input is never copied.
+		if(mPosition > mHistoryCount)
+		{
+			INTRA_DEBUG_ASSERT(mHistoryCount == 0);
+			const size_t skipped = Funal::Min(mPosition, src.Length());
+			src.PopFirstExactly(skipped);
+			mPosition -= skipped;
+			if(mPosition != 0) break;
+		}
+
+		const size_t copied = CopyTo(src, mHistory.Drop(mHistoryCount));
+		src.PopFirstExactly(copied);
+		mHistoryCount += copied;
+
+		const float* const history = mHistory.Data();
+		while(!dst.Empty() && mPosition + bank.TapCount <= mHistoryCount)
+		{
+			dst.Next() = filterAt(history + mPosition);
+			written++;
+			mPosition += stepInteger;
+			mPhase += stepFraction;
+			if(mPhase >= bank.Interpolation)
+			{
+				mPhase -= bank.Interpolation;
+				mPosition++;
+			}
+		}
+
+		// Keep only the samples which are still needed by the next windows
+		const size_t consumed = Funal::Min(mPosition, mHistoryCount);
+		if(consumed != 0)
+		{
+			C::memmove(mHistory.Data(), mHistory.Data() + consumed, (mHistoryCount - consumed)*sizeof(float));
+			mHistoryCount -= consumed;
+			mPosition -= consumed;
+		}
+		if(dst.Empty() || src.Empty()) break;
+	}
+	return written;
+}
+
+size_t PolyphaseResampler::OutputLengthFor(size_t inputCount) const
+{
+	// Output n is ready when its window fits into the available input: mPosition + floor((mPhase + n*M)/L) + TapCount <= available
+	const ulong64 available = ulong64(mHistoryCount) + inputCount;
+	const ulong64 needed = ulong64(mPosition) + mBank->TapCount;
+	if(available < needed) return 0;
+	const ulong64 L = mBank->Interpolation, M = mBank->Decimation;
+	const ulong64 limit = (available - needed + 1)*L - mPhase;
+	return size_t((limit + M - 1) / M);
+}
+
 Span<float> DecimateX2LinearInPlace(Span<float> inOutSamples)
 {
 	const size_t newLen = inOutSamples.Length() / 2;
@@ -2,6 +2,8 @@
 
 #include "Utils/Span.h"
 #include "Math/Math.h"
+#include "Utils/Shared.h"
+#include "Container/Sequential/Array.h"
 
 namespace Intra { namespace Audio {
 
@@ -14,6 +16,70 @@ inline float LinearSample(CSpan<float> arr, float index)
 
 void ResampleLinear(CSpan<float> src, Span<float> dst);
 
+//!   :      .
+enum class ResampleQuality: byte
+{
+	//! 8 ,  50  .
+	Fast,
+
+	//! 16 ,  70 .
+	Medium,
+
+	//! 32 ,  90 .       .
+	High,
+
+	//! 64 ,  100      .
+	Best
+};
+
+//!      windowed sinc ( )     .
+//!     ,  44100 -> 48000  147 -> 160,     160     .
+//!    MaxPhaseCount,  MaxPhaseCount + 1        .
+//!       ,           .
+//!         ,    .
+//!      :       .
+//!     .     ,        .
+class PolyphaseResampler
+{
+public:
+	enum: size_t {MaxPhaseCount = 1024, HistoryBlockSize = 1024};
+
+	PolyphaseResampler(uint srcSampleRate, uint dstSampleRate, ResampleQuality quality = ResampleQuality::High);
+
+	//!    src     dst,        .
+	//! src  dst        .
+	//! @return   .
+	size_t Process(CSpan<float>& src, Span<float>& dst);
+
+	//!       .
+	//!   ,    ,       .
+	forceinline size_t InputLatency() const {return mBank->TapCount/2;}
+
+	//!       count ,    ,   InputLatency.
+	size_t OutputLengthFor(size_t inputCount) const;
+
+	//!       .
+	void Reset();
+
+private:
+	struct FilterBank
+	{
+		size_t TapCount, RowStride;
+		uint Interpolation, Decimation;
+		size_t PhaseCount;
+		bool Interpolated;
+		float PhaseScale;
+		Array<float> Rows;
+	};
+
+	Shared<FilterBank> mBank;
+	Array<float> mHistory;
+	size_t mHistoryCount, mPosition;
+	uint mPhase;
+
+	float filterAt(const float* x) const;
+};
+
 //!     1/2    .
 //! @return ,     .
 Span<float> DecimateX2LinearInPlace(Span<float> inOutSamples);
@@ -1,10 +1,265 @@
 #include "SampleConversion.h"
 
+#include "Cpp/Features.h"
+#include "Simd/Simd.h"
+#include "Utils/Debug.h"
+
 namespace Intra { namespace Audio {
 
+#if(INTRA_SIMD_SUPPORT >= INTRA_SIMD_SSE2 && INTRA_SIMD_SUPPORT <= INTRA_SIMD_AVX2)
+#define INTRA_SAMPLE_CONVERSION_SSE2 1
+#else
+#define INTRA_SAMPLE_CONVERSION_SSE2 0
+#endif
+
+TpdfDither::TpdfDither(uint seed)
+{
+	for(uint i = 0; i < 4; i++)
+	{
+		// splitmix-style scrambling so that neighbouring seeds give unrelated lanes, xorshift state must be nonzero
+		uint x = seed + (i + 1)*0x9E3779B9u;
+		x = (x ^ (x >> 16))*0x85EBCA6Bu;
+		x = (x ^ (x >> 13))*0xC2B2AE35u;
+		x ^= x >> 16;
+		State[i] = x != 0? x: 1;
+	}
+}
+
+static forceinline float tpdfNoise(uint& state)
+{
+	uint x = state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	state = x;
+	// difference of two uniform 16-bit values has triangular distribution on (-1; 1)
+	return float(int(x & 0xFFFF) - int(x >> 16))*(1.0f/65536);
+}
+
+//! Scale to 16-bit range and saturate instead of wrapping around.
+static forceinline short floatToShortSaturate(float x)
+{
+	const float v = x*32767;
+	return short(v >= 32767? 32767: v <= -32768? -32768: v);
+}
+
+static forceinline short floatToShortDithered(float x, TpdfDither& dither)
+{
+	float v = x*32767 + tpdfNoise(dither.State[0]);
+	v = v >= 32767? 32767: v <= -32768? -32768: v;
+	return short(v >= 0? v + 0.5f: v - 0.5f);
+}
+
+#if INTRA_SAMPLE_CONVERSION_SSE2
+
+// Kernels below process 4 frames at once: N channel vectors of 4 samples <-> N vectors of interleaved samples.
+
+template<size_t N> static void simdInterleave4Frames(const float* const* src, size_t offset, __m128* v);
+
+template<> forceinline void simdInterleave4Frames<2>(const float* const* src, size_t offset, __m128* v)
+{
+	const __m128 a = _mm_loadu_ps(src[0] + offset), b = _mm_loadu_ps(src[1] + offset);
+	v[0] = _mm_unpacklo_ps(a, b);
+	v[1] = _mm_unpackhi_ps(a, b);
+}
+
+template<> forceinline void simdInterleave4Frames<4>(const float* const* src, size_t offset, __m128* v)
+{
+	v[0] = _mm_loadu_ps(src[0] + offset);
+	v[1] = _mm_loadu_ps(src[1] + offset);
+	v[2] = _mm_loadu_ps(src[2] + offset);
+	v[3] = _mm_loadu_ps(src[3] + offset);
+	_MM_TRANSPOSE4_PS(v[0], v[1], v[2], v[3]);
+}
+
+template<> forceinline void simdInterleave4Frames<6>(const float* const* src, size_t offset, __m128* v)
+{
+	__m128 t0 = _mm_loadu_ps(src[0] + offset), t1 = _mm_loadu_ps(src[1] + offset);
+	__m128 t2 = _mm_loadu_ps(src[2] + offset), t3 = _mm_loadu_ps(src[3] + offset);
+	_MM_TRANSPOSE4_PS(t0, t1, t2, t3);
+	const __m128 a = _mm_loadu_ps(src[4] + offset), b = _mm_loadu_ps(src[5] + offset);
+	const __m128 q01 = _mm_unpacklo_ps(a, b), q23 = _mm_unpackhi_ps(a, b);
+	v[0] = t0;
+	v[1] = _mm_movelh_ps(q01, t1);
+	v[2] = _mm_shuffle_ps(t1, q01, _MM_SHUFFLE(3, 2, 3, 2));
+	v[3] = t2;
+	v[4] = _mm_movelh_ps(q23, t3);
+	v[5] = _mm_shuffle_ps(t3, q23, _MM_SHUFFLE(3, 2, 3, 2));
+}
+
+template<> forceinline void simdInterleave4Frames<8>(const float* const* src, size_t offset, __m128* v)
+{
+	__m128 t0 = _mm_loadu_ps(src[0] + offset), t1 = _mm_loadu_ps(src[1] + offset);
+	__m128 t2 = _mm_loadu_ps(src[2] + offset), t3 = _mm_loadu_ps(src[3] + offset);
+	__m128 u0 = _mm_loadu_ps(src[4] + offset), u1 = _mm_loadu_ps(src[5] + offset);
+	__m128 u2 = _mm_loadu_ps(src[6] + offset), u3 = _mm_loadu_ps(src[7] + offset);
+	_MM_TRANSPOSE4_PS(t0, t1, t2, t3);
+	_MM_TRANSPOSE4_PS(u0, u1, u2, u3);
+	v[0] = t0; v[1] = u0;
+	v[2] = t1; v[3] = u1;
+	v[4] = t2; v[5] = u2;
+	v[6] = t3; v[7] = u3;
+}
+
+
+template<size_t N> static void simdDeinterleave4Frames(const __m128* v, float* const* dst, size_t offset);
+
+template<> forceinline void simdDeinterleave4Frames<2>(const __m128* v, float* const* dst, size_t offset)
+{
+	_mm_storeu_ps(dst[0] + offset, _mm_shuffle_ps(v[0], v[1], _MM_SHUFFLE(2, 0, 2, 0)));
+	_mm_storeu_ps(dst[1] + offset, _mm_shuffle_ps(v[0], v[1], _MM_SHUFFLE(3, 1, 3, 1)));
+}
+
+template<> forceinline void simdDeinterleave4Frames<4>(const __m128* v, float* const* dst, size_t offset)
+{
+	__m128 t0 = v[0], t1 = v[1], t2 = v[2], t3 = v[3];
+	_MM_TRANSPOSE4_PS(t0, t1, t2, t3);
+	_mm_storeu_ps(dst[0] + offset, t0);
+	_mm_storeu_ps(dst[1] + offset, t1);
+	_mm_storeu_ps(dst[2] + offset, t2);
+	_mm_storeu_ps(dst[3] + offset, t3);
+}
+
+template<> forceinline void simdDeinterleave4Frames<6>(const __m128* v, float* const* dst, size_t offset)
+{
+	__m128 t0 = v[0];
+	__m128 t1 = _mm_shuffle_ps(v[1], v[2], _MM_SHUFFLE(1, 0, 3, 2));
+	__m128 t2 = v[3];
+	__m128 t3 = _mm_shuffle_ps(v[4], v[5], _MM_SHUFFLE(1, 0, 3, 2));
+	_MM_TRANSPOSE4_PS(t0, t1, t2, t3);
+	_mm_storeu_ps(dst[0] + offset, t0);
+	_mm_storeu_ps(dst[1] + offset, t1);
+	_mm_storeu_ps(dst[2] + offset, t2);
+	_mm_storeu_ps(dst[3] + offset, t3);
+	const __m128 q01 = _mm_shuffle_ps(v[1], v[2], _MM_SHUFFLE(3, 2, 1, 0));
+	const __m128 q23 = _mm_shuffle_ps(v[4], v[5], _MM_SHUFFLE(3, 2, 1, 0));
+	_mm_storeu_ps(dst[4] + offset, _mm_shuffle_ps(q01, q23, _MM_SHUFFLE(2, 0, 2, 0)));
+	_mm_storeu_ps(dst[5] + offset, _mm_shuffle_ps(q01, q23, _MM_SHUFFLE(3, 1, 3, 1)));
+}
+
+template<> forceinline void simdDeinterleave4Frames<8>(const __m128* v, float* const* dst, size_t offset)
+{
+	__m128 t0 = v[0], t1 = v[2], t2 = v[4], t3 = v[6];
+	__m128 u0 = v[1], u1 = v[3], u2 = v[5], u3 = v[7];
+	_MM_TRANSPOSE4_PS(t0, t1, t2, t3);
+	_MM_TRANSPOSE4_PS(u0, u1, u2, u3);
+	_mm_storeu_ps(dst[0] + offset, t0);
+	_mm_storeu_ps(dst[1] + offset, t1);
+	_mm_storeu_ps(dst[2] + offset, t2);
+	_mm_storeu_ps(dst[3] + offset, t3);
+	_mm_storeu_ps(dst[4] + offset, u0);
+	_mm_storeu_ps(dst[5] + offset, u1);
+	_mm_storeu_ps(dst[6] + offset, u2);
+	_mm_storeu_ps(dst[7] + offset, u3);
+}
+
+
+//! Converts 8 floats to 8 saturated shorts, truncating like the scalar code.
+struct SimdShortQuantizer
+{
+	forceinline __m128i operator()(__m128 a, __m128 b) const
+	{
+		const __m128 scale = _mm_set1_ps(32767.0f), lo = _mm_set1_ps(-32768.0f), hi = _mm_set1_ps(32767.0f);
+		a = _mm_min_ps(_mm_max_ps(_mm_mul_ps(a, scale), lo), hi);
+		b = _mm_min_ps(_mm_max_ps(_mm_mul_ps(b, scale), lo), hi);
+		return _mm_packs_epi32(_mm_cvttps_epi32(a), _mm_cvttps_epi32(b));
+	}
+};
+
+//! Adds TPDF noise generated by 4 independent xorshift lanes and rounds to nearest.
+struct SimdDitheredShortQuantizer
+{
+	__m128i State;
+
+	forceinline __m128 noise()
+	{
+		__m128i x = State;
+		x = _mm_xor_si128(x, _mm_slli_epi32(x, 13));
+		x = _mm_xor_si128(x, _mm_srli_epi32(x, 17));
+		x = _mm_xor_si128(x, _mm_slli_epi32(x, 5));
+		State = x;
+		const __m128i diff = _mm_sub_epi32(_mm_and_si128(x, _mm_set1_epi32(0xFFFF)), _mm_srli_epi32(x, 16));
+		return _mm_mul_ps(_mm_cvtepi32_ps(diff), _mm_set1_ps(1.0f/65536));
+	}
+
+	forceinline __m128i operator()(__m128 a, __m128 b)
+	{
+		const __m128 scale = _mm_set1_ps(32767.0f), lo = _mm_set1_ps(-32768.0f), hi = _mm_set1_ps(32767.0f);
+		a = _mm_min_ps(_mm_max_ps(_mm_add_ps(_mm_mul_ps(a, scale), noise()), lo), hi);
+		b = _mm_min_ps(_mm_max_ps(_mm_add_ps(_mm_mul_ps(b, scale), noise()), lo), hi);
+		return _mm_packs_epi32(_mm_cvtps_epi32(a), _mm_cvtps_epi32(b));
+	}
+};
+
+//! @return Number of frames processed, a multiple of 4.
+template<size_t N> static size_t simdInterleaveFloats(float* dst, size_t frameCount, const float* const* src)
+{
+	size_t i = 0;
+	for(; i + 4 <= frameCount; i += 4)
+	{
+		__m128 v[N];
+		simdInterleave4Frames<N>(src, i, v);
+		for(size_t k = 0; k < N; k++) _mm_storeu_ps(dst + i*N + 4*k, v[k]);
+	}
+	return i;
+}
+
+template<size_t N> static size_t simdDeinterleaveFloats(const float* src, size_t frameCount, float* const* dst)
+{
+	size_t i = 0;
+	for(; i + 4 <= frameCount; i += 4)
+	{
+		__m128 v[N];
+		for(size_t k = 0; k < N; k++) v[k] = _mm_loadu_ps(src + i*N + 4*k);
+		simdDeinterleave4Frames<N>(v, dst, i);
+	}
+	return i;
+}
+
+template<size_t N, typename Q> static size_t simdInterleaveFloatsCastToShorts(short* dst,
+	size_t frameCount, const float* const* src, Q& quantize)
+{
+	size_t i = 0;
+	for(; i + 4 <= frameCount; i += 4)
+	{
+		__m128 v[N];
+		simdInterleave4Frames<N>(src, i, v);
+		for(size_t k = 0; k < N/2; k++)
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i*N + 8*k), quantize(v[2*k], v[2*k+1]));
+	}
+	return i;
+}
+
+template<size_t N> static size_t simdDeinterleaveShortsCastToFloats(const short* src, size_t frameCount, float* const* dst)
+{
+	const __m128 scale = _mm_set1_ps(1.0f/32768);
+	size_t i = 0;
+	for(; i + 4 <= frameCount; i += 4)
+	{
+		__m128 v[N];
+		for(size_t k = 0; k < N/2; k++)
+		{
+			const __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i*N + 8*k));
+			// sign-extend 16-bit values by placing them into the high halves and shifting arithmetically
+			v[2*k] = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16)), scale);
+			v[2*k+1] = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(s, s), 16)), scale);
+		}
+		simdDeinterleave4Frames<N>(v, dst, i);
+	}
+	return i;
+}
+
+#endif
+
 #if(INTRA_MINEXE == 0)
 void InterleaveFloats(Span<float> dst, CSpan<float> src1, CSpan<float> src2)
 {
+#if INTRA_SAMPLE_CONVERSION_SSE2
+	const float* const src[] = {src1.Begin, src2.Begin};
+	const size_t n = simdInterleaveFloats<2>(dst.Begin, dst.Length()/2, src);
+	dst.Begin += n*2;
+	src1.Begin += n; src2.Begin += n;
+#endif
 	while(dst.End != dst.Begin)
 	{
 		*dst.Begin++ = *src1.Begin++;
@@ -25,6 +280,12 @@ void InterleaveFloats(Span<float> dst, CSpan<float> src1, CSpan<float> src2, CSp
 void InterleaveFloats(Span<float> dst, CSpan<float> src1,
 	CSpan<float> src2, CSpan<float> src3, CSpan<float> src4)
 {
+#if INTRA_SAMPLE_CONVERSION_SSE2
+	const float* const src[] = {src1.Begin, src2.Begin, src3.Begin, src4.Begin};
+	const size_t n = simdInterleaveFloats<4>(dst.Begin, dst.Length()/4, src);
+	dst.Begin += n*4;
+	src1.Begin += n; src2.Begin += n; src3.Begin += n; src4.Begin += n;
+#endif
 	while(dst.End != dst.Begin)
 	{
 		*dst.Begin++ = *src1.Begin++;
@@ -50,6 +311,12 @@ void InterleaveFloats(Span<float> dst, CSpan<float> src1,
 void InterleaveFloats(Span<float> dst, CSpan<float> src1, CSpan<float> src2,
 	CSpan<float> src3, CSpan<float> src4, CSpan<float> src5, CSpan<float> src6)
 {
+#if INTRA_SAMPLE_CONVERSION_SSE2
+	const float* const src[] = {src1.Begin, src2.Begin, src3.Begin, src4.Begin, src5.Begin, src6.Begin};
+	const size_t n = simdInterleaveFloats<6>(dst.Begin, dst.Length()/6, src);
+	dst.Begin += n*6;
+	src1.Begin += n; src2.Begin += n; src3.Begin += n; src4.Begin += n; src5.Begin += n; src6.Begin += n;
+#endif
 	while(dst.End != dst.Begin)
 	{
 		*dst.Begin++ = *src1.Begin++;
@@ -79,6 +346,12 @@ void InterleaveFloats(Span<float> dst, CSpan<float> src1, CSpan<float> src2,
 void InterleaveFloats(Span<float> dst, CSpan<float> src1, CSpan<float> src2, CSpan<float> src3,
 	CSpan<float> src4, CSpan<float> src5, CSpan<float> src6, CSpan<float> src7, CSpan<float> src8)
 {
+#if INTRA_SAMPLE_CONVERSION_SSE2
+	const float* const src[] = {src1.Begin, src2.Begin, src3.Begin, src4.Begin, src5.Begin, src6.Begin, src7.Begin, src8.Begin};
+	const size_t n = simdInterleaveFloats<8>(dst.Begin, dst.Length()/8, src);
+	dst.Begin += n*8;
+	src1.Begin += n; src2.Begin += n; src3.Begin += n; src4.Begin += n; src5.Begin += n; src6.Begin += n; src7.Begin += n; src8.Begin += n;
+#endif
 	while(dst.End != dst.Begin)
 	{
 		*dst.Begin++ = *src1.Begin++;
@@ -238,6 +511,12 @@ void InterleaveShorts(Span<short> dst, Span<CSpan<short>> src)
 #if(INTRA_MINEXE == 0)
 void DeinterleaveFloats(CSpan<float> src, Span<float> dst1, Span<float> dst2)
 {
+#if INTRA_SAMPLE_CONVERSION_SSE2
+	float* const dst[] = {dst1.Begin, dst2.Begin};
+	const size_t n = simdDeinterleaveFloats<2>(src.Begin, src.Length()/2, dst);
+	src.Begin += n*2;
+	dst1.Begin += n; dst2.Begin += n;
+#endif
 	while(src.End != src.Begin)
 	{
 		*dst1.Begin++ = *src.Begin++;
@@ -258,6 +537,12 @@ void DeinterleaveFloats(CSpan<float> src, Span<float> dst1, Span<float> dst2, Sp
 void DeinterleaveFloats(CSpan<float> src, Span<float> dst1,
 	Span<float> dst2, Span<float> dst3, Span<float> dst4)
 {
+#if INTRA_SAMPLE_CONVERSION_SSE2
+	float* const dst[] = {dst1.Begin, dst2.Begin, dst3.Begin, dst4.Begin};
+	const size_t n = simdDeinterleaveFloats<4>(src.Begin, src.Length()/4, dst);
+	src.Begin += n*4;
+	dst1.Begin += n; dst2.Begin += n; dst3.Begin += n; dst4.Begin += n;
+#endif
 	while(src.End != src.Begin)
 	{
 		*dst1.Begin++ = *src.Begin++;
@@ -283,6 +568,12 @@ void DeinterleaveFloats(CSpan<float> src, Span<float> dst1,
 void DeinterleaveFloats(CSpan<float> src, Span<float> dst1, Span<float> dst2,
 	Span<float> dst3, Span<float> dst4, Span<float> dst5, Span<float> dst6)
 {
+#if INTRA_SAMPLE_CONVERSION_SSE2
+	float* const dst[] = {dst1.Begin, dst2.Begin, dst3.Begin, dst4.Begin, dst5.Begin, dst6.Begin};
+	const size_t n = simdDeinterleaveFloats<6>(src.Begin, src.Length()/6, dst);
+	src.Begin += n*6;
+	dst1.Begin += n; dst2.Begin += n; dst3.Begin += n; dst4.Begin += n; dst5.Begin += n; dst6.Begin += n;
+#endif
 	while(src.End != src.Begin)
 	{
 		*dst1.Begin++ = *src.Begin++;
@@ -312,6 +603,12 @@ void DeinterleaveFloats(CSpan<float> src, Span<float> dst1, Span<float> dst2,
 void DeinterleaveFloats(CSpan<float> src, Span<float> dst1, Span<float> dst2, Span<float> dst3,
 	Span<float> dst4, Span<float> dst5, Span<float> dst6, Span<float> dst7, Span<float> dst8)
 {
+#if INTRA_SAMPLE_CONVERSION_SSE2
+	float* const dst[] = {dst1.Begin, dst2.Begin, dst3.Begin, dst4.Begin, dst5.Begin, dst6.Begin, dst7.Begin, dst8.Begin};
+	const size_t n = simdDeinterleaveFloats<8>(src.Begin, src.Length()/8, dst);
+	src.Begin += n*8;
+	dst1.Begin += n; dst2.Begin += n; dst3.Begin += n; dst4.Begin += n; dst5.Begin += n; dst6.Begin += n; dst7.Begin += n; dst8.Begin += n;
+#endif
 	while(src.End != src.Begin)
 	{
 		*dst1.Begin++ = *src.Begin++;
@@ -338,7 +635,7 @@ template<typename T> void genericDeinterleave(CSpan<T> src, Span<Span<T>> dst)
 void DeinterleaveFloats(CSpan<float> src, Span<Span<float>> dst)
 {
 #if(INTRA_MINEXE == 0)
-	switch(src.Length())
+	switch(dst.Length())
 #endif
 	{
 #if(INTRA_MINEXE == 0)
@@ -450,7 +747,7 @@ void DeinterleaveShorts(CSpan<short> src, Span<short> dst1, Span<short> dst2, Sp
 void DeinterleaveShorts(CSpan<short> src, Span<Span<short>> dst)
 {
 #if(INTRA_MINEXE == 0)
-	switch(src.Length())
+	switch(dst.Length())
 #endif
 	{
 #if(INTRA_MINEXE == 0)
@@ -471,10 +768,17 @@ void DeinterleaveShorts(CSpan<short> src, Span<Span<short>> dst)
 #if(INTRA_MINEXE == 0)
 void InterleaveFloatsCastToShorts(Span<short> dst, CSpan<float> src1, CSpan<float> src2)
 {
+#if INTRA_SAMPLE_CONVERSION_SSE2
+	const float* const src[] = {src1.Begin, src2.Begin};
+	SimdShortQuantizer quantize;
+	const size_t n = simdInterleaveFloatsCastToShorts<2>(dst.Begin, dst.Length()/2, src, quantize);
+	dst.Begin += n*2;
+	src1.Begin += n; src2.Begin += n;
+#endif
 	while(dst.End > dst.Begin + 1)
 	{
-		*dst.Begin++ = short(*src1.Begin++ * 32767);
-		*dst.Begin++ = short(*src2.Begin++ * 32767);
+		*dst.Begin++ = floatToShortSaturate(*src1.Begin++);
+		*dst.Begin++ = floatToShortSaturate(*src2.Begin++);
 	}
 }
 
@@ -482,21 +786,28 @@ void InterleaveFloatsCastToShorts(Span<short> dst, CSpan<float> src1, CSpan<floa
 {
 	while(dst.End > dst.Begin + 2)
 	{
-		*dst.Begin++ = short(*src1.Begin++ * 32767);
-		*dst.Begin++ = short(*src2.Begin++ * 32767);
-		*dst.Begin++ = short(*src3.Begin++ * 32767);
+		*dst.Begin++ = floatToShortSaturate(*src1.Begin++);
+		*dst.Begin++ = floatToShortSaturate(*src2.Begin++);
+		*dst.Begin++ = floatToShortSaturate(*src3.Begin++);
 	}
 }
 
 void InterleaveFloatsCastToShorts(Span<short> dst, CSpan<float> src1,
 	CSpan<float> src2, CSpan<float> src3, CSpan<float> src4)
 {
+#if INTRA_SAMPLE_CONVERSION_SSE2
+	const float* const src[] = {src1.Begin, src2.Begin, src3.Begin, src4.Begin};
+	SimdShortQuantizer quantize;
+	const size_t n = simdInterleaveFloatsCastToShorts<4>(dst.Begin, dst.Length()/4, src, quantize);
+	dst.Begin += n*4;
+	src1.Begin += n; src2.Begin += n; src3.Begin += n; src4.Begin += n;
+#endif
 	while(dst.End > dst.Begin + 3)
 	{
-		*dst.Begin++ = short(*src1.Begin++ * 32767);
-		*dst.Begin++ = short(*src2.Begin++ * 32767);
-		*dst.Begin++ = short(*src3.Begin++ * 32767);
-		*dst.Begin++ = short(*src4.Begin++ * 32767);
+		*dst.Begin++ = floatToShortSaturate(*src1.Begin++);
+		*dst.Begin++ = floatToShortSaturate(*src2.Begin++);
+		*dst.Begin++ = floatToShortSaturate(*src3.Begin++);
+		*dst.Begin++ = floatToShortSaturate(*src4.Begin++);
 	}
 }
 
@@ -505,25 +816,32 @@ void InterleaveFloatsCastToShorts(Span<short> dst, CSpan<float> src1, CSpan<floa
 {
 	while(dst.End > dst.Begin + 4)
 	{
-		*dst.Begin++ = short(*src1.Begin++ * 32767);
-		*dst.Begin++ = short(*src2.Begin++ * 32767);
-		*dst.Begin++ = short(*src3.Begin++ * 32767);
-		*dst.Begin++ = short(*src4.Begin++ * 32767);
-		*dst.Begin++ = short(*src5.Begin++ * 32767);
+		*dst.Begin++ = floatToShortSaturate(*src1.Begin++);
+		*dst.Begin++ = floatToShortSaturate(*src2.Begin++);
+		*dst.Begin++ = floatToShortSaturate(*src3.Begin++);
+		*dst.Begin++ = floatToShortSaturate(*src4.Begin++);
+		*dst.Begin++ = floatToShortSaturate(*src5.Begin++);
 	}
 }
 
 void InterleaveFloatsCastToShorts(Span<short> dst, CSpan<float> src1, CSpan<float> src2,
 	CSpan<float> src3, CSpan<float> src4, CSpan<float> src5, CSpan<float> src6)
 {
+#if INTRA_SAMPLE_CONVERSION_SSE2
+	const float* const src[] = {src1.Begin, src2.Begin, src3.Begin, src4.Begin, src5.Begin, src6.Begin};
+	SimdShortQuantizer quantize;
+	const size_t n = simdInterleaveFloatsCastToShorts<6>(dst.Begin, dst.Length()/6, src, quantize);
+	dst.Begin += n*6;
+	src1.Begin += n; src2.Begin += n; src3.Begin += n; src4.Begin += n; src5.Begin += n; src6.Begin += n;
+#endif
 	while(dst.End > dst.Begin + 5)
 	{
-		*dst.Begin++ = short(*src1.Begin++ * 32767);
-		*dst.Begin++ = short(*src2.Begin++ * 32767);
-		*dst.Begin++ = short(*src3.Begin++ * 32767);
-		*dst.Begin++ = short(*src4.Begin++ * 32767);
-		*dst.Begin++ = short(*src5.Begin++ * 32767);
-		*dst.Begin++ = short(*src6.Begin++ * 32767);
+		*dst.Begin++ = floatToShortSaturate(*src1.Begin++);
+		*dst.Begin++ = floatToShortSaturate(*src2.Begin++);
+		*dst.Begin++ = floatToShortSaturate(*src3.Begin++);
+		*dst.Begin++ = floatToShortSaturate(*src4.Begin++);
+		*dst.Begin++ = floatToShortSaturate(*src5.Begin++);
+		*dst.Begin++ = floatToShortSaturate(*src6.Begin++);
 	}
 }
 
@@ -532,29 +850,36 @@ void InterleaveFloatsCastToShorts(Span<short> dst, CSpan<float> src1, CSpan<floa
 {
 	while(dst.End > dst.Begin + 6)
 	{
-		*dst.Begin++ = short(*src1.Begin++ * 32767);
-		*dst.Begin++ = short(*src2.Begin++ * 32767);
-		*dst.Begin++ = short(*src3.Begin++ * 32767);
-		*dst.Begin++ = short(*src4.Begin++ * 32767);
-		*dst.Begin++ = short(*src5.Begin++ * 32767);
-		*dst.Begin++ = short(*src6.Begin++ * 32767);
-		*dst.Begin++ = short(*src7.Begin++ * 32767);
+		*dst.Begin++ = floatToShortSaturate(*src1.Begin++);
+		*dst.Begin++ = floatToShortSaturate(*src2.Begin++);
+		*dst.Begin++ = floatToShortSaturate(*src3.Begin++);
+		*dst.Begin++ = floatToShortSaturate(*src4.Begin++);
+		*dst.Begin++ = floatToShortSaturate(*src5.Begin++);
+		*dst.Begin++ = floatToShortSaturate(*src6.Begin++);
+		*dst.Begin++ = floatToShortSaturate(*src7.Begin++);
 	}
 }
 
 void InterleaveFloatsCastToShorts(Span<short> dst, CSpan<float> src1, CSpan<float> src2, CSpan<float> src3,
 	CSpan<float> src4, CSpan<float> src5, CSpan<float> src6, CSpan<float> src7, CSpan<float> src8)
 {
+#if INTRA_SAMPLE_CONVERSION_SSE2
+	const float* const src[] = {src1.Begin, src2.Begin, src3.Begin, src4.Begin, src5.Begin, src6.Begin, src7.Begin, src8.Begin};
+	SimdShortQuantizer quantize;
+	const size_t n = simdInterleaveFloatsCastToShorts<8>(dst.Begin, dst.Length()/8, src, quantize);
+	dst.Begin += n*8;
+	src1.Begin += n; src2.Begin += n; src3.Begin += n; src4.Begin += n; src5.Begin += n; src6.Begin += n; src7.Begin += n; src8.Begin += n;
+#endif
 	while(dst.End > dst.Begin + 7)
 	{
-		*dst.Begin++ = short(*src1.Begin++ * 32767);
-		*dst.Begin++ = short(*src2.Begin++ * 32767);
-		*dst.Begin++ = short(*src3.Begin++ * 32767);
-		*dst.Begin++ = short(*src4.Begin++ * 32767);
-		*dst.Begin++ = short(*src5.Begin++ * 32767);
-		*dst.Begin++ = short(*src6.Begin++ * 32767);
-		*dst.Begin++ = short(*src7.Begin++ * 32767);
-		*dst.Begin++ = short(*src8.Begin++ * 32767);
+		*dst.Begin++ = floatToShortSaturate(*src1.Begin++);
+		*dst.Begin++ = floatToShortSaturate(*src2.Begin++);
+		*dst.Begin++ = floatToShortSaturate(*src3.Begin++);
+		*dst.Begin++ = floatToShortSaturate(*src4.Begin++);
+		*dst.Begin++ = floatToShortSaturate(*src5.Begin++);
+		*dst.Begin++ = floatToShortSaturate(*src6.Begin++);
+		*dst.Begin++ = floatToShortSaturate(*src7.Begin++);
+		*dst.Begin++ = floatToShortSaturate(*src8.Begin++);
 	}
 }
 #endif
@@ -565,7 +890,7 @@ static void genericInterleaveCast(Span<short> dst, Span<CSpan<float>> src)
 	auto srcsSpan = Range::Take(srcs, src.CopyTo(srcs));
 	while(dst.End != dst.Begin)
 		for(auto& srci: srcsSpan)
-			*dst.Begin++ = short(*srci.Begin++ * 32767);
+			*dst.Begin++ = floatToShortSaturate(*srci.Begin++);
 }
 
 void InterleaveFloatsCastToShorts(Span<short> dst, Span<CSpan<float>> src)
@@ -588,14 +913,48 @@ void InterleaveFloatsCastToShorts(Span<short> dst, Span<CSpan<float>> src)
 	}
 }
 
+#if INTRA_SAMPLE_CONVERSION_SSE2
+template<size_t N> static void simdInterleaveCastDithered(Span<short>& dst, Span<CSpan<float>> src, TpdfDither& dither)
+{
+	const float* srcPtrs[N];
+	for(size_t c = 0; c < N; c++) srcPtrs[c] = src[c].Begin;
+	SimdDitheredShortQuantizer quantize;
+	quantize.State = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dither.State));
+	const size_t n = simdInterleaveFloatsCastToShorts<N>(dst.Begin, dst.Length()/N, srcPtrs, quantize);
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(dither.State), quantize.State);
+	dst.Begin += n*N;
+	for(auto& srci: src) srci.Begin += n;
+}
+#endif
+
+void InterleaveFloatsCastToShorts(Span<short> dst, Span<CSpan<float>> src, TpdfDither& dither)
+{
+	// kernels advance the channel spans, so they work on local copies and the caller's spans stay intact
+	CSpan<float> srcs[16];
+	auto srcsSpan = Range::Take(srcs, src.CopyTo(srcs));
+#if INTRA_SAMPLE_CONVERSION_SSE2
+	switch(srcsSpan.Length())
+	{
+	case 2: simdInterleaveCastDithered<2>(dst, srcsSpan, dither); break;
+	case 4: simdInterleaveCastDithered<4>(dst, srcsSpan, dither); break;
+	case 6: simdInterleaveCastDithered<6>(dst, srcsSpan, dither); break;
+	case 8: simdInterleaveCastDithered<8>(dst, srcsSpan, dither); break;
+	default:;
+	}
+#endif
+	while(dst.End != dst.Begin)
+		for(auto& srci: srcsSpan)
+			*dst.Begin++ = floatToShortDithered(*srci.Begin++, dither);
+}
+
 
 #if(INTRA_MINEXE == 0)
 void DeinterleaveFloatsCastToShorts(CSpan<float> src, Span<short> dst1, Span<short> dst2)
 {
 	while(src.End != src.Begin)
 	{
-		*dst1.Begin++ = short(*src.Begin++ * 32767);
-		*dst2.Begin++ = short(*src.Begin++ * 32767);
+		*dst1.Begin++ = floatToShortSaturate(*src.Begin++);
+		*dst2.Begin++ = floatToShortSaturate(*src.Begin++);
 	}
 }
 
@@ -604,9 +963,9 @@ void DeinterleaveFloatsCastToShorts(CSpan<float> src,
 {
 	while(src.End != src.Begin)
 	{
-		*dst1.Begin++ = short(*src.Begin++ * 32767);
-		*dst2.Begin++ = short(*src.Begin++ * 32767);
-		*dst3.Begin++ = short(*src.Begin++ * 32767);
+		*dst1.Begin++ = floatToShortSaturate(*src.Begin++);
+		*dst2.Begin++ = floatToShortSaturate(*src.Begin++);
+		*dst3.Begin++ = floatToShortSaturate(*src.Begin++);
 	}
 }
 
@@ -615,10 +974,10 @@ void DeinterleaveFloatsCastToShorts(CSpan<float> src, Span<short> dst1,
 {
 	while(src.End != src.Begin)
 	{
-		*dst1.Begin++ = short(*src.Begin++ * 32767);
-		*dst2.Begin++ = short(*src.Begin++ * 32767);
-		*dst3.Begin++ = short(*src.Begin++ * 32767);
-		*dst4.Begin++ = short(*src.Begin++ * 32767);
+		*dst1.Begin++ = floatToShortSaturate(*src.Begin++);
+		*dst2.Begin++ = floatToShortSaturate(*src.Begin++);
+		*dst3.Begin++ = floatToShortSaturate(*src.Begin++);
+		*dst4.Begin++ = floatToShortSaturate(*src.Begin++);
 	}
 }
 
@@ -627,11 +986,11 @@ void DeinterleaveFloatsCastToShorts(CSpan<float> src, Span<short> dst1,
 {
 	while(src.End != src.Begin)
 	{
-		*dst1.Begin++ = short(*src.Begin++ * 32767);
-		*dst2.Begin++ = short(*src.Begin++ * 32767);
-		*dst3.Begin++ = short(*src.Begin++ * 32767);
-		*dst4.Begin++ = short(*src.Begin++ * 32767);
-		*dst5.Begin++ = short(*src.Begin++ * 32767);
+		*dst1.Begin++ = floatToShortSaturate(*src.Begin++);
+		*dst2.Begin++ = floatToShortSaturate(*src.Begin++);
+		*dst3.Begin++ = floatToShortSaturate(*src.Begin++);
+		*dst4.Begin++ = floatToShortSaturate(*src.Begin++);
+		*dst5.Begin++ = floatToShortSaturate(*src.Begin++);
 	}
 }
 
@@ -640,12 +999,12 @@ void DeinterleaveFloatsCastToShorts(CSpan<float> src, Span<short> dst1, Span<sho
 {
 	while(src.End != src.Begin)
 	{
-		*dst1.Begin++ = short(*src.Begin++ * 32767);
-		*dst2.Begin++ = short(*src.Begin++ * 32767);
-		*dst3.Begin++ = short(*src.Begin++ * 32767);
-		*dst4.Begin++ = short(*src.Begin++ * 32767);
-		*dst5.Begin++ = short(*src.Begin++ * 32767);
-		*dst6.Begin++ = short(*src.Begin++ * 32767);
+		*dst1.Begin++ = floatToShortSaturate(*src.Begin++);
+		*dst2.Begin++ = floatToShortSaturate(*src.Begin++);
+		*dst3.Begin++ = floatToShortSaturate(*src.Begin++);
+		*dst4.Begin++ = floatToShortSaturate(*src.Begin++);
+		*dst5.Begin++ = floatToShortSaturate(*src.Begin++);
+		*dst6.Begin++ = floatToShortSaturate(*src.Begin++);
 	}
 }
 
@@ -654,13 +1013,13 @@ void DeinterleaveFloatsCastToShorts(CSpan<float> src, Span<short> dst1, Span<sho
 {
 	while(src.End != src.Begin)
 	{
-		*dst1.Begin++ = short(*src.Begin++ * 32767);
-		*dst2.Begin++ = short(*src.Begin++ * 32767);
-		*dst3.Begin++ = short(*src.Begin++ * 32767);
-		*dst4.Begin++ = short(*src.Begin++ * 32767);
-		*dst5.Begin++ = short(*src.Begin++ * 32767);
-		*dst6.Begin++ = short(*src.Begin++ * 32767);
-		*dst7.Begin++ = short(*src.Begin++ * 32767);
+		*dst1.Begin++ = floatToShortSaturate(*src.Begin++);
+		*dst2.Begin++ = floatToShortSaturate(*src.Begin++);
+		*dst3.Begin++ = floatToShortSaturate(*src.Begin++);
+		*dst4.Begin++ = floatToShortSaturate(*src.Begin++);
+		*dst5.Begin++ = floatToShortSaturate(*src.Begin++);
+		*dst6.Begin++ = floatToShortSaturate(*src.Begin++);
+		*dst7.Begin++ = floatToShortSaturate(*src.Begin++);
 	}
 }
 
@@ -669,14 +1028,14 @@ void DeinterleaveFloatsCastToShorts(CSpan<float> src, Span<short> dst1, Span<sho
 {
 	while(src.End != src.Begin)
 	{
-		*dst1.Begin++ = short(*src.Begin++ * 32767);
-		*dst2.Begin++ = short(*src.Begin++ * 32767);
-		*dst3.Begin++ = short(*src.Begin++ * 32767);
-		*dst4.Begin++ = short(*src.Begin++ * 32767);
-		*dst5.Begin++ = short(*src.Begin++ * 32767);
-		*dst6.Begin++ = short(*src.Begin++ * 32767);
-		*dst7.Begin++ = short(*src.Begin++ * 32767);
-		*dst8.Begin++ = short(*src.Begin++ * 32767);
+		*dst1.Begin++ = floatToShortSaturate(*src.Begin++);
+		*dst2.Begin++ = floatToShortSaturate(*src.Begin++);
+		*dst3.Begin++ = floatToShortSaturate(*src.Begin++);
+		*dst4.Begin++ = floatToShortSaturate(*src.Begin++);
+		*dst5.Begin++ = floatToShortSaturate(*src.Begin++);
+		*dst6.Begin++ = floatToShortSaturate(*src.Begin++);
+		*dst7.Begin++ = floatToShortSaturate(*src.Begin++);
+		*dst8.Begin++ = floatToShortSaturate(*src.Begin++);
 	}
 }
 #endif
@@ -687,13 +1046,13 @@ static void genericDeinterleaveCastToShorts(CSpan<float> src, Span<Span<short>>
 	auto dstsSpan = Range::Take(dsts, dst.CopyTo(dsts));
 	while(src.End != src.Begin)
 		for(auto& dsti: dstsSpan)
-			*dsti.Begin++ = short(*src.Begin++ * 32767);
+			*dsti.Begin++ = floatToShortSaturate(*src.Begin++);
 }
 
 void DeinterleaveFloatsCastToShorts(CSpan<float> src, Span<Span<short>> dst)
 {
 #if(INTRA_MINEXE == 0)
-	switch(src.Length())
+	switch(dst.Length())
 #endif
 	{
 #if(INTRA_MINEXE == 0)
@@ -714,6 +1073,12 @@ void DeinterleaveFloatsCastToShorts(CSpan<float> src, Span<Span<short>> dst)
 #if(INTRA_MINEXE == 0)
 void DeinterleaveShortsCastToFloats(CSpan<short> src, Span<float> dst1, Span<float> dst2)
 {
+#if INTRA_SAMPLE_CONVERSION_SSE2
+	float* const dst[] = {dst1.Begin, dst2.Begin};
+	const size_t n = simdDeinterleaveShortsCastToFloats<2>(src.Begin, src.Length()/2, dst);
+	src.Begin += n*2;
+	dst1.Begin += n; dst2.Begin += n;
+#endif
 	while(src.End != src.Begin)
 	{
 		*dst1.Begin++ = *src.Begin++ / 32768.0f;
@@ -735,6 +1100,12 @@ void DeinterleaveShortsCastToFloats(CSpan<short> src,
 void DeinterleaveShortsCastToFloats(CSpan<short> src,
 	Span<float> dst1, Span<float> dst2, Span<float> dst3, Span<float> dst4)
 {
+#if INTRA_SAMPLE_CONVERSION_SSE2
+	float* const dst[] = {dst1.Begin, dst2.Begin, dst3.Begin, dst4.Begin};
+	const size_t n = simdDeinterleaveShortsCastToFloats<4>(src.Begin, src.Length()/4, dst);
+	src.Begin += n*4;
+	dst1.Begin += n; dst2.Begin += n; dst3.Begin += n; dst4.Begin += n;
+#endif
 	while(src.End != src.Begin)
 	{
 		*dst1.Begin++ = *src.Begin++ / 32768.0f;
@@ -760,6 +1131,12 @@ void DeinterleaveShortsCastToFloats(CSpan<short> src, Span<float> dst1,
 void DeinterleaveShortsCastToFloats(CSpan<short> src, Span<float> dst1,
 	Span<float> dst2, Span<float> dst3, Span<float> dst4, Span<float> dst5, Span<float> dst6)
 {
+#if INTRA_SAMPLE_CONVERSION_SSE2
+	float* const dst[] = {dst1.Begin, dst2.Begin, dst3.Begin, dst4.Begin, dst5.Begin, dst6.Begin};
+	const size_t n = simdDeinterleaveShortsCastToFloats<6>(src.Begin, src.Length()/6, dst);
+	src.Begin += n*6;
+	dst1.Begin += n; dst2.Begin += n; dst3.Begin += n; dst4.Begin += n; dst5.Begin += n; dst6.Begin += n;
+#endif
 	while(src.End != src.Begin)
 	{
 		*dst1.Begin++ = *src.Begin++ / 32768.0f;
@@ -789,6 +1166,12 @@ void DeinterleaveShortsCastToFloats(CSpan<short> src, Span<float> dst1, Span<flo
 void DeinterleaveShortsCastToFloats(CSpan<short> src, Span<float> dst1, Span<float> dst2,
 	Span<float> dst3, Span<float> dst4, Span<float> dst5, Span<float> dst6, Span<float> dst7, Span<float> dst8)
 {
+#if INTRA_SAMPLE_CONVERSION_SSE2
+	float* const dst[] = {dst1.Begin, dst2.Begin, dst3.Begin, dst4.Begin, dst5.Begin, dst6.Begin, dst7.Begin, dst8.Begin};
+	const size_t n = simdDeinterleaveShortsCastToFloats<8>(src.Begin, src.Length()/8, dst);
+	src.Begin += n*8;
+	dst1.Begin += n; dst2.Begin += n; dst3.Begin += n; dst4.Begin += n; dst5.Begin += n; dst6.Begin += n; dst7.Begin += n; dst8.Begin += n;
+#endif
 	while(src.End != src.Begin)
 	{
 		*dst1.Begin++ = *src.Begin++ / 32768.0f;
@@ -815,7 +1198,7 @@ static void genericDeinterleaveCastToFloats(CSpan<short> src, Span<Span<float>>
 void DeinterleaveShortsCastToFloats(CSpan<short> src, Span<Span<float>> dst)
 {
 #if(INTRA_MINEXE == 0)
-	switch(src.Length())
+	switch(dst.Length())
 #endif
 	{
 #if(INTRA_MINEXE == 0)
@@ -832,4 +1215,30 @@ void DeinterleaveShortsCastToFloats(CSpan<short> src, Span<Span<float>> dst)
 	}
 }
 
+void CastFloatsToInt24(Span<int> dst, CSpan<float> src)
+{
+	INTRA_DEBUG_ASSERT(dst.Length() == src.Length());
+#if INTRA_SAMPLE_CONVERSION_SSE2
+	const __m128 scale = _mm_set1_ps(8388607.0f), lo = _mm_set1_ps(-8388608.0f), hi = _mm_set1_ps(8388607.0f);
+	const __m128 half = _mm_set1_ps(0.5f), signMask = _mm_set1_ps(-0.0f);
+	while(dst.Begin + 4 <= dst.End)
+	{
+		__m128 v = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(src.Begin), scale), lo), hi);
+		// round half away from zero like the scalar code
+		v = _mm_add_ps(v, _mm_or_ps(_mm_and_ps(v, signMask), half));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst.Begin), _mm_cvttps_epi32(v));
+		dst.Begin += 4;
+		src.Begin += 4;
+	}
+#endif
+	while(dst.Begin != dst.End)
+	{
+		float v = *src.Begin++ * 8388607.0f;
+		v = v >= 8388607? 8388607: v <= -8388608? -8388608: v;
+		*dst.Begin++ = int(v >= 0? v + 0.5f: v - 0.5f);
+	}
+}
+
+#undef INTRA_SAMPLE_CONVERSION_SSE2
+
 }}
@@ -67,6 +67,19 @@ void InterleaveFloatsCastToShorts(Span<short> dst, CSpan<float> src1, CSpan<floa
 
 void InterleaveFloatsCastToShorts(Span<short> dst, Span<CSpan<float>> srcChannels);
 
+//! Triangular (TPDF) dither noise generator with +-1 LSB amplitude.
+//! Adding it before quantization to 16 bits turns quantization distortion of quiet signals into uncorrelated noise.
+//! Keep one instance per stream so that the noise stays continuous between calls.
+struct TpdfDither
+{
+	explicit TpdfDither(uint seed = 1);
+	uint State[4];
+};
+
+//! Same as InterleaveFloatsCastToShorts but adds TPDF dither and rounds to nearest.
+//! Samples outside [-1; 1] are saturated.
+void InterleaveFloatsCastToShorts(Span<short> dst, Span<CSpan<float>> srcChannels, TpdfDither& dither);
+
 
 void DeinterleaveFloatsCastToShorts(CSpan<float> src, Span<short> dst1, Span<short> dst2);
 void DeinterleaveFloatsCastToShorts(CSpan<float> src,
@@ -107,5 +120,10 @@ void DeinterleaveShortsCastToFloats(CSpan<short> src, Span<float> dst1, Span<flo
 
 void DeinterleaveShortsCastToFloats(CSpan<short> src, Span<Span<float>> dst);
 
+
+//! Scale samples to signed 24-bit range stored in ints, round to nearest and saturate.
+//! dst and src must have equal lengths.
+void CastFloatsToInt24(Span<int> dst, CSpan<float> src);
+
 }}
 
@@ -0,0 +1,5 @@
+#pragma once
+
+#include "Sinks/AudioFileSink.h"
+#include "Sinks/FlacSink.h"
+#include "Sinks/WaveSink.h"
@@ -0,0 +1,141 @@
+﻿#include "Audio/Sinks/AudioFileSink.h"
+#include "Audio/AudioSource.h"
+
+#include "Cpp/Intrinsics.h"
+
+#include "Math/Math.h"
+
+#include "Memory/Allocator/System.h"
+
+#include "Container/Sequential/Array.h"
+#include "Container/Sequential/String.h"
+
+#include "Utils/Debug.h"
+
+INTRA_PUSH_DISABLE_REDUNDANT_WARNINGS
+
+namespace Intra { namespace Audio { namespace Sinks {
+
+namespace {
+
+Span<byte> allocateAudioSinkBuffer(size_t bytes)
+{
+	byte* const data = Memory::PageAllocator::Allocate(bytes, INTRA_SOURCE_INFO);
+	return SpanOfPtr(data, bytes);
+}
+
+}
+
+AudioFileSink::AudioFileSink(StringView path, uint sampleRate, ushort channelCount, size_t bufferSize, ErrorStatus& status):
+	mFile(path, IO::OsFile::Mode::Write, status),
+	mBuffer(allocateAudioSinkBuffer(bufferSize)),
+	mSampleRate(sampleRate), mChannelCount(channelCount)
+{
+	INTRA_DEBUG_ASSERT(channelCount != 0);
+}
+
+AudioFileSink::~AudioFileSink()
+{
+	if(mBuffer.Begin != null) Memory::PageAllocator::Free(mBuffer.Begin, mBuffer.Length());
+}
+
+void AudioFileSink::WriteInterleaved(CSpan<float> samples, ErrorStatus& status)
+{
+	INTRA_DEBUG_ASSERT(samples.Length() % mChannelCount == 0);
+	if(!IsOpen() || samples.Empty()) return;
+	encode(samples, status);
+	mSampleCount += samples.Length()/mChannelCount;
+}
+
+ulong64 AudioFileSink::WriteFrom(IAudioSource& source, ulong64 maxSamples, ErrorStatus& status)
+{
+	INTRA_DEBUG_ASSERT(source.ChannelCount() == mChannelCount);
+	if(!IsOpen()) return 0;
+	enum: size_t {BlockSamples = 8192};
+	Array<float> block;
+	block.SetCountUninitialized(BlockSamples*mChannelCount);
+	ulong64 totalSamplesWritten = 0;
+	while(totalSamplesWritten < maxSamples && !status.WasError())
+	{
+		const size_t samplesToRead = size_t(Math::Min(ulong64(BlockSamples), maxSamples - totalSamplesWritten));
+		const size_t samplesRead = source.GetInterleavedSamples(block.AsRange().Take(samplesToRead*mChannelCount));
+		WriteInterleaved(block.AsConstRange().Take(samplesRead*mChannelCount), status);
+		totalSamplesWritten += samplesRead;
+		if(samplesRead < samplesToRead) break;
+	}
+	return totalSamplesWritten;
+}
+
+void AudioFileSink::Finish(ErrorStatus& status)
+{
+	if(!IsOpen()) return;
+	flushEncoder(status);
+	flushBuffer(status);
+	finalizeHeader(status);
+	mFile.SetSize(mFlushedBytes, status);
+	mFile = null;
+	mFinished = true;
+}
+
+void AudioFileSink::discard()
+{
+	mFile = null;
+	mFinished = true;
+}
+
+Span<byte> AudioFileSink::bufferSpace(ErrorStatus& status)
+{
+	if(mBufferUsed == mBuffer.Length()) flushBuffer(status);
+	return mBuffer.Drop(mBufferUsed);
+}
+
+void AudioFileSink::writeBytes(CSpan<byte> data, ErrorStatus& status)
+{
+	const size_t freeSpace = mBuffer.Length() - mBufferUsed;
+	if(data.Length() < freeSpace)
+	{
+		C::memcpy(mBuffer.Begin + mBufferUsed, data.Begin, data.Length());
+		mBufferUsed += data.Length();
+		return;
+	}
+
+	// Дополняем буфер до конца, чтобы записи в файл оставались выровненными по размеру буфера
+	C::memcpy(mBuffer.Begin + mBufferUsed, data.Begin, freeSpace);
+	mBufferUsed = mBuffer.Length();
+	data.Begin += freeSpace;
+	flushBuffer(status);
+
+	// Целые блоки размером с буфер записываем в файл напрямую, минуя копирование
+	const size_t directBytes = data.Length() - data.Length() % mBuffer.Length();
+	if(directBytes != 0)
+	{
+		const size_t bytesWritten = mFile.WriteData(mFlushedBytes, data.Begin, directBytes, status);
+		if(bytesWritten != directBytes)
+			status.Error(String::Concat("Cannot write ", directBytes, " bytes to ", mFile.FullPath(), "."), INTRA_SOURCE_INFO);
+		mFlushedBytes += bytesWritten;
+		data.Begin += directBytes;
+	}
+	C::memcpy(mBuffer.Begin, data.Begin, data.Length());
+	mBufferUsed = data.Length();
+}
+
+void AudioFileSink::patchFile(ulong64 offset, CSpan<byte> data, ErrorStatus& status)
+{
+	INTRA_DEBUG_ASSERT(offset + data.Length() <= mFlushedBytes);
+	if(mFile.WriteData(offset, data.Begin, data.Length(), status) != data.Length())
+		status.Error(String::Concat("Cannot update header of ", mFile.FullPath(), "."), INTRA_SOURCE_INFO);
+}
+
+void AudioFileSink::flushBuffer(ErrorStatus& status)
+{
+	if(mBufferUsed == 0) return;
+	const size_t bytesWritten = mFile.WriteData(mFlushedBytes, mBuffer.Begin, mBufferUsed, status);
+	if(bytesWritten != mBufferUsed)
+		status.Error(String::Concat("Cannot write ", mBufferUsed, " bytes to ", mFile.FullPath(), "."), INTRA_SOURCE_INFO);
+	mFlushedBytes += bytesWritten;
+	mBufferUsed = 0;
+}
+
+}}}
+
+INTRA_WARNING_POP
@@ -0,0 +1,103 @@
+﻿#pragma once
+
+#include "Cpp/Warnings.h"
+#include "Cpp/Fundamental.h"
+
+#include "Utils/Span.h"
+#include "Utils/StringView.h"
+#include "Utils/ErrorStatus.h"
+
+#include "Data/ValueType.h"
+
+#include "IO/OsFile.h"
+
+INTRA_PUSH_DISABLE_REDUNDANT_WARNINGS
+
+namespace Intra { namespace Audio {
+
+class IAudioSource;
+
+namespace Sinks {
+
+//! Базовый класс потоковой записи звука в файл.
+//! Закодированные данные накапливаются в большом буфере, выровненном по границе страницы,
+//! и записываются в файл через OsFile::WriteData блоками размера буфера по смещениям, кратным этому размеру.
+//! Заголовок, длина которого известна заранее, записывается в начало файла и исправляется в Finish.
+class AudioFileSink
+{
+public:
+	enum: size_t {DefaultBufferSize = 1 << 20};
+
+	virtual ~AudioFileSink();
+
+	AudioFileSink(const AudioFileSink&) = delete;
+	AudioFileSink& operator=(const AudioFileSink&) = delete;
+
+	forceinline uint SampleRate() const {return mSampleRate;}
+	forceinline ushort ChannelCount() const {return mChannelCount;}
+
+	//! Количество записанных семплов на канал.
+	forceinline ulong64 SampleCount() const {return mSampleCount;}
+
+	//! Количество байт, записанных в файл, включая ещё не сброшенные из буфера.
+	forceinline ulong64 ByteCount() const {return mFlushedBytes + mBufferUsed;}
+
+	forceinline bool IsOpen() const {return mFile != null && !mFinished;}
+
+	//! Записать чередующиеся каналы семплов. Длина samples должна быть кратна ChannelCount.
+	void WriteInterleaved(CSpan<float> samples, ErrorStatus& status = Error::Skip());
+
+	//! Прочитать из source не более maxSamples семплов на канал и записать их.
+	//! Количество каналов и частота дискретизации source должны совпадать с параметрами файла.
+	//! @return Количество записанных семплов на канал.
+	ulong64 WriteFrom(IAudioSource& source, ulong64 maxSamples = ~ulong64(), ErrorStatus& status = Error::Skip());
+
+	//! Закодировать оставшиеся данные, записать их в файл, исправить заголовок и закрыть файл.
+	//! Вызывается деструктором наследника, если не была вызвана явно.
+	void Finish(ErrorStatus& status = Error::Skip());
+
+protected:
+	AudioFileSink(StringView path, uint sampleRate, ushort channelCount, size_t bufferSize, ErrorStatus& status);
+
+	//! Закодировать семплы и поместить результат в буфер.
+	virtual void encode(CSpan<float> interleavedSamples, ErrorStatus& status) = 0;
+
+	//! Закодировать оставшиеся данные перед исправлением заголовка.
+	virtual void flushEncoder(ErrorStatus& status) {(void)status;}
+
+	//! Записать окончательный заголовок через patchFile. Вызывается после записи всех данных.
+	virtual void finalizeHeader(ErrorStatus& status) = 0;
+
+	//! Непустая свободная часть буфера, в которую можно кодировать данные напрямую.
+	//! Если буфер заполнен, сначала сбрасывает его в файл.
+	Span<byte> bufferSpace(ErrorStatus& status);
+
+	//! Отметить bytes байт в начале bufferSpace как записанные.
+	forceinline void commit(size_t bytes) {mBufferUsed += bytes;}
+
+	//! Записать произвольные данные через буфер. Большие данные записываются в файл напрямую.
+	void writeBytes(CSpan<byte> data, ErrorStatus& status);
+
+	//! Перезаписать уже записанные в файл байты, начиная со смещения offset.
+	void patchFile(ulong64 offset, CSpan<byte> data, ErrorStatus& status);
+
+	//! Закрыть файл, не завершая запись. Используется, если параметры записи не поддерживаются.
+	void discard();
+
+	ulong64 mSampleCount = 0;
+
+private:
+	IO::OsFile mFile;
+	Span<byte> mBuffer;
+	size_t mBufferUsed = 0;
+	ulong64 mFlushedBytes = 0;
+	uint mSampleRate;
+	ushort mChannelCount;
+	bool mFinished = false;
+
+	void flushBuffer(ErrorStatus& status);
+};
+
+}}}
+
+INTRA_WARNING_POP
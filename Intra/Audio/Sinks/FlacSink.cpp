@@ -0,0 +1,525 @@
+﻿#include "Audio/Sinks/FlacSink.h"
+
+#include "Cpp/Intrinsics.h"
+
+#include "Math/Math.h"
+
+#include "Utils/Debug.h"
+
+INTRA_PUSH_DISABLE_REDUNDANT_WARNINGS
+
+namespace Intra { namespace Audio { namespace Sinks {
+
+namespace {
+
+enum: size_t {FlacStreamHeaderSize = 4 + 4 + 34, FlacMaxPartitionOrder = 8};
+
+struct FlacCrcTables
+{
+	byte Crc8[256];
+	ushort Crc16[256];
+
+	FlacCrcTables()
+	{
+		for(uint i = 0; i < 256; i++)
+		{
+			uint c8 = i, c16 = i << 8;
+			for(int k = 0; k < 8; k++)
+			{
+				c8 = (c8 & 0x80)? (c8 << 1) ^ 0x07: c8 << 1;
+				c16 = (c16 & 0x8000)? (c16 << 1) ^ 0x8005: c16 << 1;
+			}
+			Crc8[i] = byte(c8);
+			Crc16[i] = ushort(c16);
+		}
+	}
+};
+
+const FlacCrcTables& flacCrcTables()
+{
+	static const FlacCrcTables tables;
+	return tables;
+}
+
+uint flacCrc8(CSpan<byte> data)
+{
+	const FlacCrcTables& tables = flacCrcTables();
+	uint crc = 0;
+	for(byte b: data) crc = tables.Crc8[crc ^ b];
+	return crc;
+}
+
+uint flacCrc16(CSpan<byte> data)
+{
+	const FlacCrcTables& tables = flacCrcTables();
+	uint crc = 0;
+	for(byte b: data) crc = ((crc << 8) ^ tables.Crc16[(crc >> 8) ^ b]) & 0xFFFF;
+	return crc;
+}
+
+//! Записывает биты от старших к младшим, как требует формат FLAC.
+class FlacBitWriter
+{
+public:
+	explicit FlacBitWriter(byte* dst): mBegin(dst), mPos(dst), mAcc(0), mBits(0) {}
+
+	//! Записать младшие bits бит value, bits <= 32.
+	forceinline void Put(uint value, uint bits)
+	{
+		mAcc = (mAcc << bits) | (value & ((ulong64(1) << bits) - 1));
+		mBits += bits;
+		while(mBits >= 8)
+		{
+			mBits -= 8;
+			*mPos++ = byte(mAcc >> mBits);
+		}
+	}
+
+	//! Записать код Райса с параметром k для неотрицательного значения u.
+	forceinline void PutRice(uint u, uint k)
+	{
+		uint q = u >> k;
+		const uint low = u & ((1u << k) - 1);
+		if(q + 1 + k <= 32)
+		{
+			Put((1u << k) | low, q + 1 + k);
+			return;
+		}
+		for(; q >= 32; q -= 32) Put(0, 32);
+		Put(1, q + 1);
+		Put(low, k);
+	}
+
+	void AlignToByte() {if(mBits != 0) Put(0, 8 - mBits);}
+
+	forceinline size_t BytesWritten() const {return size_t(mPos - mBegin);}
+	forceinline CSpan<byte> Written() const {return {mBegin, mPos};}
+
+private:
+	byte* mBegin;
+	byte* mPos;
+	ulong64 mAcc;
+	uint mBits;
+};
+
+//! Результат анализа канала: лучший фиксированный предсказатель и сумма модулей его остатков.
+struct FlacChannelAnalysis
+{
+	uint Order;
+	ulong64 AbsResidualSum;
+	bool Constant;
+};
+
+FlacChannelAnalysis flacAnalyzeChannel(const int* x, size_t n)
+{
+	FlacChannelAnalysis result = {0, 0, true};
+	for(size_t i = 1; i < n; i++)
+		if(x[i] != x[0])
+		{
+			result.Constant = false;
+			break;
+		}
+	if(result.Constant) return result;
+	if(n <= 4)
+	{
+		for(size_t i = 0; i < n; i++) result.AbsResidualSum += ulong64(Math::Abs(long64(x[i])));
+		return result;
+	}
+
+	// Остатки предсказателей порядков 0-4 - последовательные разности сигнала
+	ulong64 sums[5] = {0, 0, 0, 0, 0};
+	int lastErr0 = x[3];
+	int lastErr1 = x[3] - x[2];
+	int lastErr2 = lastErr1 - (x[2] - x[1]);
+	int lastErr3 = lastErr2 - (x[2] - 2*x[1] + x[0]);
+	for(size_t i = 4; i < n; i++)
+	{
+		const int err0 = x[i];
+		const int err1 = err0 - lastErr0;
+		const int err2 = err1 - lastErr1;
+		const int err3 = err2 - lastErr2;
+		const int err4 = err3 - lastErr3;
+		sums[0] += uint(Math::Abs(err0));
+		sums[1] += uint(Math::Abs(err1));
+		sums[2] += uint(Math::Abs(err2));
+		sums[3] += uint(Math::Abs(err3));
+		sums[4] += uint(Math::Abs(err4));
+		lastErr0 = err0;
+		lastErr1 = err1;
+		lastErr2 = err2;
+		lastErr3 = err3;
+	}
+	for(uint order = 1; order < 5; order++)
+		if(sums[order] < sums[result.Order]) result.Order = order;
+	result.AbsResidualSum = sums[result.Order];
+	return result;
+}
+
+forceinline uint flacZigZag(int e) {return (uint(e) << 1) ^ uint(e >> 31);}
+
+void flacFixedResidual(const int* x, size_t n, uint order, uint* residual)
+{
+	switch(order)
+	{
+	case 0: for(size_t i = 0; i < n; i++) residual[i] = flacZigZag(x[i]); break;
+	case 1: for(size_t i = 1; i < n; i++) residual[i - 1] = flacZigZag(x[i] - x[i-1]); break;
+	case 2: for(size_t i = 2; i < n; i++) residual[i - 2] = flacZigZag(x[i] - 2*x[i-1] + x[i-2]); break;
+	case 3: for(size_t i = 3; i < n; i++) residual[i - 3] = flacZigZag(x[i] - 3*x[i-1] + 3*x[i-2] - x[i-3]); break;
+	default: for(size_t i = 4; i < n; i++) residual[i - 4] = flacZigZag(x[i] - 4*x[i-1] + 6*x[i-2] - 4*x[i-3] + x[i-4]);
+	}
+}
+
+//! Выбирает параметр Райса для count значений с суммой sum.
+//! Оценка count*(k+1) + (sum >> k) не меньше точной длины кода, поэтому по ней можно сравнивать с записью без сжатия.
+uint flacRiceParameter(size_t count, ulong64 sum, ulong64& bits)
+{
+	uint k = 0;
+	while(k < 30 && (ulong64(count) << (k + 1)) < sum) k++;
+	uint best = k;
+	bits = ulong64(count)*(k + 1) + (sum >> k);
+	for(uint candidate = k > 0? k - 1: 0; candidate <= k + 1 && candidate <= 30; candidate++)
+	{
+		const ulong64 candidateBits = ulong64(count)*(candidate + 1) + (sum >> candidate);
+		if(candidateBits >= bits) continue;
+		bits = candidateBits;
+		best = candidate;
+	}
+	return best;
+}
+
+struct FlacPartitioning
+{
+	uint Order;
+	uint ParameterBits;
+	ulong64 Bits;
+	byte Parameters[1 << FlacMaxPartitionOrder];
+};
+
+//! Сумма остатков каждого раздела при разбиении на 2^partitionOrder частей.
+//! Первый раздел короче на order семплов, для которых записываются начальные значения.
+void flacPartitionSums(const uint* residual, size_t n, uint order, uint partitionOrder, ulong64* sums)
+{
+	const size_t partitionLength = n >> partitionOrder;
+	const uint* p = residual;
+	for(size_t i = 0; i < (size_t(1) << partitionOrder); i++)
+	{
+		const size_t count = partitionLength - (i == 0? order: 0);
+		ulong64 sum = 0;
+		for(size_t j = 0; j < count; j++) sum += p[j];
+		p += count;
+		sums[i] = sum;
+	}
+}
+
+void flacChoosePartitioning(const uint* residual, size_t n, uint order, FlacPartitioning& result)
+{
+	uint maxOrder = 0;
+	while(maxOrder < FlacMaxPartitionOrder && (n >> (maxOrder + 1) << (maxOrder + 1)) == n && (n >> (maxOrder + 1)) > order)
+		maxOrder++;
+
+	ulong64 sums[1 << FlacMaxPartitionOrder];
+	flacPartitionSums(residual, n, order, maxOrder, sums);
+	result.Bits = ~ulong64();
+	for(uint partitionOrder = maxOrder + 1; partitionOrder--;)
+	{
+		const size_t partitionCount = size_t(1) << partitionOrder;
+		const size_t partitionLength = n >> partitionOrder;
+		byte parameters[1 << FlacMaxPartitionOrder];
+		ulong64 bits = 0;
+		uint maxParameter = 0;
+		for(size_t i = 0; i < partitionCount; i++)
+		{
+			ulong64 partitionBits;
+			const uint k = flacRiceParameter(partitionLength - (i == 0? order: 0), sums[i], partitionBits);
+			parameters[i] = byte(k);
+			if(maxParameter < k) maxParameter = k;
+			bits += partitionBits;
+		}
+		// параметры больше 14 требуют 5-битного метода RICE2
+		const uint parameterBits = maxParameter > 14? 5: 4;
+		bits += partitionCount*parameterBits;
+		if(bits < result.Bits)
+		{
+			result.Order = partitionOrder;
+			result.ParameterBits = parameterBits;
+			result.Bits = bits;
+			C::memcpy(result.Parameters, parameters, partitionCount);
+		}
+		if(partitionOrder == 0) break;
+		// суммы следующего, более крупного разбиения получаются сложением соседних разделов
+		for(size_t i = 0; i < partitionCount/2; i++) sums[i] = sums[2*i] + sums[2*i + 1];
+	}
+}
+
+void flacEncodeSubframe(FlacBitWriter& bw, const int* x, size_t n, uint bps,
+	const FlacChannelAnalysis& analysis, uint* residual)
+{
+	if(analysis.Constant)
+	{
+		bw.Put(0, 8);
+		bw.Put(uint(x[0]), bps);
+		return;
+	}
+
+	const uint order = analysis.Order;
+	flacFixedResidual(x, n, order, residual);
+	FlacPartitioning partitioning;
+	flacChoosePartitioning(residual, n, order, partitioning);
+	const ulong64 fixedBits = ulong64(order)*bps + 2 + 4 + partitioning.Bits;
+	if(fixedBits >= ulong64(n)*bps)
+	{
+		bw.Put(1 << 1, 8);
+		for(size_t i = 0; i < n; i++) bw.Put(uint(x[i]), bps);
+		return;
+	}
+
+	bw.Put((8 + order) << 1, 8);
+	for(uint i = 0; i < order; i++) bw.Put(uint(x[i]), bps);
+	bw.Put(partitioning.ParameterBits == 5? 1: 0, 2);
+	bw.Put(partitioning.Order, 4);
+	const size_t partitionLength = n >> partitioning.Order;
+	const uint* r = residual;
+	for(size_t i = 0; i < (size_t(1) << partitioning.Order); i++)
+	{
+		const uint k = partitioning.Parameters[i];
+		bw.Put(k, partitioning.ParameterBits);
+		const size_t count = partitionLength - (i == 0? order: 0);
+		for(size_t j = 0; j < count; j++) bw.PutRice(r[j], k);
+		r += count;
+	}
+}
+
+uint flacBlockSizeCode(size_t n)
+{
+	switch(n)
+	{
+	case 192: return 1;
+	case 576: return 2;
+	case 1152: return 3;
+	case 2304: return 4;
+	case 4608: return 5;
+	case 256: return 8;
+	case 512: return 9;
+	case 1024: return 10;
+	case 2048: return 11;
+	case 4096: return 12;
+	case 8192: return 13;
+	case 16384: return 14;
+	case 32768: return 15;
+	default: return n <= 256? 6: 7;
+	}
+}
+
+//! Номер кадра кодируется так же, как символ в UTF-8.
+void flacPutUtf8(FlacBitWriter& bw, ulong64 value)
+{
+	if(value < 0x80)
+	{
+		bw.Put(uint(value), 8);
+		return;
+	}
+	uint byteCount = 2;
+	while(byteCount < 7 && value >= (ulong64(1) << (5*byteCount + 1))) byteCount++;
+	bw.Put(((0xFF00u >> byteCount) & 0xFF) | uint(value >> (6*(byteCount - 1))), 8);
+	for(uint i = byteCount - 1; i--;) bw.Put(0x80 | (uint(value >> (6*i)) & 0x3F), 8);
+}
+
+}
+
+FlacFileSink::FlacFileSink(StringView path, uint sampleRate, ushort channelCount,
+	Data::ValueType sampleType, bool dither, ErrorStatus& status, size_t blockSize, size_t bufferSize):
+	AudioFileSink(path, sampleRate, channelCount, bufferSize, status),
+	mBitsPerSample(sampleType == Data::ValueType::SNorm24? 24u: 16u), mBlockSize(blockSize), mDither(dither)
+{
+	if(sampleType != Data::ValueType::SNorm16 && sampleType != Data::ValueType::SNorm24)
+	{
+		status.Error("FLAC sink supports only SNorm16 and SNorm24 samples.", INTRA_SOURCE_INFO);
+		discard();
+		return;
+	}
+	if(channelCount > MaxChannelCount || blockSize < 16 || blockSize > 65535 || sampleRate == 0 || sampleRate >= (1u << 20))
+	{
+		status.Error("Unsupported FLAC stream parameters.", INTRA_SOURCE_INFO);
+		discard();
+		return;
+	}
+	if(!IsOpen()) return;
+
+	mBlock.SetCountUninitialized(mBlockSize*channelCount);
+	if(channelCount == 2)
+	{
+		mSide.SetCountUninitialized(mBlockSize);
+		mMid.SetCountUninitialized(mBlockSize);
+	}
+	mResidual.SetCountUninitialized(mBlockSize);
+	if(mBitsPerSample == 16) mQuantized16.SetCountUninitialized(mBlockSize*channelCount);
+	else mQuantized24.SetCountUninitialized(mBlockSize*channelCount);
+	// Кодирование без сжатия занимает не больше 4 байт на семпл канала side, остальное - заголовки
+	mFrame.SetCountUninitialized(64 + channelCount*(mBlockSize*4 + 16));
+
+	byte header[FlacStreamHeaderSize];
+	writeBytes(CSpanOf(header).Take(buildStreamInfo(header)), status);
+}
+
+FlacFileSink::~FlacFileSink() {Finish();}
+
+void FlacFileSink::encode(CSpan<float> samples, ErrorStatus& status)
+{
+	const size_t channelCount = ChannelCount();
+	while(!samples.Empty())
+	{
+		const size_t frames = Funal::Min(samples.Length()/channelCount, mBlockSize - mBlockFill);
+		const CSpan<float> part = samples.Take(frames*channelCount);
+		int* const block = mBlock.Data() + mBlockFill;
+		if(mBitsPerSample == 16)
+		{
+			const Span<short> quantized = mQuantized16.AsRange().Take(part.Length());
+			CSpan<float> channels[] = {part};
+			if(mDither) InterleaveFloatsCastToShorts(quantized, channels, mDitherState);
+			else InterleaveFloatsCastToShorts(quantized, channels);
+			for(size_t c = 0; c < channelCount; c++)
+				for(size_t i = 0; i < frames; i++)
+					block[c*mBlockSize + i] = quantized[i*channelCount + c];
+		}
+		else
+		{
+			const Span<int> quantized = mQuantized24.AsRange().Take(part.Length());
+			CastFloatsToInt24(quantized, part);
+			for(size_t c = 0; c < channelCount; c++)
+				for(size_t i = 0; i < frames; i++)
+					block[c*mBlockSize + i] = quantized[i*channelCount + c];
+		}
+		mBlockFill += frames;
+		samples.PopFirstExactly(part.Length());
+		if(mBlockFill == mBlockSize)
+		{
+			encodeFrame(mBlockSize, status);
+			mBlockFill = 0;
+		}
+	}
+}
+
+void FlacFileSink::flushEncoder(ErrorStatus& status)
+{
+	if(mBlockFill == 0) return;
+	encodeFrame(mBlockFill, status);
+	mBlockFill = 0;
+}
+
+void FlacFileSink::encodeFrame(size_t n, ErrorStatus& status)
+{
+	const uint channelCount = ChannelCount();
+	const int* channels[MaxChannelCount];
+	uint channelBits[MaxChannelCount];
+	FlacChannelAnalysis analysis[MaxChannelCount];
+	for(uint c = 0; c < channelCount; c++)
+	{
+		channels[c] = mBlock.Data() + c*mBlockSize;
+		channelBits[c] = mBitsPerSample;
+		analysis[c] = flacAnalyzeChannel(channels[c], n);
+	}
+
+	uint channelAssignment = channelCount - 1;
+	if(channelCount == 2)
+	{
+		const int* const left = channels[0];
+		const int* const right = channels[1];
+		int* const side = mSide.Data();
+		int* const mid = mMid.Data();
+		for(size_t i = 0; i < n; i++)
+		{
+			side[i] = left[i] - right[i];
+			mid[i] = (left[i] + right[i]) >> 1;
+		}
+		const FlacChannelAnalysis sideAnalysis = flacAnalyzeChannel(side, n);
+		const FlacChannelAnalysis midAnalysis = flacAnalyzeChannel(mid, n);
+		const ulong64 leftRight = analysis[0].AbsResidualSum + analysis[1].AbsResidualSum;
+		const ulong64 leftSide = analysis[0].AbsResidualSum + sideAnalysis.AbsResidualSum;
+		const ulong64 sideRight = sideAnalysis.AbsResidualSum + analysis[1].AbsResidualSum;
+		const ulong64 midSide = midAnalysis.AbsResidualSum + sideAnalysis.AbsResidualSum;
+		const ulong64 best = Funal::Min(Funal::Min(leftRight, leftSide), Funal::Min(sideRight, midSide));
+		if(best == leftRight) {}
+		else if(best == midSide)
+		{
+			channelAssignment = 10;
+			channels[0] = mid;
+			analysis[0] = midAnalysis;
+			channels[1] = side;
+			analysis[1] = sideAnalysis;
+			channelBits[1]++;
+		}
+		else if(best == leftSide)
+		{
+			channelAssignment = 8;
+			channels[1] = side;
+			analysis[1] = sideAnalysis;
+			channelBits[1]++;
+		}
+		else
+		{
+			channelAssignment = 9;
+			channels[0] = side;
+			analysis[0] = sideAnalysis;
+			channelBits[0]++;
+		}
+	}
+
+	FlacBitWriter bw(mFrame.Data());
+	bw.Put(0x3FFE, 14);
+	bw.Put(0, 1);
+	bw.Put(0, 1); // кадры фиксированного размера
+	const uint blockSizeCode = flacBlockSizeCode(n);
+	bw.Put(blockSizeCode, 4);
+	bw.Put(0, 4); // частота дискретизации берётся из STREAMINFO
+	bw.Put(channelAssignment, 4);
+	bw.Put(mBitsPerSample == 16? 4: 6, 3);
+	bw.Put(0, 1);
+	flacPutUtf8(bw, mFrameNumber);
+	if(blockSizeCode == 6) bw.Put(uint(n - 1), 8);
+	else if(blockSizeCode == 7) bw.Put(uint(n - 1), 16);
+	bw.Put(flacCrc8(bw.Written()), 8);
+
+	for(uint c = 0; c < channelCount; c++)
+		flacEncodeSubframe(bw, channels[c], n, channelBits[c], analysis[c], mResidual.Data());
+	bw.AlignToByte();
+	bw.Put(flacCrc16(bw.Written()), 16);
+
+	const uint frameSize = uint(bw.BytesWritten());
+	INTRA_DEBUG_ASSERT(frameSize <= mFrame.Length());
+	if(mFrameNumber == 0 || frameSize < mMinFrameSize) mMinFrameSize = frameSize;
+	if(frameSize > mMaxFrameSize) mMaxFrameSize = frameSize;
+	mFrameNumber++;
+	writeBytes(bw.Written(), status);
+}
+
+void FlacFileSink::finalizeHeader(ErrorStatus& status)
+{
+	byte header[FlacStreamHeaderSize];
+	patchFile(0, CSpanOf(header).Take(buildStreamInfo(header)), status);
+}
+
+size_t FlacFileSink::buildStreamInfo(Span<byte> dst) const
+{
+	INTRA_DEBUG_ASSERT(dst.Length() >= FlacStreamHeaderSize);
+	C::memcpy(dst.Begin, "fLaC", 4);
+	FlacBitWriter bw(dst.Begin + 4);
+	bw.Put(1, 1); // последний блок метаданных
+	bw.Put(0, 7); // STREAMINFO
+	bw.Put(34, 24);
+	bw.Put(uint(mBlockSize), 16);
+	bw.Put(uint(mBlockSize), 16);
+	bw.Put(mMinFrameSize, 24);
+	bw.Put(mMaxFrameSize, 24);
+	bw.Put(SampleRate(), 20);
+	bw.Put(ChannelCount() - 1u, 3);
+	bw.Put(mBitsPerSample - 1, 5);
+	bw.Put(uint(mSampleCount >> 32), 4);
+	bw.Put(uint(mSampleCount), 32);
+	for(int i = 0; i < 4; i++) bw.Put(0, 32); // MD5 не вычисляется
+	INTRA_DEBUG_ASSERT(bw.BytesWritten() + 4 == FlacStreamHeaderSize);
+	return FlacStreamHeaderSize;
+}
+
+}}}
+
+INTRA_WARNING_POP
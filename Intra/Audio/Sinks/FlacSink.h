@@ -0,0 +1,66 @@
+﻿#pragma once
+
+#include "Cpp/Warnings.h"
+
+#include "Data/ValueType.h"
+
+#include "Container/Sequential/Array.h"
+
+#include "Audio/SampleConversion.h"
+
+#include "AudioFileSink.h"
+
+INTRA_PUSH_DISABLE_REDUNDANT_WARNINGS
+
+namespace Intra { namespace Audio { namespace Sinks {
+
+//! Потоковое сжатие без потерь в формате FLAC.
+//! Семплы квантуются в 16 или 24 бита и кодируются кадрами фиксированного размера.
+//! Каждый канал кадра кодируется константой, фиксированным предсказателем порядка 0-4 с кодами Райса
+//! или без сжатия - в зависимости от того, что короче. Для стерео выбирается лучшее из раздельного, left/side, side/right и mid/side кодирования.
+//! Размеры кадров и количество семплов записываются в STREAMINFO в Finish. MD5 несжатых данных не вычисляется и остаётся нулевым.
+class FlacFileSink: public AudioFileSink
+{
+public:
+	enum: size_t {DefaultBlockSize = 4096, MaxChannelCount = 8};
+
+	//! @param sampleType Data::ValueType::SNorm16 или SNorm24.
+	//! @param dither Добавлять треугольный шум перед квантованием в 16 бит.
+	//! @param blockSize Количество семплов на канал в одном кадре, от 16 до 65535.
+	FlacFileSink(StringView path, uint sampleRate, ushort channelCount,
+		Data::ValueType sampleType = Data::ValueType::SNorm16, bool dither = true,
+		ErrorStatus& status = Error::Skip(), size_t blockSize = DefaultBlockSize, size_t bufferSize = DefaultBufferSize);
+	~FlacFileSink();
+
+	forceinline size_t BlockSize() const {return mBlockSize;}
+
+private:
+	uint mBitsPerSample;
+	size_t mBlockSize;
+	bool mDither;
+	TpdfDither mDitherState;
+
+	//! Неполный кадр: каналы идут подряд, по mBlockSize семплов на каждый.
+	Array<int> mBlock;
+	size_t mBlockFill = 0;
+
+	Array<int> mSide, mMid;
+	Array<uint> mResidual;
+	Array<short> mQuantized16;
+	Array<int> mQuantized24;
+	Array<byte> mFrame;
+
+	ulong64 mFrameNumber = 0;
+	uint mMinFrameSize = 0, mMaxFrameSize = 0;
+
+	void encode(CSpan<float> interleavedSamples, ErrorStatus& status) override;
+	void flushEncoder(ErrorStatus& status) override;
+	void finalizeHeader(ErrorStatus& status) override;
+
+	void encodeFrame(size_t sampleCount, ErrorStatus& status);
+	size_t buildStreamInfo(Span<byte> dst) const;
+};
+
+}}}
+
+INTRA_WARNING_POP
@@ -0,0 +1,169 @@
+﻿#include "Audio/Sinks/WaveSink.h"
+
+#include "Cpp/Intrinsics.h"
+
+#include "Math/Math.h"
+
+#include "Utils/Debug.h"
+
+INTRA_PUSH_DISABLE_REDUNDANT_WARNINGS
+
+namespace Intra { namespace Audio { namespace Sinks {
+
+namespace {
+
+enum: ushort {WaveFormatPcm = 1, WaveFormatIeeeFloat = 3};
+
+forceinline byte* putWaveTag(byte* dst, const char* tag)
+{
+	C::memcpy(dst, tag, 4);
+	return dst + 4;
+}
+
+forceinline byte* putWaveLE(byte* dst, ulong64 value, size_t bytes)
+{
+	for(size_t i = 0; i < bytes; i++) dst[i] = byte(value >> (8*i));
+	return dst + bytes;
+}
+
+}
+
+WaveFileSink::WaveFileSink(StringView path, uint sampleRate, ushort channelCount,
+	Data::ValueType sampleType, bool dither, ErrorStatus& status, size_t bufferSize):
+	AudioFileSink(path, sampleRate, channelCount, bufferSize, status),
+	mSampleType(sampleType), mBytesPerSample(0), mDither(dither)
+{
+	if(sampleType == Data::ValueType::SNorm16) mBytesPerSample = 2;
+	else if(sampleType == Data::ValueType::SNorm24) mBytesPerSample = 3;
+	else if(sampleType == Data::ValueType::Float) mBytesPerSample = 4;
+	else
+	{
+		status.Error("WAV sink supports only SNorm16, SNorm24 and Float samples.", INTRA_SOURCE_INFO);
+		discard();
+		return;
+	}
+	if(!IsOpen()) return;
+	byte header[MaxHeaderSize];
+	writeBytes(CSpanOf(header).Take(BuildHeader(header, sampleRate, channelCount, sampleType, 0)), status);
+}
+
+WaveFileSink::~WaveFileSink() {Finish();}
+
+size_t WaveFileSink::convertSamples(Span<byte> dst, CSpan<float> samples)
+{
+	const size_t n = Funal::Min(samples.Length(), dst.Length()/mBytesPerSample);
+	CSpan<float> src = samples.Take(n);
+	if(mBytesPerSample == 2)
+	{
+		// Данные WAV начинаются с чётного смещения, поэтому dst выровнен для short
+		const Span<short> dstShorts = SpanOfRawElements<short>(dst.Begin, n);
+		CSpan<float> channels[] = {src};
+		if(mDither) InterleaveFloatsCastToShorts(dstShorts, channels, mDitherState);
+		else InterleaveFloatsCastToShorts(dstShorts, channels);
+	}
+	else if(mBytesPerSample == 3)
+	{
+		byte* p = dst.Begin;
+		int ints[256];
+		while(!src.Empty())
+		{
+			const size_t count = Funal::Min(src.Length(), size_t(256));
+			CastFloatsToInt24(SpanOfBuffer(ints).Take(count), src.Take(count));
+			for(size_t i = 0; i < count; i++) p = putWaveLE(p, uint(ints[i]), 3);
+			src.PopFirstExactly(count);
+		}
+	}
+	else C::memcpy(dst.Begin, src.Begin, n*sizeof(float));
+	return n;
+}
+
+void WaveFileSink::encode(CSpan<float> samples, ErrorStatus& status)
+{
+	while(!samples.Empty())
+	{
+		const Span<byte> space = bufferSpace(status);
+		const size_t n = convertSamples(space, samples);
+		if(n == 0)
+		{
+			// в конце буфера не поместился целый семпл - он записывается по частям
+			byte sample[4];
+			convertSamples(sample, samples.Take(1));
+			writeBytes(CSpanOf(sample).Take(mBytesPerSample), status);
+			samples.PopFirst();
+			continue;
+		}
+		commit(n*mBytesPerSample);
+		samples.PopFirstExactly(n);
+	}
+}
+
+void WaveFileSink::flushEncoder(ErrorStatus& status)
+{
+	// чанки RIFF выравниваются по 2 байта
+	const ulong64 dataSize = mSampleCount*ChannelCount()*mBytesPerSample;
+	if(dataSize & 1)
+	{
+		const byte pad[1] = {0};
+		writeBytes(pad, status);
+	}
+}
+
+void WaveFileSink::finalizeHeader(ErrorStatus& status)
+{
+	byte header[MaxHeaderSize];
+	const size_t headerSize = BuildHeader(header, SampleRate(), ChannelCount(), mSampleType, mSampleCount);
+	patchFile(0, CSpanOf(header).Take(headerSize), status);
+}
+
+size_t WaveFileSink::BuildHeader(Span<byte> dst, uint sampleRate, ushort channelCount,
+	Data::ValueType sampleType, ulong64 sampleCount)
+{
+	INTRA_DEBUG_ASSERT(dst.Length() >= MaxHeaderSize);
+	const bool isFloat = sampleType == Data::ValueType::Float;
+	const ushort bytesPerSample = sampleType.Size();
+	const ulong64 dataSize = sampleCount*channelCount*bytesPerSample;
+	const size_t formatChunkSize = isFloat? 18: 16;
+	const size_t headerSize = 12 + (8 + 28) + (8 + formatChunkSize) + (isFloat? 12: 0) + 8;
+	const ulong64 riffSize = headerSize - 8 + dataSize + (dataSize & 1);
+	const bool rf64 = riffSize > 0xFFFFFFFFu;
+	const ushort blockAlign = ushort(bytesPerSample*channelCount);
+
+	byte* p = dst.Begin;
+	p = putWaveTag(p, rf64? "RF64": "RIFF");
+	p = putWaveLE(p, rf64? 0xFFFFFFFFu: riffSize, 4);
+	p = putWaveTag(p, "WAVE");
+
+	// Пока размер укладывается в 32 бита, место под ds64 занимает игнорируемый чанк JUNK
+	p = putWaveTag(p, rf64? "ds64": "JUNK");
+	p = putWaveLE(p, 28, 4);
+	p = putWaveLE(p, rf64? riffSize: 0, 8);
+	p = putWaveLE(p, rf64? dataSize: 0, 8);
+	p = putWaveLE(p, rf64? sampleCount: 0, 8);
+	p = putWaveLE(p, 0, 4);
+
+	p = putWaveTag(p, "fmt ");
+	p = putWaveLE(p, formatChunkSize, 4);
+	p = putWaveLE(p, isFloat? WaveFormatIeeeFloat: WaveFormatPcm, 2);
+	p = putWaveLE(p, channelCount, 2);
+	p = putWaveLE(p, sampleRate, 4);
+	p = putWaveLE(p, ulong64(sampleRate)*blockAlign, 4);
+	p = putWaveLE(p, blockAlign, 2);
+	p = putWaveLE(p, bytesPerSample*8u, 2);
+	if(isFloat)
+	{
+		p = putWaveLE(p, 0, 2);
+		// для форматов, отличных от PCM, обязателен чанк fact с количеством семплов
+		p = putWaveTag(p, "fact");
+		p = putWaveLE(p, 4, 4);
+		p = putWaveLE(p, rf64 || sampleCount > 0xFFFFFFFFu? 0xFFFFFFFFu: sampleCount, 4);
+	}
+
+	p = putWaveTag(p, "data");
+	p = putWaveLE(p, rf64? 0xFFFFFFFFu: dataSize, 4);
+	INTRA_DEBUG_ASSERT(size_t(p - dst.Begin) == headerSize);
+	return headerSize;
+}
+
+}}}
+
+INTRA_WARNING_POP
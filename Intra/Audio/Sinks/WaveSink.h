@@ -0,0 +1,52 @@
+﻿#pragma once
+
+#include "Cpp/Warnings.h"
+
+#include "Data/ValueType.h"
+
+#include "Audio/SampleConversion.h"
+
+#include "AudioFileSink.h"
+
+INTRA_PUSH_DISABLE_REDUNDANT_WARNINGS
+
+namespace Intra { namespace Audio { namespace Sinks {
+
+//! Потоковая запись WAV файла с семплами PCM 16 бит, PCM 24 бит или float 32 бит.
+//! Если размер данных превышает 4 ГБ, файл записывается в формате RF64:
+//! место под чанк ds64 заранее резервируется чанком JUNK, который заменяется при исправлении заголовка.
+class WaveFileSink: public AudioFileSink
+{
+public:
+	//! @param sampleType Data::ValueType::SNorm16, SNorm24 или Float.
+	//! @param dither Добавлять треугольный шум перед квантованием в 16 бит.
+	WaveFileSink(StringView path, uint sampleRate, ushort channelCount,
+		Data::ValueType sampleType = Data::ValueType::SNorm16, bool dither = true,
+		ErrorStatus& status = Error::Skip(), size_t bufferSize = DefaultBufferSize);
+	~WaveFileSink();
+
+	forceinline Data::ValueType SampleType() const {return mSampleType;}
+
+	enum: size_t {MaxHeaderSize = 96};
+
+	//! Записать в dst заголовок WAV или RF64 для sampleCount семплов на канал.
+	//! @return Размер заголовка, не больше MaxHeaderSize.
+	static size_t BuildHeader(Span<byte> dst, uint sampleRate, ushort channelCount,
+		Data::ValueType sampleType, ulong64 sampleCount);
+
+private:
+	Data::ValueType mSampleType;
+	ushort mBytesPerSample;
+	bool mDither;
+	TpdfDither mDitherState;
+
+	void encode(CSpan<float> interleavedSamples, ErrorStatus& status) override;
+	void flushEncoder(ErrorStatus& status) override;
+	void finalizeHeader(ErrorStatus& status) override;
+
+	size_t convertSamples(Span<byte> dst, CSpan<float> src);
+};
+
+}}}
+
+INTRA_WARNING_POP
@@ -79,7 +79,7 @@ Sound Sound::FromFile(StringView fileName, ErrorStatus& status)
 
 	Unique<IAudioSource> source;
 
-	if(fileSignature.StartsWith("RIFF"))
+	if(fileSignature.StartsWith("RIFF") || fileSignature.StartsWith("RF64"))
 		source = new Sources::Wave(null, fileMapping.AsRange());
 	else
 #if(INTRA_LIBRARY_VORBIS_DECODER != INTRA_LIBRARY_VORBIS_DECODER_None)
@@ -140,8 +140,8 @@ StreamedSound StreamedSound::FromFile(StringView fileName, size_t bufSize, Error
 	Unique<IAudioSource> source;
 	auto fileSignature = fileMapping.AsRangeOf<char>();
 #ifndef INTRA_NO_WAVE_LOADER
-	if(fileSignature.StartsWith("RIFF"))
-		source = new Sources::Wave(Funal::Value(Cpp::Move(fileMapping)), fileMapping);
+	if(fileSignature.StartsWith("RIFF") || fileSignature.StartsWith("RF64"))
+		source = new Sources::Wave(Cpp::Move(fileMapping));
 	else
 #endif
 #if(INTRA_LIBRARY_VORBIS_DECODER != INTRA_LIBRARY_VORBIS_DECODER_None)
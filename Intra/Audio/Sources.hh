@@ -1,5 +1,6 @@
 #pragma once
 
+#include "Sources/MidiRender.h"
 #include "Sources/MusicSynth.h"
 #include "Sources/Vorbis.h"
 #include "Sources/Wave.h"
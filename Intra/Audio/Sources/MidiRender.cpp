@@ -0,0 +1,268 @@
+﻿#include "Audio/Sources/MidiRender.h"
+
+#include "Cpp/Warnings.h"
+
+#include "Math/Math.h"
+
+#include "Concurrency/ParallelFor.h"
+
+#include "Audio/Midi/Messages.h"
+
+INTRA_PUSH_DISABLE_REDUNDANT_WARNINGS
+
+namespace Intra { namespace Audio { namespace Sources {
+
+#ifndef INTRA_NO_MUSIC_LOADER
+
+namespace {
+
+struct RecordedMidiEvent
+{
+	enum: byte {TypeNoteOn, TypeNoteOff, TypePitchBend, TypeAllNotesOff};
+
+	byte Type;
+	double Time;
+	union
+	{
+		Midi::NoteOn On;
+		Midi::NoteOff Off;
+		Midi::PitchBend Bend;
+		byte Channel;
+	};
+};
+
+class MidiEventRecorder: public Midi::IDevice
+{
+public:
+	Array<RecordedMidiEvent> Events;
+
+	//! Время следующего события. Нужно для OnAllNotesOff, которое не передаёт время.
+	double CurrentTime = 0;
+
+	void OnNoteOn(const Midi::NoteOn& noteOn) final
+	{
+		RecordedMidiEvent& e = add(RecordedMidiEvent::TypeNoteOn, noteOn.Time);
+		e.On = noteOn;
+	}
+
+	void OnNoteOff(const Midi::NoteOff& noteOff) final
+	{
+		RecordedMidiEvent& e = add(RecordedMidiEvent::TypeNoteOff, noteOff.Time);
+		e.Off = noteOff;
+	}
+
+	void OnPitchBend(const Midi::PitchBend& pitchBend) final
+	{
+		RecordedMidiEvent& e = add(RecordedMidiEvent::TypePitchBend, pitchBend.Time);
+		e.Bend = pitchBend;
+	}
+
+	void OnAllNotesOff(byte channel) final
+	{
+		RecordedMidiEvent& e = add(RecordedMidiEvent::TypeAllNotesOff, CurrentTime);
+		e.Channel = channel;
+	}
+
+private:
+	RecordedMidiEvent& add(byte type, double time)
+	{
+		RecordedMidiEvent& e = Events.EmplaceLast();
+		e.Type = type;
+		e.Time = time;
+		return e;
+	}
+};
+
+//! Часть песни: события [FirstEvent; EndEvent), начальное состояние колёс высоты тона и результат синтеза.
+struct MidiRenderChunk
+{
+	size_t FirstEvent, EndEvent;
+	short PitchBends[16];
+	size_t StartSample;
+	Array<float> Left, Right;
+};
+
+forceinline size_t midiRenderEventSample(double time, uint sampleRate)
+{return size_t(time*sampleRate + 0.5);}
+
+void renderMidiChunk(MidiRenderChunk& chunk, CSpan<RecordedMidiEvent> events,
+	const Synth::MidiInstrumentSet& instruments, const MidiRenderParams& params, size_t endSample)
+{
+	enum: size_t {TailBlockSize = 4096};
+	MidiSynth synth(Midi::TrackCombiner(0), Cpp::Infinity, instruments, 1, null, params.SampleRate, params.Stereo);
+	synth.SetMaxVoiceCount(params.MaxVoiceCount);
+	const double startTime = events[chunk.FirstEvent].Time;
+	for(byte channel = 0; channel < 16; channel++)
+	{
+		if(chunk.PitchBends[channel] == 0) continue;
+		synth.OnPitchBend({startTime, channel, chunk.PitchBends[channel]});
+	}
+
+	chunk.StartSample = midiRenderEventSample(startTime, params.SampleRate);
+	size_t pos = chunk.StartSample;
+	auto renderUntil = [&](size_t sample) {
+		sample = Funal::Min(sample, endSample);
+		if(sample <= pos) return;
+		const size_t from = pos - chunk.StartSample, to = sample - chunk.StartSample;
+		chunk.Left.SetCount(to);
+		if(params.Stereo) chunk.Right.SetCount(to);
+		if(synth.ActiveVoiceCount() != 0)
+			synth.RenderActiveVoices(chunk.Left.AsRange().Drop(from),
+				params.Stereo? chunk.Right.AsRange().Drop(from): null);
+		pos = sample;
+	};
+
+	for(size_t i = chunk.FirstEvent; i < events.Length(); i++)
+	{
+		const RecordedMidiEvent& e = events[i];
+		const bool own = i < chunk.EndEvent;
+		// после своей части нужны только события, которые влияют на уже звучащие голоса
+		if(!own && synth.ActiveVoiceCount() == 0) break;
+		renderUntil(midiRenderEventSample(e.Time, params.SampleRate));
+		switch(e.Type)
+		{
+		case RecordedMidiEvent::TypeNoteOn:
+			if(own) synth.OnNoteOn(e.On);
+			else if(e.On.Volume != 0)
+			{
+				// повторное нажатие той же ноты в следующей части отпускает голос этой части
+				synth.OnNoteOff({e.Time, e.On.Channel, e.On.NoteOctaveOrDrumId, 0});
+			}
+			break;
+		case RecordedMidiEvent::TypeNoteOff: synth.OnNoteOff(e.Off); break;
+		case RecordedMidiEvent::TypePitchBend: synth.OnPitchBend(e.Bend); break;
+		case RecordedMidiEvent::TypeAllNotesOff: synth.OnAllNotesOff(e.Channel); break;
+		}
+	}
+	while(synth.ActiveVoiceCount() != 0 && pos < endSample) renderUntil(pos + TailBlockSize);
+}
+
+}
+
+Array<float> RenderMidi(Midi::TrackCombiner music, const Synth::MidiInstrumentSet& instruments,
+	const MidiRenderParams& params, ThreadPool& pool, size_t* outChunkCount)
+{
+	if(outChunkCount != null) *outChunkCount = 0;
+	MidiEventRecorder recorder;
+	while(!music.Empty())
+	{
+		recorder.CurrentTime = music.NextEventTime();
+		music.ProcessEvent(recorder);
+	}
+	const CSpan<RecordedMidiEvent> events = recorder.Events.AsConstRange();
+	if(events.Empty()) return null;
+
+	// Делим песню на части. Часть начинается с нажатия ноты не раньше, чем через ChunkDuration после начала предыдущей.
+	// Если в течение половины этого времени находится момент, когда не нажата ни одна нота, граница ставится туда:
+	// тогда ноты предыдущей части почти не заходят в следующую.
+	Array<MidiRenderChunk> chunks;
+	short pitchBends[16]{};
+	bool heldKeys[16*128]{};
+	bool usedDrums[128]{};
+	size_t heldCount = 0;
+	double nextBoundary = events.First().Time;
+	for(size_t i = 0; i < events.Length(); i++)
+	{
+		const RecordedMidiEvent& e = events[i];
+		if(e.Type == RecordedMidiEvent::TypeNoteOn && e.Time >= nextBoundary &&
+			(chunks.Empty() || heldCount == 0 || e.Time >= nextBoundary + params.ChunkDuration/2))
+		{
+			if(!chunks.Empty()) chunks.Last().EndEvent = i;
+			MidiRenderChunk& chunk = chunks.EmplaceLast();
+			chunk.FirstEvent = i;
+			C::memcpy(chunk.PitchBends, pitchBends, sizeof(pitchBends));
+			nextBoundary = e.Time + params.ChunkDuration;
+		}
+		switch(e.Type)
+		{
+		case RecordedMidiEvent::TypeNoteOn:
+		{
+			if(e.On.Volume == 0) break;
+			bool& held = heldKeys[(e.On.Channel & 15)*128 + (e.On.NoteOctaveOrDrumId & 127)];
+			if(!held) heldCount++;
+			held = true;
+			if(e.On.Channel == 9) usedDrums[e.On.NoteOctaveOrDrumId & 127] = true;
+			break;
+		}
+		case RecordedMidiEvent::TypeNoteOff:
+		{
+			bool& held = heldKeys[(e.Off.Channel & 15)*128 + (e.Off.NoteOctaveOrDrumId & 127)];
+			if(held) heldCount--;
+			held = false;
+			break;
+		}
+		case RecordedMidiEvent::TypePitchBend:
+			pitchBends[e.Bend.Channel & 15] = e.Bend.Pitch;
+			break;
+		case RecordedMidiEvent::TypeAllNotesOff:
+			for(bool& held: Span<bool>(heldKeys + (e.Channel & 15)*128, 128))
+			{
+				if(held) heldCount--;
+				held = false;
+			}
+			break;
+		}
+	}
+	if(chunks.Empty()) return null;
+	chunks.Last().EndEvent = events.Length();
+	if(outChunkCount != null) *outChunkCount = chunks.Length();
+
+	// Ударные инструменты генерируют свои семплы при первом вызове, а это не потокобезопасно
+	for(size_t id = 0; id < 128; id++)
+	{
+		if(!usedDrums[id] || instruments.DrumInstruments[id] == null) continue;
+		(*instruments.DrumInstruments[id])(1, params.SampleRate);
+	}
+
+	const size_t endSample = midiRenderEventSample(events.Last().Time + params.TailDuration, params.SampleRate);
+	ParallelFor(pool, chunks.Length(), [&](size_t begin, size_t end) {
+		for(size_t i = begin; i < end; i++) renderMidiChunk(chunks[i], events, instruments, params, endSample);
+	}, 1);
+
+	// Складываем части блоками, каждый блок в своём потоке, перебирая части всегда в одном порядке
+	enum: size_t {MixBlockSize = 1 << 16};
+	const size_t channelCount = params.Stereo? 2: 1;
+	size_t totalSamples = 0;
+	for(const MidiRenderChunk& chunk: chunks)
+		totalSamples = Funal::Max(totalSamples, chunk.StartSample + chunk.Left.Length());
+	Array<float> result;
+	result.SetCount(totalSamples*channelCount);
+	const size_t blockCount = (totalSamples + MixBlockSize - 1)/MixBlockSize;
+	Array<float> blockPeaks;
+	blockPeaks.SetCount(blockCount);
+	ParallelFor(pool, blockCount, [&](size_t beginBlock, size_t endBlock) {
+		for(size_t block = beginBlock; block < endBlock; block++)
+		{
+			const size_t blockStart = block*MixBlockSize;
+			const size_t blockEnd = Funal::Min(blockStart + MixBlockSize, totalSamples);
+			for(const MidiRenderChunk& chunk: chunks)
+			{
+				const size_t from = Funal::Max(blockStart, chunk.StartSample);
+				const size_t to = Funal::Min(blockEnd, chunk.StartSample + chunk.Left.Length());
+				for(size_t s = from; s < to; s++)
+				{
+					result[s*channelCount] += chunk.Left[s - chunk.StartSample];
+					if(channelCount == 2) result[s*2 + 1] += chunk.Right[s - chunk.StartSample];
+				}
+			}
+			float peak = 0;
+			for(size_t i = blockStart*channelCount; i < blockEnd*channelCount; i++)
+				peak = Math::Max(peak, Math::Abs(result[i]));
+			blockPeaks[block] = peak;
+		}
+	}, 1);
+
+	float peak = params.MaxVolume;
+	for(float blockPeak: blockPeaks) peak = Math::Max(peak, blockPeak);
+	const float gain = 1.0f/peak;
+	ParallelFor(pool, result.Length(), [&](size_t begin, size_t end) {
+		for(size_t i = begin; i < end; i++) result[i] *= gain;
+	}, MixBlockSize);
+	return result;
+}
+
+#endif
+
+}}}
+
+INTRA_WARNING_POP
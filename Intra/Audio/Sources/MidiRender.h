@@ -0,0 +1,55 @@
+﻿#pragma once
+
+#include "Cpp/Warnings.h"
+
+#include "Container/Sequential/Array.h"
+
+#include "Concurrency/ThreadPool.h"
+
+#include "Audio/Midi/TrackCombiner.h"
+#include "Audio/Synth/InstrumentSet.h"
+#include "Audio/Sources/MidiSynth.h"
+
+namespace Intra { namespace Audio { namespace Sources {
+
+#ifndef INTRA_NO_MUSIC_LOADER
+
+INTRA_PUSH_DISABLE_REDUNDANT_WARNINGS
+
+//! Параметры синтеза MIDI целиком функцией RenderMidi.
+struct MidiRenderParams
+{
+	uint SampleRate = 48000;
+	bool Stereo = true;
+
+	//! Начальная оценка максимальной амплитуды, как у MidiSynth.
+	//! Результат делится на максимум из неё и пиковой амплитуды всей песни.
+	float MaxVolume = 1;
+
+	//! Примерная длительность в секундах частей, которые синтезируются параллельно.
+	double ChunkDuration = 4;
+
+	//! Сколько секунд после последнего события доигрываются отпущенные ноты.
+	double TailDuration = 2;
+
+	//! Размер пула голосов каждой части.
+	size_t MaxVoiceCount = MidiSynth::DefaultMaxVoiceCount;
+};
+
+//! Синтезировать MIDI целиком, разделив песню на части, которые синтезируются параллельно в потоках пула pool.
+//! События заранее считываются из music. Части начинаются с нажатия ноты, предпочтительно в момент, когда не звучит ни одна нажатая нота.
+//! Каждая часть синтезирует только ноты, начавшиеся в ней, и доигрывает их до конца,
+//! получая их отпускания и изменения высоты тона из следующих частей.
+//! Голоса независимы, поэтому части просто складываются с перекрытием и не требуют перекрёстного затухания.
+//! Результат отличается от последовательного синтеза только тогда, когда в одной части не хватает голосов.
+//! @param outChunkCount Если не null, сюда записывается количество частей, на которые была разделена песня.
+//! @return Чередующиеся каналы семплов.
+Array<float> RenderMidi(Midi::TrackCombiner music, const Synth::MidiInstrumentSet& instruments,
+	const MidiRenderParams& params = MidiRenderParams(), ThreadPool& pool = ThreadPool::Default(),
+	size_t* outChunkCount = null);
+
+INTRA_WARNING_POP
+
+#endif
+
+}}}
@@ -9,6 +9,9 @@
 #include "Range/Mutation/Fill.h"
 #include "Range/Reduction.h"
 #include "Range/Mutation/Transform.h"
+#include "Range/Mutation/Copy.h"
+
+#include "Concurrency/Job.h"
 
 #include "IO/FileSystem.h"
 #include "IO/FileReader.h"
@@ -33,9 +36,46 @@ MidiSynth::MidiSynth(Midi::TrackCombiner music, double duration, const Synth::Mi
 	mTime(0),
 	mSampleCount(duration == Cpp::Infinity? ~size_t(): size_t((duration+2)*sampleRate)),
 	mMaxSample(maxVolume)
-{}
+{
+	SetMaxVoiceCount(DefaultMaxVoiceCount);
+}
+
+namespace {
+
+forceinline size_t heldVoiceIndex(byte channel, byte noteOctaveOrDrumId)
+{return size_t(channel & 15)*128 + (noteOctaveOrDrumId & 127);}
+
+}
+
+void MidiSynth::SetMaxVoiceCount(size_t maxVoices)
+{
+	INTRA_DEBUG_ASSERT(maxVoices >= 1 && maxVoices <= MaxVoiceCountLimit);
+	mVoicePool.Clear();
+	mVoicePool.SetCount(maxVoices);
+	// типичному инструменту хватает этой памяти, поэтому переиспользуемые голоса не выделяют её в процессе синтеза
+	for(auto& voice: mVoicePool)
+	{
+		voice.Sampler.WaveTableSamplers.Reserve(4);
+		voice.Sampler.GenericSamplers.Reserve(2);
+		voice.Sampler.Modifiers.Reserve(4);
+	}
+	mFreeVoices.Clear();
+	mFreeVoices.Reserve(maxVoices);
+	for(size_t i = maxVoices; i--;) mFreeVoices.AddLast(ushort(i));
+	mActiveVoices.Clear();
+	mActiveVoices.Reserve(maxVoices);
+	for(short& index: mHeldVoices) index = -1;
+	mVoices.Reserve(maxVoices);
+	mVoiceFinished.Reserve(maxVoices);
+}
+
+void MidiSynth::SetThreadPool(ThreadPool* pool)
+{
+	mThreadPool = pool;
+	if(pool != null) mScratch.Reserve(ParallelLaneCount*2*ParallelBlockSize);
+}
 
-bool MidiSynth::synthNote(Synth::NoteSampler& sampler, Span<float> dstLeft, Span<float> dstRight, bool add)
+bool MidiSynth::synthNote(Synth::NoteSampler& sampler, Span<float> dstLeft, Span<float> dstRight, bool add) const
 {
 	Span<float> dstLeftStart = dstLeft;
 	size_t samplesProcessed;
@@ -81,25 +121,13 @@ size_t MidiSynth::GetUninterleavedSamples(CSpan<Span<float>> outFloatChannels)
 		const size_t samplesLeft = SamplesLeft();
 		if(samplesLeft == 0) break;
 		samplesBeforeNextEvent = Funal::Min(samplesBeforeNextEvent, samplesLeft);
-		bool add = false;
 		const auto dstLeftBeforeEvent = dstLeft.Take(samplesBeforeNextEvent);
 		const auto dstRightBeforeEvent = dstRight.Take(samplesBeforeNextEvent);
-		Array<NoteMap::iterator> notesToRemove;
-		for(size_t i=0; i<mOffPlayingNotes.Length(); i++)
-		{
-			const bool removeThisNote = synthNote(mOffPlayingNotes[i].Sampler, dstLeftBeforeEvent, dstRightBeforeEvent, add);
-			if(removeThisNote) mOffPlayingNotes.RemoveUnordered(i--);
-			add = true;
-		}
-		int i = 0;
-		for(auto it = mPlayingNotes.begin(); it != mPlayingNotes.end(); ++it)
-		{
-			const bool removeThisNote = synthNote(it->Value.Sampler, dstLeftBeforeEvent, dstRightBeforeEvent, add);
-			if(removeThisNote) notesToRemove.AddLast(it);
-			add = true;
-			i++;
-		}
-		for(auto it: notesToRemove) mPlayingNotes.Remove(it);
+		const bool parallel = mThreadPool != null && mThreadPool->ThreadCount() != 0 &&
+			mActiveVoices.Length() >= 2;
+		const bool add = parallel?
+			synthVoicesParallel(dstLeftBeforeEvent, dstRightBeforeEvent):
+			synthVoices(dstLeftBeforeEvent, dstRightBeforeEvent);
 		if(!add)
 		{
 			FillZeros(dstLeftBeforeEvent);
@@ -126,7 +154,7 @@ size_t MidiSynth::GetUninterleavedSamples(CSpan<Span<float>> outFloatChannels)
 		dstRight.PopFirstExactly(dstRightBeforeEvent.Length());
 		totalSamplesProcessed += dstLeftBeforeEvent.Length();
 		mTime += double(dstLeftBeforeEvent.Length())/mSampleRate;
-		if(mPlayingNotes.Empty() && mOffPlayingNotes.Empty() && nextTime == Cpp::Infinity)
+		if(mActiveVoices.Empty() && nextTime == Cpp::Infinity)
 		{
 			if(dstLeft.Empty() && totalSamplesProcessed != 0) totalSamplesProcessed--;
 			break;
@@ -136,42 +164,210 @@ size_t MidiSynth::GetUninterleavedSamples(CSpan<Span<float>> outFloatChannels)
 	return totalSamplesProcessed;
 }
 
+void MidiSynth::RenderActiveVoices(Span<float> dstLeft, Span<float> dstRight)
+{
+	const bool parallel = mThreadPool != null && mThreadPool->ThreadCount() != 0 &&
+		mActiveVoices.Length() >= 2;
+	const bool add = parallel?
+		synthVoicesParallel(dstLeft, dstRight):
+		synthVoices(dstLeft, dstRight);
+	if(!add)
+	{
+		FillZeros(dstLeft);
+		FillZeros(dstRight);
+	}
+	mTime += double(dstLeft.Length())/mSampleRate;
+}
+
+bool MidiSynth::synthVoices(Span<float> dstLeft, Span<float> dstRight)
+{
+	const size_t voiceCount = mActiveVoices.Length();
+	mVoiceFinished.Clear();
+	mVoiceFinished.SetCount(voiceCount, false);
+	bool add = false;
+	for(size_t i = 0; i < voiceCount; i++)
+	{
+		if(synthNote(mVoicePool[mActiveVoices[i]].Sampler, dstLeft, dstRight, add)) mVoiceFinished[i] = true;
+		add = true;
+	}
+	removeFinishedVoices();
+	return add;
+}
+
+bool MidiSynth::synthVoicesParallel(Span<float> dstLeft, Span<float> dstRight)
+{
+	mVoices.Clear();
+	for(ushort index: mActiveVoices) mVoices.AddLast(&mVoicePool[index].Sampler);
+	const size_t voiceCount = mVoices.Length();
+	if(voiceCount == 0) return false;
+	mVoiceFinished.Clear();
+	mVoiceFinished.SetCount(voiceCount, false);
+
+	// Голоса распределяются по дорожкам чередованием, каждая дорожка синтезируется одной задачей в свой буфер.
+	// Число дорожек не зависит от числа потоков, поэтому результат одинаков на любом пуле с потоками.
+	// От последовательного синтеза он отличается только ошибкой округления из-за другого порядка сложения голосов.
+	const size_t laneCount = Funal::Min(voiceCount, size_t(ParallelLaneCount));
+	const size_t channelCount = mChannelCount >= 2? 2u: 1u;
+	const size_t blockSize = Funal::Min(dstLeft.Length(), size_t(ParallelBlockSize));
+	const size_t laneStride = channelCount*blockSize;
+	mScratch.SetCountUninitialized(laneCount*laneStride);
+
+	while(!dstLeft.Empty())
+	{
+		const size_t len = Funal::Min(dstLeft.Length(), blockSize);
+#if(INTRA_LIBRARY_THREAD != INTRA_LIBRARY_THREAD_None)
+		// Задачи создаются в заранее выделенной памяти: ParallelFor выделял бы их в куче на каждом блоке
+		Job* jobs[ParallelLaneCount];
+		for(size_t lane = 1; lane < laneCount; lane++)
+		{
+			const LaneTask task = {this, uint(lane), uint(laneCount), uint(len), uint(blockSize)};
+			jobs[lane] = Job::CreateIn(mLaneJobs[lane], *mThreadPool, &synthLaneJob, CSpanOfRaw(&task, sizeof(task)));
+			jobs[lane]->Run();
+		}
+		synthLane(0, laneCount, len, blockSize);
+		for(size_t lane = 1; lane < laneCount; lane++) jobs[lane]->Wait();
+#else
+		for(size_t lane = 0; lane < laneCount; lane++) synthLane(lane, laneCount, len, blockSize);
+#endif
+
+		const Span<float> left = dstLeft.Take(len);
+		const Span<float> right = dstRight.Take(len);
+		CopyTo(mScratch.AsConstRange().Take(len), left);
+		if(channelCount >= 2) CopyTo(mScratch.AsConstRange().Drop(blockSize).Take(len), right);
+		for(size_t lane = 1; lane < laneCount; lane++)
+		{
+			Add(left, mScratch.AsConstRange().Drop(lane*laneStride).Take(len));
+			if(channelCount >= 2) Add(right, mScratch.AsConstRange().Drop(lane*laneStride + blockSize).Take(len));
+		}
+		dstLeft.PopFirstExactly(len);
+		dstRight = dstRight.Drop(len);
+	}
+
+	removeFinishedVoices();
+	return true;
+}
+
+void MidiSynth::synthLane(size_t lane, size_t laneCount, size_t len, size_t blockSize)
+{
+	const size_t laneStride = (mChannelCount >= 2? 2u: 1u)*blockSize;
+	const Span<float> laneLeft = mScratch.AsRange().Drop(lane*laneStride).Take(len);
+	const Span<float> laneRight = mChannelCount >= 2? mScratch.AsRange().Drop(lane*laneStride + blockSize).Take(len): null;
+	bool add = false;
+	for(size_t v = lane; v < mVoices.Length(); v += laneCount)
+	{
+		if(mVoiceFinished[v]) continue;
+		if(synthNote(*mVoices[v], laneLeft, laneRight, add)) mVoiceFinished[v] = true;
+		add = true;
+	}
+	if(!add)
+	{
+		FillZeros(laneLeft);
+		FillZeros(laneRight);
+	}
+}
+
+#if(INTRA_LIBRARY_THREAD != INTRA_LIBRARY_THREAD_None)
+void MidiSynth::synthLaneJob(Job*, const void* data)
+{
+	const LaneTask& task = *static_cast<const LaneTask*>(data);
+	task.Synth->synthLane(task.Lane, task.LaneCount, task.Len, task.BlockSize);
+}
+#endif
+
+void MidiSynth::removeFinishedVoices()
+{
+	// Сохраняем порядок оставшихся голосов, чтобы первыми вытеснялись самые старые
+	size_t kept = 0;
+	for(size_t i = 0; i < mActiveVoices.Length(); i++)
+	{
+		const ushort index = mActiveVoices[i];
+		if(!mVoiceFinished[i])
+		{
+			mActiveVoices[kept++] = index;
+			continue;
+		}
+		const Voice& voice = mVoicePool[index];
+		if(!voice.Released) mHeldVoices[heldVoiceIndex(voice.Channel, voice.NoteOctaveOrDrumId)] = -1;
+		mFreeVoices.AddLast(index);
+	}
+	while(mActiveVoices.Length() > kept) mActiveVoices.RemoveLast();
+}
+
+MidiSynth::Voice& MidiSynth::allocateVoice()
+{
+	ushort index;
+	if(!mFreeVoices.Empty())
+	{
+		index = mFreeVoices.Last();
+		mFreeVoices.RemoveLast();
+	}
+	else
+	{
+		// Все голоса заняты: вытесняем самый старый отпущенный голос, а если таких нет - самый старый
+		size_t pos = 0;
+		for(size_t i = 0; i < mActiveVoices.Length(); i++)
+		{
+			if(!mVoicePool[mActiveVoices[i]].Released) continue;
+			pos = i;
+			break;
+		}
+		index = mActiveVoices[pos];
+		const Voice& victim = mVoicePool[index];
+		if(!victim.Released) mHeldVoices[heldVoiceIndex(victim.Channel, victim.NoteOctaveOrDrumId)] = -1;
+		mActiveVoices.Remove(pos);
+	}
+	mActiveVoices.AddLast(index);
+	return mVoicePool[index];
+}
+
+void MidiSynth::releaseHeldVoice(byte channel, byte noteOctaveOrDrumId)
+{
+	short& held = mHeldVoices[heldVoiceIndex(channel, noteOctaveOrDrumId)];
+	if(held < 0) return;
+	Voice& voice = mVoicePool[size_t(held)];
+	voice.Released = true;
+	voice.Sampler.NoteRelease();
+	held = -1;
+}
+
 void MidiSynth::OnNoteOn(const Midi::NoteOn& noteOn)
 {
 	if(noteOn.Volume == 0) return;
-	const ushort id = noteOn.Id();
-	NoteEntry* newNote = null;
-	auto found = mPlayingNotes.Find(id);
-	if(!found.Empty())
+	const size_t heldIndex = heldVoiceIndex(noteOn.Channel, noteOn.NoteOctaveOrDrumId);
+	const short held = mHeldVoices[heldIndex];
+	if(held >= 0)
 	{
-		if(Math::Abs(found.First().Value.Time - noteOn.Time) < 0.0001) return;
-		found.First().Value.Sampler.NoteRelease();
-		mOffPlayingNotes.AddLast(Cpp::Move(found.First().Value));
+		if(Math::Abs(mVoicePool[size_t(held)].Time - noteOn.Time) < 0.0001) return;
+		releaseHeldVoice(noteOn.Channel, noteOn.NoteOctaveOrDrumId);
 	}
+	const Synth::MusicalInstrument* instr = null;
+	const Synth::GenericDrumInstrument* drum = null;
 	if(noteOn.Channel != 9)
 	{
-		auto instr = mInstruments.Instruments[noteOn.Instrument];
+		instr = mInstruments.Instruments[noteOn.Instrument];
 		if(instr == null) return;
-		newNote = &mPlayingNotes[id];
-		newNote->Sampler = (*instr)(noteOn.Frequency(), noteOn.TotalVolume(), mSampleRate);
 	}
 	else
 	{
-		auto instr = mInstruments.DrumInstruments[noteOn.NoteOctaveOrDrumId];
-		if(instr == null) return;
-		newNote = &mPlayingNotes[id];
-		newNote->Sampler = Synth::NoteSampler();
-		newNote->Sampler.GenericSamplers.AddLast((*instr)(noteOn.TotalVolume(), mSampleRate));
+		drum = mInstruments.DrumInstruments[noteOn.NoteOctaveOrDrumId];
+		if(drum == null) return;
 	}
-	if(newNote)
+
+	Voice& voice = allocateVoice();
+	if(instr != null) (*instr)(voice.Sampler, noteOn.Frequency(), noteOn.TotalVolume(), mSampleRate);
+	else
 	{
-		newNote->Channel = noteOn.Channel;
-		newNote->Time = noteOn.Time;
-		newNote->NoteOctaveOrDrumId = noteOn.NoteOctaveOrDrumId;
-		newNote->Sampler.SetPan(noteOn.Pan/64.0f);
-		const float freqMult = pitchBendToFreqMultiplier(mCurrentPitchBend[noteOn.Channel]);
-		newNote->Sampler.MultiplyPitch(freqMult);
+		voice.Sampler.Reset();
+		voice.Sampler.GenericSamplers.AddLast((*drum)(noteOn.TotalVolume(), mSampleRate));
 	}
+	voice.Channel = noteOn.Channel;
+	voice.Time = noteOn.Time;
+	voice.NoteOctaveOrDrumId = noteOn.NoteOctaveOrDrumId;
+	voice.Released = false;
+	voice.Sampler.SetPan(noteOn.Pan/64.0f);
+	const float freqMult = pitchBendToFreqMultiplier(mCurrentPitchBend[noteOn.Channel]);
+	voice.Sampler.MultiplyPitch(freqMult);
+	mHeldVoices[heldIndex] = short(&voice - mVoicePool.Data());
 }
 
 float MidiSynth::pitchBendToFreqMultiplier(short relativePitchBend) const
@@ -181,13 +377,7 @@ float MidiSynth::pitchBendToFreqMultiplier(short relativePitchBend) const
 
 void MidiSynth::OnNoteOff(const Midi::NoteOff& noteOff)
 {
-	auto found = mPlayingNotes.Find(noteOff.Id());
-	if(!found.Empty())
-	{
-		auto& note = mOffPlayingNotes.AddLast(Cpp::Move(found.First().Value));
-		note.Sampler.NoteRelease();
-		mPlayingNotes.Remove(NoteMap::const_iterator(found));
-	}
+	releaseHeldVoice(noteOff.Channel, noteOff.NoteOctaveOrDrumId);
 }
 
 void MidiSynth::OnPitchBend(const Midi::PitchBend& pitchBend)
@@ -195,24 +385,22 @@ void MidiSynth::OnPitchBend(const Midi::PitchBend& pitchBend)
 	const short shift = short(pitchBend.Pitch - mCurrentPitchBend[pitchBend.Channel]);
 	mCurrentPitchBend[pitchBend.Channel] = pitchBend.Pitch;
 	const float freqMult = pitchBendToFreqMultiplier(shift);
-	for(auto& note: mPlayingNotes)
+	for(ushort index: mActiveVoices)
 	{
-		if((note.Key >> 8) != pitchBend.Channel) continue;
-		note.Value.Sampler.MultiplyPitch(freqMult);
+		Voice& voice = mVoicePool[index];
+		if(voice.Released || voice.Channel != pitchBend.Channel) continue;
+		voice.Sampler.MultiplyPitch(freqMult);
 	}
 }
 
 void MidiSynth::OnAllNotesOff(byte channel)
 {
-	Array<NoteMap::iterator> notesToRemove;
-	for(auto it = mPlayingNotes.begin(); it != mPlayingNotes.end(); ++it)
+	for(ushort index: mActiveVoices)
 	{
-		if((it->Key >> 8) != channel) continue;
-		it->Value.Sampler.NoteRelease();
-		mOffPlayingNotes.AddLast(Cpp::Move(it->Value));
-		notesToRemove.AddLast(it);
+		const Voice& voice = mVoicePool[index];
+		if(voice.Released || voice.Channel != channel) continue;
+		releaseHeldVoice(voice.Channel, voice.NoteOctaveOrDrumId);
 	}
-	for(auto it: notesToRemove) mPlayingNotes.Remove(it);
 }
 
 Unique<MidiSynth> MidiSynth::FromFile(StringView path, double duration, const Synth::MidiInstrumentSet& instruments,
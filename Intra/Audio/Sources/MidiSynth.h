@@ -5,7 +5,8 @@
 #include "Utils/FixedArray.h"
 #include "Utils/ErrorStatus.h"
 
-#include "Container/Associative/HashMap.h"
+
+#include "Concurrency/ThreadPool.h"
 
 #include "Audio/AudioSource.h"
 #include "Audio/Synth/Types.h"
@@ -31,19 +32,49 @@ class MidiSynth: public SeparateFloatAudioSource, public Midi::IDevice
 	short mCurrentPitchBend[16]{};
 	ushort mPitchBendRangeInSemitones = 2;
 
-	struct NoteEntry
+	//! Голос - звучащая нота. Голоса берутся из пула фиксированного размера, выделенного заранее,
+	//! и переиспользуются вместе с памятью их сэмплеров, поэтому синтез не выделяет память для управления нотами.
+	struct Voice
 	{
-		double Time;
-		byte Channel;
-		byte NoteOctaveOrDrumId;
+		double Time = 0;
+		byte Channel = 0;
+		byte NoteOctaveOrDrumId = 0;
+		bool Released = false;
 		Synth::NoteSampler Sampler;
 	};
 
-	typedef Container::HashMap<ushort, NoteEntry> NoteMap;
-	NoteMap mPlayingNotes;
-	Array<NoteEntry> mOffPlayingNotes;
+	Array<Voice> mVoicePool;
+	Array<ushort> mFreeVoices;
+
+	//! Индексы звучащих голосов в порядке начала нот. При нехватке голосов вытесняется самый старый отпущенный голос или самый старый голос.
+	Array<ushort> mActiveVoices;
+
+	//! Индекс голоса нажатой ноты по её Id (канал*128 + нота) или -1.
+	short mHeldVoices[16*128];
+
+	//! Память, переиспользуемая между интервалами синтеза, чтобы не выделять её заново.
+	Array<Synth::NoteSampler*> mVoices;
+	Array<bool> mVoiceFinished;
+	Array<float> mScratch;
+
+	ThreadPool* mThreadPool = null;
+
+	//! Максимальная длина блока, синтезируемого за одну параллельную задачу.
+	//! Ограничивает размер буферов потоков, чтобы они помещались в кеш.
+	enum: size_t {ParallelBlockSize = 2048};
+
+	//! Число дорожек параллельного синтеза. Не зависит от числа потоков пула,
+	//! чтобы порядок суммирования голосов, а значит и результат, был одинаковым на любом пуле.
+	enum: size_t {ParallelLaneCount = 16};
+
+#if(INTRA_LIBRARY_THREAD != INTRA_LIBRARY_THREAD_None)
+	//! Память задач дорожек. Задачи создаются в ней заново для каждого блока, поэтому параллельный синтез не выделяет память.
+	Concurrency::JobStorage mLaneJobs[ParallelLaneCount];
+#endif
 
 public:
+	enum: size_t {DefaultMaxVoiceCount = 256, MaxVoiceCountLimit = 32767};
+
 	MidiSynth(Midi::TrackCombiner music, double duration, const Synth::MidiInstrumentSet& instruments, float maxVolume=1,
 		OnCloseResourceCallback onClose=null, uint sampleRate=48000, bool stereo=true);
 	~MidiSynth() {}
@@ -59,14 +90,40 @@ public:
 
 	size_t GetUninterleavedSamples(CSpan<Span<float>> outFloats) final;
 
+	//! Синтезировать голоса параллельно в потоках пула pool.
+	//! Голоса распределяются по ParallelLaneCount дорожкам, каждая дорожка пишет в свой буфер, затем буферы суммируются.
+	//! null - синтезировать все голоса в вызывающем потоке.
+	void SetThreadPool(ThreadPool* pool);
+	ThreadPool* GetThreadPool() const {return mThreadPool;}
+
+	//! Устанавливает максимальное число одновременно звучащих голосов и выделяет для них память.
+	//! Звучащие ноты при этом обрываются, поэтому менять размер пула нужно до начала синтеза.
+	void SetMaxVoiceCount(size_t maxVoices);
+	size_t MaxVoiceCount() const {return mVoicePool.Length();}
+	size_t ActiveVoiceCount() const {return mActiveVoices.Length();}
+
+	//! Синтезировать звучащие голоса в dstLeft и dstRight, не обрабатывая события музыки и не нормализуя громкость.
+	//! Нужен, когда события подаются напрямую через методы IDevice, например при синтезе песни по частям.
+	void RenderActiveVoices(Span<float> dstLeft, Span<float> dstRight);
+
 	void OnNoteOn(const Midi::NoteOn& noteOn) final;
 	void OnNoteOff(const Midi::NoteOff& noteOff) final;
 	void OnPitchBend(const Midi::PitchBend& pitchBend) final;
 	void OnAllNotesOff(byte channel) final;
 
 private:
-	bool synthNote(Synth::NoteSampler& sampler, Span<float> dstLeft, Span<float> dstRight, bool add);
+	bool synthNote(Synth::NoteSampler& sampler, Span<float> dstLeft, Span<float> dstRight, bool add) const;
+	bool synthVoices(Span<float> dstLeft, Span<float> dstRight);
+	bool synthVoicesParallel(Span<float> dstLeft, Span<float> dstRight);
+	void synthLane(size_t lane, size_t laneCount, size_t len, size_t blockSize);
+#if(INTRA_LIBRARY_THREAD != INTRA_LIBRARY_THREAD_None)
+	struct LaneTask {MidiSynth* Synth; uint Lane, LaneCount, Len, BlockSize;};
+	static void synthLaneJob(Job* job, const void* data);
+#endif
 	float pitchBendToFreqMultiplier(short relativePitchBend) const;
+	Voice& allocateVoice();
+	void releaseHeldVoice(byte channel, byte noteOctaveOrDrumId);
+	void removeFinishedVoices();
 };
 
 
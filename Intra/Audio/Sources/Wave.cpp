@@ -9,6 +9,8 @@
 
 #include "Range/Mutation/Cast.h"
 
+#include "Funal/ValueRef.h"
+
 INTRA_PUSH_DISABLE_REDUNDANT_WARNINGS
 
 namespace Intra { namespace Audio { namespace Sources {
@@ -30,39 +32,91 @@ struct WaveHeader
 	uintLE DataSize;
 };
 
+struct WaveFormatChunk
+{
+	ushortLE FormatTag, Channels;
+	uintLE SampleRate, BytesPerSec;
+	ushortLE BlockAlign, BitsPerSample;
+};
+
+
+namespace {
+
+enum: ushort {WaveFormatTagPcm = 1, WaveFormatTagIeeeFloat = 3, WaveFormatTagExtensible = 0xFFFE};
+
+forceinline int waveReadSNorm24(const byte* src)
+{return int(uint(src[0]) << 8 | uint(src[1]) << 16 | uint(src[2]) << 24) >> 8;}
+
+}
 
 Wave::Wave(OnCloseResourceCallback onClose, CSpan<byte> srcFileData):
-	BasicAudioSource(Cpp::Move(onClose))
+	BasicAudioSource(Cpp::Move(onClose)), mDataType(Data::ValueType::Void)
 {
-	const WaveHeader& header = *reinterpret_cast<const WaveHeader*>(srcFileData.Begin);
+	if(srcFileData.Length() < 12) return;
+	const bool isRf64 = C::memcmp(srcFileData.Begin, "RF64", 4) == 0;
+	if((!isRf64 && C::memcmp(srcFileData.Begin, "RIFF", 4) != 0) ||
+		C::memcmp(srcFileData.Begin + 8, "WAVE", 4) != 0) return;
 
-	const bool isValidHeader = (C::memcmp(header.RIFF, "RIFF", sizeof(header.RIFF)) == 0 &&
-		C::memcmp(header.WAVE, "WAVE", sizeof(header.WAVE)) == 0 &&
-		C::memcmp(header.fmt, "fmt ", sizeof(header.fmt)) == 0 &&
-		C::memcmp(header.data, "data", sizeof(header.data)) == 0);
-	
-	if(!isValidHeader) return;
+	// Перебираем чанки: между fmt и data могут быть JUNK, LIST, fact и другие.
+	// В RF64 настоящий размер данных лежит в чанке ds64, а в заголовке data записано 0xFFFFFFFF.
+	CSpan<byte> fmt, data;
+	ulong64 ds64DataSize = 0;
+	bool hasDs64 = false;
+	CSpan<byte> chunks = srcFileData.Drop(12);
+	while(chunks.Length() >= 8)
+	{
+		const byte* const chunkId = chunks.Begin;
+		ulong64 chunkSize = *reinterpret_cast<const uintLE*>(chunks.Begin + 4);
+		chunks.PopFirstExactly(8);
+		if(C::memcmp(chunkId, "data", 4) == 0)
+		{
+			if(hasDs64 && chunkSize == 0xFFFFFFFFu) chunkSize = ds64DataSize;
+			data = chunks.Take(size_t(Math::Min(chunkSize, ulong64(chunks.Length()))));
+			break;
+		}
+		if(C::memcmp(chunkId, "fmt ", 4) == 0) fmt = chunks.Take(size_t(chunkSize));
+		else if(isRf64 && C::memcmp(chunkId, "ds64", 4) == 0 && chunkSize >= 16 && chunks.Length() >= 16)
+		{
+			ds64DataSize = *reinterpret_cast<const ulong64LE*>(chunks.Begin + 8);
+			hasDs64 = true;
+		}
+		chunks.PopFirstN(size_t(Math::Min(chunkSize + (chunkSize & 1), ulong64(chunks.Length()))));
+	}
+	if(fmt.Length() < 16 || data.Empty()) return;
 
-	mData = srcFileData.Drop(sizeof(WaveHeader)).Reinterpret<const byte>().Take(header.DataSize);
-	mChannelCount = ushort(header.Channels);
-	mSampleRate = header.SampleRate;
-	mSampleCount = header.DataSize/sizeof(short)/mChannelCount;
-	if(header.FormatTag == 1) switch(header.BitsPerSample)
+	const WaveFormatChunk& header = *reinterpret_cast<const WaveFormatChunk*>(fmt.Begin);
+	ushort formatTag = header.FormatTag;
+	if(formatTag == WaveFormatTagExtensible && fmt.Length() >= 26)
+		formatTag = *reinterpret_cast<const ushortLE*>(fmt.Begin + 24);
+	const ushort channelCount = header.Channels;
+	const uint bytesPerSample = uint(header.BitsPerSample)/8;
+	if(channelCount == 0 || bytesPerSample == 0) return;
+
+	if(formatTag == WaveFormatTagPcm) switch(header.BitsPerSample)
 	{
 	case 8: mDataType = Data::ValueType::SNorm8; break;
 	case 16: mDataType = Data::ValueType::SNorm16; break;
 	case 24: mDataType = Data::ValueType::SNorm24; break;
 	case 32: mDataType = Data::ValueType::SNorm32; break;
-	default:
-		mDataType = Data::ValueType::Void;
-		mSampleCount = 0;
-		mData = null;
+	default: return;
 	}
-	else if(header.FormatTag == 3)
+	else if(formatTag == WaveFormatTagIeeeFloat)
 	{
 		if(header.BitsPerSample == 32) mDataType = Data::ValueType::Float;
 		else mDataType = Data::ValueType::Double;
 	}
+	else return;
+
+	mChannelCount = channelCount;
+	mSampleRate = header.SampleRate;
+	mSampleCount = data.Length()/bytesPerSample/mChannelCount;
+	mData = data.Take(mSampleCount*mChannelCount*bytesPerSample);
+}
+
+Wave::Wave(IO::FileMapping mapping): Wave(null, mapping.AsRange())
+{
+	// Перемещение отображения не меняет адрес данных, поэтому mData остаётся действительным
+	mOnCloseResource = Funal::Value(Cpp::Move(mapping));
 }
 
 size_t Wave::GetInterleavedSamples(Span<short> outShorts)
@@ -74,6 +128,12 @@ size_t Wave::GetInterleavedSamples(Span<short> outShorts)
 		const auto srcShorts = mData.Reinterpret<const short>().Drop(mCurrentDataPos);
 		valuesRead = CopyTo(srcShorts, outShorts);
 	}
+	else if(mDataType == Data::ValueType::SNorm24)
+	{
+		const byte* const src = mData.Begin + mCurrentDataPos*3;
+		valuesRead = Math::Min(outShorts.Length(), mData.Length()/3 - mCurrentDataPos);
+		for(size_t i = 0; i < valuesRead; i++) outShorts[i] = short(waveReadSNorm24(src + i*3) >> 8);
+	}
 	else if(mDataType == Data::ValueType::Float)
 	{
 		const auto srcFloats = mData.Reinterpret<const float>().Drop(mCurrentDataPos).Take(outShorts.Length());
@@ -96,11 +156,20 @@ size_t Wave::GetInterleavedSamples(Span<float> outFloats)
 		valuesRead = srcShorts.Length();
 		CastToNormalized(outFloats.Take(valuesRead), srcShorts);
 	}
+	else if(mDataType == Data::ValueType::SNorm24)
+	{
+		const byte* const src = mData.Begin + mCurrentDataPos*3;
+		valuesRead = Math::Min(outFloats.Length(), mData.Length()/3 - mCurrentDataPos);
+		for(size_t i = 0; i < valuesRead; i++) outFloats[i] = float(waveReadSNorm24(src + i*3))*(1.0f/8388608);
+	}
 	else if(mDataType == Data::ValueType::Float)
 	{
 		const auto srcFloats = mData.Reinterpret<const float>().Drop(mCurrentDataPos);
 		valuesRead = CopyTo(srcFloats, outFloats);
 	}
+
+	mCurrentDataPos += valuesRead;
+	if(valuesRead < outFloats.Length()) mCurrentDataPos = 0;
 	return valuesRead / mChannelCount;
 }
 
@@ -122,6 +191,15 @@ size_t Wave::GetUninterleavedSamples(CSpan<Span<float>> outFloatChannels)
 		DeinterleaveShortsCastToFloats(srcShorts, outFloatChannelsTempSpans);
 		valuesRead = srcShorts.Length();
 	}
+	else if(mDataType == Data::ValueType::SNorm24)
+	{
+		const byte* const src = mData.Begin + mCurrentDataPos*3;
+		const size_t samplesRead = Math::Min(outSamplesCount, (mData.Length()/3 - mCurrentDataPos)/mChannelCount);
+		for(size_t i = 0; i < samplesRead; i++)
+			for(size_t c = 0; c < mChannelCount; c++)
+				outFloatChannels[c][i] = float(waveReadSNorm24(src + (i*mChannelCount + c)*3))*(1.0f/8388608);
+		valuesRead = samplesRead*mChannelCount;
+	}
 	else if(mDataType == Data::ValueType::Float)
 	{
 		const auto srcFloats = mData.Reinterpret<const float>().Drop(mCurrentDataPos)
@@ -130,19 +208,22 @@ size_t Wave::GetUninterleavedSamples(CSpan<Span<float>> outFloatChannels)
 		DeinterleaveFloats(srcFloats, outFloatChannelsTempSpans);
 		valuesRead = srcFloats.Length();
 	}
+
+	mCurrentDataPos += valuesRead;
+	if(valuesRead < outFloatChannels.Length()*outSamplesCount) mCurrentDataPos = 0;
 	return valuesRead / mChannelCount;
 }
 
 FixedArray<const void*> Wave::GetRawSamplesData(size_t maxSamplesToRead,
 	Data::ValueType* oType, bool* oInterleaved, size_t* oSamplesRead)
 {
-	const auto shortsToRead = Math::Min(maxSamplesToRead, mSampleCount*mChannelCount - mCurrentDataPos);
-	if(oSamplesRead) *oSamplesRead = shortsToRead / mChannelCount;
+	const size_t valuesToRead = Math::Min(maxSamplesToRead*mChannelCount, mSampleCount*mChannelCount - mCurrentDataPos);
+	if(oSamplesRead) *oSamplesRead = valuesToRead / mChannelCount;
 	if(oInterleaved) *oInterleaved = true;
 	if(oType) *oType = mDataType;
-	FixedArray<const void*> resultPtrs{mData.Begin + mCurrentDataPos};
-	mCurrentDataPos += shortsToRead;
-	if(shortsToRead < maxSamplesToRead) mCurrentDataPos = 0;
+	FixedArray<const void*> resultPtrs{mData.Begin + mCurrentDataPos*mDataType.Size()};
+	mCurrentDataPos += valuesToRead;
+	if(valuesToRead < maxSamplesToRead*mChannelCount) mCurrentDataPos = 0;
 	return resultPtrs;
 }
 
@@ -8,6 +8,8 @@
 
 #include "Data/ValueType.h"
 
+#include "IO/FileMapping.h"
+
 #include "Audio/SoundTypes.h"
 #include "Audio/AudioSource.h"
 
@@ -23,18 +25,22 @@ class Wave: public BasicAudioSource
 public:
 	Wave(OnCloseResourceCallback onClose, const SoundInfo& info, const void* data):
 		BasicAudioSource(Cpp::Move(onClose), info.SampleRate, info.Channels),
-		mData(SpanOfRaw(data, info.GetBufferSize())), mDataType(info.SampleType) {}
+		mData(SpanOfRaw(data, info.GetBufferSize())), mSampleCount(info.SampleCount), mDataType(info.SampleType) {}
 
 	Wave(OnCloseResourceCallback onClose, uint sampleRate, ushort numChannels, CSpan<short> data):
 		BasicAudioSource(Cpp::Move(onClose), sampleRate, numChannels),
-		mData(data.Reinterpret<byte>()), mSampleCount(data.Length()), mDataType(Data::ValueType::SNorm16) {}
+		mData(data.Reinterpret<byte>()), mSampleCount(data.Length()/numChannels), mDataType(Data::ValueType::SNorm16) {}
 
 	Wave(OnCloseResourceCallback onClose, uint sampleRate, ushort numChannels, CSpan<float> data):
 		BasicAudioSource(Cpp::Move(onClose), sampleRate, numChannels),
-		mData(data.Reinterpret<byte>()), mSampleCount(data.Length()), mDataType(Data::ValueType::Float) {}
+		mData(data.Reinterpret<byte>()), mSampleCount(data.Length()/numChannels), mDataType(Data::ValueType::Float) {}
 
 	Wave(OnCloseResourceCallback onClose, CSpan<byte> srcFileData);
 
+	//! Читает семплы прямо из отображения файла в память, владея им.
+	//! GetRawSamplesData возвращает указатели внутрь отображения без копирования.
+	explicit Wave(IO::FileMapping mapping);
+
 	Wave(const Wave&) = delete;
 	Wave(Wave&&) = default;
 	Wave& operator=(const Wave&) = delete;
@@ -43,6 +49,14 @@ public:
 	size_t SampleCount() const override {return mSampleCount;}
 	size_t SamplePosition() const override {return mCurrentDataPos/mChannelCount;}
 
+	//! Перемещение выполняется за O(1): позиция - это просто смещение в данных.
+	bool SetSamplePosition(size_t position) override
+	{
+		if(position > mSampleCount) return false;
+		mCurrentDataPos = position*mChannelCount;
+		return true;
+	}
+
 	size_t GetInterleavedSamples(Span<short> outShorts) override;
 	size_t GetInterleavedSamples(Span<float> outFloats) override;
 	size_t GetUninterleavedSamples(CSpan<Span<float>> outFloats) override;
@@ -1,9 +1,20 @@
 ﻿#include "Chorus.h"
+#include "Range/Mutation/Fill.h"
 
 INTRA_PUSH_DISABLE_REDUNDANT_WARNINGS
 
 namespace Intra { namespace Audio { namespace Synth {
 
+void Chorus::Reset(size_t maxDelaySamples, float delayFreqPerSample, float mainVolume, float secondaryVolume)
+{
+	DelayCircularBuffer.SetCountUninitialized(maxDelaySamples);
+	FillZeros(DelayCircularBuffer.AsRange());
+	CircularBufferOffset = 0;
+	MainVolume = mainVolume;
+	SecondaryVolume = secondaryVolume;
+	Oscillator = Math::SineRange<float>(float(maxDelaySamples)*0.5f, float(-Math::PI/2), float(2*Math::PI*delayFreqPerSample));
+}
+
 void Chorus::operator()(Span<float> inOutSamples)
 {
 	const float oscillatorOffset = float(DelayCircularBuffer.Length())*0.5f;
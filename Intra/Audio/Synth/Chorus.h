@@ -21,12 +21,20 @@ struct Chorus
 	float MainVolume, SecondaryVolume;
 	Math::SineRange<float> Oscillator;
 
+	Chorus(null_t=null): CircularBufferOffset(0), MainVolume(1), SecondaryVolume(0) {}
+
 	Chorus(size_t maxDelaySamples, float delayFreqPerSample, float mainVolume=0.5f, float secondaryVolume=0.5f):
-		DelayCircularBuffer(maxDelaySamples), CircularBufferOffset(0),
-		MainVolume(mainVolume), SecondaryVolume(secondaryVolume),
-		Oscillator(float(maxDelaySamples)*0.5f, float(-Math::PI/2), float(2*Math::PI*delayFreqPerSample)) {}
+		CircularBufferOffset(0) {Reset(maxDelaySamples, delayFreqPerSample, mainVolume, secondaryVolume);}
+
+	//! Переинициализирует эффект, переиспользуя память линии задержки.
+	//! При maxDelaySamples == 0 эффект отключается.
+	void Reset(size_t maxDelaySamples, float delayFreqPerSample, float mainVolume=0.5f, float secondaryVolume=0.5f);
 
 	void operator()(Span<float> inOutSamples);
+
+	forceinline bool operator==(null_t) const noexcept {return DelayCircularBuffer.Empty();}
+	forceinline bool operator!=(null_t) const noexcept {return !operator==(null);}
+	forceinline explicit operator bool() const noexcept {return operator!=(null);}
 };
 
 struct ChorusFactory
@@ -43,9 +51,16 @@ struct ChorusFactory
 		MainVolume(mainVolume), SecondaryVolume(secondaryVolume) {}
 
 	Chorus operator()(float freq, float volume, uint sampleRate) const
+	{
+		Chorus result;
+		operator()(result, freq, volume, sampleRate);
+		return result;
+	}
+
+	void operator()(Chorus& chorus, float freq, float volume, uint sampleRate) const
 	{
 		(void)freq; (void)volume;
-		return Chorus(size_t(MaxDelay*float(sampleRate)), DelayFrequency/float(sampleRate), MainVolume, SecondaryVolume);
+		chorus.Reset(size_t(MaxDelay*float(sampleRate)), DelayFrequency/float(sampleRate), MainVolume, SecondaryVolume);
 	}
 
 	forceinline bool operator==(null_t) const noexcept {return MaxDelay == 0 || SecondaryVolume == 0;}
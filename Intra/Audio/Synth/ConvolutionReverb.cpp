@@ -0,0 +1,150 @@
+﻿#include "ConvolutionReverb.h"
+#include "Cpp/Warnings.h"
+#include "Funal/Op.h"
+#include "Range/Mutation/Copy.h"
+#include "Range/Mutation/Fill.h"
+#include "Range/Mutation/Transform.h"
+#include "Simd/Simd.h"
+
+INTRA_PUSH_DISABLE_REDUNDANT_WARNINGS
+
+namespace Intra { namespace Audio { namespace Synth {
+
+PartitionedImpulseResponse::PartitionedImpulseResponse(CSpan<float> impulseResponse, size_t blockSize):
+	mBlockSize(blockSize), mPartitionCount((impulseResponse.Length() + blockSize - 1) / blockSize),
+	mSpectrumStride((blockSize + 1 + 3) & ~size_t(3))
+{
+	INTRA_DEBUG_ASSERT(blockSize % 2 == 0);
+	if(mPartitionCount == 0) mPartitionCount = 1;
+	mReal.SetCount(mPartitionCount*mSpectrumStride, 0);
+	mImag.SetCount(mPartitionCount*mSpectrumStride, 0);
+
+	const FFTPlan& plan = FFTPlan::Get(2*blockSize);
+	Array<float> block, temp;
+	block.SetCountUninitialized(2*blockSize);
+	temp.SetCountUninitialized(plan.TempLength());
+	for(size_t i = 0; i < mPartitionCount; i++)
+	{
+		const size_t copied = CopyTo(impulseResponse.Drop(i*blockSize).Take(blockSize), block);
+		FillZeros(block.Drop(copied));
+		Span<float> re = mReal.Drop(i*mSpectrumStride).Take(blockSize + 1);
+		Span<float> im = mImag.Drop(i*mSpectrumStride).Take(blockSize + 1);
+		plan.ForwardReal(block, re, im, temp);
+
+		// Нормировка обратного преобразования делается здесь один раз, а не на каждом блоке выхода
+		Multiply(re, 1.0f/float(2*blockSize));
+		Multiply(im, 1.0f/float(2*blockSize));
+	}
+}
+
+ConvolutionReverb::ConvolutionReverb(Shared<PartitionedImpulseResponse> impulseResponse, float dryVolume, float wetVolume):
+	mImpulse(Cpp::Move(impulseResponse)), mPlan(&FFTPlan::Get(2*mImpulse->BlockSize())),
+	mDryVolume(dryVolume), mWetVolume(wetVolume), mPosition(0), mCurrentSpectrum(0)
+{
+	const size_t blockSize = mImpulse->BlockSize();
+	const size_t stride = mImpulse->SpectrumStride();
+	mInput.SetCount(blockSize, 0);
+	mOutput.SetCount(blockSize, 0);
+	mOverlap.SetCount(blockSize, 0);
+	mTime.SetCount(2*blockSize, 0);
+	mTemp.SetCountUninitialized(mPlan->TempLength());
+	mSpectraReal.SetCount(mImpulse->PartitionCount()*stride, 0);
+	mSpectraImag.SetCount(mImpulse->PartitionCount()*stride, 0);
+	mSumReal.SetCount(stride, 0);
+	mSumImag.SetCount(stride, 0);
+}
+
+void ConvolutionReverb::Reset()
+{
+	FillZeros(mInput.AsRange());
+	FillZeros(mOutput.AsRange());
+	FillZeros(mOverlap.AsRange());
+	FillZeros(mSpectraReal.AsRange());
+	FillZeros(mSpectraImag.AsRange());
+	mPosition = 0;
+	mCurrentSpectrum = 0;
+}
+
+void ConvolutionReverb::operator()(Span<float> inOutSamples)
+{
+	const size_t blockSize = mImpulse->BlockSize();
+	while(!inOutSamples.Empty())
+	{
+		// Вход накапливается в текущий блок, а на его место выдаётся выход, посчитанный по предыдущему блоку
+		const size_t n = Funal::Min(blockSize - mPosition, inOutSamples.Length());
+		float* const input = mInput.Data() + mPosition;
+		const float* const output = mOutput.Data() + mPosition;
+		for(size_t i = 0; i < n; i++)
+		{
+			input[i] = inOutSamples[i];
+			inOutSamples[i] = output[i];
+		}
+		inOutSamples.PopFirstExactly(n);
+		mPosition += n;
+		if(mPosition == blockSize)
+		{
+			processBlock();
+			mPosition = 0;
+		}
+	}
+}
+
+//! sum += x*h для спектров в виде раздельных массивов действительных и мнимых частей. Длина кратна 4.
+static void multiplyAddSpectra(float* sumRe, float* sumIm,
+	const float* xRe, const float* xIm, const float* hRe, const float* hIm, size_t length)
+{
+#if(INTRA_SIMD_SUPPORT >= INTRA_SIMD_SSE2 && INTRA_SIMD_SUPPORT <= INTRA_SIMD_AVX2)
+	for(size_t i = 0; i < length; i += 4)
+	{
+		const __m128 xr = _mm_loadu_ps(xRe + i), xi = _mm_loadu_ps(xIm + i);
+		const __m128 hr = _mm_loadu_ps(hRe + i), hi = _mm_loadu_ps(hIm + i);
+		_mm_storeu_ps(sumRe + i, _mm_add_ps(_mm_loadu_ps(sumRe + i), _mm_sub_ps(_mm_mul_ps(xr, hr), _mm_mul_ps(xi, hi))));
+		_mm_storeu_ps(sumIm + i, _mm_add_ps(_mm_loadu_ps(sumIm + i), _mm_add_ps(_mm_mul_ps(xr, hi), _mm_mul_ps(xi, hr))));
+	}
+#else
+	for(size_t i = 0; i < length; i++)
+	{
+		sumRe[i] += xRe[i]*hRe[i] - xIm[i]*hIm[i];
+		sumIm[i] += xRe[i]*hIm[i] + xIm[i]*hRe[i];
+	}
+#endif
+}
+
+void ConvolutionReverb::processBlock()
+{
+	const size_t blockSize = mImpulse->BlockSize();
+	const size_t partitionCount = mImpulse->PartitionCount();
+	const size_t stride = mImpulse->SpectrumStride();
+
+	// Спектр нового блока, дополненного нулями, записывается на место самого старого в линии задержки
+	mCurrentSpectrum = mCurrentSpectrum + 1 == partitionCount? 0: mCurrentSpectrum + 1;
+	CopyTo(mInput.AsConstRange(), mTime.AsRange());
+	FillZeros(mTime.Drop(blockSize));
+	mPlan->ForwardReal(mTime,
+		mSpectraReal.Drop(mCurrentSpectrum*stride).Take(blockSize + 1),
+		mSpectraImag.Drop(mCurrentSpectrum*stride).Take(blockSize + 1), mTemp);
+
+	// Блок характеристики i умножается на спектр входного блока, поступившего i блоков назад
+	FillZeros(mSumReal.AsRange());
+	FillZeros(mSumImag.AsRange());
+	size_t spectrum = mCurrentSpectrum;
+	for(size_t i = 0; i < partitionCount; i++)
+	{
+		multiplyAddSpectra(mSumReal.Data(), mSumImag.Data(),
+			mSpectraReal.Data() + spectrum*stride, mSpectraImag.Data() + spectrum*stride,
+			mImpulse->PartitionReal(i).Data(), mImpulse->PartitionImag(i).Data(), stride);
+		spectrum = spectrum == 0? partitionCount - 1: spectrum - 1;
+	}
+	mPlan->InverseRealNonNormalized(mSumReal, mSumImag, mTime, mTemp);
+
+	// Первая половина результата складывается с хвостом предыдущего блока, вторая половина становится новым хвостом
+	for(size_t i = 0; i < blockSize; i++)
+	{
+		mOutput[i] = mDryVolume*mInput[i] + mWetVolume*(mTime[i] + mOverlap[i]);
+		mOverlap[i] = mTime[blockSize + i];
+	}
+}
+
+}}}
+
+INTRA_WARNING_POP
@@ -0,0 +1,94 @@
+﻿#pragma once
+
+#include "Cpp/Warnings.h"
+#include "Cpp/Features.h"
+
+#include "Utils/Span.h"
+#include "Utils/Shared.h"
+
+#include "Container/Sequential/Array.h"
+
+#include "Audio/AudioProcessing.h"
+
+INTRA_PUSH_DISABLE_REDUNDANT_WARNINGS
+
+namespace Intra { namespace Audio { namespace Synth {
+
+//! Импульсная характеристика, подготовленная для равномерно разбитой свёртки.
+//! Характеристика разбивается на блоки по BlockSize() семплов, каждый блок дополняется нулями до 2*BlockSize() и переводится в частотную область.
+//! После создания не изменяется, поэтому одна характеристика разделяется всеми экземплярами ConvolutionReverb через Shared.
+//! Характеристика должна быть записана с той же частотой дискретизации, что и обрабатываемый звук.
+class PartitionedImpulseResponse
+{
+public:
+	//! @param blockSize Размер блока в семплах, чётный, лучше степень двойки.
+	//! Определяет задержку свёртки: меньший блок даёт меньшую задержку, но больше блоков и больше вычислений на семпл.
+	PartitionedImpulseResponse(CSpan<float> impulseResponse, size_t blockSize = 512);
+
+	forceinline size_t BlockSize() const {return mBlockSize;}
+	forceinline size_t PartitionCount() const {return mPartitionCount;}
+
+	//! Число чисел в массиве действительных или мнимых частей спектра одного блока: BlockSize() + 1, выровненное до 4.
+	forceinline size_t SpectrumStride() const {return mSpectrumStride;}
+
+	forceinline CSpan<float> PartitionReal(size_t index) const {return mReal.AsConstRange().Drop(index*mSpectrumStride).Take(mSpectrumStride);}
+	forceinline CSpan<float> PartitionImag(size_t index) const {return mImag.AsConstRange().Drop(index*mSpectrumStride).Take(mSpectrumStride);}
+
+private:
+	size_t mBlockSize, mPartitionCount, mSpectrumStride;
+
+	//! Спектры всех блоков подряд, уже поделённые на размер обратного БПФ.
+	Array<float> mReal, mImag;
+};
+
+//! Свёртка потока семплов с длинной импульсной характеристикой (реверберация) методом перекрытия со сложением.
+//! Характеристика разбита на равные блоки, входные блоки хранятся в линии задержки спектров,
+//! поэтому на каждый блок входа выполняется одно прямое и одно обратное БПФ и PartitionCount() умножений спектров.
+//! Выход задержан на Latency() семплов. Вся память выделяется в конструкторе, поэтому экземпляр можно использовать как GenericModifier.
+class ConvolutionReverb
+{
+public:
+	ConvolutionReverb(Shared<PartitionedImpulseResponse> impulseResponse, float dryVolume = 1, float wetVolume = 1);
+
+	void operator()(Span<float> inOutSamples);
+
+	forceinline size_t Latency() const {return mImpulse->BlockSize();}
+
+	//! Забыть всю историю входа, как будто до этого на вход подавалась тишина.
+	void Reset();
+
+private:
+	Shared<PartitionedImpulseResponse> mImpulse;
+	const FFTPlan* mPlan;
+	float mDryVolume, mWetVolume;
+	size_t mPosition, mCurrentSpectrum;
+	Array<float> mInput, mOutput, mOverlap, mTime, mTemp;
+	Array<float> mSpectraReal, mSpectraImag, mSumReal, mSumImag;
+
+	void processBlock();
+};
+
+struct ConvolutionReverbFactory
+{
+	Shared<PartitionedImpulseResponse> ImpulseResponse;
+	float DryVolume, WetVolume;
+
+	ConvolutionReverbFactory(null_t=null): DryVolume(1), WetVolume(0) {}
+
+	ConvolutionReverbFactory(Shared<PartitionedImpulseResponse> impulseResponse, float dryVolume = 1, float wetVolume = 1):
+		ImpulseResponse(Cpp::Move(impulseResponse)), DryVolume(dryVolume), WetVolume(wetVolume) {}
+
+	ConvolutionReverb operator()(float freq, float volume, uint sampleRate) const
+	{
+		(void)freq; (void)volume; (void)sampleRate;
+		return ConvolutionReverb(ImpulseResponse, DryVolume, WetVolume);
+	}
+
+	forceinline bool operator==(null_t) const noexcept {return ImpulseResponse == null || WetVolume == 0;}
+	forceinline bool operator!=(null_t) const noexcept {return !operator==(null);}
+	forceinline explicit operator bool() const noexcept {return operator!=(null);}
+};
+
+}}}
+
+INTRA_WARNING_POP
@@ -23,10 +23,16 @@ class ExponentAttenuator
 {
 	float mFactor, mFactorStep;
 public:
+	ExponentAttenuator(null_t=null): mFactor(1), mFactorStep(1) {}
+
 	ExponentAttenuator(float startVolume, float expCoeff, uint sampleRate):
 		mFactor(startVolume), mFactorStep(Math::Exp(-expCoeff/float(sampleRate))) {}
 
 	void operator()(Span<float> inOutSamples);
+
+	forceinline bool operator==(null_t) const noexcept {return mFactor == 1 && mFactorStep == 1;}
+	forceinline bool operator!=(null_t) const noexcept {return !operator==(null);}
+	forceinline explicit operator bool() const noexcept {return operator!=(null);}
 };
 
 struct ExponentAttenuatorFactory
@@ -4,6 +4,7 @@
 #include "Types.h"
 #include "Range/Mutation/Transform.h"
 #include "Range/Reduction.h"
+#include "Simd/Simd.h"
 
 #include <stdio.h>
 
@@ -29,142 +30,170 @@ FilterCoeffs FilterCoeffs::Calculate(float rezAmount, float cutoffRatio, FilterT
 	return result;
 }
 
-void Filter::operator()(Span<float> inOutSamples)
+#if(INTRA_SIMD_SUPPORT >= INTRA_SIMD_SSE2 && INTRA_SIMD_SUPPORT <= INTRA_SIMD_AVX2)
+
+//! Линейный рекуррентный фильтр с состоянием из D <= 4 чисел, обрабатывающий блоки из 4 семплов как произведение матриц.
+//! Выходы Y и новое состояние S' блока линейно зависят от входов X и состояния S:
+//! Y = Σ X[j]*YX[j] + Σ S[k]*YS[k], S' = Σ X[j]*SX[j] + Σ S[k]*SS[k].
+//! Последовательная зависимость остаётся только между блоками, поэтому задержка делится на 4.
+//! Столбцы матриц вычисляются прогоном скалярного шага step по базисным векторам.
+template<size_t D> struct LinearFilterBlock4
 {
-	//TODO: сделать оптимизированные версии с использованием SIMD
-	if(A2 == 0)
+	__m128 YX[4], YS[D], SX[4], SS[D];
+
+	template<typename Step> explicit LinearFilterBlock4(const Step& step)
 	{
-		if(A1 == 0)
+		for(size_t col = 0; col < 4 + D; col++)
 		{
-			if(B2 == 0)
-			{
-				if(B1 == 0)
-				{
-					Multiply(inOutSamples, C);
-					return;
-				}
-				for(float& sample: inOutSamples)
-				{
-					sample *= C;
-					sample += B1*PrevSample;
-
-					PrevSample = sample;
-				}
-				return;
-			}
+			float x[4] = {0, 0, 0, 0};
+			float state[4] = {0, 0, 0, 0};
+			if(col < 4) x[col] = 1;
+			else state[col - 4] = 1;
+			float y[4];
+			for(int i = 0; i < 4; i++) y[i] = step(state, x[i]);
+			const __m128 yv = _mm_loadu_ps(y), sv = _mm_loadu_ps(state);
+			if(col < 4) YX[col] = yv, SX[col] = sv;
+			else YS[col - 4] = yv, SS[col - 4] = sv;
+		}
+	}
 
-			for(float& sample: inOutSamples)
-			{
-				sample *= C;
-				sample += B1*PrevSample + B2*PrevSample2;
+	template<int K> static forceinline __m128 lane(__m128 v) {return _mm_shuffle_ps(v, v, _MM_SHUFFLE(K, K, K, K));}
 
-				PrevSample2 = PrevSample;
-				PrevSample = sample;
-			}
-			return;
-		}
-		if(B2 == 0)
+	//! Обрабатывает целые блоки по 4 семпла.
+	//! @return Количество обработанных семплов.
+	size_t operator()(float* samples, size_t count, float* state) const
+	{
+		__m128 s = _mm_loadu_ps(state);
+		size_t i = 0;
+		for(; i + 4 <= count; i += 4)
 		{
-			if(B1 == 0)
+			const __m128 x = _mm_loadu_ps(samples + i);
+			const __m128 x0 = lane<0>(x), x1 = lane<1>(x), x2 = lane<2>(x), x3 = lane<3>(x);
+			__m128 y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x0, YX[0]), _mm_mul_ps(x1, YX[1])),
+				_mm_add_ps(_mm_mul_ps(x2, YX[2]), _mm_mul_ps(x3, YX[3])));
+			__m128 ns = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x0, SX[0]), _mm_mul_ps(x1, SX[1])),
+				_mm_add_ps(_mm_mul_ps(x2, SX[2]), _mm_mul_ps(x3, SX[3])));
+			const __m128 s0 = lane<0>(s);
+			y = _mm_add_ps(y, _mm_mul_ps(s0, YS[0]));
+			ns = _mm_add_ps(ns, _mm_mul_ps(s0, SS[0]));
+			if(D > 1)
 			{
-				for(float& sample: inOutSamples)
-				{
-					const float cur = sample;
-
-					sample *= C;
-					sample += A1*PrevSrc;
-
-					PrevSrc = cur;
-				}
-				return;
+				const __m128 s1 = lane<1>(s);
+				y = _mm_add_ps(y, _mm_mul_ps(s1, YS[D > 1? 1: 0]));
+				ns = _mm_add_ps(ns, _mm_mul_ps(s1, SS[D > 1? 1: 0]));
 			}
-
-			for(float& sample: inOutSamples)
+			if(D > 2)
 			{
-				const float cur = sample;
-
-				sample *= C;
-				sample += A1*PrevSrc;
-				sample += B1*PrevSample;
-
-				PrevSrc = cur;
-				PrevSample = sample;
+				const __m128 s2 = lane<2>(s), s3 = lane<3>(s);
+				y = _mm_add_ps(y, _mm_add_ps(_mm_mul_ps(s2, YS[D > 2? 2: 0]), _mm_mul_ps(s3, YS[D > 3? 3: 0])));
+				ns = _mm_add_ps(ns, _mm_add_ps(_mm_mul_ps(s2, SS[D > 2? 2: 0]), _mm_mul_ps(s3, SS[D > 3? 3: 0])));
 			}
-			return;
+			_mm_storeu_ps(samples + i, y);
+			s = ns;
 		}
+		_mm_storeu_ps(state, s);
+		return i;
+	}
+};
 
-		for(float& sample: inOutSamples)
-		{
-			const float cur = sample;
+#endif
 
-			sample *= C;
-			sample += A1*PrevSrc;
-			sample += B1*PrevSample + B2*PrevSample2;
+//! Блочная обработка имеет смысл, только если подготовка матриц окупается.
+enum: size_t {FilterBlockMinLength = 32};
 
-			PrevSrc = cur;
-			PrevSample2 = PrevSample;
-			PrevSample = sample;
-		}
-		return;
-	}
+namespace {
 
-	if(B2 == 0)
+//! Шаги фильтров в форме step(state, x) -> y, общие для скалярной и блочной обработки.
+struct BiquadStep
+{
+	// state = {y[n-1], y[n-2], x[n-1], x[n-2]}
+	float A1, A2, B1, B2, C;
+
+	forceinline float operator()(float* state, float x) const
 	{
-		if(B1 == 0)
-		{
-			for(float& sample: inOutSamples)
-			{
-				const float cur = sample;
+		const float y = C*x + A1*state[2] + A2*state[3] + B1*state[0] + B2*state[1];
+		state[3] = state[2];
+		state[2] = x;
+		state[1] = state[0];
+		state[0] = y;
+		return y;
+	}
+};
 
-				sample *= C;
-				sample += A1*PrevSrc + A2*PrevSrc2;
+struct ResonanceStep
+{
+	// state = {y[n-1], S}
+	float DeltaPhase, QFactor;
 
-				PrevSrc2 = PrevSrc;
-				PrevSrc = cur;
-			}
-			return;
-		}
-		for(float& sample: inOutSamples)
-		{
-			const float cur = sample;
+	forceinline float operator()(float* state, float x) const
+	{
+		const float y = x + state[1]*DeltaPhase + state[0];
+		state[0] = y;
+		state[1] = (state[1] - y*DeltaPhase)*QFactor;
+		return y;
+	}
+};
 
-			sample *= C;
-			sample += A1*PrevSrc + A2*PrevSrc2;
-			sample += B1*PrevSample;
+struct SoftHighPassStep
+{
+	// state = {S}
+	float K, K1;
 
-			PrevSrc2 = PrevSrc;
-			PrevSrc = cur;
-			PrevSample = sample;
-		}
-		return;
+	forceinline float operator()(float* state, float x) const
+	{
+		state[0] = state[0]*K + x*K1;
+		return x - state[0];
 	}
+};
 
-	for(float& sample: inOutSamples)
-	{
-		const float cur = sample;
+}
 
-		sample *= C;
-		sample += A1*PrevSrc + A2*PrevSrc2;
-		sample += B1*PrevSample + B2*PrevSample2;
+template<size_t D, typename Step> static void processLinearFilter(const Step& step, Span<float> inOutSamples, float* state)
+{
+	// состояние в локальном массиве, чтобы компилятор не перечитывал его из памяти после каждой записи семпла
+	float localState[4] = {0, 0, 0, 0};
+	for(size_t k = 0; k < D; k++) localState[k] = state[k];
+	float* ptr = inOutSamples.Begin;
+	const float* const end = inOutSamples.End;
+#if(INTRA_SIMD_SUPPORT >= INTRA_SIMD_SSE2 && INTRA_SIMD_SUPPORT <= INTRA_SIMD_AVX2)
+	if(inOutSamples.Length() >= FilterBlockMinLength)
+	{
+		const LinearFilterBlock4<D> block(step);
+		ptr += block(ptr, inOutSamples.Length(), localState);
+	}
+#endif
+	while(ptr != end)
+	{
+		*ptr = step(localState, *ptr);
+		ptr++;
+	}
+	for(size_t k = 0; k < D; k++) state[k] = localState[k];
+}
 
-		PrevSrc2 = PrevSrc;
-		PrevSrc = cur;
-		PrevSample2 = PrevSample;
-		PrevSample = sample;
+void Filter::operator()(Span<float> inOutSamples)
+{
+	if(A1 == 0 && A2 == 0 && B1 == 0 && B2 == 0)
+	{
+		Multiply(inOutSamples, C);
+		return;
 	}
+	const BiquadStep step = {A1, A2, B1, B2, C};
+	float state[4] = {PrevSample, PrevSample2, PrevSrc, PrevSrc2};
+	processLinearFilter<4>(step, inOutSamples, state);
+	PrevSample = state[0];
+	PrevSample2 = state[1];
+	PrevSrc = state[2];
+	PrevSrc2 = state[3];
 }
 
 
 void ResonanceFilter::operator()(Span<float> inOutSamples)
 {
-	for(float& sample: inOutSamples)
-	{
-		sample += S*DeltaPhase + PrevSample;
-		PrevSample = sample;
-
-		S -= sample*DeltaPhase;
-		S *= QFactor;
-	}
+	const ResonanceStep step = {DeltaPhase, QFactor};
+	float state[2] = {PrevSample, S};
+	processLinearFilter<2>(step, inOutSamples, state);
+	PrevSample = state[0];
+	S = state[1];
 }
 
 void DriveEffect::operator()(Span<float> inOutSamples)
@@ -181,13 +210,8 @@ void DriveEffect::operator()(Span<float> inOutSamples)
 
 void SoftHighPassFilter::operator()(Span<float> inOutSamples)
 {
-	const float K1 = 1 - K;
-	for(float& sample: inOutSamples)
-	{
-		S *= K;
-		S += sample*K1;
-		sample -= S;
-	}
+	const SoftHighPassStep step = {K, 1 - K};
+	processLinearFilter<1>(step, inOutSamples, &S);
 }
 
 void NormalizeEffect::operator()(Span<float> inOutSamples)
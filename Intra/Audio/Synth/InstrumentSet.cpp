@@ -1,5 +1,11 @@
 #include "InstrumentSet.h"
+#include "MusicalInstrument.h"
+#include "WaveTableSampler.h"
 #include "Audio/Midi/MidiFileParser.h"
+#include "Audio/Midi/Messages.h"
+#include "Container/Sequential/Array.h"
+#include "Range/Search/Single.h"
+#include "Concurrency/ParallelFor.h"
 
 INTRA_PUSH_DISABLE_REDUNDANT_WARNINGS
 
@@ -11,6 +17,28 @@ void MidiInstrumentSet::Preload(const Midi::MidiFileInfo& info, uint sampleRate)
 	{
 		if(info.UsedDrumInstrumentsFlags[i]) (*DrumInstruments[i])(1, sampleRate);
 	}
+
+	// Generate wave tables for all notes of the file now, so that synthesizers don't do it during rendering.
+	// Frequencies are ascending, so a mipmapped table is generated for the lowest octave and reused by upper ones.
+	Array<float> freqs;
+	for(size_t i = 0; i < 128; i++)
+	{
+		if(!info.UsedNotesFlags[i]) continue;
+		Midi::NoteOn note{};
+		note.NoteOctaveOrDrumId = byte(i);
+		freqs.AddLast(note.Frequency());
+	}
+	Array<const WaveTableCache*> caches;
+	for(size_t i = 0; i < 128; i++)
+	{
+		if(!info.UsedInstrumentsFlags[i] || Instruments[i] == null) continue;
+		for(auto& wave: Instruments[i]->WaveTables)
+			if(wave.Tables != null && !Range::Contains(caches, wave.Tables)) caches.AddLast(wave.Tables);
+	}
+	// each cache serializes its own generation, different caches are filled in parallel
+	ParallelFor(caches.Length(), [&](size_t begin, size_t end) {
+		for(size_t i = begin; i < end; i++) caches[i]->Preload(freqs, sampleRate);
+	}, 1);
 }
 
 }}}
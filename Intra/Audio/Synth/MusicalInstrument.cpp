@@ -8,18 +8,23 @@ namespace Intra { namespace Audio { namespace Synth {
 NoteSampler MusicalInstrument::operator()(float freq, float volume, uint sampleRate) const
 {
 	NoteSampler result;
+	operator()(result, freq, volume, sampleRate);
+	return result;
+}
 
-	for(auto& wave: Waves) result.WaveTableSamplers.AddLast(wave(freq, volume, sampleRate));
-	for(auto& wave: WaveTables) result.WaveTableSamplers.AddLast(wave(freq, volume, sampleRate));
-	if(WhiteNoise) result.GenericSamplers.AddLast(WhiteNoise(freq, volume, sampleRate));
-	for(auto& instrument: GenericInstruments) result.GenericSamplers.AddLast(instrument(freq, volume, sampleRate));
+void MusicalInstrument::operator()(NoteSampler& sampler, float freq, float volume, uint sampleRate) const
+{
+	sampler.Reset();
 
-	if(ExponentAttenuation) result.Modifiers.AddLast(ExponentAttenuation(freq, volume, sampleRate));
-	if(ADSR) result.ADSR = ADSR(freq, volume, sampleRate);
-	if(Chorus) result.Modifiers.AddLast(Chorus(freq, volume, sampleRate));
-	for(auto& mod: GenericModifiers) result.Modifiers.AddLast(mod(freq, volume, sampleRate));
+	for(auto& wave: Waves) sampler.WaveTableSamplers.AddLast(wave(freq, volume, sampleRate));
+	for(auto& wave: WaveTables) sampler.WaveTableSamplers.AddLast(wave(freq, volume, sampleRate));
+	if(WhiteNoise) sampler.GenericSamplers.AddLast(WhiteNoise(freq, volume, sampleRate));
+	for(auto& instrument: GenericInstruments) sampler.GenericSamplers.AddLast(instrument(freq, volume, sampleRate));
 
-	return result;
+	if(ExponentAttenuation) sampler.ExponentAttenuation = ExponentAttenuation(freq, volume, sampleRate);
+	if(ADSR) sampler.ADSR = ADSR(freq, volume, sampleRate);
+	if(Chorus) Chorus(sampler.Chorus, freq, volume, sampleRate);
+	for(auto& mod: GenericModifiers) sampler.Modifiers.AddLast(mod(freq, volume, sampleRate));
 }
 
 }}}
@@ -29,6 +29,9 @@ struct MusicalInstrument
 	Array<GenericModifierFactory> GenericModifiers;
 
 	NoteSampler operator()(float freq, float volume, uint sampleRate) const;
+
+	//! Переинициализирует sampler для новой ноты, переиспользуя память его массивов.
+	void operator()(NoteSampler& sampler, float freq, float volume, uint sampleRate) const;
 };
 
 }}}
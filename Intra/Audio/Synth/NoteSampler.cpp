@@ -1,4 +1,4 @@
-#include "NoteSampler.h"
+﻿#include "NoteSampler.h"
 #include "Range/Mutation/Fill.h"
 #include "Range/Mutation/Transform.h"
 
@@ -8,7 +8,7 @@ Span<float> NoteSampler::operator()(Span<float> dst, bool add)
 {
 	auto notProcessedPart = dst.Drop(ADSR.SamplesLeft());
 	dst = dst.Take(ADSR.SamplesLeft());
-	if(add && (!Modifiers.Empty() || ADSR))
+	if(add && hasModifiers())
 	{
 		float tempArr[1024];
 		while(!dst.Full() && !Empty())
@@ -27,7 +27,7 @@ Span<float> NoteSampler::operator()(Span<float> dst, bool add)
 
 size_t NoteSampler::operator()(Span<float> dstLeft, Span<float> dstRight, bool add)
 {
-	if(Modifiers.Empty() && !ADSR && GenericSamplers.Empty())
+	if(!hasModifiers() && GenericSamplers.Empty())
 	{
 		const size_t sampleCount = Math::Min(ADSR.SamplesLeft(), dstLeft.Length());
 		fillStereo(dstLeft.Take(sampleCount), dstRight.Take(sampleCount), add);
@@ -118,14 +118,17 @@ void NoteSampler::fillStereo(Span<float> dstLeft, Span<float> dstRight, bool add
 
 void NoteSampler::applyModifiers(Span<float> dst)
 {
+	if(ExponentAttenuation) ExponentAttenuation(dst);
+	if(Chorus) Chorus(dst);
 	for(auto& mod: Modifiers) mod(dst);
 	if(ADSR)
 	{
 		ADSR(dst);
 		if(ADSR.SamplesLeft() == 0)
 		{
-			WaveTableSamplers = null;
-			GenericSamplers = null;
+			// Clear keeps the memory of the arrays for the next note of a reused sampler
+			WaveTableSamplers.Clear();
+			GenericSamplers.Clear();
 		}
 	}
 }
@@ -144,6 +147,18 @@ void NoteSampler::NoteRelease()
 	if(ADSR) ADSR.NoteRelease();
 }
 
+void NoteSampler::Reset()
+{
+	// Clear keeps the capacity of the arrays, so a reused sampler doesn't allocate them again
+	WaveTableSamplers.Clear();
+	GenericSamplers.Clear();
+	Modifiers.Clear();
+	ExponentAttenuation = null;
+	Chorus.Reset(0, 0);
+	ADSR = null;
+	Pan = 0;
+}
+
 void NoteSampler::SetPan(float pan)
 {
 	for(auto& sampler: WaveTableSamplers) sampler.SetPan(pan);
@@ -9,6 +9,8 @@
 
 #include "WaveTableSampler.h"
 #include "ADSR.h"
+#include "ExponentialAttenuation.h"
+#include "Chorus.h"
 
 INTRA_PUSH_DISABLE_REDUNDANT_WARNINGS
 
@@ -21,6 +23,12 @@ public:
 	Array<WaveTableSampler> WaveTableSamplers;
 	Array<GenericSampler> GenericSamplers;
 	Array<GenericModifier> Modifiers;
+
+	//! Встроенные модификаторы хранятся в семплере, а не в Modifiers,
+	//! чтобы переиспользуемый семплер не выделял память при каждом нажатии ноты.
+	//! Применяются до Modifiers в порядке объявления.
+	ExponentAttenuator ExponentAttenuation;
+	Synth::Chorus Chorus;
 	AdsrAttenuator ADSR;
 	float Pan = 0;
 
@@ -30,6 +38,7 @@ public:
 	void MultiplyPitch(float freqMultiplier);
 	void NoteRelease();
 	void SetPan(float pan);
+	void Reset();
 
 	bool Empty() const noexcept {return (WaveTableSamplers.Empty() && GenericSamplers.Empty()) || ADSR.SamplesLeft() == 0;}
 
@@ -37,6 +46,7 @@ private:
 	void fill(Span<float> dst, bool add);
 	void fillStereo(Span<float> dstLeft, Span<float> dstRight, bool add);
 	void applyModifiers(Span<float> dst);
+	bool hasModifiers() const noexcept {return ExponentAttenuation || Chorus || !Modifiers.Empty() || ADSR;}
 };
 
 
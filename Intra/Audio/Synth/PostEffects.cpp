@@ -3,26 +3,54 @@
 #include "Math/SineRange.h"
 #include "Math/Math.h"
 #include "Container/Sequential/Array.h"
+#include "Range/Mutation/Copy.h"
+#include "Range/Mutation/Fill.h"
+#include "Range/Mutation/Transform.h"
+#include "Cpp/Intrinsics.h"
 
 namespace Intra { namespace Audio { namespace Synth { namespace PostEffects {
 
 void Echo::operator()(Span<float> inOutSamples, uint sampleRate) const
 {
-	Array<float> copy(inOutSamples);
-	const double duration = double(inOutSamples.Length())/sampleRate;
-	float t = 0;
-	const float dt = 1.0f/float(sampleRate);
-	while(!inOutSamples.Empty())
+	// Семпл i смешивается с исходным семплом i + delay. Семплы, для которых он выходит за границы звука, не меняются.
+	const double delayInSamples = Math::Floor(double(Delay)*double(sampleRate));
+	if(Math::Abs(delayInSamples) >= double(inOutSamples.Length())) return;
+	const size_t len = inOutSamples.Length();
+	if(delayInSamples >= 0)
 	{
-		float st = t+Delay;
-		if(st>=0 && st<duration)
-		{
-			inOutSamples.First() *= MainVolume;
-			inOutSamples.First() += copy[uint(st*float(sampleRate))]*SecondaryVolume;
-		}
-		t += dt;
-		inOutSamples.PopFirst();
+		// Источник находится впереди приёмника, поэтому при проходе вперёд он ещё не изменён и копия звука не нужна
+		const size_t delay = size_t(delayInSamples);
+		AddMultiplied(inOutSamples.Take(len - delay), MainVolume, inOutSamples.Drop(delay), SecondaryVolume);
+		return;
 	}
+
+	// Источник позади приёмника - проходим с конца
+	const size_t delay = size_t(-delayInSamples);
+	for(size_t i = len; i --> delay;)
+		inOutSamples[i] = inOutSamples[i]*MainVolume + inOutSamples[i - delay]*SecondaryVolume;
+}
+
+void Reverb::operator()(Span<float> inOutSamples, uint sampleRate) const
+{
+	(void)sampleRate;
+	ConvolutionReverb reverb(ImpulseResponse, DryVolume, WetVolume);
+	const size_t latency = reverb.Latency();
+	reverb(inOutSamples);
+	if(inOutSamples.Length() <= latency)
+	{
+		// Весь выход пришёлся на задержку, досчитываем его, подав на вход тишину
+		Array<float> tail;
+		tail.SetCount(latency, 0);
+		reverb(tail);
+		CopyTo(tail.Drop(latency - inOutSamples.Length()), inOutSamples);
+		return;
+	}
+
+	// Выход задержан на latency семплов: сдвигаем его к началу и досчитываем последние latency семплов
+	C::memmove(inOutSamples.Data(), inOutSamples.Data() + latency, (inOutSamples.Length() - latency)*sizeof(float));
+	const Span<float> end = inOutSamples.Drop(inOutSamples.Length() - latency);
+	FillZeros(end);
+	reverb(end);
 }
 
 void FilterDrive::operator()(Span<float> inOutSamples, uint sampleRate) const
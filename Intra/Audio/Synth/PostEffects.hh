@@ -8,6 +8,7 @@
 #include "Math/SineRange.h"
 
 #include "Types.h"
+#include "ConvolutionReverb.h"
 
 INTRA_PUSH_DISABLE_REDUNDANT_WARNINGS
 
@@ -24,6 +25,18 @@ struct Echo
 	void operator()(Span<float> inOutSamples, uint sampleRate) const;
 };
 
+//! Свёртка всего звука с импульсной характеристикой. Задержка свёртки компенсируется, длина звука не меняется.
+struct Reverb
+{
+	Shared<PartitionedImpulseResponse> ImpulseResponse;
+	float DryVolume, WetVolume;
+
+	Reverb(Shared<PartitionedImpulseResponse> impulseResponse, float dryVolume=1, float wetVolume=1):
+		ImpulseResponse(Cpp::Move(impulseResponse)), DryVolume(dryVolume), WetVolume(wetVolume) {}
+
+	void operator()(Span<float> inOutSamples, uint sampleRate) const;
+};
+
 struct FilterDrive
 {
 	float K;
@@ -2,6 +2,8 @@
 
 #include "Cpp/Warnings.h"
 
+#include "Cpp/PlacementNew.h"
+
 #include "Utils/Span.h"
 
 #include "Funal/Delegate.h"
@@ -25,6 +27,11 @@ public:
 	virtual void NoteRelease() {}
 	virtual void MultiplyPitch(float freqMultiplier) {(void)freqMultiplier;}
 	IGenericSampler* Clone() const override = 0;
+
+	//! Сконструировать в памяти place копию семплера или перенести в неё семплер и вернуть указатель на результат.
+	//! Используются GenericSampler для семплеров, хранящихся внутри него.
+	virtual IGenericSampler* CloneTo(void* place) const = 0;
+	virtual IGenericSampler* MoveTo(void* place) = 0;
 };
 
 INTRA_DEFINE_EXPRESSION_CHECKER(HasNoteRelease, Meta::Val<T>().NoteRelease());
@@ -36,6 +43,8 @@ public:
 	GenericSamplerImpl(OBJ&& obj): Obj(Cpp::Move(obj)) {}
 	GenericSamplerImpl(const OBJ& obj): Obj(obj) {}
 	GenericSamplerImpl* Clone() const final { return new GenericSamplerImpl(Obj); }
+	GenericSamplerImpl* CloneTo(void* place) const final { return new(place) GenericSamplerImpl(Obj); }
+	GenericSamplerImpl* MoveTo(void* place) final { return new(place) GenericSamplerImpl(Cpp::Move(Obj)); }
 	forceinline Span<float> operator()(Span<float> dst, bool add) final { return Obj(dst, add); }
 
 	forceinline void NoteRelease() final {noteRelease();}
@@ -63,29 +72,70 @@ private:
 
 class GenericSampler
 {
-	Unique<IGenericSampler> mSampler;
+	//! Небольшие семплеры, например ударных и белого шума, хранятся внутри объекта,
+	//! поэтому их создание при нажатии ноты не выделяет память.
+	enum: size_t {InlineSize = 48};
+
+	IGenericSampler* mSampler;
+	union
+	{
+		void* mForceAlignment;
+		byte mInline[InlineSize];
+	};
 
 	typedef Span<float>(*FunctionPtr)(Span<float> dst, bool add);
 
-	
+	forceinline bool isInline() const noexcept {return static_cast<const void*>(mSampler) == mInline;}
+
+	template<typename T, typename A> void construct(A&& arg)
+	{
+		typedef GenericSamplerImpl<T> Impl;
+		if(sizeof(Impl) <= InlineSize && alignof(Impl) <= alignof(void*)) mSampler = new(mInline) Impl(Cpp::Forward<A>(arg));
+		else mSampler = new Impl(Cpp::Forward<A>(arg));
+	}
+
+	void copyFrom(const GenericSampler& rhs)
+	{
+		if(rhs.mSampler == null) mSampler = null;
+		else if(rhs.isInline()) mSampler = rhs.mSampler->CloneTo(mInline);
+		else mSampler = rhs.mSampler->Clone();
+	}
+
+	void moveFrom(GenericSampler& rhs)
+	{
+		if(rhs.isInline())
+		{
+			mSampler = rhs.mSampler->MoveTo(mInline);
+			rhs.destroy();
+		}
+		else mSampler = rhs.mSampler;
+		rhs.mSampler = null;
+	}
+
+	void destroy()
+	{
+		if(isInline()) mSampler->~IGenericSampler();
+		else delete mSampler;
+		mSampler = null;
+	}
+
 public:
 	forceinline GenericSampler(null_t=null): mSampler(null) {}
 
 	template<typename T, typename = Meta::EnableIf<
 		!Meta::IsFunction<Meta::RemovePointer<Meta::RemoveConstRef<T>>>::_ &&
 		Meta::IsCallable<T, Span<float>, bool>::_
-	>> GenericSampler(T&& obj): mSampler(new GenericSamplerImpl<Meta::RemoveConstRef<T>>(Cpp::Forward<T>(obj))) {}
+	>> GenericSampler(T&& obj) {construct<Meta::RemoveConstRef<T>>(Cpp::Forward<T>(obj));}
 
-	GenericSampler(FunctionPtr freeFunction)
-	{if(freeFunction) mSampler = new GenericSamplerImpl<FunctionPtr>(freeFunction);}
+	GenericSampler(FunctionPtr freeFunction): mSampler(null)
+	{if(freeFunction) construct<FunctionPtr>(freeFunction);}
 
 	forceinline GenericSampler(Unique<IGenericSampler> sampler):
-		mSampler(Cpp::Move(sampler)) {}
-
-	forceinline GenericSampler(const GenericSampler& rhs)
-	{if(rhs) mSampler = rhs.mSampler->Clone();}
+		mSampler(sampler.Release()) {}
 
-	forceinline GenericSampler(GenericSampler&& rhs) = default;
+	forceinline GenericSampler(const GenericSampler& rhs) {copyFrom(rhs);}
+	forceinline GenericSampler(GenericSampler&& rhs) {moveFrom(rhs);}
+	forceinline ~GenericSampler() {destroy();}
 
 	//! Генератор семплов.
 	//! @param[out] dst Массив в который записываются или складываются семплы. Считывается семплов не больше, чем dst.Length().
@@ -103,16 +153,35 @@ public:
 
 	GenericSampler& operator=(const GenericSampler& rhs)
 	{
-		if(!rhs.mSampler) mSampler = null;
-		else mSampler = rhs.mSampler->Clone();
+		if(this == &rhs) return *this;
+		destroy();
+		copyFrom(rhs);
 		return *this;
 	}
 
-	forceinline GenericSampler& operator=(GenericSampler&&) = default;
+	GenericSampler& operator=(GenericSampler&& rhs)
+	{
+		if(this == &rhs) return *this;
+		destroy();
+		moveFrom(rhs);
+		return *this;
+	}
 
-	forceinline Unique<IGenericSampler> TakeAwaySampler() noexcept {return Cpp::Move(mSampler);}
+	//! Передать владение семплером. Семплер, хранящийся внутри объекта, при этом копируется в кучу.
+	Unique<IGenericSampler> TakeAwaySampler() {return ReleaseSampler();}
 	forceinline IGenericSampler& MySampler() const {return *mSampler;}
-	forceinline IGenericSampler* ReleaseSampler() noexcept {return mSampler.Release();}
+	IGenericSampler* ReleaseSampler()
+	{
+		if(!isInline())
+		{
+			IGenericSampler* const result = mSampler;
+			mSampler = null;
+			return result;
+		}
+		IGenericSampler* const result = mSampler->Clone();
+		destroy();
+		return result;
+	}
 
 	forceinline explicit operator bool() const {return mSampler != null;}
 };
@@ -100,23 +100,6 @@ static void GenerateRandomPhases(Span<float> inOutRealAmplitudes, Span<float> ou
 	}
 }
 
-static void ReflectComplexAmplitudes(Span<float> inOutRealAmplitudesX2, Span<float> inOutImagAmplitudesX2)
-{
-	inOutImagAmplitudesX2[inOutImagAmplitudesX2.Length() / 2] = 0;
-	inOutRealAmplitudesX2.PopFirst();
-	inOutImagAmplitudesX2.PopFirst();
-	while(!inOutRealAmplitudesX2.Empty())
-	{
-		inOutRealAmplitudesX2.Last() = inOutRealAmplitudesX2.First();
-		inOutImagAmplitudesX2.Last() = -inOutImagAmplitudesX2.First();
-		inOutRealAmplitudesX2.PopFirst();
-		inOutImagAmplitudesX2.PopFirst();
-		if(inOutRealAmplitudesX2.Empty()) break;
-		inOutRealAmplitudesX2.PopLast();
-		inOutImagAmplitudesX2.PopLast();
-	}
-}
-
 static void NormalizeSamples(Span<float> inOutSamples, float volume = 1)
 {
 	const auto minimax = MiniMax(inOutSamples.AsConstRange());
@@ -129,11 +112,12 @@ void ConvertAmplutudesToSamples(Span<float> inAmplitudesX2OutSamples, Span<float
 {
 	INTRA_DEBUG_ASSERT(tempBuffer.Length() >= inAmplitudesX2OutSamples.Length());
 	INTRA_DEBUG_ASSERT(inAmplitudesX2OutSamples.Length() % 2 == 0);
-	GenerateRandomPhases(
-		inAmplitudesX2OutSamples.Take(inAmplitudesX2OutSamples.Length() / 2),
-		tempBuffer.Take(inAmplitudesX2OutSamples.Length() / 2));
-	ReflectComplexAmplitudes(inAmplitudesX2OutSamples, tempBuffer.Take(inAmplitudesX2OutSamples.Length()));
-	InplaceInverseFFTNonNormalized(inAmplitudesX2OutSamples, tempBuffer.Take(inAmplitudesX2OutSamples.Length()));
+	const size_t halfLength = inAmplitudesX2OutSamples.Length() / 2;
+	GenerateRandomPhases(inAmplitudesX2OutSamples.Take(halfLength), tempBuffer.Take(halfLength));
+
+	//Спектр действительного сигнала симметричен, поэтому достаточно первой половины амплитуд и обратного БПФ половинного размера
+	FFTPlan::Get(inAmplitudesX2OutSamples.Length()).InverseRealNonNormalized(
+		inAmplitudesX2OutSamples.Take(halfLength + 1), tempBuffer.Take(halfLength + 1), inAmplitudesX2OutSamples);
 	NormalizeSamples(inAmplitudesX2OutSamples, volume);
 	//InplaceInverseFFT(inAmplitudesX2OutSamples, tempBuffer.Take(inAmplitudesX2OutSamples.Length()));
 	//Multiply(inAmplitudesX2OutSamples, volume);
@@ -26,6 +26,12 @@
 
 #include "Random/FastUniform.h"
 
+#include "Concurrency/Atomic.h"
+#include "Concurrency/Mutex.h"
+#include "Concurrency/Lock.h"
+
+#include "Utils/Debug.h"
+
 
 namespace Intra { namespace Audio { namespace Synth {
 
@@ -479,7 +485,7 @@ WaveTableSampler WaveInstrument::operator()(float freq, float volume, uint sampl
 
 WaveTableSampler WaveTableInstrument::operator()(float freq, float volume, uint sampleRate) const
 {
-	auto& table = Tables->Get(freq, sampleRate);
+	const WaveTable& table = Tables->Get(freq, sampleRate);
 	const float ratio = freq / float(sampleRate);
 	const size_t level = table.NearestLevelForRatio(ratio);
 	const auto samples = table.LevelSamples(level);
@@ -490,25 +496,114 @@ WaveTableSampler WaveTableInstrument::operator()(float freq, float volume, uint
 }
 
 
-WaveTable& WaveTableCache::Get(float freq, uint sampleRate) const
+struct WaveTableCache::Data
 {
-	float freqSampleRateRatio = freq/float(sampleRate);
-	for(size_t i = 0; i < Tables.Length(); i++)
+	//! Узлы односвязного списка только добавляются в его начало и не изменяются после публикации.
+	struct Node
 	{
-		float rate = freqSampleRateRatio / Tables[i].BaseLevelRatio;
+		WaveTable Table;
+		uint SampleRate;
+		Node* Next;
+	};
+
+#if(INTRA_LIBRARY_ATOMIC != INTRA_LIBRARY_ATOMIC_None)
+	Concurrency::AtomicBase<Node*> Head{null};
+	Concurrency::AtomicInteger<size_t> Count{0};
+#else
+	Node* Head = null;
+	size_t Count = 0;
+#endif
+
+#if(INTRA_LIBRARY_MUTEX != INTRA_LIBRARY_MUTEX_None)
+	Mutex GenerationMutex;
+#endif
+
+	Node* First() const
+	{
+#if(INTRA_LIBRARY_ATOMIC != INTRA_LIBRARY_ATOMIC_None)
+		return Head.GetAcquire();
+#else
+		return Head;
+#endif
+	}
+
+	void Publish(Node* node)
+	{
+		node->Next = First();
+#if(INTRA_LIBRARY_ATOMIC != INTRA_LIBRARY_ATOMIC_None)
+		Head.SetRelease(node);
+		Count.Increment();
+#else
+		Head = node;
+		Count++;
+#endif
+	}
+
+	~Data()
+	{
+		for(Node* node = First(); node != null;)
+		{
+			Node* const next = node->Next;
+			delete node;
+			node = next;
+		}
+	}
+};
+
+WaveTableCache::WaveTableCache(): mData(new Data) {}
+WaveTableCache::~WaveTableCache() {}
+WaveTableCache::WaveTableCache(WaveTableCache&&) = default;
+WaveTableCache& WaveTableCache::operator=(WaveTableCache&&) = default;
+
+const WaveTable* WaveTableCache::find(float freqSampleRateRatio, uint sampleRate) const
+{
+	for(const Data::Node* node = mData->First(); node != null; node = node->Next)
+	{
+		if(node->SampleRate != sampleRate) continue;
+		const float rate = freqSampleRateRatio / node->Table.BaseLevelRatio;
 		if(!AllowMipmaps)
 		{
-			if(0.9999f < rate && rate < 1.0001f) return Tables[i];
+			if(0.9999f < rate && rate < 1.0001f) return &node->Table;
 			continue;
 		}
 		float r = rate;
 		while(r >= 0.9999f)
 		{
-			if(0.9999f < r && r < 1.0001f) return Tables[i];
+			if(0.9999f < r && r < 1.0001f) return &node->Table;
 			r *= 0.5f;
 		}
 	}
-	return Tables.AddLast(Generator(freq, sampleRate));
+	return null;
+}
+
+const WaveTable& WaveTableCache::Get(float freq, uint sampleRate) const
+{
+	INTRA_DEBUG_ASSERT(mData != null);
+	const float freqSampleRateRatio = freq/float(sampleRate);
+	if(const WaveTable* const table = find(freqSampleRateRatio, sampleRate)) return *table;
+
+#if(INTRA_LIBRARY_MUTEX != INTRA_LIBRARY_MUTEX_None)
+	auto locker = Concurrency::MakeLock(mData->GenerationMutex);
+	// пока мы ждали блокировку, эту таблицу мог сгенерировать другой поток
+	if(const WaveTable* const table = find(freqSampleRateRatio, sampleRate)) return *table;
+#endif
+	Data::Node* const node = new Data::Node{Generator(freq, sampleRate), sampleRate, null};
+	mData->Publish(node);
+	return node->Table;
+}
+
+void WaveTableCache::Preload(CSpan<float> freqs, uint sampleRate) const
+{
+	for(float freq: freqs) Get(freq, sampleRate);
+}
+
+size_t WaveTableCache::Count() const
+{
+#if(INTRA_LIBRARY_ATOMIC != INTRA_LIBRARY_ATOMIC_None)
+	return mData->Count.Get();
+#else
+	return mData->Count;
+#endif
 }
 
 }}}
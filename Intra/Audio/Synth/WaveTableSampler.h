@@ -8,6 +8,8 @@
 
 #include "Container/Sequential/Array.h"
 
+#include "Utils/Unique.h"
+
 #include "Types.h"
 #include "Filter.h"
 #include "WaveTable.h"
@@ -134,20 +136,39 @@ struct WaveInstrument
 	WaveTableSampler operator()(float freq, float volume, uint sampleRate) const;
 };
 
+//! Кеш волновых таблиц одного инструмента.
+//! Таблицы различаются частотой дискретизации и отношением частоты к частоте дискретизации.
+//! Может использоваться одновременно из нескольких потоков: поиск уже созданной таблицы выполняется без блокировок,
+//! а каждая таблица генерируется ровно один раз. Созданные таблицы не изменяются и не перемещаются до разрушения кеша.
+//! Generator и AllowMipmaps нельзя менять после первого вызова Get.
 struct WaveTableCache
 {
 	typedef Delegate<WaveTable(float freq, uint sampleRate)> GeneratorType;
-	mutable Array<WaveTable> Tables;
 	GeneratorType Generator;
 	bool AllowMipmaps = false;
 
-	WaveTable& Get(float freq, uint sampleRate) const;
+	//! Возвращает таблицу для частоты freq, генерируя её при первом обращении.
+	const WaveTable& Get(float freq, uint sampleRate) const;
+
+	//! Заранее генерирует таблицы для всех частот из freqs, чтобы Get не выполнял генерацию во время синтеза.
+	//! Частоты лучше передавать по возрастанию: при AllowMipmaps таблица низкой частоты подходит и для её октав вверх.
+	void Preload(CSpan<float> freqs, uint sampleRate) const;
+
+	//! Количество сгенерированных таблиц.
+	size_t Count() const;
 
-	WaveTableCache() {}
+	WaveTableCache();
+	~WaveTableCache();
 	WaveTableCache(const WaveTableCache&) = delete;
 	WaveTableCache& operator=(const WaveTableCache&) = delete;
-	WaveTableCache(WaveTableCache&&) = default;
-	WaveTableCache& operator=(WaveTableCache&&) = default;
+	WaveTableCache(WaveTableCache&&);
+	WaveTableCache& operator=(WaveTableCache&&);
+
+private:
+	struct Data;
+	Unique<Data> mData;
+
+	const WaveTable* find(float freqSampleRateRatio, uint sampleRate) const;
 };
 
 struct WaveTableInstrument
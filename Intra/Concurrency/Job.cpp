@@ -1,278 +1,70 @@
-﻿
-#include "Cpp/PlatformDetect.h"
-#include "Random/FastUniform.h"
-#include "Container/Sequential/Array.h"
+﻿#include "Concurrency/Job.h"
+#include "Concurrency/ThreadPool.h"
 
-#include "Thread.h"
-#include "Mutex.h"
-#include "Atomic.h"
-#include "Lock.h"
+#include "Cpp/Warnings.h"
+#include "Utils/Debug.h"
 
 #if(INTRA_LIBRARY_THREAD != INTRA_LIBRARY_THREAD_None)
 
-#include "Concurrency/Job.h"
-
-#undef Yield
+INTRA_PUSH_DISABLE_REDUNDANT_WARNINGS
 
 namespace Intra { namespace Concurrency {
 
-using namespace Math;
-
-class WorkStealingQueue;
-static Array<WorkStealingQueue*> queues;
-
-#if(INTRA_LIBRARY_ATOMIC == INTRA_LIBRARY_ATOMIC_None)
-class WorkStealingQueue
-{
-public:
-	WorkStealingQueue(): mJobs(), mBottom(0), mTop(0), mMutex()
-	{
-		queues.AddLast(this);
-	}
-
-	WorkStealingQueue(const WorkStealingQueue&) = delete;
-	WorkStealingQueue& operator=(const WorkStealingQueue&) = delete;
-
-	enum: uint {NUMBER_OF_JOBS = 4096};
-
-	void Push(Job* job)
-	{
-		INTRA_SYNCHRONIZED(mMutex)
-		{
-			jobs[mBottom++ % NUMBER_OF_JOBS] = job;
-		}
-	}
-
-	Job* Pop()
-	{
-		auto locker = MakeLock(mMutex);
-		const int jobCount = int(mBottom) - int(mTop);
-		if(jobCount <= 0)
-		{
-			// no job left in the queue
-			return null;
-		}
-		return jobs[--mBottom % NUMBER_OF_JOBS];
-	}
-
-	Job* Steal()
-	{
-		auto locker = MakeLock(mMutex);
-		const int jobCount = int(mBottom) - int(mTop);
-		if(jobCount <= 0) return null;
-		return mJobs[mTop++ % NUMBER_OF_JOBS];
-	}
-
-private:
-	Array<Job*> mJobs;
-	uint mBottom, mTop;
-	Mutex mMutex;
-};
-#else
-class WorkStealingQueue
+Job::Job(ThreadPool& pool, Function function, Job* parent, int refCount, CSpan<byte> data):
+	mFunction(function), mParent(parent), mPool(&pool),
+	mUnfinishedJobCount(1), mRefCount(refCount)
 {
-public:
-	WorkStealingQueue()
-	{
-		queues.AddLast(this);
-	}
-
-	WorkStealingQueue(const WorkStealingQueue&) = delete;
-	WorkStealingQueue& operator=(const WorkStealingQueue&) = delete;
-
-	enum {NUMBER_OF_JOBS = 4096};
-
-	void Push(Job* job)
-	{
-		int b = mBottom.GetRelaxed();
-		mJobs[size_t(b % NUMBER_OF_JOBS)] = job;
-
-		mBottom.Set(b + 1);
-	}
-
-	Job* Pop()
-	{
-		const int b = mBottom.GetRelaxed() - 1;
-		mBottom.Set(b);
-
-		int t = mTop.Get();
-		if(t <= b)
-		{
-			// non-empty queue
-			Job* job = mJobs[size_t(b % NUMBER_OF_JOBS)];
-			if(t != b)
-			{
-				// there's still more than one item left in the queue
-				return job;
-			}
-
-			// this is the last item in the queue
-			if(mTop.CompareSet(t, t + 1))
-			{
-				// failed race against steal operation
-				job = null;
-			}
-
-			mBottom.SetRelaxed(t + 1);
-			return job;
-		}
-		else
-		{
-			// deque was already empty
-			mBottom.SetRelaxed(t);
-			return null;
-		}
-	}
-
-	Job* Steal()
-	{
-		int t = mTop.Get();
-
-		int b = mBottom.GetRelaxed();
-		if(t < b)
-		{
-			// non-empty queue
-			Job* job = mJobs[size_t(t % NUMBER_OF_JOBS)];
-
-			// serves as a compiler barrier, and guarantees that the read happens before the CAS.
-			if(mTop.CompareSet(t, t + 1))
-			{
-				// a concurrent steal or pop operation removed an element from the deque in the meantime.
-				return null;
-			}
-
-			return job;
-		}
-		else
-		{
-			// empty queue
-			return null;
-		}
-	}
-
-private:
-	Array<Job*> mJobs;
-	AtomicInt mTop, mBottom;
-};
-#endif
-
-
-
-
-namespace
-{
-	/*thread_local*/ WorkStealingQueue wsqueue;
-	AtomicInt JobToDeleteCount;
-	Array<Job*> JobsToDelete;
+	INTRA_DEBUG_ASSERT(data.Length() <= DataSize);
+	data.CopyTo(SpanOf(mData));
 }
 
-void WorkerMain()
+Job* Job::Create(ThreadPool& pool, Function function, CSpan<byte> data)
 {
-	bool workerThreadActive = true;
-	while(workerThreadActive)
-	{
-		Job* job = Job::Get();
-		if(job != null) job->Execute();
-	}
+	// one reference for the caller and one which is dropped when the job is finished
+	return new Job(pool, function, null, 2, data);
 }
 
+Job* Job::CreateIn(JobStorage& storage, ThreadPool& pool, Function function, CSpan<byte> data)
+{return new(storage.Bytes) Job(pool, function, null, StorageRefCount, data);}
 
-enum {MaxJobCount = 4096};
-static thread_local Array<Job> g_jobAllocator;
-static thread_local uint g_allocatedJobs = 0u;
-
-Job* Job::Allocate()
+Job* Job::CreateAsChild(Job* parent, Function function, CSpan<byte> data)
 {
-	const uint index = g_allocatedJobs++;
-	return &g_jobAllocator[(index - 1) % MaxJobCount];
-}
-
-bool Job::IsEmpty()
-{
-	return mUnfinishedJobCount.GetRelaxed() == -1;
+	INTRA_DEBUG_ASSERT(!parent->IsFinished());
+	parent->mUnfinishedJobCount.Increment();
+	return new Job(*parent->mPool, function, parent, 1, data);
 }
 
-Job* Job::Get()
-{
-	Job* const job = wsqueue.Pop();
-	if(job->IsEmpty())
-	{
-		// this is not a valid job because our own queue is empty, so try stealing from some other queue
-		const size_t randomIndex = (reinterpret_cast<size_t>(job) >> 6) % queues.Count();
-		WorkStealingQueue* const stealQueue = queues[randomIndex];
-		if(stealQueue == &wsqueue)
-		{
-			// don't try to steal from ourselves
-			ThisThread.Yield();
-			return null;
-		}
-
-		Job* stolenJob = stealQueue->Steal();
-		if(stolenJob->IsEmpty())
-		{
-			// we couldn't steal a job from the other queue either, so we just yield our time slice for now
-			ThisThread.Yield();
-			return null;
-		}
+void Job::Run() {mPool->Run(this);}
 
-		return stolenJob;
-	}
+void Job::Wait() const {mPool->Wait(this);}
 
-	return job;
-}
+bool Job::IsFinished() const
+{return mUnfinishedJobCount.GetAcquire() == 0;}
 
-void Job::Finish()
+void Job::Release()
 {
-	const int unfinishedJobs = mUnfinishedJobCount.Increment();
-	if(unfinishedJobs == 0 && mParent != null) mParent->Finish();
+	if(mRefCount.DecrementAcquireRelease() == 0)
+		delete this;
 }
 
 void Job::Execute()
 {
-	mFunction(this, data);
-	Finish();
+	mFunction(this, mData);
+	finish();
 }
 
-Job* Job::CreateJob(Job::Function function)
+void Job::finish()
 {
-	g_jobAllocator.SetCountUninitialized(MaxJobCount);
-
-	Job* result = Job::Allocate();
-	result->mFunction = function;
-	result->mParent = null;
-	result->mUnfinishedJobCount.Set(1);
-
-	return result;
-}
-
-Job* Job::CreateJobAsChild(Job* parent, Job::Function function)
-{
-	parent->mUnfinishedJobCount.Increment();
-
-	Job* result = Job::Allocate();
-	result->mFunction = function;
-	result->mParent = parent;
-	result->mUnfinishedJobCount.Set(1);
-
-	return result;
-}
-
-
-
-void Job::Run()
-{
-	wsqueue.Push(this);
-}
-
-void Job::Wait() const
-{
-	while(mUnfinishedJobCount.Get() != 0)
-	{
-		Job* nextJob = Job::Get();
-		if(nextJob != null) nextJob->Execute();
-	}
+	Job* const parent = mParent;
+	// the owner of a job in its own storage may reuse it as soon as it is finished, so it is checked beforehand
+	const bool inStorage = mRefCount.GetRelaxed() == StorageRefCount;
+	if(mUnfinishedJobCount.DecrementAcquireRelease() != 0) return;
+	if(parent != null) parent->finish();
+	if(!inStorage) Release();
 }
 
 }}
 
-#endif
\ No newline at end of file
+INTRA_WARNING_POP
+
+#endif
@@ -3,59 +3,134 @@
 #include "Cpp/PlatformDetect.h"
 #include "Cpp/Warnings.h"
 #include "Cpp/Fundamental.h"
+#include "Cpp/PlacementNew.h"
 
+#include "Meta/Type.h"
+
+#include "Thread.h"
 #include "Atomic.h"
 #include "Utils/Span.h"
 
-//Ещё не протестировано
-
 namespace Intra { namespace Concurrency {
 
 INTRA_PUSH_DISABLE_REDUNDANT_WARNINGS
 
+class ThreadPool;
+
+#if(INTRA_LIBRARY_THREAD != INTRA_LIBRARY_THREAD_None)
+
+union JobStorage;
+
+//! A unit of work scheduled on a ThreadPool.
+//! Jobs form fork/join trees: a job is finished only when its function has returned and all of its children are finished.
+//! A job returned by Create must be released with Release after the last access to it.
+//! Child jobs are owned by the pool and must not be accessed after Run.
 struct Job
 {
 	typedef void(*Function)(Job*, const void*);
 
-	Function mFunction;
-	Job* mParent;
-	Concurrency::AtomicInt mUnfinishedJobCount;
-#ifndef INTRA_PLATFORM_IS_64
-	enum {PADDING_SIZE = 52};
-#else
-	enum {PADDING_SIZE = 44};
-#endif
-	byte data[PADDING_SIZE];
+	enum: size_t {DataSize = 64 - 3*sizeof(void*) - 2*sizeof(int)};
 
-	Job(const Job& rhs):
-		mFunction(rhs.mFunction), mParent(rhs.mParent),
-		mUnfinishedJobCount(rhs.mUnfinishedJobCount.Get())
-	{SpanOf(rhs.data).CopyTo(SpanOf(data));}
+	//! Create a job which calls function(job, copyOfData) when executed.
+	//! data is copied into the job and must fit into DataSize bytes.
+	static Job* Create(ThreadPool& pool, Function function, CSpan<byte> data = null);
 
+	//! Create a job in caller-owned storage which calls function(job, copyOfData) when executed.
+	//! The pool never destroys such a job and does not access it after it is finished,
+	//! so the storage may be reused for the next job as soon as IsFinished returns true. Such a job must not be released.
+	//! Allows a real-time thread to run jobs without allocating memory. Its children are still allocated on the heap.
+	static Job* CreateIn(JobStorage& storage, ThreadPool& pool, Function function, CSpan<byte> data = null);
 
-	template<typename T, typename S> static Job* parallel_for(T* data, uint count, Function function, const S& splitter)
-	{
-		typedef parallel_for_data<T, S> JobData;
-		const JobData jobData(data, count, function, splitter);
+	//! Create a job which calls function(job, copyOfData) when executed and makes parent wait for it.
+	//! Must be called before parent is finished, usually from parent's function.
+	static Job* CreateAsChild(Job* parent, Function function, CSpan<byte> data = null);
 
-		Job* const job = CreateJob(&parallel_for_job<JobData>, jobData);
+	template<typename F, typename = Meta::EnableIf<
+		Meta::IsCallable<F>::_
+	>> static Job* Create(ThreadPool& pool, F&& func)
+	{
+		typedef Meta::RemoveConstRef<F> Functor;
+		Job* const result = Create(pool, &functorJob<Functor>);
+		result->setFunctor(Cpp::Forward<F>(func));
+		return result;
+	}
 
-		return job;
+	template<typename F, typename = Meta::EnableIf<
+		Meta::IsCallable<F>::_
+	>> static Job* CreateAsChild(Job* parent, F&& func)
+	{
+		typedef Meta::RemoveConstRef<F> Functor;
+		Job* const result = CreateAsChild(parent, &functorJob<Functor>);
+		result->setFunctor(Cpp::Forward<F>(func));
+		return result;
 	}
 
-	static Job* Allocate();
-	static Job* Get();
-	bool IsEmpty();
-	void Finish();
-	void Execute();
+	//! Recursively split [data; data + count) with splitter and call function for each part in parallel.
+	template<typename T, typename S> static Job* parallel_for(ThreadPool& pool,
+		T* data, uint count, void(*function)(T*, uint), const S& splitter)
+	{
+		typedef parallel_for_data<T, S> JobData;
+		const JobData jobData(data, count, function, splitter);
+		return Create(pool, &parallel_for_job<JobData>, CSpanOfRaw(&jobData, sizeof(jobData)));
+	}
 
+	//! Schedule this job for execution.
 	void Run();
+
+	//! Execute other jobs until this job is finished.
 	void Wait() const;
 
-	static Job* CreateJob(Job::Function function);
-	static Job* CreateJobAsChild(Job* parent, Job::Function function);
+	//! Run this job and execute other jobs until it is finished.
+	forceinline void RunAndWait() {Run(); Wait();}
+
+	bool IsFinished() const;
+
+	//! Drop the reference returned by Create. The job is destroyed after it finishes.
+	void Release();
+
+	forceinline ThreadPool& Pool() const {return *mPool;}
+	forceinline Job* Parent() const {return mParent;}
+
+	void Execute();
 
 private:
+	Function mFunction;
+	Job* mParent;
+	ThreadPool* mPool;
+	AtomicInt mUnfinishedJobCount;
+	AtomicInt mRefCount;
+	union
+	{
+		void* mForceAlignment;
+		byte mData[DataSize];
+	};
+
+	Job(ThreadPool& pool, Function function, Job* parent, int refCount, CSpan<byte> data);
+	void finish();
+
+	template<typename Functor> void setFunctor(Functor&& func)
+	{
+		typedef Meta::RemoveConstRef<Functor> F;
+		if(sizeof(F) <= DataSize) new(mData) F(Cpp::Forward<Functor>(func));
+		else *reinterpret_cast<F**>(mData) = new F(Cpp::Forward<Functor>(func));
+	}
+
+	template<typename F> static void functorJob(Job*, const void* data)
+	{
+		if(sizeof(F) <= DataSize)
+		{
+			F& func = *static_cast<F*>(const_cast<void*>(data));
+			func();
+			func.~F();
+		}
+		else
+		{
+			F* const func = *static_cast<F* const*>(data);
+			(*func)();
+			delete func;
+		}
+	}
+
 	template<typename T, typename S> struct parallel_for_data
 	{
 		typedef T DataType;
@@ -76,18 +151,18 @@ private:
 		const JobData* data = static_cast<const JobData*>(jobData);
 		const typename JobData::SplitterType& splitter = data->splitter;
 
-		if(splitter.Split<JobData::DataType>(data->count))
+		if(splitter.template Split<typename JobData::DataType>(data->count))
 		{
 			// split in two
 			const uint leftCount = data->count/2u;
 			const JobData leftData(data->data, leftCount, data->function, splitter);
-			Job* left = Job::CreateJobAsChild(job, &Job::parallel_for_job<JobData>, leftData);
-			left->Run();
+			Job::CreateAsChild(job, &Job::parallel_for_job<JobData>,
+				CSpanOfRaw(&leftData, sizeof(leftData)))->Run();
 
 			const uint rightCount = data->count - leftCount;
 			const JobData rightData(data->data + leftCount, rightCount, data->function, splitter);
-			Job* right = Job::CreateJobAsChild(job, &Job::parallel_for_job<JobData>, rightData);
-			right->Run();
+			Job::CreateAsChild(job, &Job::parallel_for_job<JobData>,
+				CSpanOfRaw(&rightData, sizeof(rightData)))->Run();
 		}
 		else
 		{
@@ -96,10 +171,19 @@ private:
 		}
 	}
 
+	//! mRefCount of a job created by CreateIn. It is never changed, so finish knows not to release the job.
+	enum: int {StorageRefCount = -1};
+
+	Job(const Job&) = delete;
 	Job& operator=(const Job&) = delete;
 };
 
-void WorkerMain();
+//! Memory for a job created by Job::CreateIn.
+union JobStorage
+{
+	void* ForceAlignment;
+	byte Bytes[sizeof(Job)];
+};
 
 class CountSplitter
 {
@@ -124,7 +208,13 @@ public:
 private:
 	uint mSize;
 };
+#else
+struct Job;
+#endif
 
 INTRA_WARNING_POP
 
-}}
+}
+using Concurrency::Job;
+
+}
@@ -0,0 +1,33 @@
+#include "Concurrency/ParallelFor.h"
+
+#include "Cpp/Warnings.h"
+#include "System/ProcessorInfo.h"
+
+INTRA_PUSH_DISABLE_REDUNDANT_WARNINGS
+
+namespace Intra { namespace Concurrency {
+
+size_t DefaultGrainSize(size_t count, size_t elementSize, uint concurrency)
+{
+	static const System::ProcessorInfo processorInfo = System::ProcessorInfo::Get();
+	if(elementSize == 0) elementSize = 1;
+	if(concurrency == 0) concurrency = 1;
+
+	// at least 4 cache lines per part
+	size_t minGrain = 4*processorInfo.CacheLineSize/elementSize;
+	if(minGrain == 0) minGrain = 1;
+
+	// a part fits into half of L2 cache
+	size_t maxGrain = processorInfo.L2CacheSize/2/elementSize;
+	if(maxGrain < minGrain) maxGrain = minGrain;
+
+	// 4 parts per thread are enough to balance the load
+	size_t grain = (count + 4*concurrency - 1)/(4*concurrency);
+	if(grain > maxGrain) grain = maxGrain;
+	if(grain < minGrain) grain = minGrain;
+	return grain;
+}
+
+}}
+
+INTRA_WARNING_POP
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "Cpp/Warnings.h"
+#include "Cpp/Fundamental.h"
+#include "Cpp/Features.h"
+
+#include "Utils/Span.h"
+
+#include "Thread.h"
+#include "Job.h"
+#include "ThreadPool.h"
+
+INTRA_PUSH_DISABLE_REDUNDANT_WARNINGS
+
+namespace Intra { namespace Concurrency {
+
+//! Number of elements processed by one job of ParallelFor.
+//! A part is small enough to fit into half of L2 cache and to give every thread several parts for load balancing,
+//! and large enough to span several cache lines to amortize job overhead and avoid false sharing.
+//! @param elementSize Number of bytes touched per element.
+//! @param concurrency Number of threads processing the parts.
+size_t DefaultGrainSize(size_t count, size_t elementSize, uint concurrency);
+
+#if(INTRA_LIBRARY_THREAD != INTRA_LIBRARY_THREAD_None)
+namespace D {
+
+template<typename Body> struct ParallelForTask
+{
+	const Body* Func;
+	size_t Grain;
+
+	struct Part
+	{
+		const ParallelForTask* Task;
+		size_t Begin, End;
+	};
+
+	static void Run(Job* job, const void* data)
+	{
+		Part part = *static_cast<const Part*>(data);
+		while(part.End - part.Begin > part.Task->Grain)
+		{
+			const size_t middle = part.Begin + (part.End - part.Begin)/2;
+			const Part right = {part.Task, middle, part.End};
+			Job::CreateAsChild(job, &Run, CSpanOfRaw(&right, sizeof(right)))->Run();
+			part.End = middle;
+		}
+		(*part.Task->Func)(part.Begin, part.End);
+	}
+};
+
+}
+#endif
+
+//! Call body(begin, end) for disjoint subranges covering [0; count) in parallel and wait for all calls to finish.
+//! Subranges are obtained by recursive halving until they contain at most grainSize indices.
+//! The calling thread takes part in the work.
+//! @param grainSize Maximum subrange length. 0 means DefaultGrainSize(count, 1, pool.MaxConcurrency()).
+template<typename Body> void ParallelFor(ThreadPool& pool, size_t count, const Body& body, size_t grainSize = 0)
+{
+	if(grainSize == 0) grainSize = DefaultGrainSize(count, 1, pool.MaxConcurrency());
+	if(count <= grainSize || pool.ThreadCount() == 0)
+	{
+		if(count != 0) body(size_t(0), count);
+		return;
+	}
+#if(INTRA_LIBRARY_THREAD != INTRA_LIBRARY_THREAD_None)
+	typedef D::ParallelForTask<Body> Task;
+	const Task task = {&body, grainSize};
+	const typename Task::Part whole = {&task, 0, count};
+	Job* const root = Job::Create(pool, &Task::Run, CSpanOfRaw(&whole, sizeof(whole)));
+	root->Execute();
+	root->Wait();
+	root->Release();
+#endif
+}
+
+template<typename Body> forceinline void ParallelFor(size_t count, const Body& body, size_t grainSize = 0)
+{ParallelFor(ThreadPool::Default(), count, body, grainSize);}
+
+}
+using Concurrency::ParallelFor;
+
+}
+
+INTRA_WARNING_POP
@@ -0,0 +1,308 @@
+﻿#include "Concurrency/ThreadPool.h"
+#include "Concurrency/Job.h"
+#include "Concurrency/Atomic.h"
+#include "Concurrency/Mutex.h"
+#include "Concurrency/CondVar.h"
+#include "Concurrency/Lock.h"
+
+#include "Cpp/Warnings.h"
+#include "Utils/Debug.h"
+#include "Container/Sequential/Array.h"
+#include "Container/Sequential/String.h"
+#include "Random/FastUniform.h"
+#include "System/ProcessorInfo.h"
+
+#if(INTRA_LIBRARY_THREAD != INTRA_LIBRARY_THREAD_None)
+
+#undef Yield
+
+INTRA_PUSH_DISABLE_REDUNDANT_WARNINGS
+
+namespace Intra { namespace Concurrency {
+
+namespace D {
+
+//! Chase-Lev work-stealing deque.
+//! Only the owner thread may call Push and Pop, any thread may call Steal.
+//! The ring buffer grows by doubling. Old buffers are kept until destruction because concurrent thieves may still read them.
+class WorkStealingDeque
+{
+public:
+	WorkStealingDeque(): mTop(0), mBottom(0), mBufferIndex(0), mBuffers{}
+	{mBuffers[0] = new Job*[size_t(1) << InitialCapacityLog];}
+
+	~WorkStealingDeque()
+	{
+		for(Job** buffer: mBuffers) delete[] buffer;
+	}
+
+	WorkStealingDeque(const WorkStealingDeque&) = delete;
+	WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+	void Push(Job* job)
+	{
+		const long64 b = mBottom.GetRelaxed();
+		const long64 t = mTop.GetAcquire();
+		int index = mBufferIndex.GetRelaxed();
+		long64 mask = capacityOf(index) - 1;
+		if(b - t > mask)
+		{
+			// full, copy the live part into a twice larger buffer
+			INTRA_ASSERT(index + 1 < MaxBufferCount);
+			Job** const oldBuffer = mBuffers[index];
+			Job** const newBuffer = new Job*[size_t(capacityOf(index + 1))];
+			const long64 newMask = capacityOf(index + 1) - 1;
+			for(long64 i = t; i < b; i++) newBuffer[i & newMask] = oldBuffer[i & mask];
+			mBuffers[++index] = newBuffer;
+			mBufferIndex.SetRelease(index);
+			mask = newMask;
+		}
+		mBuffers[index][b & mask] = job;
+		mBottom.SetRelease(b + 1);
+	}
+
+	Job* Pop()
+	{
+		const long64 b = mBottom.GetRelaxed() - 1;
+		const int index = mBufferIndex.GetRelaxed();
+		mBottom.Set(b);
+		const long64 t = mTop.Get();
+		if(t > b)
+		{
+			// the deque was already empty
+			mBottom.SetRelaxed(b + 1);
+			return null;
+		}
+		Job* job = mBuffers[index][b & (capacityOf(index) - 1)];
+		if(t == b)
+		{
+			// this is the last job, race against thieves for it
+			if(!mTop.CompareSet(t, t + 1)) job = null;
+			mBottom.SetRelaxed(b + 1);
+		}
+		return job;
+	}
+
+	Job* Steal()
+	{
+		const long64 t = mTop.Get();
+		const long64 b = mBottom.Get();
+		if(t >= b) return null;
+		const int index = mBufferIndex.GetAcquire();
+		Job* const job = mBuffers[index][t & (capacityOf(index) - 1)];
+		// a concurrent Pop or Steal may have taken this job already
+		if(!mTop.CompareSet(t, t + 1)) return null;
+		return job;
+	}
+
+private:
+	enum: int {InitialCapacityLog = 8, MaxBufferCount = 40};
+
+	static forceinline long64 capacityOf(int bufferIndex)
+	{return long64(1) << (InitialCapacityLog + bufferIndex);}
+
+	AtomicLong mTop, mBottom;
+	AtomicInt mBufferIndex;
+	Job** mBuffers[MaxBufferCount];
+};
+
+}
+
+struct ThreadPool::Data
+{
+	struct Worker
+	{
+		Data* Owner;
+		int Index;
+		D::WorkStealingDeque Queue;
+		Random::FastUniform<uint> Random;
+		Thread Handle;
+
+		Worker(Data* owner, int index):
+			Owner(owner), Index(index), Random(uint(2654435761u*uint(index + 1))) {}
+	};
+
+	//! Number of unsuccessful job searches after which a worker parks.
+	enum: uint {SpinRoundsBeforeParking = 64};
+
+	Array<Unique<Worker>> Workers;
+
+	Mutex InjectionMutex;
+	//! Jobs are popped by advancing InjectionHead. The queue is cleared when it becomes empty,
+	//! so its buffer is reused instead of being reallocated as the jobs move towards its end.
+	Array<Job*> InjectionQueue;
+	size_t InjectionHead = 0;
+	AtomicInt InjectionCount{0};
+
+	CondVar IdleCV;
+	AtomicInt WorkVersion{0};
+	AtomicInt SleepingCount{0};
+	AtomicBool Stop{false};
+
+	static thread_local Worker* CurrentWorker;
+
+	Worker* CurrentWorkerOfThisPool() const
+	{
+		Worker* const w = CurrentWorker;
+		return w != null && w->Owner == this? w: null;
+	}
+
+	Job* PopInjected()
+	{
+		if(InjectionCount.GetRelaxed() == 0) return null;
+		INTRA_SYNCHRONIZED(InjectionMutex)
+		{
+			if(InjectionHead == InjectionQueue.Count()) return null;
+			InjectionCount.Decrement();
+			Job* const job = InjectionQueue[InjectionHead++];
+			if(InjectionHead == InjectionQueue.Count())
+			{
+				InjectionQueue.Clear();
+				InjectionHead = 0;
+			}
+			return job;
+		}
+		return null;
+	}
+
+	Job* Steal(Worker* self, Random::FastUniform<uint>& random)
+	{
+		const uint n = uint(Workers.Count());
+		if(n == 0) return null;
+		const uint start = random(n);
+		for(uint i = 0; i < n; i++)
+		{
+			Worker* const victim = Workers[(start + i) % n].Ptr();
+			if(victim == self) continue;
+			if(Job* const job = victim->Queue.Steal()) return job;
+		}
+		return null;
+	}
+
+	Job* FindJob(Worker* self, Random::FastUniform<uint>& random)
+	{
+		if(self != null) if(Job* const job = self->Queue.Pop()) return job;
+		if(Job* const job = PopInjected()) return job;
+		return Steal(self, random);
+	}
+
+	void WakeWorker()
+	{
+		WorkVersion.Increment();
+		if(SleepingCount.Get() == 0) return;
+		INTRA_SYNCHRONIZED(IdleCV) IdleCV.Notify();
+	}
+
+	void WorkerMain(Worker& self)
+	{
+		CurrentWorker = &self;
+		uint idleRounds = 0;
+		while(!Stop.GetRelaxed())
+		{
+			if(Job* const job = FindJob(&self, self.Random))
+			{
+				job->Execute();
+				idleRounds = 0;
+				continue;
+			}
+			if(++idleRounds < SpinRoundsBeforeParking)
+			{
+				ThisThread.Yield();
+				continue;
+			}
+			idleRounds = 0;
+
+			// Read the version before the last search: any job pushed after this point changes it,
+			// so either we find the job or the wait predicate sees the new version.
+			const int version = WorkVersion.Get();
+			if(Job* const job = FindJob(&self, self.Random))
+			{
+				job->Execute();
+				continue;
+			}
+			INTRA_SYNCHRONIZED(IdleCV)
+			{
+				SleepingCount.Increment();
+				IdleCV.Wait([&]() {return WorkVersion.Get() != version || Stop.Get();});
+				SleepingCount.Decrement();
+			}
+		}
+		CurrentWorker = null;
+	}
+};
+thread_local ThreadPool::Data::Worker* ThreadPool::Data::CurrentWorker = null;
+
+ThreadPool::ThreadPool(uint threadCount): mData(new Data)
+{
+	if(threadCount == 0)
+	{
+		const uint logicalProcessors = System::ProcessorInfo::Get().LogicalProcessorNumber;
+		threadCount = logicalProcessors > 1? logicalProcessors - 1: 1;
+	}
+	mData->Workers.Reserve(threadCount);
+	for(uint i = 0; i < threadCount; i++)
+		mData->Workers.AddLast(new Data::Worker(mData.Ptr(), int(i)));
+
+	// start threads only when the worker array doesn't change anymore, because thieves iterate over it
+	for(auto& worker: mData->Workers)
+	{
+		Data::Worker* const w = worker.Ptr();
+		Data* const data = mData.Ptr();
+		w->Handle = Thread("PoolWorker " + StringOf(w->Index), [data, w]() {data->WorkerMain(*w);});
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	mData->Stop.Set(true);
+	INTRA_SYNCHRONIZED(mData->IdleCV) mData->IdleCV.NotifyAll();
+	for(auto& worker: mData->Workers) worker->Handle.Join();
+}
+
+ThreadPool& ThreadPool::Default()
+{
+	static ThreadPool pool;
+	return pool;
+}
+
+uint ThreadPool::ThreadCount() const
+{return uint(mData->Workers.Count());}
+
+int ThreadPool::CurrentWorkerIndex() const
+{
+	Data::Worker* const w = mData->CurrentWorkerOfThisPool();
+	return w != null? w->Index: -1;
+}
+
+void ThreadPool::Run(Job* job)
+{
+	INTRA_DEBUG_ASSERT(&job->Pool() == this);
+	if(Data::Worker* const w = mData->CurrentWorkerOfThisPool()) w->Queue.Push(job);
+	else
+	{
+		INTRA_SYNCHRONIZED(mData->InjectionMutex)
+		{
+			mData->InjectionQueue.AddLast(job);
+			mData->InjectionCount.Increment();
+		}
+	}
+	mData->WakeWorker();
+}
+
+void ThreadPool::Wait(const Job* job)
+{
+	Data::Worker* const self = mData->CurrentWorkerOfThisPool();
+	Random::FastUniform<uint> localRandom(uint(reinterpret_cast<size_t>(job) >> 6));
+	Random::FastUniform<uint>& random = self != null? self->Random: localRandom;
+	while(!job->IsFinished())
+	{
+		if(Job* const other = mData->FindJob(self, random)) other->Execute();
+		else ThisThread.Yield();
+	}
+}
+
+}}
+
+INTRA_WARNING_POP
+
+#endif
@@ -1,2 +1,98 @@
 #pragma once
 
+#include "Cpp/PlatformDetect.h"
+#include "Cpp/Warnings.h"
+#include "Cpp/Fundamental.h"
+
+#include "Utils/Unique.h"
+
+#include "Thread.h"
+#include "Job.h"
+
+INTRA_PUSH_DISABLE_REDUNDANT_WARNINGS
+
+namespace Intra { namespace Concurrency {
+
+#if(INTRA_LIBRARY_THREAD != INTRA_LIBRARY_THREAD_None)
+
+//! Work-stealing thread pool.
+//! Every worker owns a Chase-Lev deque: it pushes and pops jobs at the bottom, idle workers steal from the top of a randomly chosen victim.
+//! Jobs run from other threads go to a shared injection queue.
+//! Workers that find no work for a while park on a condition variable until new jobs arrive.
+//! A thread waiting for a job (Job::Wait) executes other jobs in the meantime, so nested fork/join does not block workers.
+class ThreadPool
+{
+public:
+	struct Data;
+
+	//! @param threadCount Number of worker threads.
+	//! 0 means one thread per logical processor minus one, because the thread which waits for jobs executes them too.
+	explicit ThreadPool(uint threadCount = 0);
+	~ThreadPool();
+
+	//! Pool shared by the whole program. It is created on first use.
+	static ThreadPool& Default();
+
+	//! Number of worker threads.
+	uint ThreadCount() const;
+
+	//! Number of threads which may execute jobs concurrently: workers and the thread calling Job::Wait.
+	forceinline uint MaxConcurrency() const {return ThreadCount() + 1;}
+
+	//! Index of the worker thread of this pool which executes the calling code or -1 if it is not a worker of this pool.
+	int CurrentWorkerIndex() const;
+
+	//! Schedule job for execution. Usually called through Job::Run.
+	void Run(Job* job);
+
+	//! Execute jobs of this pool until job is finished. Usually called through Job::Wait.
+	void Wait(const Job* job);
+
+	//! Run func as a job and wait for it.
+	template<typename F> void Execute(F&& func)
+	{
+		Job* const job = Job::Create(*this, Cpp::Forward<F>(func));
+		job->RunAndWait();
+		job->Release();
+	}
+
+private:
+	Unique<Data> mData;
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+};
+
+#else
+
+//! Without threading support all work is done by the calling thread.
+class ThreadPool
+{
+public:
+	explicit ThreadPool(uint threadCount = 0) {(void)threadCount;}
+
+	static ThreadPool& Default()
+	{
+		static ThreadPool pool;
+		return pool;
+	}
+
+	forceinline uint ThreadCount() const {return 0;}
+	forceinline uint MaxConcurrency() const {return 1;}
+	forceinline int CurrentWorkerIndex() const {return -1;}
+
+	template<typename F> void Execute(F&& func) {func();}
+
+private:
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+};
+
+#endif
+
+}
+using Concurrency::ThreadPool;
+
+}
+
+INTRA_WARNING_POP
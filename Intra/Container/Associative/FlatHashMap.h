@@ -0,0 +1,547 @@
+﻿#pragma once
+
+#include "Cpp/Warnings.h"
+#include "Cpp/Fundamental.h"
+#include "Cpp/PlacementNew.h"
+#include "Cpp/Intrinsics.h"
+
+#include "Meta/Type.h"
+#include "Meta/Pair.h"
+
+#include "Math/Bit.h"
+#include "Math/Math.h"
+#include "Simd/Simd.h"
+#include "Utils/Debug.h"
+
+#include "Hash/ToHash.h"
+
+#include "Container/AllForwardDecls.h"
+
+#include "Memory/Allocator/AllocatorRef.h"
+#include "Memory/Allocator/Global.h"
+#include "Memory/Memory.h"
+
+
+INTRA_PUSH_DISABLE_REDUNDANT_WARNINGS
+
+namespace Intra { namespace Container {
+
+namespace D {
+
+//! Байт метаданных пустой ячейки. Занятые ячейки хранят 7 бит хеша ключа, поэтому старший бит у них всегда 0.
+enum: byte {FlatHashEmpty = 0x80};
+
+#if(INTRA_SIMD_SUPPORT >= INTRA_SIMD_SSE2 && INTRA_SIMD_SUPPORT <= INTRA_SIMD_AVX2)
+
+//! Группа из 16 байт метаданных, сравниваемых одной инструкцией SSE2.
+struct FlatHashGroup
+{
+	enum: size_t {Width = 16};
+	typedef uint Mask;
+
+	forceinline explicit FlatHashGroup(const byte* ctrl):
+		mCtrl(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl))) {}
+
+	//! Маска, в которой i-й бит установлен, если метаданные i-й ячейки равны h2.
+	forceinline Mask Match(byte h2) const
+	{return Mask(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(char(h2)), mCtrl)));}
+
+	forceinline Mask MatchEmpty() const {return Mask(_mm_movemask_epi8(mCtrl));}
+
+	static forceinline size_t LowestIndex(Mask mask) {return Math::CountTrailingZeros(mask);}
+
+private:
+	__m128i mCtrl;
+};
+
+#else
+
+//! Группа из 8 байт метаданных, сравниваемых как одно 64-битное число.
+struct FlatHashGroup
+{
+	enum: size_t {Width = 8};
+	typedef ulong64 Mask;
+
+	forceinline explicit FlatHashGroup(const byte* ctrl): mCtrl(0)
+	{
+		for(size_t i = 0; i < Width; i++) mCtrl |= ulong64(ctrl[i]) << (i*8);
+	}
+
+	//! Маска, в которой установлен старший бит каждого байта, равного h2.
+	//! Возможны ложные срабатывания на байтах, следующих за совпавшим, поэтому ключи всё равно сравниваются.
+	forceinline Mask Match(byte h2) const
+	{
+		const ulong64 x = mCtrl ^ (Lsbs*h2);
+		return (x - Lsbs) & ~x & Msbs;
+	}
+
+	forceinline Mask MatchEmpty() const {return mCtrl & Msbs;}
+
+	static forceinline size_t LowestIndex(Mask mask) {return Math::CountTrailingZeros(mask) >> 3;}
+
+private:
+	enum: ulong64 {Lsbs = 0x0101010101010101ull, Msbs = 0x8080808080808080ull};
+	ulong64 mCtrl;
+};
+
+#endif
+
+}
+
+template<typename T> struct FlatHashTableRange
+{
+	forceinline FlatHashTableRange(null_t=null): mCtrl(null), mFirst(null), mEnd(null) {}
+
+	forceinline FlatHashTableRange(const byte* ctrl, T* first, T* end):
+		mCtrl(ctrl), mFirst(first), mEnd(end) {skipEmpty();}
+
+	forceinline bool operator==(const FlatHashTableRange& rhs) const
+	{return (Empty() && rhs.Empty()) || (mFirst == rhs.mFirst && mEnd == rhs.mEnd);}
+	forceinline bool operator!=(const FlatHashTableRange& rhs) const {return !operator==(rhs);}
+	forceinline bool operator==(null_t) const {return Empty();}
+	forceinline bool operator!=(null_t) const {return !Empty();}
+
+	forceinline bool Empty() const {return mFirst == mEnd;}
+	forceinline T& First() const {INTRA_DEBUG_ASSERT(!Empty()); return *mFirst;}
+	forceinline void PopFirst() {INTRA_DEBUG_ASSERT(!Empty()); mCtrl++; mFirst++; skipEmpty();}
+
+	forceinline operator FlatHashTableRange<const T>() const
+	{return FlatHashTableRange<const T>(mCtrl, mFirst, mEnd);}
+
+private:
+	forceinline void skipEmpty()
+	{
+		while(mFirst != mEnd && *mCtrl == D::FlatHashEmpty) mCtrl++, mFirst++;
+	}
+
+	const byte* mCtrl;
+	T* mFirst;
+	T* mEnd;
+};
+
+//! Хеш-таблица с открытой адресацией, хранящая пары непрерывно в одном массиве.
+//! Рядом с массивом пар хранится массив байт метаданных: 7 бит хеша ключа для занятых ячеек или признак пустой ячейки.
+//! Поиск сравнивает сразу группу байт метаданных (16 байт с SSE2, иначе 8) и сравнивает ключи только у совпавших ячеек.
+//! Используется линейное пробирование, а удаление сдвигает следующие элементы назад,
+//! поэтому удалённые элементы не оставляют меток и не замедляют поиск.
+//! В отличие от HashMap, не выделяет память на каждый элемент, но не сохраняет порядок вставки,
+//! а вставка и удаление делают недействительными все ссылки на элементы и диапазоны.
+template<typename K, typename V, typename AllocatorType = Memory::GlobalHeapType>
+class FlatHashMap: Memory::AllocatorRef<AllocatorType>
+{
+	typedef Memory::AllocatorRef<AllocatorType> AllocatorRef;
+	typedef D::FlatHashGroup Group;
+public:
+	typedef AllocatorType Allocator;
+
+	typedef K key_type;
+	typedef V mapped_type;
+	typedef KeyValuePair<const K, V> value_type;
+	typedef FlatHashTableRange<value_type> ElementRange;
+	typedef FlatHashTableRange<const value_type> ElementConstRange;
+
+	struct iterator
+	{
+		forceinline iterator(const ElementRange& r=null): range(r) {}
+
+		forceinline bool operator==(const iterator& rhs) const {return range == rhs.range;}
+		forceinline bool operator!=(const iterator& rhs) const {return range != rhs.range;}
+
+		forceinline iterator& operator++() {range.PopFirst(); return *this;}
+		forceinline iterator operator++(int) {iterator it = *this; range.PopFirst(); return it;}
+
+		forceinline value_type* operator->() const {return &range.First();}
+		forceinline value_type& operator*() const {return range.First();}
+
+		ElementRange range;
+	};
+
+	struct const_iterator
+	{
+		forceinline const_iterator(const ElementConstRange& r=null): range(r) {}
+		forceinline const_iterator(const iterator& rhs): range(rhs.range) {}
+
+		forceinline bool operator==(const const_iterator& rhs) const {return range == rhs.range;}
+		forceinline bool operator!=(const const_iterator& rhs) const {return range != rhs.range;}
+
+		forceinline const_iterator& operator++() {range.PopFirst(); return *this;}
+		forceinline const_iterator operator++(int) {const_iterator it = *this; range.PopFirst(); return it;}
+
+		forceinline const value_type* operator->() const {return &range.First();}
+		forceinline const value_type& operator*() const {return range.First();}
+
+		ElementConstRange range;
+	};
+
+
+	FlatHashMap(null_t=null): mSlots(null), mCtrl(null), mCount(0), mCapacity(0), mShift(0) {}
+
+	FlatHashMap(Allocator& allocator): AllocatorRef(allocator),
+		mSlots(null), mCtrl(null), mCount(0), mCapacity(0), mShift(0) {}
+
+	FlatHashMap(const FlatHashMap& rhs): AllocatorRef(rhs),
+		mSlots(null), mCtrl(null), mCount(0), mCapacity(0), mShift(0) {operator=(rhs);}
+
+	FlatHashMap(FlatHashMap&& rhs): AllocatorRef(rhs),
+		mSlots(rhs.mSlots), mCtrl(rhs.mCtrl), mCount(rhs.mCount), mCapacity(rhs.mCapacity), mShift(rhs.mShift)
+	{
+		rhs.mSlots = null;
+		rhs.mCtrl = null;
+		rhs.mCount = rhs.mCapacity = 0;
+	}
+
+	~FlatHashMap()
+	{
+		Clear();
+		freeTable(mSlots, mCapacity);
+	}
+
+	FlatHashMap& operator=(const FlatHashMap& rhs)
+	{
+		if(this == &rhs) return *this;
+		Clear();
+		Reserve(rhs.Count());
+		Insert(rhs);
+		return *this;
+	}
+
+	FlatHashMap& operator=(FlatHashMap&& rhs)
+	{
+		if(this == &rhs) return *this;
+		Clear();
+		freeTable(mSlots, mCapacity);
+		AllocatorRef::operator=(rhs);
+		mSlots = rhs.mSlots;
+		mCtrl = rhs.mCtrl;
+		mCount = rhs.mCount;
+		mCapacity = rhs.mCapacity;
+		mShift = rhs.mShift;
+		rhs.mSlots = null;
+		rhs.mCtrl = null;
+		rhs.mCount = rhs.mCapacity = 0;
+		return *this;
+	}
+
+	FlatHashMap& operator=(null_t)
+	{
+		Clear();
+		return *this;
+	}
+
+	bool operator==(const FlatHashMap& rhs) const
+	{
+		if(rhs.Count() != Count()) return false;
+		for(const value_type& element: *this)
+		{
+			const value_type* const found = rhs.findSlot(element.Key);
+			if(found == null || found->Value != element.Value) return false;
+		}
+		return true;
+	}
+
+	bool operator!=(const FlatHashMap& rhs) const {return !operator==(rhs);}
+
+	forceinline bool Empty() const {return mCount == 0;}
+	forceinline bool operator==(null_t) const {return Empty();}
+	forceinline bool operator!=(null_t) const {return !Empty();}
+
+	V& operator[](const K& key)
+	{
+		bool found;
+		byte h2;
+		value_type* const slot = findOrPrepareSlot(key, found, h2);
+		if(!found) publishSlot(new(slot) value_type(key, V()), h2);
+		return slot->Value;
+	}
+
+	V& operator[](K&& key)
+	{
+		bool found;
+		byte h2;
+		value_type* const slot = findOrPrepareSlot(key, found, h2);
+		if(!found) publishSlot(new(slot) value_type(Cpp::Move(key), V()), h2);
+		return slot->Value;
+	}
+
+	//! Вставить пару или заменить значение, если пара с таким ключом уже существует.
+	//! @return Диапазон, начинающийся с вставленного элемента.
+	ElementRange Insert(const value_type& pair) {return Insert(pair.Key, pair.Value);}
+
+	ElementRange Insert(K&& key, V&& value)
+	{
+		bool found;
+		byte h2;
+		value_type* const slot = findOrPrepareSlot(key, found, h2);
+		if(!found) publishSlot(new(slot) value_type(Cpp::Move(key), Cpp::Move(value)), h2);
+		else slot->Value = Cpp::Move(value);
+		return rangeFrom(slot);
+	}
+
+	ElementRange Insert(const K& key, const V& value)
+	{
+		bool found;
+		byte h2;
+		value_type* const slot = findOrPrepareSlot(key, found, h2);
+		if(!found) publishSlot(new(slot) value_type(key, value), h2);
+		else slot->Value = value;
+		return rangeFrom(slot);
+	}
+
+	void Insert(const FlatHashMap& map)
+	{
+		for(const value_type& element: map) Insert(element.Key, element.Value);
+	}
+
+	//! Вставить пару только в случае если пары с указанным ключом не существует.
+	//! @return Диапазон, начинающийся с найденного или вставленного элемента с указанным ключом.
+	ElementRange InsertNew(const K& key, const V& value)
+	{
+		bool found;
+		byte h2;
+		value_type* const slot = findOrPrepareSlot(key, found, h2);
+		if(!found) publishSlot(new(slot) value_type(key, value), h2);
+		return rangeFrom(slot);
+	}
+
+	ElementRange InsertNew(K&& key, V&& value)
+	{
+		bool found;
+		byte h2;
+		value_type* const slot = findOrPrepareSlot(key, found, h2);
+		if(!found) publishSlot(new(slot) value_type(Cpp::Move(key), Cpp::Move(value)), h2);
+		return rangeFrom(slot);
+	}
+
+	//! Удалить элемент по ключу.
+	//! @return Возвращает, существовал ли элемент с таким ключом.
+	bool Remove(const K& key)
+	{
+		value_type* const slot = findSlot(key);
+		if(slot == null) return false;
+		eraseAt(size_t(slot - mSlots));
+		return true;
+	}
+
+	void Clear()
+	{
+		if(mCapacity == 0) return;
+		for(size_t i = 0; i < mCapacity; i++)
+			if(mCtrl[i] != D::FlatHashEmpty) Memory::DestructObj(mSlots[i]);
+		C::memset(mCtrl, D::FlatHashEmpty, ctrlSize(mCapacity));
+		mCount = 0;
+	}
+
+	//! Выделить память так, чтобы вставка count элементов не приводила к перехешированию.
+	void Reserve(size_t count)
+	{
+		size_t capacity = Group::Width;
+		while(capacity*MaxLoadNum < count*MaxLoadDen) capacity *= 2;
+		if(capacity > mCapacity) rehash(capacity);
+	}
+
+	//! Поиск по ключу.
+	//! \return Диапазон, начинающийся с элемента с ключом key, или пустой диапазон, если такого элемента нет.
+	ElementRange Find(const K& key)
+	{
+		value_type* const slot = findSlot(key);
+		if(slot == null) return null;
+		return rangeFrom(slot);
+	}
+
+	ElementConstRange Find(const K& key) const
+	{return const_cast<FlatHashMap*>(this)->Find(key);}
+
+	V& Get(const K& key, V& defaultValue, bool& oExists)
+	{
+		value_type* const slot = findSlot(key);
+		oExists = slot != null;
+		return slot != null? slot->Value: defaultValue;
+	}
+
+	V& Get(const K& key, V& defaultValue)
+	{
+		bool exists;
+		return Get(key, defaultValue, exists);
+	}
+
+	const V& Get(const K& key, const V& defaultValue, bool& oExists) const
+	{
+		const value_type* const slot = findSlot(key);
+		oExists = slot != null;
+		return slot != null? slot->Value: defaultValue;
+	}
+
+	const V& Get(const K& key, const V& defaultValue) const
+	{
+		bool exists;
+		return Get(key, defaultValue, exists);
+	}
+
+	forceinline bool Contains(const K& key) const {return findSlot(key) != null;}
+
+	forceinline ElementRange AsRange() {return ElementRange(mCtrl, mSlots, mSlots + mCapacity);}
+	forceinline ElementConstRange AsRange() const {return ElementConstRange(mCtrl, mSlots, mSlots + mCapacity);}
+	forceinline ElementConstRange AsConstRange() const {return AsRange();}
+
+	forceinline ElementRange operator()() {return AsRange();}
+
+	forceinline iterator begin() {return iterator(AsRange());}
+	forceinline const_iterator begin() const {return const_iterator(AsRange());}
+	forceinline iterator end() {return iterator(null);}
+	forceinline const_iterator end() const {return const_iterator(null);}
+
+	forceinline iterator emplace(K&& key, V&& value) {return iterator(Insert(Cpp::Move(key), Cpp::Move(value)));}
+	forceinline iterator insert(const value_type& pair) {return iterator(Insert(pair.Key, pair.Value));}
+	forceinline bool empty() const {return Empty();}
+	forceinline size_t size() const {return Count();}
+	forceinline void clear() {Clear();}
+	forceinline void reserve(size_t count) {Reserve(count);}
+	forceinline iterator find(const K& key) {return iterator(Find(key));}
+	forceinline const_iterator find(const K& key) const {return const_iterator(Find(key));}
+
+	forceinline size_t Count() const {return mCount;}
+
+	//! Количество ячеек таблицы.
+	forceinline size_t Capacity() const {return mCapacity;}
+
+private:
+	// Максимальная доля занятых ячеек - 3/4.
+	enum: size_t {MaxLoadNum = 3, MaxLoadDen = 4};
+
+	value_type* mSlots;
+	byte* mCtrl;
+	size_t mCount;
+	size_t mCapacity;
+	uint mShift;
+
+	// Байты метаданных с копией первых Group::Width - 1 байт в конце,
+	// чтобы группу, начинающуюся в конце таблицы, можно было прочитать одной загрузкой.
+	static forceinline size_t ctrlSize(size_t capacity) {return capacity + Group::Width - 1;}
+
+	forceinline ElementRange rangeFrom(value_type* slot)
+	{return ElementRange(mCtrl + (slot - mSlots), slot, mSlots + mCapacity);}
+
+	// Старшие 7 бит перемешанного хеша идут в метаданные, следующие за ними - в индекс начальной ячейки.
+	forceinline ulong64 mixedHash(const K& key) const {return ulong64(ToHash(key))*0x9E3779B97F4A7C15ull;}
+	forceinline size_t homeOf(ulong64 hash) const {return size_t((hash << 7) >> mShift);}
+	static forceinline byte h2Of(ulong64 hash) {return byte(hash >> 57);}
+
+	forceinline void setCtrl(size_t index, byte value)
+	{
+		mCtrl[index] = value;
+		if(index < Group::Width - 1) mCtrl[mCapacity + index] = value;
+	}
+
+	value_type* findSlot(const K& key) const
+	{
+		if(mCount == 0) return null;
+		const size_t mask = mCapacity - 1;
+		const ulong64 hash = mixedHash(key);
+		const byte h2 = h2Of(hash);
+		size_t pos = homeOf(hash);
+		for(;;)
+		{
+			const Group group(mCtrl + pos);
+			for(auto match = group.Match(h2); match != 0; match &= match - 1)
+			{
+				const size_t index = (pos + Group::LowestIndex(match)) & mask;
+				if(mSlots[index].Key == key) return mSlots + index;
+			}
+			if(group.MatchEmpty() != 0) return null;
+			pos = (pos + Group::Width) & mask;
+		}
+	}
+
+	size_t findEmptySlot(size_t pos) const
+	{
+		const size_t mask = mCapacity - 1;
+		for(;;)
+		{
+			const auto empty = Group(mCtrl + pos).MatchEmpty();
+			if(empty != 0) return (pos + Group::LowestIndex(empty)) & mask;
+			pos = (pos + Group::Width) & mask;
+		}
+	}
+
+	// Находит элемент с ключом key или пустую ячейку для него. Ячейка остаётся пустой:
+	// вызывающий код конструирует в ней элемент и только после этого вызывает publishSlot с oH2.
+	value_type* findOrPrepareSlot(const K& key, bool& oFound, byte& oH2)
+	{
+		value_type* const existing = findSlot(key);
+		oFound = existing != null;
+		if(oFound) return existing;
+		if((mCount + 1)*MaxLoadDen > mCapacity*MaxLoadNum)
+			rehash(mCapacity == 0? size_t(Group::Width): mCapacity*2);
+		const ulong64 hash = mixedHash(key);
+		oH2 = h2Of(hash);
+		return mSlots + findEmptySlot(homeOf(hash));
+	}
+
+	forceinline void publishSlot(value_type* slot, byte h2)
+	{
+		setCtrl(size_t(slot - mSlots), h2);
+		mCount++;
+	}
+
+	static forceinline void relocate(value_type& dst, value_type& src)
+	{
+		new(&dst) value_type(Cpp::Move(const_cast<K&>(src.Key)), Cpp::Move(src.Value));
+		Memory::DestructObj(src);
+	}
+
+	// Удаление без меток: следующие элементы кластера сдвигаются на освободившееся место,
+	// если это не переносит их раньше их начальной ячейки.
+	void eraseAt(size_t hole)
+	{
+		const size_t mask = mCapacity - 1;
+		Memory::DestructObj(mSlots[hole]);
+		for(size_t i = (hole + 1) & mask; mCtrl[i] != D::FlatHashEmpty; i = (i + 1) & mask)
+		{
+			const size_t home = homeOf(mixedHash(mSlots[i].Key));
+			if(((i - home) & mask) < ((i - hole) & mask)) continue;
+			relocate(mSlots[hole], mSlots[i]);
+			setCtrl(hole, mCtrl[i]);
+			hole = i;
+		}
+		setCtrl(hole, D::FlatHashEmpty);
+		mCount--;
+	}
+
+	void rehash(size_t newCapacity)
+	{
+		INTRA_DEBUG_ASSERT(Math::IsPow2(newCapacity) && newCapacity >= Group::Width);
+		value_type* const oldSlots = mSlots;
+		byte* const oldCtrl = mCtrl;
+		const size_t oldCapacity = mCapacity;
+
+		size_t bytes = newCapacity*sizeof(value_type) + ctrlSize(newCapacity);
+		mSlots = AllocatorRef::Allocate(bytes, INTRA_SOURCE_INFO);
+		mCtrl = reinterpret_cast<byte*>(mSlots + newCapacity);
+		C::memset(mCtrl, D::FlatHashEmpty, ctrlSize(newCapacity));
+		mCapacity = newCapacity;
+		mShift = 64 - Math::CountTrailingZeros(ulong64(newCapacity));
+
+		for(size_t i = 0; i < oldCapacity; i++)
+		{
+			if(oldCtrl[i] == D::FlatHashEmpty) continue;
+			const ulong64 hash = mixedHash(oldSlots[i].Key);
+			const size_t index = findEmptySlot(homeOf(hash));
+			setCtrl(index, h2Of(hash));
+			relocate(mSlots[index], oldSlots[i]);
+		}
+		freeTable(oldSlots, oldCapacity);
+	}
+
+	void freeTable(value_type* slots, size_t capacity)
+	{
+		if(slots == null) return;
+		AllocatorRef::Free(slots, capacity*sizeof(value_type) + ctrlSize(capacity));
+	}
+};
+
+}
+using Container::FlatHashMap;
+
+}
+
+INTRA_WARNING_POP
@@ -188,6 +188,8 @@ public:
 
 	HashMap(null_t=null): mRange(null), mBucketHeads(null) {}
 
+	HashMap(Allocator& allocator): AllocatorRef(allocator), mRange(null), mBucketHeads(null) {}
+
 	HashMap(const HashMap& rhs): AllocatorRef(rhs),
 		mRange(null), mBucketHeads(null) {operator=(rhs);}
 
@@ -564,7 +564,7 @@ public:
 	void SetCount(size_t newCount, const T& initValue)
 	{
 		const size_t oldCount = setCountNotConstruct(newCount);
-		for(T& dst: Drop(oldCount)) new(dst) T(initValue);
+		for(T& dst: Drop(oldCount)) new(&dst) T(initValue);
 	}
 
 	//! Изменить количество занятых элементов массива без вызова денструтора лишних элементов или инициализации новых.
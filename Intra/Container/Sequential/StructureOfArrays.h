@@ -1,72 +1,294 @@
 ﻿#pragma once
 
-#if INTRA_DISABLED
-
+#include "Cpp/Features.h"
+#include "Cpp/Warnings.h"
+#include "Cpp/PlacementNew.h"
+#include "Meta/Type.h"
 #include "Meta/TypeList.h"
 #include "Meta/Tuple.h"
+#include "Meta/GetField.h"
+#include "Utils/Span.h"
+#include "Utils/Debug.h"
+#include "Memory/Memory.h"
+#include "Memory/Allocator/Global.h"
+#include "Range/Compositors/Zip.h"
+
+namespace Intra { namespace Container {
 
-namespace Intra {
+INTRA_PUSH_DISABLE_REDUNDANT_WARNINGS
 
-template<typename ...T> class StructureOfArrays
+//! Контейнер, хранящий каждое поле своих элементов в отдельном непрерывном массиве - столбце.
+//! Проход, который использует только часть полей, читает из памяти только их столбцы.
+//! Столбцы доступны как Span и передаются в алгоритмы диапазонов и SIMD-функции без копирования.
+//! Все столбцы имеют одинаковую длину Count() и растут вместе.
+template<typename... T> class StructureOfArrays
 {
+	static_assert(sizeof...(T) > 0, "StructureOfArrays must have at least one column.");
+	typedef typename Meta::D::make_indexes<T...>::_ Indices;
 public:
-	typedef Tuple<T...> AoS;
-	typedef Tuple<T*...> SoA;
-	typedef TypeList<T...> TL;
-	enum: uint {ColumnCount = TypeListLength(TL);};
+	typedef Meta::TypeList<T...> TL;
+	enum: size_t {ColumnCount = sizeof...(T)};
+
+	template<size_t I> using ColumnType = Meta::TypeListAt<I, TL>;
+
+	StructureOfArrays(null_t=null): mCount(0), mCapacity(0) {}
+
+	explicit StructureOfArrays(size_t initialCount): mCount(0), mCapacity(0) {SetCount(initialCount);}
+
+	StructureOfArrays(StructureOfArrays&& rhs): mColumns(rhs.mColumns), mCount(rhs.mCount), mCapacity(rhs.mCapacity)
+	{
+		rhs.mColumns = Meta::Tuple<T*...>();
+		rhs.mCount = rhs.mCapacity = 0;
+	}
+
+	StructureOfArrays(const StructureOfArrays& rhs): mCount(0), mCapacity(0) {operator=(rhs);}
+
+	~StructureOfArrays() {operator=(null);}
+
+	StructureOfArrays& operator=(const StructureOfArrays& rhs)
+	{
+		if(this == &rhs) return *this;
+		Clear();
+		Reserve(rhs.mCount);
+		copyInit(Indices(), rhs);
+		mCount = rhs.mCount;
+		return *this;
+	}
+
+	StructureOfArrays& operator=(StructureOfArrays&& rhs)
+	{
+		if(this == &rhs) return *this;
+		operator=(null);
+		mColumns = rhs.mColumns;
+		mCount = rhs.mCount;
+		mCapacity = rhs.mCapacity;
+		rhs.mColumns = Meta::Tuple<T*...>();
+		rhs.mCount = rhs.mCapacity = 0;
+		return *this;
+	}
+
+	//! Удалить все элементы и освободить память.
+	StructureOfArrays& operator=(null_t)
+	{
+		Clear();
+		freeColumns(Indices());
+		mColumns = Meta::Tuple<T*...>();
+		mCapacity = 0;
+		return *this;
+	}
+
+
+	//! Столбец с индексом I длиной Count().
+	template<size_t I> forceinline Span<ColumnType<I>> Column()
+	{return {Meta::Get<I>(mColumns), mCount};}
+
+	template<size_t I> forceinline CSpan<ColumnType<I>> Column() const
+	{return {Meta::Get<I>(mColumns), mCount};}
+
+	//! Диапазон кортежей ссылок на поля элементов из выбранных столбцов.
+	//! Для одного столбца используйте Column.
+	template<size_t... I> forceinline Range::RZip<Span<ColumnType<I>>...> Columns()
+	{
+		static_assert(sizeof...(I) >= 2, "Use Column to access a single column.");
+		return Range::RZip<Span<ColumnType<I>>...>(Column<I>()...);
+	}
+
+	template<size_t... I> forceinline Range::RZip<CSpan<ColumnType<I>>...> Columns() const
+	{
+		static_assert(sizeof...(I) >= 2, "Use Column to access a single column.");
+		return Range::RZip<CSpan<ColumnType<I>>...>(Column<I>()...);
+	}
+
+	//! Поле с индексом I элемента с индексом index.
+	template<size_t I> forceinline ColumnType<I>& Get(size_t index)
+	{
+		INTRA_DEBUG_ASSERT(index < mCount);
+		return Meta::Get<I>(mColumns)[index];
+	}
+
+	template<size_t I> forceinline const ColumnType<I>& Get(size_t index) const
+	{
+		INTRA_DEBUG_ASSERT(index < mCount);
+		return Meta::Get<I>(mColumns)[index];
+	}
+
+
+	//! Добавить в конец элемент, поля которого копируются или перемещаются из values.
+	//! @return Индекс добавленного элемента.
+	forceinline size_t AddLast(const T&... values)
+	{
+		if(mCount == mCapacity) CheckSpace(1);
+		emplaceLast(Indices(), values...);
+		return mCount++;
+	}
+
+	forceinline size_t AddLast(T&&... values)
+	{
+		if(mCount == mCapacity) CheckSpace(1);
+		emplaceLast(Indices(), Cpp::Move(values)...);
+		return mCount++;
+	}
+
+	//! Добавить в конец элемент со значениями полей по умолчанию.
+	//! @return Индекс добавленного элемента.
+	forceinline size_t EmplaceLast()
+	{
+		if(mCount == mCapacity) CheckSpace(1);
+		emplaceLast(Indices());
+		return mCount++;
+	}
+
+	//! Удалить последний элемент.
+	forceinline void RemoveLast()
+	{
+		INTRA_DEBUG_ASSERT(!Empty());
+		mCount--;
+		destruct(Indices(), mCount, mCount+1);
+	}
+
+	//! Удалить элемент с индексом index, сохраняя порядок остальных элементов.
+	//! Все последующие элементы сдвигаются на одну позицию влево.
+	void Remove(size_t index)
+	{
+		INTRA_DEBUG_ASSERT(index < mCount);
+		removeShift(Indices(), index);
+		mCount--;
+	}
 
-	void AddLast()
+	//! Удалить элемент с индексом index, переместив на его место последний элемент.
+	//! Работает за O(1), но меняет порядок элементов.
+	void RemoveUnordered(size_t index)
 	{
-		CheckSpace(1);
-		add<0>();
+		INTRA_DEBUG_ASSERT(index < mCount);
+		if(index + 1 != mCount) moveLastTo(Indices(), index);
+		RemoveLast();
 	}
 
-	void CheckSpace(size_t space) {Reserve(count+space);}
+	//! Удалить все элементы без освобождения памяти.
+	forceinline void Clear()
+	{
+		destruct(Indices(), 0, mCount);
+		mCount = 0;
+	}
+
+	//! Изменить количество элементов.
+	//! Новые элементы инициализируются конструктором по умолчанию.
+	void SetCount(size_t newCount)
+	{
+		if(newCount <= mCount)
+		{
+			destruct(Indices(), newCount, mCount);
+			mCount = newCount;
+			return;
+		}
+		Reserve(newCount);
+		initialize(Indices(), mCount, newCount);
+		mCount = newCount;
+	}
 
+	//! Выделить память как минимум для capacityToReserve элементов во всех столбцах.
 	void Reserve(size_t capacityToReserve)
 	{
-		if(capacityToReserve>size)
-			Resize(Math::max(capacityToReserve, size+size/2));
+		if(capacityToReserve <= mCapacity) return;
+		reallocate(Indices(), capacityToReserve);
+		mCapacity = capacityToReserve;
 	}
 
-	void Resize(size_t size);
+	//! Обеспечить место для space новых элементов с геометрическим ростом ёмкости.
+	forceinline void CheckSpace(size_t space)
+	{
+		const size_t required = mCount + space;
+		if(required <= mCapacity) return;
+		const size_t grown = mCapacity + mCapacity/2;
+		Reserve(required > grown? required: grown);
+	}
 
-	void SetCount(size_t newCount);
+	forceinline size_t Count() const {return mCount;}
+	forceinline size_t Length() const {return mCount;}
+	forceinline size_t Capacity() const {return mCapacity;}
+	forceinline bool Empty() const {return mCount == 0;}
 
-	size_t Count() const {return count;}
-	size_t Size() const {return size;}
+	forceinline bool operator==(null_t) const {return Empty();}
+	forceinline bool operator!=(null_t) const {return !Empty();}
 
 private:
-	SoA data;
-	size_t count, size;
+	Meta::Tuple<T*...> mColumns;
+	size_t mCount, mCapacity;
 
-	template<uint I> void add()
+	template<int... I> forceinline void emplaceLast(Meta::D::index_tuple<I...>)
 	{
-		new(data.Get<I>()) TypeListTypeAt<I, TL>;
-		add<I+1>();
+		const int expand[] = {(new(Meta::Get<I>(mColumns) + mCount) ColumnType<size_t(I)>(), 0)...};
+		(void)expand;
 	}
 
-	template<> void add() {}
+	template<int... I, typename... Args> forceinline void emplaceLast(Meta::D::index_tuple<I...>, Args&&... args)
+	{
+		const int expand[] = {(new(Meta::Get<I>(mColumns) + mCount) ColumnType<size_t(I)>(Cpp::Forward<Args>(args)), 0)...};
+		(void)expand;
+	}
 
+	template<int... I> void initialize(Meta::D::index_tuple<I...>, size_t from, size_t to)
+	{
+		const int expand[] = {(Memory::Initialize(Span<ColumnType<size_t(I)>>(Meta::Get<I>(mColumns) + from, to - from)), 0)...};
+		(void)expand;
+	}
+
+	template<int... I> void destruct(Meta::D::index_tuple<I...>, size_t from, size_t to)
+	{
+		const int expand[] = {(Memory::Destruct(Span<ColumnType<size_t(I)>>(Meta::Get<I>(mColumns) + from, to - from)), 0)...};
+		(void)expand;
+	}
 
-	template<uint I> void add(const AoS& aos)
+	template<int... I> void copyInit(Meta::D::index_tuple<I...>, const StructureOfArrays& rhs)
 	{
-		new(data.Get<I>()) TypeListTypeAt<I, TL>(aos.Get<I>());
-		add<I+1>(aos);
+		const int expand[] = {(Memory::CopyInit(Span<ColumnType<size_t(I)>>(Meta::Get<I>(mColumns), rhs.mCount),
+			CSpan<ColumnType<size_t(I)>>(rhs.Column<size_t(I)>())), 0)...};
+		(void)expand;
 	}
 
-	template<> void add(const AoS& aos) {}
+	template<int... I> void removeShift(Meta::D::index_tuple<I...>, size_t index)
+	{
+		const int expand[] = {(removeShiftColumn(Meta::Get<I>(mColumns), index), 0)...};
+		(void)expand;
+	}
 
+	template<typename C> void removeShiftColumn(C* column, size_t index)
+	{
+		column[index].~C();
+		Memory::MoveInitDelete<C>({column + index, column + mCount - 1}, {column + index + 1, column + mCount});
+	}
 
-	template<uint I> void add(AoS&& aos)
+	template<int... I> void moveLastTo(Meta::D::index_tuple<I...>, size_t index)
 	{
-		new(data.Get<I>()) TypeListTypeAt<I, TL>(std::move(aos.Get<I>()));
-		add<I+1>(std::move(aos));
+		const int expand[] = {(Meta::Get<I>(mColumns)[index] = Cpp::Move(Meta::Get<I>(mColumns)[mCount - 1]), 0)...};
+		(void)expand;
 	}
 
-	template<> void add(AoS&& aos) {}
+	template<int... I> void reallocate(Meta::D::index_tuple<I...>, size_t newCapacity)
+	{
+		const int expand[] = {(reallocateColumn(Meta::Get<I>(mColumns), newCapacity), 0)...};
+		(void)expand;
+	}
+
+	template<typename C> void reallocateColumn(C*& column, size_t newCapacity)
+	{
+		Span<C> newColumn = Memory::AllocateRangeUninitialized<C>(Memory::GlobalHeap, newCapacity, INTRA_SOURCE_INFO);
+		Memory::MoveInitDelete<C>(newColumn.Take(mCount), {column, mCount});
+		Memory::FreeRangeUninitialized(Memory::GlobalHeap, Span<C>(column, mCapacity));
+		column = newColumn.Begin;
+	}
+
+	template<int... I> void freeColumns(Meta::D::index_tuple<I...>)
+	{
+		const int expand[] = {(Memory::FreeRangeUninitialized(Memory::GlobalHeap,
+			Span<ColumnType<size_t(I)>>(Meta::Get<I>(mColumns), mCapacity)), 0)...};
+		(void)expand;
+	}
 };
 
+INTRA_WARNING_POP
+
 }
+using Container::StructureOfArrays;
 
-#endif
+}
@@ -4,5 +4,6 @@
 #include "Data/Variable.h"
 #include "Data/ValueType.h"
 #include "Data/Object.h"
+#include "Data/Compression/Inflate.h"
 
 #include "Data/Serialization.hh"
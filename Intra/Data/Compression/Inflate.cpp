@@ -0,0 +1,397 @@
+﻿#include "Data/Compression/Inflate.h"
+
+#include "Cpp/Warnings.h"
+#include "Cpp/Intrinsics.h"
+#include "Cpp/PlatformDetect.h"
+
+INTRA_PUSH_DISABLE_REDUNDANT_WARNINGS
+
+namespace Intra { namespace Data {
+
+namespace {
+
+enum: uint {InflateFastBits = 10, InflateFastMask = (1u << InflateFastBits) - 1};
+
+//! Канонический код Хаффмана.
+//! Fast по младшим InflateFastBits битам входа даёт (символ << 4) | длина кода или 0, если код длиннее.
+//! Более длинные коды ищутся сравнением развёрнутых 16 бит входа с MaxCode каждой длины.
+struct InflateHuffman
+{
+	ushort Fast[1u << InflateFastBits];
+	ushort FirstCode[16];
+	ushort FirstSymbol[16];
+	uint MaxCode[17];
+	ushort Symbols[288];
+};
+
+forceinline uint inflateReverseBits(uint code, uint bitCount)
+{
+	code = ((code & 0xAAAA) >> 1) | ((code & 0x5555) << 1);
+	code = ((code & 0xCCCC) >> 2) | ((code & 0x3333) << 2);
+	code = ((code & 0xF0F0) >> 4) | ((code & 0x0F0F) << 4);
+	code = ((code & 0xFF00) >> 8) | ((code & 0x00FF) << 8);
+	return code >> (16 - bitCount);
+}
+
+bool inflateBuildHuffman(InflateHuffman& h, const byte* lengths, uint count)
+{
+	uint lengthCounts[17] = {};
+	for(uint i = 0; i < count; i++) lengthCounts[lengths[i]]++;
+	lengthCounts[0] = 0;
+	C::memset(h.Fast, 0, sizeof(h.Fast));
+
+	uint nextCode[16];
+	uint code = 0, symbol = 0;
+	for(uint len = 1; len < 16; len++)
+	{
+		nextCode[len] = code;
+		h.FirstCode[len] = ushort(code);
+		h.FirstSymbol[len] = ushort(symbol);
+		code += lengthCounts[len];
+		// неполный код допустим, переполненный - нет
+		if(lengthCounts[len] != 0 && code > (1u << len)) return false;
+		h.MaxCode[len] = code << (16 - len);
+		code <<= 1;
+		symbol += lengthCounts[len];
+	}
+	h.MaxCode[16] = 0x10000;
+
+	for(uint i = 0; i < count; i++)
+	{
+		const uint len = lengths[i];
+		if(len == 0) continue;
+		const uint index = nextCode[len] - h.FirstCode[len] + h.FirstSymbol[len];
+		h.Symbols[index] = ushort(i);
+		if(len <= InflateFastBits)
+		{
+			const ushort entry = ushort((i << 4) | len);
+			for(uint j = inflateReverseBits(nextCode[len], len); j < (1u << InflateFastBits); j += 1u << len)
+				h.Fast[j] = entry;
+		}
+		nextCode[len]++;
+	}
+	return true;
+}
+
+//! Битовый поток DEFLATE с 64-битным буфером, который пополняется по 8 байт.
+//! За концом входа подставляются нули, а Overrun проверяет, были ли они прочитаны.
+class InflateBitReader
+{
+public:
+	InflateBitReader(CSpan<byte> src): mPos(src.Begin), mEnd(src.End), mBits(0), mBitCount(0), mPaddingBytes(0) {}
+
+	//! Гарантирует не менее 56 бит в буфере.
+	forceinline void Refill()
+	{
+		if(mEnd - mPos >= 8)
+		{
+			ulong64 v;
+			C::memcpy(&v, mPos, 8);
+#if(INTRA_PLATFORM_ENDIANESS == INTRA_PLATFORM_ENDIANESS_BigEndian)
+			v = __builtin_bswap64(v);
+#endif
+			mBits |= v << mBitCount;
+			mPos += (63 - mBitCount) >> 3;
+			mBitCount |= 56;
+			return;
+		}
+		while(mBitCount <= 56)
+		{
+			if(mPos != mEnd) mBits |= ulong64(*mPos++) << mBitCount;
+			else mPaddingBytes++;
+			mBitCount += 8;
+		}
+	}
+
+	forceinline uint Peek(uint bitCount) const {return uint(mBits & ((ulong64(1) << bitCount) - 1));}
+	forceinline void Consume(uint bitCount) {mBits >>= bitCount; mBitCount -= bitCount;}
+
+	forceinline uint Get(uint bitCount)
+	{
+		const uint result = Peek(bitCount);
+		Consume(bitCount);
+		return result;
+	}
+
+	//! Декодирует символ кода h. Требует не менее 15 бит в буфере.
+	forceinline uint Decode(const InflateHuffman& h)
+	{
+		const uint entry = h.Fast[mBits & InflateFastMask];
+		if(entry != 0)
+		{
+			Consume(entry & 15);
+			return entry >> 4;
+		}
+		const uint reversed = inflateReverseBits(uint(mBits & 0xFFFF), 16);
+		uint len = InflateFastBits + 1;
+		while(reversed >= h.MaxCode[len]) len++;
+		if(len == 16) return 0xFFFF;
+		Consume(len);
+		const uint index = (reversed >> (16 - len)) - h.FirstCode[len] + h.FirstSymbol[len];
+		return index < 288? h.Symbols[index]: 0xFFFF;
+	}
+
+	void AlignToByte() {Consume(mBitCount & 7);}
+
+	//! Копирует count байт выровненного потока в dst.
+	bool CopyBytes(byte* dst, size_t count)
+	{
+		while(count != 0 && mBitCount >= 8)
+		{
+			*dst++ = byte(Get(8));
+			count--;
+		}
+		if(count == 0) return true;
+		if(size_t(mEnd - mPos) < count) return false;
+		C::memcpy(dst, mPos, count);
+		mPos += count;
+		// в буфере остались байты, пропущенные копированием
+		mBits = 0;
+		return true;
+	}
+
+	//! Были ли прочитаны нули, подставленные за концом входа.
+	bool Overrun() const {return mBitCount < mPaddingBytes*8;}
+
+	//! Позиция первого непрочитанного байта выровненного потока.
+	const byte* BytePosition() const {return mPos - (mBitCount >> 3) + mPaddingBytes;}
+
+private:
+	const byte* mPos;
+	const byte* mEnd;
+	ulong64 mBits;
+	uint mBitCount;
+	uint mPaddingBytes;
+};
+
+const ushort inflateLengthBase[29] = {
+	3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+	35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+const byte inflateLengthExtra[29] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+const ushort inflateDistanceBase[30] = {
+	1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+	257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+const byte inflateDistanceExtra[30] = {
+	0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+struct InflateFixedCodes
+{
+	InflateHuffman LitLen, Distance;
+
+	InflateFixedCodes()
+	{
+		byte lengths[288];
+		C::memset(lengths, 8, 144);
+		C::memset(lengths + 144, 9, 112);
+		C::memset(lengths + 256, 7, 24);
+		C::memset(lengths + 280, 8, 8);
+		inflateBuildHuffman(LitLen, lengths, 288);
+		C::memset(lengths, 5, 30);
+		inflateBuildHuffman(Distance, lengths, 30);
+	}
+};
+
+bool inflateReadDynamicCodes(InflateBitReader& in, InflateHuffman& litLen, InflateHuffman& distance)
+{
+	static const byte codeLengthOrder[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+	in.Refill();
+	const uint litLenCount = in.Get(5) + 257;
+	const uint distanceCount = in.Get(5) + 1;
+	const uint codeLengthCount = in.Get(4) + 4;
+	if(litLenCount > 286 || distanceCount > 30) return false;
+
+	byte codeLengthLengths[19] = {};
+	in.Refill();
+	for(uint i = 0; i < codeLengthCount; i++)
+		codeLengthLengths[codeLengthOrder[i]] = byte(in.Get(3));
+	InflateHuffman codeLengthCode;
+	if(!inflateBuildHuffman(codeLengthCode, codeLengthLengths, 19)) return false;
+
+	byte lengths[286 + 30];
+	const uint total = litLenCount + distanceCount;
+	for(uint n = 0; n < total;)
+	{
+		in.Refill();
+		const uint symbol = in.Decode(codeLengthCode);
+		if(symbol < 16)
+		{
+			lengths[n++] = byte(symbol);
+			continue;
+		}
+		byte value = 0;
+		uint repeat;
+		if(symbol == 16)
+		{
+			if(n == 0) return false;
+			value = lengths[n - 1];
+			repeat = 3 + in.Get(2);
+		}
+		else if(symbol == 17) repeat = 3 + in.Get(3);
+		else if(symbol == 18) repeat = 11 + in.Get(7);
+		else return false;
+		if(total - n < repeat) return false;
+		C::memset(lengths + n, value, repeat);
+		n += repeat;
+	}
+	if(lengths[256] == 0) return false;
+	return inflateBuildHuffman(litLen, lengths, litLenCount) &&
+		inflateBuildHuffman(distance, lengths + litLenCount, distanceCount);
+}
+
+//! Копирование совпадения, которое может перекрываться со своим источником.
+forceinline void inflateCopyMatch(byte* out, size_t distance, size_t length, const byte* dstEnd)
+{
+	const byte* src = out - distance;
+	if(distance >= 8 && size_t(dstEnd - out) >= length + 8)
+	{
+		// каждые 8 байт источника уже записаны, так что хвост последнего блока можно перезаписать
+		for(size_t i = 0; i < length; i += 8)
+		{
+			ulong64 v;
+			C::memcpy(&v, src + i, 8);
+			C::memcpy(out + i, &v, 8);
+		}
+		return;
+	}
+	if(distance == 1)
+	{
+		C::memset(out, *src, length);
+		return;
+	}
+	for(size_t i = 0; i < length; i++) out[i] = src[i];
+}
+
+bool inflateBlock(InflateBitReader& in, const InflateHuffman& litLen, const InflateHuffman& distance,
+	byte* dstBegin, byte*& out, byte* dstEnd)
+{
+	for(;;)
+	{
+		// 56 бит хватает на символ длины с доп. битами и символ расстояния с доп. битами
+		in.Refill();
+		uint symbol = in.Decode(litLen);
+		if(symbol < 256)
+		{
+			if(out == dstEnd) return false;
+			*out++ = byte(symbol);
+			// второй литерал без пополнения буфера
+			const uint entry = litLen.Fast[in.Peek(InflateFastBits)];
+			if(entry != 0 && (entry >> 4) < 256 && out != dstEnd)
+			{
+				in.Consume(entry & 15);
+				*out++ = byte(entry >> 4);
+			}
+			continue;
+		}
+		if(symbol == 256) return true;
+		symbol -= 257;
+		if(symbol >= 29) return false;
+		const size_t length = inflateLengthBase[symbol] + in.Get(inflateLengthExtra[symbol]);
+		const uint distanceSymbol = in.Decode(distance);
+		if(distanceSymbol >= 30) return false;
+		const size_t dist = inflateDistanceBase[distanceSymbol] + in.Get(inflateDistanceExtra[distanceSymbol]);
+		if(dist > size_t(out - dstBegin) || length > size_t(dstEnd - out)) return false;
+		inflateCopyMatch(out, dist, length, dstEnd);
+		out += length;
+	}
+}
+
+size_t inflateStream(InflateBitReader& in, Span<byte> dst)
+{
+	static const InflateFixedCodes fixedCodes;
+	InflateHuffman dynamicLitLen, dynamicDistance;
+	byte* const dstBegin = dst.Begin;
+	byte* const dstEnd = dst.End;
+	byte* out = dstBegin;
+	bool final;
+	do
+	{
+		in.Refill();
+		final = in.Get(1) != 0;
+		const uint type = in.Get(2);
+		if(type == 0)
+		{
+			in.AlignToByte();
+			const uint len = in.Get(16);
+			const uint nlen = in.Get(16);
+			if((len ^ 0xFFFF) != nlen || len > size_t(dstEnd - out)) return InflateError;
+			if(!in.CopyBytes(out, len)) return InflateError;
+			out += len;
+		}
+		else if(type == 1)
+		{
+			if(!inflateBlock(in, fixedCodes.LitLen, fixedCodes.Distance, dstBegin, out, dstEnd)) return InflateError;
+		}
+		else if(type == 2)
+		{
+			if(!inflateReadDynamicCodes(in, dynamicLitLen, dynamicDistance)) return InflateError;
+			if(!inflateBlock(in, dynamicLitLen, dynamicDistance, dstBegin, out, dstEnd)) return InflateError;
+		}
+		else return InflateError;
+		if(in.Overrun()) return InflateError;
+	} while(!final);
+	return size_t(out - dstBegin);
+}
+
+}
+
+size_t Inflate(CSpan<byte> src, Span<byte> dst)
+{
+	InflateBitReader in(src);
+	return inflateStream(in, dst);
+}
+
+size_t InflateZlib(CSpan<byte> src, Span<byte> dst)
+{
+	if(src.Length() < 6) return InflateError;
+	const uint cmf = src.Begin[0], flg = src.Begin[1];
+	// метод 8 (DEFLATE), окно не больше 32 КБ, без предустановленного словаря
+	if((cmf & 15) != 8 || (cmf >> 4) > 7 || (flg & 32) != 0 || (cmf*256 + flg) % 31 != 0) return InflateError;
+	InflateBitReader in(CSpan<byte>(src.Begin + 2, src.End));
+	const size_t size = inflateStream(in, dst);
+	if(size == InflateError) return InflateError;
+	in.AlignToByte();
+	const byte* checksum = in.BytePosition();
+	if(src.End - checksum < 4) return InflateError;
+	const uint expected = uint(checksum[0]) << 24 | uint(checksum[1]) << 16 | uint(checksum[2]) << 8 | checksum[3];
+	if(Adler32(CSpan<byte>(dst.Begin, size)) != expected) return InflateError;
+	return size;
+}
+
+uint Adler32(CSpan<byte> data, uint adler)
+{
+	// 5552 - наибольшее число байт, сумма которых ещё не переполняет 32 бита
+	enum: size_t {BlockSize = 5552};
+	uint a = adler & 0xFFFF, b = adler >> 16;
+	const byte* p = data.Begin;
+	size_t n = data.Length();
+	while(n != 0)
+	{
+		const size_t blockLen = n < BlockSize? n: BlockSize;
+		n -= blockLen;
+		const byte* const blockEnd = p + blockLen;
+		for(; p + 4 <= blockEnd; p += 4)
+		{
+			a += p[0]; b += a;
+			a += p[1]; b += a;
+			a += p[2]; b += a;
+			a += p[3]; b += a;
+		}
+		for(; p != blockEnd; p++)
+		{
+			a += *p;
+			b += a;
+		}
+		a %= 65521;
+		b %= 65521;
+	}
+	return b << 16 | a;
+}
+
+}}
+
+INTRA_WARNING_POP
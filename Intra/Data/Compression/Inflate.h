@@ -0,0 +1,29 @@
+﻿#pragma once
+
+#include "Cpp/Warnings.h"
+#include "Cpp/Fundamental.h"
+
+#include "Utils/Span.h"
+
+namespace Intra { namespace Data {
+
+INTRA_PUSH_DISABLE_REDUNDANT_WARNINGS
+
+//! Значение, возвращаемое функциями распаковки при ошибке.
+enum: size_t {InflateError = ~size_t(0)};
+
+//! Распаковать данные формата DEFLATE (RFC 1951) из src в dst.
+//! Коды Хаффмана длиной до 10 бит декодируются одним обращением к таблице, более длинные - по каноническим диапазонам кодов.
+//! @return Количество байт, записанных в dst, или InflateError, если данные повреждены или не помещаются в dst.
+size_t Inflate(CSpan<byte> src, Span<byte> dst);
+
+//! Распаковать поток zlib (RFC 1950): проверяет заголовок и контрольную сумму Adler-32 распакованных данных.
+//! @return Количество байт, записанных в dst, или InflateError.
+size_t InflateZlib(CSpan<byte> src, Span<byte> dst);
+
+//! Контрольная сумма Adler-32, продолжающая сумму adler предыдущих данных.
+uint Adler32(CSpan<byte> data, uint adler = 1);
+
+INTRA_WARNING_POP
+
+}}
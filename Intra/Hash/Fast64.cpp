@@ -0,0 +1,216 @@
+﻿#include "Fast64.h"
+#include "Cpp/Endianess.h"
+#include "Cpp/Intrinsics.h"
+#include "Simd/Simd.h"
+
+#if(INTRA_PLATFORM_ENDIANESS != INTRA_PLATFORM_ENDIANESS_LittleEndian)
+#error "Fast64 hash support only little endian!"
+#endif
+
+#if(defined(_MSC_VER) && INTRA_PLATFORM_ARCH == INTRA_PLATFORM_X86_64)
+#include <intrin.h>
+#pragma intrinsic(_umul128)
+#endif
+
+INTRA_PUSH_DISABLE_REDUNDANT_WARNINGS
+
+namespace Intra { namespace Hash {
+
+namespace {
+
+enum: ulong64
+{
+	fast64P0 = 0xa0761d6478bd642fULL, fast64P1 = 0xe7037ed1a0b428dbULL, fast64P2 = 0x8ebc6af09c88c6e3ULL
+};
+
+enum: uint {fast64ScramblePrime = 0x9E3779B1u, fast64StripesPerScramble = 16};
+
+//! Секрет для 8 аккумуляторов длинного пути. Должен совпадать с HashCT::D::fast64Key.
+static const ulong64 fast64Key[8] = {
+	0xbe4ba423396cfeb8ULL, 0x1cad21f72c81017cULL, 0xdb979083e96dd4deULL, 0x1f67b3b7a4a44072ULL,
+	0x78e5c0cc4ee679cbULL, 0x2172ffcc7dd05a82ULL, 0x8e2443f7744608b8ULL, 0x4c263a81e69035e0ULL
+};
+
+#if defined(__SIZEOF_INT128__)
+//! __extension__ убирает предупреждение -Wpedantic о нестандартном типе.
+__extension__ typedef unsigned __int128 fast64U128;
+#endif
+
+forceinline void fast64Mum(ulong64& a, ulong64& b)
+{
+#if defined(__SIZEOF_INT128__)
+	const fast64U128 r = static_cast<fast64U128>(a)*b;
+	a = ulong64(r);
+	b = ulong64(r >> 64);
+#elif(defined(_MSC_VER) && INTRA_PLATFORM_ARCH == INTRA_PLATFORM_X86_64)
+	a = _umul128(a, b, &b);
+#else
+	const ulong64 ha = a >> 32, hb = b >> 32, la = uint(a), lb = uint(b);
+	const ulong64 cross = ((la*lb) >> 32) + uint(ha*lb) + la*hb;
+	const ulong64 lo = a*b;
+	b = ha*hb + ((ha*lb) >> 32) + (cross >> 32);
+	a = lo;
+#endif
+}
+
+forceinline ulong64 fast64Mix(ulong64 a, ulong64 b)
+{
+	fast64Mum(a, b);
+	return a ^ b;
+}
+
+forceinline ulong64 fast64Read8(const byte* p)
+{
+	ulong64 result;
+	C::memcpy(&result, p, sizeof(result));
+	return result;
+}
+
+forceinline ulong64 fast64Read4(const byte* p)
+{
+	uint result;
+	C::memcpy(&result, p, sizeof(result));
+	return result;
+}
+
+forceinline ulong64 fast64Read3(const byte* p, size_t k)
+{return (ulong64(p[0]) << 16) | (ulong64(p[k >> 1]) << 8) | p[k - 1];}
+
+#if(INTRA_SIMD_SUPPORT >= INTRA_SIMD_SSE2 && INTRA_SIMD_SUPPORT <= INTRA_SIMD_AVX2)
+
+//! acc[i^1] += d[i], acc[i] += lo32(d[i]^key[i])*hi32(d[i]^key[i]) для двух пар аккумуляторов за раз.
+forceinline void fast64AccumulateStripe(__m128i acc[4], const byte* p)
+{
+	for(int i = 0; i < 4; i++)
+	{
+		const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p) + i);
+		const __m128i dk = _mm_xor_si128(d, _mm_loadu_si128(reinterpret_cast<const __m128i*>(fast64Key) + i));
+		const __m128i product = _mm_mul_epu32(dk, _mm_srli_epi64(dk, 32));
+		const __m128i swapped = _mm_shuffle_epi32(d, _MM_SHUFFLE(1, 0, 3, 2));
+		acc[i] = _mm_add_epi64(acc[i], _mm_add_epi64(product, swapped));
+	}
+}
+
+forceinline void fast64Scramble(__m128i acc[4])
+{
+	const __m128i prime = _mm_set1_epi32(int(fast64ScramblePrime));
+	for(int i = 0; i < 4; i++)
+	{
+		__m128i x = _mm_xor_si128(acc[i], _mm_srli_epi64(acc[i], 47));
+		x = _mm_xor_si128(x, _mm_set_epi64x(long64(fast64Key[(2*i + 2) & 7]), long64(fast64Key[(2*i + 1) & 7])));
+		const __m128i lo = _mm_mul_epu32(x, prime);
+		const __m128i hi = _mm_mul_epu32(_mm_srli_epi64(x, 32), prime);
+		acc[i] = _mm_add_epi64(lo, _mm_slli_epi64(hi, 32));
+	}
+}
+
+void fast64Accumulate(ulong64 accumulators[8], const byte* p, size_t len)
+{
+	__m128i acc[4];
+	for(int i = 0; i < 4; i++) acc[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(accumulators) + i);
+	const size_t stripeCount = (len - 1)/64;
+	for(size_t s = 0; s < stripeCount; s++)
+	{
+		fast64AccumulateStripe(acc, p + s*64);
+		if(s % fast64StripesPerScramble == fast64StripesPerScramble - 1) fast64Scramble(acc);
+	}
+	fast64AccumulateStripe(acc, p + len - 64);
+	for(int i = 0; i < 4; i++) _mm_storeu_si128(reinterpret_cast<__m128i*>(accumulators) + i, acc[i]);
+}
+
+#else
+
+forceinline void fast64AccumulatePair(ulong64& acc0, ulong64& acc1, const byte* p, const ulong64* key)
+{
+	const ulong64 d0 = fast64Read8(p), d1 = fast64Read8(p + 8);
+	const ulong64 dk0 = d0 ^ key[0], dk1 = d1 ^ key[1];
+	acc0 += d1 + (dk0 & 0xFFFFFFFFu)*(dk0 >> 32);
+	acc1 += d0 + (dk1 & 0xFFFFFFFFu)*(dk1 >> 32);
+}
+
+forceinline void fast64ScramblePair(ulong64& acc0, ulong64& acc1, int i)
+{
+	acc0 = (acc0 ^ (acc0 >> 47) ^ fast64Key[(i + 1) & 7])*fast64ScramblePrime;
+	acc1 = (acc1 ^ (acc1 >> 47) ^ fast64Key[(i + 2) & 7])*fast64ScramblePrime;
+}
+
+//! Аккумуляторы обновляются парами, чтобы компилятор держал их в регистрах.
+void fast64Accumulate(ulong64 acc[8], const byte* p, size_t len)
+{
+	ulong64 a0 = acc[0], a1 = acc[1], a2 = acc[2], a3 = acc[3], a4 = acc[4], a5 = acc[5], a6 = acc[6], a7 = acc[7];
+	const size_t stripeCount = (len - 1)/64;
+	for(size_t s = 0; s <= stripeCount; s++)
+	{
+		const byte* const stripe = s < stripeCount? p + s*64: p + len - 64;
+		fast64AccumulatePair(a0, a1, stripe, fast64Key);
+		fast64AccumulatePair(a2, a3, stripe + 16, fast64Key + 2);
+		fast64AccumulatePair(a4, a5, stripe + 32, fast64Key + 4);
+		fast64AccumulatePair(a6, a7, stripe + 48, fast64Key + 6);
+		if(s < stripeCount && s % fast64StripesPerScramble == fast64StripesPerScramble - 1)
+		{
+			fast64ScramblePair(a0, a1, 0);
+			fast64ScramblePair(a2, a3, 2);
+			fast64ScramblePair(a4, a5, 4);
+			fast64ScramblePair(a6, a7, 6);
+		}
+	}
+	acc[0] = a0; acc[1] = a1; acc[2] = a2; acc[3] = a3; acc[4] = a4; acc[5] = a5; acc[6] = a6; acc[7] = a7;
+}
+
+#endif
+
+ulong64 fast64Long(const byte* p, size_t len, ulong64 seed)
+{
+	ulong64 acc[8];
+	for(int i = 0; i < 8; i++) acc[i] = seed ^ fast64Key[(i + 5) & 7];
+	fast64Accumulate(acc, p, len);
+	ulong64 h = ulong64(len)*fast64P0;
+	for(int i = 0; i < 8; i += 2)
+		h += fast64Mix(acc[i] ^ fast64Key[(i + 3) & 7], acc[i + 1] ^ fast64Key[(i + 4) & 7]);
+	return fast64Mix(h, seed ^ fast64P2);
+}
+
+}
+
+ulong64 Fast64(StringView key, ulong64 seed)
+{
+	const byte* const p = reinterpret_cast<const byte*>(key.Data());
+	const size_t len = key.Length();
+	seed ^= fast64Mix(seed ^ fast64P0, fast64P1);
+	ulong64 a, b;
+	if(len <= 16)
+	{
+		if(len >= 4)
+		{
+			const size_t shift = (len >> 3) << 2;
+			a = (fast64Read4(p) << 32) | fast64Read4(p + shift);
+			b = (fast64Read4(p + len - 4) << 32) | fast64Read4(p + len - 4 - shift);
+		}
+		else if(len > 0)
+		{
+			a = fast64Read3(p, len);
+			b = 0;
+		}
+		else a = b = 0;
+	}
+	else
+	{
+		if(len <= 64)
+		{
+			const byte* q = p;
+			for(size_t i = len; i > 16; i -= 16, q += 16)
+				seed = fast64Mix(fast64Read8(q) ^ fast64P1, fast64Read8(q + 8) ^ seed);
+		}
+		else seed = fast64Long(p, len, seed);
+		a = fast64Read8(p + len - 16);
+		b = fast64Read8(p + len - 8);
+	}
+	a ^= fast64P1;
+	b ^= seed;
+	fast64Mum(a, b);
+	return fast64Mix(a ^ fast64P0 ^ len, b ^ fast64P1);
+}
+
+}}
+
+INTRA_WARNING_POP
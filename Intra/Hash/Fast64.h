@@ -0,0 +1,24 @@
+﻿#pragma once
+
+#include "Cpp/Fundamental.h"
+#include "Cpp/Warnings.h"
+
+#include "Utils/StringView.h"
+
+namespace Intra { namespace Hash {
+
+INTRA_PUSH_DISABLE_REDUNDANT_WARNINGS
+
+//! Быстрая 64-разрядная некриптографическая хеш-функция.
+//! Ключи до 64 байт хешируются несколькими умножениями 64x64->128 (в стиле wyhash),
+//! более длинные обрабатываются полосами по 64 байта в 8 независимых аккумуляторах (в стиле XXH3),
+//! которые при поддержке SSE2 обновляются векторными инструкциями.
+//! Результат не зависит от платформы и совпадает с compile-time версией HashCT::Fast64 из MurmurCT.h.
+ulong64 Fast64(StringView key, ulong64 seed = 0);
+
+inline ulong64 Fast64(const char* key, ulong64 seed = 0)
+{return Fast64(StringView(key), seed);}
+
+INTRA_WARNING_POP
+
+}}
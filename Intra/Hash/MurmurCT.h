@@ -3,6 +3,7 @@
 //! В данном заголовочном файле определена compile-time версия MurmurHash 3.
 //! Она также может работать в run-time, но скорее всего будет медленнее,
 //! чем версия, определённая в файле Murmur.h
+//! Здесь же определена compile-time версия хеш-функции Fast64 из Fast64.h.
 
 #include "Types.h"
 
@@ -14,6 +15,8 @@ INTRA_PUSH_DISABLE_REDUNDANT_WARNINGS
 
 namespace Intra { namespace Range { namespace HashCT {
 
+using Hash::hash128;
+
 namespace D {
 
 constexpr inline uint murmur3_32_k(uint k)
@@ -175,6 +178,125 @@ constexpr inline hash128 _calcrest(const char* str, size_t offset, size_t restle
 constexpr inline hash128 _calcfinal(size_t len, hash128 value)
 {return _add(_fmix(_add(hash128(value.h1^len, value.h2^len))));}
 
+
+//Fast64
+enum: ulong64 {fast64P0 = 0xa0761d6478bd642fULL, fast64P1 = 0xe7037ed1a0b428dbULL, fast64P2 = 0x8ebc6af09c88c6e3ULL};
+
+constexpr ulong64 fast64KeyTable[8] = {
+	0xbe4ba423396cfeb8ULL, 0x1cad21f72c81017cULL, 0xdb979083e96dd4deULL, 0x1f67b3b7a4a44072ULL,
+	0x78e5c0cc4ee679cbULL, 0x2172ffcc7dd05a82ULL, 0x8e2443f7744608b8ULL, 0x4c263a81e69035e0ULL
+};
+
+constexpr inline ulong64 fast64Key(size_t i)
+{return fast64KeyTable[i & 7];}
+
+constexpr inline ulong64 fast64Read8(const char* str, size_t offset)
+{
+	return ulong64(byte(str[offset]))         | ulong64(byte(str[offset+1])) << 8 |
+		   ulong64(byte(str[offset+2])) << 16 | ulong64(byte(str[offset+3])) << 24 |
+		   ulong64(byte(str[offset+4])) << 32 | ulong64(byte(str[offset+5])) << 40 |
+		   ulong64(byte(str[offset+6])) << 48 | ulong64(byte(str[offset+7])) << 56;
+}
+
+constexpr inline ulong64 fast64Read4(const char* str, size_t offset)
+{
+	return ulong64(byte(str[offset]))         | ulong64(byte(str[offset+1])) << 8 |
+		   ulong64(byte(str[offset+2])) << 16 | ulong64(byte(str[offset+3])) << 24;
+}
+
+constexpr inline ulong64 fast64Read3(const char* str, size_t len)
+{return ulong64(byte(str[0])) << 16 | ulong64(byte(str[len >> 1])) << 8 | ulong64(byte(str[len-1]));}
+
+constexpr inline ulong64 fast64MulCross(ulong64 a, ulong64 b)
+{return ((ulong64(uint(a))*uint(b)) >> 32) + uint((a >> 32)*uint(b)) + ulong64(uint(a))*(b >> 32);}
+
+constexpr inline ulong64 fast64MulHi(ulong64 a, ulong64 b)
+{return (a >> 32)*(b >> 32) + (((a >> 32)*uint(b)) >> 32) + (fast64MulCross(a, b) >> 32);}
+
+constexpr inline ulong64 fast64Mix(ulong64 a, ulong64 b)
+{return (a*b) ^ fast64MulHi(a, b);}
+
+constexpr inline ulong64 fast64Final(ulong64 lo, ulong64 hi, size_t len)
+{return fast64Mix(lo ^ fast64P0 ^ len, hi ^ fast64P1);}
+
+constexpr inline ulong64 fast64Finish(ulong64 a, ulong64 b, size_t len)
+{return fast64Final(a*b, fast64MulHi(a, b), len);}
+
+constexpr inline ulong64 fast64ShortA(const char* str, size_t len)
+{
+	return len >= 4? (fast64Read4(str, 0) << 32) | fast64Read4(str, (len >> 3) << 2):
+		len > 0? fast64Read3(str, len): 0;
+}
+
+constexpr inline ulong64 fast64ShortB(const char* str, size_t len)
+{return len >= 4? (fast64Read4(str, len-4) << 32) | fast64Read4(str, len-4-((len >> 3) << 2)): 0;}
+
+constexpr inline ulong64 fast64Medium(const char* str, size_t len, ulong64 seed)
+{
+	return len <= 16? seed:
+		fast64Medium(str+16, len-16, fast64Mix(fast64Read8(str, 0) ^ fast64P1, fast64Read8(str, 8) ^ seed));
+}
+
+struct Fast64Acc {ulong64 v[8];};
+
+constexpr inline ulong64 fast64Product(ulong64 dk)
+{return (dk & 0xFFFFFFFFu)*(dk >> 32);}
+
+constexpr inline ulong64 fast64Lane(const Fast64Acc& acc, const char* stripe, size_t i)
+{return acc.v[i] + fast64Product(fast64Read8(stripe, i*8) ^ fast64Key(i)) + fast64Read8(stripe, (i^1)*8);}
+
+constexpr inline Fast64Acc fast64Stripe(const Fast64Acc& acc, const char* stripe)
+{
+	return Fast64Acc{{
+		fast64Lane(acc, stripe, 0), fast64Lane(acc, stripe, 1), fast64Lane(acc, stripe, 2), fast64Lane(acc, stripe, 3),
+		fast64Lane(acc, stripe, 4), fast64Lane(acc, stripe, 5), fast64Lane(acc, stripe, 6), fast64Lane(acc, stripe, 7)
+	}};
+}
+
+constexpr inline ulong64 fast64ScrambleLane(ulong64 v, size_t i)
+{return (v ^ (v >> 47) ^ fast64Key(i+1))*0x9E3779B1u;}
+
+constexpr inline Fast64Acc fast64Scramble(const Fast64Acc& acc)
+{
+	return Fast64Acc{{
+		fast64ScrambleLane(acc.v[0], 0), fast64ScrambleLane(acc.v[1], 1), fast64ScrambleLane(acc.v[2], 2), fast64ScrambleLane(acc.v[3], 3),
+		fast64ScrambleLane(acc.v[4], 4), fast64ScrambleLane(acc.v[5], 5), fast64ScrambleLane(acc.v[6], 6), fast64ScrambleLane(acc.v[7], 7)
+	}};
+}
+
+constexpr inline Fast64Acc fast64Stripes(const char* str, size_t stripeCount, size_t index, const Fast64Acc& acc)
+{
+	return index == stripeCount? acc:
+		fast64Stripes(str, stripeCount, index+1, index % 16 == 15?
+			fast64Scramble(fast64Stripe(acc, str + index*64)):
+			fast64Stripe(acc, str + index*64));
+}
+
+constexpr inline ulong64 fast64Merge(const Fast64Acc& acc, size_t len, ulong64 seed)
+{
+	return fast64Mix(ulong64(len)*fast64P0 +
+		fast64Mix(acc.v[0] ^ fast64Key(3), acc.v[1] ^ fast64Key(4)) +
+		fast64Mix(acc.v[2] ^ fast64Key(5), acc.v[3] ^ fast64Key(6)) +
+		fast64Mix(acc.v[4] ^ fast64Key(7), acc.v[5] ^ fast64Key(0)) +
+		fast64Mix(acc.v[6] ^ fast64Key(1), acc.v[7] ^ fast64Key(2)), seed ^ fast64P2);
+}
+
+constexpr inline ulong64 fast64Long(const char* str, size_t len, ulong64 seed)
+{
+	return fast64Merge(fast64Stripe(fast64Stripes(str, (len-1)/64, 0, Fast64Acc{{
+			seed ^ fast64Key(5), seed ^ fast64Key(6), seed ^ fast64Key(7), seed ^ fast64Key(0),
+			seed ^ fast64Key(1), seed ^ fast64Key(2), seed ^ fast64Key(3), seed ^ fast64Key(4)
+		}}), str + len - 64), len, seed);
+}
+
+constexpr inline ulong64 fast64Seeded(const char* str, size_t len, ulong64 seed)
+{
+	return len <= 16?
+		fast64Finish(fast64ShortA(str, len) ^ fast64P1, fast64ShortB(str, len) ^ seed, len):
+		fast64Finish(fast64Read8(str, len-16) ^ fast64P1, fast64Read8(str, len-8) ^
+			(len <= 64? fast64Medium(str, len, seed): fast64Long(str, len, seed)), len);
+}
+
 }
 
 constexpr hash128 inline Murmur3_128_x64(const char* str, size_t length, ulong64 seed)
@@ -199,6 +321,13 @@ template<uint N> constexpr inline ulong64 Murmur3_128_x64_low(const char(&key)[N
 template<uint N> constexpr inline uint Murmur3_32(const char(&key)[N], uint seed)
 {return D::murmur3_32_value(key, N-1, seed);}
 
+//! Compile-time версия Hash::Fast64. Даёт тот же результат.
+constexpr inline ulong64 Fast64(const char* str, size_t length, ulong64 seed)
+{return D::fast64Seeded(str, length, seed ^ D::fast64Mix(seed ^ D::fast64P0, D::fast64P1));}
+
+template<uint N> constexpr inline ulong64 Fast64(const char(&key)[N], ulong64 seed = 0)
+{return Fast64(key, N-1, seed);}
+
 #ifdef INTRA_CONSTEXPR_SUPPORT
 static_assert(Murmur3_32("hello, world", 0) == 345750399, "murmur3 test 1");
 static_assert(Murmur3_32("hello, world1", 0) == 3714214180, "murmur3 test 2");
@@ -209,6 +338,10 @@ static_assert(Murmur3_32("hello, world", 1) == 1868346089, "murmur3 test 6");
 
 static_assert(Murmur3_128_x64_low("hello, world", 0) == 0x342fac623a5ebc8eULL, "murmur3 128 test 1");
 static_assert(Murmur3_128_x64_low("hello, world", 1) == 0x8b95f808840725c6ULL, "murmur3 128 test 2");
+
+static_assert(Fast64("hello, world", 0) == 0xa62febd64a684677ULL, "fast64 test 1");
+static_assert(Fast64("hello, world", 1) == 0x2cb8c14da3691c61ULL, "fast64 test 2");
+static_assert(Fast64("The quick brown fox jumps over the lazy dog. The quick brown fox jumps over the lazy dog!", 0) == 0xf251e1735abfa70dULL, "fast64 test 3");
 #endif
 
 namespace Literals {
@@ -219,6 +352,10 @@ namespace Literals {
 constexpr inline uint operator"" _m3h(const char* str, size_t len)
 {return D::murmur3_32_value(str, len, 0);}
 
+//! 64-разрядная хеш-функция Fast64
+constexpr inline ulong64 operator"" _fh64(const char* str, size_t len)
+{return Fast64(str, len, 0);}
+
 //! Младшие 64 бита 128-разрядной Murmur3 хеш-функции
 constexpr inline ulong64 operator"" _m3h64(const char* str, size_t len)
 {return Murmur3_128_x64_low(str, len, 0);}
@@ -6,6 +6,7 @@
 #include "Meta/Type.h"
 
 #include "Murmur.h"
+#include "Fast64.h"
 
 namespace Intra { namespace Hash {
 
@@ -15,7 +16,7 @@ INTRA_DEFINE_EXPRESSION_CHECKER(HasToHashMethod, Meta::Val<T>().ToHash());
 
 template<typename T> constexpr inline Meta::EnableIf<
 	Meta::IsIntegralType<T>::_,
-uint> ToHash(T k) {return uint(k*2659435761u);}
+uint> ToHash(T k) {return uint(k)*2659435761u;}
 
 template<typename T> inline Meta::EnableIf<
 	Meta::IsFloatType<T>::_,
@@ -30,7 +31,10 @@ template<typename T> inline uint ToHash(T* k)
 {return ToHash(reinterpret_cast<size_t>(k));}
 
 inline uint ToHash(StringView k)
-{return Murmur3_32(k, 0);}
+{
+	const ulong64 h = Fast64(k, 0);
+	return uint(h ^ (h >> 32));
+}
 
 template<typename T> Meta::EnableIf<
 	HasToHashMethod<const T>::_,
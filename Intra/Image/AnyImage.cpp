@@ -4,6 +4,8 @@
 #include "Range/Mutation/Fill.h"
 #include "Range/Generators/ListRange.h"
 #include "Image/Loaders/Loader.h"
+#include "Image/FormatConversion.h"
+#include "Concurrency/ParallelFor.h"
 
 namespace Intra { namespace Image {
 
@@ -38,6 +40,78 @@ AnyImage AnyImage::FromData(USVec3 size, ImageFormat format, ImageType type,
 }
 
 
+AnyImage AnyImage::ConvertFormat(ImageFormat format, byte newLineAlignment,
+	const BlockCompressParams& params, ThreadPool& pool) const
+{
+	if(newLineAlignment == 0) newLineAlignment = LineAlignment;
+	const ImageFormat srcFormat = Info.Format;
+	const bool srcCompressed = srcFormat.IsCompressed(), dstCompressed = format.IsCompressed();
+	if(*this == null || Info == null || !format.IsValid()) return null;
+	if((srcCompressed || dstCompressed) && Info.Type == ImageType_3D) return null;
+	if((srcCompressed && !CanCompressBlocks(srcFormat)) || (dstCompressed && !CanCompressBlocks(format))) return null;
+
+	//Сжатые блоками изображения преобразуются построчно через RGBA8.
+	//sRGB8 и sRGB8_A8 хранятся так же, как RGB8 и RGBA8, и проходят через их кодеки без преобразования гаммы
+	const bool viaRGBA = srcCompressed || dstCompressed;
+	const ImageFormat rowFormat = srcCompressed? ImageFormat::RGBA8: viaRGBA? srcFormat.ToNonSRGB(): srcFormat;
+	const ImageFormat dstRowFormat = dstCompressed? ImageFormat::RGBA8: viaRGBA? format.ToNonSRGB(): format;
+	if(!CanConvertPixelRows(rowFormat, dstRowFormat)) return null;
+	if(SwapRB && !CanConvertPixelRows(rowFormat, ImageFormat::RGBA8)) return null;
+
+	AnyImage result;
+	result.Info = Info;
+	result.Info.Format = format;
+	result.LineAlignment = newLineAlignment;
+	result.Data.SetCountUninitialized(result.Info.CalculateFullDataSize(newLineAlignment));
+
+	Array<byte> rgba;
+	for(size_t mip = 0, mips = Max<size_t>(Info.MipmapCount, 1); mip < mips; mip++)
+	{
+		const USVec3 size = Info.CalculateMipmapSize(mip);
+		const USVec2 size2 = {size.x, size.y};
+		const size_t srcLayerBytes = Info.CalculateMipmapDataSize(mip, LineAlignment)/size.z;
+		const size_t dstLayerBytes = result.Info.CalculateMipmapDataSize(mip, newLineAlignment)/size.z;
+		const byte* const srcMip = static_cast<const byte*>(GetMipmapDataPtr(mip));
+		byte* const dstMip = static_cast<byte*>(result.GetMipmapDataPtr(mip));
+		const size_t rgbaLineBytes = size_t(size.x)*4;
+		if(viaRGBA) rgba.SetCountUninitialized(rgbaLineBytes*size.y);
+		for(size_t z = 0; z < size.z; z++)
+		{
+			const CSpan<byte> src(srcMip + z*srcLayerBytes, srcLayerBytes);
+			const Span<byte> dst(dstMip + z*dstLayerBytes, dstLayerBytes);
+			if(!viaRGBA)
+			{
+				const size_t srcLineBytes = srcLayerBytes/size.y, dstLineBytes = dstLayerBytes/size.y;
+				ParallelFor(pool, size.y, [&](size_t first, size_t end) {
+					for(size_t y = first; y < end; y++)
+						ConvertPixelRow(src.Data() + y*srcLineBytes, srcFormat,
+							dst.Data() + y*dstLineBytes, format, size.x, SwapRB);
+				}, Concurrency::DefaultGrainSize(size.y, dstLineBytes, pool.MaxConcurrency()));
+				continue;
+			}
+
+			if(srcCompressed) DecompressBlocks(src, srcFormat, size2, rgba, rgbaLineBytes, pool);
+			const size_t srcLineBytes = srcCompressed? rgbaLineBytes: srcLayerBytes/size.y;
+			const byte* const srcRows = srcCompressed? rgba.Data(): src.Data();
+			if(!dstCompressed)
+			{
+				const size_t dstLineBytes = dstLayerBytes/size.y;
+				for(size_t y = 0; y < size.y; y++)
+					ConvertPixelRow(srcRows + y*srcLineBytes, rowFormat, dst.Data() + y*dstLineBytes, dstRowFormat, size.x, SwapRB);
+				continue;
+			}
+			if(rowFormat != ImageFormat::RGBA8 || SwapRB)
+				for(size_t y = 0; y < size.y; y++)
+					ConvertPixelRow(srcRows + y*srcLineBytes, rowFormat,
+						rgba.Data() + y*rgbaLineBytes, ImageFormat::RGBA8, size.x, SwapRB);
+			const bool packed = rowFormat != ImageFormat::RGBA8 || SwapRB || srcCompressed;
+			CompressBlocks(packed? CSpan<byte>(rgba): src, packed? rgbaLineBytes: srcLineBytes, size2, format, dst, params, pool);
+		}
+	}
+	return result;
+}
+
+
 #if INTRA_DISABLED
 
 AnyImage AnyImage::ExtractChannel(char channelName, ImageFormat compatibleFormat, ushort newLineAlignment) const
@@ -123,7 +197,9 @@ ImageInfo AnyImage::GetImageInfo(ForwardStream stream, FileFormat* oFormat)
 	ImageInfo result;
 	for(auto& loader: AImageLoader::GetRegisteredLoaders())
 	{
-		result = loader.GetInfo(stream);
+		// каждый загрузчик читает заголовок с начала
+		ForwardStream loaderStream = stream;
+		result = loader.GetInfo(loaderStream);
 		if(result == null) continue;
 		if(oFormat) *oFormat = loader.FileFormatOfLoader();
 		break;
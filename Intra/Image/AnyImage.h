@@ -13,6 +13,7 @@
 
 #include "ImageFormat.h"
 #include "ImageInfo.h"
+#include "BlockCompression.h"
 
 namespace Intra { namespace Image {
 
@@ -34,6 +35,14 @@ public:
 
 	AnyImage ExtractChannel(char channelName, ImageFormat compatibleFormat, ushort newLineAlignment=0) const;
 
+	//! Преобразовать все мип-уровни, слои и грани в формат format с выравниванием строк newLineAlignment.
+	//! Если newLineAlignment == 0, выравнивание сохраняется. Каналы, переставленные по SwapRB, возвращаются на место.
+	//! Сжатые форматы распаковываются и сжимаются через RGBA8 функциями DecompressBlocks и CompressBlocks.
+	//! sRGB8 и sRGB8_A8 при этом проходят через RGB8 и RGBA8 без преобразования гаммы.
+	//! @return null, если преобразование между форматами не поддерживается или изображение трёхмерное и сжатое.
+	AnyImage ConvertFormat(ImageFormat format, byte newLineAlignment=0,
+		const BlockCompressParams& params=BlockCompressParams(), ThreadPool& pool=ThreadPool::Default()) const;
+
 	static AnyImage FromData(Math::USVec3 size, ImageFormat format, ImageType type, const void* data,
 		ushort borderLeft, ushort borderTop, ushort borderRight, ushort borderBottom);
 
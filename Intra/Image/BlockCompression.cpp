@@ -0,0 +1,579 @@
+﻿#include "Image/BlockCompression.h"
+#include "Concurrency/ParallelFor.h"
+#include "Math/Math.h"
+#include "Cpp/Intrinsics.h"
+#include "Simd/Simd.h"
+
+namespace Intra { namespace Image {
+
+using namespace Math;
+
+INTRA_PUSH_DISABLE_REDUNDANT_WARNINGS
+
+namespace {
+
+//! Способ кодирования каналов блока.
+enum BcKind: byte
+{
+	BcNone,
+	BcColor,           //!< BC1 без прозрачности
+	BcColorAlpha1,     //!< BC1 с прозрачностью через трёхцветный режим
+	BcColorAlpha4,     //!< BC2: явная 4-битная альфа и BC1
+	BcColorAlpha8,     //!< BC3: альфа в блоке BC4 и BC1
+	BcRed,             //!< BC4
+	BcRedGreen,        //!< BC5
+	BcLuminance,       //!< BC4 с яркостью
+	BcLuminanceAlpha   //!< BC5 с яркостью и альфой
+};
+
+BcKind bcKindOf(ImageFormat format)
+{
+	switch(format.value)
+	{
+	case ImageFormat::DXT1_RGB: case ImageFormat::DXT1_sRGB: return BcColor;
+	case ImageFormat::DXT1_RGBA: case ImageFormat::DXT1_sRGB_A: return BcColorAlpha1;
+	case ImageFormat::DXT3_RGBA: case ImageFormat::DXT3_sRGB_A: return BcColorAlpha4;
+	case ImageFormat::DXT5_RGBA: case ImageFormat::DXT5_sRGB_A: return BcColorAlpha8;
+	case ImageFormat::RGTC_Red: return BcRed;
+	case ImageFormat::RGTC_RG: return BcRedGreen;
+	case ImageFormat::LATC_Luminance: return BcLuminance;
+	case ImageFormat::LATC_LuminanceAlpha: return BcLuminanceAlpha;
+	default: return BcNone;
+	}
+}
+
+size_t bcBlockBytes(BcKind kind)
+{return kind == BcColor || kind == BcColorAlpha1 || kind == BcRed || kind == BcLuminance? 8u: 16u;}
+
+uint bcLoad16(const byte* p) {return uint(p[0]) | uint(p[1]) << 8;}
+
+void bcStore16(byte* p, uint v)
+{
+	p[0] = byte(v);
+	p[1] = byte(v >> 8);
+}
+
+//! Цвет RGB565 в RGB888 с повторением старших битов в младших.
+void bcUnpack565(uint c, int rgb[3])
+{
+	const int r = int(c >> 11) & 31, g = int(c >> 5) & 63, b = int(c) & 31;
+	rgb[0] = (r << 3) | (r >> 2);
+	rgb[1] = (g << 2) | (g >> 4);
+	rgb[2] = (b << 3) | (b >> 2);
+}
+
+//! Палитра BC1 из опорных цветов c0 и c1. В трёхцветном режиме третий цвет - среднее, четвёртый - чёрный.
+//! Используется и распаковщиком, и кодировщиком, чтобы ошибка при подборе совпадала с ошибкой распаковки.
+void bcColorPalette(uint c0, uint c1, bool threeColor, int pal[4][3])
+{
+	bcUnpack565(c0, pal[0]);
+	bcUnpack565(c1, pal[1]);
+	for(uint k = 0; k < 3; k++)
+	{
+		if(threeColor)
+		{
+			pal[2][k] = (pal[0][k] + pal[1][k] + 1)/2;
+			pal[3][k] = 0;
+			continue;
+		}
+		pal[2][k] = (2*pal[0][k] + pal[1][k] + 1)/3;
+		pal[3][k] = (pal[0][k] + 2*pal[1][k] + 1)/3;
+	}
+}
+
+//! Палитра BC4. При a0 > a1 восемь значений интерполируются, иначе шесть, а последние два - 0 и 255.
+void bcSinglePalette(uint a0, uint a1, byte pal[8])
+{
+	pal[0] = byte(a0);
+	pal[1] = byte(a1);
+	if(a0 > a1)
+	{
+		for(uint i = 1; i < 7; i++) pal[i + 1] = byte(((7 - i)*a0 + i*a1 + 3)/7);
+		return;
+	}
+	for(uint i = 1; i < 5; i++) pal[i + 1] = byte(((5 - i)*a0 + i*a1 + 2)/5);
+	pal[6] = 0;
+	pal[7] = 255;
+}
+
+//! Распаковать цветовую часть блока BC1-BC3 в тайл 4x4 RGBA8.
+//! punchThrough - четвёртый цвет трёхцветного режима прозрачный. BC2 и BC3 всегда используют четырёхцветный режим.
+void bcDecodeColor(const byte* block, bool punchThrough, bool fourColorOnly, byte* tile)
+{
+	const uint c0 = bcLoad16(block), c1 = bcLoad16(block + 2);
+	const bool threeColor = !fourColorOnly && c0 <= c1;
+	int pal[4][3];
+	bcColorPalette(c0, c1, threeColor, pal);
+	uint palette[4];
+	for(int i = 0; i < 4; i++)
+	{
+		const byte rgba[4] = {byte(pal[i][0]), byte(pal[i][1]), byte(pal[i][2]),
+			byte(threeColor && punchThrough && i == 3? 0: 255)};
+		C::memcpy(palette + i, rgba, 4);
+	}
+#if(INTRA_SIMD_SUPPORT >= INTRA_SIMD_SSE2 && INTRA_SIMD_SUPPORT <= INTRA_SIMD_AVX2)
+	//Каждый пиксель строки выбирает цвет палитры маской сравнения своего 2-битного индекса
+	const __m128i pal0 = _mm_set1_epi32(int(palette[0])), pal1 = _mm_set1_epi32(int(palette[1]));
+	const __m128i pal2 = _mm_set1_epi32(int(palette[2])), pal3 = _mm_set1_epi32(int(palette[3]));
+	const __m128i unit = _mm_set_epi32(64, 16, 4, 1);
+	const __m128i mask = _mm_set_epi32(3 << 6, 3 << 4, 3 << 2, 3);
+	for(int y = 0; y < 4; y++)
+	{
+		const __m128i idx = _mm_and_si128(_mm_set1_epi32(block[4 + y]), mask);
+		__m128i rgba = _mm_and_si128(_mm_cmpeq_epi32(idx, _mm_setzero_si128()), pal0);
+		rgba = _mm_or_si128(rgba, _mm_and_si128(_mm_cmpeq_epi32(idx, unit), pal1));
+		rgba = _mm_or_si128(rgba, _mm_and_si128(_mm_cmpeq_epi32(idx, _mm_add_epi32(unit, unit)), pal2));
+		rgba = _mm_or_si128(rgba, _mm_and_si128(_mm_cmpeq_epi32(idx, mask), pal3));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(tile + 16*y), rgba);
+	}
+#else
+	for(int y = 0; y < 4; y++)
+		for(int x = 0; x < 4; x++)
+			C::memcpy(tile + 16*y + 4*x, palette + ((block[4 + y] >> 2*x) & 3), 4);
+#endif
+}
+
+//! Распаковать блок BC4 в канал channel тайла 4x4 RGBA8.
+void bcDecodeSingle(const byte* block, byte* tile, size_t channel)
+{
+	byte pal[8];
+	bcSinglePalette(block[0], block[1], pal);
+	for(size_t half = 0; half < 2; half++)
+	{
+		const byte* const p = block + 2 + 3*half;
+		const uint bits = uint(p[0]) | uint(p[1]) << 8 | uint(p[2]) << 16;
+		for(size_t i = 0; i < 8; i++)
+			tile[4*(8*half + i) + channel] = pal[(bits >> 3*i) & 7];
+	}
+}
+
+void bcDecodeBlock(const byte* block, BcKind kind, byte* tile)
+{
+	switch(kind)
+	{
+	case BcColor: case BcColorAlpha1:
+		bcDecodeColor(block, kind == BcColorAlpha1, false, tile);
+		break;
+
+	case BcColorAlpha4:
+		bcDecodeColor(block + 8, false, true, tile);
+		for(size_t i = 0; i < 16; i++)
+			tile[4*i + 3] = byte(((block[i/2] >> 4*(i & 1)) & 15)*17);
+		break;
+
+	case BcColorAlpha8:
+		bcDecodeColor(block + 8, false, true, tile);
+		bcDecodeSingle(block, tile, 3);
+		break;
+
+	default:
+		for(size_t i = 0; i < 16; i++)
+		{
+			tile[4*i + 1] = tile[4*i + 2] = 0;
+			tile[4*i + 3] = 255;
+		}
+		bcDecodeSingle(block, tile, 0);
+		if(kind == BcRedGreen) bcDecodeSingle(block + 8, tile, 1);
+		if(kind == BcLuminanceAlpha) bcDecodeSingle(block + 8, tile, 3);
+		if(kind == BcLuminance || kind == BcLuminanceAlpha)
+			for(size_t i = 0; i < 16; i++) tile[4*i + 1] = tile[4*i + 2] = tile[4*i];
+	}
+}
+
+
+//! Собрать блок 4x4 RGBA8, повторяя крайние пиксели за правым и нижним краями изображения.
+void bcGatherBlock(const byte* src, size_t lineBytes, USVec2 size, size_t bx, size_t by, byte* tile)
+{
+	for(size_t y = 0; y < 4; y++)
+	{
+		const byte* const row = src + Min<size_t>(4*by + y, size.y - 1u)*lineBytes;
+		if(4*bx + 4 <= size.x)
+		{
+			C::memcpy(tile + 16*y, row + 16*bx, 16);
+			continue;
+		}
+		for(size_t x = 0; x < 4; x++)
+			C::memcpy(tile + 16*y + 4*x, row + 4*Min<size_t>(4*bx + x, size.x - 1u), 4);
+	}
+}
+
+uint bcPack565(const float c[3])
+{
+	const uint r = uint(c[0]*(31.0f/255) + 0.5f), g = uint(c[1]*(63.0f/255) + 0.5f), b = uint(c[2]*(31.0f/255) + 0.5f);
+	return Min(r, 31u) << 11 | Min(g, 63u) << 5 | Min(b, 31u);
+}
+
+//! Индексы ближайших цветов палитры из palSize цветов для непрозрачных пикселей блока.
+//! Прозрачные пиксели, отмеченные битами transparent, получают индекс 3. error - суммарная квадратичная ошибка.
+uint bcColorIndices(const byte* tile, uint transparent, const int pal[4][3], uint palSize, uint& error)
+{
+	uint indices = 0;
+	error = 0;
+	for(uint i = 0; i < 16; i++)
+	{
+		uint best = 3;
+		if((transparent >> i & 1) == 0)
+		{
+			uint bestError = ~0u;
+			for(uint k = 0; k < palSize; k++)
+			{
+				const int dr = tile[4*i] - pal[k][0], dg = tile[4*i + 1] - pal[k][1], db = tile[4*i + 2] - pal[k][2];
+				const uint e = uint(dr*dr + dg*dg + db*db);
+				if(e >= bestError) continue;
+				bestError = e;
+				best = k;
+			}
+			error += bestError;
+		}
+		indices |= best << 2*i;
+	}
+	return indices;
+}
+
+//! Опорные цвета - углы ограничивающего параллелепипеда непрозрачных пикселей, сдвинутые внутрь на 1/16 его размера.
+//! Диагональ выбирается по знакам ковариаций красного и синего с зелёным.
+void bcBoundingBoxEndpoints(const byte* tile, uint transparent, float e0[3], float e1[3])
+{
+	int mins[3] = {255, 255, 255}, maxs[3] = {0, 0, 0}, sums[3] = {0, 0, 0}, n = 0;
+	for(uint i = 0; i < 16; i++)
+	{
+		if(transparent >> i & 1) continue;
+		for(uint k = 0; k < 3; k++)
+		{
+			const int v = tile[4*i + k];
+			mins[k] = Min(mins[k], v);
+			maxs[k] = Max(maxs[k], v);
+			sums[k] += v;
+		}
+		n++;
+	}
+	float covRG = 0, covBG = 0;
+	for(uint i = 0; i < 16; i++)
+	{
+		if(transparent >> i & 1) continue;
+		const float g = float(tile[4*i + 1]*n - sums[1]);
+		covRG += float(tile[4*i]*n - sums[0])*g;
+		covBG += float(tile[4*i + 2]*n - sums[2])*g;
+	}
+	for(uint k = 0; k < 3; k++)
+	{
+		const float inset = float(maxs[k] - mins[k])/16;
+		e0[k] = float(maxs[k]) - inset;
+		e1[k] = float(mins[k]) + inset;
+	}
+	if(covRG < 0) Cpp::Swap(e0[0], e1[0]);
+	if(covBG < 0) Cpp::Swap(e0[2], e1[2]);
+}
+
+//! Опорные цвета - проекции крайних непрозрачных пикселей на главную ось их ковариационной матрицы.
+//! Ось находится несколькими итерациями степенного метода.
+void bcPrincipalEndpoints(const byte* tile, uint transparent, float e0[3], float e1[3])
+{
+	float mean[3] = {0, 0, 0};
+	uint n = 0;
+	for(uint i = 0; i < 16; i++)
+	{
+		if(transparent >> i & 1) continue;
+		for(uint k = 0; k < 3; k++) mean[k] += tile[4*i + k];
+		n++;
+	}
+	for(uint k = 0; k < 3; k++) mean[k] /= float(n);
+
+	float cov[3][3] = {{0, 0, 0}, {0, 0, 0}, {0, 0, 0}};
+	for(uint i = 0; i < 16; i++)
+	{
+		if(transparent >> i & 1) continue;
+		const float d[3] = {tile[4*i] - mean[0], tile[4*i + 1] - mean[1], tile[4*i + 2] - mean[2]};
+		for(int a = 0; a < 3; a++)
+			for(int b = 0; b < 3; b++) cov[a][b] += d[a]*d[b];
+	}
+
+	int start = 0;
+	if(cov[1][1] > cov[start][start]) start = 1;
+	if(cov[2][2] > cov[start][start]) start = 2;
+	float axis[3] = {cov[start][0], cov[start][1], cov[start][2]};
+	for(int iter = 0; iter < 4; iter++)
+	{
+		float next[3];
+		for(int a = 0; a < 3; a++) next[a] = cov[a][0]*axis[0] + cov[a][1]*axis[1] + cov[a][2]*axis[2];
+		const float norm = Max(Abs(next[0]), Max(Abs(next[1]), Abs(next[2])));
+		if(norm < 1e-6f) break;
+		for(int a = 0; a < 3; a++) axis[a] = next[a]/norm;
+	}
+	const float lengthSqr = axis[0]*axis[0] + axis[1]*axis[1] + axis[2]*axis[2];
+	if(lengthSqr < 1e-6f)
+	{
+		//Все непрозрачные пиксели одного цвета
+		for(uint k = 0; k < 3; k++) e0[k] = e1[k] = mean[k];
+		return;
+	}
+
+	float minT = 0, maxT = 0;
+	for(uint i = 0; i < 16; i++)
+	{
+		if(transparent >> i & 1) continue;
+		const float t = (tile[4*i] - mean[0])*axis[0] + (tile[4*i + 1] - mean[1])*axis[1] + (tile[4*i + 2] - mean[2])*axis[2];
+		minT = Min(minT, t);
+		maxT = Max(maxT, t);
+	}
+	for(uint k = 0; k < 3; k++)
+	{
+		e0[k] = Clamp(mean[k] + axis[k]*maxT/lengthSqr, 0.0f, 255.0f);
+		e1[k] = Clamp(mean[k] + axis[k]*minT/lengthSqr, 0.0f, 255.0f);
+	}
+}
+
+//! Доля второго опорного цвета в цветах палитры по индексу в четырёх- и трёхцветном режимах.
+const float bcColorWeights4[4] = {0, 1, 1.0f/3, 2.0f/3};
+const float bcColorWeights3[4] = {0, 1, 0.5f, 0};
+
+//! Опорные цвета, минимизирующие квадратичную ошибку при фиксированных индексах.
+//! @return false, если система вырождена - все пиксели выбрали один цвет палитры.
+bool bcRefineEndpoints(const byte* tile, uint transparent, uint indices, const float weights[4], float e0[3], float e1[3])
+{
+	float aa = 0, bb = 0, ab = 0, ax[3] = {0, 0, 0}, bx[3] = {0, 0, 0};
+	for(uint i = 0; i < 16; i++)
+	{
+		if(transparent >> i & 1) continue;
+		const float t = weights[(indices >> 2*i) & 3], s = 1 - t;
+		aa += s*s;
+		bb += t*t;
+		ab += s*t;
+		for(uint k = 0; k < 3; k++)
+		{
+			ax[k] += s*tile[4*i + k];
+			bx[k] += t*tile[4*i + k];
+		}
+	}
+	const float det = aa*bb - ab*ab;
+	if(Abs(det) < 1e-4f) return false;
+	const float invDet = 1/det;
+	for(uint k = 0; k < 3; k++)
+	{
+		e0[k] = Clamp((bb*ax[k] - ab*bx[k])*invDet, 0.0f, 255.0f);
+		e1[k] = Clamp((aa*bx[k] - ab*ax[k])*invDet, 0.0f, 255.0f);
+	}
+	return true;
+}
+
+//! Закодировать цветовую часть блока BC1-BC3.
+//! Если в transparent есть отмеченные пиксели, используется трёхцветный режим DXT1 с прозрачным четвёртым цветом.
+void bcEncodeColor(const byte* tile, uint transparent, uint quality, byte* block)
+{
+	if(transparent == 0xFFFF)
+	{
+		bcStore16(block, 0);
+		bcStore16(block + 2, 0);
+		C::memset(block + 4, 0xFF, 4);
+		return;
+	}
+
+	const bool threeColor = transparent != 0;
+	const uint palSize = threeColor? 3u: 4u;
+	float e0[3], e1[3];
+	if(quality == 0) bcBoundingBoxEndpoints(tile, transparent, e0, e1);
+	else bcPrincipalEndpoints(tile, transparent, e0, e1);
+
+	int pal[4][3];
+	uint c0 = bcPack565(e0), c1 = bcPack565(e1), error;
+	bcColorPalette(c0, c1, threeColor, pal);
+	uint indices = bcColorIndices(tile, transparent, pal, palSize, error);
+	for(uint iter = 1; iter < quality && error != 0; iter++)
+	{
+		if(!bcRefineEndpoints(tile, transparent, indices, threeColor? bcColorWeights3: bcColorWeights4, e0, e1)) break;
+		const uint n0 = bcPack565(e0), n1 = bcPack565(e1);
+		if(n0 == c0 && n1 == c1) break;
+		uint newError;
+		bcColorPalette(n0, n1, threeColor, pal);
+		const uint newIndices = bcColorIndices(tile, transparent, pal, palSize, newError);
+		if(newError >= error) break;
+		c0 = n0;
+		c1 = n1;
+		indices = newIndices;
+		error = newError;
+	}
+
+	//Режим палитры задаётся порядком опорных цветов: c0 > c1 - четыре цвета, иначе три
+	if(threeColor)
+	{
+		if(c0 > c1)
+		{
+			Cpp::Swap(c0, c1);
+			indices ^= ~(indices >> 1) & 0x55555555u; //0 <-> 1
+		}
+	}
+	else if(c0 < c1)
+	{
+		Cpp::Swap(c0, c1);
+		indices ^= 0x55555555u; //0 <-> 1, 2 <-> 3
+	}
+	else if(c0 == c1) indices = 0;
+
+	bcStore16(block, c0);
+	bcStore16(block + 2, c1);
+	bcStore16(block + 4, indices);
+	bcStore16(block + 6, indices >> 16);
+}
+
+//! Индексы ближайших значений палитры BC4 для канала channel тайла. error - суммарная квадратичная ошибка.
+ulong64 bcSingleIndices(const byte* tile, size_t channel, const byte pal[8], uint& error)
+{
+	ulong64 indices = 0;
+	error = 0;
+	for(uint i = 0; i < 16; i++)
+	{
+		const int v = tile[4*i + channel];
+		uint best = 0, bestError = ~0u;
+		for(uint k = 0; k < 8; k++)
+		{
+			const uint e = uint((v - pal[k])*(v - pal[k]));
+			if(e >= bestError) continue;
+			bestError = e;
+			best = k;
+		}
+		error += bestError;
+		indices |= ulong64(best) << 3*i;
+	}
+	return indices;
+}
+
+//! Закодировать канал channel тайла в блок BC4.
+//! Восьмицветный режим строится по минимуму и максимуму. При quality > 0 пробуется и шестицветный режим
+//! по значениям, кроме 0 и 255, которые в нём представлены точно.
+void bcEncodeSingle(const byte* tile, size_t channel, uint quality, byte* block)
+{
+	uint mins = 255, maxs = 0, innerMin = 255, innerMax = 0;
+	for(size_t i = 0; i < 16; i++)
+	{
+		const uint v = tile[4*i + channel];
+		mins = Min(mins, v);
+		maxs = Max(maxs, v);
+		if(v == 0 || v == 255) continue;
+		innerMin = Min(innerMin, v);
+		innerMax = Max(innerMax, v);
+	}
+
+	byte pal[8];
+	uint a0 = maxs, a1 = mins, error;
+	bcSinglePalette(a0, a1, pal);
+	ulong64 indices = bcSingleIndices(tile, channel, pal, error);
+	if(quality > 0 && error != 0)
+	{
+		if(innerMin > innerMax) innerMin = innerMax = 0;
+		uint newError;
+		bcSinglePalette(innerMin, innerMax, pal);
+		const ulong64 newIndices = bcSingleIndices(tile, channel, pal, newError);
+		if(newError < error)
+		{
+			a0 = innerMin;
+			a1 = innerMax;
+			indices = newIndices;
+		}
+	}
+
+	block[0] = byte(a0);
+	block[1] = byte(a1);
+	for(size_t i = 0; i < 6; i++) block[2 + i] = byte(indices >> 8*i);
+}
+
+void bcEncodeBlock(byte* tile, BcKind kind, const BlockCompressParams& params, byte* block)
+{
+	switch(kind)
+	{
+	case BcColor:
+		bcEncodeColor(tile, 0, params.Quality, block);
+		break;
+
+	case BcColorAlpha1:
+	{
+		uint transparent = 0;
+		for(uint i = 0; i < 16; i++)
+			if(tile[4*i + 3] < params.AlphaThreshold) transparent |= 1u << i;
+		bcEncodeColor(tile, transparent, params.Quality, block);
+		break;
+	}
+
+	case BcColorAlpha4:
+		for(size_t i = 0; i < 8; i++)
+		{
+			const uint lo = (tile[8*i + 3]*15u + 127)/255, hi = (tile[8*i + 7]*15u + 127)/255;
+			block[i] = byte(lo | hi << 4);
+		}
+		bcEncodeColor(tile, 0, params.Quality, block + 8);
+		break;
+
+	case BcColorAlpha8:
+		bcEncodeSingle(tile, 3, params.Quality, block);
+		bcEncodeColor(tile, 0, params.Quality, block + 8);
+		break;
+
+	case BcLuminance: case BcLuminanceAlpha:
+		for(size_t i = 0; i < 16; i++)
+			tile[4*i] = byte((tile[4*i]*77u + tile[4*i + 1]*150u + tile[4*i + 2]*29u + 128) >> 8);
+		bcEncodeSingle(tile, 0, params.Quality, block);
+		if(kind == BcLuminanceAlpha) bcEncodeSingle(tile, 3, params.Quality, block + 8);
+		break;
+
+	default:
+		bcEncodeSingle(tile, 0, params.Quality, block);
+		if(kind == BcRedGreen) bcEncodeSingle(tile, 1, params.Quality, block + 8);
+	}
+}
+
+}
+
+bool CanCompressBlocks(ImageFormat format) {return bcKindOf(format) != BcNone;}
+
+void DecompressBlocks(CSpan<byte> src, ImageFormat format, USVec2 size,
+	Span<byte> dst, size_t dstLineBytes, ThreadPool& pool)
+{
+	const BcKind kind = bcKindOf(format);
+	INTRA_DEBUG_ASSERT(kind != BcNone);
+	if(kind == BcNone || size.x == 0 || size.y == 0) return;
+	const size_t blocksX = (size.x + 3u)/4u, blocksY = (size.y + 3u)/4u, blockBytes = bcBlockBytes(kind);
+	INTRA_DEBUG_ASSERT(src.Length() >= blocksX*blocksY*blockBytes);
+	INTRA_DEBUG_ASSERT(dst.Length() >= dstLineBytes*(size.y - 1u) + size.x*4u);
+	const byte* const srcData = src.Data();
+	byte* const dstData = dst.Data();
+	ParallelFor(pool, blocksY, [&](size_t first, size_t end) {
+		byte tile[64];
+		for(size_t by = first; by < end; by++)
+		{
+			const size_t rows = Min<size_t>(4, size.y - 4*by);
+			for(size_t bx = 0; bx < blocksX; bx++)
+			{
+				bcDecodeBlock(srcData + (by*blocksX + bx)*blockBytes, kind, tile);
+				const size_t cols = Min<size_t>(4, size.x - 4*bx);
+				for(size_t y = 0; y < rows; y++)
+					C::memcpy(dstData + (4*by + y)*dstLineBytes + 16*bx, tile + 16*y, 4*cols);
+			}
+		}
+	}, Concurrency::DefaultGrainSize(blocksY, blocksX*64, pool.MaxConcurrency()));
+}
+
+void CompressBlocks(CSpan<byte> src, size_t srcLineBytes, USVec2 size,
+	ImageFormat format, Span<byte> dst, const BlockCompressParams& params, ThreadPool& pool)
+{
+	const BcKind kind = bcKindOf(format);
+	INTRA_DEBUG_ASSERT(kind != BcNone);
+	if(kind == BcNone || size.x == 0 || size.y == 0) return;
+	const size_t blocksX = (size.x + 3u)/4u, blocksY = (size.y + 3u)/4u, blockBytes = bcBlockBytes(kind);
+	INTRA_DEBUG_ASSERT(src.Length() >= srcLineBytes*(size.y - 1u) + size.x*4u);
+	INTRA_DEBUG_ASSERT(dst.Length() >= blocksX*blocksY*blockBytes);
+	const byte* const srcData = src.Data();
+	byte* const dstData = dst.Data();
+	//Кодирование на порядок дороже распаковки, поэтому полосы берутся мельче
+	ParallelFor(pool, blocksY, [&](size_t first, size_t end) {
+		byte tile[64];
+		for(size_t by = first; by < end; by++)
+			for(size_t bx = 0; bx < blocksX; bx++)
+			{
+				bcGatherBlock(srcData, srcLineBytes, size, bx, by, tile);
+				bcEncodeBlock(tile, kind, params, dstData + (by*blocksX + bx)*blockBytes);
+			}
+	}, Concurrency::DefaultGrainSize(blocksY, blocksX*64*16, pool.MaxConcurrency()));
+}
+
+INTRA_WARNING_POP
+
+}}
@@ -0,0 +1,51 @@
+﻿#pragma once
+
+#include "Cpp/Warnings.h"
+#include "Cpp/Fundamental.h"
+
+#include "Math/Vector2.h"
+#include "Utils/Span.h"
+
+#include "Concurrency/ThreadPool.h"
+
+#include "Image/ImageFormat.h"
+
+namespace Intra { namespace Image {
+
+INTRA_PUSH_DISABLE_REDUNDANT_WARNINGS
+
+//! Параметры CompressBlocks.
+struct BlockCompressParams
+{
+	//! Качество подбора опорных цветов блоков BC1-BC3.
+	//! 0 - углы ограничивающего параллелепипеда цветов блока, самое быстрое;
+	//! 1 - крайние точки вдоль главной оси цветов блока;
+	//! каждое следующее значение добавляет итерацию уточнения опорных цветов методом наименьших квадратов.
+	//! Для BC4 и BC5 при Quality > 0 дополнительно пробуется режим с явными 0 и 255.
+	uint Quality = 2;
+
+	//! В DXT1_RGBA пиксели с альфой меньше этого порога кодируются прозрачными.
+	byte AlphaThreshold = 128;
+};
+
+//! Поддерживают ли DecompressBlocks и CompressBlocks формат format.
+//! Поддерживаются DXT1, DXT3, DXT5 (BC1-BC3) вместе с их sRGB вариантами и беззнаковые RGTC и LATC (BC4, BC5).
+bool CanCompressBlocks(ImageFormat format);
+
+//! Распаковать изображение размера size из блоков 4x4 формата format в RGBA8 со строками по dstLineBytes байт.
+//! Отсутствующие в формате цветовые каналы заполняются нулями, альфа - значением 255. LATC копирует яркость в RGB.
+//! Строки блоков распаковываются параллельно в потоках пула pool.
+void DecompressBlocks(CSpan<byte> src, ImageFormat format, Math::USVec2 size,
+	Span<byte> dst, size_t dstLineBytes, ThreadPool& pool = ThreadPool::Default());
+
+//! Сжать изображение RGBA8 размера size со строками по srcLineBytes байт в блоки 4x4 формата format.
+//! Неполные блоки на правом и нижнем краях дополняются повторением крайних пикселей.
+//! RGTC кодирует каналы R и G, LATC - яркость по весам BT.601 и альфу.
+//! Строки блоков кодируются параллельно в потоках пула pool.
+void CompressBlocks(CSpan<byte> src, size_t srcLineBytes, Math::USVec2 size,
+	ImageFormat format, Span<byte> dst,
+	const BlockCompressParams& params = BlockCompressParams(), ThreadPool& pool = ThreadPool::Default());
+
+INTRA_WARNING_POP
+
+}}
@@ -1,7 +1,10 @@
 ﻿#include "Image/FormatConversion.h"
 #include "Cpp/Fundamental.h"
 #include "Cpp/Endianess.h"
+#include "Cpp/Intrinsics.h"
 #include "Range/Stream/RawRead.h"
+#include "Container/Sequential/Array.h"
+#include "Simd/Simd.h"
 
 namespace Intra {
 
@@ -21,121 +24,373 @@ uint ConvertColorBits(uint color, uint fromBitCount, uint toBitCount)
 	return color;
 }
 
-template<typename T> static void SwapRedBlueTyped(size_t lineUnused,
-	size_t componentCount, Math::USVec2 sizes, T* data)
+namespace {
+
+//! Все строковые преобразования идут через промежуточный формат RGBA8:
+//! каждый поддерживаемый формат умеет распаковывать строку в RGBA8 и упаковывать её обратно.
+//! Строка обрабатывается кусками по PixelRowChunk пикселей, чтобы промежуточный буфер оставался в кэше.
+enum: size_t {PixelRowChunk = 256};
+
+typedef void(*PixelRowFunc)(const byte* src, byte* dst, size_t count);
+
+struct PixelRowCodec
+{
+	ImageFormat::I Format;
+	PixelRowFunc Unpack, Pack;
+};
+
+constexpr uint pixelRowLowBit(uint mask) {return mask == 0 || (mask & 1u)? 0u: 1u + pixelRowLowBit(mask >> 1);}
+constexpr uint pixelRowBitCount(uint mask) {return mask == 0? 0u: (mask & 1u) + pixelRowBitCount(mask >> 1);}
+
+//! Компонент упакованного 16-битного формата, заданный маской.
+//! Расширение до 8 бит повторяет старшие биты в младших, поэтому максимум переходит в 255.
+template<uint Mask> struct PixelRowChannel
+{
+	enum: uint {
+		Shift = pixelRowLowBit(Mask), Bits = pixelRowBitCount(Mask), Max = (1u << Bits) - 1u,
+		Up = Bits >= 4? 8 - Bits: 0, Down = Bits >= 4? 2*Bits - 8: 0
+	};
+	static_assert(Bits == 0 || Bits == 1 || (Bits >= 4 && Bits <= 8), "Unsupported channel width!");
+
+	static forceinline byte Expand(uint color)
+	{
+		if(Bits == 0) return 255;
+		const uint v = (color >> Shift) & Max;
+		if(Bits == 1) return byte(0u - v);
+		return byte((v << Up)|(v >> Down));
+	}
+
+	static forceinline uint Compress(uint v)
+	{
+		if(Bits == 0) return 0;
+		v = v*Max + 128;
+		return ((v + (v >> 8)) >> 8) << Shift;
+	}
+
+#if(INTRA_SIMD_SUPPORT >= INTRA_SIMD_SSE2 && INTRA_SIMD_SUPPORT <= INTRA_SIMD_AVX2)
+	static forceinline __m128i Expand(__m128i color)
+	{
+		if(Bits == 0) return _mm_set1_epi16(255);
+		const __m128i v = _mm_and_si128(_mm_srli_epi16(color, int(Shift)), _mm_set1_epi16(short(Max)));
+		if(Bits == 1) return _mm_mullo_epi16(v, _mm_set1_epi16(255));
+		return _mm_or_si128(_mm_slli_epi16(v, int(Up)), _mm_srli_epi16(v, int(Down)));
+	}
+#endif
+};
+
+template<uint RMask, uint GMask, uint BMask, uint AMask>
+void pixelRowUnpackPacked16(const byte* src, byte* dst, size_t count)
 {
-	for(int y = 0; y<sizes.y; y++)
+	typedef PixelRowChannel<RMask> R;
+	typedef PixelRowChannel<GMask> G;
+	typedef PixelRowChannel<BMask> B;
+	typedef PixelRowChannel<AMask> A;
+	size_t i = 0;
+#if(INTRA_SIMD_SUPPORT >= INTRA_SIMD_SSE2 && INTRA_SIMD_SUPPORT <= INTRA_SIMD_AVX2)
+	for(; i + 8 <= count; i += 8)
+	{
+		const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 2*i));
+		const __m128i rg = _mm_or_si128(R::Expand(c), _mm_slli_epi16(G::Expand(c), 8));
+		const __m128i ba = _mm_or_si128(B::Expand(c), _mm_slli_epi16(A::Expand(c), 8));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 4*i), _mm_unpacklo_epi16(rg, ba));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 4*i + 16), _mm_unpackhi_epi16(rg, ba));
+	}
+#endif
+	for(; i < count; i++)
 	{
-		for(int x = 0; x<sizes.x; x++)
+		const uint c = uint(src[2*i] | (src[2*i + 1] << 8));
+		dst[4*i] = R::Expand(c);
+		dst[4*i + 1] = G::Expand(c);
+		dst[4*i + 2] = B::Expand(c);
+		dst[4*i + 3] = A::Expand(c);
+	}
+}
+
+template<uint RMask, uint GMask, uint BMask, uint AMask>
+void pixelRowPackPacked16(const byte* src, byte* dst, size_t count)
+{
+	for(size_t i = 0; i < count; i++)
+	{
+		const uint c = PixelRowChannel<RMask>::Compress(src[4*i]) |
+			PixelRowChannel<GMask>::Compress(src[4*i + 1]) |
+			PixelRowChannel<BMask>::Compress(src[4*i + 2]) |
+			PixelRowChannel<AMask>::Compress(src[4*i + 3]);
+		dst[2*i] = byte(c);
+		dst[2*i + 1] = byte(c >> 8);
+	}
+}
+
+//! Каналы, которых нет в исходном формате, заполняются нулями, а альфа - 255.
+//! Luminance переходит во все три цветовых канала.
+template<int R, int G, int B, int A, uint N> void pixelRowUnpack8(const byte* src, byte* dst, size_t count)
+{
+	for(size_t i = 0; i < count; i++, src += N, dst += 4)
+	{
+		dst[0] = R < 0? byte(0): src[R];
+		dst[1] = G < 0? byte(0): src[G];
+		dst[2] = B < 0? byte(0): src[B];
+		dst[3] = A < 0? byte(255): src[A];
+	}
+}
+
+template<int R, int G, int A, uint N> void pixelRowPack8(const byte* src, byte* dst, size_t count)
+{
+	for(size_t i = 0; i < count; i++, src += 4, dst += N)
+	{
+		if(R >= 0) dst[R] = src[0];
+		if(G >= 0) dst[G] = src[1];
+		if(A >= 0) dst[A] = src[3];
+	}
+}
+
+//! Яркость по весам BT.601 с суммой 256, чтобы белый оставался белым.
+template<uint N> void pixelRowPackLuminance(const byte* src, byte* dst, size_t count)
+{
+	for(size_t i = 0; i < count; i++, src += 4, dst += N)
+	{
+		dst[0] = byte((77u*src[0] + 150u*src[1] + 29u*src[2] + 128u) >> 8);
+		if(N == 2) dst[1] = src[3];
+	}
+}
+
+void pixelRowUnpackRGB8(const byte* src, byte* dst, size_t count)
+{
+	size_t i = 0;
+#if(INTRA_SIMD_SUPPORT >= INTRA_SIMD_SSE2 && INTRA_SIMD_SUPPORT <= INTRA_SIMD_AVX2)
+	//4 пикселя за итерацию: по 2 пикселя в каждой 64-битной половине, затем раздвигаем их до 4 байт.
+	const __m128i lowMask = _mm_set_epi32(0, 0, 0xFFFF, -1);
+	const __m128i pixel0Mask = _mm_set_epi32(0, 0xFFFFFF, 0, 0xFFFFFF);
+	const __m128i pixel1Mask = _mm_set_epi32(0xFFFFFF, 0, 0xFFFFFF, 0);
+	const __m128i alpha = _mm_set1_epi32(int(0xFF000000u));
+	for(; i + 6 <= count; i += 4)
+	{
+		const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 3*i));
+		const __m128i halves = _mm_or_si128(_mm_and_si128(c, lowMask), _mm_slli_si128(_mm_andnot_si128(lowMask, c), 2));
+		const __m128i pixels = _mm_or_si128(_mm_and_si128(halves, pixel0Mask),
+			_mm_and_si128(_mm_slli_epi64(halves, 8), pixel1Mask));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 4*i), _mm_or_si128(pixels, alpha));
+	}
+#endif
+	pixelRowUnpack8<0, 1, 2, -1, 3>(src + 3*i, dst + 4*i, count - i);
+}
+
+void pixelRowPackRGB8(const byte* src, byte* dst, size_t count)
+{
+	size_t i = 0;
+#if(INTRA_SIMD_SUPPORT >= INTRA_SIMD_SSE2 && INTRA_SIMD_SUPPORT <= INTRA_SIMD_AVX2)
+	//Обратное к pixelRowUnpackRGB8: сдвигаем пиксели внутри 64-битных половин, затем склеиваем половины.
+	const __m128i pixel0Mask = _mm_set_epi32(0, 0xFFFFFF, 0, 0xFFFFFF);
+	const __m128i pixel1Mask = _mm_set_epi32(0xFFFF, int(0xFF000000u), 0xFFFF, int(0xFF000000u));
+	const __m128i lowMask = _mm_set_epi32(0, 0, 0xFFFF, -1);
+	for(; i + 4 <= count; i += 4)
+	{
+		const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 4*i));
+		const __m128i halves = _mm_or_si128(_mm_and_si128(c, pixel0Mask),
+			_mm_and_si128(_mm_srli_epi64(c, 8), pixel1Mask));
+		const __m128i packed = _mm_or_si128(_mm_and_si128(halves, lowMask), _mm_srli_si128(_mm_andnot_si128(lowMask, halves), 2));
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(dst + 3*i), packed);
+		const int tail = _mm_cvtsi128_si32(_mm_srli_si128(packed, 8));
+		C::memcpy(dst + 3*i + 8, &tail, 4);
+	}
+#endif
+	for(; i < count; i++)
+	{
+		dst[3*i] = src[4*i];
+		dst[3*i + 1] = src[4*i + 1];
+		dst[3*i + 2] = src[4*i + 2];
+	}
+}
+
+void pixelRowUnpackRGBA8(const byte* src, byte* dst, size_t count)
+{if(src != dst) C::memcpy(dst, src, count*4);}
+
+void pixelRowUnpackRGBX8(const byte* src, byte* dst, size_t count)
+{
+	size_t i = 0;
+#if(INTRA_SIMD_SUPPORT >= INTRA_SIMD_SSE2 && INTRA_SIMD_SUPPORT <= INTRA_SIMD_AVX2)
+	const __m128i alpha = _mm_set1_epi32(int(0xFF000000u));
+	for(; i + 4 <= count; i += 4)
+	{
+		const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 4*i));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 4*i), _mm_or_si128(c, alpha));
+	}
+#endif
+	pixelRowUnpack8<0, 1, 2, -1, 4>(src + 4*i, dst + 4*i, count - i);
+}
+
+void pixelRowPackRGBX8(const byte* src, byte* dst, size_t count)
+{pixelRowUnpackRGBX8(src, dst, count);}
+
+//! Меняет местами R и B в строке RGBA8. Можно вызывать с src == dst.
+void pixelRowSwapRB(const byte* src, byte* dst, size_t count)
+{
+	size_t i = 0;
+#if(INTRA_SIMD_SUPPORT >= INTRA_SIMD_SSE2 && INTRA_SIMD_SUPPORT <= INTRA_SIMD_AVX2)
+	const __m128i gaMask = _mm_set1_epi32(int(0xFF00FF00u));
+	const __m128i lowMask = _mm_set1_epi32(0xFF);
+	for(; i + 4 <= count; i += 4)
+	{
+		const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 4*i));
+		const __m128i r = _mm_slli_epi32(_mm_and_si128(c, lowMask), 16);
+		const __m128i b = _mm_and_si128(_mm_srli_epi32(c, 16), lowMask);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 4*i), _mm_or_si128(_mm_and_si128(c, gaMask), _mm_or_si128(r, b)));
+	}
+#endif
+	for(; i < count; i++)
+	{
+		const byte r = src[4*i];
+		dst[4*i] = src[4*i + 2];
+		dst[4*i + 1] = src[4*i + 1];
+		dst[4*i + 2] = r;
+		dst[4*i + 3] = src[4*i + 3];
+	}
+}
+
+const PixelRowCodec pixelRowCodecs[] = {
+	{ImageFormat::Red8, pixelRowUnpack8<0, -1, -1, -1, 1>, pixelRowPack8<0, -1, -1, 1>},
+	{ImageFormat::Luminance8, pixelRowUnpack8<0, 0, 0, -1, 1>, pixelRowPackLuminance<1>},
+	{ImageFormat::Alpha8, pixelRowUnpack8<-1, -1, -1, 0, 1>, pixelRowPack8<-1, -1, 0, 1>},
+	{ImageFormat::RG8, pixelRowUnpack8<0, 1, -1, -1, 2>, pixelRowPack8<0, 1, -1, 2>},
+	{ImageFormat::LuminanceAlpha8, pixelRowUnpack8<0, 0, 0, 1, 2>, pixelRowPackLuminance<2>},
+	{ImageFormat::RGB8, pixelRowUnpackRGB8, pixelRowPackRGB8},
+	{ImageFormat::RGBA8, pixelRowUnpackRGBA8, pixelRowUnpackRGBA8},
+	{ImageFormat::RGBX8, pixelRowUnpackRGBX8, pixelRowPackRGBX8},
+	{ImageFormat::RGB565, pixelRowUnpackPacked16<0xF800, 0x7E0, 0x1F, 0>, pixelRowPackPacked16<0xF800, 0x7E0, 0x1F, 0>},
+	{ImageFormat::A1_BGR5, pixelRowUnpackPacked16<0xF800, 0x7C0, 0x3E, 0x1>, pixelRowPackPacked16<0xF800, 0x7C0, 0x3E, 0x1>},
+	{ImageFormat::X1_BGR5, pixelRowUnpackPacked16<0xF800, 0x7C0, 0x3E, 0>, pixelRowPackPacked16<0xF800, 0x7C0, 0x3E, 0>},
+	{ImageFormat::RGB5, pixelRowUnpackPacked16<0x7C00, 0x3E0, 0x1F, 0>, pixelRowPackPacked16<0x7C00, 0x3E0, 0x1F, 0>},
+	{ImageFormat::RGB5A1, pixelRowUnpackPacked16<0x7C00, 0x3E0, 0x1F, 0x8000>, pixelRowPackPacked16<0x7C00, 0x3E0, 0x1F, 0x8000>},
+	{ImageFormat::RGBA4, pixelRowUnpackPacked16<0xF00, 0xF0, 0xF, 0xF000>, pixelRowPackPacked16<0xF00, 0xF0, 0xF, 0xF000>},
+	{ImageFormat::RGBX4, pixelRowUnpackPacked16<0xF00, 0xF0, 0xF, 0>, pixelRowPackPacked16<0xF00, 0xF0, 0xF, 0>}
+};
+
+const PixelRowCodec* pixelRowFindCodec(ImageFormat format)
+{
+	for(auto& codec: pixelRowCodecs)
+		if(codec.Format == format.value) return &codec;
+	return null;
+}
+
+size_t pixelRowLineBytes(size_t usefulBytes, ushort alignment)
+{return (usefulBytes + alignment - 1u) & ~size_t(alignment - 1u);}
+
+template<typename T> void pixelRowSwapTyped(T* data, size_t componentCount, size_t count)
+{
+	for(size_t x = 0; x < count; x++, data += componentCount)
+		Cpp::Swap(data[0], data[2]);
+}
+
+}
+
+bool CanConvertPixelRows(ImageFormat srcFormat, ImageFormat dstFormat)
+{
+	if(srcFormat == dstFormat) return !srcFormat.IsCompressed();
+	return pixelRowFindCodec(srcFormat) != null && pixelRowFindCodec(dstFormat) != null;
+}
+
+void ConvertPixelRow(const byte* src, ImageFormat srcFormat,
+	byte* dst, ImageFormat dstFormat, size_t pixelCount, bool swapRB)
+{
+	if(srcFormat == dstFormat && !swapRB)
+	{
+		if(src != dst) C::memcpy(dst, src, pixelCount*srcFormat.BytesPerPixel());
+		return;
+	}
+	const PixelRowCodec* srcCodec = pixelRowFindCodec(srcFormat);
+	const PixelRowCodec* dstCodec = pixelRowFindCodec(dstFormat);
+	if(srcFormat == dstFormat && srcCodec == null)
+	{
+		//Форматы без кодека (sRGB, знаковые и целочисленные 8-битные, 16- и 32-битные) только копируются с перестановкой каналов
+		if(src != dst) C::memcpy(dst, src, pixelCount*srcFormat.BytesPerPixel());
+		const size_t components = srcFormat.ComponentCount();
+		const auto bytesPerComp = srcFormat.GetComponentType().Size();
+		INTRA_DEBUG_ASSERT(components >= 3);
+		if(bytesPerComp == 1) pixelRowSwapTyped(dst, components, pixelCount);
+		else if(bytesPerComp == 2) pixelRowSwapTyped(reinterpret_cast<ushort*>(dst), components, pixelCount);
+		else if(bytesPerComp == 4) pixelRowSwapTyped(reinterpret_cast<uint*>(dst), components, pixelCount);
+		else INTRA_FATAL_ERROR("ConvertPixelRow не поддерживает перестановку каналов в этом формате!");
+		return;
+	}
+	INTRA_DEBUG_ASSERT(srcCodec != null && dstCodec != null);
+	if(srcCodec == null || dstCodec == null) return;
+
+	const bool srcIsRGBA = srcFormat == ImageFormat::RGBA8;
+	const bool dstIsRGBA = dstFormat == ImageFormat::RGBA8;
+	const size_t srcBpp = srcFormat.BytesPerPixel(), dstBpp = dstFormat.BytesPerPixel();
+	byte tmp[PixelRowChunk*4];
+	for(size_t pos = 0; pos < pixelCount; pos += PixelRowChunk)
+	{
+		const size_t n = Min(size_t(PixelRowChunk), pixelCount - pos);
+		const byte* srcChunk = src + pos*srcBpp;
+		byte* dstChunk = dst + pos*dstBpp;
+		byte* rgba = dstIsRGBA? dstChunk: tmp;
+		const byte* unpacked = srcChunk;
+		if(!srcIsRGBA)
+		{
+			srcCodec->Unpack(srcChunk, rgba, n);
+			unpacked = rgba;
+		}
+		if(swapRB)
 		{
-			Cpp::Swap(data[0], data[2]);
-			data += componentCount;
+			pixelRowSwapRB(unpacked, rgba, n);
+			unpacked = rgba;
 		}
-		data += lineUnused;
+		if(!dstIsRGBA) dstCodec->Pack(unpacked, dstChunk, n);
+		else if(unpacked != dstChunk) C::memcpy(dstChunk, unpacked, n*4);
 	}
 }
 
 void SwapRedBlueChannels(ImageFormat format, ushort lineAlignment, USVec2 sizes, Span<byte> data)
 {
-	const auto components = format.ComponentCount();
-	const auto bytesPerComp = format.GetComponentType().Size();
-	const ushort lineUnusedBytes = ushort(lineAlignment-sizes.x*format.BytesPerPixel()%lineAlignment);
-	INTRA_DEBUG_ASSERT(data.Length() >= size_t(sizes.y*(sizes.x*components+lineUnusedBytes)));
-	if(bytesPerComp==1) SwapRedBlueTyped<byte>(lineUnusedBytes, components, sizes, data.Data());
-	else if(bytesPerComp==2) SwapRedBlueTyped<ushort>(lineUnusedBytes/2u, components, sizes, reinterpret_cast<ushort*>(data.Data()));
-	else if(bytesPerComp==4) SwapRedBlueTyped<uint>(lineUnusedBytes/4u, components, sizes, reinterpret_cast<uint*>(data.Data()));
-	else INTRA_FATAL_ERROR("swap_red_blue пока не поддерживает упакованные форматы!");
+	const size_t lineBytes = pixelRowLineBytes(size_t(sizes.x*format.BytesPerPixel()), lineAlignment);
+	INTRA_DEBUG_ASSERT(data.Length() >= sizes.y*lineBytes);
+	for(size_t y = 0; y < sizes.y; y++)
+	{
+		byte* line = data.Data() + y*lineBytes;
+		ConvertPixelRow(line, format, line, format, sizes.x, true);
+	}
 }
 
-
-
 void ReadPixelDataBlock(IInputStream& stream, USVec2 sizes,
 	ImageFormat srcFormat, ImageFormat dstFormat,
 	bool swapRB, bool flipVert, ushort srcAlignment, ushort dstAlignment, Span<byte> dstBuf)
 {
-	INTRA_DEBUG_ASSERT(srcFormat.ComponentCount()>=3 || !swapRB);
+	INTRA_DEBUG_ASSERT(CanConvertPixelRows(srcFormat, dstFormat));
 	const size_t usefulSrcLineBytes = size_t(sizes.x*srcFormat.BytesPerPixel());
 	const size_t usefulDstLineBytes = size_t(sizes.x*dstFormat.BytesPerPixel());
-	const size_t srcLineBytes = (usefulSrcLineBytes+srcAlignment-1u) & ~size_t(srcAlignment-1u);
-	const size_t dstLineBytes = (usefulDstLineBytes+dstAlignment-1u) & ~size_t(dstAlignment-1u);
+	const size_t srcLineBytes = pixelRowLineBytes(usefulSrcLineBytes, srcAlignment);
+	const size_t dstLineBytes = pixelRowLineBytes(usefulDstLineBytes, dstAlignment);
 	const size_t srcDataSize = sizes.y*srcLineBytes;
-	const size_t dstDataSize = sizes.y*dstLineBytes;
-	INTRA_DEBUG_ASSERT(dstBuf.Length() >= dstDataSize);
-	(void)dstDataSize;
+	INTRA_DEBUG_ASSERT(dstBuf.Length() >= sizes.y*dstLineBytes);
 
-	if(srcFormat==dstFormat && srcLineBytes==dstLineBytes && !swapRB && !flipVert)
+	const bool sameFormat = srcFormat == dstFormat && !swapRB;
+	if(sameFormat && srcLineBytes == dstLineBytes && !flipVert)
 	{
 		RawReadTo(stream, dstBuf.Take(srcDataSize));
 		return;
 	}
 
-	auto dstPos = dstBuf;
-
-	if(srcFormat==dstFormat)
-		for(int y = 0; y<sizes.y; y++)
-		{
-			if(flipVert)
-			{
-				RawReadTo(stream, dstPos.Tail(usefulSrcLineBytes));
-				dstPos.PopLastExactly(dstLineBytes);
-			}
-			else
-			{
-				RawReadTo(stream, dstPos.Take(usefulSrcLineBytes));
-				dstPos.PopFirstExactly(dstLineBytes);
-				//FillZeros(dstPos.Drop(usefulSrcLineBytes));
-			}
-			stream.PopFirstN(srcLineBytes-usefulSrcLineBytes);
-		}
-
-	if(srcFormat==ImageFormat::A1_BGR5 && dstFormat==ImageFormat::RGB8)
-		for(int y=0; y<sizes.y; y++)
-		{
-			auto pixels = !flipVert?
-				reinterpret_cast<UBVec3*>(dstPos.Begin):
-				reinterpret_cast<UBVec3*>(dstPos.End)-sizes.x;
-			for(uint x=0; x<sizes.x; x++)
-			{
-				ushort color = Range::RawRead<ushortLE>(stream);
-				*pixels++ = {(color >> 11) << 3, ((color >> 6) & 0x1f) << 3, ((color >> 1) & 0x1f) << 3};
-			}
-			if(flipVert) dstPos.PopLastExactly(dstLineBytes);
-			else dstPos.PopFirstExactly(dstLineBytes);
-			stream.PopFirstN(srcLineBytes-usefulSrcLineBytes);
-		}
-
-	if(srcFormat==ImageFormat::RGB5A1 && dstFormat==ImageFormat::RGB8)
-		for(int y=0; y<sizes.y; y++)
+	//Строки читаются блоками примерно по 64 КБ и сразу же попадают на своё место в dstBuf:
+	//преобразование формата, перестановка каналов, переворот и выравнивание выполняются за один проход.
+	const size_t blockLines = Max(size_t(1), Min(size_t(sizes.y), (size_t(1) << 16)/Max(srcLineBytes, size_t(1))));
+	Array<byte> block;
+	if(!sameFormat) block.SetCountUninitialized(blockLines*srcLineBytes);
+	for(size_t y = 0; y < sizes.y;)
+	{
+		const size_t lines = Min(blockLines, sizes.y - y);
+		if(!sameFormat) RawReadTo(stream, block.Data(), lines*srcLineBytes);
+		for(size_t i = 0; i < lines; i++, y++)
 		{
-			auto pixels = !flipVert?
-				reinterpret_cast<UBVec3*>(dstPos.Begin):
-				reinterpret_cast<UBVec3*>(dstPos.End)-sizes.x;
-			for(uint x=0; x<sizes.x; x++)
+			byte* dstLine = dstBuf.Data() + (flipVert? sizes.y - 1 - y: y)*dstLineBytes;
+			if(sameFormat)
 			{
-				ushort color = Range::RawRead<ushortLE>(stream);
-				*pixels++ = {((color >> 10) & 0x1f) << 3, ((color >> 5) & 0x1f) << 3, (color & 0x1f) << 3};
+				RawReadTo(stream, dstLine, usefulSrcLineBytes);
+				stream.PopFirstN(srcLineBytes - usefulSrcLineBytes);
 			}
-			if(flipVert) dstPos.PopLastExactly(dstLineBytes);
-			else dstPos.PopFirstExactly(dstLineBytes);
-			stream.PopFirstN(srcLineBytes-usefulSrcLineBytes);
-		}
-
-	if(srcFormat==ImageFormat::RGBA8 && dstFormat==ImageFormat::RGB8)
-		for(int y=0; y<sizes.y; y++)
-		{
-			auto pixels = !flipVert?
-				reinterpret_cast<UBVec3*>(dstPos.Begin):
-				reinterpret_cast<UBVec3*>(dstPos.End)-sizes.x;
-			if(swapRB) for(uint x = 0; x<sizes.x; x++)
-				*pixels++ = Range::RawRead<UBVec4>(stream).swizzle<2, 1, 0>();
-			else for(uint x = 0; x<sizes.x; x++)
-				*pixels++ = Range::RawRead<UBVec4>(stream).xyz;
-			if(flipVert) dstPos.PopLastExactly(dstLineBytes);
-			else dstPos.PopFirstExactly(dstLineBytes);
-			stream.PopFirstN(srcLineBytes-usefulSrcLineBytes);
+			else ConvertPixelRow(block.Data() + i*srcLineBytes, srcFormat, dstLine, dstFormat, sizes.x, swapRB);
+			C::memset(dstLine + usefulDstLineBytes, 0, dstLineBytes - usefulDstLineBytes);
 		}
-
-	if(swapRB) SwapRedBlueChannels(dstFormat, dstAlignment, sizes, dstBuf);
+	}
 }
 
 void ReadPalettedPixelDataBlock(IInputStream& stream, CSpan<byte> palette,
@@ -148,7 +403,7 @@ void ReadPalettedPixelDataBlock(IInputStream& stream, CSpan<byte> palette,
 	const uint usefulDstLineBytes = uint(sizes.x*bytesPerPixel);
 	const uint srcLineBytes = (usefulSrcLineBytes+srcAlignment-1u)&~(srcAlignment-1u);
 	const uint dstLineBytes = (usefulDstLineBytes+dstAlignment-1u)&~(dstAlignment-1u);
-	const size_t dstDataSize = sizes.x*dstLineBytes;
+	const size_t dstDataSize = sizes.y*dstLineBytes;
 
 	byte* pos = dstBuf.Begin;
 	if(flipVert) pos += dstDataSize-dstLineBytes;
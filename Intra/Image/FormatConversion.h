@@ -20,6 +20,16 @@ inline uint ComponentByMask(uint color, uint mask)
 {return (color&mask) >> Math::FindBitPosition(mask);}
 
 uint ConvertColorBits(uint color, uint fromBitCount, uint toBitCount);
+
+//! Поддерживается ли построчное преобразование из srcFormat в dstFormat.
+//! Между разными форматами поддерживаются 8-битные нормализованные и упакованные 16-битные форматы.
+bool CanConvertPixelRows(ImageFormat srcFormat, ImageFormat dstFormat);
+
+//! Преобразовать строку из pixelCount пикселей формата srcFormat в формат dstFormat.
+//! swapRB меняет местами красный и синий каналы. Если размер пикселя не меняется, допускается src == dst.
+void ConvertPixelRow(const byte* src, ImageFormat srcFormat,
+	byte* dst, ImageFormat dstFormat, size_t pixelCount, bool swapRB);
+
 void SwapRedBlueChannels(ImageFormat format, ushort lineAlignment, Math::USVec2 sizes, Span<byte> data);
 
 void ReadPixelDataBlock(IInputStream& stream, Math::USVec2 sizes,
@@ -5,6 +5,7 @@
 #include "Image/AnyImage.h"
 #include "Image/ImageFormat.h"
 #include "Image/ImageInfo.h"
+#include "Image/Resample.h"
 
 #include "Image/Bindings.hh"
 #include "Image/Loaders.hh"
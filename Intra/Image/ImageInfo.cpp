@@ -24,7 +24,7 @@ StringView ToString(ImageType t)
 ushort ImageInfo::CalculateMaxMipmapCount() const
 {
 	ushort maxDimension = Math::Max(Size.x, Size.y);
-	if(Type!=ImageType_2DArray) maxDimension = Math::Max(maxDimension, Size.z);
+	if(Type==ImageType_3D) maxDimension = Math::Max(maxDimension, Size.z);
 	const short maxUncompressedLevel = maxDimension==1? 0: Math::Log2i(Math::Max<uint>(1u, maxDimension));
 	ushort numLevels = ushort(maxUncompressedLevel+1);
 	return Math::Max(numLevels, ushort(0));
@@ -156,13 +156,18 @@ static ImageFormat GetFormat(const DDS_HEADER& header, const DDS_HEADER_DXT10& d
 {
 	if(swapRB!=null) *swapRB=false;
 
-	if( (header.ddspf.flags & DDPF_FOURCC) && dx10header.resourceDimension!=D3D10_RESOURCE_DIMENSION_UNKNOWN)
+	if(header.ddspf.flags & DDPF_FOURCC)
 	{
-		uint fourcc = to_fourcc(header.ddspf.fourCC);
-		if(to_fourcc("DX10"))
+		//Сжатые форматы DX9 задаются только FourCC, без заголовка DX10
+		const uint fourcc = to_fourcc(header.ddspf.fourCC);
+		if(fourcc==to_fourcc("DX10"))
+		{
+			if(dx10header.resourceDimension==D3D10_RESOURCE_DIMENSION_UNKNOWN) return null;
 			return DXGI_ToImageFormat(dx10header.dxgiFormat, swapRB);
+		}
 
 		for(auto& v: FourCC_ImageFormat) if(v.fourcc==fourcc) return v.format;
+		return null;
 	}
 
 	for(auto& fd: D3d9Formats)
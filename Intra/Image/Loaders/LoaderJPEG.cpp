@@ -2,12 +2,1094 @@
 #include "Image/Loaders/LoaderPlatform.h"
 #include "Range/Polymorphic/InputRange.h"
 #include "Image/AnyImage.h"
+#include "Container/Sequential/Array.h"
+#include "Math/Math.h"
+#include "Utils/Unique.h"
 #include "Cpp/Endianess.h"
+#include "Cpp/Intrinsics.h"
+#include "Simd/Simd.h"
 
 namespace Intra { namespace Image {
 
 INTRA_PUSH_DISABLE_REDUNDANT_WARNINGS
 
+namespace {
+
+//! Номер коэффициента в естественном порядке по его номеру в зигзаге.
+//! Хвост из 63 защищает от выхода за границу блока при повреждённых длинах серий.
+const byte jpegZigzag[64 + 16] = {
+	0, 1, 8, 16, 9, 2, 3, 10, 17, 24, 32, 25, 18, 11, 4, 5,
+	12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13, 6, 7, 14, 21, 28,
+	35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+	58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63,
+	63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63
+};
+
+enum: uint {JpegFastBits = 9};
+
+//! Канонический код Хаффмана JPEG, коды записаны начиная со старшего бита.
+//! Fast по старшим JpegFastBits битам входа даёт (длина кода << 8) | значение или 0, если код длиннее.
+//! Более длинные коды ищутся сравнением префиксов с MaxCode каждой длины.
+//! FastAc для таблиц AC сразу декодирует коэффициент, если код вместе с его битами умещается в JpegFastBits бит:
+//! (значение << 8) | (серия нулей << 4) | общая длина или 0.
+struct JpegHuffman
+{
+	ushort Fast[1u << JpegFastBits];
+	short FastAc[1u << JpegFastBits];
+	int MaxCode[17];
+	int ValueOffset[17];
+	byte Values[256];
+	bool Defined;
+};
+
+bool jpegBuildHuffman(JpegHuffman& h, const byte* counts, const byte* values)
+{
+	C::memset(h.Fast, 0, sizeof(h.Fast));
+	uint code = 0, k = 0;
+	for(uint len = 1; len <= 16; len++)
+	{
+		h.ValueOffset[len] = int(k) - int(code);
+		// неравенство Крафта проверяем до заполнения Fast, иначе лишние коды выйдут за границу таблицы
+		if(code + counts[len - 1] > (1u << len)) return false;
+		for(uint i = 0; i < counts[len - 1]; i++, code++, k++)
+		{
+			h.Values[k] = values[k];
+			if(len > JpegFastBits) continue;
+			const uint shift = JpegFastBits - len;
+			for(uint j = 0; j < (1u << shift); j++)
+				h.Fast[(code << shift) + j] = ushort(len << 8 | values[k]);
+		}
+		h.MaxCode[len] = counts[len - 1] != 0? int(code) - 1: -1;
+		code <<= 1;
+	}
+	h.Defined = true;
+
+	for(uint i = 0; i < (1u << JpegFastBits); i++)
+	{
+		h.FastAc[i] = 0;
+		const uint entry = h.Fast[i], len = entry >> 8;
+		const uint run = (entry >> 4) & 15, size = entry & 15;
+		if(entry == 0 || size == 0 || len + size > JpegFastBits) continue;
+		const int bits = int((i << len) & ((1u << JpegFastBits) - 1)) >> (JpegFastBits - size);
+		const int value = bits < (1 << (size - 1))? bits - (1 << size) + 1: bits;
+		if(value >= -128 && value <= 127) h.FastAc[i] = short(value*256 + int(run << 4) + int(len + size));
+	}
+	return true;
+}
+
+//! Чтение энтропийно закодированных данных скана.
+//! Байты 0xFF 0x00 заменяются на 0xFF, на маркере чтение останавливается и дальше подаются нули.
+class JpegBitReader
+{
+public:
+	JpegBitReader(const byte* pos, const byte* end): Pos(pos), End(end), mBits(0), mCount(0), mMarker(0) {}
+
+	const byte* Pos;
+	const byte* End;
+
+	forceinline int Decode(const JpegHuffman& h)
+	{
+		if(mCount < 16) refill();
+		const uint entry = h.Fast[mBits >> (64 - JpegFastBits)];
+		if(entry != 0)
+		{
+			consume(entry >> 8);
+			return int(entry & 255);
+		}
+		const uint peek = uint(mBits >> 48);
+		for(uint len = JpegFastBits + 1; len <= 16; len++)
+		{
+			const int code = int(peek >> (16 - len));
+			if(code > h.MaxCode[len]) continue;
+			consume(len);
+			return h.Values[code + h.ValueOffset[len]];
+		}
+		return -1;
+	}
+
+	//! Посмотреть следующие JpegFastBits бит, не извлекая их.
+	forceinline uint PeekFast()
+	{
+		if(mCount < 16) refill();
+		return uint(mBits >> (64 - JpegFastBits));
+	}
+
+	forceinline void Skip(uint n) {consume(n);}
+
+	forceinline uint GetBits(uint n)
+	{
+		if(n == 0) return 0;
+		if(mCount < int(n)) refill();
+		const uint result = uint(mBits >> (64 - n));
+		consume(n);
+		return result;
+	}
+
+	forceinline uint GetBit() {return GetBits(1);}
+
+	//! Прочитать n бит и восстановить знак разности по правилу EXTEND из стандарта.
+	forceinline int Receive(uint n)
+	{
+		if(n == 0) return 0;
+		const int v = int(GetBits(n));
+		return v < (1 << (n - 1))? v - (1 << n) + 1: v;
+	}
+
+	//! Перейти через маркер RSTn к следующему интервалу перезапуска.
+	void Restart()
+	{
+		mBits = 0;
+		mCount = 0;
+		if(mMarker == 0)
+		{
+			// оставшиеся биты интервала не прочитаны, ищем маркер
+			while(Pos + 1 < End && !(Pos[0] == 0xFF && Pos[1] != 0 && Pos[1] != 0xFF)) Pos++;
+			if(Pos + 1 < End) mMarker = Pos[1];
+		}
+		if(mMarker >= 0xD0 && mMarker <= 0xD7)
+		{
+			Pos += 2;
+			mMarker = 0;
+		}
+	}
+
+private:
+	ulong64 mBits;
+	int mCount;
+	byte mMarker;
+
+	forceinline void consume(uint n)
+	{
+		mBits <<= n;
+		mCount -= int(n);
+	}
+
+	void refill()
+	{
+		if(mMarker == 0 && End - Pos >= 8)
+		{
+			// если среди следующих 8 байт нет 0xFF, добавляем сразу все целые байты.
+			// Младшие биты за mCount получают начало следующего байта - при его дочитывании они совпадут
+			ulong64BE wordBE;
+			C::memcpy(&wordBE, Pos, 8);
+			const ulong64 word = wordBE, inv = ~word;
+			if(((inv - 0x0101010101010101ULL) & ~inv & 0x8080808080808080ULL) == 0)
+			{
+				const uint bytes = uint(64 - mCount) >> 3;
+				mBits |= word >> mCount;
+				mCount += int(bytes*8);
+				Pos += bytes;
+				return;
+			}
+		}
+		while(mCount <= 56)
+		{
+			uint b = 0;
+			if(mMarker == 0 && Pos < End)
+			{
+				b = *Pos;
+				if(b != 0xFF) Pos++;
+				else if(Pos + 1 < End && Pos[1] == 0) Pos += 2;
+				else
+				{
+					mMarker = Pos + 1 < End? Pos[1]: byte(0xD9);
+					b = 0;
+				}
+			}
+			mBits |= ulong64(b) << (56 - mCount);
+			mCount += 8;
+		}
+	}
+};
+
+forceinline byte jpegClampByte(int x) {return byte(x < 0? 0: x > 255? 255: x);}
+
+// Целочисленное ОДКП LLM (как jidctint из libjpeg) с константами, умноженными на 4096.
+// Первый проход по столбцам оставляет 2 дополнительных бита точности, второй проход по строкам прибавляет 128.
+#define JPEG_F2F(x) int((x)*4096 + 0.5)
+
+#define JPEG_IDCT_1D(s0, s1, s2, s3, s4, s5, s6, s7) \
+	int t0, t1, t2, t3, p1, p2, p3, p4, p5, x0, x1, x2, x3; \
+	p1 = (s2 + s6)*JPEG_F2F(0.5411961); \
+	t2 = p1 + s6*JPEG_F2F(-1.847759065); \
+	t3 = p1 + s2*JPEG_F2F(0.765366865); \
+	t0 = (s0 + s4)*4096; \
+	t1 = (s0 - s4)*4096; \
+	x0 = t0 + t3; \
+	x3 = t0 - t3; \
+	x1 = t1 + t2; \
+	x2 = t1 - t2; \
+	t0 = s7; t1 = s5; t2 = s3; t3 = s1; \
+	p3 = t0 + t2; \
+	p4 = t1 + t3; \
+	p1 = t0 + t3; \
+	p2 = t1 + t2; \
+	p5 = (p3 + p4)*JPEG_F2F(1.175875602); \
+	t0 = t0*JPEG_F2F(0.298631336); \
+	t1 = t1*JPEG_F2F(2.053119869); \
+	t2 = t2*JPEG_F2F(3.072711026); \
+	t3 = t3*JPEG_F2F(1.501321110); \
+	p1 = p5 + p1*JPEG_F2F(-0.899976223); \
+	p2 = p5 + p2*JPEG_F2F(-2.562915447); \
+	p3 = p3*JPEG_F2F(-1.961570560); \
+	p4 = p4*JPEG_F2F(-0.390180644); \
+	t3 += p1 + p4; \
+	t2 += p2 + p3; \
+	t1 += p2 + p4; \
+	t0 += p1 + p3;
+
+#if(INTRA_SIMD_SUPPORT >= INTRA_SIMD_SSE2 && INTRA_SIMD_SUPPORT <= INTRA_SIMD_AVX2)
+
+forceinline void jpegTranspose8x8(__m128i& r0, __m128i& r1, __m128i& r2, __m128i& r3,
+	__m128i& r4, __m128i& r5, __m128i& r6, __m128i& r7)
+{
+	const __m128i a0 = _mm_unpacklo_epi16(r0, r1), a1 = _mm_unpackhi_epi16(r0, r1);
+	const __m128i a2 = _mm_unpacklo_epi16(r2, r3), a3 = _mm_unpackhi_epi16(r2, r3);
+	const __m128i a4 = _mm_unpacklo_epi16(r4, r5), a5 = _mm_unpackhi_epi16(r4, r5);
+	const __m128i a6 = _mm_unpacklo_epi16(r6, r7), a7 = _mm_unpackhi_epi16(r6, r7);
+	const __m128i b0 = _mm_unpacklo_epi32(a0, a2), b1 = _mm_unpackhi_epi32(a0, a2);
+	const __m128i b2 = _mm_unpacklo_epi32(a1, a3), b3 = _mm_unpackhi_epi32(a1, a3);
+	const __m128i b4 = _mm_unpacklo_epi32(a4, a6), b5 = _mm_unpackhi_epi32(a4, a6);
+	const __m128i b6 = _mm_unpacklo_epi32(a5, a7), b7 = _mm_unpackhi_epi32(a5, a7);
+	r0 = _mm_unpacklo_epi64(b0, b4); r1 = _mm_unpackhi_epi64(b0, b4);
+	r2 = _mm_unpacklo_epi64(b1, b5); r3 = _mm_unpackhi_epi64(b1, b5);
+	r4 = _mm_unpacklo_epi64(b2, b6); r5 = _mm_unpackhi_epi64(b2, b6);
+	r6 = _mm_unpacklo_epi64(b3, b7); r7 = _mm_unpackhi_epi64(b3, b7);
+}
+
+forceinline __m128i jpegPairConst(int a, int b)
+{return _mm_setr_epi16(short(a), short(b), short(a), short(b), short(a), short(b), short(a), short(b));}
+
+//! Повороты на парах (x, y) через pmaddwd: out0 = x*c0.a + y*c0.b, out1 = x*c1.a + y*c1.b в 32 битах.
+struct JpegRot
+{
+	__m128i Lo0, Hi0, Lo1, Hi1;
+
+	forceinline JpegRot(__m128i x, __m128i y, __m128i c0, __m128i c1)
+	{
+		const __m128i xyLo = _mm_unpacklo_epi16(x, y), xyHi = _mm_unpackhi_epi16(x, y);
+		Lo0 = _mm_madd_epi16(xyLo, c0); Hi0 = _mm_madd_epi16(xyHi, c0);
+		Lo1 = _mm_madd_epi16(xyLo, c1); Hi1 = _mm_madd_epi16(xyHi, c1);
+	}
+};
+
+//! Одномерное ОДКП восьми векторов. Каждый 16-битный канал - отдельное независимое преобразование.
+forceinline void jpegIdctPass(__m128i& r0, __m128i& r1, __m128i& r2, __m128i& r3,
+	__m128i& r4, __m128i& r5, __m128i& r6, __m128i& r7, __m128i bias, int shift)
+{
+	const __m128i rot00 = jpegPairConst(JPEG_F2F(0.5411961), JPEG_F2F(0.5411961) + JPEG_F2F(-1.847759065));
+	const __m128i rot01 = jpegPairConst(JPEG_F2F(0.5411961) + JPEG_F2F(0.765366865), JPEG_F2F(0.5411961));
+	const __m128i rot10 = jpegPairConst(JPEG_F2F(1.175875602) + JPEG_F2F(-0.899976223), JPEG_F2F(1.175875602));
+	const __m128i rot11 = jpegPairConst(JPEG_F2F(1.175875602), JPEG_F2F(1.175875602) + JPEG_F2F(-2.562915447));
+	const __m128i rot20 = jpegPairConst(JPEG_F2F(-1.961570560) + JPEG_F2F(0.298631336), JPEG_F2F(-1.961570560));
+	const __m128i rot21 = jpegPairConst(JPEG_F2F(-1.961570560), JPEG_F2F(-1.961570560) + JPEG_F2F(3.072711026));
+	const __m128i rot30 = jpegPairConst(JPEG_F2F(-0.390180644) + JPEG_F2F(2.053119869), JPEG_F2F(-0.390180644));
+	const __m128i rot31 = jpegPairConst(JPEG_F2F(-0.390180644), JPEG_F2F(-0.390180644) + JPEG_F2F(1.501321110));
+	const __m128i zero = _mm_setzero_si128();
+
+	// чётная часть
+	const JpegRot e(r2, r6, rot00, rot01);
+	const __m128i sum04 = _mm_add_epi16(r0, r4), dif04 = _mm_sub_epi16(r0, r4);
+	// (a << 16) >> 4 расширяет до 32 бит с умножением на 4096
+	const __m128i sum04Lo = _mm_srai_epi32(_mm_unpacklo_epi16(zero, sum04), 4);
+	const __m128i sum04Hi = _mm_srai_epi32(_mm_unpackhi_epi16(zero, sum04), 4);
+	const __m128i dif04Lo = _mm_srai_epi32(_mm_unpacklo_epi16(zero, dif04), 4);
+	const __m128i dif04Hi = _mm_srai_epi32(_mm_unpackhi_epi16(zero, dif04), 4);
+	const __m128i x0Lo = _mm_add_epi32(sum04Lo, e.Lo1), x0Hi = _mm_add_epi32(sum04Hi, e.Hi1);
+	const __m128i x3Lo = _mm_sub_epi32(sum04Lo, e.Lo1), x3Hi = _mm_sub_epi32(sum04Hi, e.Hi1);
+	const __m128i x1Lo = _mm_add_epi32(dif04Lo, e.Lo0), x1Hi = _mm_add_epi32(dif04Hi, e.Hi0);
+	const __m128i x2Lo = _mm_sub_epi32(dif04Lo, e.Lo0), x2Hi = _mm_sub_epi32(dif04Hi, e.Hi0);
+
+	// нечётная часть
+	const JpegRot o73(r7, r3, rot20, rot21);
+	const JpegRot o51(r5, r1, rot30, rot31);
+	const JpegRot o(_mm_add_epi16(r1, r7), _mm_add_epi16(r3, r5), rot10, rot11);
+	const __m128i x4Lo = _mm_add_epi32(o73.Lo0, o.Lo0), x4Hi = _mm_add_epi32(o73.Hi0, o.Hi0);
+	const __m128i x5Lo = _mm_add_epi32(o51.Lo0, o.Lo1), x5Hi = _mm_add_epi32(o51.Hi0, o.Hi1);
+	const __m128i x6Lo = _mm_add_epi32(o73.Lo1, o.Lo1), x6Hi = _mm_add_epi32(o73.Hi1, o.Hi1);
+	const __m128i x7Lo = _mm_add_epi32(o51.Lo1, o.Lo0), x7Hi = _mm_add_epi32(o51.Hi1, o.Hi0);
+
+#define JPEG_BUTTERFLY(out0, out1, a, b) { \
+	const __m128i aLo = _mm_add_epi32(a ## Lo, bias), aHi = _mm_add_epi32(a ## Hi, bias); \
+	out0 = _mm_packs_epi32(_mm_srai_epi32(_mm_add_epi32(aLo, b ## Lo), shift), _mm_srai_epi32(_mm_add_epi32(aHi, b ## Hi), shift)); \
+	out1 = _mm_packs_epi32(_mm_srai_epi32(_mm_sub_epi32(aLo, b ## Lo), shift), _mm_srai_epi32(_mm_sub_epi32(aHi, b ## Hi), shift)); }
+	JPEG_BUTTERFLY(r0, r7, x0, x7)
+	JPEG_BUTTERFLY(r1, r6, x1, x6)
+	JPEG_BUTTERFLY(r2, r5, x2, x5)
+	JPEG_BUTTERFLY(r3, r4, x3, x4)
+#undef JPEG_BUTTERFLY
+}
+
+void jpegIdct8x8(const short* coefs, byte* dst, size_t stride)
+{
+	__m128i r0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(coefs));
+	__m128i r1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(coefs + 8));
+	__m128i r2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(coefs + 16));
+	__m128i r3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(coefs + 24));
+	__m128i r4 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(coefs + 32));
+	__m128i r5 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(coefs + 40));
+	__m128i r6 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(coefs + 48));
+	__m128i r7 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(coefs + 56));
+
+	// строки векторов - это строки блока, поэтому первый проход идёт сразу по всем столбцам
+	jpegIdctPass(r0, r1, r2, r3, r4, r5, r6, r7, _mm_set1_epi32(512), 10);
+	jpegTranspose8x8(r0, r1, r2, r3, r4, r5, r6, r7);
+	jpegIdctPass(r0, r1, r2, r3, r4, r5, r6, r7, _mm_set1_epi32(65536 + (128 << 17)), 17);
+	jpegTranspose8x8(r0, r1, r2, r3, r4, r5, r6, r7);
+
+	const __m128i p01 = _mm_packus_epi16(r0, r1), p23 = _mm_packus_epi16(r2, r3);
+	const __m128i p45 = _mm_packus_epi16(r4, r5), p67 = _mm_packus_epi16(r6, r7);
+	_mm_storel_epi64(reinterpret_cast<__m128i*>(dst), p01);
+	_mm_storel_epi64(reinterpret_cast<__m128i*>(dst + stride), _mm_srli_si128(p01, 8));
+	_mm_storel_epi64(reinterpret_cast<__m128i*>(dst + 2*stride), p23);
+	_mm_storel_epi64(reinterpret_cast<__m128i*>(dst + 3*stride), _mm_srli_si128(p23, 8));
+	_mm_storel_epi64(reinterpret_cast<__m128i*>(dst + 4*stride), p45);
+	_mm_storel_epi64(reinterpret_cast<__m128i*>(dst + 5*stride), _mm_srli_si128(p45, 8));
+	_mm_storel_epi64(reinterpret_cast<__m128i*>(dst + 6*stride), p67);
+	_mm_storel_epi64(reinterpret_cast<__m128i*>(dst + 7*stride), _mm_srli_si128(p67, 8));
+}
+
+#else
+
+void jpegIdct8x8(const short* coefs, byte* dst, size_t stride)
+{
+	int tmp[64];
+	for(int i = 0; i < 8; i++)
+	{
+		const short* const d = coefs + i;
+		int* const v = tmp + i;
+		JPEG_IDCT_1D(d[0], d[8], d[16], d[24], d[32], d[40], d[48], d[56])
+		x0 += 512; x1 += 512; x2 += 512; x3 += 512;
+		v[0] = (x0 + t3) >> 10; v[56] = (x0 - t3) >> 10;
+		v[8] = (x1 + t2) >> 10; v[48] = (x1 - t2) >> 10;
+		v[16] = (x2 + t1) >> 10; v[40] = (x2 - t1) >> 10;
+		v[24] = (x3 + t0) >> 10; v[32] = (x3 - t0) >> 10;
+	}
+	for(int i = 0; i < 8; i++, dst += stride)
+	{
+		const int* const v = tmp + i*8;
+		JPEG_IDCT_1D(v[0], v[1], v[2], v[3], v[4], v[5], v[6], v[7])
+		const int bias = 65536 + (128 << 17);
+		x0 += bias; x1 += bias; x2 += bias; x3 += bias;
+		dst[0] = jpegClampByte((x0 + t3) >> 17); dst[7] = jpegClampByte((x0 - t3) >> 17);
+		dst[1] = jpegClampByte((x1 + t2) >> 17); dst[6] = jpegClampByte((x1 - t2) >> 17);
+		dst[2] = jpegClampByte((x2 + t1) >> 17); dst[5] = jpegClampByte((x2 - t1) >> 17);
+		dst[3] = jpegClampByte((x3 + t0) >> 17); dst[4] = jpegClampByte((x3 - t0) >> 17);
+	}
+}
+
+#endif
+
+#undef JPEG_IDCT_1D
+#undef JPEG_F2F
+
+//! Базисы уменьшенных ОДКП: Basis[n][x*8 + u] - среднее c(u)/2*cos((2k + 1)uπ/16) по 8/n отсчётам k, попадающим в отсчёт x,
+//! умноженное на 4096. Результат совпадает с усреднением полного ОДКП по квадратам 8/n x 8/n без вычисления всех 64 отсчётов.
+struct JpegReducedBases
+{
+	int Basis1[8], Basis2[16], Basis4[32], Basis8[64];
+	const int* Basis[9];
+
+	JpegReducedBases()
+	{
+		fill(Basis1, 1);
+		fill(Basis2, 2);
+		fill(Basis4, 4);
+		fill(Basis8, 8);
+		Basis[1] = Basis1;
+		Basis[2] = Basis2;
+		Basis[4] = Basis4;
+		Basis[8] = Basis8;
+	}
+
+	static void fill(int* basis, int n)
+	{
+		const int step = 8/n;
+		for(int x = 0; x < n; x++)
+			for(int u = 0; u < 8; u++)
+			{
+				double sum = 0;
+				for(int k = x*step; k < (x + 1)*step; k++)
+					sum += Math::Cos((2*k + 1)*u*3.14159265358979324/16);
+				const double cu = u == 0? 0.70710678118654752: 1.0;
+				basis[x*8 + u] = int(Math::Floor(cu/2*sum/step*4096 + 0.5));
+			}
+	}
+};
+
+//! Восстановить блок width x height (1, 2, 4 или 8 по каждому направлению) из коэффициентов блока 8x8.
+void jpegIdctReduced(const short* coefs, byte* dst, size_t stride, uint width, uint height)
+{
+	static const JpegReducedBases bases;
+	const int* const basisX = bases.Basis[width];
+	const int* const basisY = bases.Basis[height];
+	// строки коэффициентов обычно в основном нулевые, пропускаем их в обоих проходах
+	int tmp[8][8];
+	uint rows[8], rowCount = 0;
+	for(uint v = 0; v < 8; v++)
+	{
+		const short* const row = coefs + v*8;
+		if((row[0] | row[1] | row[2] | row[3] | row[4] | row[5] | row[6] | row[7]) == 0) continue;
+		rows[rowCount++] = v;
+		for(uint x = 0; x < width; x++)
+		{
+			int sum = 0;
+			for(uint u = 0; u < 8; u++) sum += basisX[x*8 + u]*row[u];
+			tmp[v][x] = (sum + 512) >> 10;
+		}
+	}
+	for(uint y = 0; y < height; y++, dst += stride)
+		for(uint x = 0; x < width; x++)
+		{
+			long64 sum = 0;
+			for(uint i = 0; i < rowCount; i++) sum += long64(basisY[y*8 + rows[i]])*tmp[rows[i]][x];
+			dst[x] = jpegClampByte(int((sum + (1 << 13)) >> 14) + 128);
+		}
+}
+
+//! Преобразование строки YCbCr в RGB с коэффициентами JFIF в 16-битной фиксированной точке.
+//! Скалярная версия повторяет арифметику векторной до бита.
+void jpegYCbCrToRGB(const byte* yRow, const byte* cbRow, const byte* crRow, byte* dst, uint count)
+{
+	enum: int {CrToR = 11485, CbToB = 14516, CbToG = -2819, CrToG = -5850};
+	uint i = 0;
+#if(INTRA_SIMD_SUPPORT >= INTRA_SIMD_SSE2 && INTRA_SIMD_SUPPORT <= INTRA_SIMD_AVX2)
+	const __m128i zero = _mm_setzero_si128(), bias128 = _mm_set1_epi16(128), round = _mm_set1_epi16(8);
+	const __m128i crToR = _mm_set1_epi16(CrToR), cbToB = _mm_set1_epi16(CbToB);
+	const __m128i cbToG = _mm_set1_epi16(CbToG), crToG = _mm_set1_epi16(CrToG);
+	alignas(16) uint rgbx[16];
+	// каждый пиксель пишется 4 байтами RGBX, X затирается следующим пикселем, поэтому после группы нужен ещё один пиксель
+	for(; i + 17 <= count; i += 16, dst += 48)
+	{
+		const __m128i y8 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(yRow + i));
+		const __m128i cb8 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cbRow + i));
+		const __m128i cr8 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(crRow + i));
+		__m128i rgb[3][2];
+		for(int half = 0; half < 2; half++)
+		{
+			const __m128i y16 = half == 0? _mm_unpacklo_epi8(y8, zero): _mm_unpackhi_epi8(y8, zero);
+			const __m128i cb16 = half == 0? _mm_unpacklo_epi8(cb8, zero): _mm_unpackhi_epi8(cb8, zero);
+			const __m128i cr16 = half == 0? _mm_unpacklo_epi8(cr8, zero): _mm_unpackhi_epi8(cr8, zero);
+			const __m128i y4 = _mm_add_epi16(_mm_slli_epi16(y16, 4), round);
+			const __m128i cb7 = _mm_slli_epi16(_mm_sub_epi16(cb16, bias128), 7);
+			const __m128i cr7 = _mm_slli_epi16(_mm_sub_epi16(cr16, bias128), 7);
+			rgb[0][half] = _mm_srai_epi16(_mm_add_epi16(y4, _mm_mulhi_epi16(cr7, crToR)), 4);
+			rgb[1][half] = _mm_srai_epi16(_mm_add_epi16(_mm_add_epi16(y4,
+				_mm_mulhi_epi16(cb7, cbToG)), _mm_mulhi_epi16(cr7, crToG)), 4);
+			rgb[2][half] = _mm_srai_epi16(_mm_add_epi16(y4, _mm_mulhi_epi16(cb7, cbToB)), 4);
+		}
+		const __m128i r = _mm_packus_epi16(rgb[0][0], rgb[0][1]);
+		const __m128i g = _mm_packus_epi16(rgb[1][0], rgb[1][1]);
+		const __m128i b = _mm_packus_epi16(rgb[2][0], rgb[2][1]);
+		const __m128i rgLo = _mm_unpacklo_epi8(r, g), rgHi = _mm_unpackhi_epi8(r, g);
+		const __m128i bxLo = _mm_unpacklo_epi8(b, zero), bxHi = _mm_unpackhi_epi8(b, zero);
+		_mm_store_si128(reinterpret_cast<__m128i*>(rgbx), _mm_unpacklo_epi16(rgLo, bxLo));
+		_mm_store_si128(reinterpret_cast<__m128i*>(rgbx + 4), _mm_unpackhi_epi16(rgLo, bxLo));
+		_mm_store_si128(reinterpret_cast<__m128i*>(rgbx + 8), _mm_unpacklo_epi16(rgHi, bxHi));
+		_mm_store_si128(reinterpret_cast<__m128i*>(rgbx + 12), _mm_unpackhi_epi16(rgHi, bxHi));
+		for(int j = 0; j < 16; j++) C::memcpy(dst + 3*j, rgbx + j, 4);
+	}
+#endif
+	for(; i < count; i++, dst += 3)
+	{
+		const int y4 = (yRow[i] << 4) + 8;
+		const int cb7 = (cbRow[i] - 128) << 7, cr7 = (crRow[i] - 128) << 7;
+		dst[0] = jpegClampByte((y4 + ((cr7*CrToR) >> 16)) >> 4);
+		dst[1] = jpegClampByte((y4 + ((cb7*CbToG) >> 16) + ((cr7*CrToG) >> 16)) >> 4);
+		dst[2] = jpegClampByte((y4 + ((cb7*CbToB) >> 16)) >> 4);
+	}
+}
+
+struct JpegComponent
+{
+	byte Id, H, V, QuantTable;
+	byte DcTable, AcTable;
+
+	//! Число блоков в плоскости с дополнением до целого числа MCU.
+	uint BlocksX, BlocksY;
+
+	//! Размер восстановленного блока в отсчётах. При уменьшении прореженные компоненты
+	//! восстанавливаются более крупными блоками, чтобы не увеличивать их потом.
+	uint BlockW, BlockH;
+
+	//! Во сколько раз нужно увеличить плоскость, чтобы получить размер изображения.
+	uint UpsampleH, UpsampleV;
+
+	//! Размер компоненты в отсчётах без учёта масштаба.
+	uint Width, Height;
+
+	int DcPredictor;
+
+	//! Декодированные отсчёты: по BlockW x BlockH на блок.
+	Array<byte> Plane;
+	size_t PlaneStride;
+
+	//! Коэффициенты прогрессивного JPEG в естественном порядке без деквантования, по 64 на блок.
+	Array<short> Coefs;
+};
+
+class JpegDecoder
+{
+public:
+	JpegDecoder(uint scaleLog): mScaleLog(scaleLog) {}
+
+	AnyImage Decode(CSpan<byte> file, ushort lineAlignment);
+
+private:
+	JpegHuffman mDcTables[4], mAcTables[4];
+	ushort mQuant[4][64];
+	JpegComponent mComps[3];
+	uint mCompCount = 0;
+	uint mWidth = 0, mHeight = 0, mHmax = 1, mVmax = 1, mMcusX = 0, mMcusY = 0;
+	uint mRestartInterval = 0;
+	bool mProgressive = false, mFrameRead = false, mAnyScan = false;
+	int mAdobeTransform = -1;
+	const uint mScaleLog;
+
+	// параметры текущего скана
+	JpegComponent* mScanComps[3];
+	uint mScanCompCount = 0;
+	uint mSpectralStart = 0, mSpectralEnd = 63, mApproxHigh = 0, mApproxLow = 0;
+	uint mEobRun = 0;
+
+	bool readFrame(const byte* seg, size_t len);
+	bool readHuffmanTables(const byte* seg, size_t len);
+	bool readQuantTables(const byte* seg, size_t len);
+	const byte* readScan(const byte* seg, size_t len, const byte* data, const byte* end);
+
+	bool decodeBlock(JpegBitReader& reader, JpegComponent& c, uint bx, uint by);
+	bool decodeBaselineBlock(JpegBitReader& reader, JpegComponent& c, short* block);
+	bool decodeDcProgressive(JpegBitReader& reader, JpegComponent& c, short* block);
+	bool decodeAcFirst(JpegBitReader& reader, JpegComponent& c, short* block);
+	bool decodeAcRefine(JpegBitReader& reader, JpegComponent& c, short* block);
+
+	void idct(const short* coefs, JpegComponent& c, uint bx, uint by) const;
+	void finishProgressive();
+	AnyImage output(ushort lineAlignment);
+};
+
+bool JpegDecoder::readFrame(const byte* seg, size_t len)
+{
+	if(mFrameRead || len < 6 || seg[0] != 8) return false;
+	mHeight = uint(seg[1] << 8 | seg[2]);
+	mWidth = uint(seg[3] << 8 | seg[4]);
+	mCompCount = seg[5];
+	// высота из маркера DNL и CMYK не поддерживаются
+	if(mWidth == 0 || mHeight == 0 || (mCompCount != 1 && mCompCount != 3) || len < 6 + 3*mCompCount) return false;
+	for(uint i = 0; i < mCompCount; i++)
+	{
+		JpegComponent& c = mComps[i];
+		c.Id = seg[6 + 3*i];
+		c.H = byte(seg[7 + 3*i] >> 4);
+		c.V = byte(seg[7 + 3*i] & 15);
+		c.QuantTable = seg[8 + 3*i];
+		if(c.H == 0 || c.H > 4 || c.V == 0 || c.V > 4 || c.QuantTable > 3) return false;
+		mHmax = Math::Max<uint>(mHmax, c.H);
+		mVmax = Math::Max<uint>(mVmax, c.V);
+	}
+	// для единственной компоненты MCU - один блок
+	if(mCompCount == 1)
+	{
+		mComps[0].H = mComps[0].V = 1;
+		mHmax = mVmax = 1;
+	}
+
+	mMcusX = (mWidth + 8*mHmax - 1)/(8*mHmax);
+	mMcusY = (mHeight + 8*mVmax - 1)/(8*mVmax);
+	for(uint i = 0; i < mCompCount; i++)
+	{
+		JpegComponent& c = mComps[i];
+		if(mHmax % c.H != 0 || mVmax % c.V != 0) return false;
+		c.BlocksX = mMcusX*c.H;
+		c.BlocksY = mMcusY*c.V;
+		c.Width = (mWidth*c.H + mHmax - 1)/mHmax;
+		c.Height = (mHeight*c.V + mVmax - 1)/mVmax;
+		c.UpsampleH = mHmax/c.H;
+		c.UpsampleV = mVmax/c.V;
+		c.BlockW = c.BlockH = 8u >> mScaleLog;
+		for(; c.BlockW < 8 && c.UpsampleH % 2 == 0; c.UpsampleH /= 2) c.BlockW *= 2;
+		for(; c.BlockH < 8 && c.UpsampleV % 2 == 0; c.UpsampleV /= 2) c.BlockH *= 2;
+		c.PlaneStride = size_t(c.BlocksX)*c.BlockW;
+		c.Plane.SetCount(c.PlaneStride*c.BlocksY*c.BlockH);
+		if(mProgressive) c.Coefs.SetCount(size_t(c.BlocksX)*c.BlocksY*64);
+	}
+	mFrameRead = true;
+	return true;
+}
+
+bool JpegDecoder::readHuffmanTables(const byte* seg, size_t len)
+{
+	while(len >= 17)
+	{
+		const uint tableClass = seg[0] >> 4, index = seg[0] & 15u;
+		if(tableClass > 1 || index > 3) return false;
+		uint count = 0;
+		for(uint i = 0; i < 16; i++) count += seg[1 + i];
+		if(count > 256 || len < 17 + count) return false;
+		JpegHuffman& h = tableClass == 0? mDcTables[index]: mAcTables[index];
+		if(!jpegBuildHuffman(h, seg + 1, seg + 17)) return false;
+		seg += 17 + count;
+		len -= 17 + count;
+	}
+	return len == 0;
+}
+
+bool JpegDecoder::readQuantTables(const byte* seg, size_t len)
+{
+	while(len >= 65)
+	{
+		const uint precision = seg[0] >> 4, index = seg[0] & 15u;
+		const size_t size = 1 + 64*(precision + 1);
+		if(precision > 1 || index > 3 || len < size) return false;
+		for(uint k = 0; k < 64; k++)
+			mQuant[index][jpegZigzag[k]] = ushort(precision? seg[1 + 2*k] << 8 | seg[2 + 2*k]: seg[1 + k]);
+		seg += size;
+		len -= size;
+	}
+	return len == 0;
+}
+
+void JpegDecoder::idct(const short* coefs, JpegComponent& c, uint bx, uint by) const
+{
+	byte* const dst = c.Plane.Data() + by*c.BlockH*c.PlaneStride + bx*c.BlockW;
+	if(c.BlockW == 8 && c.BlockH == 8) jpegIdct8x8(coefs, dst, c.PlaneStride);
+	else if(c.BlockW == 1 && c.BlockH == 1) *dst = jpegClampByte(((coefs[0] + 4) >> 3) + 128);
+	else jpegIdctReduced(coefs, dst, c.PlaneStride, c.BlockW, c.BlockH);
+}
+
+bool JpegDecoder::decodeBaselineBlock(JpegBitReader& reader, JpegComponent& c, short* block)
+{
+	const JpegHuffman& dc = mDcTables[c.DcTable];
+	const JpegHuffman& ac = mAcTables[c.AcTable];
+	const ushort* const quant = mQuant[c.QuantTable];
+	const int t = reader.Decode(dc);
+	if(t < 0 || t > 16) return false;
+	c.DcPredictor += reader.Receive(uint(t));
+	block[0] = short(c.DcPredictor*quant[0]);
+	for(uint k = 1; k < 64; k++)
+	{
+		const int fast = ac.FastAc[reader.PeekFast()];
+		if(fast != 0)
+		{
+			reader.Skip(uint(fast) & 15);
+			k += (uint(fast) >> 4) & 15;
+			if(k > 63) return false;
+			const uint n = jpegZigzag[k];
+			block[n] = short((fast >> 8)*quant[n]);
+			continue;
+		}
+		const int rs = reader.Decode(ac);
+		if(rs < 0) return false;
+		const uint run = uint(rs) >> 4, size = uint(rs) & 15;
+		if(size == 0)
+		{
+			if(run != 15) break;
+			k += 15;
+			continue;
+		}
+		k += run;
+		if(k > 63) return false;
+		const uint n = jpegZigzag[k];
+		block[n] = short(reader.Receive(size)*quant[n]);
+	}
+	return true;
+}
+
+bool JpegDecoder::decodeDcProgressive(JpegBitReader& reader, JpegComponent& c, short* block)
+{
+	if(mApproxHigh != 0)
+	{
+		if(reader.GetBit()) block[0] = short(block[0] | (1 << mApproxLow));
+		return true;
+	}
+	const int t = reader.Decode(mDcTables[c.DcTable]);
+	if(t < 0 || t > 16) return false;
+	c.DcPredictor += reader.Receive(uint(t));
+	block[0] = short(c.DcPredictor*(1 << mApproxLow));
+	return true;
+}
+
+bool JpegDecoder::decodeAcFirst(JpegBitReader& reader, JpegComponent& c, short* block)
+{
+	if(mEobRun != 0)
+	{
+		mEobRun--;
+		return true;
+	}
+	const JpegHuffman& ac = mAcTables[c.AcTable];
+	for(uint k = mSpectralStart; k <= mSpectralEnd; k++)
+	{
+		const int fast = ac.FastAc[reader.PeekFast()];
+		if(fast != 0)
+		{
+			reader.Skip(uint(fast) & 15);
+			k += (uint(fast) >> 4) & 15;
+			if(k > mSpectralEnd) return false;
+			block[jpegZigzag[k]] = short((fast >> 8)*(1 << mApproxLow));
+			continue;
+		}
+		const int rs = reader.Decode(ac);
+		if(rs < 0) return false;
+		const uint run = uint(rs) >> 4, size = uint(rs) & 15;
+		if(size == 0)
+		{
+			if(run < 15)
+			{
+				// серия пустых блоков, текущий входит в неё
+				mEobRun = (1u << run) - 1 + reader.GetBits(run);
+				break;
+			}
+			k += 15;
+			continue;
+		}
+		k += run;
+		if(k > mSpectralEnd) return false;
+		block[jpegZigzag[k]] = short(reader.Receive(size)*(1 << mApproxLow));
+	}
+	return true;
+}
+
+bool JpegDecoder::decodeAcRefine(JpegBitReader& reader, JpegComponent& c, short* block)
+{
+	// уточнение: уже ненулевые коэффициенты получают по биту, новые коэффициенты равны ±1 << Al
+	const int plus = 1 << mApproxLow, minus = -plus;
+	const JpegHuffman& ac = mAcTables[c.AcTable];
+	auto refine = [&](short& coef)
+	{
+		if(reader.GetBit() && (coef & plus) == 0)
+			coef = short(coef + (coef >= 0? plus: minus));
+	};
+	uint k = mSpectralStart;
+	if(mEobRun == 0)
+	{
+		for(; k <= mSpectralEnd; k++)
+		{
+			const int rs = reader.Decode(ac);
+			if(rs < 0) return false;
+			int run = rs >> 4;
+			const uint size = uint(rs) & 15;
+			int value = 0;
+			if(size != 0)
+			{
+				if(size != 1) return false;
+				value = reader.GetBit()? plus: minus;
+			}
+			else if(run != 15)
+			{
+				mEobRun = (1u << run) + reader.GetBits(uint(run));
+				break;
+			}
+			// пропускаем run нулевых коэффициентов, уточняя встреченные ненулевые
+			for(; k <= mSpectralEnd; k++)
+			{
+				short& coef = block[jpegZigzag[k]];
+				if(coef != 0) refine(coef);
+				else if(--run < 0) break;
+			}
+			if(value != 0 && k <= mSpectralEnd) block[jpegZigzag[k]] = short(value);
+		}
+	}
+	if(mEobRun != 0)
+	{
+		for(; k <= mSpectralEnd; k++)
+		{
+			short& coef = block[jpegZigzag[k]];
+			if(coef != 0) refine(coef);
+		}
+		mEobRun--;
+	}
+	return true;
+}
+
+bool JpegDecoder::decodeBlock(JpegBitReader& reader, JpegComponent& c, uint bx, uint by)
+{
+	if(!mProgressive)
+	{
+		alignas(16) short block[64] = {};
+		if(!decodeBaselineBlock(reader, c, block)) return false;
+		idct(block, c, bx, by);
+		return true;
+	}
+	short* const block = c.Coefs.Data() + (size_t(by)*c.BlocksX + bx)*64;
+	if(mSpectralStart == 0) return decodeDcProgressive(reader, c, block);
+	if(mApproxHigh == 0) return decodeAcFirst(reader, c, block);
+	return decodeAcRefine(reader, c, block);
+}
+
+const byte* JpegDecoder::readScan(const byte* seg, size_t len, const byte* data, const byte* end)
+{
+	if(!mFrameRead || len < 1) return null;
+	mScanCompCount = seg[0];
+	if(mScanCompCount < 1 || mScanCompCount > mCompCount || len != 4 + 2*mScanCompCount) return null;
+	for(uint i = 0; i < mScanCompCount; i++)
+	{
+		const byte id = seg[1 + 2*i], tables = seg[2 + 2*i];
+		JpegComponent* comp = null;
+		for(uint j = 0; j < mCompCount; j++) if(mComps[j].Id == id) comp = &mComps[j];
+		if(comp == null || (tables >> 4) > 3 || (tables & 15) > 3) return null;
+		comp->DcTable = byte(tables >> 4);
+		comp->AcTable = byte(tables & 15);
+		mScanComps[i] = comp;
+	}
+	const byte* const params = seg + 1 + 2*mScanCompCount;
+	mSpectralStart = params[0];
+	mSpectralEnd = params[1];
+	mApproxHigh = uint(params[2] >> 4);
+	mApproxLow = params[2] & 15u;
+	if(mProgressive)
+	{
+		if(mSpectralStart > mSpectralEnd || mSpectralEnd > 63 || mApproxLow > 13 ||
+			(mSpectralStart == 0 && mSpectralEnd != 0) || (mSpectralStart != 0 && mScanCompCount != 1)) return null;
+	}
+	else
+	{
+		mSpectralStart = 0;
+		mSpectralEnd = 63;
+		mApproxHigh = mApproxLow = 0;
+	}
+
+	// используемые таблицы Хаффмана должны быть определены
+	for(uint i = 0; i < mScanCompCount; i++)
+	{
+		const JpegComponent& c = *mScanComps[i];
+		const bool needDc = mSpectralStart == 0 && mApproxHigh == 0, needAc = mSpectralEnd != 0;
+		if((needDc && !mDcTables[c.DcTable].Defined) || (needAc && !mAcTables[c.AcTable].Defined)) return null;
+	}
+
+	JpegBitReader reader(data, end);
+	for(uint i = 0; i < mScanCompCount; i++) mScanComps[i]->DcPredictor = 0;
+	mEobRun = 0;
+
+	// в скане с одной компонентой каждый её блок - отдельный MCU, блоки вне изображения не кодируются
+	const bool single = mScanCompCount == 1;
+	const uint unitsX = single? (mScanComps[0]->Width + 7)/8: mMcusX;
+	const uint unitsY = single? (mScanComps[0]->Height + 7)/8: mMcusY;
+	uint restartsLeft = mRestartInterval;
+	for(uint uy = 0; uy < unitsY; uy++)
+	{
+		for(uint ux = 0; ux < unitsX; ux++)
+		{
+			if(single)
+			{
+				if(!decodeBlock(reader, *mScanComps[0], ux, uy)) return null;
+			}
+			else for(uint i = 0; i < mScanCompCount; i++)
+			{
+				JpegComponent& c = *mScanComps[i];
+				for(uint v = 0; v < c.V; v++)
+					for(uint h = 0; h < c.H; h++)
+						if(!decodeBlock(reader, c, ux*c.H + h, uy*c.V + v)) return null;
+			}
+			if(mRestartInterval != 0 && --restartsLeft == 0)
+			{
+				reader.Restart();
+				for(uint i = 0; i < mScanCompCount; i++) mScanComps[i]->DcPredictor = 0;
+				mEobRun = 0;
+				restartsLeft = mRestartInterval;
+			}
+		}
+	}
+	mAnyScan = true;
+	return reader.Pos;
+}
+
+void JpegDecoder::finishProgressive()
+{
+	alignas(16) short block[64];
+	for(uint i = 0; i < mCompCount; i++)
+	{
+		JpegComponent& c = mComps[i];
+		const ushort* const quant = mQuant[c.QuantTable];
+		const short* coefs = c.Coefs.Data();
+		for(uint by = 0; by < c.BlocksY; by++)
+			for(uint bx = 0; bx < c.BlocksX; bx++, coefs += 64)
+			{
+				for(uint k = 0; k < 64; k++) block[k] = short(coefs[k]*quant[k]);
+				idct(block, c, bx, by);
+			}
+		c.Coefs = null;
+	}
+}
+
+//! Получить строку y изображения из плоскости компоненты, увеличенной в UpsampleH раз по горизонтали и UpsampleV раз по вертикали.
+//! Для коэффициента 2 используется треугольный фильтр с весами 3/4 и 1/4 (как fancy upsampling в libjpeg),
+//! для остальных - повторение отсчётов.
+void jpegUpsampleRow(const JpegComponent& c, uint y, uint srcWidth, uint srcHeight, byte* dst, uint dstWidth, ushort* tmp)
+{
+	const uint hf = c.UpsampleH, vf = c.UpsampleV;
+	if(hf > 2 || vf > 2)
+	{
+		const byte* const src = c.Plane.Data() + Math::Min(y/vf, srcHeight - 1)*c.PlaneStride;
+		for(uint x = 0; x < dstWidth; x++) dst[x] = src[Math::Min(x/hf, srcWidth - 1)];
+		return;
+	}
+
+	// вертикальный проход: t = 3*ближняя строка + дальняя, без вертикального увеличения дальняя совпадает с ближней.
+	// По краям t дополняется повторением крайних отсчётов, чтобы горизонтальному проходу не нужны были проверки
+	const uint sy = y/vf;
+	uint farY = sy;
+	if(vf == 2) farY = (y & 1)? Math::Min(sy + 1, srcHeight - 1): (sy != 0? sy - 1: 0);
+	const byte* const nearRow = c.Plane.Data() + sy*c.PlaneStride;
+	const byte* const farRow = c.Plane.Data() + farY*c.PlaneStride;
+	ushort* const t = tmp + 1;
+	uint x = 0;
+#if(INTRA_SIMD_SUPPORT >= INTRA_SIMD_SSE2 && INTRA_SIMD_SUPPORT <= INTRA_SIMD_AVX2)
+	const __m128i zero = _mm_setzero_si128();
+	for(; x + 8 <= srcWidth; x += 8)
+	{
+		const __m128i n = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(nearRow + x)), zero);
+		const __m128i f = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(farRow + x)), zero);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(t + x), _mm_add_epi16(_mm_add_epi16(n, _mm_slli_epi16(n, 1)), f));
+	}
+#endif
+	for(; x < srcWidth; x++) t[x] = ushort(3*nearRow[x] + farRow[x]);
+	tmp[0] = t[0];
+	t[srcWidth] = t[srcWidth - 1];
+
+	if(hf == 1)
+	{
+		for(x = 0; x < dstWidth; x++) dst[x] = byte((t[x] + 2) >> 2);
+		return;
+	}
+	x = 0;
+#if(INTRA_SIMD_SUPPORT >= INTRA_SIMD_SSE2 && INTRA_SIMD_SUPPORT <= INTRA_SIMD_AVX2)
+	const __m128i round8 = _mm_set1_epi16(8), round7 = _mm_set1_epi16(7);
+	for(; 2*x + 16 <= dstWidth; x += 8)
+	{
+		const __m128i cur = _mm_loadu_si128(reinterpret_cast<const __m128i*>(t + x));
+		const __m128i prev = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tmp + x));
+		const __m128i next = _mm_loadu_si128(reinterpret_cast<const __m128i*>(t + x + 1));
+		const __m128i cur3 = _mm_add_epi16(cur, _mm_slli_epi16(cur, 1));
+		const __m128i even = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(cur3, prev), round8), 4);
+		const __m128i odd = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(cur3, next), round7), 4);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 2*x),
+			_mm_packus_epi16(_mm_unpacklo_epi16(even, odd), _mm_unpackhi_epi16(even, odd)));
+	}
+#endif
+	for(; 2*x < dstWidth; x++)
+	{
+		// tmp[x] = t[x - 1]
+		const int cur = 3*t[x];
+		dst[2*x] = byte((cur + tmp[x] + 8) >> 4);
+		if(2*x + 1 < dstWidth) dst[2*x + 1] = byte((cur + t[x + 1] + 7) >> 4);
+	}
+}
+
+AnyImage JpegDecoder::output(ushort lineAlignment)
+{
+	const uint scale = 1u << mScaleLog;
+	const uint outWidth = (mWidth + scale - 1) >> mScaleLog, outHeight = (mHeight + scale - 1) >> mScaleLog;
+	const bool gray = mCompCount == 1;
+	AnyImage result({ushort(outWidth), ushort(outHeight), 1}, gray? ImageFormat::Luminance8: ImageFormat::RGB8);
+	result.LineAlignment = byte(lineAlignment);
+	result.Data.SetCountUninitialized(result.Info.CalculateMipmapDataSize(0, lineAlignment));
+	const size_t outRowBytes = (size_t(outWidth)*(gray? 1: 3) + lineAlignment - 1) & ~size_t(lineAlignment - 1);
+
+	// Adobe transform = 0 и идентификаторы R, G, B означают, что компоненты хранятся без преобразования цвета
+	const bool rgb = !gray && (mAdobeTransform == 0 ||
+		(mComps[0].Id == 'R' && mComps[1].Id == 'G' && mComps[2].Id == 'B'));
+
+	uint srcWidth[3], srcHeight[3];
+	Array<byte> rows[3];
+	Array<ushort> tmp;
+	for(uint i = 0; i < mCompCount; i++)
+	{
+		const JpegComponent& c = mComps[i];
+		srcWidth[i] = (c.Width*c.BlockW + 7)/8;
+		srcHeight[i] = (c.Height*c.BlockH + 7)/8;
+		if(c.UpsampleH == 1 && c.UpsampleV == 1) continue;
+		rows[i].SetCountUninitialized(outWidth);
+		if(tmp.Length() < srcWidth[i] + 2) tmp.SetCountUninitialized(srcWidth[i] + 2);
+	}
+
+	for(uint y = 0; y < outHeight; y++)
+	{
+		const byte* src[3];
+		for(uint i = 0; i < mCompCount; i++)
+		{
+			const JpegComponent& c = mComps[i];
+			if(c.UpsampleH == 1 && c.UpsampleV == 1)
+			{
+				src[i] = c.Plane.Data() + y*c.PlaneStride;
+				continue;
+			}
+			jpegUpsampleRow(c, y, srcWidth[i], srcHeight[i], rows[i].Data(), outWidth, tmp.Data());
+			src[i] = rows[i].Data();
+		}
+		byte* const dst = result.Data.Data() + y*outRowBytes;
+		if(gray) C::memcpy(dst, src[0], outWidth);
+		else if(!rgb) jpegYCbCrToRGB(src[0], src[1], src[2], dst, outWidth);
+		else for(uint x = 0; x < outWidth; x++)
+		{
+			dst[3*x] = src[0][x];
+			dst[3*x + 1] = src[1][x];
+			dst[3*x + 2] = src[2][x];
+		}
+	}
+	return result;
+}
+
+AnyImage JpegDecoder::Decode(CSpan<byte> file, ushort lineAlignment)
+{
+	for(auto& table: mDcTables) table.Defined = false;
+	for(auto& table: mAcTables) table.Defined = false;
+	C::memset(mQuant, 0, sizeof(mQuant));
+	if(file.Length() < 4 || file[0] != 0xFF || file[1] != 0xD8) return null;
+
+	const byte* p = file.Data() + 2;
+	const byte* const end = file.Data() + file.Length();
+	for(;;)
+	{
+		// пропускаем байты-заполнители и мусор до следующего маркера
+		while(p + 1 < end && !(p[0] == 0xFF && p[1] != 0 && p[1] != 0xFF)) p++;
+		if(p + 1 >= end) break;
+		const byte marker = p[1];
+		p += 2;
+		if(marker == 0xD9) break;
+		if((marker >= 0xD0 && marker <= 0xD7) || marker == 0x01) continue;
+		if(end - p < 2) return null;
+		const size_t len = size_t(p[0] << 8 | p[1]);
+		if(len < 2 || len > size_t(end - p)) return null;
+		const byte* const seg = p + 2;
+		const size_t segLen = len - 2;
+		p += len;
+		switch(marker)
+		{
+		case 0xC0: case 0xC1: case 0xC2:
+			mProgressive = marker == 0xC2;
+			if(!readFrame(seg, segLen)) return null;
+			break;
+		case 0xC4:
+			if(!readHuffmanTables(seg, segLen)) return null;
+			break;
+		case 0xDB:
+			if(!readQuantTables(seg, segLen)) return null;
+			break;
+		case 0xDD:
+			if(segLen < 2) return null;
+			mRestartInterval = uint(seg[0] << 8 | seg[1]);
+			break;
+		case 0xDA:
+			p = readScan(seg, segLen, p, end);
+			if(p == null) return null;
+			break;
+		case 0xEE:
+			if(segLen >= 12 && C::memcmp(seg, "Adobe", 5) == 0) mAdobeTransform = seg[11];
+			break;
+		default:
+			// арифметическое кодирование, lossless и иерархический режим не поддерживаются
+			if(marker >= 0xC3 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC) return null;
+			// остальные сегменты (APPn, COM, ...) не влияют на пиксели
+			break;
+		}
+	}
+	if(!mAnyScan) return null;
+	if(mProgressive) finishProgressive();
+	return output(lineAlignment);
+}
+
+}
+
 bool LoaderJPEG::IsValidHeader(const void* header, size_t headerSize) const
 {
 	const byte* headerBytes = reinterpret_cast<const byte*>(header);
@@ -25,7 +1107,7 @@ ImageInfo LoaderJPEG::GetInfo(IInputStream& stream) const
 		stream.PopFirst();
 		const byte chunkName = Range::RawRead<byte>(stream);
 		ushort chunkSize = ushort(Range::RawRead<ushortBE>(stream) - 2u);
-		if(chunkName == 0xC0 || chunkName == 0xC2) // baseline/progressive (huffman)
+		if(chunkName == 0xC0 || chunkName == 0xC1 || chunkName == 0xC2) // baseline/extended/progressive (huffman)
 		{
 			stream.PopFirst(); // precision
 			result.Size.y = Range::RawRead<ushortBE>(stream);
@@ -40,18 +1122,31 @@ ImageInfo LoaderJPEG::GetInfo(IInputStream& stream) const
 	return result;
 }
 
-
 AnyImage LoaderJPEG::Load(IInputStream& stream) const
+{return Load(stream, 1, 1);}
+
+AnyImage LoaderJPEG::Load(IInputStream& stream, uint scaleDenominator, ushort lineAlignment) const
 {
-#ifdef INTRA_USE_LIBJPEG
-	//TODO: сделать загрузку через libjpeg
-#error Not implemented!
-#elif(INTRA_LIBRARY_IMAGE_LOADING != INTRA_LIBRARY_IMAGE_LOADING_None)
-	return LoadWithPlatform(stream);
-#else
-	(void)stream;
-	return null;
-#endif
+	// конец энтропийно закодированных данных без их разбора не найти, поэтому поток читается целиком
+	Array<byte> file;
+	while(!stream.Empty())
+	{
+		const size_t oldLength = file.Length();
+		file.SetCountUninitialized(oldLength + 65536);
+		file.SetCountUninitialized(oldLength + RawReadTo(stream, file.Data() + oldLength, 65536));
+	}
+	return LoadFromMemory(file.AsConstRange(), scaleDenominator, lineAlignment);
+}
+
+AnyImage LoaderJPEG::LoadFromMemory(CSpan<byte> fileData, uint scaleDenominator, ushort lineAlignment) const
+{
+	uint scaleLog = 0;
+	while(scaleLog < 3 && (1u << scaleLog) < scaleDenominator) scaleLog++;
+	if((1u << scaleLog) != scaleDenominator) return null;
+	// AnyImage::LineAlignment хранится в байте, поэтому допустимы только степени двойки до 128
+	if(lineAlignment == 0 || lineAlignment > 128 || (lineAlignment & (lineAlignment - 1)) != 0) return null;
+	Unique<JpegDecoder> decoder(new JpegDecoder(scaleLog));
+	return decoder->Decode(fileData, lineAlignment);
 }
 
 const LoaderJPEG LoaderJPEG::Instance;
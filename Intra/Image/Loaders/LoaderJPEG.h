@@ -4,6 +4,7 @@
 
 #include "Loader.h"
 #include "Cpp/Warnings.h"
+#include "Utils/Span.h"
 
 namespace Intra { namespace Image {
 
@@ -15,6 +16,17 @@ class LoaderJPEG: public AImageLoader
 public:
 	ImageInfo GetInfo(IInputStream& stream) const override;
 	AnyImage Load(IInputStream& stream) const override;
+
+	//! Загрузить JPEG, уменьшив его в scaleDenominator раз (1, 2, 4 или 8), и выровнять строки результата по lineAlignment байт.
+	//! Поток читается до конца.
+	AnyImage Load(IInputStream& stream, uint scaleDenominator, ushort lineAlignment = 1) const;
+
+	//! Декодировать baseline или progressive JPEG с кодированием Хаффмана, целиком находящийся в памяти.
+	//! При scaleDenominator, равном 2, 4 или 8, каждый блок 8x8 восстанавливается уменьшенным ОДКП сразу в блок 4x4, 2x2 или 1x1,
+	//! без полного ОДКП и последующего уменьшения - удобно для миниатюр.
+	//! Результат - RGB8 или Luminance8. Прореженные компоненты цветности увеличиваются с линейной интерполяцией.
+	//! lineAlignment должен быть степенью двойки не больше 128, иначе возвращается null.
+	AnyImage LoadFromMemory(CSpan<byte> fileData, uint scaleDenominator = 1, ushort lineAlignment = 1) const;
 	bool IsValidHeader(const void* header, size_t headerSize) const override;
 	FileFormat FileFormatOfLoader() const override {return FileFormat::JPEG;}
 
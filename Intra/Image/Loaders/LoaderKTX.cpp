@@ -6,6 +6,8 @@
 
 #include "Image/AnyImage.h"
 #include "Image/Bindings/GLenumFormats.h"
+#include "Range/Stream/RawRead.h"
+#include "Range/Stream/RawWrite.h"
 
 namespace Intra { namespace Image {
 
@@ -20,6 +22,11 @@ struct KtxHeader
 	uint bytesOfKeyValueData;
 };
 
+static const byte KtxFileIdentifier[12] = {
+	0xAB, 0x4B, 0x54, 0x58, 0x20, 0x31,
+	0x31, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A
+};
+
 static ImageInfo GetImageInfoFromHeader(const KtxHeader& header)
 {
 	ImageInfo result = {{0,0,0}, null, ImageType_End, 0};
@@ -42,6 +49,11 @@ static ImageInfo GetImageInfoFromHeader(const KtxHeader& header)
 	}
 	else result.Type = ImageType_3D;
 	result.Size = Math::Max(Math::USVec3(header.sizes), Math::USVec3(1));
+	//Слои массивов и грани кубических карт хранятся как слои по z
+	if(result.Type == ImageType_2DArray)
+		result.Size.z = ushort(header.numberOfArrayElements);
+	else if(result.Type == ImageType_Cube || result.Type == ImageType_CubeArray)
+		result.Size.z = ushort(6*Math::Max(header.numberOfArrayElements, 1u));
 	return result;
 }
 
@@ -56,12 +68,7 @@ ImageInfo LoaderKTX::GetInfo(IInputStream& stream) const
 bool LoaderKTX::IsValidHeader(const void* header, size_t bytes) const
 {
 	if(bytes<12) return false;
-
-	static const byte fileIdentifier[12] = {
-		0xAB, 0x4B, 0x54, 0x58, 0x20, 0x31,
-		0x31, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A
-	};
-	return Equals(SpanOfRaw(header, bytes), fileIdentifier);
+	return Equals(SpanOfRaw(header, 12), KtxFileIdentifier);
 }
 
 AnyImage LoaderKTX::Load(IInputStream& stream) const
@@ -84,29 +91,82 @@ AnyImage LoaderKTX::Load(IInputStream& stream) const
 	const size_t fullDataSize = info.CalculateFullDataSize(result.LineAlignment);
 	result.Data.SetCountUninitialized(fullDataSize);
 	byte* pos = result.Data.Data();
+	byte* const end = pos + fullDataSize;
 
 	stream.PopFirstN(header.bytesOfKeyValueData); //Пропускаем метаданные
 
+	//Выравнивание граней и мип-уровней до 4 байт есть только в файле
 	for(ushort i=0; i<info.MipmapCount; i++)
 	{
 		const uint imageSize = Range::RawRead<uint>(stream);
-		if(result.Info.Type == ImageType_Cube)
+		const ushort parts = ushort(result.Info.Type == ImageType_Cube? 6: 1);
+		for(ushort j=0; j<parts; j++)
 		{
-			for(ushort j=0; j<6; j++)
-			{
-				RawReadTo(stream, pos, imageSize);
-				pos += imageSize;
-				pos += 3-(imageSize+3)%4;
-			}
-			continue;
+			if(imageSize > size_t(end - pos)) return null;
+			RawReadTo(stream, pos, imageSize);
+			pos += imageSize;
+			stream.PopFirstN(3 - (imageSize + 3) % 4);
 		}
-		RawReadTo(stream, pos, imageSize);
-		pos += imageSize;
-		pos += 3 - (imageSize + 3) % 4;
 	}
 	return result;
 }
 
+static void WritePadding(IOutputStream& stream, size_t bytes)
+{
+	static const byte zeros[3] = {0, 0, 0};
+	RawWriteFrom(stream, CSpan<byte>(zeros, 3 - (bytes + 3) % 4));
+}
+
+void LoaderKTX::Save(const AnyImage& img, IOutputStream& stream) const
+{
+	const ImageInfo& info = img.Info;
+	const bool compressed = info.Format.IsCompressed();
+	if(!compressed && img.LineAlignment != 4)
+	{
+		//Строки несжатых изображений в KTX выровнены на 4 байта
+		const AnyImage aligned = img.ConvertFormat(info.Format, 4);
+		INTRA_ASSERT1(aligned != null, info.Format.ToString());
+		if(aligned != null) Save(aligned, stream);
+		return;
+	}
+
+	RawWriteFrom(stream, CSpan<byte>(KtxFileIdentifier));
+	Range::RawWrite<uint>(stream, 0x04030201);
+
+	const bool cube = info.Type == ImageType_Cube || info.Type == ImageType_CubeArray;
+	const bool array = info.Type == ImageType_2DArray || info.Type == ImageType_CubeArray;
+	KtxHeader header;
+	header.glType = compressed? 0u: ImageFormatToGLType(info.Format);
+	if(compressed) header.glTypeSize = 1;
+	else if(info.Format.IsPacked()) header.glTypeSize = info.Format.BytesPerPixel();
+	else header.glTypeSize = uint(info.Format.BytesPerPixel()/info.Format.ComponentCount());
+	header.glFormat = compressed? 0u: ImageFormatToGLExternal(info.Format, img.SwapRB, false);
+	header.glInternalFormat = ImageFormatToGLInternal(info.Format, false);
+	header.glBaseInternalFormat = ImageFormatToGLExternal(compressed? info.Format.GetBasicFormat(): info.Format, false, false);
+	header.sizes = {info.Size.x, info.Size.y, info.Type == ImageType_3D? uint(info.Size.z): 0u};
+	header.numberOfArrayElements = array? uint(cube? info.Size.z/6: info.Size.z): 0u;
+	header.numberOfFaces = cube? 6u: 1u;
+	header.numberOfMipmapLevels = Math::Max(uint(info.MipmapCount), 1u);
+	header.bytesOfKeyValueData = 0;
+	Range::RawWrite<KtxHeader>(stream, header);
+
+	for(size_t i=0; i<header.numberOfMipmapLevels; i++)
+	{
+		const size_t mipBytes = info.CalculateMipmapDataSize(i, img.LineAlignment);
+		const byte* data = static_cast<const byte*>(img.GetMipmapDataPtr(i));
+		//У кубических карт без массива размер и выравнивание указываются для каждой грани отдельно
+		const size_t parts = info.Type == ImageType_Cube? 6u: 1u;
+		const size_t partBytes = mipBytes/parts;
+		Range::RawWrite<uint>(stream, uint(partBytes));
+		for(size_t j=0; j<parts; j++)
+		{
+			RawWriteFrom(stream, CSpan<byte>(data, partBytes));
+			WritePadding(stream, partBytes);
+			data += partBytes;
+		}
+	}
+}
+
 const LoaderKTX LoaderKTX::Instance;
 
 INTRA_WARNING_POP
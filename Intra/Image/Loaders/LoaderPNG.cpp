@@ -6,9 +6,429 @@
 #include "Image/AnyImage.h"
 #include "Range/Polymorphic/InputRange.h"
 #include "Cpp/Endianess.h"
+#include "Cpp/Intrinsics.h"
+#include "Data/Compression/Inflate.h"
+#include "Simd/Simd.h"
 
 namespace Intra { namespace Image {
 
+INTRA_PUSH_DISABLE_REDUNDANT_WARNINGS
+
+namespace {
+
+enum: byte {PngGray = 0, PngRGB = 2, PngPalette = 3, PngGrayAlpha = 4, PngRGBA = 6};
+
+struct PngHeader
+{
+	uint Width, Height;
+	byte BitDepth, ColorType, Interlace;
+
+	uint Channels() const
+	{
+		static const byte channels[] = {1, 0, 3, 1, 2, 0, 4};
+		return channels[ColorType];
+	}
+
+	uint BitsPerPixel() const {return Channels()*BitDepth;}
+	size_t RowBytes(uint width) const {return (size_t(width)*BitsPerPixel() + 7)/8;}
+
+	//! Расстояние в байтах до соответствующего байта предыдущего пикселя, используемое фильтрами.
+	uint FilterStep() const {return BitsPerPixel() < 8? 1: BitsPerPixel()/8;}
+
+	bool IsValid() const
+	{
+		if(Width == 0 || Height == 0 || Width > 65535 || Height > 65535 || Interlace > 1) return false;
+		switch(ColorType)
+		{
+		case PngGray: return BitDepth == 1 || BitDepth == 2 || BitDepth == 4 || BitDepth == 8 || BitDepth == 16;
+		case PngPalette: return BitDepth == 1 || BitDepth == 2 || BitDepth == 4 || BitDepth == 8;
+		case PngRGB: case PngGrayAlpha: case PngRGBA: return BitDepth == 8 || BitDepth == 16;
+		default: return false;
+		}
+	}
+};
+
+forceinline uint pngReadUInt(const byte* p)
+{return uint(p[0]) << 24 | uint(p[1]) << 16 | uint(p[2]) << 8 | p[3];}
+
+PngHeader pngParseHeader(const byte* ihdr)
+{
+	PngHeader result;
+	result.Width = pngReadUInt(ihdr);
+	result.Height = pngReadUInt(ihdr + 4);
+	result.BitDepth = ihdr[8];
+	result.ColorType = ihdr[9];
+	// методы сжатия и фильтрации, отличные от 0, не определены
+	result.Interlace = ihdr[10] == 0 && ihdr[11] == 0? ihdr[12]: byte(255);
+	return result;
+}
+
+ImageFormat pngOutputFormat(const PngHeader& header, bool paletteHasAlpha)
+{
+	const bool is16 = header.BitDepth == 16;
+	switch(header.ColorType)
+	{
+	case PngGray: return is16? ImageFormat::Luminance16: ImageFormat::Luminance8;
+	case PngRGB: return is16? ImageFormat::RGB16: ImageFormat::RGB8;
+	case PngPalette: return paletteHasAlpha? ImageFormat::RGBA8: ImageFormat::RGB8;
+	case PngGrayAlpha: return is16? ImageFormat::LuminanceAlpha16: ImageFormat::LuminanceAlpha8;
+	case PngRGBA: return is16? ImageFormat::RGBA16: ImageFormat::RGBA8;
+	default: return null;
+	}
+}
+
+forceinline byte pngPaeth(int a, int b, int c)
+{
+	const int pa = Math::Abs(b - c), pb = Math::Abs(a - c), pc = Math::Abs(a + b - 2*c);
+	if(pa <= pb && pa <= pc) return byte(a);
+	return byte(pb <= pc? b: c);
+}
+
+#if(INTRA_SIMD_SUPPORT >= INTRA_SIMD_SSE2 && INTRA_SIMD_SUPPORT <= INTRA_SIMD_AVX2)
+// Фильтры Sub, Avg и Paeth зависят от предыдущего пикселя строки, поэтому векторизуются по байтам одного пикселя:
+// пиксель из 3, 4, 6 или 8 байт целиком помещается в регистр в виде 16-битных компонент.
+
+template<uint Step> forceinline __m128i pngLoadPixel(const byte* p)
+{
+	ulong64 v = 0;
+	C::memcpy(&v, p, Step);
+	return _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(&v)), _mm_setzero_si128());
+}
+
+template<uint Step> forceinline void pngStorePixel(byte* p, __m128i x)
+{
+	ulong64 v;
+	_mm_storel_epi64(reinterpret_cast<__m128i*>(&v), _mm_packus_epi16(x, x));
+	C::memcpy(p, &v, Step);
+}
+
+forceinline __m128i pngAbs16(__m128i x) {return _mm_max_epi16(x, _mm_sub_epi16(_mm_setzero_si128(), x));}
+
+forceinline __m128i pngSelect(__m128i mask, __m128i a, __m128i b)
+{return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));}
+
+template<uint Step> void pngUnfilterSubSimd(const byte* raw, byte* dst, size_t rowBytes)
+{
+	const __m128i mask = _mm_set1_epi16(255);
+	__m128i a = _mm_setzero_si128();
+	for(size_t i = 0; i < rowBytes; i += Step)
+	{
+		a = _mm_and_si128(_mm_add_epi16(a, pngLoadPixel<Step>(raw + i)), mask);
+		pngStorePixel<Step>(dst + i, a);
+	}
+}
+
+template<uint Step> void pngUnfilterAvgSimd(const byte* raw, byte* dst, const byte* prev, size_t rowBytes)
+{
+	const __m128i mask = _mm_set1_epi16(255);
+	__m128i a = _mm_setzero_si128();
+	for(size_t i = 0; i < rowBytes; i += Step)
+	{
+		const __m128i b = pngLoadPixel<Step>(prev + i);
+		const __m128i avg = _mm_srli_epi16(_mm_add_epi16(a, b), 1);
+		a = _mm_and_si128(_mm_add_epi16(avg, pngLoadPixel<Step>(raw + i)), mask);
+		pngStorePixel<Step>(dst + i, a);
+	}
+}
+
+template<uint Step> void pngUnfilterPaethSimd(const byte* raw, byte* dst, const byte* prev, size_t rowBytes)
+{
+	const __m128i mask = _mm_set1_epi16(255);
+	__m128i a = _mm_setzero_si128(), c = _mm_setzero_si128();
+	for(size_t i = 0; i < rowBytes; i += Step)
+	{
+		const __m128i b = pngLoadPixel<Step>(prev + i);
+		const __m128i pbSigned = _mm_sub_epi16(a, c), paSigned = _mm_sub_epi16(b, c);
+		const __m128i pa = pngAbs16(paSigned), pb = pngAbs16(pbSigned);
+		const __m128i pc = pngAbs16(_mm_add_epi16(paSigned, pbSigned));
+		const __m128i smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+		const __m128i predictor = pngSelect(_mm_cmpeq_epi16(smallest, pa), a,
+			pngSelect(_mm_cmpeq_epi16(smallest, pb), b, c));
+		a = _mm_and_si128(_mm_add_epi16(predictor, pngLoadPixel<Step>(raw + i)), mask);
+		c = b;
+		pngStorePixel<Step>(dst + i, a);
+	}
+}
+
+template<uint Step> bool pngUnfilterPixelsSimd(byte filter, const byte* raw, byte* dst, const byte* prev, size_t rowBytes)
+{
+	switch(filter)
+	{
+	case 1: pngUnfilterSubSimd<Step>(raw, dst, rowBytes); return true;
+	case 3: pngUnfilterAvgSimd<Step>(raw, dst, prev, rowBytes); return true;
+	case 4: pngUnfilterPaethSimd<Step>(raw, dst, prev, rowBytes); return true;
+	default: return false;
+	}
+}
+#endif
+
+//! Восстановить строку dst из отфильтрованной строки raw и восстановленной предыдущей строки prev.
+//! @return false, если тип фильтра неизвестен.
+bool pngUnfilterRow(byte filter, const byte* raw, byte* dst, const byte* prev, size_t rowBytes, uint step)
+{
+	if(filter == 0)
+	{
+		C::memcpy(dst, raw, rowBytes);
+		return true;
+	}
+	if(filter == 2)
+	{
+		size_t i = 0;
+#if(INTRA_SIMD_SUPPORT >= INTRA_SIMD_SSE2 && INTRA_SIMD_SUPPORT <= INTRA_SIMD_AVX2)
+		for(; i + 16 <= rowBytes; i += 16)
+		{
+			const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(raw + i));
+			const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(prev + i));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_add_epi8(x, b));
+		}
+#endif
+		for(; i < rowBytes; i++) dst[i] = byte(raw[i] + prev[i]);
+		return true;
+	}
+	if(filter > 4) return false;
+
+#if(INTRA_SIMD_SUPPORT >= INTRA_SIMD_SSE2 && INTRA_SIMD_SUPPORT <= INTRA_SIMD_AVX2)
+	// длина строки кратна шагу, так что чтение и запись пикселей целиком не выходят за строку
+	switch(step)
+	{
+	case 3: return pngUnfilterPixelsSimd<3>(filter, raw, dst, prev, rowBytes);
+	case 4: return pngUnfilterPixelsSimd<4>(filter, raw, dst, prev, rowBytes);
+	case 6: return pngUnfilterPixelsSimd<6>(filter, raw, dst, prev, rowBytes);
+	case 8: return pngUnfilterPixelsSimd<8>(filter, raw, dst, prev, rowBytes);
+	}
+#endif
+
+	const size_t first = Math::Min<size_t>(step, rowBytes);
+	switch(filter)
+	{
+	case 1:
+		C::memcpy(dst, raw, first);
+		for(size_t i = first; i < rowBytes; i++) dst[i] = byte(raw[i] + dst[i - step]);
+		break;
+	case 3:
+		for(size_t i = 0; i < first; i++) dst[i] = byte(raw[i] + (prev[i] >> 1));
+		for(size_t i = first; i < rowBytes; i++) dst[i] = byte(raw[i] + ((dst[i - step] + prev[i]) >> 1));
+		break;
+	case 4:
+		for(size_t i = 0; i < first; i++) dst[i] = byte(raw[i] + prev[i]);
+		for(size_t i = first; i < rowBytes; i++) dst[i] = byte(raw[i] + pngPaeth(dst[i - step], prev[i], prev[i - step]));
+		break;
+	}
+	return true;
+}
+
+//! Перевод восстановленной строки PNG в формат AnyImage.
+struct PngRowConverter
+{
+	const PngHeader* Header;
+	//! Палитра из 256 цветов RGBA. Индексы за пределами PLTE дают непрозрачный чёрный.
+	const byte* Palette;
+	uint OutPixelBytes;
+
+	//! Нужно ли преобразование: 8-битные изображения без палитры копируются как есть.
+	bool IsIdentity() const {return Header->BitDepth == 8 && Header->ColorType != PngPalette;}
+
+	void operator()(const byte* src, byte* dst, uint width) const
+	{
+		const uint depth = Header->BitDepth;
+		if(depth == 16)
+		{
+			// PNG хранит 16-битные компоненты в big-endian
+			const size_t count = size_t(width)*Header->Channels()*2;
+			size_t i = 0;
+#if(INTRA_SIMD_SUPPORT >= INTRA_SIMD_SSE2 && INTRA_SIMD_SUPPORT <= INTRA_SIMD_AVX2)
+			for(; i + 16 <= count; i += 16)
+			{
+				const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8)));
+			}
+#endif
+			for(; i < count; i += 2)
+			{
+				dst[i] = src[i + 1];
+				dst[i + 1] = src[i];
+			}
+			return;
+		}
+		if(Header->ColorType == PngPalette)
+		{
+			if(depth == 8)
+			{
+				if(OutPixelBytes == 4) for(uint x = 0; x < width; x++) C::memcpy(dst + x*4, Palette + src[x]*4, 4);
+				else for(uint x = 0; x < width; x++) C::memcpy(dst + x*3, Palette + src[x]*4, 3);
+				return;
+			}
+			const uint mask = (1u << depth) - 1;
+			for(uint x = 0; x < width; x++)
+			{
+				const uint bit = x*depth;
+				const uint index = (src[bit >> 3] >> (8 - depth - (bit & 7))) & mask;
+				C::memcpy(dst + x*OutPixelBytes, Palette + index*4, OutPixelBytes);
+			}
+			return;
+		}
+		if(depth == 8)
+		{
+			C::memcpy(dst, src, size_t(width)*OutPixelBytes);
+			return;
+		}
+		// оттенки серого с 1, 2 или 4 битами растягиваются на весь диапазон байта
+		const uint mask = (1u << depth) - 1;
+		const uint scale = 255/mask;
+		for(uint x = 0; x < width; x++)
+		{
+			const uint bit = x*depth;
+			dst[x] = byte(((src[bit >> 3] >> (8 - depth - (bit & 7))) & mask)*scale);
+		}
+	}
+};
+
+AnyImage pngDecode(CSpan<byte> file, ushort lineAlignment)
+{
+	static const byte pngSignature[] = {137, 'P', 'N', 'G', 13, 10, 26, 10};
+	if(file.Length() < 8 || C::memcmp(file.Begin, pngSignature, 8) != 0) return null;
+	// AnyImage::LineAlignment хранится в байте, поэтому допустимы только степени двойки до 128
+	if(lineAlignment == 0 || lineAlignment > 128 || (lineAlignment & (lineAlignment - 1)) != 0) return null;
+
+	PngHeader header{};
+	bool hasHeader = false, paletteHasAlpha = false;
+	byte palette[256*4];
+	for(size_t i = 0; i < 256; i++)
+	{
+		palette[i*4] = palette[i*4 + 1] = palette[i*4 + 2] = 0;
+		palette[i*4 + 3] = 255;
+	}
+	size_t paletteSize = 0;
+
+	// Обычно весь IDAT находится в одном или нескольких соседних чанках.
+	// Если чанк один, данные распаковываются прямо из файла.
+	const byte* singleIdat = null;
+	size_t singleIdatLength = 0;
+	Array<byte> joinedIdat;
+	size_t idatCount = 0;
+
+	const byte* pos = file.Begin + 8;
+	for(;;)
+	{
+		if(file.End - pos < 12) return null;
+		const uint length = pngReadUInt(pos);
+		const byte* const type = pos + 4;
+		const byte* const data = pos + 8;
+		if(length > size_t(file.End - data) - 4) return null;
+		pos = data + length + 4;
+
+		if(C::memcmp(type, "IHDR", 4) == 0)
+		{
+			if(length < 13) return null;
+			header = pngParseHeader(data);
+			if(!header.IsValid()) return null;
+			hasHeader = true;
+		}
+		else if(!hasHeader) return null;
+		else if(C::memcmp(type, "PLTE", 4) == 0)
+		{
+			paletteSize = Math::Min<size_t>(length/3, 256);
+			for(size_t i = 0; i < paletteSize; i++) C::memcpy(palette + i*4, data + i*3, 3);
+		}
+		else if(C::memcmp(type, "tRNS", 4) == 0)
+		{
+			// прозрачность по цветовому ключу для изображений без палитры не поддерживается
+			if(header.ColorType != PngPalette) continue;
+			const size_t count = Math::Min<size_t>(length, 256);
+			for(size_t i = 0; i < count; i++) palette[i*4 + 3] = data[i];
+			paletteHasAlpha = count != 0;
+		}
+		else if(C::memcmp(type, "IDAT", 4) == 0)
+		{
+			if(idatCount == 1) joinedIdat.AddLastRange(CSpan<byte>(singleIdat, singleIdatLength));
+			if(idatCount == 0)
+			{
+				singleIdat = data;
+				singleIdatLength = length;
+			}
+			else joinedIdat.AddLastRange(CSpan<byte>(data, length));
+			idatCount++;
+		}
+		else if(C::memcmp(type, "IEND", 4) == 0) break;
+		// остальные чанки не влияют на пиксели
+	}
+	if(idatCount == 0 || (header.ColorType == PngPalette && paletteSize == 0)) return null;
+	const CSpan<byte> idat = idatCount == 1? CSpan<byte>(singleIdat, singleIdatLength): joinedIdat.AsConstRange();
+
+	// проходы Adam7: начало и шаг по x и y
+	static const byte adam7[7][4] = {{0, 0, 8, 8}, {4, 0, 8, 8}, {0, 4, 4, 8}, {2, 0, 4, 4}, {0, 2, 2, 4}, {1, 0, 2, 2}, {0, 1, 1, 2}};
+	static const byte noInterlace[1][4] = {{0, 0, 1, 1}};
+	const byte (*passes)[4] = header.Interlace? adam7: noInterlace;
+	const uint passCount = header.Interlace? 7u: 1u;
+
+	uint passWidth[7], passHeight[7];
+	size_t filteredSize = 0;
+	for(uint p = 0; p < passCount; p++)
+	{
+		passWidth[p] = header.Width > passes[p][0]? (header.Width - passes[p][0] + passes[p][2] - 1)/passes[p][2]: 0;
+		passHeight[p] = header.Height > passes[p][1]? (header.Height - passes[p][1] + passes[p][3] - 1)/passes[p][3]: 0;
+		if(passWidth[p] != 0 && passHeight[p] != 0)
+			filteredSize += passHeight[p]*(header.RowBytes(passWidth[p]) + 1);
+	}
+
+	Array<byte> filtered;
+	filtered.SetCountUninitialized(filteredSize);
+	if(Data::InflateZlib(idat, filtered) != filteredSize) return null;
+	joinedIdat = null;
+
+	AnyImage result({ushort(header.Width), ushort(header.Height), 1}, pngOutputFormat(header, paletteHasAlpha));
+	result.LineAlignment = byte(lineAlignment);
+	result.Data.SetCountUninitialized(result.Info.CalculateMipmapDataSize(0, lineAlignment));
+	const uint outPixelBytes = result.Info.Format.BytesPerPixel();
+	const size_t outRowBytes = (size_t(header.Width)*outPixelBytes + lineAlignment - 1) & ~size_t(lineAlignment - 1);
+	const PngRowConverter convert = {&header, palette, outPixelBytes};
+	const uint step = header.FilterStep();
+
+	// две строки для восстановления с предыдущей строкой и строка пикселей прохода Adam7
+	const size_t maxRowBytes = header.RowBytes(header.Width);
+	Array<byte> scratch;
+	scratch.SetCount(2*maxRowBytes + size_t(header.Width)*outPixelBytes);
+	byte* const zeroRow = scratch.Data() + maxRowBytes;
+
+	const byte* raw = filtered.Data();
+	for(uint p = 0; p < passCount; p++)
+	{
+		const uint width = passWidth[p], height = passHeight[p];
+		if(width == 0 || height == 0) continue;
+		const size_t rowBytes = header.RowBytes(width);
+		C::memset(zeroRow, 0, rowBytes);
+		const byte* prev = zeroRow;
+		const uint x0 = passes[p][0], y0 = passes[p][1], dx = passes[p][2], dy = passes[p][3];
+		for(uint y = 0; y < height; y++, raw += rowBytes + 1)
+		{
+			byte* const dstRow = result.Data.Data() + (y0 + y*dy)*outRowBytes;
+			if(!header.Interlace && convert.IsIdentity())
+			{
+				// восстанавливаем прямо в изображение, предыдущая строка уже лежит в нём
+				if(!pngUnfilterRow(raw[0], raw + 1, dstRow, prev, rowBytes, step)) return null;
+				prev = dstRow;
+				continue;
+			}
+			// строки по очереди занимают две половины scratch, чтобы не затереть предыдущую
+			byte* const row = scratch.Data() + (prev == scratch.Data()? maxRowBytes: 0);
+			if(!pngUnfilterRow(raw[0], raw + 1, row, prev, rowBytes, step)) return null;
+			prev = row;
+			if(!header.Interlace)
+			{
+				convert(row, dstRow, width);
+				continue;
+			}
+			byte* const pixels = scratch.Data() + 2*maxRowBytes;
+			convert(row, pixels, width);
+			for(uint x = 0; x < width; x++)
+				C::memcpy(dstRow + (x0 + x*dx)*outPixelBytes, pixels + x*outPixelBytes, outPixelBytes);
+		}
+	}
+	return result;
+}
+
+}
+
 bool LoaderPNG::IsValidHeader(const void* header, size_t headerSize) const
 {
 	const byte* headerBytes = reinterpret_cast<const byte*>(header);
@@ -24,43 +444,74 @@ ImageInfo LoaderPNG::GetInfo(IInputStream& stream) const
 	if(!IsValidHeader(headerSignature, 8)) return ImageInfo();
 	stream.PopFirstN(2*sizeof(intBE));
 
-	const Math::UVec2 ihdrSize = Range::RawRead<Math::Vector2<uintBE>>(stream);
-	const byte ihdrBitsPerComponent = Range::RawRead<byte>(stream);
-	const byte ihdrColorType = Range::RawRead<byte>(stream);
+	byte ihdr[13];
+	if(RawReadTo(stream, ihdr, 13) != 13) return ImageInfo();
+	const PngHeader header = pngParseHeader(ihdr);
+	if(!header.IsValid()) return ImageInfo();
 
-	ImageFormat fmt = null;
-	if(ihdrBitsPerComponent == 8)
+	// формат изображения с палитрой зависит от наличия чанка tRNS, который идёт до IDAT
+	bool paletteHasAlpha = false;
+	if(header.ColorType == PngPalette)
 	{
-		if(ihdrColorType == 0) fmt = ImageFormat::Luminance8;
-		else if(ihdrColorType == 4) fmt = ImageFormat::LuminanceAlpha8;
-		else if(ihdrColorType == 2) fmt = ImageFormat::RGB8;
-		else if(ihdrColorType == 6) fmt = ImageFormat::RGBA8;
-	}
-	else if(ihdrBitsPerComponent==16)
-	{
-		if(ihdrColorType == 0) fmt = ImageFormat::Luminance16;
-		//else if(ihdrColorType == 4) fmt = ImageFormat::LuminanceAlpha16;
-		else if(ihdrColorType == 2) fmt = ImageFormat::RGB16;
-		else if(ihdrColorType == 6) fmt = ImageFormat::RGBA16;
+		stream.PopFirstN(4);
+		for(;;)
+		{
+			byte chunkHeader[8];
+			if(RawReadTo(stream, chunkHeader, 8) != 8) break;
+			const uint length = pngReadUInt(chunkHeader);
+			if(C::memcmp(chunkHeader + 4, "IDAT", 4) == 0 || C::memcmp(chunkHeader + 4, "IEND", 4) == 0) break;
+			if(C::memcmp(chunkHeader + 4, "tRNS", 4) == 0)
+			{
+				paletteHasAlpha = length != 0;
+				break;
+			}
+			if(stream.PopFirstN(size_t(length) + 4) != size_t(length) + 4) break;
+		}
 	}
+
 	return {
-		Math::USVec3(ihdrSize.x, ihdrSize.y, 1),
-		fmt, ImageType_2D, 0
+		Math::USVec3(ushort(header.Width), ushort(header.Height), 1),
+		pngOutputFormat(header, paletteHasAlpha), ImageType_2D, 0
 	};
 }
 
 AnyImage LoaderPNG::Load(IInputStream& stream) const
+{return Load(stream, 1);}
+
+AnyImage LoaderPNG::Load(IInputStream& stream, ushort lineAlignment) const
 {
-#ifdef INTRA_USE_LIBPNG
-	//TODO: сделать загрузку через libjpeg
-#elif(INTRA_LIBRARY_IMAGE_LOADING!=INTRA_LIBRARY_IMAGE_LOADING_None)
-	return LoadWithPlatform(stream);
-#else
-	(void)stream;
-	return null;
-#endif
+	// Собираем файл до чанка IEND, не читая поток дальше него
+	Array<byte> file;
+	file.SetCountUninitialized(8);
+	if(RawReadTo(stream, file.Data(), 8) != 8 || !IsValidHeader(file.Data(), 8)) return null;
+	for(;;)
+	{
+		const size_t chunkStart = file.Length();
+		file.SetCountUninitialized(chunkStart + 8);
+		if(RawReadTo(stream, file.Data() + chunkStart, 8) != 8) return null;
+		const size_t length = pngReadUInt(file.Data() + chunkStart);
+		const bool end = C::memcmp(file.Data() + chunkStart + 4, "IEND", 4) == 0;
+		// Длина чанка по стандарту не превышает 2^31 - 1. Буфер растёт по мере чтения,
+		// чтобы длина из повреждённого заголовка не приводила к выделению памяти сверх содержимого потока.
+		if(length > 0x7FFFFFFF) return null;
+		for(size_t read = 0; read < length + 4;)
+		{
+			const size_t piece = Math::Min<size_t>(length + 4 - read, 65536);
+			const size_t oldLength = file.Length();
+			file.SetCountUninitialized(oldLength + piece);
+			if(RawReadTo(stream, file.Data() + oldLength, piece) != piece) return null;
+			read += piece;
+		}
+		if(end) break;
+	}
+	return pngDecode(file.AsConstRange(), lineAlignment);
 }
 
+AnyImage LoaderPNG::LoadFromMemory(CSpan<byte> fileData, ushort lineAlignment) const
+{return pngDecode(fileData, lineAlignment);}
+
 const LoaderPNG LoaderPNG::Instance;
 
+INTRA_WARNING_POP
+
 }}
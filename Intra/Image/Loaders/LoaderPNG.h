@@ -4,6 +4,7 @@
 
 #include "Loader.h"
 #include "Cpp/Warnings.h"
+#include "Utils/Span.h"
 
 namespace Intra { namespace Image {
 
@@ -15,6 +16,16 @@ class LoaderPNG: public AImageLoader
 public:
 	ImageInfo GetInfo(IInputStream& stream) const override;
 	AnyImage Load(IInputStream& stream) const override;
+
+	//! Загрузить PNG, выравнивая строки результата по lineAlignment байт.
+	//! Поток читается до чанка IEND включительно. lineAlignment должен быть степенью двойки не больше 128, иначе возвращается null.
+	AnyImage Load(IInputStream& stream, ushort lineAlignment) const;
+
+	//! Декодировать PNG-файл, целиком находящийся в памяти, например в отображении файла.
+	//! Данные единственного чанка IDAT распаковываются без копирования, восстановленные строки сразу пишутся в AnyImage::Data.
+	//! Изображения с палитрой переводятся в RGB8 или RGBA8, оттенки серого с глубиной меньше 8 бит - в Luminance8,
+	//! 16-битные компоненты - в порядок байт платформы.
+	AnyImage LoadFromMemory(CSpan<byte> fileData, ushort lineAlignment = 1) const;
 	bool IsValidHeader(const void* header, size_t headerSize) const override;
 	FileFormat FileFormatOfLoader() const override {return FileFormat::PNG;}
 
@@ -0,0 +1,399 @@
+﻿#include "Image/Resample.h"
+#include "Image/AnyImage.h"
+#include "Image/FormatConversion.h"
+#include "Container/Sequential/Array.h"
+#include "Concurrency/ParallelFor.h"
+#include "Math/Math.h"
+#include "Cpp/Intrinsics.h"
+#include "Simd/Simd.h"
+
+namespace Intra { namespace Image {
+
+using namespace Math;
+
+INTRA_PUSH_DISABLE_REDUNDANT_WARNINGS
+
+namespace {
+
+//! Пиксель результата - взвешенная сумма исходных пикселей [First; First + Count) одной строки или столбца.
+//! За краем изображения повторяется крайний пиксель, поэтому веса выходящих за край пикселей прибавляются к крайнему.
+struct ResampleTap
+{
+	uint First, Count, WeightOffset;
+};
+
+struct ResampleTaps
+{
+	Array<ResampleTap> Taps;
+	Array<float> Weights;
+};
+
+float resampleSinc(float x)
+{
+	if(Abs(x) < 1e-6f) return 1;
+	x *= float(PI);
+	return Sin(x)/x;
+}
+
+//! Модифицированная функция Бесселя первого рода нулевого порядка.
+float resampleBesselI0(float x)
+{
+	float sum = 1, term = 1;
+	const float q = x*x/4;
+	for(int k = 1; k < 50 && term > sum*1e-8f; k++)
+	{
+		term *= q/float(k*k);
+		sum += term;
+	}
+	return sum;
+}
+
+float resampleFilterRadius(const ResampleParams& params)
+{
+	switch(params.Filter)
+	{
+	case ResampleFilter::Box: return 0.5f;
+	case ResampleFilter::Lanczos3: return 3;
+	default: return params.KaiserWidth;
+	}
+}
+
+float resampleFilterWeight(const ResampleParams& params, float x)
+{
+	x = Abs(x);
+	switch(params.Filter)
+	{
+	case ResampleFilter::Box: return x < 0.5f? 1.0f: x > 0.5f? 0.0f: 0.5f;
+	case ResampleFilter::Lanczos3: return x < 3? resampleSinc(x)*resampleSinc(x/3): 0;
+	default:
+	{
+		if(x >= params.KaiserWidth) return 0;
+		const float t = x/params.KaiserWidth;
+		return resampleSinc(x)*resampleBesselI0(params.KaiserAlpha*Sqrt(1 - t*t))/resampleBesselI0(params.KaiserAlpha);
+	}
+	}
+}
+
+//! При уменьшении фильтр растягивается во столько раз, во сколько уменьшается изображение,
+//! чтобы подавлять частоты выше новой частоты Найквиста.
+void resampleBuildTaps(ResampleTaps& taps, uint srcSize, uint dstSize, const ResampleParams& params)
+{
+	const float scale = float(srcSize)/float(dstSize);
+	const float stretch = Max(scale, 1.0f);
+	const float radius = resampleFilterRadius(params)*stretch;
+	taps.Taps.SetCountUninitialized(dstSize);
+	taps.Weights.Clear();
+	Array<float> weights;
+	for(uint i = 0; i < dstSize; i++)
+	{
+		const float center = (float(i) + 0.5f)*scale - 0.5f;
+		const int lo = int(Floor(center - radius)), hi = int(Ceil(center + radius));
+		const int first = Max(lo, 0), last = Min(hi, int(srcSize) - 1);
+		weights.Clear();
+		weights.SetCount(size_t(last - first + 1));
+		float* const w = weights.Data();
+		float sum = 0;
+		for(int j = lo; j <= hi; j++)
+		{
+			const float weight = resampleFilterWeight(params, (float(j) - center)/stretch);
+			w[Clamp(j, first, last) - first] += weight;
+			sum += weight;
+		}
+		int begin = 0, end = last - first + 1;
+		while(end - begin > 1 && w[begin] == 0) begin++;
+		while(end - begin > 1 && w[end - 1] == 0) end--;
+
+		ResampleTap& tap = taps.Taps[i];
+		tap.First = uint(first + begin);
+		tap.Count = uint(end - begin);
+		tap.WeightOffset = uint(taps.Weights.Length());
+		for(int k = begin; k < end; k++) taps.Weights.AddLast(w[k]/sum);
+	}
+}
+
+void resampleRowsHorizontal(const float* src, uint srcWidth, float* dst,
+	const ResampleTaps& taps, size_t rowBegin, size_t rowEnd)
+{
+	const size_t dstWidth = taps.Taps.Length();
+	for(size_t y = rowBegin; y < rowEnd; y++)
+	{
+		const float* srcRow = src + y*srcWidth*4;
+		float* d = dst + y*dstWidth*4;
+		for(const ResampleTap& tap: taps.Taps)
+		{
+			const float* w = taps.Weights.Data() + tap.WeightOffset;
+			const float* p = srcRow + tap.First*4;
+#if(INTRA_SIMD_SUPPORT >= INTRA_SIMD_SSE2 && INTRA_SIMD_SUPPORT <= INTRA_SIMD_AVX2)
+			__m128 acc = _mm_setzero_ps();
+			for(uint k = 0; k < tap.Count; k++)
+				acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(w[k]), _mm_loadu_ps(p + 4*k)));
+			_mm_storeu_ps(d, acc);
+#else
+			float acc[4] = {0, 0, 0, 0};
+			for(uint k = 0; k < tap.Count; k++)
+				for(uint c = 0; c < 4; c++) acc[c] += w[k]*p[4*k + c];
+			for(uint c = 0; c < 4; c++) d[c] = acc[c];
+#endif
+			d += 4;
+		}
+	}
+}
+
+//! Строка результата накапливается по целым исходным строкам, чтобы внутренний цикл шёл подряд по памяти.
+void resampleRowsVertical(const float* src, float* dst, size_t rowFloats,
+	const ResampleTaps& taps, size_t rowBegin, size_t rowEnd)
+{
+	for(size_t y = rowBegin; y < rowEnd; y++)
+	{
+		const ResampleTap& tap = taps.Taps[y];
+		const float* w = taps.Weights.Data() + tap.WeightOffset;
+		float* d = dst + y*rowFloats;
+		for(uint k = 0; k < tap.Count; k++)
+		{
+			const float* s = src + (tap.First + k)*rowFloats;
+			size_t x = 0;
+#if(INTRA_SIMD_SUPPORT >= INTRA_SIMD_SSE2 && INTRA_SIMD_SUPPORT <= INTRA_SIMD_AVX2)
+			const __m128 wk = _mm_set1_ps(w[k]);
+			if(k == 0) for(; x < rowFloats; x += 4)
+				_mm_storeu_ps(d + x, _mm_mul_ps(wk, _mm_loadu_ps(s + x)));
+			else for(; x < rowFloats; x += 4)
+				_mm_storeu_ps(d + x, _mm_add_ps(_mm_loadu_ps(d + x), _mm_mul_ps(wk, _mm_loadu_ps(s + x))));
+#else
+			if(k == 0) for(; x < rowFloats; x++) d[x] = w[k]*s[x];
+			else for(; x < rowFloats; x++) d[x] += w[k]*s[x];
+#endif
+		}
+	}
+}
+
+//! ToLinear переводит байт sRGB в линейную яркость.
+//! Thresholds[i] - линейная яркость середины между кодами i и i + 1, так что обратное преобразование с округлением -
+//! это число порогов, не превосходящих значение. Start даёт это число для начала каждого из 4096 равных отрезков,
+//! после чего остаётся пройти не больше пары порогов.
+struct ResampleSrgbTables
+{
+	float ToLinear[256];
+	float Thresholds[255];
+	byte Start[4097];
+
+	static float Decode(float v)
+	{return v <= 0.04045f? v/12.92f: Pow((v + 0.055f)/1.055f, 2.4f);}
+
+	ResampleSrgbTables()
+	{
+		for(int i = 0; i < 256; i++) ToLinear[i] = Decode(float(i)/255);
+		for(int i = 0; i < 255; i++) Thresholds[i] = Decode((float(i) + 0.5f)/255);
+		uint code = 0;
+		for(uint k = 0; k <= 4096; k++)
+		{
+			while(code < 255 && Thresholds[code] <= float(k)/4096) code++;
+			Start[k] = byte(code);
+		}
+	}
+
+	//! v должно лежать в [0; 1].
+	byte Encode(float v) const
+	{
+		uint code = Start[uint(v*4096)];
+		while(code < 255 && Thresholds[code] <= v) code++;
+		return byte(code);
+	}
+};
+
+const ResampleSrgbTables& resampleSrgbTables()
+{
+	static const ResampleSrgbTables tables;
+	return tables;
+}
+
+//! sRGB8 и sRGB8_A8 хранятся так же, как RGB8 и RGBA8, и читаются и записываются их кодеками (см. ToNonSRGB),
+//! поэтому фильтрация для них всегда идёт в линейном пространстве.
+ResampleParams resampleFormatParams(ImageFormat format, const ResampleParams& params)
+{
+	ResampleParams result = params;
+	if(format.IsSRGB()) result.SRGB = true;
+	return result;
+}
+
+size_t resampleLineBytes(uint width, ImageFormat format, ushort lineAlignment)
+{return (size_t(width)*format.BytesPerPixel() + lineAlignment - 1u) & ~size_t(lineAlignment - 1u);}
+
+//! Плоское изображение из четырёх float на пиксель: линейный цвет, умноженный на альфу, если это требуется, и альфа.
+struct ResampleLayer
+{
+	const byte* Data;
+	size_t LineBytes;
+	uint Width;
+	ImageFormat Format;
+};
+
+void resampleDecodeRows(const ResampleLayer& src, float* dst,
+	const ResampleParams& params, size_t rowBegin, size_t rowEnd)
+{
+	const ResampleSrgbTables& srgb = resampleSrgbTables();
+	Array<byte> rgba;
+	rgba.SetCountUninitialized(src.Width*4u);
+	for(size_t y = rowBegin; y < rowEnd; y++)
+	{
+		ConvertPixelRow(src.Data + y*src.LineBytes, src.Format, rgba.Data(), ImageFormat::RGBA8, src.Width, false);
+		float* d = dst + y*src.Width*4;
+		for(const byte* p = rgba.Data(); p != rgba.End(); p += 4, d += 4)
+		{
+			const float a = float(p[3])/255;
+			for(int c = 0; c < 3; c++)
+			{
+				const float v = params.SRGB? srgb.ToLinear[p[c]]: float(p[c])/255;
+				d[c] = params.PremultiplyAlpha? v*a: v;
+			}
+			d[3] = a;
+		}
+	}
+}
+
+void resampleEncodeRows(const float* src, byte* dst, size_t dstLineBytes, uint width, ImageFormat format,
+	const ResampleParams& params, size_t rowBegin, size_t rowEnd)
+{
+	const ResampleSrgbTables& srgb = resampleSrgbTables();
+	const size_t usefulBytes = size_t(width)*format.BytesPerPixel();
+	Array<byte> rgba;
+	rgba.SetCountUninitialized(width*4u);
+	for(size_t y = rowBegin; y < rowEnd; y++)
+	{
+		const float* s = src + y*width*4;
+		for(byte* p = rgba.Data(); p != rgba.End(); p += 4, s += 4)
+		{
+			const float a = Clamp(s[3], 0.0f, 1.0f);
+			const float scale = !params.PremultiplyAlpha? 1.0f: a > 0? 1.0f/a: 0.0f;
+			for(int c = 0; c < 3; c++)
+			{
+				const float v = Clamp(s[c]*scale, 0.0f, 1.0f);
+				p[c] = params.SRGB? srgb.Encode(v): byte(v*255 + 0.5f);
+			}
+			p[3] = byte(a*255 + 0.5f);
+		}
+		byte* line = dst + y*dstLineBytes;
+		ConvertPixelRow(rgba.Data(), ImageFormat::RGBA8, line, format, width, false);
+		C::memset(line + usefulBytes, 0, dstLineBytes - usefulBytes);
+	}
+}
+
+template<typename Body> void resampleParallelRows(ThreadPool& pool, size_t rows, size_t rowBytes, const Body& body)
+{ParallelFor(pool, rows, body, Concurrency::DefaultGrainSize(rows, rowBytes, pool.MaxConcurrency()));}
+
+void resampleDecode(const ResampleLayer& src, uint height, float* dst, const ResampleParams& params, ThreadPool& pool)
+{
+	resampleParallelRows(pool, height, src.Width*16u, [&](size_t begin, size_t end) {
+		resampleDecodeRows(src, dst, params, begin, end);
+	});
+}
+
+void resampleEncode(const float* src, USVec2 size, byte* dst, size_t dstLineBytes, ImageFormat format,
+	const ResampleParams& params, ThreadPool& pool)
+{
+	resampleParallelRows(pool, size.y, size.x*16u, [&](size_t begin, size_t end) {
+		resampleEncodeRows(src, dst, dstLineBytes, size.x, format, params, begin, end);
+	});
+}
+
+//! Сначала фильтруются строки в tmp размером dstSize.x x srcSize.y, затем столбцы.
+//! Проход по неизменяющемуся измерению пропускается.
+void resampleFloat(const float* src, USVec2 srcSize, float* tmp, float* dst, USVec2 dstSize,
+	const ResampleParams& params, ThreadPool& pool)
+{
+	const bool horizontal = srcSize.x != dstSize.x, vertical = srcSize.y != dstSize.y;
+	if(!horizontal && !vertical)
+	{
+		C::memcpy(dst, src, sizeof(float)*4*srcSize.x*srcSize.y);
+		return;
+	}
+	ResampleTaps taps;
+	float* const hDst = vertical? tmp: dst;
+	if(horizontal)
+	{
+		resampleBuildTaps(taps, srcSize.x, dstSize.x, params);
+		resampleParallelRows(pool, srcSize.y, (srcSize.x + dstSize.x)*16u, [&](size_t begin, size_t end) {
+			resampleRowsHorizontal(src, srcSize.x, hDst, taps, begin, end);
+		});
+	}
+	if(!vertical) return;
+	const float* const vSrc = horizontal? tmp: src;
+	resampleBuildTaps(taps, srcSize.y, dstSize.y, params);
+	const size_t rowFloats = size_t(dstSize.x)*4;
+	const size_t tapsPerRow = taps.Weights.Length()/dstSize.y + 1;
+	resampleParallelRows(pool, dstSize.y, rowFloats*4*tapsPerRow, [&](size_t begin, size_t end) {
+		resampleRowsVertical(vSrc, dst, rowFloats, taps, begin, end);
+	});
+}
+
+}
+
+bool CanResample(ImageFormat format)
+{return !format.IsCompressed() && CanConvertPixelRows(format.ToNonSRGB(), ImageFormat::RGBA8);}
+
+bool ResampleImage(CSpan<byte> src, USVec2 srcSize, Span<byte> dst, USVec2 dstSize,
+	ImageFormat format, ushort lineAlignment, const ResampleParams& requestedParams, ThreadPool& pool)
+{
+	if(!CanResample(format)) return false;
+	if(srcSize.x == 0 || srcSize.y == 0 || dstSize.x == 0 || dstSize.y == 0) return true;
+	const ResampleParams params = resampleFormatParams(format, requestedParams);
+	format = format.ToNonSRGB();
+	const ResampleLayer layer = {src.Data(), resampleLineBytes(srcSize.x, format, lineAlignment), srcSize.x, format};
+	const size_t dstLineBytes = resampleLineBytes(dstSize.x, format, lineAlignment);
+	INTRA_DEBUG_ASSERT(src.Length() >= layer.LineBytes*srcSize.y);
+	INTRA_DEBUG_ASSERT(dst.Length() >= dstLineBytes*dstSize.y);
+
+	Array<float> srcPixels, tmp, dstPixels;
+	srcPixels.SetCountUninitialized(size_t(srcSize.x)*srcSize.y*4);
+	tmp.SetCountUninitialized(size_t(dstSize.x)*srcSize.y*4);
+	dstPixels.SetCountUninitialized(size_t(dstSize.x)*dstSize.y*4);
+	resampleDecode(layer, srcSize.y, srcPixels.Data(), params, pool);
+	resampleFloat(srcPixels.Data(), srcSize, tmp.Data(), dstPixels.Data(), dstSize, params, pool);
+	resampleEncode(dstPixels.Data(), dstSize, dst.Data(), dstLineBytes, format, params, pool);
+	return true;
+}
+
+bool GenerateMipmaps(AnyImage& image, const ResampleParams& requestedParams, ThreadPool& pool)
+{
+	ImageInfo& info = image.Info;
+	if(image == null || info == null || !CanResample(info.Format) || info.Type == ImageType_3D) return false;
+	const ResampleParams params = resampleFormatParams(info.Format, requestedParams);
+	const ImageFormat codecFormat = info.Format.ToNonSRGB();
+	const uint maxLevels = info.CalculateMaxMipmapCount();
+	const uint levels = info.MipmapCount == 0? maxLevels: Min(uint(info.MipmapCount), maxLevels);
+	INTRA_DEBUG_ASSERT(image.Data.Length() >= info.CalculateMipmapDataSize(0, image.LineAlignment));
+	info.MipmapCount = ushort(levels);
+	image.Data.SetCount(Max(image.Data.Length(), info.CalculateFullDataSize(image.LineAlignment)));
+	if(levels == 1) return true;
+
+	const USVec2 size0 = {info.Size.x, info.Size.y};
+	const size_t level0Floats = size_t(size0.x)*size0.y*4;
+	Array<float> cur, next, tmp;
+	tmp.SetCountUninitialized(level0Floats/2 + 4);
+	const size_t layerCount = info.Size.z;
+	for(size_t z = 0; z < layerCount; z++)
+	{
+		//cur и next меняются местами на каждом уровне, поэтому размеры восстанавливаются для каждого слоя
+		cur.SetCountUninitialized(level0Floats);
+		next.SetCountUninitialized(level0Floats/2 + 4);
+		const size_t line0 = resampleLineBytes(size0.x, info.Format, image.LineAlignment);
+		const ResampleLayer layer = {image.Data.Data() + z*line0*size0.y, line0, size0.x, codecFormat};
+		resampleDecode(layer, size0.y, cur.Data(), params, pool);
+		USVec2 size = size0;
+		for(uint mip = 1; mip < levels; mip++)
+		{
+			const USVec3 mipSize = info.CalculateMipmapSize(mip);
+			const USVec2 nextSize = {mipSize.x, mipSize.y};
+			resampleFloat(cur.Data(), size, tmp.Data(), next.Data(), nextSize, params, pool);
+			const size_t lineBytes = resampleLineBytes(nextSize.x, info.Format, image.LineAlignment);
+			byte* const dst = static_cast<byte*>(image.GetMipmapDataPtr(mip)) + z*lineBytes*nextSize.y;
+			resampleEncode(next.Data(), nextSize, dst, lineBytes, codecFormat, params, pool);
+			cur.swap(next);
+			size = nextSize;
+		}
+	}
+	return true;
+}
+
+INTRA_WARNING_POP
+
+}}
@@ -0,0 +1,73 @@
+﻿#pragma once
+
+#include "Cpp/Warnings.h"
+#include "Cpp/Fundamental.h"
+
+#include "Math/Vector2.h"
+#include "Utils/Span.h"
+
+#include "Concurrency/ThreadPool.h"
+
+#include "Image/ImageFormat.h"
+
+namespace Intra { namespace Image {
+
+class AnyImage;
+
+INTRA_PUSH_DISABLE_REDUNDANT_WARNINGS
+
+enum class ResampleFilter: byte
+{
+	//! Среднее по покрываемым пикселям. При уменьшении вдвое - обычное усреднение 2x2.
+	Box,
+
+	//! Окно Ланцоша радиуса 3. Резче Kaiser, но сильнее звенит на контрастных границах.
+	Lanczos3,
+
+	//! Sinc с окном Кайзера. Хороший компромисс между резкостью и звоном для мип-уровней.
+	Kaiser
+};
+
+//! Параметры ResampleImage и GenerateMipmaps.
+struct ResampleParams
+{
+	ResampleFilter Filter = ResampleFilter::Kaiser;
+
+	//! Цветовые каналы закодированы в sRGB. Фильтрация тогда идёт в линейном пространстве,
+	//! иначе уменьшенные изображения темнеют. Альфа всегда линейна.
+	//! Для форматов sRGB8 и sRGB8_A8 включается автоматически.
+	bool SRGB = false;
+
+	//! Фильтровать цвет, умноженный на альфу, и делить на неё после фильтрации,
+	//! чтобы цвет полностью прозрачных пикселей не просачивался в соседние.
+	//! Если альфа в изображении уже умножена, нужно выключить.
+	bool PremultiplyAlpha = true;
+
+	//! Радиус окна Kaiser в пикселях результата и его параметр формы.
+	float KaiserWidth = 3;
+	float KaiserAlpha = 4;
+};
+
+//! Поддерживает ли ResampleImage формат format.
+//! Поддерживаются форматы, которые ConvertPixelRow умеет преобразовывать в RGBA8, а также sRGB8 и sRGB8_A8.
+bool CanResample(ImageFormat format);
+
+//! Изменить размер двумерного изображения разделимым фильтром.
+//! Строки src и dst выровнены на lineAlignment байт. Строки обрабатываются параллельно полосами в потоках пула pool.
+//! @return false, если формат не поддерживается.
+bool ResampleImage(CSpan<byte> src, Math::USVec2 srcSize, Span<byte> dst, Math::USVec2 dstSize,
+	ImageFormat format, ushort lineAlignment,
+	const ResampleParams& params = ResampleParams(), ThreadPool& pool = ThreadPool::Default());
+
+//! Заполнить все мип-уровни image, начиная с первого, уменьшением нулевого уровня.
+//! Если Info.MipmapCount == 0, генерируется полная цепочка до 1x1 и MipmapCount обновляется.
+//! Data расширяется до полного размера, нулевой уровень сохраняется.
+//! Каждый уровень строится из предыдущего, который хранится без квантования, так что ошибка не накапливается.
+//! Слои массивов и грани кубических карт обрабатываются независимо. Трёхмерные и сжатые изображения не поддерживаются.
+//! @return false, если формат или тип изображения не поддерживается. Тогда image не изменяется.
+bool GenerateMipmaps(AnyImage& image,
+	const ResampleParams& params = ResampleParams(), ThreadPool& pool = ThreadPool::Default());
+
+INTRA_WARNING_POP
+
+}}
@@ -4,6 +4,10 @@
 #include "Cpp/Warnings.h"
 #include "Meta/Type.h"
 
+#if(defined(_MSC_VER) && !defined(__GNUC__))
+#include <intrin.h>
+#endif
+
 namespace Intra { namespace Math {
 
 INTRA_PUSH_DISABLE_REDUNDANT_WARNINGS
@@ -39,6 +43,33 @@ uint> FindBitPosition(T mask)
 	return Count1Bits((mask&(~mask+1))-1);
 }
 
+//! Номер младшего установленного бита. mask не должна быть равна нулю.
+forceinline uint CountTrailingZeros(uint mask)
+{
+#if(defined(__GNUC__) || defined(__clang__))
+	return uint(__builtin_ctz(mask));
+#elif defined(_MSC_VER)
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return uint(index);
+#else
+	return FindBitPosition(mask);
+#endif
+}
+
+forceinline uint CountTrailingZeros(ulong64 mask)
+{
+#if(defined(__GNUC__) || defined(__clang__))
+	return uint(__builtin_ctzll(mask));
+#elif(defined(_MSC_VER) && defined(_WIN64))
+	unsigned long index;
+	_BitScanForward64(&index, mask);
+	return uint(index);
+#else
+	return uint(mask)!=0? CountTrailingZeros(uint(mask)): 32 + CountTrailingZeros(uint(mask >> 32));
+#endif
+}
+
 forceinline uint BitCountToMask(uint bitCount)
 {
 	return (bitCount==32)? 0xFFFFFFFFu: (1u << bitCount)-1u;
@@ -55,6 +55,7 @@ template<typename A> struct AllocatorRef<A, Meta::EmptyType, true>: A
 {
 	forceinline AllocatorRef(null_t=null) {}
 	forceinline AllocatorRef(A& allocator) {(void)allocator;}
+	forceinline AllocatorRef(const AllocatorRef&) = default;
 
 	AllocatorRef& operator=(const AllocatorRef&) {return *this;}
 
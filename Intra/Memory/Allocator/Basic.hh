@@ -3,3 +3,4 @@
 #include "Basic/Linear.h"
 #include "Basic/Stack.h"
 #include "Basic/Pool.h"
+#include "Basic/Arena.h"
@@ -0,0 +1,63 @@
+﻿#include "Memory/Allocator/Basic/Arena.h"
+#include "Memory/VirtualMemory.h"
+#include "Cpp/Warnings.h"
+
+INTRA_PUSH_DISABLE_REDUNDANT_WARNINGS
+
+namespace Intra { namespace Memory {
+
+AVirtualArena::AVirtualArena(size_t reserveBytes, size_t allocatorAlignment):
+	mStart(null), mTop(null), mCommitEnd(null), mReserveEnd(null), mAlignment(allocatorAlignment)
+{
+	reserveBytes = Aligned(reserveBytes, CommitGranularity);
+	if(reserveBytes == 0) return;
+	mStart = VirtualAlloc(reserveBytes, Access::None);
+	if(mStart == null) return;
+	mTop = mCommitEnd = mStart;
+	mReserveEnd = mStart + reserveBytes;
+}
+
+AVirtualArena& AVirtualArena::operator=(AVirtualArena&& rhs)
+{
+	if(this == &rhs) return *this;
+	if(mStart != null) VirtualFree(mStart, ReservedBytes());
+	mStart = rhs.mStart;
+	mTop = rhs.mTop;
+	mCommitEnd = rhs.mCommitEnd;
+	mReserveEnd = rhs.mReserveEnd;
+	mAlignment = rhs.mAlignment;
+	rhs.mStart = rhs.mTop = rhs.mCommitEnd = rhs.mReserveEnd = null;
+	return *this;
+}
+
+AVirtualArena::~AVirtualArena()
+{
+	if(mStart != null) VirtualFree(mStart, ReservedBytes());
+}
+
+void AVirtualArena::commit(byte* newTop)
+{
+	INTRA_DEBUG_ASSERT(newTop <= mReserveEnd);
+	// grow the committed part geometrically to keep the number of system calls small
+	size_t bytesToCommit = Aligned(size_t(newTop - mCommitEnd), CommitGranularity);
+	size_t growth = CommittedBytes();
+	if(growth > MaxCommitGrowth) growth = MaxCommitGrowth;
+	if(bytesToCommit < growth) bytesToCommit = growth;
+	const size_t available = size_t(mReserveEnd - mCommitEnd);
+	if(bytesToCommit > available) bytesToCommit = available;
+	VirtualCommit(mCommitEnd, bytesToCommit, Access::ReadWrite);
+	mCommitEnd += bytesToCommit;
+}
+
+void AVirtualArena::ReleaseUnusedPages(size_t keepBytes)
+{
+	if(mStart == null) return;
+	byte* const keepEnd = mStart + Aligned(UsedBytes() + keepBytes, CommitGranularity);
+	if(keepEnd >= mCommitEnd) return;
+	VirtualCommit(keepEnd, size_t(mCommitEnd - keepEnd), Access::None);
+	mCommitEnd = keepEnd;
+}
+
+}}
+
+INTRA_WARNING_POP
@@ -0,0 +1,113 @@
+﻿#pragma once
+
+#include "Cpp/Fundamental.h"
+#include "Cpp/Warnings.h"
+#include "Utils/Debug.h"
+#include "Utils/AnyPtr.h"
+#include "Memory/Align.h"
+
+namespace Intra { namespace Memory {
+
+INTRA_PUSH_DISABLE_REDUNDANT_WARNINGS
+
+//! Растущий линейный аллокатор (арена) поверх зарезервированного диапазона виртуальной памяти.
+/*!
+При создании резервируется адресное пространство размером reserveBytes, а физическая память выделяется
+кусками по CommitGranularity байт по мере роста. Поэтому адреса выделенных блоков никогда не меняются.
+Free освобождает память только для последнего выделенного блока, всё остальное освобождается сразу
+вызовом Rewind до ранее полученной отметки GetMark или вызовом Reset.
+Используется с контейнерами через AllocatorRef, например BList<T, AVirtualArena> list(arena).
+*/
+struct AVirtualArena
+{
+	enum: size_t {CommitGranularity = 64*1024, MaxCommitGrowth = 16*1024*1024};
+
+	//! Положение вершины арены, к которому можно вернуться через Rewind.
+	struct Mark
+	{
+		byte* Position;
+	};
+
+	//! Восстанавливает вершину арены при выходе из области видимости.
+	struct Scope
+	{
+		Scope(AVirtualArena& arena): mArena(arena), mMark(arena.GetMark()) {}
+		~Scope() {mArena.Rewind(mMark);}
+
+	private:
+		AVirtualArena& mArena;
+		Mark mMark;
+
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+	};
+
+	AVirtualArena(null_t=null, size_t allocatorAlignment=16):
+		mStart(null), mTop(null), mCommitEnd(null), mReserveEnd(null), mAlignment(allocatorAlignment) {}
+
+	//! @param reserveBytes Максимальный размер арены. Округляется вверх до CommitGranularity.
+	explicit AVirtualArena(size_t reserveBytes, size_t allocatorAlignment=16);
+
+	AVirtualArena(AVirtualArena&& rhs):
+		mStart(rhs.mStart), mTop(rhs.mTop), mCommitEnd(rhs.mCommitEnd),
+		mReserveEnd(rhs.mReserveEnd), mAlignment(rhs.mAlignment)
+	{rhs.mStart = rhs.mTop = rhs.mCommitEnd = rhs.mReserveEnd = null;}
+
+	AVirtualArena& operator=(AVirtualArena&& rhs);
+
+	~AVirtualArena();
+
+	size_t GetAlignment() const {return mAlignment;}
+
+	AnyPtr Allocate(size_t& bytes, const Utils::SourceInfo& sourceInfo)
+	{
+		(void)sourceInfo;
+		byte* const userPtr = Aligned(mTop, mAlignment);
+		if(userPtr == null || size_t(mReserveEnd - userPtr) < bytes) return null;
+		byte* const newTop = userPtr + bytes;
+		if(newTop > mCommitEnd) commit(newTop);
+		mTop = newTop;
+		return userPtr;
+	}
+
+	//! Если ptr - последний выделенный блок, его память возвращается арене, иначе ничего не делает.
+	void Free(void* ptr, size_t size)
+	{
+		if(ptr != null && static_cast<byte*>(ptr) + size == mTop) mTop = static_cast<byte*>(ptr);
+	}
+
+	Mark GetMark() const {return {mTop};}
+
+	//! Освободить всё, что было выделено после получения отметки mark.
+	void Rewind(Mark mark)
+	{
+		INTRA_DEBUG_ASSERT(mark.Position >= mStart && mark.Position <= mTop);
+		mTop = mark.Position;
+	}
+
+	//! Освободить всё, что было выделено. Физическая память остаётся выделенной для повторного использования.
+	void Reset() {mTop = mStart;}
+
+	//! Вернуть системе физическую память, не занятую блоками, оставив выделенными keepBytes байт после вершины.
+	void ReleaseUnusedPages(size_t keepBytes = 0);
+
+	size_t UsedBytes() const {return size_t(mTop - mStart);}
+	size_t CommittedBytes() const {return size_t(mCommitEnd - mStart);}
+	size_t ReservedBytes() const {return size_t(mReserveEnd - mStart);}
+
+private:
+	byte* mStart;
+	byte* mTop;
+	byte* mCommitEnd;
+	byte* mReserveEnd;
+	size_t mAlignment;
+
+	void commit(byte* newTop);
+
+	AVirtualArena(const AVirtualArena&) = delete;
+	AVirtualArena& operator=(const AVirtualArena&) = delete;
+};
+
+INTRA_WARNING_POP
+
+}}
@@ -12,8 +12,8 @@ template<size_t N> struct LogSizes
 
     static size_t GetSizeClass(size_t size)
     {
-		auto Log = Math::Log2i(uint(size));
-        return size_t(Log>5? Log-5u: 0u);
+		if(size <= 32) return 0;
+		return size_t(Math::Log2i(uint(size - 1)) + 1u - 5u);
     }
  
     static size_t GetSizeClassMaxSize(size_t sizeClass)
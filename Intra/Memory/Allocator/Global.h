@@ -4,16 +4,25 @@
 #include "Decorators/BoundsChecked.h"
 #include "Decorators/CallOnFail.h"
 #include "System.h"
+#include "ThreadCaching.h"
 #include "Utils/Debug.h"
 
 namespace Intra { namespace Memory {
 
+//! Define INTRA_THREAD_CACHING_GLOBAL_HEAP to make GlobalHeap and SizedHeap, and therefore Array, String, HashMap and other containers,
+//! allocate through ThreadCachingAllocator instead of the system heap.
+#ifdef INTRA_THREAD_CACHING_GLOBAL_HEAP
+using GlobalHeapBaseType = ThreadCachingAllocator;
+#else
+using GlobalHeapBaseType = SystemHeapAllocator;
+#endif
+
 #ifdef INTRA_DEBUG_ALLOCATORS
-using SizedHeapType = ASized<ABoundsChecked<ACallOnFail<SystemHeapAllocator, NoMemoryAbort>>>;
-using GlobalHeapType = ABoundsChecked<ACallOnFail<SystemHeapAllocator, NoMemoryAbort>>;
+using SizedHeapType = ASized<ABoundsChecked<ACallOnFail<GlobalHeapBaseType, NoMemoryAbort>>>;
+using GlobalHeapType = ABoundsChecked<ACallOnFail<GlobalHeapBaseType, NoMemoryAbort>>;
 #else
-using SizedHeapType = ASized<ACallOnFail<SystemHeapAllocator, NoMemoryAbort>>;
-using GlobalHeapType = ACallOnFail<SystemHeapAllocator, NoMemoryAbort>;
+using SizedHeapType = ASized<ACallOnFail<GlobalHeapBaseType, NoMemoryAbort>>;
+using GlobalHeapType = ACallOnFail<GlobalHeapBaseType, NoMemoryAbort>;
 #endif
 
 extern SizedHeapType SizedHeap;
@@ -0,0 +1,400 @@
+﻿#include "Memory/Allocator/ThreadCaching.h"
+#include "Memory/Allocator/System.h"
+#include "Concurrency/Atomic.h"
+#include "Concurrency/Thread.h"
+#include "Cpp/Intrinsics.h"
+#include "Cpp/Warnings.h"
+
+#undef Yield
+
+INTRA_PUSH_DISABLE_REDUNDANT_WARNINGS
+
+namespace Intra { namespace Memory {
+
+namespace {
+
+typedef ThreadCachingAllocator TCA;
+
+enum: size_t {
+	tcClassCount = TCA::SizeClasses::NumBins,
+	tcLargeHeaderSize = sizeof(void*)*2,
+	tcChunkMapLeafBits = 16,
+	tcChunkMapLeafSize = size_t(1) << tcChunkMapLeafBits,
+	tcAddressBits = sizeof(void*) == 8? 48: 32,
+	tcChunkMapTopBits = tcAddressBits - TCA::ChunkSizeLog > tcChunkMapLeafBits?
+		tcAddressBits - TCA::ChunkSizeLog - tcChunkMapLeafBits: 0,
+	tcChunkMapTopSize = size_t(1) << tcChunkMapTopBits
+};
+
+forceinline size_t tcClassSize(size_t sizeClass)
+{return TCA::SizeClasses::GetSizeClassMaxSize(sizeClass);}
+
+//! Сколько блоков передаётся между кешем потока и общей кучей за раз.
+forceinline uint tcBatchSize(size_t sizeClass)
+{
+	const size_t n = 8192/tcClassSize(sizeClass);
+	return uint(n < 4? 4: n > 64? 64: n);
+}
+
+//! Свободные блоки связаны в список через первое слово блока.
+//! Во втором слове первого блока полной пачки хранится ссылка на следующую пачку.
+forceinline void*& tcNext(void* block) {return static_cast<void**>(block)[0];}
+forceinline void*& tcNextBatch(void* block) {return static_cast<void**>(block)[1];}
+
+#if(INTRA_LIBRARY_THREAD != INTRA_LIBRARY_THREAD_None && INTRA_LIBRARY_ATOMIC != INTRA_LIBRARY_ATOMIC_None)
+#define INTRA_TC_THREADS
+
+class TCSpinLock
+{
+public:
+	void Lock()
+	{
+		for(uint spins = 0; !mLocked.CompareSetAcquire(0, 1); spins++)
+		{
+			while(mLocked.GetRelaxed() != 0)
+				if(++spins > 64) ThisThread.Yield();
+		}
+	}
+
+	void Unlock() {mLocked.SetRelease(0);}
+
+private:
+	AtomicInt mLocked;
+};
+
+#else
+
+class TCSpinLock
+{
+public:
+	void Lock() {}
+	void Unlock() {}
+};
+
+#endif
+
+struct TCThreadCache
+{
+	void* Heads[tcClassCount];
+	uint Counts[tcClassCount];
+	TCThreadCache* NextIdle;
+};
+
+struct TCCentralHeap
+{
+	struct SizeClass
+	{
+		TCSpinLock Lock;
+		void* Batches;
+		void* Loose;
+		byte* Bump;
+		byte* BumpEnd;
+	};
+
+	SizeClass Classes[tcClassCount];
+
+	TCSpinLock MetaLock;
+	TCThreadCache* IdleCaches;
+
+#ifdef INTRA_TC_THREADS
+	Concurrency::AtomicBase<byte*> ChunkMap[tcChunkMapTopSize];
+#else
+	byte* ChunkMap[tcChunkMapTopSize];
+#endif
+
+	TCCentralHeap(): IdleCaches(null)
+	{
+		for(auto& c: Classes) c.Batches = c.Loose = c.Bump = c.BumpEnd = null;
+	}
+
+	byte* chunkMapLeaf(size_t top) const
+	{
+#ifdef INTRA_TC_THREADS
+		return ChunkMap[top].GetAcquire();
+#else
+		return ChunkMap[top];
+#endif
+	}
+
+	//! Класс блока по его адресу или -1, если блок выделен не из кусков общей кучи.
+	forceinline int ClassOf(const void* ptr) const
+	{
+		const size_t index = reinterpret_cast<size_t>(ptr) >> TCA::ChunkSizeLog;
+		const size_t top = index >> tcChunkMapLeafBits;
+		if(top >= tcChunkMapTopSize) return -1;
+		const byte* const leaf = chunkMapLeaf(top);
+		if(leaf == null) return -1;
+		return int(leaf[index & (tcChunkMapLeafSize - 1)]) - 1;
+	}
+
+	//! Выделить новый кусок для класса c. Вызывается под блокировкой класса.
+	bool AddChunk(size_t sizeClass)
+	{
+		AlignedSystemHeapAllocator chunkAllocator(TCA::ChunkSize);
+		size_t chunkSize = TCA::ChunkSize;
+		byte* const chunk = chunkAllocator.Allocate(chunkSize, INTRA_SOURCE_INFO);
+		if(chunk == null) return false;
+
+		const size_t index = reinterpret_cast<size_t>(chunk) >> TCA::ChunkSizeLog;
+		const size_t top = index >> tcChunkMapLeafBits;
+		if(top >= tcChunkMapTopSize)
+		{
+			chunkAllocator.Free(chunk, TCA::ChunkSize);
+			return false;
+		}
+		MetaLock.Lock();
+		byte* leaf = chunkMapLeaf(top);
+		if(leaf == null)
+		{
+			leaf = MallocAllocator::Allocate(tcChunkMapLeafSize, INTRA_SOURCE_INFO);
+			if(leaf != null)
+			{
+				C::memset(leaf, 0, tcChunkMapLeafSize);
+#ifdef INTRA_TC_THREADS
+				ChunkMap[top].SetRelease(leaf);
+#else
+				ChunkMap[top] = leaf;
+#endif
+			}
+		}
+		if(leaf != null) leaf[index & (tcChunkMapLeafSize - 1)] = byte(sizeClass + 1);
+		MetaLock.Unlock();
+		if(leaf == null)
+		{
+			chunkAllocator.Free(chunk, TCA::ChunkSize);
+			return false;
+		}
+
+		Classes[sizeClass].Bump = chunk;
+		Classes[sizeClass].BumpEnd = chunk + TCA::ChunkSize;
+		return true;
+	}
+
+	//! Забрать до batchSize блоков класса sizeClass. Возвращает список блоков, count - их количество.
+	void* TakeBatch(size_t sizeClass, uint& count)
+	{
+		const uint batchSize = tcBatchSize(sizeClass);
+		const size_t blockSize = tcClassSize(sizeClass);
+		SizeClass& c = Classes[sizeClass];
+		void* list = null;
+		count = 0;
+		c.Lock.Lock();
+		if(c.Batches != null)
+		{
+			list = c.Batches;
+			c.Batches = tcNextBatch(list);
+			count = batchSize;
+		}
+		else
+		{
+			while(count < batchSize && c.Loose != null)
+			{
+				void* const block = c.Loose;
+				c.Loose = tcNext(block);
+				tcNext(block) = list;
+				list = block;
+				count++;
+			}
+			while(count < batchSize)
+			{
+				if(c.Bump == c.BumpEnd && !AddChunk(sizeClass)) break;
+				void* const block = c.Bump;
+				c.Bump += blockSize;
+				tcNext(block) = list;
+				list = block;
+				count++;
+			}
+		}
+		c.Lock.Unlock();
+		return list;
+	}
+
+	//! Вернуть полную пачку из tcBatchSize(sizeClass) блоков.
+	void PutBatch(size_t sizeClass, void* batch)
+	{
+		SizeClass& c = Classes[sizeClass];
+		c.Lock.Lock();
+		tcNextBatch(batch) = c.Batches;
+		c.Batches = batch;
+		c.Lock.Unlock();
+	}
+
+	//! Вернуть список блоков произвольной длины, заканчивающийся блоком tail.
+	void PutLoose(size_t sizeClass, void* list, void* tail)
+	{
+		SizeClass& c = Classes[sizeClass];
+		c.Lock.Lock();
+		tcNext(tail) = c.Loose;
+		c.Loose = list;
+		c.Lock.Unlock();
+	}
+
+	TCThreadCache* AcquireCache()
+	{
+		MetaLock.Lock();
+		TCThreadCache* cache = IdleCaches;
+		if(cache != null) IdleCaches = cache->NextIdle;
+		MetaLock.Unlock();
+		if(cache == null)
+		{
+			cache = MallocAllocator::Allocate(sizeof(TCThreadCache), INTRA_SOURCE_INFO);
+			if(cache == null) return null;
+			C::memset(cache, 0, sizeof(TCThreadCache));
+		}
+		return cache;
+	}
+
+	void ReturnIdleCache(TCThreadCache* cache)
+	{
+		MetaLock.Lock();
+		cache->NextIdle = IdleCaches;
+		IdleCaches = cache;
+		MetaLock.Unlock();
+	}
+};
+
+TCCentralHeap& tcCentral()
+{
+	static TCCentralHeap central;
+	return central;
+}
+
+//! Отделить от списка кеша полную пачку и вернуть её в общую кучу.
+void tcReleaseBatch(TCThreadCache& cache, size_t sizeClass)
+{
+	const uint batchSize = tcBatchSize(sizeClass);
+	void* const batch = cache.Heads[sizeClass];
+	void* tail = batch;
+	for(uint i = 1; i < batchSize; i++) tail = tcNext(tail);
+	cache.Heads[sizeClass] = tcNext(tail);
+	cache.Counts[sizeClass] -= batchSize;
+	tcNext(tail) = null;
+	tcCentral().PutBatch(sizeClass, batch);
+}
+
+void tcReleaseCache(TCThreadCache& cache)
+{
+	for(size_t sizeClass = 0; sizeClass < tcClassCount; sizeClass++)
+	{
+		while(cache.Counts[sizeClass] >= tcBatchSize(sizeClass)) tcReleaseBatch(cache, sizeClass);
+		void* const list = cache.Heads[sizeClass];
+		if(list == null) continue;
+		void* tail = list;
+		while(tcNext(tail) != null) tail = tcNext(tail);
+		tcCentral().PutLoose(sizeClass, list, tail);
+		cache.Heads[sizeClass] = null;
+		cache.Counts[sizeClass] = 0;
+	}
+}
+
+AnyPtr tcAllocateLarge(size_t bytes, const Utils::SourceInfo& sourceInfo)
+{
+	size_t* const header = SystemHeapAllocator::Allocate(bytes + tcLargeHeaderSize, sourceInfo);
+	if(header == null) return null;
+	*header = bytes;
+	return reinterpret_cast<byte*>(header) + tcLargeHeaderSize;
+}
+
+forceinline size_t* tcLargeHeader(void* ptr)
+{return reinterpret_cast<size_t*>(static_cast<byte*>(ptr) - tcLargeHeaderSize);}
+
+#ifdef INTRA_TC_THREADS
+
+thread_local TCThreadCache* tcCurrentCache = null;
+thread_local bool tcThreadFinished = false;
+
+//! Возвращает кеш потока общей куче при завершении потока.
+struct TCThreadCacheReleaser
+{
+	bool Active = false;
+
+	~TCThreadCacheReleaser()
+	{
+		TCThreadCache* const cache = tcCurrentCache;
+		if(cache == null) return;
+		tcReleaseCache(*cache);
+		tcCurrentCache = null;
+		tcThreadFinished = true;
+		tcCentral().ReturnIdleCache(cache);
+	}
+};
+
+thread_local TCThreadCacheReleaser tcReleaser;
+
+TCThreadCache* tcGetCache()
+{
+	if(tcCurrentCache != null) return tcCurrentCache;
+	if(tcThreadFinished) return null;
+	tcCurrentCache = tcCentral().AcquireCache();
+	if(tcCurrentCache != null) tcReleaser.Active = true;
+	return tcCurrentCache;
+}
+
+#else
+
+TCThreadCache* tcCurrentCache = null;
+
+TCThreadCache* tcGetCache()
+{
+	if(tcCurrentCache == null) tcCurrentCache = tcCentral().AcquireCache();
+	return tcCurrentCache;
+}
+
+#endif
+
+}
+
+AnyPtr ThreadCachingAllocator::Allocate(size_t& bytes, const Utils::SourceInfo& sourceInfo)
+{
+	if(bytes > MaxSmallSize) return tcAllocateLarge(bytes, sourceInfo);
+	const size_t sizeClass = SizeClasses::GetSizeClass(bytes);
+	TCThreadCache* const cache = tcGetCache();
+	if(cache == null) return tcAllocateLarge(bytes, sourceInfo);
+	void* block = cache->Heads[sizeClass];
+	if(block == null)
+	{
+		block = tcCentral().TakeBatch(sizeClass, cache->Counts[sizeClass]);
+		if(block == null) return tcAllocateLarge(bytes, sourceInfo);
+	}
+	cache->Heads[sizeClass] = tcNext(block);
+	cache->Counts[sizeClass]--;
+	bytes = tcClassSize(sizeClass);
+	return block;
+}
+
+void ThreadCachingAllocator::Free(void* ptr)
+{
+	if(ptr == null) return;
+	const int sizeClass = tcCentral().ClassOf(ptr);
+	if(sizeClass < 0)
+	{
+		SystemHeapAllocator::Free(tcLargeHeader(ptr));
+		return;
+	}
+	TCThreadCache* const cache = tcGetCache();
+	if(cache == null)
+	{
+		tcCentral().PutLoose(size_t(sizeClass), ptr, ptr);
+		return;
+	}
+	tcNext(ptr) = cache->Heads[sizeClass];
+	cache->Heads[sizeClass] = ptr;
+	if(++cache->Counts[sizeClass] >= 2*tcBatchSize(size_t(sizeClass)))
+		tcReleaseBatch(*cache, size_t(sizeClass));
+}
+
+size_t ThreadCachingAllocator::GetAllocationSize(void* ptr)
+{
+	const int sizeClass = tcCentral().ClassOf(ptr);
+	if(sizeClass < 0) return *tcLargeHeader(ptr);
+	return tcClassSize(size_t(sizeClass));
+}
+
+void ThreadCachingAllocator::ReleaseThreadCache()
+{
+	if(tcCurrentCache != null) tcReleaseCache(*tcCurrentCache);
+}
+
+}}
+
+INTRA_WARNING_POP
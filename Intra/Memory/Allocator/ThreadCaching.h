@@ -0,0 +1,47 @@
+﻿#pragma once
+
+#include "Cpp/Fundamental.h"
+#include "Cpp/Warnings.h"
+#include "Utils/AnyPtr.h"
+#include "Utils/Debug.h"
+#include "Compositors/SegregatedPools.h"
+
+namespace Intra { namespace Memory {
+
+INTRA_PUSH_DISABLE_REDUNDANT_WARNINGS
+
+//! Аллокатор общего назначения с кешем свободных блоков в каждом потоке.
+/*!
+Блоки до MaxSmallSize байт распределяются по размерным классам SizeClasses.
+Каждый поток держит свои списки свободных блоков для всех классов и обращается к общей куче только пачками:
+когда список пуст, из общей кучи забирается сразу несколько блоков, а когда он переполняется, пачка блоков возвращается обратно.
+Поэтому в большинстве вызовов Allocate и Free блокировки не используются, а общая куча блокируется по классам, а не целиком.
+Блок, освобождённый в другом потоке, попадает в кеш освободившего потока и возвращается в общую кучу в составе пачки.
+Кеш завершившегося потока отдаётся общей куче.
+Блоки мелких классов нарезаются из выровненных кусков по ChunkSize байт, которые не возвращаются системе.
+Большие блоки запрашиваются у SystemHeapAllocator напрямую.
+Размер при освобождении не обязателен: класс блока определяется по адресу.
+*/
+struct ThreadCachingAllocator
+{
+	typedef LogSizes<10> SizeClasses;
+
+	enum: size_t {
+		MaxSmallSize = 32u << (SizeClasses::NumBins - 1),
+		ChunkSizeLog = 18, ChunkSize = size_t(1) << ChunkSizeLog
+	};
+
+	static AnyPtr Allocate(size_t& bytes, const Utils::SourceInfo& sourceInfo);
+	static void Free(void* ptr, size_t size) {(void)size; Free(ptr);}
+	static void Free(void* ptr);
+	static size_t GetAllocationSize(void* ptr);
+	static size_t GetAlignment() {return sizeof(void*)*2;}
+
+	//! Вернуть все свободные блоки из кеша вызывающего потока в общую кучу.
+	//! Вызывается автоматически при завершении потока.
+	static void ReleaseThreadCache();
+};
+
+INTRA_WARNING_POP
+
+}}
@@ -79,6 +79,7 @@ static int translate_access(Access access)
 AnyPtr VirtualAlloc(size_t bytes, Access access)
 {
     void* ptr = mmap(null, bytes, translate_access(access), MAP_ANON|(access==Access::None? MAP_PRIVATE: MAP_SHARED), -1, 0);
+    if(ptr == MAP_FAILED) return null;
     msync(ptr, bytes, MS_SYNC|MS_INVALIDATE);
     return ptr;
 }
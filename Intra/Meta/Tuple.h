@@ -73,7 +73,7 @@ public:
 	template<typename H1> constexpr Tuple(const Tuple<H1>& h): first(h.first) {}
 
 	constexpr Tuple(HNoCR&& h): first(Cpp::Move(h)) {}
-	constexpr Tuple(const HNoCR& h): first(h) {}
+	constexpr Tuple(AddLValueReference<AddConst<H>> h): first(h) {}
 
 	constexpr Tuple(const Tuple& rhs) = default;
 	//constexpr Tuple(const H& h, const Tuple<>&): first(h) {}
@@ -22,7 +22,9 @@ public:
 
 	forceinline RZip(null_t=null) {}
 
-	template<typename R0, typename... RANGES1> forceinline RZip(R0&& r0, RANGES1&&... ranges):
+	template<typename R0, typename... RANGES1, typename = Meta::EnableIf<
+		!Meta::TypeEqualsIgnoreCVRef<R0, RZip>::_
+	>> forceinline RZip(R0&& r0, RANGES1&&... ranges):
 		OriginalRanges(Cpp::Forward<R0>(r0), Cpp::Forward<RANGES1>(ranges)...) {}
 	
 	forceinline RZip(OriginalRangeTuple ranges): OriginalRanges(ranges) {}
@@ -160,6 +160,39 @@ size_t AddMultipliedAdvance(Span<float>& dstOp1, CSpan<float>& op2, float op2Mul
 }
 
 
+size_t AddMultipliedAdvance(Span<float>& dstOp1, float op1Multiplyer, CSpan<float>& op2, float op2Multiplyer)
+{
+	const size_t len = Funal::Min(dstOp1.Length(), op2.Length());
+	auto& dst = dstOp1.Begin;
+	auto& src = op2.Begin;
+	auto dstend = dst + len;
+#if(INTRA_SIMD_SUPPORT==INTRA_SIMD_NONE)
+	while(dst + 3 < dstend)
+	{
+		*dst = *dst * op1Multiplyer + *src++ * op2Multiplyer; dst++;
+		*dst = *dst * op1Multiplyer + *src++ * op2Multiplyer; dst++;
+		*dst = *dst * op1Multiplyer + *src++ * op2Multiplyer; dst++;
+		*dst = *dst * op1Multiplyer + *src++ * op2Multiplyer; dst++;
+	}
+#else
+	while(dst + 3 < dstend && size_t(dst) % 16 != 0)
+		*dst = *dst * op1Multiplyer + *src++ * op2Multiplyer, dst++;
+	Simd::float4 op1MultiplyerVec = Simd::SetFloat4(op1Multiplyer);
+	Simd::float4 op2MultiplyerVec = Simd::SetFloat4(op2Multiplyer);
+	while(dst + 3 < dstend)
+	{
+		auto dstVal = Simd::SetFloat4(dst);
+		auto srcVal = Simd::SetFloat4U(src);
+		Simd::Get(dst, Simd::Add(Simd::Mul(dstVal, op1MultiplyerVec), Simd::Mul(srcVal, op2MultiplyerVec)));
+		dst += 4;
+		src += 4;
+	}
+#endif
+	while(dst < dstend) *dst = *dst * op1Multiplyer + *src++ * op2Multiplyer, dst++;
+	return len;
+}
+
+
 size_t MulAddAdvance(Span<float>& dstOp1, float mul, float add)
 {
 	const size_t len = dstOp1.Length();
@@ -171,6 +171,7 @@ size_t MultiplyAdvance(Span<float>& dstOp1, float multiplyer);
 size_t MultiplyAdvance(Span<float>& dst, CSpan<float>& op1, float multiplyer);
 size_t MulAddAdvance(Span<float>& dstOp1, float mul, float add);
 size_t AddMultipliedAdvance(Span<float>& dstOp1, CSpan<float>& op2, float op2Multiplyer);
+size_t AddMultipliedAdvance(Span<float>& dstOp1, float op1Multiplyer, CSpan<float>& op2, float op2Multiplyer);
 
 //! Складывать соответствующие элементы диапазонов.
 //! Если один из диапазонов короче другого, будет обработано столько элементов, какова минимальная длина.
@@ -185,6 +186,11 @@ forceinline size_t Multiply(Span<float> dst, CSpan<float> op1, float multiplier)
 forceinline size_t MulAdd(Span<float> dstOp1, float mul, float add) {return MulAddAdvance(dstOp1, mul, add);}
 forceinline size_t AddMultiplied(Span<float> dst, CSpan<float> op1, float multiplier) {return AddMultipliedAdvance(dst, op1, multiplier);}
 
+//! dstOp1[i] = dstOp1[i]*op1Multiplier + op2[i]*op2Multiplier за один проход.
+//! op2 может перекрываться с dstOp1, если начинается не раньше него.
+forceinline size_t AddMultiplied(Span<float> dstOp1, float op1Multiplier, CSpan<float> op2, float op2Multiplier)
+{return AddMultipliedAdvance(dstOp1, op1Multiplier, op2, op2Multiplier);}
+
 template<typename R> Meta::EnableIf<
 	Concepts::IsInputRange<R>::_ &&
 	!Meta::IsConst<R>::_
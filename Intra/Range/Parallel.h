@@ -0,0 +1,206 @@
+﻿#pragma once
+
+#include "Cpp/Features.h"
+#include "Cpp/Warnings.h"
+
+#include "Meta/Type.h"
+
+#include "Concepts/Range.h"
+#include "Concepts/RangeOf.h"
+
+#include "Funal/Op.h"
+
+#include "Container/Sequential/Array.h"
+
+#include "Concurrency/ThreadPool.h"
+#include "Concurrency/ParallelFor.h"
+
+namespace Intra { namespace Range {
+
+INTRA_PUSH_DISABLE_REDUNDANT_WARNINGS
+
+using Concurrency::ThreadPool;
+
+//! Параллельный аналог ForEach: вызывает f для каждого элемента диапазона в потоках пула pool.
+//! Порядок вызовов не определён, f должна допускать одновременный вызов из нескольких потоков.
+//! @param grainSize Максимальное количество элементов, обрабатываемых одной задачей.
+//! 0 означает автоматический выбор по размеру элемента и размеру кэша.
+template<typename R, typename F,
+	typename AsR = Concepts::RangeOfType<R>
+> Meta::EnableIf<
+	Concepts::IsFiniteRandomAccessRange<AsR>::_ &&
+	Meta::IsCallable<F, Concepts::ReturnValueTypeOf<AsR>>::_
+> ParallelForEach(ThreadPool& pool, R&& r, F&& f, size_t grainSize = 0)
+{
+	auto range = Range::Forward<R>(r);
+	const size_t count = range.Length();
+	if(grainSize == 0) grainSize = Concurrency::DefaultGrainSize(count,
+		sizeof(Concepts::ValueTypeOf<AsR>), pool.MaxConcurrency());
+	ParallelFor(pool, count, [&](size_t begin, size_t end) {
+		for(size_t i = begin; i < end; i++) f(range[i]);
+	}, grainSize);
+}
+
+template<typename R, typename F,
+	typename AsR = Concepts::RangeOfType<R>
+> forceinline Meta::EnableIf<
+	Concepts::IsFiniteRandomAccessRange<AsR>::_ &&
+	Meta::IsCallable<F, Concepts::ReturnValueTypeOf<AsR>>::_
+> ParallelForEach(R&& r, F&& f)
+{ParallelForEach(ThreadPool::Default(), Cpp::Forward<R>(r), Cpp::Forward<F>(f));}
+
+
+//! Параллельный аналог Transform: заменяет каждый элемент v диапазона на f(v).
+template<typename R, typename F,
+	typename AsR = Concepts::RangeOfType<R>
+> Meta::EnableIf<
+	Concepts::IsFiniteRandomAccessRange<AsR>::_ &&
+	Concepts::IsAssignableRange<AsR>::_ &&
+	Meta::IsCallable<F, Concepts::ValueTypeOf<AsR>&>::_
+> ParallelTransform(ThreadPool& pool, R&& r, F f, size_t grainSize = 0)
+{
+	ParallelForEach(pool, Cpp::Forward<R>(r), [&f](Concepts::ValueTypeOf<AsR>& v) {v = f(v);}, grainSize);
+}
+
+template<typename R, typename F,
+	typename AsR = Concepts::RangeOfType<R>
+> forceinline Meta::EnableIf<
+	Concepts::IsFiniteRandomAccessRange<AsR>::_ &&
+	Concepts::IsAssignableRange<AsR>::_ &&
+	Meta::IsCallable<F, Concepts::ValueTypeOf<AsR>&>::_
+> ParallelTransform(R&& r, F f)
+{ParallelTransform(ThreadPool::Default(), Cpp::Forward<R>(r), f);}
+
+
+//! Параллельный аналог TransformTo: записывает f(src[i]) в dst[i].
+//! Обрабатывается столько элементов, какова минимальная длина диапазонов.
+//! @return Количество обработанных элементов.
+template<typename R, typename OR, typename F,
+	typename AsR = Concepts::RangeOfType<R>,
+	typename AsOR = Concepts::RangeOfType<OR>
+> Meta::EnableIf<
+	Concepts::IsFiniteRandomAccessRange<AsR>::_ &&
+	Concepts::IsFiniteRandomAccessRange<AsOR>::_ &&
+	Concepts::IsAssignableRange<AsOR>::_ &&
+	Meta::IsCallable<F, Concepts::ReturnValueTypeOf<AsR>>::_,
+size_t> ParallelTransformTo(ThreadPool& pool, R&& src, OR&& dst, F f, size_t grainSize = 0)
+{
+	auto srcRange = Range::Forward<R>(src);
+	auto dstRange = Range::Forward<OR>(dst);
+	const size_t count = Funal::Min(srcRange.Length(), dstRange.Length());
+	if(grainSize == 0) grainSize = Concurrency::DefaultGrainSize(count,
+		sizeof(Concepts::ValueTypeOf<AsR>) + sizeof(Concepts::ValueTypeOf<AsOR>), pool.MaxConcurrency());
+	ParallelFor(pool, count, [&](size_t begin, size_t end) {
+		for(size_t i = begin; i < end; i++) dstRange[i] = f(srcRange[i]);
+	}, grainSize);
+	return count;
+}
+
+template<typename R, typename OR, typename F,
+	typename AsR = Concepts::RangeOfType<R>,
+	typename AsOR = Concepts::RangeOfType<OR>
+> forceinline Meta::EnableIf<
+	Concepts::IsFiniteRandomAccessRange<AsR>::_ &&
+	Concepts::IsFiniteRandomAccessRange<AsOR>::_ &&
+	Concepts::IsAssignableRange<AsOR>::_ &&
+	Meta::IsCallable<F, Concepts::ReturnValueTypeOf<AsR>>::_,
+size_t> ParallelTransformTo(R&& src, OR&& dst, F f)
+{return ParallelTransformTo(ThreadPool::Default(), Cpp::Forward<R>(src), Cpp::Forward<OR>(dst), f);}
+
+
+//! Параллельный аналог Reduce.
+//! Диапазон делится на части фиксированного размера, каждая часть сворачивается начиная со своего первого элемента,
+//! затем результаты частей сворачиваются по порядку начиная с seed.
+//! Поэтому func должна быть ассоциативной, но может быть некоммутативной, а результат не зависит от числа потоков.
+//! Результаты частей сворачиваются той же func, поэтому тип seed должен совпадать с типом элементов.
+//! Для свёртки в другой тип используйте перегрузку с combine.
+template<typename R, typename F, typename S,
+	typename AsR = Concepts::RangeOfType<R>
+> Meta::EnableIf<
+	Concepts::IsFiniteRandomAccessRange<AsR>::_ &&
+	Meta::IsCallable<F, S, Concepts::ReturnValueTypeOf<AsR>>::_,
+S> ParallelReduce(ThreadPool& pool, R&& r, const F& func, const S& seed)
+{
+	static_assert(Meta::TypeEquals<S, Concepts::ValueTypeOf<AsR>>::_,
+		"ParallelReduce folds partial results with func: the seed type must equal the element type, otherwise pass a combine function.");
+	auto range = Range::Forward<R>(r);
+	const size_t count = range.Length();
+	if(count == 0) return seed;
+	const size_t grainSize = Concurrency::DefaultGrainSize(count,
+		sizeof(Concepts::ValueTypeOf<AsR>), pool.MaxConcurrency());
+	const size_t partCount = (count + grainSize - 1)/grainSize;
+	Array<S> partials;
+	partials.Reserve(partCount);
+	for(size_t i = 0; i < partCount; i++) partials.AddLast(seed);
+	ParallelFor(pool, partCount, [&](size_t beginPart, size_t endPart) {
+		for(size_t part = beginPart; part < endPart; part++)
+		{
+			const size_t end = Funal::Min(count, (part + 1)*grainSize);
+			size_t i = part*grainSize;
+			S result = range[i++];
+			while(i < end) result = func(result, range[i++]);
+			partials[part] = Cpp::Move(result);
+		}
+	}, 1);
+	S result = seed;
+	for(auto& partial: partials) result = func(result, partial);
+	return result;
+}
+
+template<typename R, typename F, typename S,
+	typename AsR = Concepts::RangeOfType<R>
+> forceinline Meta::EnableIf<
+	Concepts::IsFiniteRandomAccessRange<AsR>::_ &&
+	Meta::IsCallable<F, S, Concepts::ReturnValueTypeOf<AsR>>::_,
+S> ParallelReduce(R&& r, const F& func, const S& seed)
+{return ParallelReduce(ThreadPool::Default(), Cpp::Forward<R>(r), func, seed);}
+
+//! Параллельная свёртка в тип S, отличный от типа элементов.
+//! Каждая часть диапазона сворачивается func(S, элемент) начиная с identity, затем результаты частей по порядку сворачиваются combine(S, S).
+//! Поэтому identity должен быть нейтральным элементом combine, а combine - ассоциативной, но может быть некоммутативной.
+//! Результат не зависит от числа потоков.
+template<typename R, typename F, typename S, typename C,
+	typename AsR = Concepts::RangeOfType<R>
+> Meta::EnableIf<
+	Concepts::IsFiniteRandomAccessRange<AsR>::_ &&
+	Meta::IsCallable<F, S, Concepts::ReturnValueTypeOf<AsR>>::_ &&
+	Meta::IsCallable<C, S, S>::_,
+S> ParallelReduce(ThreadPool& pool, R&& r, const F& func, const S& identity, const C& combine)
+{
+	auto range = Range::Forward<R>(r);
+	const size_t count = range.Length();
+	if(count == 0) return identity;
+	const size_t grainSize = Concurrency::DefaultGrainSize(count,
+		sizeof(Concepts::ValueTypeOf<AsR>), pool.MaxConcurrency());
+	const size_t partCount = (count + grainSize - 1)/grainSize;
+	Array<S> partials;
+	partials.Reserve(partCount);
+	for(size_t i = 0; i < partCount; i++) partials.AddLast(identity);
+	ParallelFor(pool, partCount, [&](size_t beginPart, size_t endPart) {
+		for(size_t part = beginPart; part < endPart; part++)
+		{
+			const size_t end = Funal::Min(count, (part + 1)*grainSize);
+			S result = identity;
+			for(size_t i = part*grainSize; i < end; i++) result = func(result, range[i]);
+			partials[part] = Cpp::Move(result);
+		}
+	}, 1);
+	S result = Cpp::Move(partials[0]);
+	for(size_t part = 1; part < partCount; part++) result = combine(result, partials[part]);
+	return result;
+}
+
+template<typename R, typename F, typename S, typename C,
+	typename AsR = Concepts::RangeOfType<R>,
+	// отсекает вызов ParallelReduce(pool, r, func, seed) до проверки вызываемости func с элементами pool
+	typename = Meta::EnableIf<Concepts::IsFiniteRandomAccessRange<AsR>::_>
+> forceinline Meta::EnableIf<
+	Concepts::IsFiniteRandomAccessRange<AsR>::_ &&
+	Meta::IsCallable<F, S, Concepts::ReturnValueTypeOf<AsR>>::_ &&
+	Meta::IsCallable<C, S, S>::_,
+S> ParallelReduce(R&& r, const F& func, const S& identity, const C& combine)
+{return ParallelReduce(ThreadPool::Default(), Cpp::Forward<R>(r), func, identity, combine);}
+
+INTRA_WARNING_POP
+
+}}
@@ -9,6 +9,10 @@
 
 #include "Range/Mutation/Copy.h"
 
+#include "Concurrency/Job.h"
+#include "Concurrency/ThreadPool.h"
+#include "Concurrency/ParallelFor.h"
+
 namespace Intra { namespace Range {
 
 namespace D {
@@ -45,7 +49,8 @@ template<typename T, typename C> T* merge_sort_pass(T* up, T* down, size_t left,
 	{
 		if(l_cur<=middle && r_cur<=right)
 		{
-			if(comparer(l_buff[l_cur], r_buff[r_cur]))
+			// при равенстве берётся элемент из левой половины, чтобы сортировка была устойчивой
+			if(!comparer(r_buff[r_cur], l_buff[l_cur]))
 			{
 				target[i] = l_buff[l_cur++];
 				continue;
@@ -64,6 +69,104 @@ template<typename T, typename C> T* merge_sort_pass(T* up, T* down, size_t left,
 	return target;
 }
 
+// Устойчивое слияние отсортированных a и b в dst, элементы a при равенстве идут первыми.
+template<typename T, typename C> void merge_to(const T* a, size_t na, const T* b, size_t nb, T* dst, C comparer)
+{
+	const T* const aEnd = a + na;
+	const T* const bEnd = b + nb;
+	while(a != aEnd && b != bEnd)
+		*dst++ = comparer(*b, *a)? *b++: *a++;
+	while(a != aEnd) *dst++ = *a++;
+	while(b != bEnd) *dst++ = *b++;
+}
+
+#if(INTRA_LIBRARY_THREAD != INTRA_LIBRARY_THREAD_None)
+template<typename C> struct ParallelMergeContext
+{
+	C Comparer;
+	ThreadPool* Pool;
+	size_t Grain;
+};
+
+// Выполняет left в задаче пула, right - в текущем потоке и дожидается завершения обоих.
+template<typename F1, typename F2> void fork_join(ThreadPool& pool, const F1& left, const F2& right)
+{
+	Job* const job = Job::Create(pool, left);
+	job->Run();
+	right();
+	job->Wait();
+	job->Release();
+}
+
+// Параллельное устойчивое слияние.
+// Средний элемент более длинной последовательности ставится на своё место в dst,
+// а части слева и справа от него сливаются независимо.
+template<typename T, typename C> void parallel_merge(const T* a, size_t na,
+	const T* b, size_t nb, T* dst, const ParallelMergeContext<C>& context)
+{
+	if(na + nb <= context.Grain)
+	{
+		merge_to(a, na, b, nb, dst, context.Comparer);
+		return;
+	}
+	size_t aMid, bMid;
+	if(na >= nb)
+	{
+		// элементы b, равные a[aMid], должны оказаться после него
+		aMid = na/2;
+		size_t lo = 0, hi = nb;
+		while(lo < hi)
+		{
+			const size_t m = (lo + hi)/2;
+			if(context.Comparer(b[m], a[aMid])) lo = m + 1;
+			else hi = m;
+		}
+		bMid = lo;
+		dst[aMid + bMid] = a[aMid];
+		fork_join(*context.Pool,
+			[=, &context]() {parallel_merge(a, aMid, b, bMid, dst, context);},
+			[=, &context]() {parallel_merge(a + aMid + 1, na - aMid - 1, b + bMid, nb - bMid, dst + aMid + bMid + 1, context);});
+		return;
+	}
+
+	// элементы a, равные b[bMid], должны оказаться перед ним
+	bMid = nb/2;
+	size_t lo = 0, hi = na;
+	while(lo < hi)
+	{
+		const size_t m = (lo + hi)/2;
+		if(context.Comparer(b[bMid], a[m])) hi = m;
+		else lo = m + 1;
+	}
+	aMid = lo;
+	dst[aMid + bMid] = b[bMid];
+	fork_join(*context.Pool,
+		[=, &context]() {parallel_merge(a, aMid, b, bMid, dst, context);},
+		[=, &context]() {parallel_merge(a + aMid, na - aMid, b + bMid + 1, nb - bMid - 1, dst + aMid + bMid + 1, context);});
+}
+
+// Сортирует src[0; count), результат помещается в buf, если toBuf, иначе в src.
+template<typename T, typename C> void parallel_merge_sort_pass(T* src, T* buf, size_t count,
+	bool toBuf, const ParallelMergeContext<C>& context)
+{
+	if(count <= context.Grain)
+	{
+		T* const result = merge_sort_pass(src, buf, 0, count-1, context.Comparer);
+		T* const target = toBuf? buf: src;
+		if(result != target) for(size_t i = 0; i < count; i++) target[i] = result[i];
+		return;
+	}
+
+	// половины сортируются в другой массив, откуда потом сливаются в нужный
+	const size_t half = count/2;
+	fork_join(*context.Pool,
+		[=, &context]() {parallel_merge_sort_pass(src, buf, half, !toBuf, context);},
+		[=, &context]() {parallel_merge_sort_pass(src + half, buf + half, count - half, !toBuf, context);});
+	const T* const from = toBuf? src: buf;
+	parallel_merge(from, half, from + half, count - half, toBuf? buf: src, context);
+}
+#endif
+
 }
 
 //! Сортировка слиянием
@@ -82,5 +185,35 @@ template<typename R, typename C = Funal::TLess> Meta::EnableIf<
 	CopyTo(temp.AsConstRange(), range);
 }
 
+//! Многопоточная устойчивая сортировка слиянием.
+//! Половины сортируются параллельно в задачах пула pool, слияние тоже выполняется параллельно:
+//! средний элемент одной половины ищется двоичным поиском в другой, и части слева и справа от него сливаются независимо.
+//! Требует дополнительной памяти по размеру исходного массива.
+template<typename R, typename C = Funal::TLess> Meta::EnableIf<
+	!Meta::IsConst<Concepts::RefElementTypeOfArrayOrDisable<R>>::_
+> ParallelMergeSort(ThreadPool& pool, R&& range, C comparer = Funal::Less)
+{
+	const size_t count = Concepts::LengthOf(range);
+	if(count < 2) return;
+	const size_t grain = Concurrency::DefaultGrainSize(count,
+		sizeof(Concepts::ValueTypeOf<R>), pool.MaxConcurrency());
+	if(pool.ThreadCount() == 0 || count <= grain)
+	{
+		MergeSort(Cpp::Forward<R>(range), comparer);
+		return;
+	}
+#if(INTRA_LIBRARY_THREAD != INTRA_LIBRARY_THREAD_None)
+	Array<Concepts::ValueTypeOf<R>> temp;
+	temp.SetCountUninitialized(count);
+	const D::ParallelMergeContext<C> context = {comparer, &pool, grain};
+	D::parallel_merge_sort_pass(Concepts::DataOf(range), Concepts::DataOf(temp), count, false, context);
+#endif
+}
+
+template<typename R, typename C = Funal::TLess> forceinline Meta::EnableIf<
+	!Meta::IsConst<Concepts::RefElementTypeOfArrayOrDisable<R>>::_
+> ParallelMergeSort(R&& range, C comparer = Funal::Less)
+{ParallelMergeSort(ThreadPool::Default(), Cpp::Forward<R>(range), comparer);}
+
 }}
 
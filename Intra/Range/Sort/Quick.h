@@ -13,6 +13,10 @@
 #include "Range/Sort/Insertion.h"
 #include "Range/Sort/Heap.h"
 
+#include "Concurrency/Job.h"
+#include "Concurrency/ThreadPool.h"
+#include "Concurrency/ParallelFor.h"
+
 INTRA_PUSH_DISABLE_REDUNDANT_WARNINGS
 
 namespace Intra { namespace Range {
@@ -143,6 +147,51 @@ template<typename T, typename C> void sort_pass(Span<T> range,
 	if(count>=2) InsertionSort(range, comparer);
 }
 
+#if(INTRA_LIBRARY_THREAD != INTRA_LIBRARY_THREAD_None)
+template<typename C> struct ParallelSortContext
+{
+	C Comparer;
+	Job* Root;
+	size_t ForkThreshold;
+};
+
+template<typename T, typename C> void parallel_sort_pass(Span<T> range,
+	intptr ideal, ParallelSortContext<C>& context, size_t insertionSortThreshold=32)
+{
+	while(range.Length() > insertionSortThreshold && ideal > 0)
+	{
+		Meta::Pair<T*, T*> mid = unguarded_partition(range, context.Comparer);
+		ideal /= 2, ideal += ideal/2;	// allow 1.5 log2(N) divisions
+
+		// hand the smaller half to another thread if it is large enough and loop on the larger half
+		Span<T> smaller(range.Begin, mid.first);
+		if(mid.first-range.Begin < range.End-mid.second) range.Begin = mid.second;
+		else
+		{
+			smaller = Span<T>(mid.second, range.End);
+			range.End = mid.first;
+		}
+
+		if(smaller.Length() <= context.ForkThreshold)
+		{
+			sort_pass(smaller, ideal, context.Comparer);
+			continue;
+		}
+		ParallelSortContext<C>* const pcontext = &context;
+		Job::CreateAsChild(context.Root, [smaller, ideal, pcontext]() {
+			parallel_sort_pass(smaller, ideal, *pcontext);
+		})->Run();
+	}
+
+	if(range.Length() > insertionSortThreshold)
+	{
+		HeapSort(range, context.Comparer);
+		return;
+	}
+	if(range.Length() >= 2) InsertionSort(range, context.Comparer);
+}
+#endif
+
 }
 
 
@@ -161,6 +210,49 @@ template<typename R> Meta::EnableIf<
 	return QuickSort<Funal::TLess>(Range::Forward<R>(range), Funal::Less);
 }
 
+//! Multi-threaded QuickSort.
+//! After each partition the smaller part is forked as a job of pool if it is longer than the grain size,
+//! the calling thread continues with the larger part.
+//! Falls back to HeapSort like QuickSort when the recursion gets too deep.
+template<typename C, typename R> Meta::EnableIf<
+	Concepts::IsAssignableArrayClass<R>::_
+> ParallelQuickSort(ThreadPool& pool, R&& range, C comparer)
+{
+	auto arr = SpanOf(range);
+	const size_t forkThreshold = Concurrency::DefaultGrainSize(arr.Length(),
+		sizeof(arr.First()), pool.MaxConcurrency());
+	if(pool.ThreadCount() == 0 || arr.Length() <= forkThreshold)
+	{
+		D::sort_pass(arr, intptr(arr.Length()), comparer);
+		return;
+	}
+#if(INTRA_LIBRARY_THREAD != INTRA_LIBRARY_THREAD_None)
+	D::ParallelSortContext<C> context = {comparer, null, forkThreshold};
+	D::ParallelSortContext<C>* const pcontext = &context;
+	context.Root = Job::Create(pool, [arr, pcontext]() {
+		D::parallel_sort_pass(arr, intptr(arr.Length()), *pcontext);
+	});
+	context.Root->Execute();
+	context.Root->Wait();
+	context.Root->Release();
+#endif
+}
+
+template<typename R> forceinline Meta::EnableIf<
+	Concepts::IsAssignableArrayClass<R>::_
+> ParallelQuickSort(ThreadPool& pool, R&& range)
+{ParallelQuickSort<Funal::TLess>(pool, Range::Forward<R>(range), Funal::Less);}
+
+template<typename C, typename R> forceinline Meta::EnableIf<
+	Concepts::IsAssignableArrayClass<R>::_
+> ParallelQuickSort(R&& range, C comparer)
+{ParallelQuickSort<C>(ThreadPool::Default(), Range::Forward<R>(range), comparer);}
+
+template<typename R> forceinline Meta::EnableIf<
+	Concepts::IsAssignableArrayClass<R>::_
+> ParallelQuickSort(R&& range)
+{ParallelQuickSort<Funal::TLess>(ThreadPool::Default(), Range::Forward<R>(range), Funal::Less);}
+
 }}
 
 INTRA_WARNING_POP
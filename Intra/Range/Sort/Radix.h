@@ -1,10 +1,27 @@
 ﻿#pragma once
 
+#include "Cpp/Warnings.h"
+#include "Cpp/Fundamental.h"
+
+#include "Meta/Type.h"
+
+#include "Funal/Op.h"
+
 #include "Utils/Span.h"
-#include "Container/ForwardDecls.h"
+#include "Container/Sequential/Array.h"
+
+#include "Range/Mutation/Copy.h"
+#include "Range/Sort/Insertion.h"
+
+#include "Concurrency/ThreadPool.h"
+#include "Concurrency/ParallelFor.h"
+
+INTRA_PUSH_DISABLE_REDUNDANT_WARNINGS
 
 namespace Intra { namespace Range {
 
+//! ExtractKey maps a value to an unsigned integer with the same order.
+
 template<typename T> forceinline Meta::EnableIf<
 	Meta::IsSignedIntegralType<T>::_,
 Meta::MakeUnsignedType<T>> ExtractKey(T t) {return Meta::MakeUnsignedType<T>(t ^ T(1ull << (sizeof(T)*8-1)));}
@@ -15,63 +32,218 @@ T> ExtractKey(T t) {return t;}
 
 template<typename T> forceinline size_t ExtractKey(T* t) {return reinterpret_cast<size_t>(t);}
 
-template<typename T, typename ExtractKeyFunc = Meta::MakeUnsignedType<T>(*)(T), size_t RadixLog=8>
-void RadixSort(Span<T> arr, ExtractKeyFunc extractKey = &ExtractKey<T>);
+//! Negative floats have the sign bit set and the reversed order of the other bits, so all their bits are inverted.
+//! Only the sign bit of non-negative floats is flipped to put them above the negative ones.
+forceinline uint ExtractKey(float f)
+{
+	union {float asFloat; uint asInt;};
+	asFloat = f;
+	return asInt ^ (uint(int(asInt) >> 31) | 0x80000000u);
+}
+
+forceinline ulong64 ExtractKey(double d)
+{
+	union {double asDouble; ulong64 asInt;};
+	asDouble = d;
+	return asInt ^ (ulong64(long64(asInt) >> 63) | (1ull << 63));
+}
 
-template<typename T, typename ExtractKeyFunc = size_t(*)(T*), size_t RadixLog=8>
-void RadixSort(Span<T*> arr, ExtractKeyFunc extractKey = &ExtractKey<T>)
-{RadixSort(arr.template Reinterpret<size_t>(), extractKey);}
+namespace D {
 
-namespace D
+struct TExtractKey
 {
-	template<typename T, typename ExtractKeyFunc, size_t RadixLog> void radixSortPass(
-		Span<T> arr, Span<T> temp, size_t radixOffset, ExtractKeyFunc extractKey)
+	template<typename T> forceinline auto operator()(const T& t) const -> decltype(ExtractKey(t))
+	{return ExtractKey(t);}
+};
+
+template<typename K, size_t RadixLog> struct RadixDigits
+{
+	enum: size_t {
+		Radix = size_t(1) << RadixLog, Mask = Radix - 1,
+		Count = (sizeof(K)*8 + RadixLog - 1)/RadixLog,
+		HistogramsSize = Count*Radix
+	};
+
+	static forceinline size_t Of(K key, size_t digit) {return size_t(key >> (digit*RadixLog)) & Mask;}
+};
+
+// Shorter ranges are sorted by insertion sort.
+enum: size_t {RadixSortInsertionThreshold = 48};
+
+// Build the histograms of all digits in one pass over arr.
+template<size_t RadixLog, typename T, typename ExtractKeyFunc>
+void radixHistograms(Span<T> arr, size_t* histograms, ExtractKeyFunc extractKey)
+{
+	typedef decltype(extractKey(arr.First())) K;
+	typedef RadixDigits<K, RadixLog> Digits;
+	for(const T& value: arr)
 	{
-		enum: size_t {Radix = 1 << RadixLog, RadixMask = Radix-1};
-		const size_t count = arr.Length();
+		const K key = extractKey(value);
+		for(size_t d = 0; d < Digits::Count; d++)
+			histograms[d*Digits::Radix + Digits::Of(key, d)]++;
+	}
+}
 
-		uint c[Radix] = {0};
-		for(size_t j = 0; j<count; j++)
-		{
-			const auto key = extractKey(arr[j]);
-			const size_t keyRadix = size_t(key >> radixOffset) & RadixMask;
-			c[keyRadix]++;
-		}
-		for(size_t j=1; j<Radix; j++) c[j] += c[j-1];
-		for(size_t j = count-1; j!=Meta::NumericLimits<size_t>::Max(); j--)
-		{
-			const auto key = extractKey(arr[j]);
-			const size_t keyRadix = size_t(key >> radixOffset) & RadixMask;
-			const size_t tempIndex = --c[keyRadix];
-			temp[tempIndex] = arr[j];
-		}
+// A pass is trivial when all keys have the same digit: it would only copy the array.
+template<size_t Radix> bool radixPassIsTrivial(const size_t* histogram, size_t count)
+{
+	for(size_t i = 0; i < Radix; i++)
+		if(histogram[i] != 0) return histogram[i] == count;
+	return true;
+}
+
+// Turn counts into exclusive prefix sums.
+template<size_t Radix> void radixOffsets(size_t* histogram)
+{
+	size_t offset = 0;
+	for(size_t i = 0; i < Radix; i++)
+	{
+		const size_t n = histogram[i];
+		histogram[i] = offset;
+		offset += n;
 	}
 }
 
-template<typename T, typename ExtractKeyFunc, size_t RadixLog>
-void RadixSort(Span<T> arr, ExtractKeyFunc extractKey)
+// Stable distribution of src into dst by digit. offsets are advanced past the written elements.
+template<size_t RadixLog, typename T, typename ExtractKeyFunc>
+void radixScatter(Span<T> src, T* dst, size_t* offsets, size_t digit, ExtractKeyFunc extractKey)
 {
-	enum: size_t {KeyBits = sizeof(extractKey(Meta::Val<T>()))*8};
+	typedef decltype(extractKey(src.First())) K;
+	typedef RadixDigits<K, RadixLog> Digits;
+	for(const T& value: src) dst[offsets[Digits::Of(extractKey(value), digit)]++] = value;
+}
+
+// LSD sort of data by its lowest digitCount digits using buffer of the same length.
+// Returns data or buffer, whichever contains the result.
+template<size_t RadixLog, typename T, typename ExtractKeyFunc>
+Span<T> radixSortLsd(Span<T> data, Span<T> buffer, size_t digitCount, ExtractKeyFunc extractKey)
+{
+	typedef decltype(extractKey(data.First())) K;
+	typedef RadixDigits<K, RadixLog> Digits;
+	const size_t count = data.Length();
+	if(digitCount == 0) return data;
+	if(count <= RadixSortInsertionThreshold)
+	{
+		InsertionSort(data, [&extractKey](const T& a, const T& b) {return extractKey(a) < extractKey(b);});
+		return data;
+	}
 
+	size_t histograms[Digits::HistogramsSize] = {};
+	radixHistograms<RadixLog>(data, histograms, extractKey);
+	for(size_t d = 0; d < digitCount; d++)
+	{
+		size_t* const histogram = histograms + d*Digits::Radix;
+		if(radixPassIsTrivial<Digits::Radix>(histogram, count)) continue;
+		radixOffsets<Digits::Radix>(histogram);
+		radixScatter<RadixLog>(data, buffer.Data(), histogram, d, extractKey);
+		Cpp::Swap(data, buffer);
+	}
+	return data;
+}
+
+}
+
+//! Stable LSD radix sort.
+//! Histograms of all digits are built in one pass, passes where all keys have the same digit are skipped.
+//! @param extractKey Maps an element to an unsigned integer key with the order of elements. Keys are compared by value.
+template<typename T, typename ExtractKeyFunc = D::TExtractKey, size_t RadixLog = 8>
+void RadixSort(Span<T> arr, ExtractKeyFunc extractKey = ExtractKeyFunc())
+{
+	typedef decltype(extractKey(Meta::Val<T>())) K;
+	if(arr.Length() < 2) return;
 	Array<T> tempBuffer;
 	tempBuffer.SetCountUninitialized(arr.Length());
-	Span<T> dst = arr, temp = tempBuffer;
-	size_t shift = 0;
-	for(size_t i=0; i<KeyBits/RadixLog; i++)
+	const Span<T> result = D::radixSortLsd<RadixLog>(arr, Span<T>(tempBuffer),
+		D::RadixDigits<K, RadixLog>::Count, extractKey);
+	if(result.Data() != arr.Data()) CopyTo(result, arr);
+}
+
+//! Multi-threaded stable radix sort for large arrays.
+//! The array is distributed in parallel by its most significant non-trivial digit (MSD pass),
+//! then the resulting buckets are sorted independently by LSD passes over the remaining digits.
+//! Arrays shorter than minParallelLength are sorted by RadixSort in the calling thread.
+template<typename T, typename ExtractKeyFunc = D::TExtractKey, size_t RadixLog = 8>
+void ParallelRadixSort(ThreadPool& pool, Span<T> arr,
+	ExtractKeyFunc extractKey = ExtractKeyFunc(), size_t minParallelLength = 65536)
+{
+	typedef decltype(extractKey(Meta::Val<T>())) K;
+	typedef D::RadixDigits<K, RadixLog> Digits;
+	const size_t count = arr.Length();
+	const uint concurrency = pool.MaxConcurrency();
+	if(concurrency == 1 || count < minParallelLength || count < 2)
 	{
-		D::radixSortPass<T, ExtractKeyFunc, RadixLog>(dst, temp, shift, extractKey);
-		shift += RadixLog;
-		Cpp::Swap(dst, temp);
+		RadixSort<T, ExtractKeyFunc, RadixLog>(arr, extractKey);
+		return;
 	}
-	if(shift<KeyBits)
+
+	// histograms of all digits of every chunk, built in one parallel pass
+	size_t chunkCount = 4*size_t(concurrency);
+	const size_t chunkSize = (count + chunkCount - 1)/chunkCount;
+	chunkCount = (count + chunkSize - 1)/chunkSize;
+	Array<size_t> chunkHistograms;
+	chunkHistograms.SetCount(chunkCount*Digits::HistogramsSize, 0);
+	auto chunk = [&](size_t c) {return arr(c*chunkSize, Funal::Min(count, (c + 1)*chunkSize));};
+	ParallelFor(pool, chunkCount, [&](size_t begin, size_t end) {
+		for(size_t c = begin; c < end; c++)
+			D::radixHistograms<RadixLog>(chunk(c), chunkHistograms.Data() + c*Digits::HistogramsSize, extractKey);
+	}, 1);
+
+	// find the most significant digit which has different values
+	size_t msd = Digits::Count;
+	for(;;)
+	{
+		if(msd == 0) return; // all keys are equal
+		msd--;
+		size_t histogram[Digits::Radix] = {};
+		for(size_t c = 0; c < chunkCount; c++)
+		{
+			const size_t* const chunkHistogram = chunkHistograms.Data() + c*Digits::HistogramsSize + msd*Digits::Radix;
+			for(size_t i = 0; i < Digits::Radix; i++) histogram[i] += chunkHistogram[i];
+		}
+		if(!D::radixPassIsTrivial<Digits::Radix>(histogram, count)) break;
+	}
+
+	// every chunk writes each digit value after the same digit value of the preceding chunks, this keeps the sort stable
+	size_t bucketBounds[Digits::Radix + 1];
+	size_t offset = 0;
+	for(size_t i = 0; i < Digits::Radix; i++)
 	{
-		D::radixSortPass<T, ExtractKeyFunc, KeyBits % RadixLog>(dst, temp, shift, extractKey);
-		Cpp::Swap(dst, temp);
+		bucketBounds[i] = offset;
+		for(size_t c = 0; c < chunkCount; c++)
+		{
+			size_t& h = chunkHistograms[c*Digits::HistogramsSize + msd*Digits::Radix + i];
+			const size_t n = h;
+			h = offset;
+			offset += n;
+		}
 	}
-	if(arr==dst) return;
-	CopyTo(temp, arr);
+	bucketBounds[Digits::Radix] = count;
+
+	Array<T> tempBuffer;
+	tempBuffer.SetCountUninitialized(count);
+	const Span<T> temp = tempBuffer;
+	ParallelFor(pool, chunkCount, [&](size_t begin, size_t end) {
+		for(size_t c = begin; c < end; c++)
+			D::radixScatter<RadixLog>(chunk(c), temp.Data(),
+				chunkHistograms.Data() + c*Digits::HistogramsSize + msd*Digits::Radix, msd, extractKey);
+	}, 1);
+
+	ParallelFor(pool, Digits::Radix, [&](size_t begin, size_t end) {
+		for(size_t i = begin; i < end; i++)
+		{
+			const Span<T> bucket = temp(bucketBounds[i], bucketBounds[i + 1]);
+			const Span<T> dst = arr(bucketBounds[i], bucketBounds[i + 1]);
+			if(bucket.Empty()) continue;
+			const Span<T> result = D::radixSortLsd<RadixLog>(bucket, dst, msd, extractKey);
+			if(result.Data() != dst.Data()) CopyTo(result, dst);
+		}
+	}, 1);
 }
 
+template<typename T, typename ExtractKeyFunc = D::TExtractKey, size_t RadixLog = 8>
+forceinline void ParallelRadixSort(Span<T> arr, ExtractKeyFunc extractKey = ExtractKeyFunc())
+{ParallelRadixSort<T, ExtractKeyFunc, RadixLog>(ThreadPool::Default(), arr, extractKey);}
 
 }}
 
+INTRA_WARNING_POP
@@ -56,6 +56,23 @@ ProcessorInfo ProcessorInfo::Get()
 		if(lError == ERROR_SUCCESS) result.BrandString = TrimRight(StringView(processorName, size), '\0');
 	}
 
+	SYSTEM_LOGICAL_PROCESSOR_INFORMATION logicalProcInfo[64];
+	DWORD bufferLength = sizeof(logicalProcInfo);
+	if(GetLogicalProcessorInformation(logicalProcInfo, &bufferLength))
+	{
+		for(DWORD i = 0; i < bufferLength/sizeof(logicalProcInfo[0]); i++)
+		{
+			if(logicalProcInfo[i].Relationship != RelationCache) continue;
+			const CACHE_DESCRIPTOR& cache = logicalProcInfo[i].Cache;
+			if(cache.Level == 1 && cache.Type != CacheInstruction)
+			{
+				result.L1DataCacheSize = uint(cache.Size);
+				result.CacheLineSize = cache.LineSize;
+			}
+			else if(cache.Level == 2) result.L2CacheSize = uint(cache.Size);
+		}
+	}
+
 	return result;
 }
 
@@ -89,6 +106,15 @@ ProcessorInfo ProcessorInfo::Get()
 	const StringView cpuMHzStr = cpuMHzLine.Find(':').Drop(2).FindBefore('\n');
 	result.Frequency = ulong64(1000000 * Range::Parse<double>(cpuMHzStr));
 
+#ifdef _SC_LEVEL1_DCACHE_SIZE
+	const long l1Size = sysconf(_SC_LEVEL1_DCACHE_SIZE);
+	const long l2Size = sysconf(_SC_LEVEL2_CACHE_SIZE);
+	const long lineSize = sysconf(_SC_LEVEL1_DCACHE_LINESIZE);
+	if(l1Size > 0) result.L1DataCacheSize = uint(l1Size);
+	if(l2Size > 0) result.L2CacheSize = uint(l2Size);
+	if(lineSize > 0) result.CacheLineSize = uint(lineSize);
+#endif
+
 	return result;
 }
 
@@ -14,6 +14,11 @@ struct ProcessorInfo
 	ushort LogicalProcessorNumber = 1;
 	ulong64 Frequency = 0;
 
+	//! Размеры кэшей в байтах. Если их не удалось определить, содержат типичные для x86 значения.
+	uint CacheLineSize = 64;
+	uint L1DataCacheSize = 32768;
+	uint L2CacheSize = 262144;
+
 	static ProcessorInfo Get();
 };
 
@@ -31,7 +31,7 @@ template<typename T> Meta::EnableIf<
 	Meta::IsFloatType<T>::_
 > GenerateRandomValue(T& dst)
 {
-	auto rand = Random::FastUniform<T>(uint(&dst));
+	auto rand = Random::FastUniform<T>(uint(size_t(&dst)));
 	dst = rand()*1000;
 }
 